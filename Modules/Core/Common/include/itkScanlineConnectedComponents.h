@@ -0,0 +1,176 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScanlineConnectedComponents_h
+#define itkScanlineConnectedComponents_h
+
+#include "itkBarrier.h"
+#include "itkImageRegion.h"
+#include <vector>
+
+namespace itk
+{
+/**
+ * \class ScanlineConnectedComponents
+ * \brief Multithreaded labeling of the connected runs of pixels of an image.
+ *
+ * ScanlineConnectedComponents holds the run length encoding of the lines
+ * of an image along its first dimension and finds the connected
+ * components formed by the runs.  It is the common part of the filters
+ * labeling binary images, like ConnectedComponentImageFilter and
+ * BinaryImageToLabelMapFilter.
+ *
+ * The filter calls Initialize() with the number of threads it uses,
+ * then each thread encodes the lines of its region in the lines returned
+ * by GetLine() and calls LabelRuns() with its region.  The regions must
+ * be made of complete lines and ordered by thread id, as done by
+ * ImageRegionSplitterDirection with direction 0.  Once LabelRuns()
+ * returns, GetConsecutiveLabel() gives the final label of each run.
+ *
+ * LabelRuns() does all the work in parallel: each thread numbers its
+ * runs and merges the runs in its region, then the regions are merged
+ * pairwise along their boundaries, in log2(number of threads) steps.
+ * At each step, the merged regions hold disjoint sets of labels, so the
+ * threads update the union-find table concurrently without locking.
+ * The final labels are consecutive and ordered by the raster order of
+ * the first run of each component.
+ *
+ * \ingroup ITKCommon
+ */
+template< unsigned int VDimension >
+class ITK_TEMPLATE_EXPORT ScanlineConnectedComponents
+{
+public:
+  /** Standard class typedefs. */
+  typedef ScanlineConnectedComponents Self;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, VDimension);
+
+  typedef Index< VDimension >       IndexType;
+  typedef ImageRegion< VDimension > RegionType;
+
+  /** Type of the labels of the runs and of the components. */
+  typedef SizeValueType LabelType;
+
+  /** A run of connected pixels along the first dimension. */
+  struct RunLength
+  {
+    SizeValueType length;
+    IndexType     where;   // Index of the start of the run
+    LabelType     label;   // the initial label of the run
+  };
+
+  typedef std::vector< RunLength >        LineEncodingType;
+  typedef std::vector< LineEncodingType > LineMapType;
+
+  ScanlineConnectedComponents();
+
+  /** Prepare the labeling of the lines of region by numberOfThreads
+   * threads. */
+  void Initialize(const RegionType & region, bool fullyConnected,
+                  ThreadIdType numberOfThreads);
+
+  /** Release the memory used by the labeling. */
+  void Clear();
+
+  /** Number of lines in the region. */
+  SizeValueType GetNumberOfLines() const
+  {
+    return static_cast< SizeValueType >( m_LineMap.size() );
+  }
+
+  /** Index of the line which starts at the given index. */
+  SizeValueType GetLineId(const IndexType & lineStart) const;
+
+  /** Run length encoding of a line.  The runs must be ordered along
+   * the line. */
+  LineEncodingType & GetLine(SizeValueType lineId)
+  {
+    return m_LineMap[lineId];
+  }
+  const LineEncodingType & GetLine(SizeValueType lineId) const
+  {
+    return m_LineMap[lineId];
+  }
+
+  /** Find the connected components of the runs.  All the threads must
+   * call this method, once they have encoded the lines of their region.
+   * The consecutive labels skip backgroundLabel. */
+  void LabelRuns(ThreadIdType threadId, const RegionType & regionForThread,
+                 LabelType backgroundLabel);
+
+  /** Final label of the component of a run, after LabelRuns(). */
+  LabelType GetConsecutiveLabel(LabelType label) const
+  {
+    return m_Consecutive[label];
+  }
+
+  /** Number of connected components, after LabelRuns(). */
+  SizeValueType GetNumberOfComponents() const
+  {
+    return m_NumberOfComponents;
+  }
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ScanlineConnectedComponents);
+
+  typedef std::vector< OffsetValueType > OffsetVectorType;
+  typedef std::vector< LabelType >       UnionFindType;
+
+  void Wait();
+
+  LabelType LookupSet(LabelType label);
+
+  LabelType FindRoot(LabelType label) const;
+
+  void LinkLabels(LabelType label1, LabelType label2);
+
+  /** Merge the runs of the lines [firstLine, lastLine) with the runs of
+   * their neighbors in [firstNeighbor, lastNeighbor). */
+  void LinkLines(SizeValueType firstLine, SizeValueType lastLine,
+                 SizeValueType firstNeighbor, SizeValueType lastNeighbor);
+
+  bool CheckNeighbors(const IndexType & A, const IndexType & B) const;
+
+  void CompareLines(const LineEncodingType & current, const LineEncodingType & neighbor);
+
+  RegionType       m_Region;
+  bool             m_FullyConnected;
+  SizeValueType    m_LineStrides[VDimension];
+  OffsetVectorType m_LineOffsets;
+  OffsetValueType  m_SmallestLineOffset;
+
+  LineMapType   m_LineMap;
+  UnionFindType m_UnionFind;
+  UnionFindType m_Consecutive;
+  SizeValueType m_NumberOfComponents;
+
+  // per thread
+  std::vector< SizeValueType > m_FirstLine;
+  std::vector< SizeValueType > m_NumberOfLines;
+  std::vector< SizeValueType > m_NumberOfRuns;
+  std::vector< SizeValueType > m_NumberOfRoots;
+
+  typename Barrier::Pointer m_Barrier;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkScanlineConnectedComponents.hxx"
+#endif
+
+#endif
@@ -0,0 +1,414 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScanlineConnectedComponents_hxx
+#define itkScanlineConnectedComponents_hxx
+
+#include "itkScanlineConnectedComponents.h"
+#include "itkMath.h"
+#include <algorithm>
+
+namespace itk
+{
+template< unsigned int VDimension >
+ScanlineConnectedComponents< VDimension >
+::ScanlineConnectedComponents():
+  m_FullyConnected(false),
+  m_SmallestLineOffset(0),
+  m_NumberOfComponents(0)
+{
+  for ( unsigned int d = 0; d < VDimension; ++d )
+    {
+    m_LineStrides[d] = 0;
+    }
+}
+
+template< unsigned int VDimension >
+void
+ScanlineConnectedComponents< VDimension >
+::Initialize(const RegionType & region, bool fullyConnected,
+             ThreadIdType numberOfThreads)
+{
+  m_Region = region;
+  m_FullyConnected = fullyConnected;
+
+  // lines are numbered in raster order along the dimensions after the
+  // first one
+  SizeValueType numberOfLines = 1;
+  for ( unsigned int d = 1; d < VDimension; ++d )
+    {
+    m_LineStrides[d] = numberOfLines;
+    numberOfLines *= region.GetSize(d);
+    }
+
+  // offsets to the "previous" neighbor lines: the lines of the 3x3x...
+  // neighborhood, face connected or not, which are before the current
+  // line in raster order.
+  m_LineOffsets.clear();
+  m_SmallestLineOffset = 0;
+  SizeValueType numberOfNeighbors = 1;
+  for ( unsigned int d = 1; d < VDimension; ++d )
+    {
+    numberOfNeighbors *= 3;
+    }
+  for ( SizeValueType n = 0; n < numberOfNeighbors; ++n )
+    {
+    SizeValueType   code = n;
+    OffsetValueType lineOffset = 0;
+    unsigned int    numberOfShiftedDimensions = 0;
+    for ( unsigned int d = 1; d < VDimension; ++d )
+      {
+      const OffsetValueType shift = static_cast< OffsetValueType >( code % 3 ) - 1;
+      code /= 3;
+      if ( shift != 0 )
+        {
+        ++numberOfShiftedDimensions;
+        lineOffset += shift * static_cast< OffsetValueType >( m_LineStrides[d] );
+        }
+      }
+    if ( numberOfShiftedDimensions == 0 || lineOffset >= 0
+         || ( !m_FullyConnected && numberOfShiftedDimensions > 1 ) )
+      {
+      continue;
+      }
+    m_LineOffsets.push_back(lineOffset);
+    m_SmallestLineOffset = std::min(m_SmallestLineOffset, lineOffset);
+    }
+
+  m_LineMap.clear();
+  m_LineMap.resize(numberOfLines);
+  m_UnionFind.clear();
+  m_Consecutive.clear();
+  m_NumberOfComponents = 0;
+
+  m_FirstLine.assign(numberOfThreads, 0);
+  m_NumberOfLines.assign(numberOfThreads, 0);
+  m_NumberOfRuns.assign(numberOfThreads, 0);
+  m_NumberOfRoots.assign(numberOfThreads, 0);
+
+  m_Barrier = Barrier::New();
+  m_Barrier->Initialize(numberOfThreads);
+}
+
+template< unsigned int VDimension >
+void
+ScanlineConnectedComponents< VDimension >
+::Clear()
+{
+  LineMapType().swap(m_LineMap);
+  UnionFindType().swap(m_UnionFind);
+  UnionFindType().swap(m_Consecutive);
+  m_Barrier = ITK_NULLPTR;
+}
+
+template< unsigned int VDimension >
+SizeValueType
+ScanlineConnectedComponents< VDimension >
+::GetLineId(const IndexType & lineStart) const
+{
+  SizeValueType lineId = 0;
+  for ( unsigned int d = 1; d < VDimension; ++d )
+    {
+    lineId += static_cast< SizeValueType >( lineStart[d] - m_Region.GetIndex(d) ) * m_LineStrides[d];
+    }
+  return lineId;
+}
+
+template< unsigned int VDimension >
+void
+ScanlineConnectedComponents< VDimension >
+::Wait()
+{
+  if ( m_FirstLine.size() > 1 )
+    {
+    m_Barrier->Wait();
+    }
+}
+
+template< unsigned int VDimension >
+void
+ScanlineConnectedComponents< VDimension >
+::LabelRuns(ThreadIdType threadId, const RegionType & regionForThread,
+            LabelType backgroundLabel)
+{
+  const ThreadIdType numberOfThreads = static_cast< ThreadIdType >( m_FirstLine.size() );
+
+  // the lines and the runs of this thread
+  const SizeValueType firstLine = this->GetLineId( regionForThread.GetIndex() );
+  const SizeValueType lastLine = firstLine
+    + regionForThread.GetNumberOfPixels() / regionForThread.GetSize(0);
+  SizeValueType numberOfRuns = 0;
+  for ( SizeValueType lineId = firstLine; lineId < lastLine; ++lineId )
+    {
+    numberOfRuns += m_LineMap[lineId].size();
+    }
+  m_FirstLine[threadId] = firstLine;
+  m_NumberOfLines[threadId] = lastLine - firstLine;
+  m_NumberOfRuns[threadId] = numberOfRuns;
+
+  this->Wait();
+
+  // number the runs in raster order: the threads hold consecutive ranges
+  // of labels, starting at 1
+  LabelType firstLabel = 1;
+  SizeValueType totalNumberOfRuns = 0;
+  for ( ThreadIdType i = 0; i < numberOfThreads; ++i )
+    {
+    if ( i < threadId )
+      {
+      firstLabel += m_NumberOfRuns[i];
+      }
+    totalNumberOfRuns += m_NumberOfRuns[i];
+    }
+  const LabelType lastLabel = firstLabel + numberOfRuns;
+
+  if ( threadId == 0 )
+    {
+    m_UnionFind.resize(totalNumberOfRuns + 1);
+    m_Consecutive.resize(totalNumberOfRuns + 1);
+    }
+
+  this->Wait();
+
+  LabelType label = firstLabel;
+  for ( SizeValueType lineId = firstLine; lineId < lastLine; ++lineId )
+    {
+    for ( typename LineEncodingType::iterator cIt = m_LineMap[lineId].begin();
+          cIt != m_LineMap[lineId].end();
+          ++cIt, ++label )
+      {
+      cIt->label = label;
+      m_UnionFind[label] = label;
+      }
+    }
+
+  // merge the runs inside the region of the thread: only the labels of
+  // this thread are involved
+  this->LinkLines(firstLine, lastLine, firstLine, lastLine);
+
+  this->Wait();
+
+  // merge the regions along their boundaries.  At each step, a thread
+  // merges two groups of regions merged at the previous step: the
+  // groups are disjoint, and so are their labels.
+  for ( ThreadIdType step = 1; step < numberOfThreads; step *= 2 )
+    {
+    if ( threadId % ( 2 * step ) == 0 && threadId + step < numberOfThreads )
+      {
+      const ThreadIdType  next = threadId + step;
+      const SizeValueType boundaryFirstLine = m_FirstLine[next];
+      // only the first lines of the next region have neighbors before it
+      const SizeValueType boundaryLastLine =
+        std::min( boundaryFirstLine + m_NumberOfLines[next],
+                  boundaryFirstLine + static_cast< SizeValueType >( -m_SmallestLineOffset ) );
+      this->LinkLines(boundaryFirstLine, boundaryLastLine, m_FirstLine[threadId], boundaryFirstLine);
+      }
+    this->Wait();
+    }
+
+  // the roots of the union-find trees are the smallest labels of their
+  // components.  Number them in increasing order.
+  SizeValueType numberOfRoots = 0;
+  for ( label = firstLabel; label < lastLabel; ++label )
+    {
+    if ( m_UnionFind[label] == label )
+      {
+      ++numberOfRoots;
+      }
+    }
+  m_NumberOfRoots[threadId] = numberOfRoots;
+
+  this->Wait();
+
+  SizeValueType consecutive = 0;
+  SizeValueType numberOfComponents = 0;
+  for ( ThreadIdType i = 0; i < numberOfThreads; ++i )
+    {
+    if ( i < threadId )
+      {
+      consecutive += m_NumberOfRoots[i];
+      }
+    numberOfComponents += m_NumberOfRoots[i];
+    }
+  if ( threadId == 0 )
+    {
+    m_NumberOfComponents = numberOfComponents;
+    }
+  for ( label = firstLabel; label < lastLabel; ++label )
+    {
+    if ( m_UnionFind[label] == label )
+      {
+      m_Consecutive[label] = ( consecutive < backgroundLabel ) ? consecutive : consecutive + 1;
+      ++consecutive;
+      }
+    }
+
+  this->Wait();
+
+  // the other labels take the label of their root
+  for ( label = firstLabel; label < lastLabel; ++label )
+    {
+    if ( m_UnionFind[label] != label )
+      {
+      m_Consecutive[label] = m_Consecutive[this->FindRoot(label)];
+      }
+    }
+
+  this->Wait();
+}
+
+template< unsigned int VDimension >
+void
+ScanlineConnectedComponents< VDimension >
+::LinkLines(SizeValueType firstLine, SizeValueType lastLine,
+            SizeValueType firstNeighbor, SizeValueType lastNeighbor)
+{
+  for ( SizeValueType lineId = firstLine; lineId < lastLine; ++lineId )
+    {
+    if ( m_LineMap[lineId].empty() )
+      {
+      continue;
+      }
+    for ( typename OffsetVectorType::const_iterator I = m_LineOffsets.begin();
+          I != m_LineOffsets.end(); ++I )
+      {
+      const OffsetValueType neighborId = static_cast< OffsetValueType >( lineId ) + *I;
+      // check if the neighbor is in the range and not empty
+      if ( neighborId < static_cast< OffsetValueType >( firstNeighbor )
+           || neighborId >= static_cast< OffsetValueType >( lastNeighbor )
+           || m_LineMap[neighborId].empty() )
+        {
+        continue;
+        }
+      // Now check whether they are really neighbors
+      if ( this->CheckNeighbors(m_LineMap[lineId][0].where, m_LineMap[neighborId][0].where) )
+        {
+        this->CompareLines(m_LineMap[lineId], m_LineMap[neighborId]);
+        }
+      }
+    }
+}
+
+template< unsigned int VDimension >
+bool
+ScanlineConnectedComponents< VDimension >
+::CheckNeighbors(const IndexType & A, const IndexType & B) const
+{
+  // this checks whether the line encodings are really neighbors. The
+  // first dimension gets ignored because the encodings are along that
+  // axis
+  for ( unsigned int i = 1; i < VDimension; i++ )
+    {
+    if ( itk::Math::abs(A[i] - B[i]) > 1 )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+template< unsigned int VDimension >
+void
+ScanlineConnectedComponents< VDimension >
+::CompareLines(const LineEncodingType & current, const LineEncodingType & neighbor)
+{
+  const OffsetValueType offset = m_FullyConnected ? 1 : 0;
+
+  typename LineEncodingType::const_iterator mIt = neighbor.begin(); // out marker iterator
+
+  for ( typename LineEncodingType::const_iterator cIt = current.begin(); cIt != current.end(); ++cIt )
+    {
+    const IndexValueType cStart = cIt->where[0];  // the start x position
+    const IndexValueType cLast = cStart + cIt->length - 1;
+
+    for ( typename LineEncodingType::const_iterator nIt = mIt; nIt != neighbor.end(); ++nIt )
+      {
+      const IndexValueType nStart = nIt->where[0];
+      const IndexValueType nLast = nStart + nIt->length - 1;
+      // the runs overlap, or touch diagonally if fully connected
+      const IndexValueType ss1 = nStart - offset;
+      const IndexValueType ee1 = nLast - offset;
+      const IndexValueType ee2 = nLast + offset;
+      if ( ss1 <= cLast && ee2 >= cStart )
+        {
+        this->LinkLabels(nIt->label, cIt->label);
+        }
+
+      if ( ee1 >= cLast )
+        {
+        // No point looking for more overlaps with the current run
+        // because the neighbor run extends beyond it
+        mIt = nIt;
+        break;
+        }
+      }
+    }
+}
+
+template< unsigned int VDimension >
+typename ScanlineConnectedComponents< VDimension >::LabelType
+ScanlineConnectedComponents< VDimension >
+::LookupSet(LabelType label)
+{
+  LabelType root = label;
+  while ( root != m_UnionFind[root] )
+    {
+    root = m_UnionFind[root];
+    }
+  // compress the path
+  while ( label != root )
+    {
+    const LabelType next = m_UnionFind[label];
+    m_UnionFind[label] = root;
+    label = next;
+    }
+  return root;
+}
+
+template< unsigned int VDimension >
+typename ScanlineConnectedComponents< VDimension >::LabelType
+ScanlineConnectedComponents< VDimension >
+::FindRoot(LabelType label) const
+{
+  while ( label != m_UnionFind[label] )
+    {
+    label = m_UnionFind[label];
+    }
+  return label;
+}
+
+template< unsigned int VDimension >
+void
+ScanlineConnectedComponents< VDimension >
+::LinkLabels(LabelType label1, LabelType label2)
+{
+  const LabelType E1 = this->LookupSet(label1);
+  const LabelType E2 = this->LookupSet(label2);
+
+  // the root is always the smallest label of the set
+  if ( E1 < E2 )
+    {
+    m_UnionFind[E2] = E1;
+    }
+  else
+    {
+    m_UnionFind[E1] = E2;
+    }
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,178 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkTestingImageIOCompression_h
+#define itkTestingImageIOCompression_h
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace itk
+{
+namespace Testing
+{
+/** Helpers for the tests of the ImageIO classes that deflate their
+ * data in parallel blocks: a test image, a round trip at each
+ * compression level, and the timing of a compressed write. */
+typedef Image< short, 3 > CompressionTestImageType;
+
+/** The value of a pixel of the test image, compressible but not
+ * trivially so. */
+inline CompressionTestImageType::PixelType
+CompressionTestValue(const CompressionTestImageType::IndexType & idx)
+{
+  return static_cast< CompressionTestImageType::PixelType >( ( idx[0] * idx[1] + idx[2] * 31 ) % 1021 );
+}
+
+/** An image of 8 MiB, i.e. 8 blocks of 1 MiB. */
+inline CompressionTestImageType::Pointer
+MakeCompressionTestImage()
+{
+  CompressionTestImageType::SizeType size;
+  size[0] = 256;
+  size[1] = 256;
+  size[2] = 64;
+  CompressionTestImageType::Pointer image = CompressionTestImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+  ImageRegionIteratorWithIndex< CompressionTestImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( CompressionTestValue( it.GetIndex() ) );
+    }
+  return image;
+}
+
+inline bool
+CheckCompressionTestImage(const CompressionTestImageType * image)
+{
+  ImageRegionConstIteratorWithIndex< CompressionTestImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != CompressionTestValue( it.GetIndex() ) )
+      {
+      std::cerr << "Wrong value at " << it.GetIndex() << ": " << it.Get()
+                << " instead of " << CompressionTestValue( it.GetIndex() ) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+/** Write the image with a TImageIO at the given compression level. */
+template< typename TImageIO >
+void
+WriteCompressedImage(const CompressionTestImageType * image, const std::string & fileName, int level)
+{
+  typename TImageIO::Pointer io = TImageIO::New();
+  io->SetCompressionLevel(level);
+  typedef ImageFileWriter< CompressionTestImageType > WriterType;
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+  writer->SetImageIO(io);
+  writer->SetFileName(fileName);
+  writer->UseCompressionOn();
+  writer->Update();
+}
+
+/** Check the default and the clamping of the compression level, then
+ * write the image at levels 0, 1, 6 and 9 for each extension, as
+ * prefix<level><extension>, and read it back with a TImageIO. Returns
+ * false on the first failure. */
+template< typename TImageIO >
+bool
+TestImageIOCompressionLevels(const CompressionTestImageType * image, const std::string & prefix,
+                             const char * const extensions[], unsigned int numberOfExtensions)
+{
+  typename TImageIO::Pointer io = TImageIO::New();
+  if ( io->GetCompressionLevel() != 6 )
+    {
+    std::cerr << "Default compression level is " << io->GetCompressionLevel() << " instead of 6" << std::endl;
+    return false;
+    }
+  io->SetCompressionLevel(12);
+  if ( io->GetCompressionLevel() != 9 )
+    {
+    std::cerr << "Compression level 12 is set as " << io->GetCompressionLevel() << " instead of 9" << std::endl;
+    return false;
+    }
+
+  const int levels[] = { 0, 1, 6, 9 };
+  for ( unsigned int e = 0; e < numberOfExtensions; ++e )
+    {
+    for ( unsigned int l = 0; l < 4; ++l )
+      {
+      std::ostringstream fileName;
+      fileName << prefix << levels[l] << extensions[e];
+      typedef ImageFileReader< CompressionTestImageType > ReaderType;
+      typename ReaderType::Pointer reader = ReaderType::New();
+      try
+        {
+        WriteCompressedImage< TImageIO >( image, fileName.str(), levels[l] );
+        reader->SetImageIO( TImageIO::New() );
+        reader->SetFileName( fileName.str() );
+        reader->Update();
+        }
+      catch ( ExceptionObject & excp )
+        {
+        std::cerr << "Failed round trip of " << fileName.str() << ": " << excp << std::endl;
+        return false;
+        }
+      if ( !CheckCompressionTestImage( reader->GetOutput() ) )
+        {
+        std::cerr << "Failed reading " << fileName.str() << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+/** Mean time of three calls of a function writing the image. */
+inline double
+TimeCompressedWrite(void (*write)(const CompressionTestImageType *, const std::string &),
+                    const CompressionTestImageType * image, const std::string & fileName)
+{
+  TimeProbe probe;
+  for ( unsigned int repeat = 0; repeat < 3; ++repeat )
+    {
+    probe.Start();
+    write(image, fileName);
+    probe.Stop();
+    }
+  return probe.GetMean();
+}
+
+/** Print the throughput of a write of the image. */
+inline void
+ReportCompressedWriteTime(const std::string & name, const CompressionTestImageType * image, double seconds)
+{
+  const double megabytes = image->GetLargestPossibleRegion().GetNumberOfPixels()
+                           * sizeof( CompressionTestImageType::PixelType ) / 1048576.0;
+  std::cout << name << ": " << seconds << " s per write, " << megabytes / seconds << " MB/s" << std::endl;
+}
+} // end namespace Testing
+} // end namespace itk
+
+#endif
@@ -27,6 +27,8 @@
 
 #include "vnl/vnl_vector.h"
 
+#include <vector>
+
 namespace itk {
 
 /**
@@ -71,6 +73,13 @@ namespace itk {
  * the corrected input image and spatially smoothing those results with a
  * B-spline scalar field estimate of the bias field.
  *
+ * Only the voxels inside the mask take part in the iterations, so they are
+ * gathered once and the bias field is only evaluated at these voxels, by
+ * adding the B-spline fit of each residual to the current estimate.  The
+ * full resolution bias field is reconstructed once, from the final control
+ * point lattice.  The histogram and the intensity mapping of the sharpening
+ * step are multithreaded.
+ *
  * \author Nicholas J. Tustison
  *
  * Contributed by Nicholas J. Tustison, James C. Gee in the Insight Journal
@@ -391,19 +400,22 @@ private:
   // Convergence is determined by the coefficient of variation of the difference
   // image between the current bias field estimate and the previous estimate.
 
+  typedef std::vector<RealType> RealValueArrayType;
+
   /**
    * Sharpen the intensity histogram of the current estimate of the corrected
-   * image and map those results to a new estimate of the unsmoothed corrected
-   * image.
+   * image at the masked voxels and map those results to a new estimate of
+   * the unsmoothed corrected image.
    */
-  RealImagePointer SharpenImage( const RealImageType * ) const;
+  void SharpenImage( const RealValueArrayType &, RealValueArrayType & ) const;
 
   /**
-   * Given the unsmoothed estimate of the bias field, this function smooths
-   * the estimate and adds the resulting control point values to the total
-   * bias field estimate.
+   * Given the unsmoothed estimate of the bias field stored in the point set
+   * of the B-spline filter, this function smooths the estimate, adds the
+   * resulting control point values to the total bias field estimate and
+   * updates the bias field at the masked voxels.
    */
-  RealImagePointer UpdateBiasFieldEstimate( RealImageType * );
+  void UpdateBiasFieldEstimate( BSplineFilterType *, RealValueArrayType & );
 
   /**
    * Reconstruct bias field given the control point lattice.
@@ -412,9 +424,37 @@ private:
 
   /**
    * Convergence is determined by the coefficient of variation of the difference
-   * image between the current bias field estimate and the previous estimate.
+   * between the current bias field estimate and the previous estimate at the
+   * masked voxels.
    */
-  RealType CalculateConvergenceMeasurement( const RealImageType *, const RealImageType * ) const;
+  RealType CalculateConvergenceMeasurement( const RealValueArrayType &,
+    const RealValueArrayType & ) const;
+
+  /** Structure passed to the threads of SharpenImage(). Each thread
+   * handles a contiguous range of the masked voxels.  The histograms of
+   * the threads are accumulated in double precision so the merged
+   * histogram hardly depends on the number of threads. */
+  struct SharpenImageThreadStruct
+    {
+    const RealValueArrayType *          Unsharpened;
+    RealValueArrayType *                Sharpened;
+    unsigned int                        NumberOfHistogramBins;
+    RealType                            BinMinimum;
+    RealType                            HistogramSlope;
+    std::vector<RealType>               BinMinima;
+    std::vector<RealType>               BinMaxima;
+    std::vector< vnl_vector<double> >   Histograms;
+    vnl_vector<RealType>                E;
+    };
+
+  /** Compute the intensity range of the voxels of a thread. */
+  static ITK_THREAD_RETURN_TYPE ComputeHistogramRangeThreaderCallback( void * );
+
+  /** Compute the histogram of the voxels of a thread. */
+  static ITK_THREAD_RETURN_TYPE ComputeHistogramThreaderCallback( void * );
+
+  /** Map the intensities of the voxels of a thread. */
+  static ITK_THREAD_RETURN_TYPE MapIntensitiesThreaderCallback( void * );
 
 #if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
   MaskPixelType m_MaskLabel;
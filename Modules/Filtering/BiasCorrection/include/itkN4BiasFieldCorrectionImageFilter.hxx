@@ -20,17 +20,16 @@
 
 #include "itkN4BiasFieldCorrectionImageFilter.h"
 
-#include "itkAddImageFilter.h"
 #include "itkBSplineControlPointImageFilter.h"
 #include "itkDivideImageFilter.h"
 #include "itkExpImageFilter.h"
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionIteratorWithIndex.h"
-#include "itkImportImageFilter.h"
 #include "itkIterationReporter.h"
-#include "itkSubtractImageFilter.h"
 #include "itkVectorIndexSelectionCastImageFilter.h"
 
+#include <algorithm>
+
 CLANG_PRAGMA_PUSH
 CLANG_SUPPRESS_Wfloat_equal
 #include "vnl/algo/vnl_fft_1d.h"
@@ -78,25 +77,6 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
   typedef typename InputImageType::RegionType RegionType;
   const RegionType inputRegion = inputImage->GetBufferedRegion();
 
-  // Calculate the log of the input image.
-  RealImagePointer logInputImage = RealImageType::New();
-  logInputImage->CopyInformation( inputImage );
-  logInputImage->SetRegions( inputRegion );
-  logInputImage->Allocate( false );
-
-  ImageRegionConstIterator<InputImageType> inpItr( inputImage, inputRegion );
-  ImageRegionIterator<RealImageType> outItr( logInputImage, inputRegion );
-
-  inpItr.GoToBegin();
-  outItr.GoToBegin();
-
-  while( !inpItr.IsAtEnd() )
-    {
-    outItr.Set( static_cast< RealType >( inpItr.Get() ) );
-    ++inpItr;
-    ++outItr;
-    }
-
   const MaskImageType * maskImage = this->GetMaskImage();
   const RealImageType * confidenceImage = this->GetConfidenceImage();
 #if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
@@ -104,8 +84,27 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
   const bool useMaskLabel = this->GetUseMaskLabel();
 #endif
 
-  ImageRegionIteratorWithIndex<RealImageType> It( logInputImage, inputRegion );
+  // Gather the log of the input image at the masked voxels, together with
+  // their positions in the parametric domain of the B-spline fitting and
+  // their confidence weights.  The iterations only visit these voxels.
+  // The direction cosine is ignored since the B-spline approximation
+  // algorithm works in parametric space and not physical space.
+
+  PointSetPointer fieldPoints = PointSetType::New();
+  fieldPoints->Initialize();
+
+  typename BSplineFilterType::WeightsContainerType::Pointer weights =
+    BSplineFilterType::WeightsContainerType::New();
+  weights->Initialize();
+
+  RealValueArrayType logInput;
 
+  const typename InputImageType::PointType & origin = inputImage->GetOrigin();
+  const typename InputImageType::SpacingType & spacing = inputImage->GetSpacing();
+
+  ImageRegionConstIteratorWithIndex<InputImageType> It( inputImage, inputRegion );
+
+  unsigned int index = 0;
   for( It.GoToBegin(); !It.IsAtEnd(); ++It )
     {
     if( ( !maskImage ||
@@ -119,28 +118,60 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
         && ( !confidenceImage ||
              confidenceImage->GetPixel( It.GetIndex() ) > 0.0 ) )
       {
+      RealType pixel = static_cast< RealType >( It.Get() );
       if( It.Get() > NumericTraits<typename InputImageType::PixelType>::ZeroValue() )
         {
-        It.Set( std::log( static_cast< RealType >( It.Get() ) ) );
+        pixel = std::log( pixel );
+        }
+      logInput.push_back( pixel );
+
+      PointType point;
+      for( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        point[d] = origin[d] + spacing[d] * It.GetIndex()[d];
+        }
+      fieldPoints->SetPoint( index, point );
+
+      RealType confidenceWeight = 1.0;
+      if( confidenceImage )
+        {
+        confidenceWeight = confidenceImage->GetPixel( It.GetIndex() );
         }
+      weights->InsertElement( index, confidenceWeight );
+      index++;
       }
     }
 
-  // Duplicate logInputImage since we reuse the original at each iteration.
+  // The B-spline filter is reused by all the iterations: only the residual
+  // bias field stored in the point data changes.
 
-  typedef ImageDuplicator<RealImageType> DuplicatorType;
-  typename DuplicatorType::Pointer duplicator = DuplicatorType::New();
-  duplicator->SetInputImage( logInputImage );
-  duplicator->Update();
+  typename BSplineFilterType::Pointer bspliner = BSplineFilterType::New();
 
-  RealImagePointer logUncorrectedImage = duplicator->GetModifiableOutput();
+  typename BSplineFilterType::ArrayType numberOfFittingLevels;
+  numberOfFittingLevels.Fill( 1 );
+
+  typename ScalarImageType::PointType parametricOrigin = origin;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    parametricOrigin[d] += (
+        spacing[d] * inputImage->GetLargestPossibleRegion().GetIndex()[d] );
+    }
+  bspliner->SetOrigin( parametricOrigin );
+  bspliner->SetSpacing( spacing );
+  bspliner->SetSize( inputImage->GetLargestPossibleRegion().GetSize() );
+  bspliner->SetDirection( inputImage->GetDirection() );
+  bspliner->SetGenerateOutputImage( false );
+  bspliner->SetNumberOfLevels( numberOfFittingLevels );
+  bspliner->SetSplineOrder( this->m_SplineOrder );
+  bspliner->SetNumberOfThreads( this->GetNumberOfThreads() );
+  bspliner->SetInput( fieldPoints );
+  bspliner->SetPointWeights( weights );
 
   // Provide an initial log bias field of zeros
 
-  RealImagePointer logBiasField = RealImageType::New();
-  logBiasField->CopyInformation( inputImage );
-  logBiasField->SetRegions( inputImage->GetLargestPossibleRegion() );
-  logBiasField->Allocate( true ); // initialize buffer to zero
+  RealValueArrayType logBiasField( logInput.size(), 0.0 );
+  RealValueArrayType logUncorrected( logInput );
+  RealValueArrayType logSharpened( logInput.size() );
 
   // Iterate until convergence or iterative exhaustion.
   unsigned int maximumNumberOfLevels = 1;
@@ -171,46 +202,50 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
 
       // Sharpen the current estimate of the uncorrected image.
 
-      RealImagePointer logSharpenedImage = this->SharpenImage( logUncorrectedImage );
-
-      typedef SubtractImageFilter<RealImageType, RealImageType, RealImageType>
-      SubtracterType;
-      typename SubtracterType::Pointer subtracter1 = SubtracterType::New();
-      subtracter1->SetInput1( logUncorrectedImage );
-      subtracter1->SetInput2( logSharpenedImage );
+      this->SharpenImage( logUncorrected, logSharpened );
 
-      RealImagePointer residualBiasField = subtracter1->GetOutput();
-      residualBiasField->Update();
+      for( SizeValueType n = 0; n < logUncorrected.size(); n++ )
+        {
+        ScalarType residual;
+        residual[0] = logUncorrected[n] - logSharpened[n];
+        fieldPoints->SetPointData( n, residual );
+        }
 
       // Smooth the residual bias field estimate and add the resulting
       // control point grid to get the new total bias field estimate.
 
-      RealImagePointer newLogBiasField = this->UpdateBiasFieldEstimate( residualBiasField );
+      RealValueArrayType newLogBiasField( logBiasField );
+      this->UpdateBiasFieldEstimate( bspliner, newLogBiasField );
 
       this->m_CurrentConvergenceMeasurement =
         this->CalculateConvergenceMeasurement( logBiasField, newLogBiasField );
-      logBiasField = newLogBiasField;
+      logBiasField.swap( newLogBiasField );
 
-      typename SubtracterType::Pointer subtracter2 = SubtracterType::New();
-      subtracter2->SetInput1( logInputImage );
-      subtracter2->SetInput2( logBiasField );
-
-      logUncorrectedImage = subtracter2->GetOutput();
-      logUncorrectedImage->Update();
+      for( SizeValueType n = 0; n < logUncorrected.size(); n++ )
+        {
+        logUncorrected[n] = logInput[n] - logBiasField[n];
+        }
 
       reporter.CompletedStep();
       }
 
+    if( !this->m_LogBiasFieldControlPointLattice )
+      {
+      continue;
+      }
+
+    // Refining the lattice leaves the B-spline object unchanged, so the
+    // bias field at the masked voxels carries over to the next level.
+
     typedef BSplineControlPointImageFilter<BiasFieldControlPointLatticeType, ScalarImageType>
       BSplineReconstructerType;
     typename BSplineReconstructerType::Pointer reconstructer = BSplineReconstructerType::New();
     reconstructer->SetInput( this->m_LogBiasFieldControlPointLattice );
-    reconstructer->SetOrigin( logBiasField->GetOrigin() );
-    reconstructer->SetSpacing( logBiasField->GetSpacing() );
-    reconstructer->SetDirection( logBiasField->GetDirection() );
-    reconstructer->SetSize( logBiasField->GetLargestPossibleRegion().GetSize() );
+    reconstructer->SetOrigin( inputImage->GetOrigin() );
+    reconstructer->SetSpacing( inputImage->GetSpacing() );
+    reconstructer->SetDirection( inputImage->GetDirection() );
+    reconstructer->SetSize( inputImage->GetLargestPossibleRegion().GetSize() );
     reconstructer->SetSplineOrder( this->m_SplineOrder );
-    reconstructer->Update();
 
     typename BSplineReconstructerType::ArrayType numberOfLevels;
     numberOfLevels.Fill( 1 );
@@ -226,9 +261,25 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
       RefineControlPointLattice( numberOfLevels );
     }
 
+  // Reconstruct the full resolution bias field from the final control
+  // point lattice.
+
+  RealImagePointer logBiasFieldImage;
+  if( this->m_LogBiasFieldControlPointLattice )
+    {
+    logBiasFieldImage = this->ReconstructBiasField( this->m_LogBiasFieldControlPointLattice );
+    }
+  else
+    {
+    logBiasFieldImage = RealImageType::New();
+    logBiasFieldImage->CopyInformation( inputImage );
+    logBiasFieldImage->SetRegions( inputImage->GetLargestPossibleRegion() );
+    logBiasFieldImage->Allocate( true ); // initialize buffer to zero
+    }
+
   typedef ExpImageFilter<RealImageType, RealImageType> ExpImageFilterType;
   typename ExpImageFilterType::Pointer expFilter = ExpImageFilterType::New();
-  expFilter->SetInput( logBiasField );
+  expFilter->SetInput( logBiasFieldImage );
   expFilter->Update();
 
   // Divide the input image by the bias field to get the final image.
@@ -245,52 +296,40 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
 }
 
 template<typename TInputImage, typename TMaskImage, typename TOutputImage>
-typename
-N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::RealImagePointer
+void
 N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
-::SharpenImage( const RealImageType *unsharpenedImage ) const
+::SharpenImage( const RealValueArrayType & unsharpened,
+                RealValueArrayType & sharpened ) const
 {
-  const MaskImageType * maskImage = this->GetMaskImage();
-  const RealImageType * confidenceImage = this->GetConfidenceImage();
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-  const MaskPixelType maskLabel = this->GetMaskLabel();
-  const bool useMaskLabel = this->GetUseMaskLabel();
-#endif
-
   // Build the histogram for the uncorrected image.  Store copy
   // in a vnl_vector to utilize vnl FFT routines.  Note that variables
   // in real space are denoted by a single uppercase letter whereas their
   // frequency counterparts are indicated by a trailing lowercase 'f'.
+  // Each thread computes the range and the histogram of its voxels, the
+  // results of the threads are merged in order.
 
-  RealType binMaximum = NumericTraits<RealType>::NonpositiveMin();
-  RealType binMinimum = NumericTraits<RealType>::max();
+  MultiThreader * threader = this->GetMultiThreader();
+  threader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  const ThreadIdType numberOfThreads = threader->GetNumberOfThreads();
 
-  ImageRegionConstIterator<RealImageType> ItU(
-    unsharpenedImage, unsharpenedImage->GetLargestPossibleRegion() );
+  SharpenImageThreadStruct str;
+  str.Unsharpened = &unsharpened;
+  str.Sharpened = &sharpened;
+  str.NumberOfHistogramBins = this->m_NumberOfHistogramBins;
+  str.BinMinima.assign( numberOfThreads, NumericTraits<RealType>::max() );
+  str.BinMaxima.assign( numberOfThreads, NumericTraits<RealType>::NonpositiveMin() );
+  str.Histograms.assign( numberOfThreads,
+    vnl_vector<double>( this->m_NumberOfHistogramBins, 0.0 ) );
 
-  for( ItU.GoToBegin(); !ItU.IsAtEnd(); ++ItU )
+  threader->SetSingleMethod( this->ComputeHistogramRangeThreaderCallback, &str );
+  threader->SingleMethodExecute();
+
+  RealType binMaximum = NumericTraits<RealType>::NonpositiveMin();
+  RealType binMinimum = NumericTraits<RealType>::max();
+  for( ThreadIdType t = 0; t < numberOfThreads; t++ )
     {
-    if( ( !maskImage ||
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-          ( useMaskLabel && maskImage->GetPixel( ItU.GetIndex() ) == maskLabel ) || ( !useMaskLabel &&
-#endif
-            maskImage->GetPixel( ItU.GetIndex() ) != NumericTraits< MaskPixelType >::ZeroValue() )
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-          )
-#endif
-        && ( !confidenceImage ||
-             confidenceImage->GetPixel( ItU.GetIndex() ) > 0.0 ) )
-      {
-      RealType pixel = ItU.Get();
-      if( pixel > binMaximum )
-        {
-        binMaximum = pixel;
-        }
-      else if( pixel < binMinimum )
-        {
-        binMinimum = pixel;
-        }
-      }
+    binMaximum = std::max( binMaximum, str.BinMaxima[t] );
+    binMinimum = std::min( binMinimum, str.BinMinima[t] );
     }
   RealType histogramSlope = ( binMaximum - binMinimum ) /
     static_cast<RealType>( this->m_NumberOfHistogramBins - 1 );
@@ -298,38 +337,21 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
   // Create the intensity profile (within the masked region, if applicable)
   // using a triangular parzen windowing scheme.
 
-  vnl_vector<RealType> H( this->m_NumberOfHistogramBins, 0.0 );
+  str.BinMinimum = binMinimum;
+  str.HistogramSlope = histogramSlope;
 
-  for( ItU.GoToBegin(); !ItU.IsAtEnd(); ++ItU )
-    {
-    if( ( !maskImage ||
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-          ( useMaskLabel && maskImage->GetPixel( ItU.GetIndex() ) == maskLabel ) || ( !useMaskLabel &&
-#endif
-            maskImage->GetPixel( ItU.GetIndex() ) != NumericTraits< MaskPixelType >::ZeroValue() )
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-          )
-#endif
-        && ( !confidenceImage ||
-             confidenceImage->GetPixel( ItU.GetIndex() ) > 0.0 ) )
-      {
-      RealType pixel = ItU.Get();
-
-      RealType cidx = ( static_cast<RealType>( pixel ) - binMinimum ) /
-        histogramSlope;
-      unsigned int idx = itk::Math::floor( cidx );
-      RealType     offset = cidx - static_cast<RealType>( idx );
+  threader->SetSingleMethod( this->ComputeHistogramThreaderCallback, &str );
+  threader->SingleMethodExecute();
 
-      if( offset == 0.0 )
-        {
-        H[idx] += 1.0;
-        }
-      else if( idx < this->m_NumberOfHistogramBins - 1 )
-        {
-        H[idx] += 1.0 - offset;
-        H[idx+1] += offset;
-        }
-      }
+  vnl_vector<double> histogram( this->m_NumberOfHistogramBins, 0.0 );
+  for( ThreadIdType t = 0; t < numberOfThreads; t++ )
+    {
+    histogram += str.Histograms[t];
+    }
+  vnl_vector<RealType> H( this->m_NumberOfHistogramBins );
+  for( unsigned int n = 0; n < this->m_NumberOfHistogramBins; n++ )
+    {
+    H[n] = static_cast<RealType>( histogram[n] );
     }
 
   // Determine information about the intensity histogram and zero-pad
@@ -462,132 +484,131 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
 
   E = E.extract( this->m_NumberOfHistogramBins, histogramOffset );
 
-  const InputImageType * inputImage = this->GetInput();
-
   // Sharpen the image with the new mapping, E(u|v)
-  RealImagePointer sharpenedImage = RealImageType::New();
-  sharpenedImage->CopyInformation( inputImage );
-  sharpenedImage->SetRegions( inputImage->GetLargestPossibleRegion() );
-  sharpenedImage->Allocate( true ); // initialize buffer to zero
 
-  ImageRegionIterator<RealImageType> ItC(
-    sharpenedImage, sharpenedImage->GetLargestPossibleRegion() );
+  sharpened.resize( unsharpened.size() );
+  str.E = E;
 
-  for( ItU.GoToBegin(), ItC.GoToBegin(); !ItU.IsAtEnd(); ++ItU, ++ItC )
+  threader->SetSingleMethod( this->MapIntensitiesThreaderCallback, &str );
+  threader->SingleMethodExecute();
+}
+
+template<typename TInputImage, typename TMaskImage, typename TOutputImage>
+ITK_THREAD_RETURN_TYPE
+N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
+::ComputeHistogramRangeThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *threadInfo =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  SharpenImageThreadStruct *str =
+    static_cast<SharpenImageThreadStruct *>( threadInfo->UserData );
+
+  const ThreadIdType threadId = threadInfo->ThreadID;
+  const RealValueArrayType & unsharpened = *str->Unsharpened;
+  const SizeValueType start = unsharpened.size() * threadId / threadInfo->NumberOfThreads;
+  const SizeValueType end = unsharpened.size() * ( threadId + 1 ) / threadInfo->NumberOfThreads;
+
+  RealType binMaximum = str->BinMaxima[threadId];
+  RealType binMinimum = str->BinMinima[threadId];
+  for( SizeValueType n = start; n < end; n++ )
     {
-    if( ( !maskImage ||
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-          ( useMaskLabel && maskImage->GetPixel( ItU.GetIndex() ) == maskLabel ) || ( !useMaskLabel &&
-#endif
-            maskImage->GetPixel( ItU.GetIndex() ) != NumericTraits< MaskPixelType >::ZeroValue() )
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-          )
-#endif
-        && ( !confidenceImage ||
-             confidenceImage->GetPixel( ItU.GetIndex() ) > 0.0 ) )
+    const RealType pixel = unsharpened[n];
+    if( pixel > binMaximum )
       {
-      RealType     cidx = ( ItU.Get() - binMinimum ) / histogramSlope;
-      unsigned int idx = itk::Math::floor( cidx );
-
-      RealType correctedPixel = 0;
-      if( idx < E.size() - 1 )
-        {
-        correctedPixel = E[idx] + ( E[idx + 1] - E[idx] )
-          * ( cidx - static_cast<RealType>( idx ) );
-        }
-      else
-        {
-        correctedPixel = E[E.size() - 1];
-        }
-      ItC.Set( correctedPixel );
+      binMaximum = pixel;
+      }
+    if( pixel < binMinimum )
+      {
+      binMinimum = pixel;
       }
     }
+  str->BinMaxima[threadId] = binMaximum;
+  str->BinMinima[threadId] = binMinimum;
 
-  return sharpenedImage;
+  return ITK_THREAD_RETURN_VALUE;
 }
 
 template<typename TInputImage, typename TMaskImage, typename TOutputImage>
-typename
-N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::RealImagePointer
+ITK_THREAD_RETURN_TYPE
 N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
-::UpdateBiasFieldEstimate( RealImageType* fieldEstimate )
+::ComputeHistogramThreaderCallback( void *arg )
 {
-  // Temporarily set the direction cosine to identity since the B-spline
-  // approximation algorithm works in parametric space and not physical
-  // space.
-  typename ScalarImageType::DirectionType identity;
-  identity.SetIdentity();
-
-  const typename ScalarImageType::RegionType & bufferedRegion = fieldEstimate->GetBufferedRegion();
-  const SizeValueType numberOfPixels = bufferedRegion.GetNumberOfPixels();
-  const bool filterHandlesMemory = false;
-
-  typedef ImportImageFilter<RealType, ImageDimension> ImporterType;
-  typename ImporterType::Pointer importer = ImporterType::New();
-  importer->SetImportPointer( fieldEstimate->GetBufferPointer(), numberOfPixels, filterHandlesMemory );
-  importer->SetRegion( fieldEstimate->GetBufferedRegion() );
-  importer->SetOrigin( fieldEstimate->GetOrigin() );
-  importer->SetSpacing( fieldEstimate->GetSpacing() );
-  importer->SetDirection( identity );
-  importer->Update();
-
-  const typename ImporterType::OutputImageType * parametricFieldEstimate = importer->GetOutput();
-
-  PointSetPointer fieldPoints = PointSetType::New();
-  fieldPoints->Initialize();
-
-  typename BSplineFilterType::WeightsContainerType::Pointer weights =
-    BSplineFilterType::WeightsContainerType::New();
-  weights->Initialize();
-
-  const MaskImageType * maskImage = this->GetMaskImage();
-  const RealImageType * confidenceImage = this->GetConfidenceImage();
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-  const MaskPixelType maskLabel = this->GetMaskLabel();
-  const bool useMaskLabel = this->GetUseMaskLabel();
-#endif
-
-  ImageRegionConstIteratorWithIndex<RealImageType>
-    It( parametricFieldEstimate, parametricFieldEstimate->GetRequestedRegion() );
-
-  unsigned int index = 0;
-  for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
+  MultiThreader::ThreadInfoStruct *threadInfo =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  SharpenImageThreadStruct *str =
+    static_cast<SharpenImageThreadStruct *>( threadInfo->UserData );
+
+  const ThreadIdType threadId = threadInfo->ThreadID;
+  const RealValueArrayType & unsharpened = *str->Unsharpened;
+  const SizeValueType start = unsharpened.size() * threadId / threadInfo->NumberOfThreads;
+  const SizeValueType end = unsharpened.size() * ( threadId + 1 ) / threadInfo->NumberOfThreads;
+
+  vnl_vector<double> & H = str->Histograms[threadId];
+  for( SizeValueType n = start; n < end; n++ )
     {
-    if( ( !maskImage ||
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-          ( useMaskLabel && maskImage->GetPixel( It.GetIndex() ) == maskLabel ) || ( !useMaskLabel &&
-#endif
-            maskImage->GetPixel( It.GetIndex() ) != NumericTraits< MaskPixelType >::ZeroValue() )
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-          )
-#endif
-        && ( !confidenceImage ||
-             confidenceImage->GetPixel( It.GetIndex() ) > 0.0 ) )
+    RealType cidx = ( unsharpened[n] - str->BinMinimum ) / str->HistogramSlope;
+    unsigned int idx = itk::Math::floor( cidx );
+    RealType     offset = cidx - static_cast<RealType>( idx );
+
+    if( offset == 0.0 )
       {
-      PointType point;
-      parametricFieldEstimate->TransformIndexToPhysicalPoint( It.GetIndex(), point );
+      H[idx] += 1.0;
+      }
+    else if( idx < str->NumberOfHistogramBins - 1 )
+      {
+      H[idx] += 1.0 - offset;
+      H[idx+1] += offset;
+      }
+    }
 
-      ScalarType scalar;
-      scalar[0] = It.Get();
+  return ITK_THREAD_RETURN_VALUE;
+}
 
-      fieldPoints->SetPointData( index, scalar );
-      fieldPoints->SetPoint( index, point );
+template<typename TInputImage, typename TMaskImage, typename TOutputImage>
+ITK_THREAD_RETURN_TYPE
+N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
+::MapIntensitiesThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *threadInfo =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  SharpenImageThreadStruct *str =
+    static_cast<SharpenImageThreadStruct *>( threadInfo->UserData );
+
+  const ThreadIdType threadId = threadInfo->ThreadID;
+  const RealValueArrayType & unsharpened = *str->Unsharpened;
+  RealValueArrayType & sharpened = *str->Sharpened;
+  const SizeValueType start = unsharpened.size() * threadId / threadInfo->NumberOfThreads;
+  const SizeValueType end = unsharpened.size() * ( threadId + 1 ) / threadInfo->NumberOfThreads;
+
+  const vnl_vector<RealType> & E = str->E;
+  for( SizeValueType n = start; n < end; n++ )
+    {
+    RealType     cidx = ( unsharpened[n] - str->BinMinimum ) / str->HistogramSlope;
+    unsigned int idx = itk::Math::floor( cidx );
 
-      RealType confidenceWeight = 1.0;
-      if( confidenceImage )
-        {
-        confidenceWeight = confidenceImage->GetPixel( It.GetIndex() );
-        }
-      weights->InsertElement( index, confidenceWeight );
-      index++;
+    RealType correctedPixel = 0;
+    if( idx < E.size() - 1 )
+      {
+      correctedPixel = E[idx] + ( E[idx + 1] - E[idx] )
+        * ( cidx - static_cast<RealType>( idx ) );
       }
+    else
+      {
+      correctedPixel = E[E.size() - 1];
+      }
+    sharpened[n] = correctedPixel;
     }
 
-  typename BSplineFilterType::Pointer bspliner = BSplineFilterType::New();
+  return ITK_THREAD_RETURN_VALUE;
+}
 
+template<typename TInputImage, typename TMaskImage, typename TOutputImage>
+void
+N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
+::UpdateBiasFieldEstimate( BSplineFilterType *bspliner,
+                           RealValueArrayType & logBiasField )
+{
   typename BSplineFilterType::ArrayType numberOfControlPoints;
-  typename BSplineFilterType::ArrayType numberOfFittingLevels;
-  numberOfFittingLevels.Fill( 1 );
   for( unsigned int d = 0; d < ImageDimension; d++ )
     {
     if( !this->m_LogBiasFieldControlPointLattice )
@@ -600,25 +621,10 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
         GetLargestPossibleRegion().GetSize()[d];
       }
     }
-
-  typename ScalarImageType::PointType parametricOrigin =
-    fieldEstimate->GetOrigin();
-  for( unsigned int d = 0; d < ImageDimension; d++ )
-    {
-    parametricOrigin[d] += (
-        fieldEstimate->GetSpacing()[d] *
-        fieldEstimate->GetLargestPossibleRegion().GetIndex()[d] );
-    }
-  bspliner->SetOrigin( parametricOrigin );
-  bspliner->SetSpacing( fieldEstimate->GetSpacing() );
-  bspliner->SetSize( fieldEstimate->GetLargestPossibleRegion().GetSize() );
-  bspliner->SetDirection( fieldEstimate->GetDirection() );
-  bspliner->SetGenerateOutputImage( false );
-  bspliner->SetNumberOfLevels( numberOfFittingLevels );
-  bspliner->SetSplineOrder( this->m_SplineOrder );
   bspliner->SetNumberOfControlPoints( numberOfControlPoints );
-  bspliner->SetInput( fieldPoints );
-  bspliner->SetPointWeights( weights );
+
+  // The point data was modified in place.
+  bspliner->Modified();
   bspliner->Update();
 
   typename BiasFieldControlPointLatticeType::Pointer phiLattice = bspliner->GetPhiLattice();
@@ -628,29 +634,30 @@ N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
   if( !this->m_LogBiasFieldControlPointLattice )
     {
     this->m_LogBiasFieldControlPointLattice = phiLattice;
+    this->m_LogBiasFieldControlPointLattice->DisconnectPipeline();
     }
   else
     {
-    // Ensure that the two lattices occupy the same physical space.  Not
-    // necessary for performance since the parameters of the reconstructed
-    // bias field are specified later in this function in the reconstructer.
-    phiLattice->CopyInformation( this->m_LogBiasFieldControlPointLattice );
-
-    typedef AddImageFilter<BiasFieldControlPointLatticeType,
-                           BiasFieldControlPointLatticeType,
-                           BiasFieldControlPointLatticeType>
-      AdderType;
-    typename AdderType::Pointer adder = AdderType::New();
-    adder->SetInput1( this->m_LogBiasFieldControlPointLattice );
-    adder->SetInput2( phiLattice );
-    adder->Update();
-
-    this->m_LogBiasFieldControlPointLattice = adder->GetOutput();
+    ImageRegionIterator<BiasFieldControlPointLatticeType> ItL(
+      this->m_LogBiasFieldControlPointLattice,
+      this->m_LogBiasFieldControlPointLattice->GetLargestPossibleRegion() );
+    ImageRegionConstIterator<BiasFieldControlPointLatticeType> ItP(
+      phiLattice, phiLattice->GetLargestPossibleRegion() );
+    for( ItL.GoToBegin(), ItP.GoToBegin(); !ItL.IsAtEnd(); ++ItL, ++ItP )
+      {
+      ItL.Set( ItL.Get() + ItP.Get() );
+      }
     }
 
-  RealImagePointer smoothField = this->ReconstructBiasField( this->m_LogBiasFieldControlPointLattice );
+  // The smoothed residual at the masked voxels is added to the bias field
+  // rather than reconstructing the bias field from the whole lattice.
 
-  return smoothField;
+  const typename BSplineFilterType::PointDataContainerType * fittedResidual =
+    bspliner->GetOutputPointData();
+  for( SizeValueType n = 0; n < logBiasField.size(); n++ )
+    {
+    logBiasField[n] += fittedResidual->GetElement( n )[0];
+    }
 }
 
 template<typename TInputImage, typename TMaskImage, typename TOutputImage>
@@ -694,55 +701,25 @@ template<typename TInputImage, typename TMaskImage, typename TOutputImage>
 typename
 N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::RealType
 N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>
-::CalculateConvergenceMeasurement( const RealImageType *fieldEstimate1,
-                                   const RealImageType *fieldEstimate2 ) const
+::CalculateConvergenceMeasurement( const RealValueArrayType & fieldEstimate1,
+                                   const RealValueArrayType & fieldEstimate2 ) const
 {
-  typedef SubtractImageFilter<RealImageType, RealImageType, RealImageType>
-    SubtracterType;
-  typename SubtracterType::Pointer subtracter = SubtracterType::New();
-  subtracter->SetInput1( fieldEstimate1 );
-  subtracter->SetInput2( fieldEstimate2 );
-  subtracter->Update();
-
   // Calculate statistics over the mask region
 
   RealType mu = 0.0;
   RealType sigma = 0.0;
   RealType N = 0.0;
 
-  const MaskImageType * maskImage = this->GetMaskImage();
-  const RealImageType * confidenceImage = this->GetConfidenceImage();
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-  const MaskPixelType maskLabel = this->GetMaskLabel();
-  const bool useMaskLabel = this->GetUseMaskLabel();
-#endif
-
-  ImageRegionConstIteratorWithIndex<RealImageType> It(
-    subtracter->GetOutput(),
-    subtracter->GetOutput()->GetLargestPossibleRegion() );
-
-  for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+  for( SizeValueType n = 0; n < fieldEstimate1.size(); n++ )
     {
-    if( ( !maskImage ||
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-          ( useMaskLabel && maskImage->GetPixel( It.GetIndex() ) == maskLabel ) || ( !useMaskLabel &&
-#endif
-            maskImage->GetPixel( It.GetIndex() ) != NumericTraits< MaskPixelType >::ZeroValue() )
-#if ! defined ( ITK_FUTURE_LEGACY_REMOVE )
-          )
-#endif
-        && ( !confidenceImage ||
-             confidenceImage->GetPixel( It.GetIndex() ) > 0.0 ) )
-      {
-      RealType pixel = std::exp( It.Get() );
-      N += 1.0;
+    RealType pixel = std::exp( fieldEstimate1[n] - fieldEstimate2[n] );
+    N += 1.0;
 
-      if( N > 1.0 )
-        {
-        sigma = sigma + itk::Math::sqr( pixel - mu ) * ( N - 1.0 ) / N;
-        }
-      mu = mu * ( 1.0 - 1.0 / N ) + pixel / N;
+    if( N > 1.0 )
+      {
+      sigma = sigma + itk::Math::sqr( pixel - mu ) * ( N - 1.0 ) / N;
       }
+    mu = mu * ( 1.0 - 1.0 / N ) + pixel / N;
     }
   sigma = std::sqrt( sigma / ( N - 1.0 ) );
 
@@ -0,0 +1,208 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkN4BiasFieldCorrectionImageFilter.h"
+#include "itkTestingMacros.h"
+
+/**
+ * In this test, we correct a synthetic two class image multiplied by a
+ * smooth bias field inside an elliptic mask.  The control point lattice
+ * must not depend on the number of threads nor on the voxels outside the
+ * mask, and the correction must reduce the spread of the intensities of
+ * each class.
+ */
+namespace
+{
+
+const unsigned int Dimension = 2;
+
+typedef itk::Image<float, Dimension>                                ImageType;
+typedef itk::Image<unsigned char, Dimension>                        MaskImageType;
+typedef itk::N4BiasFieldCorrectionImageFilter<ImageType, MaskImageType,
+                                              ImageType>           CorrecterType;
+
+bool
+SameLattices( const CorrecterType::BiasFieldControlPointLatticeType *expected,
+              const CorrecterType::BiasFieldControlPointLatticeType *actual )
+{
+  if( expected->GetLargestPossibleRegion() != actual->GetLargestPossibleRegion() )
+    {
+    std::cerr << "Different lattice regions" << std::endl;
+    return false;
+    }
+  itk::ImageRegionConstIterator<CorrecterType::BiasFieldControlPointLatticeType>
+    eIt( expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator<CorrecterType::BiasFieldControlPointLatticeType>
+    aIt( actual, actual->GetLargestPossibleRegion() );
+  for( ; !eIt.IsAtEnd(); ++eIt, ++aIt )
+    {
+    if( eIt.Get() != aIt.Get() )
+      {
+      std::cerr << "Different control points: " << eIt.Get()
+                << " and " << aIt.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// Coefficient of variation of the intensities of the class of the
+// voxels of the mask.
+double
+CoefficientOfVariation( const ImageType *image, const MaskImageType *mask,
+                        const MaskImageType *classes, unsigned char label )
+{
+  double sum = 0.0;
+  double squares = 0.0;
+  double n = 0.0;
+  itk::ImageRegionConstIterator<ImageType> It( image, image->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator<MaskImageType> ItM( mask, mask->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator<MaskImageType> ItC( classes, classes->GetLargestPossibleRegion() );
+  for( ; !It.IsAtEnd(); ++It, ++ItM, ++ItC )
+    {
+    if( ItM.Get() && ItC.Get() == label )
+      {
+      sum += It.Get();
+      squares += It.Get() * It.Get();
+      n += 1.0;
+      }
+    }
+  const double mean = sum / n;
+  return std::sqrt( squares / n - mean * mean ) / mean;
+}
+
+}
+
+int itkN4BiasFieldCorrectionImageFilterMaskTest( int, char * [] )
+{
+  ImageType::SizeType size;
+  size[0] = 96;
+  size[1] = 80;
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  MaskImageType::Pointer mask = MaskImageType::New();
+  mask->SetRegions( size );
+  mask->Allocate();
+
+  MaskImageType::Pointer classes = MaskImageType::New();
+  classes->SetRegions( size );
+  classes->Allocate();
+
+  // Two classes of stripes multiplied by a smooth bias field.
+  itk::ImageRegionIteratorWithIndex<ImageType> It( image, image->GetLargestPossibleRegion() );
+  for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    const ImageType::IndexType index = It.GetIndex();
+    const double x = index[0] / static_cast<double>( size[0] - 1 );
+    const double y = index[1] / static_cast<double>( size[1] - 1 );
+
+    const double ex = ( x - 0.5 ) / 0.45;
+    const double ey = ( y - 0.5 ) / 0.4;
+    const bool isInside = ( ex * ex + ey * ey < 1.0 );
+    const unsigned char label = ( ( index[0] / 8 + index[1] / 10 ) % 2 ) ? 2 : 1;
+
+    const double bias = std::exp( 0.4 * std::sin( 2.5 * x ) * std::cos( 1.5 * y ) + 0.2 * y );
+    It.Set( static_cast<float>( 100.0 * label * bias ) );
+    mask->SetPixel( index, isInside );
+    classes->SetPixel( index, label );
+    }
+
+  typedef CorrecterType::BiasFieldControlPointLatticeType LatticeType;
+  LatticeType::Pointer lattices[2];
+  ImageType::Pointer corrected;
+
+  const itk::ThreadIdType numberOfThreads[2] = { 1, 3 };
+  for( unsigned int t = 0; t < 2; t++ )
+    {
+    CorrecterType::Pointer correcter = CorrecterType::New();
+    correcter->SetInput( image );
+    correcter->SetMaskImage( mask );
+    correcter->SetConvergenceThreshold( 0.0 );
+    CorrecterType::VariableSizeArrayType maximumNumberOfIterations( 2 );
+    maximumNumberOfIterations.Fill( 15 );
+    correcter->SetMaximumNumberOfIterations( maximumNumberOfIterations );
+    correcter->SetNumberOfFittingLevels( 2 );
+    correcter->SetNumberOfThreads( numberOfThreads[t] );
+
+    TRY_EXPECT_NO_EXCEPTION( correcter->Update() );
+
+    lattices[t] = const_cast<LatticeType *>( correcter->GetLogBiasFieldControlPointLattice() );
+    corrected = correcter->GetOutput();
+    corrected->DisconnectPipeline();
+    }
+
+  // The results do not depend on the number of threads.
+  bool success = SameLattices( lattices[0], lattices[1] );
+
+  // The voxels outside the mask are ignored.
+  ImageType::Pointer noisyImage = ImageType::New();
+  noisyImage->SetRegions( size );
+  noisyImage->Allocate();
+  unsigned int value = 3;
+  itk::ImageRegionIteratorWithIndex<ImageType> ItN( noisyImage, noisyImage->GetLargestPossibleRegion() );
+  for( ItN.GoToBegin(); !ItN.IsAtEnd(); ++ItN )
+    {
+    value = value * 1664525u + 1013904223u;
+    if( mask->GetPixel( ItN.GetIndex() ) )
+      {
+      ItN.Set( image->GetPixel( ItN.GetIndex() ) );
+      }
+    else
+      {
+      ItN.Set( static_cast<float>( ( value >> 8 ) % 1000 ) );
+      }
+    }
+
+  CorrecterType::Pointer correcter = CorrecterType::New();
+  correcter->SetInput( noisyImage );
+  correcter->SetMaskImage( mask );
+  correcter->SetConvergenceThreshold( 0.0 );
+  CorrecterType::VariableSizeArrayType maximumNumberOfIterations( 2 );
+  maximumNumberOfIterations.Fill( 15 );
+  correcter->SetMaximumNumberOfIterations( maximumNumberOfIterations );
+  correcter->SetNumberOfFittingLevels( 2 );
+  TRY_EXPECT_NO_EXCEPTION( correcter->Update() );
+  success &= SameLattices( lattices[0], correcter->GetLogBiasFieldControlPointLattice() );
+
+  // The correction reduces the spread of the intensities of each class.
+  for( unsigned char label = 1; label <= 2; label++ )
+    {
+    const double before = CoefficientOfVariation( image, mask, classes, label );
+    const double after = CoefficientOfVariation( corrected, mask, classes, label );
+    std::cout << "Class " << static_cast<int>( label )
+              << ": coefficient of variation " << before << " -> " << after << std::endl;
+    if( !( after < 0.5 * before ) )
+      {
+      std::cerr << "The bias field was not corrected." << std::endl;
+      success = false;
+      }
+    }
+
+  if( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
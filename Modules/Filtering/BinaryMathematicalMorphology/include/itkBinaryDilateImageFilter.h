@@ -30,15 +30,9 @@ namespace itk
  * \brief Fast binary dilation
  *
  * BinaryDilateImageFilter is a binary dilation
- * morphologic operation. This implementation is based on the papers:
- *
- * L.Vincent "Morphological transformations of binary images with
- * arbitrary structuring elements", and
- *
- * N.Nikopoulos et al. "An efficient algorithm for 3d binary
- * morphological transformations with 3d structuring elements
- * for arbitrary size and shape". IEEE Transactions on Image
- * Processing. Vol. 9. No. 3. 2000. pp. 283-286.
+ * morphologic operation. The structuring element is decomposed in
+ * chords, and the dilation is computed on the image packed in words of
+ * 64 pixels, as described in BinaryMorphologyImageFilter.
  *
  * Gray scale images can be processed as binary images by selecting a
  * "DilateValue".  Pixel values matching the dilate value are
@@ -127,7 +121,8 @@ protected:
   virtual ~BinaryDilateImageFilter() ITK_OVERRIDE {}
   void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
 
-  void GenerateData() ITK_OVERRIDE;
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId) ITK_OVERRIDE;
 
   // type inherited from the superclass
   typedef typename Superclass::NeighborIndexContainer NeighborIndexContainer;
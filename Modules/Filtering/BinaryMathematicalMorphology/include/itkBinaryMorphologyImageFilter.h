@@ -25,6 +25,9 @@
 #include "itkImageBoundaryCondition.h"
 #include "itkImageRegionIterator.h"
 #include "itkConceptChecking.h"
+#include "itkImageRegionSplitterDirection.h"
+#include "itkChordUtilities.h"
+#include "itkBinaryPackedMorphologyEngine.h"
 
 namespace itk
 {
@@ -33,16 +36,7 @@ namespace itk
  * \brief Base class for fast binary dilation and erosion
  *
  * BinaryMorphologyImageFilter is a base class for fast binary
- * morphological operations. The implementation of this class and its
- * subclasses are based on the papers:
- *
- * L.Vincent "Morphological transformations of binary images with
- * arbitrary structuring elements", and
- *
- * N.Nikopoulos et al. "An efficient algorithm for 3d binary
- * morphological transformations with 3d structuring elements
- * for arbitrary size and shape". IEEE Transactions on Image
- * Processing. Vol. 9. No. 3. 2000. pp. 283-286.
+ * morphological operations.
  *
  * Gray scale images can be processed as binary images by selecting a
  * "ForegroundValued" (which subclasses may alias as "DilateValue" or
@@ -62,24 +56,19 @@ namespace itk
  *
  * Description of the algorithm:
  * ----------------------------------------------
- * Let's consider the set of the ON elements of the input image as X.
- *
- * Let's consider the structuring element as B = {B0, B1, ..., Bn},
- * where Bi denotes a connected component of B.
- *
- * Let's consider bi, i in [0,n], an arbitrary point of Bi.
- *
- * We use hence the next property in order to compute minkoswki
- * addition ( which will be written (+) ):
- *
- * X (+) B = ( Xb0 UNION Xb1 UNION ... Xbn ) UNION ( BORDER(X) (+) B ),
- *
- * where Xbi is the set X translated with respect to vector bi :
- *
- * Xbi ={ x + bi, x belongs to X }
- *
- * where BORDER(X) is the extracted border of X ( 8 connectivity in
- * 2D, 26 in 3D )
+ * The structuring element is decomposed in chords, the runs of its
+ * pixels along the last dimension (see StructuringElementChord). The
+ * pixels of the image are packed in words of 64 pixels along the first
+ * dimension. For each length of chord, the union over the windows of
+ * that length along the last dimension is computed with the algorithm of
+ * van Herk and Gil-Werman on whole planes of words, and the dilation is
+ * the union of these window images, translated by the starts of the
+ * chords of that length. The erosion is the complement of the dilation
+ * of the background. The cost per pixel depends on the number of chords,
+ * but neither on the number of pixels of the structuring element nor on
+ * the content of the image, and is divided by the 64 pixels of a word.
+ * The image is split among the threads along all the dimensions but the
+ * last one.
  *
  * Our implementation for dilation is defined as:
  *
@@ -94,7 +83,15 @@ namespace itk
  * Lehmann from INRA de Jouy-en-Josas then provided a fast erosion
  * implementaton based on Jerome's implementation.  The common
  * portions of these two implementations were then placed in this
- * superclass.
+ * superclass. Both were based on the papers:
+ *
+ * L.Vincent "Morphological transformations of binary images with
+ * arbitrary structuring elements", and
+ *
+ * N.Nikopoulos et al. "An efficient algorithm for 3d binary
+ * morphological transformations with 3d structuring elements
+ * for arbitrary size and shape". IEEE Transactions on Image
+ * Processing. Vol. 9. No. 3. 2000. pp. 283-286.
  *
  * \sa ImageToImageFilter BinaryErodeImageFilter BinaryDilateImageFilter
  * \ingroup ITKBinaryMathematicalMorphology
@@ -190,9 +187,22 @@ protected:
   void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
 
   /**
-   * Analyze kernel and prepare data for GenerateData() function */
+   * Compute the difference sets and the connected components of the
+   * kernel. The filters only use the chords of the kernel, so this is
+   * done on demand by the accessors below. */
   void AnalyzeKernel();
 
+  /** Dilate the foreground of the input, or its background for an
+   * erosion, in the region, with the chords of the kernel, and set the
+   * dilated (or not eroded) pixels of the output to the foreground value.
+   * The other foreground pixels are set to the background value, and the
+   * other pixels keep their input value. */
+  void ThreadedPackedMorphology(const OutputImageRegionType & outputRegionForThread,
+                                ThreadIdType threadId, bool erosion);
+
+  /** The image is not split along the chords. */
+  const ImageRegionSplitterBase * GetImageRegionSplitter() const ITK_OVERRIDE;
+
   /** Type definition of container of neighbourhood index */
   typedef std::vector< OffsetType > NeighborIndexContainer;
 
@@ -209,17 +219,35 @@ protected:
   /**
    * Get the difference set for a particular offset */
   NeighborIndexContainer & GetDifferenceSet(unsigned int code)
-  { return m_KernelDifferenceSets[code]; }
+  {
+    if ( !m_KernelAnalyzed )
+      {
+      this->AnalyzeKernel();
+      }
+    return m_KernelDifferenceSets[code];
+  }
 
   /**
    * Get an iterator to the start of the connected component vector */
   ComponentVectorConstIterator KernelCCVectorBegin()
-  { return m_KernelCCVector.begin(); }
+  {
+    if ( !m_KernelAnalyzed )
+      {
+      this->AnalyzeKernel();
+      }
+    return m_KernelCCVector.begin();
+  }
 
   /**
    * Get an iterator to the end of the connected component vector */
   ComponentVectorConstIterator KernelCCVectorEnd()
-  { return m_KernelCCVector.end(); }
+  {
+    if ( !m_KernelAnalyzed )
+      {
+      this->AnalyzeKernel();
+      }
+    return m_KernelCCVector.end();
+  }
 
   bool m_BoundaryToForeground;
 
@@ -239,6 +267,20 @@ private:
    * store the position of one element, arbitrary chosen, which belongs
    * to the CC */
   std::vector< OffsetType > m_KernelCCVector;
+
+  /** Whether the difference sets and connected components match the
+   * kernel. */
+  bool m_KernelAnalyzed;
+
+  /** The pixels are packed in words, along the first dimension. */
+  typedef BinaryPackedMorphologyEngine< itkGetStaticConstMacro(InputImageDimension) > EngineType;
+  typedef typename EngineType::WordType                                             WordType;
+  typedef typename EngineType::WordVectorType                                       WordVectorType;
+
+  /** The chords of the structuring element reflected through its center. */
+  std::vector< StructuringElementChord< itkGetStaticConstMacro(InputImageDimension) > > m_KernelChords;
+
+  ImageRegionSplitterDirection::Pointer m_ImageRegionSplitter;
 };
 } // end namespace itk
 
@@ -25,6 +25,8 @@
 #include "itkConstantBoundaryCondition.h"
 #include "itkOffset.h"
 #include "itkProgressReporter.h"
+#include "itkImageScanlineIterator.h"
+#include "itkMath.h"
 #include "itkBinaryMorphologyImageFilter.h"
 
 namespace itk
@@ -35,8 +37,20 @@ BinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
 {
   m_ForegroundValue = NumericTraits< InputPixelType >::max();
   m_BackgroundValue = NumericTraits< OutputPixelType >::NonpositiveMin();
-  //this->SetNumberOfThreads(1);
-  this->AnalyzeKernel();
+  m_ImageRegionSplitter = ImageRegionSplitterDirection::New();
+  m_ImageRegionSplitter->SetDirection(InputImageDimension - 1);
+  // the pixels painted by the foreground pixels are the ones of the
+  // reflected structuring element
+  m_KernelChords = DecomposeInChords(this->GetKernel(), true);
+  m_KernelAnalyzed = false;
+}
+
+template< typename TInputImage, typename TOutputImage, typename TKernel >
+const ImageRegionSplitterBase *
+BinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
+::GetImageRegionSplitter() const
+{
+  return m_ImageRegionSplitter;
 }
 
 template< typename TInputImage, typename TOutputImage, typename TKernel >
@@ -45,8 +59,9 @@ BinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
 ::SetKernel(const KernelType & kernel)
 {
   Superclass::SetKernel(kernel);
-  // Analyse it: the following process depends only on kernel
-  this->AnalyzeKernel();
+  m_KernelChords = DecomposeInChords(this->GetKernel(), true);
+  // The difference sets are only computed if asked for.
+  m_KernelAnalyzed = false;
 }
 
 template< typename TInputImage, typename TOutputImage, typename TKernel >
@@ -57,6 +72,7 @@ BinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
   // Sure clearing
   m_KernelDifferenceSets.clear();
   m_KernelCCVector.clear();
+  m_KernelAnalyzed = true;
 
   std::vector< unsigned int > kernelOnElements;
 
@@ -330,6 +346,129 @@ BinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
     }
 }
 
+template< typename TInputImage, typename TOutputImage, typename TKernel >
+void
+BinaryMorphologyImageFilter< TInputImage, TOutputImage, TKernel >
+::ThreadedPackedMorphology(const OutputImageRegionType & outputRegionForThread,
+                           ThreadIdType threadId, bool erosion)
+{
+  const InputImageType *input = this->GetInput();
+  OutputImageType *     output = this->GetOutput();
+
+  ProgressReporter progress(this, threadId, static_cast< SizeValueType >( m_KernelChords.size() ) + 2);
+
+  if ( outputRegionForThread.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  // pack the pixels to dilate: the foreground, or the background for an
+  // erosion, with the boundary when it has the same value
+  InputImageRegionType paddedRegion = outputRegionForThread;
+  if ( !m_KernelChords.empty() )
+    {
+    paddedRegion = PadRegionByChords(outputRegionForThread, m_KernelChords);
+    }
+  const SizeValueType paddedLineWords = EngineType::LineWords(paddedRegion);
+  const SizeValueType numberOfPaddedLines = paddedRegion.GetNumberOfPixels() / paddedRegion.GetSize(0);
+
+  const WordType outsideWord = ( m_BoundaryToForeground != erosion ) ? ~WordType(0) : WordType(0);
+  WordVectorType words(numberOfPaddedLines * paddedLineWords, outsideWord);
+  InputImageRegionType inputRegion = paddedRegion;
+  if ( inputRegion.Crop( input->GetBufferedRegion() ) )
+    {
+    ImageScanlineConstIterator< InputImageType > inputIt(input, inputRegion);
+    while ( !inputIt.IsAtEnd() )
+      {
+      const IndexType & index = inputIt.GetIndex();
+      SizeValueType     paddedLine = 0;
+      SizeValueType     stride = 1;
+      for ( unsigned int d = 1; d < InputImageDimension; ++d )
+        {
+        paddedLine += ( index[d] - paddedRegion.GetIndex(d) ) * stride;
+        stride *= paddedRegion.GetSize(d);
+        }
+      WordType *lineWords = &words[paddedLine * paddedLineWords];
+      for ( SizeValueType position = index[0] - paddedRegion.GetIndex(0); !inputIt.IsAtEndOfLine(); ++position )
+        {
+        WordType &     word = lineWords[position / EngineType::PixelsPerWord];
+        const WordType bit = WordType(1) << ( position % EngineType::PixelsPerWord );
+        if ( Math::ExactlyEquals(inputIt.Get(), m_ForegroundValue) != erosion )
+          {
+          word |= bit;
+          }
+        else
+          {
+          word &= ~bit;
+          }
+        ++inputIt;
+        }
+      inputIt.NextLine();
+      }
+    }
+  progress.CompletedPixel();
+
+  // the union of the windows of the chords of each length, translated by
+  // their starts
+  const SizeValueType numberOfLines = outputRegionForThread.GetNumberOfPixels() / outputRegionForThread.GetSize(0);
+  const SizeValueType lineWords = EngineType::LineWords(outputRegionForThread);
+  WordVectorType      dilated(numberOfLines * lineWords, 0);
+  WordVectorType      windows;
+  for ( unsigned int first = 0, last = 0; first < m_KernelChords.size(); first = last )
+    {
+    const SizeValueType length = m_KernelChords[first].m_Length;
+    if ( length > 1 )
+      {
+      windows = words;
+      EngineType::DilateByLine(windows, paddedRegion, paddedLineWords, InputImageDimension - 1, length);
+      }
+    const WordVectorType & source = ( length > 1 ) ? windows : words;
+
+    for ( last = first; last < m_KernelChords.size() && m_KernelChords[last].m_Length == length; ++last )
+      {
+      // the window of the chord starts at its first pixel
+      OffsetType shift;
+      for ( unsigned int d = 0; d < InputImageDimension; ++d )
+        {
+        shift[d] = -m_KernelChords[last].m_Start[d];
+        }
+      EngineType::AccumulateLines(source, paddedRegion, paddedLineWords, outputRegionForThread, shift, dilated);
+      progress.CompletedPixel();
+      }
+    }
+
+  // unpack the result
+  ImageScanlineConstIterator< InputImageType > inputIt(input, outputRegionForThread);
+  ImageScanlineIterator< OutputImageType >     outputIt(output, outputRegionForThread);
+  for ( SizeValueType line = 0; !outputIt.IsAtEnd(); ++line )
+    {
+    const WordType *dilatedLine = &dilated[line * lineWords];
+    for ( SizeValueType position = 0; !outputIt.IsAtEndOfLine(); ++position )
+      {
+      const bool     isDilated =
+        ( dilatedLine[position / EngineType::PixelsPerWord] >> ( position % EngineType::PixelsPerWord ) ) & 1;
+      const InputPixelType value = inputIt.Get();
+      if ( isDilated != erosion )
+        {
+        outputIt.Set( static_cast< OutputPixelType >( m_ForegroundValue ) );
+        }
+      else if ( Math::ExactlyEquals(value, m_ForegroundValue) )
+        {
+        outputIt.Set(m_BackgroundValue);
+        }
+      else
+        {
+        outputIt.Set( static_cast< OutputPixelType >( value ) );
+        }
+      ++inputIt;
+      ++outputIt;
+      }
+    inputIt.NextLine();
+    outputIt.NextLine();
+    }
+  progress.CompletedPixel();
+}
+
 /**
  * Standard "PrintSelf" method
  */
@@ -0,0 +1,89 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedAndImageFilter_h
+#define itkBinaryPackedAndImageFilter_h
+
+#include "itkBinaryPackedFunctorImageFilter.h"
+
+namespace itk
+{
+namespace Functor
+{
+/** \class BinaryPackedAND
+ * \brief Bitwise and of the words of two BinaryPackedImages.
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TWord >
+class BinaryPackedAND
+{
+public:
+  bool operator!=(const BinaryPackedAND &) const
+  {
+    return false;
+  }
+
+  bool operator==(const BinaryPackedAND & other) const
+  {
+    return !( *this != other );
+  }
+
+  inline TWord operator()(const TWord & A, const TWord & B) const
+  {
+    return A & B;
+  }
+};
+} // end namespace Functor
+
+/** \class BinaryPackedAndImageFilter
+ * \brief Compute the logical and of two BinaryPackedImages, 64 pixels
+ * at a time.
+ *
+ * \sa BinaryPackedImage, BinaryPackedFunctorImageFilter,
+ * BinaryPackedOrImageFilter, BinaryPackedXorImageFilter, AndImageFilter
+ * \ingroup MultiThreaded
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TImage >
+class BinaryPackedAndImageFilter:
+  public BinaryPackedFunctorImageFilter< TImage, Functor::BinaryPackedAND< typename TImage::WordType > >
+{
+public:
+  /** Standard class typedefs. */
+  typedef BinaryPackedAndImageFilter Self;
+  typedef BinaryPackedFunctorImageFilter< TImage,
+                                          Functor::BinaryPackedAND< typename TImage::WordType > > Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(BinaryPackedAndImageFilter,
+               BinaryPackedFunctorImageFilter);
+
+protected:
+  BinaryPackedAndImageFilter() {}
+  virtual ~BinaryPackedAndImageFilter() ITK_OVERRIDE {}
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryPackedAndImageFilter);
+};
+} // end namespace itk
+
+#endif
@@ -0,0 +1,73 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedDilateImageFilter_h
+#define itkBinaryPackedDilateImageFilter_h
+
+#include "itkBinaryPackedMorphologyImageFilter.h"
+
+namespace itk
+{
+/**
+ * \class BinaryPackedDilateImageFilter
+ * \brief Fast binary dilation of a BinaryPackedImage by a box or a cross.
+ *
+ * The dilation is computed on words of 64 pixels, in a number of steps
+ * which is logarithmic in the radius, as described in
+ * BinaryPackedMorphologyImageFilter.  BoundaryToForeground defaults to
+ * false.
+ *
+ * \sa BinaryPackedImage, BinaryPackedErodeImageFilter,
+ * BinaryDilateImageFilter
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TImage >
+class ITK_TEMPLATE_EXPORT BinaryPackedDilateImageFilter:
+  public BinaryPackedMorphologyImageFilter< TImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef BinaryPackedDilateImageFilter               Self;
+  typedef BinaryPackedMorphologyImageFilter< TImage > Superclass;
+  typedef SmartPointer< Self >                        Pointer;
+  typedef SmartPointer< const Self >                  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(BinaryPackedDilateImageFilter, BinaryPackedMorphologyImageFilter);
+
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+
+protected:
+  BinaryPackedDilateImageFilter();
+  ~BinaryPackedDilateImageFilter() ITK_OVERRIDE {}
+
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId) ITK_OVERRIDE;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryPackedDilateImageFilter);
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryPackedDilateImageFilter.hxx"
+#endif
+
+#endif
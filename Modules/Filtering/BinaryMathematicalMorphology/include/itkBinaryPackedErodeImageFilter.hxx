@@ -0,0 +1,42 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedErodeImageFilter_hxx
+#define itkBinaryPackedErodeImageFilter_hxx
+
+#include "itkBinaryPackedErodeImageFilter.h"
+
+namespace itk
+{
+template< typename TImage >
+BinaryPackedErodeImageFilter< TImage >
+::BinaryPackedErodeImageFilter()
+{
+  this->m_BoundaryToForeground = true;
+}
+
+template< typename TImage >
+void
+BinaryPackedErodeImageFilter< TImage >
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                       ThreadIdType threadId)
+{
+  this->ThreadedPackedMorphology(outputRegionForThread, threadId, true);
+}
+} // end namespace itk
+
+#endif
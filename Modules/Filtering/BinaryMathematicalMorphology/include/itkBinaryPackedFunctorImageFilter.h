@@ -0,0 +1,115 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedFunctorImageFilter_h
+#define itkBinaryPackedFunctorImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkImageRegionSplitterDirection.h"
+#include "itkBinaryPackedImage.h"
+
+namespace itk
+{
+/** \class BinaryPackedFunctorImageFilter
+ * \brief Apply a logic function to the words of two BinaryPackedImages.
+ *
+ * The function is applied to whole words of 64 pixels.  It takes two
+ * words and returns the word of the output, for example the bitwise and
+ * of the words for BinaryPackedAndImageFilter.  The inputs may have
+ * different buffered regions: their words are then shifted to the
+ * alignment of the output.  The bits after the end of the lines of the
+ * output are cleared.
+ *
+ * The lines of the output are not split between the threads, so that a
+ * word is only written by one thread.
+ *
+ * \sa BinaryPackedImage, BinaryPackedAndImageFilter,
+ * BinaryPackedOrImageFilter, BinaryPackedXorImageFilter,
+ * BinaryFunctorImageFilter
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TImage, typename TFunction >
+class ITK_TEMPLATE_EXPORT BinaryPackedFunctorImageFilter:
+  public ImageToImageFilter< TImage, TImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef BinaryPackedFunctorImageFilter       Self;
+  typedef ImageToImageFilter< TImage, TImage > Superclass;
+  typedef SmartPointer< Self >                 Pointer;
+  typedef SmartPointer< const Self >           ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(BinaryPackedFunctorImageFilter, ImageToImageFilter);
+
+  /** Some typedefs. */
+  typedef TFunction                      FunctorType;
+  typedef TImage                         ImageType;
+  typedef typename ImageType::RegionType RegionType;
+  typedef typename ImageType::WordType   WordType;
+  typedef ImageType                      OutputImageType;
+  typedef RegionType                     OutputImageRegionType;
+
+  /** Dimension of the images. */
+  itkStaticConstMacro(ImageDimension, unsigned int, TImage::ImageDimension);
+
+  /** Connect one of the operands. */
+  void SetInput1(const ImageType *image1)
+  {
+    this->SetNthInput( 0, const_cast< ImageType * >( image1 ) );
+  }
+
+  /** Connect the other operand. */
+  void SetInput2(const ImageType *image2)
+  {
+    this->SetNthInput( 1, const_cast< ImageType * >( image2 ) );
+  }
+
+  /** Get the functor object.  The functor is returned by reference.
+   * (Functors do not have to derive from itk::LightObject, so they do
+   * not necessarily have a reference count. So we cannot return a
+   * SmartPointer.) */
+  FunctorType & GetFunctor() { return m_Functor; }
+  const FunctorType & GetFunctor() const { return m_Functor; }
+
+protected:
+  BinaryPackedFunctorImageFilter();
+  ~BinaryPackedFunctorImageFilter() ITK_OVERRIDE {}
+
+  virtual void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                    ThreadIdType threadId) ITK_OVERRIDE;
+
+  /** The lines are not split between the threads. */
+  virtual const ImageRegionSplitterBase * GetImageRegionSplitter() const ITK_OVERRIDE;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryPackedFunctorImageFilter);
+
+  FunctorType m_Functor;
+
+  ImageRegionSplitterDirection::Pointer m_ImageRegionSplitter;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryPackedFunctorImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,108 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedFunctorImageFilter_hxx
+#define itkBinaryPackedFunctorImageFilter_hxx
+
+#include "itkBinaryPackedFunctorImageFilter.h"
+#include "itkProgressReporter.h"
+
+namespace itk
+{
+template< typename TImage, typename TFunction >
+BinaryPackedFunctorImageFilter< TImage, TFunction >
+::BinaryPackedFunctorImageFilter()
+{
+  this->SetNumberOfRequiredInputs(2);
+
+  m_ImageRegionSplitter = ImageRegionSplitterDirection::New();
+  m_ImageRegionSplitter->SetDirection(0);
+}
+
+template< typename TImage, typename TFunction >
+const ImageRegionSplitterBase *
+BinaryPackedFunctorImageFilter< TImage, TFunction >
+::GetImageRegionSplitter() const
+{
+  return m_ImageRegionSplitter;
+}
+
+template< typename TImage, typename TFunction >
+void
+BinaryPackedFunctorImageFilter< TImage, TFunction >
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId)
+{
+  const ImageType *input1 = this->GetInput(0);
+  const ImageType *input2 = this->GetInput(1);
+  ImageType *      output = this->GetOutput();
+
+  const SizeValueType lineLength = outputRegionForThread.GetSize(0);
+  if ( lineLength == 0 )
+    {
+    return;
+    }
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() / lineLength );
+
+  // the output lines are whole lines of the output buffer
+  const SizeValueType   numberOfWords = output->GetWordsPerLine();
+  const WordType        lastWordMask = ImageType::LastWordMask(lineLength);
+  const SizeValueType   numberOfWords1 = input1->GetWordsPerLine();
+  const SizeValueType   numberOfWords2 = input2->GetWordsPerLine();
+  const OffsetValueType lineStart1 = outputRegionForThread.GetIndex(0) - input1->GetBufferedRegion().GetIndex(0);
+  const OffsetValueType lineStart2 = outputRegionForThread.GetIndex(0) - input2->GetBufferedRegion().GetIndex(0);
+
+  // iterate over the lines with an index of the first dimension only
+  RegionType lines = outputRegionForThread;
+  lines.SetSize(0, 1);
+  typename ImageType::IndexType index = lines.GetIndex();
+  for ( SizeValueType line = 0; line < lines.GetNumberOfPixels(); ++line )
+    {
+    SizeValueType remainder = line;
+    for ( unsigned int d = 1; d < ImageDimension; ++d )
+      {
+      index[d] = lines.GetIndex(d) + static_cast< IndexValueType >( remainder % lines.GetSize(d) );
+      remainder /= lines.GetSize(d);
+      }
+
+    const WordType *words1 = input1->GetLineWords( input1->ComputeLineId(index) );
+    const WordType *words2 = input2->GetLineWords( input2->ComputeLineId(index) );
+    WordType *      words = output->GetLineWords( output->ComputeLineId(index) );
+    if ( lineStart1 == 0 && lineStart2 == 0 && numberOfWords1 == numberOfWords && numberOfWords2 == numberOfWords )
+      {
+      // the words of the inputs and of the output are aligned
+      for ( SizeValueType w = 0; w < numberOfWords; ++w )
+        {
+        words[w] = m_Functor(words1[w], words2[w]);
+        }
+      }
+    else
+      {
+      for ( SizeValueType w = 0; w < numberOfWords; ++w )
+        {
+        const OffsetValueType position = static_cast< OffsetValueType >( w * ImageType::PixelsPerWord );
+        words[w] = m_Functor( ImageType::ReadWord(words1, numberOfWords1, lineStart1 + position),
+                              ImageType::ReadWord(words2, numberOfWords2, lineStart2 + position) );
+        }
+      }
+    words[numberOfWords - 1] &= lastWordMask;
+    progress.CompletedPixel();
+    }
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,246 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedImage_h
+#define itkBinaryPackedImage_h
+
+#include "itkImageBase.h"
+#include "itkImportImageContainer.h"
+
+namespace itk
+{
+/** \class BinaryPackedImage
+ *  \brief Templated n-dimensional binary image with one bit per pixel.
+ *
+ * BinaryPackedImage stores each line of the buffered region along the
+ * first dimension in 64 bit words, so a mask takes 8 times less memory
+ * than in an Image of unsigned char, and the logic operations and the
+ * morphology process 64 pixels at once.  The lines start on a word, and
+ * the bits of the last word of a line after the end of the line are
+ * always zero.
+ *
+ * Like RLEImage, BinaryPackedImage derives from ImageBase, so it can be
+ * the input or the output of the pipeline filters.  It is produced from
+ * an image by ImageToBinaryPackedImageFilter, which thresholds the
+ * pixels, and decoded by BinaryPackedImageToImageFilter, which only
+ * decodes its requested region, so the writing of a file can be
+ * streamed:
+ *
+ * \code
+ * decoder->SetInput( packedImage );
+ * writer->SetInput( decoder->GetOutput() );
+ * writer->SetNumberOfStreamDivisions( 20 );
+ * writer->Update();
+ * \endcode
+ *
+ * To visit the pixels of a region, use BinaryPackedImageRegionIterator
+ * and BinaryPackedImageRegionConstIterator.  The filters access the words
+ * of the lines with GetLineWords() and ReadWord().
+ *
+ * \sa BinaryPackedImageRegionIterator, BinaryPackedFunctorImageFilter,
+ * BinaryPackedMorphologyImageFilter
+ * \ingroup ImageObjects
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< unsigned int VImageDimension = 3 >
+class ITK_TEMPLATE_EXPORT BinaryPackedImage:public ImageBase< VImageDimension >
+{
+public:
+  /** Standard class typedefs */
+  typedef BinaryPackedImage             Self;
+  typedef ImageBase< VImageDimension >  Superclass;
+  typedef SmartPointer< Self >          Pointer;
+  typedef SmartPointer< const Self >    ConstPointer;
+  typedef WeakPointer< const Self >     ConstWeakPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(BinaryPackedImage, ImageBase);
+
+  /** Dimension of the image. */
+  itkStaticConstMacro(ImageDimension, unsigned int, VImageDimension);
+
+  /** Pixel typedef support. */
+  typedef bool PixelType;
+  typedef bool ValueType;
+
+  typedef typename Superclass::SizeValueType   SizeValueType;
+  typedef typename Superclass::IndexType       IndexType;
+  typedef typename Superclass::IndexValueType  IndexValueType;
+  typedef typename Superclass::OffsetType      OffsetType;
+  typedef typename Superclass::OffsetValueType OffsetValueType;
+  typedef typename Superclass::SizeType        SizeType;
+  typedef typename Superclass::DirectionType   DirectionType;
+  typedef typename Superclass::RegionType      RegionType;
+  typedef typename Superclass::SpacingType     SpacingType;
+  typedef typename Superclass::PointType       PointType;
+
+  /** Type of the words which store the pixels. */
+  typedef uint64_t WordType;
+
+  /** Number of pixels in a word. */
+  itkStaticConstMacro(PixelsPerWord, unsigned int, 64);
+
+  /** The container of the words, line after line in the order of the
+   * buffered region. */
+  typedef ImportImageContainer< SizeValueType, WordType > BufferType;
+  typedef typename BufferType::Pointer                    BufferPointer;
+
+  /** Restore the data object to its initial state. This means releasing
+   * memory. */
+  virtual void Initialize() ITK_OVERRIDE;
+
+  /** Allocate the lines of the buffered region.  The pixels are always
+   * initialized to false, so that the bits after the end of the lines
+   * are zero. */
+  virtual void Allocate(bool initialize = false) ITK_OVERRIDE;
+
+  /** Fill the buffered region with a value. */
+  void FillBuffer(bool value);
+
+  /** Get a pixel.  The index must be in the buffered region. */
+  bool GetPixel(const IndexType & index) const
+  {
+    const SizeValueType position = static_cast< SizeValueType >( index[0] - this->GetBufferedRegion().GetIndex(0) );
+    return ( this->GetLineWords( this->ComputeLineId(index) )[position / PixelsPerWord]
+             >> ( position % PixelsPerWord ) ) & 1;
+  }
+
+  /** Set a pixel.  The index must be in the buffered region. */
+  void SetPixel(const IndexType & index, bool value)
+  {
+    const SizeValueType position = static_cast< SizeValueType >( index[0] - this->GetBufferedRegion().GetIndex(0) );
+    WordType &          word = this->GetLineWords( this->ComputeLineId(index) )[position / PixelsPerWord];
+    const WordType      bit = WordType(1) << ( position % PixelsPerWord );
+    word = value ? ( word | bit ) : ( word & ~bit );
+  }
+
+  /** Number of lines in the buffered region. */
+  SizeValueType GetNumberOfLines() const
+  {
+    return m_NumberOfLines;
+  }
+
+  /** Number of words of each line of the buffered region. */
+  SizeValueType GetWordsPerLine() const
+  {
+    return m_WordsPerLine;
+  }
+
+  /** Position of the line of an index in the buffered region. */
+  SizeValueType ComputeLineId(const IndexType & index) const
+  {
+    return static_cast< SizeValueType >( this->ComputeOffset(index) )
+           / this->GetBufferedRegion().GetSize(0);
+  }
+
+  /** Access to the words of a line. */
+  WordType * GetLineWords(SizeValueType lineId)
+  {
+    return m_Buffer->GetBufferPointer() + lineId * m_WordsPerLine;
+  }
+  const WordType * GetLineWords(SizeValueType lineId) const
+  {
+    return m_Buffer->GetBufferPointer() + lineId * m_WordsPerLine;
+  }
+
+  /** Number of pixels set to true in the buffered region. */
+  SizeValueType GetNumberOfForegroundPixels() const;
+
+  /** Return a pointer to the container of the words. */
+  BufferType * GetBuffer()
+  {
+    return m_Buffer.GetPointer();
+  }
+  const BufferType * GetBuffer() const
+  {
+    return m_Buffer.GetPointer();
+  }
+
+  /** Graft the data and information from one image to another.  The
+   * words are shared by both images. */
+  virtual void Graft(const Self *data);
+
+  /** The PixelsPerWord bits of a line of numberOfWords words from the
+   * bit position, which may be negative.  The bits out of the line are
+   * zero. */
+  static WordType ReadWord(const WordType *line, SizeValueType numberOfWords, OffsetValueType bitPosition)
+  {
+    if ( bitPosition < 0 )
+      {
+      const OffsetValueType shift = -bitPosition;
+      return ( shift < static_cast< OffsetValueType >( PixelsPerWord ) && numberOfWords > 0 ) ? line[0] << shift : 0;
+      }
+    const SizeValueType q = static_cast< SizeValueType >( bitPosition ) / PixelsPerWord;
+    const unsigned int  s = static_cast< unsigned int >( bitPosition % PixelsPerWord );
+    if ( q >= numberOfWords )
+      {
+      return 0;
+      }
+    if ( s == 0 )
+      {
+      return line[q];
+      }
+    WordType word = line[q] >> s;
+    if ( q + 1 < numberOfWords )
+      {
+      word |= line[q + 1] << ( PixelsPerWord - s );
+      }
+    return word;
+  }
+
+  /** The mask of the bits of the last word of a line of lineLength
+   * pixels which are in the line. */
+  static WordType LastWordMask(SizeValueType lineLength)
+  {
+    const unsigned int remainder = static_cast< unsigned int >( lineLength % PixelsPerWord );
+    return remainder == 0 ? ~WordType(0) : ( WordType(1) << remainder ) - 1;
+  }
+
+  /** The number of bits set in a word. */
+  static unsigned int CountBits(WordType word)
+  {
+    word = word - ( ( word >> 1 ) & 0x5555555555555555ULL );
+    word = ( word & 0x3333333333333333ULL ) + ( ( word >> 2 ) & 0x3333333333333333ULL );
+    word = ( word + ( word >> 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast< unsigned int >( ( word * 0x0101010101010101ULL ) >> 56 );
+  }
+
+protected:
+  BinaryPackedImage();
+  ~BinaryPackedImage() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  virtual void Graft(const DataObject *data) ITK_OVERRIDE;
+  using Superclass::Graft;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryPackedImage);
+
+  BufferPointer m_Buffer;
+  SizeValueType m_WordsPerLine;
+  SizeValueType m_NumberOfLines;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryPackedImage.hxx"
+#endif
+
+#endif
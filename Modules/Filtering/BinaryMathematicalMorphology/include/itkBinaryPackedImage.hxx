@@ -0,0 +1,148 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedImage_hxx
+#define itkBinaryPackedImage_hxx
+
+#include "itkBinaryPackedImage.h"
+#include <algorithm>
+
+namespace itk
+{
+template< unsigned int VImageDimension >
+BinaryPackedImage< VImageDimension >
+::BinaryPackedImage():
+  m_WordsPerLine(0),
+  m_NumberOfLines(0)
+{
+  m_Buffer = BufferType::New();
+}
+
+template< unsigned int VImageDimension >
+void
+BinaryPackedImage< VImageDimension >
+::Initialize()
+{
+  // Call the superclass which should initialize the BufferedRegion ivar.
+  Superclass::Initialize();
+
+  // Replace the words by a new container, the old one may be shared by
+  // a grafted image.
+  m_Buffer = BufferType::New();
+  m_WordsPerLine = 0;
+  m_NumberOfLines = 0;
+}
+
+template< unsigned int VImageDimension >
+void
+BinaryPackedImage< VImageDimension >
+::Allocate(bool)
+{
+  const RegionType & region = this->GetBufferedRegion();
+  this->ComputeOffsetTable();
+
+  m_WordsPerLine = ( region.GetSize(0) + PixelsPerWord - 1 ) / PixelsPerWord;
+  m_NumberOfLines = region.GetSize(0) > 0 ? region.GetNumberOfPixels() / region.GetSize(0) : 0;
+  m_Buffer->Reserve(m_WordsPerLine * m_NumberOfLines);
+  this->FillBuffer(false);
+}
+
+template< unsigned int VImageDimension >
+void
+BinaryPackedImage< VImageDimension >
+::FillBuffer(bool value)
+{
+  WordType *     words = m_Buffer->GetBufferPointer();
+  const WordType lastWord = value ? LastWordMask( this->GetBufferedRegion().GetSize(0) ) : WordType(0);
+  for ( SizeValueType lineId = 0; lineId < m_NumberOfLines; ++lineId )
+    {
+    WordType *line = words + lineId * m_WordsPerLine;
+    std::fill( line, line + m_WordsPerLine - 1, value ? ~WordType(0) : WordType(0) );
+    line[m_WordsPerLine - 1] = lastWord;
+    }
+}
+
+template< unsigned int VImageDimension >
+typename BinaryPackedImage< VImageDimension >::SizeValueType
+BinaryPackedImage< VImageDimension >
+::GetNumberOfForegroundPixels() const
+{
+  // the bits after the end of the lines are zero
+  SizeValueType    numberOfForegroundPixels = 0;
+  const WordType * words = m_Buffer->GetBufferPointer();
+  const SizeValueType numberOfWords = m_WordsPerLine * m_NumberOfLines;
+  for ( SizeValueType i = 0; i < numberOfWords; ++i )
+    {
+    numberOfForegroundPixels += CountBits(words[i]);
+    }
+  return numberOfForegroundPixels;
+}
+
+template< unsigned int VImageDimension >
+void
+BinaryPackedImage< VImageDimension >
+::Graft(const Self *imgData)
+{
+  if ( imgData == ITK_NULLPTR )
+    {
+    return; // nothing to do
+    }
+  // call the superclass' implementation
+  Superclass::Graft(imgData);
+
+  // share the words
+  m_Buffer = const_cast< BufferType * >( imgData->GetBuffer() );
+  m_WordsPerLine = imgData->GetWordsPerLine();
+  m_NumberOfLines = imgData->GetNumberOfLines();
+}
+
+template< unsigned int VImageDimension >
+void
+BinaryPackedImage< VImageDimension >
+::Graft(const DataObject *data)
+{
+  if ( data == ITK_NULLPTR )
+    {
+    return; // nothing to do
+    }
+
+  // Attempt to cast data to a BinaryPackedImage
+  const Self *imgData = dynamic_cast< const Self * >( data );
+
+  if ( imgData == ITK_NULLPTR )
+    {
+    // pointer could not be cast back down
+    itkExceptionMacro( << "itk::BinaryPackedImage::Graft() cannot cast "
+                       << typeid( data ).name() << " to "
+                       << typeid( const Self * ).name() );
+    }
+  this->Graft(imgData);
+}
+
+template< unsigned int VImageDimension >
+void
+BinaryPackedImage< VImageDimension >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfLines: " << m_NumberOfLines << std::endl;
+  os << indent << "WordsPerLine: " << m_WordsPerLine << std::endl;
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,141 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedImageRegionConstIterator_h
+#define itkBinaryPackedImageRegionConstIterator_h
+
+#include "itkBinaryPackedImage.h"
+
+namespace itk
+{
+/** \class BinaryPackedImageRegionConstIterator
+ * \brief A read-only iterator over the pixels of a region of a
+ * BinaryPackedImage.
+ *
+ * BinaryPackedImageRegionConstIterator visits the pixels of a region in
+ * the same order as ImageRegionConstIterator: the first dimension is the
+ * fastest.  The iterator keeps the word and the bit of the current
+ * pixel, so the pixels are visited in constant time.
+ *
+ * \sa BinaryPackedImage, BinaryPackedImageRegionIterator,
+ * ImageRegionConstIterator
+ * \ingroup ImageIterators
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TImage >
+class ITK_TEMPLATE_EXPORT BinaryPackedImageRegionConstIterator
+{
+public:
+  /** Standard class typedefs. */
+  typedef BinaryPackedImageRegionConstIterator Self;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TImage::ImageDimension);
+
+  typedef TImage                             ImageType;
+  typedef typename ImageType::PixelType      PixelType;
+  typedef typename ImageType::IndexType      IndexType;
+  typedef typename ImageType::IndexValueType IndexValueType;
+  typedef typename ImageType::SizeType       SizeType;
+  typedef typename ImageType::SizeValueType  SizeValueType;
+  typedef typename ImageType::RegionType     RegionType;
+  typedef typename ImageType::WordType       WordType;
+
+  /** Default constructor.  The iterator is at end until it is assigned. */
+  BinaryPackedImageRegionConstIterator();
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image.  The region must be in the buffered
+   * region of the image. */
+  BinaryPackedImageRegionConstIterator(const ImageType *image, const RegionType & region);
+
+  /** Move the iterator to the first pixel of the region. */
+  void GoToBegin();
+
+  /** Is the iterator past the last pixel of the region? */
+  bool IsAtEnd() const
+  {
+    return m_IsAtEnd;
+  }
+
+  /** Move to the next pixel. */
+  Self & operator++()
+  {
+    ++m_Index[0];
+    m_Bit <<= 1;
+    if ( m_Index[0] == m_LineEnd )
+      {
+      this->NextLine();
+      }
+    else if ( m_Bit == 0 )
+      {
+      ++m_Word;
+      m_Bit = 1;
+      }
+    return *this;
+  }
+
+  /** Value of the current pixel. */
+  PixelType Get() const
+  {
+    return ( *m_Word & m_Bit ) != 0;
+  }
+  PixelType Value() const
+  {
+    return ( *m_Word & m_Bit ) != 0;
+  }
+
+  /** Index of the current pixel. */
+  const IndexType & GetIndex() const
+  {
+    return m_Index;
+  }
+
+  /** The region iterated over. */
+  const RegionType & GetRegion() const
+  {
+    return m_Region;
+  }
+
+  /** The image iterated over. */
+  const ImageType * GetImage() const
+  {
+    return m_Image;
+  }
+
+protected:
+  /** Move to the beginning of the next line of the region. */
+  void NextLine();
+
+  /** Find the word and the bit of the current pixel. */
+  void SetLine();
+
+  const ImageType *m_Image;
+  RegionType       m_Region;
+  IndexType        m_Index;
+  IndexType        m_EndIndex;
+  IndexValueType   m_LineEnd;
+  WordType *       m_Word;
+  WordType         m_Bit;
+  bool             m_IsAtEnd;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryPackedImageRegionConstIterator.hxx"
+#endif
+
+#endif
@@ -0,0 +1,70 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedImageRegionIterator_h
+#define itkBinaryPackedImageRegionIterator_h
+
+#include "itkBinaryPackedImageRegionConstIterator.h"
+
+namespace itk
+{
+/** \class BinaryPackedImageRegionIterator
+ * \brief An iterator over the pixels of a region of a BinaryPackedImage,
+ * which can set the pixels.
+ *
+ * \sa BinaryPackedImage, BinaryPackedImageRegionConstIterator,
+ * ImageRegionIterator
+ * \ingroup ImageIterators
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TImage >
+class ITK_TEMPLATE_EXPORT BinaryPackedImageRegionIterator:
+  public BinaryPackedImageRegionConstIterator< TImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef BinaryPackedImageRegionIterator                Self;
+  typedef BinaryPackedImageRegionConstIterator< TImage > Superclass;
+
+  typedef typename Superclass::ImageType  ImageType;
+  typedef typename Superclass::PixelType  PixelType;
+  typedef typename Superclass::RegionType RegionType;
+
+  /** Default constructor.  The iterator is at end until it is assigned. */
+  BinaryPackedImageRegionIterator() {}
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image.  The region must be in the buffered
+   * region of the image. */
+  BinaryPackedImageRegionIterator(ImageType *image, const RegionType & region):
+    Superclass(image, region) {}
+
+  /** Set the value of the current pixel. */
+  void Set(PixelType value) const
+  {
+    *this->m_Word = value ? ( *this->m_Word | this->m_Bit ) : ( *this->m_Word & ~this->m_Bit );
+  }
+
+  /** The image iterated over. */
+  ImageType * GetImage() const
+  {
+    return const_cast< ImageType * >( this->m_Image );
+  }
+};
+} // end namespace itk
+
+#endif
@@ -0,0 +1,116 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedImageToImageFilter_h
+#define itkBinaryPackedImageToImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkBinaryPackedImage.h"
+
+namespace itk
+{
+/** \class BinaryPackedImageToImageFilter
+ * \brief Decode a BinaryPackedImage into an image.
+ *
+ * The pixels set to true get the foreground value, which defaults to the
+ * maximum of the pixel type, and the other ones get the background
+ * value, which defaults to zero.
+ *
+ * BinaryPackedImageToImageFilter only decodes the requested region of
+ * its output, so it can be streamed.  Writing a BinaryPackedImage with
+ * an ImageFileWriter divided in several pieces only stores one piece of
+ * the image densely in memory at a time:
+ *
+ * \code
+ * decoder->SetInput( packedImage );
+ * writer->SetInput( decoder->GetOutput() );
+ * writer->SetNumberOfStreamDivisions( 20 );
+ * writer->Update();
+ * \endcode
+ *
+ * \sa BinaryPackedImage, ImageToBinaryPackedImageFilter
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TInputImage, typename TOutputImage =
+            Image< unsigned char, TInputImage::ImageDimension > >
+class ITK_TEMPLATE_EXPORT BinaryPackedImageToImageFilter:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef BinaryPackedImageToImageFilter                  Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(BinaryPackedImageToImageFilter, ImageToImageFilter);
+
+  /** Some typedefs for the input and output. */
+  typedef TInputImage                         InputImageType;
+  typedef typename InputImageType::RegionType InputImageRegionType;
+  typedef typename InputImageType::WordType   WordType;
+
+  typedef TOutputImage                         OutputImageType;
+  typedef typename OutputImageType::RegionType OutputImageRegionType;
+  typedef typename OutputImageType::PixelType  OutputImagePixelType;
+
+  /** Dimension of input image. */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      InputImageType::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      OutputImageType::ImageDimension);
+
+  /** Set/Get the value of the pixels set to true. */
+  itkSetMacro(ForegroundValue, OutputImagePixelType);
+  itkGetConstMacro(ForegroundValue, OutputImagePixelType);
+
+  /** Set/Get the value of the pixels set to false. */
+  itkSetMacro(BackgroundValue, OutputImagePixelType);
+  itkGetConstMacro(BackgroundValue, OutputImagePixelType);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  // Begin concept checking
+  itkConceptMacro( SameDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, OutputImageDimension > ) );
+  // End concept checking
+#endif
+
+protected:
+  BinaryPackedImageToImageFilter();
+  ~BinaryPackedImageToImageFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  virtual void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                    ThreadIdType threadId) ITK_OVERRIDE;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryPackedImageToImageFilter);
+
+  OutputImagePixelType m_ForegroundValue;
+  OutputImagePixelType m_BackgroundValue;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryPackedImageToImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedImageToImageFilter_hxx
+#define itkBinaryPackedImageToImageFilter_hxx
+
+#include "itkBinaryPackedImageToImageFilter.h"
+#include "itkImageScanlineIterator.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+BinaryPackedImageToImageFilter< TInputImage, TOutputImage >
+::BinaryPackedImageToImageFilter():
+  m_ForegroundValue( NumericTraits< OutputImagePixelType >::max() ),
+  m_BackgroundValue( NumericTraits< OutputImagePixelType >::ZeroValue() )
+{
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryPackedImageToImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId)
+{
+  const InputImageType *input = this->GetInput();
+  OutputImageType *     output = this->GetOutput();
+
+  const SizeValueType lineLength = outputRegionForThread.GetSize(0);
+  if ( lineLength == 0 )
+    {
+    return;
+    }
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() / lineLength );
+
+  const SizeValueType numberOfWords = input->GetWordsPerLine();
+  const OffsetValueType lineStart =
+    outputRegionForThread.GetIndex(0) - input->GetBufferedRegion().GetIndex(0);
+
+  ImageScanlineIterator< OutputImageType > it(output, outputRegionForThread);
+  while ( !it.IsAtEnd() )
+    {
+    const WordType *words = input->GetLineWords( input->ComputeLineId( it.GetIndex() ) );
+    for ( SizeValueType position = 0; position < lineLength; position += InputImageType::PixelsPerWord )
+      {
+      WordType word = InputImageType::ReadWord( words, numberOfWords,
+                                                lineStart + static_cast< OffsetValueType >( position ) );
+      const SizeValueType end = std::min( lineLength, position + InputImageType::PixelsPerWord );
+      for ( SizeValueType x = position; x < end; ++x, word >>= 1 )
+        {
+        it.Set( ( word & 1 ) ? m_ForegroundValue : m_BackgroundValue );
+        ++it;
+        }
+      }
+    it.NextLine();
+    progress.CompletedPixel();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryPackedImageToImageFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "ForegroundValue: "
+     << static_cast< typename NumericTraits< OutputImagePixelType >::PrintType >( m_ForegroundValue ) << std::endl;
+  os << indent << "BackgroundValue: "
+     << static_cast< typename NumericTraits< OutputImagePixelType >::PrintType >( m_BackgroundValue ) << std::endl;
+}
+} // end namespace itk
+
+#endif
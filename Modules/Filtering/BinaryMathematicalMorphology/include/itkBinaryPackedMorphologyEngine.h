@@ -0,0 +1,86 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedMorphologyEngine_h
+#define itkBinaryPackedMorphologyEngine_h
+
+#include "itkBinaryPackedImage.h"
+#include <vector>
+
+namespace itk
+{
+/**
+ * \class BinaryPackedMorphologyEngine
+ * \brief Word level dilation of binary images packed 64 pixels per word
+ * along the first dimension.
+ *
+ * The pixels of a region are stored line after line, in the order of the
+ * region, each line starting on a new word, like in BinaryPackedImage.
+ * The dilation by a window of consecutive pixels along any dimension is
+ * computed on whole words, in a number of steps which is logarithmic in
+ * the length of the window: the window of twice the length is the union
+ * of a window and of its translation.  The dilation by a structuring
+ * element is the union of translated dilations by windows.
+ *
+ * BinaryPackedMorphologyImageFilter dilates by the lines of boxes and
+ * crosses, and BinaryMorphologyImageFilter by the chords of its kernel.
+ *
+ * \sa BinaryPackedImage, BinaryPackedMorphologyImageFilter,
+ * BinaryMorphologyImageFilter, StructuringElementChord
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< unsigned int VDimension >
+class BinaryPackedMorphologyEngine
+{
+public:
+  typedef BinaryPackedImage< VDimension >  PackedImageType;
+  typedef typename PackedImageType::WordType WordType;
+  typedef ImageRegion< VDimension >        RegionType;
+  typedef Offset< VDimension >             OffsetType;
+  typedef std::vector< WordType >          WordVectorType;
+
+  itkStaticConstMacro(PixelsPerWord, unsigned int, PackedImageType::PixelsPerWord);
+
+  /** The number of words of each line of the region. */
+  static SizeValueType LineWords(const RegionType & region)
+  {
+    return ( region.GetSize(0) + PixelsPerWord - 1 ) / PixelsPerWord;
+  }
+
+  /** Replace the lines of the buffer by their dilation by a line of the
+   * length along the dimension, translated so that the window starts at
+   * each pixel.  The dilation is only valid for the pixels whose window
+   * is in the buffer. */
+  static void DilateByLine(WordVectorType & buffer, const RegionType & region,
+                           SizeValueType lineWords, unsigned int dimension, SizeValueType length);
+
+  /** Add the lines of the buffer of the region, translated by minus the
+   * shift, to the lines of the output region in the target. */
+  static void AccumulateLines(const WordVectorType & buffer, const RegionType & region, SizeValueType lineWords,
+                              const RegionType & outputRegion, const OffsetType & shift, WordVectorType & target);
+
+  /** The mask of the bits of a word, starting at the position first, in
+   * the range [begin, end). */
+  static WordType RangeMask(OffsetValueType first, OffsetValueType begin, OffsetValueType end);
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryPackedMorphologyEngine.hxx"
+#endif
+
+#endif
@@ -0,0 +1,124 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedMorphologyEngine_hxx
+#define itkBinaryPackedMorphologyEngine_hxx
+
+#include "itkBinaryPackedMorphologyEngine.h"
+#include <algorithm>
+
+namespace itk
+{
+template< unsigned int VDimension >
+typename BinaryPackedMorphologyEngine< VDimension >::WordType
+BinaryPackedMorphologyEngine< VDimension >
+::RangeMask(OffsetValueType first, OffsetValueType begin, OffsetValueType end)
+{
+  const OffsetValueType wordBits = PixelsPerWord;
+  const OffsetValueType b = std::max( begin - first, OffsetValueType(0) );
+  const OffsetValueType e = std::min( end - first, wordBits );
+  if ( b >= e )
+    {
+    return 0;
+    }
+  const WordType upper = ( e == wordBits ) ? ~WordType(0) : ( WordType(1) << e ) - 1;
+  return upper & ~( ( WordType(1) << b ) - 1 );
+}
+
+template< unsigned int VDimension >
+void
+BinaryPackedMorphologyEngine< VDimension >
+::DilateByLine(WordVectorType & buffer, const RegionType & region,
+               SizeValueType lineWords, unsigned int dimension, SizeValueType length)
+{
+  const SizeValueType numberOfLines = region.GetNumberOfPixels() / region.GetSize(0);
+  const SizeValueType size = region.GetSize(dimension);
+  SizeValueType       stride = 1;
+  for ( unsigned int d = 1; d < dimension; ++d )
+    {
+    stride *= region.GetSize(d);
+    }
+
+  // the union of the window and of its translation is a window up to
+  // twice longer. The lines are updated in increasing order, so the
+  // translated window is read before being updated.
+  for ( SizeValueType done = 1; done < length; )
+    {
+    const SizeValueType shift = std::min( done, length - done );
+    for ( SizeValueType line = 0; line < numberOfLines; ++line )
+      {
+      WordType *words = &buffer[line * lineWords];
+      if ( dimension == 0 )
+        {
+        for ( SizeValueType k = 0; k < lineWords; ++k )
+          {
+          words[k] |= PackedImageType::ReadWord( words, lineWords,
+                                                 static_cast< OffsetValueType >( k * PixelsPerWord + shift ) );
+          }
+        }
+      else if ( ( line / stride ) % size + shift < size )
+        {
+        const WordType *next = words + shift * stride * lineWords;
+        for ( SizeValueType k = 0; k < lineWords; ++k )
+          {
+          words[k] |= next[k];
+          }
+        }
+      }
+    done += shift;
+    }
+}
+
+template< unsigned int VDimension >
+void
+BinaryPackedMorphologyEngine< VDimension >
+::AccumulateLines(const WordVectorType & buffer, const RegionType & region, SizeValueType lineWords,
+                  const RegionType & outputRegion, const OffsetType & shift, WordVectorType & target)
+{
+  const SizeValueType numberOfLines = outputRegion.GetNumberOfPixels() / outputRegion.GetSize(0);
+  const SizeValueType targetLineWords = target.size() / numberOfLines;
+
+  // the position in the buffer of the first pixel of the output region
+  OffsetType start;
+  for ( unsigned int d = 0; d < VDimension; ++d )
+    {
+    start[d] = outputRegion.GetIndex(d) - region.GetIndex(d) - shift[d];
+    }
+
+  for ( SizeValueType line = 0; line < numberOfLines; ++line )
+    {
+    SizeValueType remainder = line;
+    SizeValueType bufferLine = 0;
+    SizeValueType stride = 1;
+    for ( unsigned int d = 1; d < VDimension; ++d )
+      {
+      bufferLine += ( remainder % outputRegion.GetSize(d) + start[d] ) * stride;
+      remainder /= outputRegion.GetSize(d);
+      stride *= region.GetSize(d);
+      }
+    const WordType *words = &buffer[bufferLine * lineWords];
+    WordType *      targetWords = &target[line * targetLineWords];
+    for ( SizeValueType k = 0; k < targetLineWords; ++k )
+      {
+      targetWords[k] |= PackedImageType::ReadWord( words, lineWords,
+                                                   start[0] + static_cast< OffsetValueType >( k * PixelsPerWord ) );
+      }
+    }
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,125 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedMorphologyImageFilter_h
+#define itkBinaryPackedMorphologyImageFilter_h
+
+#include "itkBoxImageFilter.h"
+#include "itkImageRegionSplitterDirection.h"
+#include "itkBinaryPackedImage.h"
+#include "itkBinaryPackedMorphologyEngine.h"
+#include <vector>
+
+namespace itk
+{
+/**
+ * \class BinaryPackedMorphologyImageFilter
+ * \brief Base class for the dilation and the erosion of BinaryPackedImages
+ * by boxes and crosses.
+ *
+ * The box is the product of lines of 2 * radius + 1 pixels along each
+ * dimension, and the cross is their union.  The dilation by a line is
+ * computed on whole words of 64 pixels by BinaryPackedMorphologyEngine,
+ * in a number of steps which is logarithmic in the length of the line.
+ * The box is processed one dimension after the other, and the cross is
+ * the union of the dilations by its lines.  The erosion is the
+ * complement of the dilation of the complement.
+ *
+ * The pixels outside the image are foreground when BoundaryToForeground
+ * is true.  It defaults to false for the dilation and to true for the
+ * erosion, like in BinaryDilateImageFilter and BinaryErodeImageFilter.
+ *
+ * The lines of the output are not split between the threads, so that a
+ * word is only written by one thread.
+ *
+ * \sa BinaryPackedImage, BinaryPackedDilateImageFilter,
+ * BinaryPackedErodeImageFilter, BinaryMorphologyImageFilter
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TImage >
+class ITK_TEMPLATE_EXPORT BinaryPackedMorphologyImageFilter:
+  public BoxImageFilter< TImage, TImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef BinaryPackedMorphologyImageFilter Self;
+  typedef BoxImageFilter< TImage, TImage >  Superclass;
+  typedef SmartPointer< Self >              Pointer;
+  typedef SmartPointer< const Self >        ConstPointer;
+
+  /** Runtime information support. */
+  itkTypeMacro(BinaryPackedMorphologyImageFilter, BoxImageFilter);
+
+  /** Image related typedefs. */
+  typedef TImage                          ImageType;
+  typedef typename ImageType::RegionType  RegionType;
+  typedef typename ImageType::IndexType   IndexType;
+  typedef typename ImageType::OffsetType  OffsetType;
+  typedef typename ImageType::WordType    WordType;
+  typedef RegionType                      OutputImageRegionType;
+  typedef typename Superclass::RadiusType RadiusType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  /** The shapes of structuring element. */
+  enum KernelShapeType {
+    BOX = 0,
+    CROSS = 1
+    };
+
+  /** Set/Get the shape of the structuring element.  Defaults to BOX. */
+  itkSetMacro(KernelShape, int);
+  itkGetConstMacro(KernelShape, int);
+
+  /** Set/Get whether the pixels outside the image are foreground. */
+  itkSetMacro(BoundaryToForeground, bool);
+  itkGetConstMacro(BoundaryToForeground, bool);
+  itkBooleanMacro(BoundaryToForeground);
+
+protected:
+  BinaryPackedMorphologyImageFilter();
+  ~BinaryPackedMorphologyImageFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  /** Dilate the region of the output, or erode it, which is the
+   * complement of the dilation of the complement. */
+  void ThreadedPackedMorphology(const OutputImageRegionType & outputRegionForThread,
+                                ThreadIdType threadId, bool erosion);
+
+  /** The lines are not split between the threads. */
+  virtual const ImageRegionSplitterBase * GetImageRegionSplitter() const ITK_OVERRIDE;
+
+  bool m_BoundaryToForeground;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryPackedMorphologyImageFilter);
+
+  typedef BinaryPackedMorphologyEngine< ImageDimension > EngineType;
+  typedef typename EngineType::WordVectorType            WordVectorType;
+
+  int m_KernelShape;
+
+  ImageRegionSplitterDirection::Pointer m_ImageRegionSplitter;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryPackedMorphologyImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedMorphologyImageFilter_hxx
+#define itkBinaryPackedMorphologyImageFilter_hxx
+
+#include "itkBinaryPackedMorphologyImageFilter.h"
+#include "itkBinaryPackedMorphologyEngine.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+
+namespace itk
+{
+template< typename TImage >
+BinaryPackedMorphologyImageFilter< TImage >
+::BinaryPackedMorphologyImageFilter():
+  m_BoundaryToForeground(false),
+  m_KernelShape(BOX)
+{
+  m_ImageRegionSplitter = ImageRegionSplitterDirection::New();
+  m_ImageRegionSplitter->SetDirection(0);
+}
+
+template< typename TImage >
+const ImageRegionSplitterBase *
+BinaryPackedMorphologyImageFilter< TImage >
+::GetImageRegionSplitter() const
+{
+  return m_ImageRegionSplitter;
+}
+
+template< typename TImage >
+void
+BinaryPackedMorphologyImageFilter< TImage >
+::ThreadedPackedMorphology(const OutputImageRegionType & outputRegionForThread,
+                           ThreadIdType threadId, bool erosion)
+{
+  const ImageType *input = this->GetInput();
+  ImageType *      output = this->GetOutput();
+
+  const SizeValueType lineLength = outputRegionForThread.GetSize(0);
+  if ( lineLength == 0 )
+    {
+    return;
+    }
+
+  const RadiusType & radius = this->GetRadius();
+  ProgressReporter   progress(this, threadId, ImageDimension + 2);
+
+  // copy the region padded by the radius, complemented for the erosion,
+  // with the boundary out of the input
+  RegionType paddedRegion = outputRegionForThread;
+  paddedRegion.PadByRadius(radius);
+  const SizeValueType paddedLineWords = EngineType::LineWords(paddedRegion);
+  const SizeValueType numberOfPaddedLines = paddedRegion.GetNumberOfPixels() / paddedRegion.GetSize(0);
+
+  const WordType       outsideWord = ( m_BoundaryToForeground != erosion ) ? ~WordType(0) : WordType(0);
+  const RegionType &   inputRegion = input->GetBufferedRegion();
+  const OffsetValueType inputLineStart = paddedRegion.GetIndex(0) - inputRegion.GetIndex(0);
+  const OffsetValueType begin = std::max( -inputLineStart, OffsetValueType(0) );
+  const OffsetValueType end = std::min( static_cast< OffsetValueType >( inputRegion.GetSize(0) ) - inputLineStart,
+                                        static_cast< OffsetValueType >( paddedRegion.GetSize(0) ) );
+
+  WordVectorType original(numberOfPaddedLines * paddedLineWords, outsideWord);
+  IndexType      index = inputRegion.GetIndex();
+  for ( SizeValueType line = 0; line < numberOfPaddedLines && begin < end; ++line )
+    {
+    SizeValueType remainder = line;
+    bool          isInside = true;
+    for ( unsigned int d = 1; d < ImageDimension; ++d )
+      {
+      index[d] = paddedRegion.GetIndex(d) + static_cast< IndexValueType >( remainder % paddedRegion.GetSize(d) );
+      remainder /= paddedRegion.GetSize(d);
+      isInside = isInside && index[d] >= inputRegion.GetIndex(d)
+                 && index[d] < inputRegion.GetIndex(d) + static_cast< IndexValueType >( inputRegion.GetSize(d) );
+      }
+    if ( !isInside )
+      {
+      continue;
+      }
+    const WordType *inputWords = input->GetLineWords( input->ComputeLineId(index) );
+    WordType *      words = &original[line * paddedLineWords];
+    for ( SizeValueType k = 0; k < paddedLineWords; ++k )
+      {
+      const OffsetValueType first = static_cast< OffsetValueType >( k * ImageType::PixelsPerWord );
+      WordType              value = ImageType::ReadWord(inputWords, input->GetWordsPerLine(), inputLineStart + first);
+      if ( erosion )
+        {
+        value = ~value;
+        }
+      const WordType mask = EngineType::RangeMask(first, begin, end);
+      words[k] = ( value & mask ) | ( outsideWord & ~mask );
+      }
+    }
+  progress.CompletedPixel();
+
+  // the union of the dilations by the lines of the cross, or the
+  // dilation by the box computed one dimension after the other
+  const SizeValueType numberOfLines = outputRegionForThread.GetNumberOfPixels() / lineLength;
+  const SizeValueType lineWords = EngineType::LineWords(outputRegionForThread);
+  WordVectorType      dilated(numberOfLines * lineWords, 0);
+  OffsetType          shift;
+  shift.Fill(0);
+  if ( m_KernelShape == CROSS )
+    {
+    WordVectorType work;
+    bool           isDilated = false;
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      if ( radius[d] > 0 )
+        {
+        work = original;
+        EngineType::DilateByLine(work, paddedRegion, paddedLineWords, d, 2 * radius[d] + 1);
+        shift[d] = static_cast< OffsetValueType >( radius[d] );
+        EngineType::AccumulateLines(work, paddedRegion, paddedLineWords, outputRegionForThread, shift, dilated);
+        shift[d] = 0;
+        isDilated = true;
+        }
+      progress.CompletedPixel();
+      }
+    if ( !isDilated )
+      {
+      // the cross is reduced to its center
+      EngineType::AccumulateLines(original, paddedRegion, paddedLineWords, outputRegionForThread, shift, dilated);
+      }
+    }
+  else
+    {
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      if ( radius[d] > 0 )
+        {
+        EngineType::DilateByLine(original, paddedRegion, paddedLineWords, d, 2 * radius[d] + 1);
+        shift[d] = static_cast< OffsetValueType >( radius[d] );
+        }
+      progress.CompletedPixel();
+      }
+    EngineType::AccumulateLines(original, paddedRegion, paddedLineWords, outputRegionForThread, shift, dilated);
+    }
+
+  // the lines of the output region are whole lines of the output buffer
+  const WordType lastWordMask = ImageType::LastWordMask(lineLength);
+  index = outputRegionForThread.GetIndex();
+  for ( SizeValueType line = 0; line < numberOfLines; ++line )
+    {
+    SizeValueType remainder = line;
+    for ( unsigned int d = 1; d < ImageDimension; ++d )
+      {
+      index[d] = outputRegionForThread.GetIndex(d)
+                 + static_cast< IndexValueType >( remainder % outputRegionForThread.GetSize(d) );
+      remainder /= outputRegionForThread.GetSize(d);
+      }
+    WordType *      words = output->GetLineWords( output->ComputeLineId(index) );
+    const WordType *source = &dilated[line * lineWords];
+    for ( SizeValueType k = 0; k < lineWords; ++k )
+      {
+      words[k] = erosion ? ~source[k] : source[k];
+      }
+    words[lineWords - 1] &= lastWordMask;
+    }
+  progress.CompletedPixel();
+}
+
+template< typename TImage >
+void
+BinaryPackedMorphologyImageFilter< TImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "KernelShape: " << ( m_KernelShape == CROSS ? "CROSS" : "BOX" ) << std::endl;
+  os << indent << "BoundaryToForeground: " << m_BoundaryToForeground << std::endl;
+}
+} // end namespace itk
+
+#endif
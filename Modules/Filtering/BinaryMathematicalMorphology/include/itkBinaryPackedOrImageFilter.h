@@ -0,0 +1,89 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedOrImageFilter_h
+#define itkBinaryPackedOrImageFilter_h
+
+#include "itkBinaryPackedFunctorImageFilter.h"
+
+namespace itk
+{
+namespace Functor
+{
+/** \class BinaryPackedOR
+ * \brief Bitwise or of the words of two BinaryPackedImages.
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TWord >
+class BinaryPackedOR
+{
+public:
+  bool operator!=(const BinaryPackedOR &) const
+  {
+    return false;
+  }
+
+  bool operator==(const BinaryPackedOR & other) const
+  {
+    return !( *this != other );
+  }
+
+  inline TWord operator()(const TWord & A, const TWord & B) const
+  {
+    return A | B;
+  }
+};
+} // end namespace Functor
+
+/** \class BinaryPackedOrImageFilter
+ * \brief Compute the logical or of two BinaryPackedImages, 64 pixels
+ * at a time.
+ *
+ * \sa BinaryPackedImage, BinaryPackedFunctorImageFilter,
+ * BinaryPackedAndImageFilter, BinaryPackedXorImageFilter, OrImageFilter
+ * \ingroup MultiThreaded
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TImage >
+class BinaryPackedOrImageFilter:
+  public BinaryPackedFunctorImageFilter< TImage, Functor::BinaryPackedOR< typename TImage::WordType > >
+{
+public:
+  /** Standard class typedefs. */
+  typedef BinaryPackedOrImageFilter Self;
+  typedef BinaryPackedFunctorImageFilter< TImage,
+                                          Functor::BinaryPackedOR< typename TImage::WordType > > Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(BinaryPackedOrImageFilter,
+               BinaryPackedFunctorImageFilter);
+
+protected:
+  BinaryPackedOrImageFilter() {}
+  virtual ~BinaryPackedOrImageFilter() ITK_OVERRIDE {}
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryPackedOrImageFilter);
+};
+} // end namespace itk
+
+#endif
@@ -0,0 +1,89 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPackedXorImageFilter_h
+#define itkBinaryPackedXorImageFilter_h
+
+#include "itkBinaryPackedFunctorImageFilter.h"
+
+namespace itk
+{
+namespace Functor
+{
+/** \class BinaryPackedXOR
+ * \brief Bitwise exclusive or of the words of two BinaryPackedImages.
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TWord >
+class BinaryPackedXOR
+{
+public:
+  bool operator!=(const BinaryPackedXOR &) const
+  {
+    return false;
+  }
+
+  bool operator==(const BinaryPackedXOR & other) const
+  {
+    return !( *this != other );
+  }
+
+  inline TWord operator()(const TWord & A, const TWord & B) const
+  {
+    return A ^ B;
+  }
+};
+} // end namespace Functor
+
+/** \class BinaryPackedXorImageFilter
+ * \brief Compute the logical exclusive or of two BinaryPackedImages, 64 pixels
+ * at a time.
+ *
+ * \sa BinaryPackedImage, BinaryPackedFunctorImageFilter,
+ * BinaryPackedAndImageFilter, BinaryPackedOrImageFilter, XorImageFilter
+ * \ingroup MultiThreaded
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TImage >
+class BinaryPackedXorImageFilter:
+  public BinaryPackedFunctorImageFilter< TImage, Functor::BinaryPackedXOR< typename TImage::WordType > >
+{
+public:
+  /** Standard class typedefs. */
+  typedef BinaryPackedXorImageFilter Self;
+  typedef BinaryPackedFunctorImageFilter< TImage,
+                                          Functor::BinaryPackedXOR< typename TImage::WordType > > Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(BinaryPackedXorImageFilter,
+               BinaryPackedFunctorImageFilter);
+
+protected:
+  BinaryPackedXorImageFilter() {}
+  virtual ~BinaryPackedXorImageFilter() ITK_OVERRIDE {}
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryPackedXorImageFilter);
+};
+} // end namespace itk
+
+#endif
@@ -0,0 +1,116 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageToBinaryPackedImageFilter_h
+#define itkImageToBinaryPackedImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkImageRegionSplitterDirection.h"
+#include "itkBinaryPackedImage.h"
+
+namespace itk
+{
+/** \class ImageToBinaryPackedImageFilter
+ * \brief Threshold an image into a BinaryPackedImage.
+ *
+ * Like BinaryThresholdImageFilter, the pixels between the lower and the
+ * upper thresholds, included, are set to true in the output, and the
+ * other ones to false.  The thresholds default to the extreme values of
+ * the pixel type.  To pack a mask, set the lower threshold to the
+ * smallest foreground value.
+ *
+ * The lines of the output are not split between the threads, so that a
+ * word is only written by one thread.
+ *
+ * \sa BinaryPackedImage, BinaryPackedImageToImageFilter,
+ * BinaryThresholdImageFilter
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+template< typename TInputImage, typename TOutputImage = BinaryPackedImage< TInputImage::ImageDimension > >
+class ITK_TEMPLATE_EXPORT ImageToBinaryPackedImageFilter:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageToBinaryPackedImageFilter                  Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageToBinaryPackedImageFilter, ImageToImageFilter);
+
+  /** Some typedefs for the input and output. */
+  typedef TInputImage                         InputImageType;
+  typedef typename InputImageType::RegionType InputImageRegionType;
+  typedef typename InputImageType::PixelType  InputImagePixelType;
+
+  typedef TOutputImage                         OutputImageType;
+  typedef typename OutputImageType::RegionType OutputImageRegionType;
+  typedef typename OutputImageType::WordType   WordType;
+
+  /** Dimension of input image. */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      InputImageType::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      OutputImageType::ImageDimension);
+
+  /** Set/Get the thresholds.  The pixels between them, included, are
+   * set to true. */
+  itkSetMacro(LowerThreshold, InputImagePixelType);
+  itkGetConstMacro(LowerThreshold, InputImagePixelType);
+  itkSetMacro(UpperThreshold, InputImagePixelType);
+  itkGetConstMacro(UpperThreshold, InputImagePixelType);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  // Begin concept checking
+  itkConceptMacro( SameDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, OutputImageDimension > ) );
+  itkConceptMacro( InputComparableCheck,
+                   ( Concept::Comparable< InputImagePixelType > ) );
+  // End concept checking
+#endif
+
+protected:
+  ImageToBinaryPackedImageFilter();
+  ~ImageToBinaryPackedImageFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  virtual void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                    ThreadIdType threadId) ITK_OVERRIDE;
+
+  /** The lines are not split between the threads. */
+  virtual const ImageRegionSplitterBase * GetImageRegionSplitter() const ITK_OVERRIDE;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ImageToBinaryPackedImageFilter);
+
+  InputImagePixelType m_LowerThreshold;
+  InputImagePixelType m_UpperThreshold;
+
+  ImageRegionSplitterDirection::Pointer m_ImageRegionSplitter;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageToBinaryPackedImageFilter.hxx"
+#endif
+
+#endif
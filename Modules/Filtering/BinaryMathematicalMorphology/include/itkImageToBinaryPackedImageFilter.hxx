@@ -0,0 +1,107 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageToBinaryPackedImageFilter_hxx
+#define itkImageToBinaryPackedImageFilter_hxx
+
+#include "itkImageToBinaryPackedImageFilter.h"
+#include "itkImageScanlineConstIterator.h"
+#include "itkProgressReporter.h"
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+ImageToBinaryPackedImageFilter< TInputImage, TOutputImage >
+::ImageToBinaryPackedImageFilter():
+  m_LowerThreshold( NumericTraits< InputImagePixelType >::NonpositiveMin() ),
+  m_UpperThreshold( NumericTraits< InputImagePixelType >::max() )
+{
+  m_ImageRegionSplitter = ImageRegionSplitterDirection::New();
+  m_ImageRegionSplitter->SetDirection(0);
+}
+
+template< typename TInputImage, typename TOutputImage >
+const ImageRegionSplitterBase *
+ImageToBinaryPackedImageFilter< TInputImage, TOutputImage >
+::GetImageRegionSplitter() const
+{
+  return m_ImageRegionSplitter;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+ImageToBinaryPackedImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId)
+{
+  const InputImageType *input = this->GetInput();
+  OutputImageType *     output = this->GetOutput();
+
+  const SizeValueType lineLength = outputRegionForThread.GetSize(0);
+  if ( lineLength == 0 )
+    {
+    return;
+    }
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() / lineLength );
+
+  // the output lines are whole lines of the output buffer, so the words
+  // are written from the first one, without reading them
+  ImageScanlineConstIterator< InputImageType > it(input, outputRegionForThread);
+  while ( !it.IsAtEnd() )
+    {
+    WordType *    words = output->GetLineWords( output->ComputeLineId( it.GetIndex() ) );
+    WordType      word = 0;
+    unsigned int  bit = 0;
+    while ( !it.IsAtEndOfLine() )
+      {
+      const InputImagePixelType value = it.Get();
+      if ( m_LowerThreshold <= value && value <= m_UpperThreshold )
+        {
+        word |= WordType(1) << bit;
+        }
+      ++it;
+      if ( ++bit == OutputImageType::PixelsPerWord )
+        {
+        *words++ = word;
+        word = 0;
+        bit = 0;
+        }
+      }
+    if ( bit > 0 )
+      {
+      *words = word;
+      }
+    it.NextLine();
+    progress.CompletedPixel();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+ImageToBinaryPackedImageFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "LowerThreshold: "
+     << static_cast< typename NumericTraits< InputImagePixelType >::PrintType >( m_LowerThreshold ) << std::endl;
+  os << indent << "UpperThreshold: "
+     << static_cast< typename NumericTraits< InputImagePixelType >::PrintType >( m_UpperThreshold ) << std::endl;
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,236 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkGrayscaleFillholeImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkBinaryDilateImageFilter.h"
+#include "itkBinaryErodeImageFilter.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+#include <algorithm>
+#include <iterator>
+
+/**
+ * In this test, we dilate and erode random 3D images, with lines longer
+ * than a word of packed pixels, by balls and random asymmetric structuring
+ * elements. The outputs must match a naive dilation and erosion, for both
+ * boundary conditions, several numbers of threads and a requested region
+ * smaller than the image.
+ */
+namespace
+{
+
+const unsigned int Dimension = 3;
+
+typedef itk::Image< unsigned char, Dimension >   ImageType;
+typedef itk::FlatStructuringElement< Dimension > KernelType;
+
+const unsigned char Foreground = 200;
+const unsigned char Background = 3;
+
+unsigned int randomState = 13;
+
+unsigned int
+NextRandom()
+{
+  randomState = randomState * 1664525u + 1013904223u;
+  return randomState >> 8;
+}
+
+// The dilation sets the pixels within the kernel translated to a foreground
+// pixel, and the erosion keeps the pixels which are only within the kernel
+// translated to foreground pixels.
+bool
+NaiveMorphology( const ImageType *image, const KernelType & kernel, bool boundaryToForeground,
+                 bool erosion, const ImageType::IndexType & index )
+{
+  const ImageType::RegionType region = image->GetLargestPossibleRegion();
+  for ( unsigned int i = 0; i < kernel.Size(); i++ )
+    {
+    if ( !kernel[i] )
+      {
+      continue;
+      }
+    const ImageType::IndexType neighbor = index - kernel.GetOffset( i );
+    const bool isForeground = region.IsInside( neighbor ) ? image->GetPixel( neighbor ) == Foreground
+                                                          : boundaryToForeground;
+    if ( isForeground != erosion )
+      {
+      return !erosion;
+      }
+    }
+  return erosion;
+}
+
+bool
+Check( const ImageType *image, const ImageType *output, const ImageType::RegionType & region,
+       const KernelType & kernel, bool boundaryToForeground, bool erosion )
+{
+  itk::ImageRegionConstIteratorWithIndex< ImageType > It( output, region );
+  for ( ; !It.IsAtEnd(); ++It )
+    {
+    const unsigned char value = image->GetPixel( It.GetIndex() );
+    unsigned char       expected = value == Foreground ? Background : value;
+    if ( NaiveMorphology( image, kernel, boundaryToForeground, erosion, It.GetIndex() ) )
+      {
+      expected = Foreground;
+      }
+    if ( It.Get() != expected )
+      {
+      std::cerr << "Different values at " << It.GetIndex() << ": " << static_cast< int >( expected )
+                << " and " << static_cast< int >( It.Get() ) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< typename TFilter >
+bool
+RunAndCheck( const ImageType *image, const KernelType & kernel, bool boundaryToForeground,
+             itk::ThreadIdType numberOfThreads, const ImageType::RegionType & region, bool erosion )
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput( image );
+  filter->SetKernel( kernel );
+  filter->SetForegroundValue( Foreground );
+  filter->SetBackgroundValue( Background );
+  filter->SetBoundaryToForeground( boundaryToForeground );
+  filter->SetNumberOfThreads( numberOfThreads );
+  filter->GetOutput()->SetRequestedRegion( region );
+  filter->Update();
+  return Check( image, filter->GetOutput(), region, kernel, boundaryToForeground, erosion );
+}
+
+// Exposes the connected components and difference sets of the kernel,
+// which are only computed when asked for.
+class KernelAnalysisFilter:
+  public itk::BinaryDilateImageFilter< ImageType, ImageType, KernelType >
+{
+public:
+  typedef KernelAnalysisFilter                                            Self;
+  typedef itk::BinaryDilateImageFilter< ImageType, ImageType, KernelType > Superclass;
+  typedef itk::SmartPointer< Self >                                       Pointer;
+  itkNewMacro(Self);
+
+  size_t GetNumberOfKernelComponents()
+  {
+    return static_cast< size_t >( std::distance( this->KernelCCVectorBegin(), this->KernelCCVectorEnd() ) );
+  }
+
+  size_t GetCenterDifferenceSetSize()
+  {
+    // The difference set of the center holds all the kernel pixels.
+    return this->GetDifferenceSet( 13 ).size();
+  }
+};
+
+size_t
+CountOn( const KernelType & kernel )
+{
+  return static_cast< size_t >( std::count( kernel.Begin(), kernel.End(), true ) );
+}
+
+}
+
+int itkBinaryMorphologyImageFilterChordTest( int, char * [] )
+{
+  ImageType::SizeType size;
+  size[0] = 150;
+  size[1] = 11;
+  size[2] = 9;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIterator< ImageType > It( image, image->GetLargestPossibleRegion() );
+  for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    const unsigned int value = NextRandom() % 10;
+    It.Set( value < 4 ? Foreground : ( value < 5 ? 7 : 0 ) );
+    }
+
+  KernelType::RadiusType radius;
+  radius.Fill( 2 );
+  std::vector< KernelType > kernels;
+  kernels.push_back( KernelType::Ball( radius ) );
+  KernelType random;
+  random.SetRadius( radius );
+  for ( unsigned int i = 0; i < random.Size(); i++ )
+    {
+    random[i] = ( NextRandom() % 4 == 0 );
+    }
+  kernels.push_back( random );
+
+  ImageType::RegionType subregion = image->GetLargestPossibleRegion();
+  for ( unsigned int d = 0; d < Dimension; d++ )
+    {
+    subregion.SetIndex( d, 3 );
+    subregion.SetSize( d, size[d] - 5 );
+    }
+  const ImageType::RegionType regions[2] = { image->GetLargestPossibleRegion(), subregion };
+
+  typedef itk::BinaryDilateImageFilter< ImageType, ImageType, KernelType > DilateType;
+  typedef itk::BinaryErodeImageFilter< ImageType, ImageType, KernelType >  ErodeType;
+
+  bool success = true;
+  const itk::ThreadIdType numberOfThreads[2] = { 1, 3 };
+  for ( unsigned int k = 0; k < kernels.size(); k++ )
+    {
+    for ( unsigned int b = 0; b < 2; b++ )
+      {
+      for ( unsigned int t = 0; t < 2; t++ )
+        {
+        for ( unsigned int r = 0; r < 2; r++ )
+          {
+          success &= RunAndCheck< DilateType >( image, kernels[k], b, numberOfThreads[t], regions[r], false );
+          success &= RunAndCheck< ErodeType >( image, kernels[k], b, numberOfThreads[t], regions[r], true );
+          }
+        }
+      }
+    }
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The kernel analysis follows the changes of kernel.
+  KernelType corners;
+  corners.SetRadius( radius );
+  for ( unsigned int i = 0; i < corners.Size(); i++ )
+    {
+    corners[i] = false;
+    }
+  corners[0] = true;
+  corners[corners.Size() - 1] = true;
+  KernelAnalysisFilter::Pointer analysis = KernelAnalysisFilter::New();
+  analysis->SetKernel( kernels[0] );
+  TEST_EXPECT_EQUAL( analysis->GetNumberOfKernelComponents(), 1u );
+  TEST_EXPECT_EQUAL( analysis->GetCenterDifferenceSetSize(), CountOn( kernels[0] ) );
+  analysis->SetKernel( corners );
+  TEST_EXPECT_EQUAL( analysis->GetNumberOfKernelComponents(), 2u );
+  TEST_EXPECT_EQUAL( analysis->GetCenterDifferenceSetSize(), 2u );
+  analysis->SetKernel( kernels[0] );
+  TEST_EXPECT_EQUAL( analysis->GetNumberOfKernelComponents(), 1u );
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,232 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBinaryDilateImageFilter.h"
+#include "itkBinaryErodeImageFilter.h"
+#include "itkBinaryPackedAndImageFilter.h"
+#include "itkBinaryPackedDilateImageFilter.h"
+#include "itkBinaryPackedErodeImageFilter.h"
+#include "itkBinaryPackedOrImageFilter.h"
+#include "itkBinaryPackedXorImageFilter.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageToBinaryPackedImageFilter.h"
+#include "itkTestingMacros.h"
+
+// Compare the logical operations and the morphology of BinaryPackedImages
+// with the same operations on images of bytes.
+namespace
+{
+
+const unsigned int Dimension = 3;
+
+typedef itk::Image< unsigned char, Dimension > ImageType;
+typedef itk::BinaryPackedImage< Dimension >    PackedImageType;
+
+ImageType::Pointer
+RandomImage(const ImageType::RegionType & region, unsigned int seed, unsigned int density)
+{
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  itk::ImageRegionIterator< ImageType > it( image, region );
+  for (; !it.IsAtEnd(); ++it )
+    {
+    seed = seed * 1664525u + 1013904223u;
+    it.Set( ( seed >> 8 ) % 100 < density ? 1 : 0 );
+    }
+  return image;
+}
+
+PackedImageType::Pointer
+Pack(const ImageType *image)
+{
+  typedef itk::ImageToBinaryPackedImageFilter< ImageType > EncoderType;
+  EncoderType::Pointer encoder = EncoderType::New();
+  encoder->SetInput( image );
+  encoder->SetLowerThreshold( 1 );
+  encoder->Update();
+  return encoder->GetOutput();
+}
+
+// the region of the packed image must have the same values as the image
+bool
+SameRegion(const ImageType *image, const PackedImageType *packedImage, const ImageType::RegionType & region,
+           const char *name)
+{
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( image, region );
+  for (; !it.IsAtEnd(); ++it )
+    {
+    if ( packedImage->GetPixel( it.GetIndex() ) != ( it.Get() != 0 ) )
+      {
+      std::cerr << name << ": different values at " << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< typename TFilter >
+bool
+TestLogic(const PackedImageType *packedImage1, const PackedImageType *packedImage2,
+          const ImageType *image1, const ImageType *image2, const char *name)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput1( packedImage1 );
+  filter->SetInput2( packedImage2 );
+  filter->SetNumberOfThreads( 3 );
+  filter->Update();
+
+  const typename TFilter::FunctorType functor;
+  ImageType::Pointer expected = ImageType::New();
+  expected->SetRegions( image1->GetBufferedRegion() );
+  expected->Allocate();
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( image1, image1->GetBufferedRegion() );
+  for (; !it.IsAtEnd(); ++it )
+    {
+    expected->SetPixel( it.GetIndex(), functor( it.Get(), image2->GetPixel( it.GetIndex() ) ) );
+    }
+  return SameRegion( expected, filter->GetOutput(), expected->GetBufferedRegion(), name );
+}
+
+template< typename TPackedFilter, typename TFilter >
+bool
+TestMorphology(const PackedImageType *packedImage, const ImageType *image,
+               const ImageType::SizeType & radius, int shape, bool boundaryToForeground,
+               itk::ThreadIdType numberOfThreads, const ImageType::RegionType & requestedRegion,
+               const char *name)
+{
+  typename TPackedFilter::Pointer packedFilter = TPackedFilter::New();
+  packedFilter->SetInput( packedImage );
+  packedFilter->SetRadius( radius );
+  packedFilter->SetKernelShape( shape );
+  packedFilter->SetBoundaryToForeground( boundaryToForeground );
+  packedFilter->SetNumberOfThreads( numberOfThreads );
+  packedFilter->UpdateOutputInformation();
+  packedFilter->GetOutput()->SetRequestedRegion( requestedRegion );
+  packedFilter->Update();
+
+  typedef typename TFilter::KernelType KernelType;
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput( image );
+  filter->SetKernel( shape == TPackedFilter::BOX ? KernelType::Box( radius ) : KernelType::Cross( radius ) );
+  filter->SetForegroundValue( 1 );
+  filter->SetBackgroundValue( 0 );
+  filter->SetBoundaryToForeground( boundaryToForeground );
+  filter->Update();
+
+  if ( !SameRegion( filter->GetOutput(), packedFilter->GetOutput(), requestedRegion, name ) )
+    {
+    std::cerr << "  radius " << radius << ", shape " << shape << ", boundary to foreground "
+              << boundaryToForeground << ", threads " << numberOfThreads << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+int itkBinaryPackedImageFilterTest( int, char *[] )
+{
+  ImageType::SizeType size;
+  size[0] = 150;
+  size[1] = 11;
+  size[2] = 9;
+  ImageType::IndexType start;
+  start[0] = 5;
+  start[1] = -2;
+  start[2] = 1;
+  const ImageType::RegionType region( start, size );
+
+  // the second image covers the first one, from another position in the
+  // words
+  ImageType::RegionType largerRegion = region;
+  largerRegion.PadByRadius( 17 );
+
+  ImageType::Pointer       image1 = RandomImage( region, 3, 40 );
+  ImageType::Pointer       image2 = RandomImage( largerRegion, 7, 50 );
+  PackedImageType::Pointer packedImage1 = Pack( image1 );
+  PackedImageType::Pointer packedImage2 = Pack( image2 );
+  TEST_EXPECT_TRUE( SameRegion( image1, packedImage1, region, "Pack" ) );
+  TEST_EXPECT_TRUE( SameRegion( image2, packedImage2, largerRegion, "Pack" ) );
+
+  typedef itk::BinaryPackedAndImageFilter< PackedImageType > AndType;
+  typedef itk::BinaryPackedOrImageFilter< PackedImageType >  OrType;
+  typedef itk::BinaryPackedXorImageFilter< PackedImageType > XorType;
+  EXERCISE_BASIC_OBJECT_METHODS( AndType::New(), BinaryPackedAndImageFilter, BinaryPackedFunctorImageFilter );
+  TEST_EXPECT_TRUE( TestLogic< AndType >( packedImage1, packedImage2, image1, image2, "And" ) );
+  TEST_EXPECT_TRUE( TestLogic< OrType >( packedImage1, packedImage2, image1, image2, "Or" ) );
+  TEST_EXPECT_TRUE( TestLogic< XorType >( packedImage1, packedImage1, image1, image1, "Xor" ) );
+  TEST_EXPECT_TRUE( TestLogic< XorType >( packedImage1, packedImage2, image1, image2, "Xor" ) );
+
+  typedef itk::FlatStructuringElement< Dimension >                                 KernelType;
+  typedef itk::BinaryDilateImageFilter< ImageType, ImageType, KernelType >        DilateType;
+  typedef itk::BinaryErodeImageFilter< ImageType, ImageType, KernelType >         ErodeType;
+  typedef itk::BinaryPackedDilateImageFilter< PackedImageType >                   PackedDilateType;
+  typedef itk::BinaryPackedErodeImageFilter< PackedImageType >                    PackedErodeType;
+
+  PackedDilateType::Pointer dilate = PackedDilateType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( dilate, BinaryPackedDilateImageFilter, BinaryPackedMorphologyImageFilter );
+  TEST_SET_GET_VALUE( static_cast< int >( PackedDilateType::BOX ), dilate->GetKernelShape() );
+  TEST_SET_GET_BOOLEAN( dilate, BoundaryToForeground, true );
+  PackedErodeType::Pointer erode = PackedErodeType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( erode, BinaryPackedErodeImageFilter, BinaryPackedMorphologyImageFilter );
+  TEST_EXPECT_TRUE( erode->GetBoundaryToForeground() );
+
+  // a sparse image for the dilation and a dense one for the erosion
+  ImageType::Pointer       sparseImage = RandomImage( region, 11, 2 );
+  ImageType::Pointer       denseImage = RandomImage( region, 13, 97 );
+  PackedImageType::Pointer packedSparseImage = Pack( sparseImage );
+  PackedImageType::Pointer packedDenseImage = Pack( denseImage );
+
+  ImageType::RegionType subregion = region;
+  subregion.SetIndex( 0, 70 );
+  subregion.SetSize( 0, 51 );
+  subregion.SetIndex( 2, 3 );
+  subregion.SetSize( 2, 4 );
+
+  // radii within a word, across words, and null along a dimension
+  const unsigned int numberOfRadii = 4;
+  const unsigned int radii[numberOfRadii][Dimension] = { { 1, 1, 1 }, { 2, 0, 3 }, { 37, 1, 2 }, { 70, 2, 0 } };
+  for ( unsigned int r = 0; r < numberOfRadii; ++r )
+    {
+    ImageType::SizeType radius;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      radius[d] = radii[r][d];
+      }
+    for ( int shape = PackedDilateType::BOX; shape <= PackedDilateType::CROSS; ++shape )
+      {
+      for ( int boundary = 0; boundary < 2; ++boundary )
+        {
+        TEST_EXPECT_TRUE( ( TestMorphology< PackedDilateType, DilateType >( packedSparseImage, sparseImage,
+                            radius, shape, boundary != 0, 1, region, "Dilate" ) ) );
+        TEST_EXPECT_TRUE( ( TestMorphology< PackedErodeType, ErodeType >( packedDenseImage, denseImage,
+                            radius, shape, boundary != 0, 1, region, "Erode" ) ) );
+        TEST_EXPECT_TRUE( ( TestMorphology< PackedDilateType, DilateType >( packedSparseImage, sparseImage,
+                            radius, shape, boundary != 0, 3, subregion, "Dilate" ) ) );
+        TEST_EXPECT_TRUE( ( TestMorphology< PackedErodeType, ErodeType >( packedDenseImage, denseImage,
+                            radius, shape, boundary != 0, 3, subregion, "Erode" ) ) );
+        }
+      }
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
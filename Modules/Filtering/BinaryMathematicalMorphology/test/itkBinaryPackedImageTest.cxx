@@ -0,0 +1,188 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBinaryPackedImageRegionIterator.h"
+#include "itkBinaryPackedImageToImageFilter.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageToBinaryPackedImageFilter.h"
+#include "itkTestingMacros.h"
+
+// Threshold an image into a BinaryPackedImage, compare the pixels of the
+// packed image and of its iterators with the thresholded pixels, modify
+// pixels of both, and decode the packed image while streaming it to a
+// file.
+namespace
+{
+
+const unsigned int Dimension = 3;
+
+typedef itk::Image< unsigned char, Dimension > ImageType;
+typedef itk::BinaryPackedImage< Dimension >    PackedImageType;
+
+bool
+SameRegion(const ImageType *image, const PackedImageType *packedImage, const ImageType::RegionType & region)
+{
+  itk::ImageRegionConstIterator< ImageType >                    it( image, region );
+  itk::BinaryPackedImageRegionConstIterator< PackedImageType > pit( packedImage, region );
+  for (; !it.IsAtEnd(); ++it, ++pit )
+    {
+    if ( pit.IsAtEnd() || pit.GetIndex() != it.GetIndex() )
+      {
+      std::cerr << "The iterators are not at the same index" << std::endl;
+      return false;
+      }
+    const bool expected = ( it.Get() == 255 );
+    if ( pit.Get() != expected || packedImage->GetPixel( it.GetIndex() ) != expected )
+      {
+      std::cerr << "Different values at " << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  return pit.IsAtEnd();
+}
+
+}
+
+int itkBinaryPackedImageTest( int argc, char * argv[] )
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputImage" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // lines of several words, with a partial last word
+  ImageType::SizeType size;
+  size[0] = 150;
+  size[1] = 7;
+  size[2] = 5;
+  ImageType::IndexType start;
+  start[0] = -3;
+  start[1] = 2;
+  start[2] = 0;
+  ImageType::RegionType region( start, size );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  unsigned int value = 17;
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, region );
+  for (; !it.IsAtEnd(); ++it )
+    {
+    value = value * 1664525u + 1013904223u;
+    it.Set( static_cast< unsigned char >( ( value >> 8 ) % 200 ) );
+    }
+
+  typedef itk::ImageToBinaryPackedImageFilter< ImageType > EncoderType;
+  EncoderType::Pointer encoder = EncoderType::New();
+  encoder->SetInput( image );
+  encoder->SetLowerThreshold( 50 );
+  encoder->SetUpperThreshold( 120 );
+  encoder->SetNumberOfThreads( 3 );
+  TRY_EXPECT_NO_EXCEPTION( encoder->Update() );
+  TEST_SET_GET_VALUE( 50, encoder->GetLowerThreshold() );
+  TEST_SET_GET_VALUE( 120, encoder->GetUpperThreshold() );
+
+  PackedImageType::Pointer packedImage = encoder->GetOutput();
+  TEST_EXPECT_EQUAL( packedImage->GetWordsPerLine(), 3u );
+  TEST_EXPECT_EQUAL( packedImage->GetNumberOfLines(), 35u );
+
+  // the expected binary image
+  itk::SizeValueType numberOfForegroundPixels = 0;
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const bool isForeground = ( it.Get() >= 50 && it.Get() <= 120 );
+    it.Set( isForeground ? 255 : 0 );
+    numberOfForegroundPixels += isForeground;
+    }
+  TEST_EXPECT_TRUE( SameRegion( image, packedImage, region ) );
+  TEST_EXPECT_EQUAL( packedImage->GetNumberOfForegroundPixels(), numberOfForegroundPixels );
+
+  // a region which does not start on a word
+  ImageType::RegionType subregion = region;
+  subregion.SetIndex( 0, 60 );
+  subregion.SetSize( 0, 70 );
+  subregion.SetIndex( 1, 3 );
+  subregion.SetSize( 1, 4 );
+  TEST_EXPECT_TRUE( SameRegion( image, packedImage, subregion ) );
+
+  // modify the pixels with the iterator and with SetPixel
+  itk::BinaryPackedImageRegionIterator< PackedImageType > pit( packedImage, subregion );
+  for (; !pit.IsAtEnd(); ++pit )
+    {
+    const bool newValue = ( pit.GetIndex()[0] + pit.GetIndex()[1] ) % 3 == 0;
+    pit.Set( newValue );
+    image->SetPixel( pit.GetIndex(), newValue ? 255 : 0 );
+    }
+  ImageType::IndexType index = start;
+  index[0] = 146;
+  packedImage->SetPixel( index, true );
+  image->SetPixel( index, 255 );
+  index[0] = -3;
+  packedImage->SetPixel( index, false );
+  image->SetPixel( index, 0 );
+  TEST_EXPECT_TRUE( SameRegion( image, packedImage, region ) );
+
+  // the bits after the end of the lines stay zero
+  packedImage->FillBuffer( true );
+  TEST_EXPECT_EQUAL( packedImage->GetNumberOfForegroundPixels(), region.GetNumberOfPixels() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( 255 );
+    }
+  TEST_EXPECT_TRUE( SameRegion( image, packedImage, region ) );
+  packedImage->SetPixel( index, false );
+  image->SetPixel( index, 0 );
+
+  // decode the image while writing it in several pieces
+  typedef itk::BinaryPackedImageToImageFilter< PackedImageType, ImageType > DecoderType;
+  DecoderType::Pointer decoder = DecoderType::New();
+  decoder->SetInput( packedImage );
+  decoder->SetForegroundValue( 255 );
+  decoder->SetBackgroundValue( 0 );
+  TEST_SET_GET_VALUE( 255, decoder->GetForegroundValue() );
+  TEST_SET_GET_VALUE( 0, decoder->GetBackgroundValue() );
+
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( decoder->GetOutput() );
+  writer->SetFileName( argv[1] );
+  writer->SetNumberOfStreamDivisions( 4 );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  TRY_EXPECT_NO_EXCEPTION( reader->Update() );
+
+  itk::ImageRegionConstIterator< ImageType > rit( reader->GetOutput(), reader->GetOutput()->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it, ++rit )
+    {
+    if ( it.Get() != rit.Get() )
+      {
+      std::cerr << "The written image differs at " << it.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
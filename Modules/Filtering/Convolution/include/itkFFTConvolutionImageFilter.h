@@ -24,6 +24,7 @@
 #include "itkHalfHermitianToRealInverseFFTImageFilter.h"
 #include "itkRealToHalfHermitianForwardFFTImageFilter.h"
 #include "itkZeroFluxNeumannBoundaryCondition.h"
+#include "itkMultiThreader.h"
 
 namespace itk
 {
@@ -36,6 +37,17 @@ namespace itk
  * convolution theorem to accelerate the convolution computation when
  * the kernel is large.
  *
+ * By default the whole padded image is transformed at once.  When
+ * BlockConvolution is on, the output is instead computed in
+ * independent blocks with the overlap-save method: each block of the
+ * input, extended by the kernel support, is transformed with a small
+ * FFT, multiplied with the kernel spectrum and transformed back.  The
+ * blocks are processed in parallel and the kernel spectrum is computed
+ * once for the block FFT size.  This needs much less memory and is
+ * usually faster when the kernel is small compared with the image.  In
+ * this mode the filter only requests the part of the input it needs
+ * for the output requested region, so it can be streamed.
+ *
  * \warning This filter ignores the spacing, origin, and orientation
  * of the kernel image and treats them as identical to those in the
  * input image.
@@ -105,6 +117,21 @@ public:
   itkSetMacro(SizeGreatestPrimeFactor, SizeValueType);
   itkGetMacro(SizeGreatestPrimeFactor, SizeValueType);
 
+  /** Set/Get whether the convolution is computed block by block with
+   * the overlap-save method.  Defaults to false.  Subclasses that
+   * need the spectrum of the whole image ignore this setting. */
+  itkSetMacro(BlockConvolution, bool);
+  itkGetConstMacro(BlockConvolution, bool);
+  itkBooleanMacro(BlockConvolution);
+
+  /** Set/Get the edge length of the FFT used for each block when
+   * BlockConvolution is on.  It is raised to at least twice the
+   * kernel size and to a size whose greatest prime factor does not
+   * exceed SizeGreatestPrimeFactor.  Zero, the default, chooses a size
+   * that keeps the data of a block in the processor cache. */
+  itkSetMacro(BlockSize, SizeValueType);
+  itkGetConstMacro(BlockSize, SizeValueType);
+
 protected:
   FFTConvolutionImageFilter();
   ~FFTConvolutionImageFilter() ITK_OVERRIDE {}
@@ -130,6 +157,24 @@ protected:
   /** This filter uses a minipipeline to compute the output. */
   void GenerateData() ITK_OVERRIDE;
 
+  /** Whether GenerateData() and GenerateInputRequestedRegion() use
+   * block convolution.  Subclasses that work on the spectrum of the
+   * whole image override this to return false. */
+  virtual bool IsBlockConvolutionEnabled() const
+  {
+    return m_BlockConvolution;
+  }
+
+  /** Compute the output requested region with the overlap-save
+   * method. */
+  void BlockConvolutionGenerateData();
+
+  /** Get the size of the FFT used for each block. */
+  InputSizeType GetBlockFFTSize() const;
+
+  /** Convolve the blocks assigned to one thread. */
+  void ThreadedBlockConvolution(ThreadIdType threadId, ThreadIdType numberOfThreads);
+
   /** Prepare the input images for operations in the Fourier
    * domain. This includes resizing the input and kernel images,
    * normalizing the kernel if requested, shifting the kernel, and
@@ -192,7 +237,22 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(FFTConvolutionImageFilter);
 
+  /** Internal structure used for passing the filter to the threads. */
+  struct BlockThreadStruct
+  {
+    Self *Filter;
+  };
+
+  static ITK_THREAD_RETURN_TYPE BlockConvolutionThreaderCallback(void *arg);
+
   SizeValueType m_SizeGreatestPrimeFactor;
+
+  bool          m_BlockConvolution;
+  SizeValueType m_BlockSize;
+
+  /** Block FFT size and kernel spectrum shared by the threads. */
+  InputSizeType                   m_BlockFFTSize;
+  InternalComplexImagePointerType m_BlockKernelSpectrum;
 };
 }
 
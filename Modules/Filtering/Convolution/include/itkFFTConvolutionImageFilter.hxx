@@ -29,16 +29,25 @@
 #include "itkImageBase.h"
 #include "itkMultiplyImageFilter.h"
 #include "itkNormalizeToConstantImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkProgressReporter.h"
 #include "itkMath.h"
+#include <algorithm>
+#include <cmath>
 
 namespace itk
 {
 
 template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
 FFTConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
-::FFTConvolutionImageFilter()
+::FFTConvolutionImageFilter() :
+  m_BlockConvolution( false ),
+  m_BlockSize( 0 )
 {
   m_SizeGreatestPrimeFactor = FFTFilterType::New()->GetSizeGreatestPrimeFactor();
+  m_BlockFFTSize.Fill( 0 );
 }
 
 template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
@@ -46,6 +55,37 @@ void
 FFTConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
 ::GenerateInputRequestedRegion()
 {
+  if ( this->IsBlockConvolutionEnabled() && this->GetInput() && this->GetKernelImage() )
+    {
+    // Each output pixel needs the input under the kernel support.
+    typename InputImageType::Pointer inputPtr =
+      const_cast< InputImageType * >( this->GetInput() );
+    const KernelSizeType kernelSize =
+      this->GetKernelImage()->GetLargestPossibleRegion().GetSize();
+    InputRegionType inputRegion = this->GetOutput()->GetRequestedRegion();
+    InputIndexType  inputIndex = inputRegion.GetIndex();
+    InputSizeType   inputSize = inputRegion.GetSize();
+    for ( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      const OffsetValueType low =
+        static_cast< OffsetValueType >( kernelSize[i] - 1 - kernelSize[i] / 2 );
+      inputIndex[i] -= low;
+      inputSize[i] += kernelSize[i] - 1;
+      }
+    inputRegion.SetIndex( inputIndex );
+    inputRegion.SetSize( inputSize );
+
+    // Let the boundary condition decide which part of the input it
+    // reads for pixels outside the image.
+    inputPtr->SetRequestedRegion( this->GetBoundaryCondition()->GetInputRequestedRegion(
+                                    inputPtr->GetLargestPossibleRegion(), inputRegion ) );
+
+    typename KernelImageType::Pointer kernelPtr =
+      const_cast< KernelImageType * >( this->GetKernelImage() );
+    kernelPtr->SetRequestedRegionToLargestPossibleRegion();
+    return;
+    }
+
   // Request the largest possible region for both input images.
   if ( this->GetInput() )
     {
@@ -69,6 +109,12 @@ void
 FFTConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
 ::GenerateData()
 {
+  if ( this->IsBlockConvolutionEnabled() )
+    {
+    this->BlockConvolutionGenerateData();
+    return;
+    }
+
   // Create a process accumulator for tracking the progress of this minipipeline
   ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
   progress->SetMiniPipelineFilter( this );
@@ -98,6 +144,272 @@ FFTConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPre
   this->ProduceOutput( multiplyFilter->GetOutput(), progress, 0.2 );
 }
 
+template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
+void
+FFTConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
+::BlockConvolutionGenerateData()
+{
+  this->AllocateOutputs();
+
+  const OutputRegionType outputRegion = this->GetOutput()->GetRequestedRegion();
+  if ( outputRegion.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  // All the blocks have the same FFT size, so the kernel spectrum is
+  // computed once.  The kernel is not shifted: the first
+  // kernelSize - 1 samples of each block are wrapped around and
+  // discarded, and the kernel center is accounted for when the block
+  // input is read.
+  m_BlockFFTSize = this->GetBlockFFTSize();
+
+  const KernelImageType * kernel = this->GetKernelImage();
+  const KernelRegionType  kernelRegion = kernel->GetLargestPossibleRegion();
+
+  InternalImagePointerType paddedKernel = InternalImageType::New();
+  paddedKernel->SetRegions( m_BlockFFTSize );
+  paddedKernel->Allocate();
+  paddedKernel->FillBuffer( NumericTraits< TInternalPrecision >::ZeroValue() );
+
+  TInternalPrecision scale = NumericTraits< TInternalPrecision >::OneValue();
+  if ( this->GetNormalize() )
+    {
+    TInternalPrecision sum = NumericTraits< TInternalPrecision >::ZeroValue();
+    ImageRegionConstIterator< KernelImageType > kit( kernel, kernelRegion );
+    for ( kit.GoToBegin(); !kit.IsAtEnd(); ++kit )
+      {
+      sum += static_cast< TInternalPrecision >( kit.Get() );
+      }
+    scale /= sum;
+    }
+
+  typename InternalImageType::RegionType paddedKernelRegion;
+  paddedKernelRegion.SetSize( kernelRegion.GetSize() );
+  ImageRegionConstIterator< KernelImageType > kit( kernel, kernelRegion );
+  ImageRegionIterator< InternalImageType >    pit( paddedKernel, paddedKernelRegion );
+  for ( kit.GoToBegin(), pit.GoToBegin(); !kit.IsAtEnd(); ++kit, ++pit )
+    {
+    pit.Set( scale * static_cast< TInternalPrecision >( kit.Get() ) );
+    }
+
+  typename FFTFilterType::Pointer kernelFFTFilter = FFTFilterType::New();
+  kernelFFTFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
+  kernelFFTFilter->SetInput( paddedKernel );
+  kernelFFTFilter->Update();
+  m_BlockKernelSpectrum = kernelFFTFilter->GetOutput();
+  m_BlockKernelSpectrum->DisconnectPipeline();
+  kernelFFTFilter = ITK_NULLPTR;
+  paddedKernel = ITK_NULLPTR;
+
+  SizeValueType numberOfBlocks = 1;
+  for ( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+    const SizeValueType blockSize = m_BlockFFTSize[i] - kernelRegion.GetSize()[i] + 1;
+    numberOfBlocks *= ( outputRegion.GetSize()[i] + blockSize - 1 ) / blockSize;
+    }
+
+  ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+  if ( numberOfBlocks < numberOfThreads )
+    {
+    numberOfThreads = static_cast< ThreadIdType >( numberOfBlocks );
+    }
+
+  BlockThreadStruct str;
+  str.Filter = this;
+  this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+  this->GetMultiThreader()->SetSingleMethod( this->BlockConvolutionThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  m_BlockKernelSpectrum = ITK_NULLPTR;
+}
+
+template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
+ITK_THREAD_RETURN_TYPE
+FFTConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
+::BlockConvolutionThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  BlockThreadStruct * str = static_cast< BlockThreadStruct * >( info->UserData );
+
+  str->Filter->ThreadedBlockConvolution( info->ThreadID, info->NumberOfThreads );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
+void
+FFTConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
+::ThreadedBlockConvolution(ThreadIdType threadId, ThreadIdType numberOfThreads)
+{
+  const InputImageType *         input = this->GetInput();
+  OutputImageType *              output = this->GetOutput();
+  const OutputRegionType         outputRegion = output->GetRequestedRegion();
+  const InputRegionType          bufferedRegion = input->GetBufferedRegion();
+  const BoundaryConditionType *  boundaryCondition = this->GetBoundaryCondition();
+  const KernelSizeType           kernelSize =
+    this->GetKernelImage()->GetLargestPossibleRegion().GetSize();
+
+  // Output pixels per block, number of blocks along each axis and the
+  // offset from the first output pixel of a block to the first input
+  // pixel it depends on.
+  OutputSizeType blockSize;
+  OutputSizeType numberOfBlocks;
+  OffsetValueType inputShift[ImageDimension];
+  SizeValueType totalNumberOfBlocks = 1;
+  for ( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+    blockSize[i] = m_BlockFFTSize[i] - kernelSize[i] + 1;
+    numberOfBlocks[i] = ( outputRegion.GetSize()[i] + blockSize[i] - 1 ) / blockSize[i];
+    inputShift[i] = static_cast< OffsetValueType >( kernelSize[i] / 2 )
+      - static_cast< OffsetValueType >( kernelSize[i] - 1 );
+    totalNumberOfBlocks *= numberOfBlocks[i];
+    }
+
+  SizeValueType numberOfBlocksForThread = totalNumberOfBlocks / numberOfThreads;
+  if ( threadId < totalNumberOfBlocks % numberOfThreads )
+    {
+    ++numberOfBlocksForThread;
+    }
+  ProgressReporter progress( this, threadId, numberOfBlocksForThread );
+
+  // Each thread transforms its blocks with its own FFT filters and
+  // buffers, which are reused from one block to the next.
+  InternalImagePointerType blockInput = InternalImageType::New();
+  blockInput->SetRegions( m_BlockFFTSize );
+  blockInput->Allocate();
+
+  typename FFTFilterType::Pointer fftFilter = FFTFilterType::New();
+  fftFilter->SetNumberOfThreads( 1 );
+  fftFilter->SetInput( blockInput );
+
+  typename IFFTFilterType::Pointer ifftFilter = IFFTFilterType::New();
+  ifftFilter->SetActualXDimensionIsOdd( m_BlockFFTSize[0] % 2 != 0 );
+  ifftFilter->SetNumberOfThreads( 1 );
+  ifftFilter->SetInput( fftFilter->GetOutput() );
+
+  for ( SizeValueType block = threadId; block < totalNumberOfBlocks; block += numberOfThreads )
+    {
+    // Output region of the block and input region it depends on.
+    OutputIndexType blockIndex;
+    OutputSizeType  blockRegionSize;
+    InputIndexType  inputIndex;
+    SizeValueType   remainder = block;
+    for ( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      const SizeValueType position = remainder % numberOfBlocks[i];
+      remainder /= numberOfBlocks[i];
+      blockIndex[i] = outputRegion.GetIndex()[i]
+        + static_cast< OffsetValueType >( position * blockSize[i] );
+      blockRegionSize[i] = std::min( blockSize[i],
+                                     outputRegion.GetSize()[i] - position * blockSize[i] );
+      inputIndex[i] = blockIndex[i] + inputShift[i];
+      }
+    const OutputRegionType blockRegion( blockIndex, blockRegionSize );
+    const InputRegionType  inputRegion( inputIndex, m_BlockFFTSize );
+
+    // Read the block input, using the boundary condition outside the
+    // buffered input.
+    if ( bufferedRegion.IsInside( inputRegion ) )
+      {
+      ImageRegionConstIterator< InputImageType > iit( input, inputRegion );
+      ImageRegionIterator< InternalImageType >   bit( blockInput, blockInput->GetBufferedRegion() );
+      for ( iit.GoToBegin(), bit.GoToBegin(); !iit.IsAtEnd(); ++iit, ++bit )
+        {
+        bit.Set( static_cast< TInternalPrecision >( iit.Get() ) );
+        }
+      }
+    else
+      {
+      ImageRegionIteratorWithIndex< InternalImageType > bit( blockInput, blockInput->GetBufferedRegion() );
+      for ( bit.GoToBegin(); !bit.IsAtEnd(); ++bit )
+        {
+        InputIndexType index = bit.GetIndex();
+        for ( unsigned int i = 0; i < ImageDimension; ++i )
+          {
+          index[i] += inputIndex[i];
+          }
+        if ( bufferedRegion.IsInside( index ) )
+          {
+          bit.Set( static_cast< TInternalPrecision >( input->GetPixel( index ) ) );
+          }
+        else
+          {
+          bit.Set( static_cast< TInternalPrecision >( boundaryCondition->GetPixel( index, input ) ) );
+          }
+        }
+      }
+    blockInput->Modified();
+    fftFilter->Update();
+
+    // Multiply with the kernel spectrum in place.
+    InternalComplexImageType * spectrum = fftFilter->GetOutput();
+    ImageRegionIterator< InternalComplexImageType > sit( spectrum, spectrum->GetBufferedRegion() );
+    ImageRegionConstIterator< InternalComplexImageType > kit( m_BlockKernelSpectrum,
+                                                              m_BlockKernelSpectrum->GetBufferedRegion() );
+    for ( sit.GoToBegin(), kit.GoToBegin(); !sit.IsAtEnd(); ++sit, ++kit )
+      {
+      sit.Set( sit.Get() * kit.Get() );
+      }
+    spectrum->Modified();
+    ifftFilter->Update();
+
+    // The first kernelSize - 1 samples along each axis are corrupted
+    // by the circular wrap-around; the rest is the block output.
+    const InternalImageType * result = ifftFilter->GetOutput();
+    typename InternalImageType::IndexType resultIndex;
+    for ( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      resultIndex[i] = result->GetBufferedRegion().GetIndex()[i]
+        + static_cast< OffsetValueType >( kernelSize[i] - 1 );
+      }
+    const typename InternalImageType::RegionType resultRegion( resultIndex, blockRegionSize );
+    ImageRegionConstIterator< InternalImageType > rit( result, resultRegion );
+    ImageRegionIterator< OutputImageType >        oit( output, blockRegion );
+    for ( rit.GoToBegin(), oit.GoToBegin(); !oit.IsAtEnd(); ++rit, ++oit )
+      {
+      oit.Set( static_cast< OutputPixelType >( rit.Get() ) );
+      }
+
+    progress.CompletedPixel();
+    }
+}
+
+template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
+typename FFTConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >::InputSizeType
+FFTConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
+::GetBlockFFTSize() const
+{
+  const KernelSizeType kernelSize = this->GetKernelImage()->GetLargestPossibleRegion().GetSize();
+  const OutputSizeType outputSize = this->GetOutput()->GetRequestedRegion().GetSize();
+
+  // By default, aim at about 32768 samples per block so that the real
+  // block, its spectrum and the kernel spectrum stay in the L2 cache.
+  SizeValueType edge = m_BlockSize;
+  if ( edge == 0 )
+    {
+    edge = static_cast< SizeValueType >( std::pow( 32768.0, 1.0 / ImageDimension ) + 0.5 );
+    }
+
+  InputSizeType fftSize;
+  for ( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+    // Blocks much smaller than the kernel waste most of each FFT, and
+    // blocks larger than the output plus the kernel support are useless.
+    fftSize[i] = std::max( edge, 2 * kernelSize[i] );
+    fftSize[i] = std::min( fftSize[i], outputSize[i] + kernelSize[i] - 1 );
+    if( m_SizeGreatestPrimeFactor > 1 )
+      {
+      while ( Math::GreatestPrimeFactor( fftSize[i] ) > m_SizeGreatestPrimeFactor )
+        {
+        fftSize[i]++;
+        }
+      }
+    }
+
+  return fftSize;
+}
+
 template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
 void
 FFTConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
@@ -425,6 +737,8 @@ FFTConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPre
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "SizeGreatestPrimeFactor: " << m_SizeGreatestPrimeFactor << std::endl;
+  os << indent << "BlockConvolution: " << m_BlockConvolution << std::endl;
+  os << indent << "BlockSize: " << m_BlockSize << std::endl;
 }
 
 }
@@ -0,0 +1,184 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFFTConvolutionImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkPeriodicBoundaryCondition.h"
+#include "itkStreamingImageFilter.h"
+#include "itkTestingMacros.h"
+
+// Compare block (overlap-save) convolution with the convolution of the
+// whole padded image.
+namespace
+{
+
+template< typename TImage >
+typename TImage::Pointer
+MakeImage(const typename TImage::SizeType & size, unsigned int seed)
+{
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    unsigned int value = seed;
+    for ( unsigned int i = 0; i < TImage::ImageDimension; ++i )
+      {
+      value = value * 31 + static_cast< unsigned int >( it.GetIndex()[i] );
+      }
+    it.Set( static_cast< typename TImage::PixelType >( ( value * 2654435761u ) % 1000 ) / 100.0 );
+    }
+  return image;
+}
+
+template< typename TImage >
+bool
+CompareImages(const TImage * expected, const TImage * actual, const char * name)
+{
+  if ( expected->GetLargestPossibleRegion() != actual->GetLargestPossibleRegion() )
+    {
+    std::cerr << name << ": regions differ: " << expected->GetLargestPossibleRegion()
+              << actual->GetLargestPossibleRegion() << std::endl;
+    return false;
+    }
+  double maxDifference = 0.0;
+  itk::ImageRegionConstIterator< TImage > eit( expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > ait( actual, expected->GetLargestPossibleRegion() );
+  for ( ; !eit.IsAtEnd(); ++eit, ++ait )
+    {
+    maxDifference = std::max( maxDifference,
+                              std::abs( static_cast< double >( eit.Get() ) - static_cast< double >( ait.Get() ) ) );
+    }
+  std::cout << name << ": maximum difference " << maxDifference << std::endl;
+  if ( maxDifference > 1e-3 )
+    {
+    std::cerr << name << ": block convolution differs from whole image convolution" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+template< typename TImage >
+bool
+TestBlockConvolution(const typename TImage::SizeType & imageSize,
+                     const typename TImage::SizeType & kernelSize,
+                     itk::SizeValueType blockSize,
+                     const char * name)
+{
+  typedef itk::FFTConvolutionImageFilter< TImage > FilterType;
+
+  typename TImage::Pointer image = MakeImage< TImage >( imageSize, 1 );
+  typename TImage::Pointer kernel = MakeImage< TImage >( kernelSize, 2 );
+
+  itk::PeriodicBoundaryCondition< TImage > periodic;
+  bool success = true;
+  for ( int mode = 0; mode < 4; ++mode )
+    {
+    const bool valid = ( mode % 2 == 1 );
+    const bool usePeriodic = ( mode >= 2 );
+
+    typename FilterType::Pointer reference = FilterType::New();
+    reference->SetInput( image );
+    reference->SetKernelImage( kernel );
+    reference->NormalizeOn();
+    if ( valid )
+      {
+      reference->SetOutputRegionModeToValid();
+      }
+    if ( usePeriodic )
+      {
+      reference->SetBoundaryCondition( &periodic );
+      }
+    reference->Update();
+
+    typename FilterType::Pointer block = FilterType::New();
+    block->SetInput( image );
+    block->SetKernelImage( kernel );
+    block->NormalizeOn();
+    block->BlockConvolutionOn();
+    block->SetBlockSize( blockSize );
+    if ( valid )
+      {
+      block->SetOutputRegionModeToValid();
+      }
+    if ( usePeriodic )
+      {
+      block->SetBoundaryCondition( &periodic );
+      }
+
+    // Stream the block convolution to check that it only needs the
+    // input requested region.
+    typedef itk::StreamingImageFilter< TImage, TImage > StreamerType;
+    typename StreamerType::Pointer streamer = StreamerType::New();
+    streamer->SetInput( block->GetOutput() );
+    streamer->SetNumberOfStreamDivisions( 3 );
+    streamer->Update();
+
+    std::ostringstream modeName;
+    modeName << name << ( valid ? " valid" : " same" ) << ( usePeriodic ? " periodic" : "" );
+    success &= CompareImages< TImage >( reference->GetOutput(), streamer->GetOutput(),
+                                        modeName.str().c_str() );
+    }
+  return success;
+}
+
+}
+
+int itkFFTConvolutionImageFilterBlockTest(int, char* [])
+{
+  typedef itk::Image< float, 2 >  ImageType2D;
+  typedef itk::Image< double, 3 > ImageType3D;
+
+  typedef itk::FFTConvolutionImageFilter< ImageType2D > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  TEST_SET_GET_BOOLEAN( filter, BlockConvolution, true );
+  TEST_SET_GET_VALUE( 0, filter->GetBlockSize() );
+  filter->SetBlockSize( 32 );
+  TEST_SET_GET_VALUE( 32, filter->GetBlockSize() );
+
+  bool success = true;
+
+  ImageType2D::SizeType imageSize2D;
+  imageSize2D[0] = 97;
+  imageSize2D[1] = 83;
+  ImageType2D::SizeType kernelSize2D;
+  kernelSize2D[0] = 7;
+  kernelSize2D[1] = 4;
+  success &= TestBlockConvolution< ImageType2D >( imageSize2D, kernelSize2D, 16, "2D, block size 16" );
+  success &= TestBlockConvolution< ImageType2D >( imageSize2D, kernelSize2D, 0, "2D, default block size" );
+
+  ImageType3D::SizeType imageSize3D;
+  imageSize3D[0] = 30;
+  imageSize3D[1] = 25;
+  imageSize3D[2] = 19;
+  ImageType3D::SizeType kernelSize3D;
+  kernelSize3D[0] = 5;
+  kernelSize3D[1] = 3;
+  kernelSize3D[2] = 6;
+  success &= TestBlockConvolution< ImageType3D >( imageSize3D, kernelSize3D, 12, "3D, block size 12" );
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -110,6 +110,12 @@ protected:
   /** This filter uses a minipipeline to compute the output. */
   virtual void GenerateData() ITK_OVERRIDE;
 
+  /** Deconvolution works on the spectrum of the whole image. */
+  virtual bool IsBlockConvolutionEnabled() const ITK_OVERRIDE
+  {
+    return false;
+  }
+
   virtual void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
 
 private:
@@ -125,6 +125,12 @@ protected:
    * ThreadedGenerateData is not overridden. */
   virtual void GenerateData() ITK_OVERRIDE;
 
+  /** Deconvolution works on the spectrum of the whole image. */
+  virtual bool IsBlockConvolutionEnabled() const ITK_OVERRIDE
+  {
+    return false;
+  }
+
   /** Discrete Fourier transform of the padded kernel. */
   InternalComplexImagePointerType m_TransferFunction;
 
@@ -134,11 +140,40 @@ protected:
   typedef typename Superclass::FFTFilterType  FFTFilterType;
   typedef typename Superclass::IFFTFilterType IFFTFilterType;
 
+  /** Call functor(begin, end) on consecutive chunks of the range
+   * [0, size) in parallel.  Iterations use this to update the
+   * resident real and complex buffers in place, one pixel after the
+   * other in memory order, instead of running a filter that would
+   * allocate a new image. */
+  template< typename TFunctor >
+  void ParallelizeBufferOperation(SizeValueType size, TFunctor & functor);
+
+  /** Run a resident forward or inverse FFT filter on the current
+   * content of its input buffer.  The filter keeps its output buffer
+   * from one call to the next, so nothing is allocated once it has
+   * run the first time. */
+  template< typename TFilter >
+  static void UpdateResidentFilter(TFilter * filter)
+  {
+    const_cast< typename TFilter::InputImageType * >( filter->GetInput() )->Modified();
+    filter->Update();
+  }
+
   virtual void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
 
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(IterativeDeconvolutionImageFilter);
 
+  template< typename TFunctor >
+  struct BufferOperationThreadStruct
+  {
+    TFunctor *    Functor;
+    SizeValueType Size;
+  };
+
+  template< typename TFunctor >
+  static ITK_THREAD_RETURN_TYPE BufferOperationThreaderCallback(void *arg);
+
   /** Number of iterations to run. */
   unsigned int m_NumberOfIterations;
 
@@ -141,6 +141,53 @@ IterativeDeconvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInt
   this->Finish(progress, 0.1f);
 }
 
+template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
+template< typename TFunctor >
+void
+IterativeDeconvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
+::ParallelizeBufferOperation(SizeValueType size, TFunctor & functor)
+{
+  // Pointwise operations are memory bound; do not wake up threads for
+  // less than a few pages of data each.
+  const SizeValueType minimumChunkSize = 16384;
+  ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+  if ( size / minimumChunkSize < numberOfThreads )
+    {
+    numberOfThreads = static_cast< ThreadIdType >( size / minimumChunkSize );
+    }
+  if ( numberOfThreads <= 1 )
+    {
+    functor( 0, size );
+    return;
+    }
+
+  BufferOperationThreadStruct< TFunctor > str;
+  str.Functor = &functor;
+  str.Size = size;
+  this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+  this->GetMultiThreader()->SetSingleMethod( &Self::template BufferOperationThreaderCallback< TFunctor >, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
+template< typename TFunctor >
+ITK_THREAD_RETURN_TYPE
+IterativeDeconvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
+::BufferOperationThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  BufferOperationThreadStruct< TFunctor > * str =
+    static_cast< BufferOperationThreadStruct< TFunctor > * >( info->UserData );
+
+  const SizeValueType threadId = info->ThreadID;
+  const SizeValueType numberOfThreads = info->NumberOfThreads;
+  const SizeValueType begin = str->Size * threadId / numberOfThreads;
+  const SizeValueType end = str->Size * ( threadId + 1 ) / numberOfThreads;
+  ( *str->Functor )( begin, end );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
 void
 IterativeDeconvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
@@ -20,9 +20,6 @@
 
 #include "itkIterativeDeconvolutionImageFilter.h"
 
-#include "itkComplexConjugateImageAdaptor.h"
-#include "itkTernaryFunctorImageFilter.h"
-
 namespace itk
 {
 namespace Functor
@@ -83,6 +80,10 @@ public:
  * algorithm that enforces a positivity constraint on each
  * intermediate solution, see ProjectedLandweberDeconvolutionImageFilter.
  *
+ * The Fourier transform filters and their buffers are created once
+ * before the first iteration, and the update is computed in place in
+ * the frequency domain, so iterations do not allocate any image.
+ *
  * This code was adapted from the Insight Journal contribution:
  *
  * "Deconvolution: infrastructure and reference algorithms"
@@ -157,20 +158,66 @@ private:
 
   double m_Alpha;
 
+  /** Transform of the input multiplied by Alpha times the conjugate
+   * of the transfer function, the constant term of the update. */
   InternalComplexImagePointerType m_TransformedInput;
 
-  typedef Functor::LandweberMethod< InternalComplexType,
-                                    InternalComplexType,
-                                    InternalComplexType,
-                                    InternalComplexType > LandweberFunctor;
-  typedef TernaryFunctorImageFilter< InternalComplexImageType,
-                                     InternalComplexImageType,
-                                     InternalComplexImageType,
-                                     InternalComplexImageType,
-                                     LandweberFunctor >   LandweberFilterType;
-
-  typename LandweberFilterType::Pointer  m_LandweberFilter;
-  typename IFFTFilterType::Pointer       m_IFFTFilter;
+  /** Compute the constant term of the update in place. */
+  class InitializationOperation
+  {
+  public:
+    void operator()(SizeValueType begin, SizeValueType end) const
+    {
+      for ( SizeValueType i = begin; i < end; ++i )
+        {
+        m_Buffer[i] *= m_Alpha * std::conj( m_TransferFunction[i] );
+        }
+    }
+
+    InternalComplexType *       m_Buffer;
+    const InternalComplexType * m_TransferFunction;
+    TInternalPrecision          m_Alpha;
+  };
+
+  /** Apply LandweberMethod to the transform of the estimate in place.
+   * The products are written out explicitly so that the compiler can
+   * vectorize the loop. */
+  class IterationOperation
+  {
+  public:
+    void operator()(SizeValueType begin, SizeValueType end) const
+    {
+      for ( SizeValueType i = begin; i < end; ++i )
+        {
+        const TInternalPrecision hr = m_TransferFunction[i].real();
+        const TInternalPrecision hi = m_TransferFunction[i].imag();
+        const TInternalPrecision scale = 1 - m_Alpha * ( hr * hr + hi * hi );
+        m_Buffer[i] = InternalComplexType( m_TransformedInput[i].real() + scale * m_Buffer[i].real(),
+                                           m_TransformedInput[i].imag() + scale * m_Buffer[i].imag() );
+        }
+    }
+
+    InternalComplexType *       m_Buffer;
+    const InternalComplexType * m_TransferFunction;
+    const InternalComplexType * m_TransformedInput;
+    TInternalPrecision          m_Alpha;
+  };
+
+  /** Copy the new estimate into the estimate buffer. */
+  class CopyOperation
+  {
+  public:
+    void operator()(SizeValueType begin, SizeValueType end) const
+    {
+      std::copy( m_Source + begin, m_Source + end, m_Destination + begin );
+    }
+
+    typename InternalImageType::PixelType *       m_Destination;
+    const typename InternalImageType::PixelType * m_Source;
+  };
+
+  typename FFTFilterType::Pointer  m_FFTFilter;
+  typename IFFTFilterType::Pointer m_IFFTFilter;
 };
 
 } // end namespace itk
@@ -20,6 +20,8 @@
 
 #include "itkLandweberDeconvolutionImageFilter.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -50,46 +52,53 @@ LandweberDeconvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInt
   this->PrepareInput( this->GetInput(), m_TransformedInput, progress,
                       0.5f * progressWeight );
 
-  // Set up minipipeline to compute estimate at each iteration
-  m_LandweberFilter = LandweberFilterType::New();
-  m_LandweberFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
-  // Transform of current estimate will be set as input 1 in Iteration()
-  m_LandweberFilter->SetInput2( this->m_TransferFunction );
-  m_LandweberFilter->SetInput3( m_TransformedInput );
-  m_LandweberFilter->GetFunctor().m_Alpha = m_Alpha;
-  m_LandweberFilter->ReleaseDataFlagOn();
-  progress->RegisterInternalFilter( m_LandweberFilter,
-                                    0.3f * iterationProgressWeight );
+  InitializationOperation initialization;
+  initialization.m_Buffer = m_TransformedInput->GetBufferPointer();
+  initialization.m_TransferFunction = this->m_TransferFunction->GetBufferPointer();
+  initialization.m_Alpha = static_cast< TInternalPrecision >( m_Alpha );
+  this->ParallelizeBufferOperation( m_TransformedInput->GetPixelContainer()->Size(),
+                                    initialization );
+
+  // Resident filters to transform the estimate and back.
+  m_FFTFilter = FFTFilterType::New();
+  m_FFTFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
+  m_FFTFilter->SetInput( this->m_CurrentEstimate );
+  progress->RegisterInternalFilter( m_FFTFilter,
+                                    0.5f * iterationProgressWeight );
 
   m_IFFTFilter = IFFTFilterType::New();
   m_IFFTFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
   m_IFFTFilter->SetActualXDimensionIsOdd( this->GetXDimensionIsOdd() );
-  m_IFFTFilter->SetInput( m_LandweberFilter->GetOutput() );
-  m_IFFTFilter->ReleaseDataFlagOn();
+  m_IFFTFilter->SetInput( m_FFTFilter->GetOutput() );
   progress->RegisterInternalFilter( m_IFFTFilter,
-                                    0.7f * iterationProgressWeight );
+                                    0.5f * iterationProgressWeight );
 }
 
 template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
 void
 LandweberDeconvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
-::Iteration(ProgressAccumulator * progress, float iterationProgressWeight)
+::Iteration(ProgressAccumulator * itkNotUsed(progress), float itkNotUsed(iterationProgressWeight))
 {
-  // Set up minipipeline to compute the new estimate
-  InternalComplexImagePointerType transformedEstimate;
-  this->TransformPaddedInput( this->m_CurrentEstimate,
-                              transformedEstimate, progress,
-                              0.1f * iterationProgressWeight );
-
-  // Set the inputs
-  m_LandweberFilter->SetInput1( transformedEstimate );
-
-  // Trigger the update
-  m_IFFTFilter->UpdateLargestPossibleRegion();
-
-  // Store the current estimate
-  this->m_CurrentEstimate = m_IFFTFilter->GetOutput();
-  this->m_CurrentEstimate->DisconnectPipeline();
+  m_FFTFilter->SetInput( this->m_CurrentEstimate );
+  this->UpdateResidentFilter( m_FFTFilter.GetPointer() );
+
+  IterationOperation iteration;
+  iteration.m_Buffer = m_FFTFilter->GetOutput()->GetBufferPointer();
+  iteration.m_TransferFunction = this->m_TransferFunction->GetBufferPointer();
+  iteration.m_TransformedInput = m_TransformedInput->GetBufferPointer();
+  iteration.m_Alpha = static_cast< TInternalPrecision >( m_Alpha );
+  this->ParallelizeBufferOperation( m_TransformedInput->GetPixelContainer()->Size(),
+                                    iteration );
+  this->UpdateResidentFilter( m_IFFTFilter.GetPointer() );
+
+  // The estimate is the input of the forward transform, so the result
+  // is copied into it rather than replacing it.
+  CopyOperation copy;
+  copy.m_Destination = this->m_CurrentEstimate->GetBufferPointer();
+  copy.m_Source = m_IFFTFilter->GetOutput()->GetBufferPointer();
+  this->ParallelizeBufferOperation( this->m_CurrentEstimate->GetPixelContainer()->Size(),
+                                    copy );
+  this->m_CurrentEstimate->Modified();
 }
 
 template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
@@ -99,7 +108,8 @@ LandweberDeconvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInt
 {
   this->Superclass::Finish( progress, progressWeight );
 
-  m_LandweberFilter = ITK_NULLPTR;
+  m_TransformedInput = ITK_NULLPTR;
+  m_FFTFilter = ITK_NULLPTR;
   m_IFFTFilter = ITK_NULLPTR;
 }
 
@@ -20,8 +20,6 @@
 
 #include "itkIterativeDeconvolutionImageFilter.h"
 
-#include "itkThresholdImageFilter.h"
-
 namespace itk
 {
 /** \class ProjectedIterativeDeconvolutionImageFilter
@@ -74,19 +72,28 @@ protected:
   ProjectedIterativeDeconvolutionImageFilter();
   virtual ~ProjectedIterativeDeconvolutionImageFilter() ITK_OVERRIDE;
 
-  virtual void Initialize(ProgressAccumulator * progress,
-                          float progressWeight,
-                          float iterationProgressWeight) ITK_OVERRIDE;
-
   virtual void Iteration(ProgressAccumulator * progress,
                          float iterationProgressWeight) ITK_OVERRIDE;
 
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(ProjectedIterativeDeconvolutionImageFilter);
 
-  typedef ThresholdImageFilter< InternalImageType > ProjectionFilterType;
+  /** Set the negative values of the estimate to zero in place. */
+  class ProjectionOperation
+  {
+  public:
+    void operator()(SizeValueType begin, SizeValueType end) const
+    {
+      typedef typename InternalImageType::PixelType PixelType;
+      const PixelType zero = NumericTraits< PixelType >::ZeroValue();
+      for ( SizeValueType i = begin; i < end; ++i )
+        {
+        m_Buffer[i] = std::max( m_Buffer[i], zero );
+        }
+    }
 
-  typename ProjectionFilterType::Pointer m_ProjectionFilter;
+    typename InternalImageType::PixelType * m_Buffer;
+  };
 };
 } // end namespace ITK
 
@@ -20,6 +20,8 @@
 
 #include "itkProjectedIterativeDeconvolutionImageFilter.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -27,29 +29,12 @@ template< typename TSuperclass >
 ProjectedIterativeDeconvolutionImageFilter< TSuperclass >
 ::ProjectedIterativeDeconvolutionImageFilter()
 {
-  m_ProjectionFilter = ITK_NULLPTR;
 }
 
 template< typename TSuperclass >
 ProjectedIterativeDeconvolutionImageFilter< TSuperclass >
 ::~ProjectedIterativeDeconvolutionImageFilter()
 {
-  m_ProjectionFilter = ITK_NULLPTR;
-}
-
-template< typename TSuperclass >
-void
-ProjectedIterativeDeconvolutionImageFilter< TSuperclass >
-::Initialize(ProgressAccumulator * progress, float progressWeight,
-             float iterationProgressWeight)
-{
-  this->Superclass::Initialize( progress, progressWeight,
-                                iterationProgressWeight );
-
-  m_ProjectionFilter = ProjectionFilterType::New();
-  typename InternalImageType::PixelType zero =
-    NumericTraits< typename InternalImageType::PixelType >::ZeroValue();
-  m_ProjectionFilter->ThresholdBelow( zero );
 }
 
 template< typename TSuperclass >
@@ -59,10 +44,11 @@ ProjectedIterativeDeconvolutionImageFilter< TSuperclass >
 {
   this->Superclass::Iteration( progress, iterationProgressWeight );
 
-  m_ProjectionFilter->SetInput( this->m_CurrentEstimate );
-  m_ProjectionFilter->UpdateLargestPossibleRegion();
-  this->m_CurrentEstimate = m_ProjectionFilter->GetOutput();
-  this->m_CurrentEstimate->DisconnectPipeline();
+  ProjectionOperation projection;
+  projection.m_Buffer = this->m_CurrentEstimate->GetBufferPointer();
+  this->ParallelizeBufferOperation( this->m_CurrentEstimate->GetPixelContainer()->Size(),
+                                    projection );
+  this->m_CurrentEstimate->Modified();
 }
 
 } // end namespace itk
@@ -20,10 +20,6 @@
 
 #include "itkIterativeDeconvolutionImageFilter.h"
 
-#include "itkComplexConjugateImageAdaptor.h"
-#include "itkDivideOrZeroOutImageFilter.h"
-#include "itkMultiplyImageFilter.h"
-
 namespace itk
 {
 /** \class RichardsonLucyDeconvolutionImageFilter
@@ -40,6 +36,11 @@ namespace itk
  * follows a Poisson distribution and that the distribution for each
  * pixel is independent of the other pixels.
  *
+ * The forward and inverse Fourier transform filters and their buffers
+ * are created once before the first iteration and reused by all of
+ * them; the pointwise products and ratios are computed in place, so
+ * iterations do not allocate any image.
+ *
  * This code was adapted from the Insight Journal contribution:
  *
  * "Deconvolution: infrastructure and reference algorithms"
@@ -109,25 +110,74 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(RichardsonLucyDeconvolutionImageFilter);
 
-  /** Filters to compute each iterative update step. */
-  typedef MultiplyImageFilter< InternalImageType >                 MultiplyFilterType;
-  typedef MultiplyImageFilter< InternalComplexImageType >          ComplexMultiplyType;
-  typedef DivideOrZeroOutImageFilter< InternalImageType >          DivideFilterType;
-  typedef ComplexConjugateImageAdaptor< InternalComplexImageType > ConjugateAdaptorType;
-  typedef MultiplyImageFilter< InternalComplexImageType,
-                               ConjugateAdaptorType,
-                               InternalComplexImageType >          ComplexConjugateMultiplyType;
+  typedef typename InternalImageType::PixelType InternalPixelType;
+
+  /** Multiply a spectrum in place by the transfer function or by its
+   * complex conjugate.  The product is written out explicitly, which
+   * lets the compiler vectorize it and skips the special handling of
+   * infinities std::complex multiplication does. */
+  class ComplexMultiplyOperation
+  {
+  public:
+    void operator()(SizeValueType begin, SizeValueType end) const
+    {
+      const TInternalPrecision sign = m_Conjugate ? -1 : 1;
+      for ( SizeValueType i = begin; i < end; ++i )
+        {
+        const TInternalPrecision ar = m_Buffer[i].real();
+        const TInternalPrecision ai = m_Buffer[i].imag();
+        const TInternalPrecision br = m_Factor[i].real();
+        const TInternalPrecision bi = sign * m_Factor[i].imag();
+        m_Buffer[i] = InternalComplexType( ar * br - ai * bi, ar * bi + ai * br );
+        }
+    }
+
+    InternalComplexType *       m_Buffer;
+    const InternalComplexType * m_Factor;
+    bool                        m_Conjugate;
+  };
+
+  /** Replace the blurred estimate by the ratio of the input to it, or
+   * by zero where the blurred estimate is too small. */
+  class RatioOperation
+  {
+  public:
+    void operator()(SizeValueType begin, SizeValueType end) const
+    {
+      for ( SizeValueType i = begin; i < end; ++i )
+        {
+        m_Buffer[i] = ( m_Buffer[i] < m_Threshold ) ? 0 : m_Input[i] / m_Buffer[i];
+        }
+    }
+
+    InternalPixelType *       m_Buffer;
+    const InternalPixelType * m_Input;
+    InternalPixelType         m_Threshold;
+  };
+
+  /** Multiply the estimate in place by the correction factor. */
+  class MultiplyOperation
+  {
+  public:
+    void operator()(SizeValueType begin, SizeValueType end) const
+    {
+      for ( SizeValueType i = begin; i < end; ++i )
+        {
+        m_Buffer[i] *= m_Factor[i];
+        }
+    }
+
+    InternalPixelType *       m_Buffer;
+    const InternalPixelType * m_Factor;
+  };
 
   InternalImagePointerType m_PaddedInput;
 
-  typename ComplexMultiplyType::Pointer           m_ComplexMultiplyFilter1;
-  typename IFFTFilterType::Pointer                m_IFFTFilter1;
-  typename DivideFilterType::Pointer              m_DivideFilter;
-  typename FFTFilterType::Pointer                 m_FFTFilter;
-  typename ConjugateAdaptorType::Pointer          m_ConjugateAdaptor;
-  typename ComplexConjugateMultiplyType::Pointer  m_ComplexMultiplyFilter2;
-  typename IFFTFilterType::Pointer                m_IFFTFilter2;
-  typename MultiplyFilterType::Pointer            m_MultiplyFilter;
+  /** Resident filters for the two convolutions of each iteration. */
+  typename FFTFilterType::Pointer  m_FFTFilter1;
+  typename IFFTFilterType::Pointer m_IFFTFilter1;
+  typename FFTFilterType::Pointer  m_FFTFilter2;
+  typename IFFTFilterType::Pointer m_IFFTFilter2;
 };
 } // end namespace itk
 
@@ -49,94 +49,80 @@ RichardsonLucyDeconvolutionImageFilter< TInputImage, TKernelImage, TOutputImage,
   this->PadInput( this->GetInput(), m_PaddedInput, progress,
                   0.5f * progressWeight );
 
-  // Set up minipipeline to compute estimate at each iteration
-  m_ComplexMultiplyFilter1 = ComplexMultiplyType::New();
-  m_ComplexMultiplyFilter1->SetNumberOfThreads( this->GetNumberOfThreads() );
-  // Transformed estimate will be set as input 1 in Iteration()
-  m_ComplexMultiplyFilter1->SetInput2( this->m_TransferFunction );
-  m_ComplexMultiplyFilter1->InPlaceOn();
-  m_ComplexMultiplyFilter1->ReleaseDataFlagOn();
-  progress->RegisterInternalFilter( m_ComplexMultiplyFilter1,
-                                    0.07f * iterationProgressWeight );
+  // Each iteration blurs the estimate, divides the input by it and
+  // correlates the ratio with the kernel.  The transform filters are
+  // chained so that each one reads the buffer the previous step
+  // updated in place.
+  m_FFTFilter1 = FFTFilterType::New();
+  m_FFTFilter1->SetNumberOfThreads( this->GetNumberOfThreads() );
+  m_FFTFilter1->SetInput( this->m_CurrentEstimate );
+  progress->RegisterInternalFilter( m_FFTFilter1,
+                                    0.25f * iterationProgressWeight );
 
   m_IFFTFilter1 = IFFTFilterType::New();
   m_IFFTFilter1->SetNumberOfThreads( this->GetNumberOfThreads() );
   m_IFFTFilter1->SetActualXDimensionIsOdd( this->GetXDimensionIsOdd() );
-  m_IFFTFilter1->SetInput( m_ComplexMultiplyFilter1->GetOutput() );
-  m_IFFTFilter1->ReleaseDataFlagOn();
+  m_IFFTFilter1->SetInput( m_FFTFilter1->GetOutput() );
   progress->RegisterInternalFilter( m_IFFTFilter1,
-                                    0.2f * iterationProgressWeight );
-
-  m_DivideFilter = DivideFilterType::New();
-  m_DivideFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
-  m_DivideFilter->SetInput1( m_PaddedInput );
-  m_DivideFilter->SetInput2( m_IFFTFilter1->GetOutput() );
-  m_DivideFilter->InPlaceOn();
-  m_DivideFilter->SetCoordinateTolerance( NumericTraits< double >::max() );
-  m_DivideFilter->SetDirectionTolerance( NumericTraits< double >::max() );
-  progress->RegisterInternalFilter( m_DivideFilter,
-                                    0.1f * iterationProgressWeight );
-
-  m_FFTFilter = FFTFilterType::New();
-  m_FFTFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
-  m_FFTFilter->SetInput( m_DivideFilter->GetOutput() );
-  m_FFTFilter->ReleaseDataFlagOn();
-  progress->RegisterInternalFilter( m_FFTFilter,
-                                    0.2f * iterationProgressWeight );
-
-  m_ConjugateAdaptor = ConjugateAdaptorType::New();
-  m_ConjugateAdaptor->SetImage( this->m_TransferFunction );
-
-  m_ComplexMultiplyFilter2 = ComplexConjugateMultiplyType::New();
-  m_ComplexMultiplyFilter2->SetNumberOfThreads( this->GetNumberOfThreads() );
-  m_ComplexMultiplyFilter2->SetInput1( m_FFTFilter->GetOutput() );
-  m_ComplexMultiplyFilter2->SetInput2( m_ConjugateAdaptor );
-  m_ComplexMultiplyFilter2->ReleaseDataFlagOn();
-  progress->RegisterInternalFilter( m_ComplexMultiplyFilter2,
-                                    0.07f * iterationProgressWeight );
+                                    0.25f * iterationProgressWeight );
+
+  m_FFTFilter2 = FFTFilterType::New();
+  m_FFTFilter2->SetNumberOfThreads( this->GetNumberOfThreads() );
+  m_FFTFilter2->SetInput( m_IFFTFilter1->GetOutput() );
+  progress->RegisterInternalFilter( m_FFTFilter2,
+                                    0.25f * iterationProgressWeight );
 
   m_IFFTFilter2 = IFFTFilterType::New();
   m_IFFTFilter2->SetNumberOfThreads( this->GetNumberOfThreads() );
   m_IFFTFilter2->SetActualXDimensionIsOdd( this->GetXDimensionIsOdd() );
-  m_IFFTFilter2->SetInput( m_ComplexMultiplyFilter2->GetOutput() );
-  m_IFFTFilter2->ReleaseDataFlagOn();
+  m_IFFTFilter2->SetInput( m_FFTFilter2->GetOutput() );
   progress->RegisterInternalFilter( m_IFFTFilter2,
-                                    0.2f * iterationProgressWeight );
-
-  m_MultiplyFilter = MultiplyFilterType::New();
-  m_MultiplyFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
-  // Current estimate will be set as input 1 in Iteration()
-  m_MultiplyFilter->SetInput2( m_IFFTFilter2->GetOutput() );
-  m_MultiplyFilter->InPlaceOn();
-  m_MultiplyFilter->ReleaseDataFlagOn();
-  m_MultiplyFilter->SetCoordinateTolerance( NumericTraits< double >::max() );
-  m_MultiplyFilter->SetDirectionTolerance( NumericTraits< double >::max() );
-  progress->RegisterInternalFilter( m_MultiplyFilter,
-                                    0.06f * iterationProgressWeight );
-
+                                    0.25f * iterationProgressWeight );
 }
 
 template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
 void
 RichardsonLucyDeconvolutionImageFilter< TInputImage, TKernelImage, TOutputImage, TInternalPrecision >
-::Iteration(ProgressAccumulator * progress, float iterationProgressWeight)
+::Iteration(ProgressAccumulator * itkNotUsed(progress), float itkNotUsed(iterationProgressWeight))
 {
-  // Set up minipipeline to compute the new estimate
-  InternalComplexImagePointerType transformedEstimate;
-  this->TransformPaddedInput( this->m_CurrentEstimate,
-                              transformedEstimate, progress,
-                              0.1f * iterationProgressWeight );
-
-  // Set the inputs
-  m_ComplexMultiplyFilter1->SetInput1( transformedEstimate );
-  m_MultiplyFilter->SetInput1( this->m_CurrentEstimate );
-
-  // Trigger the update
-  m_MultiplyFilter->UpdateLargestPossibleRegion();
-
-  // Store the current estimate
-  this->m_CurrentEstimate = m_MultiplyFilter->GetOutput();
-  this->m_CurrentEstimate->DisconnectPipeline();
+  const SizeValueType numberOfPixels =
+    this->m_CurrentEstimate->GetPixelContainer()->Size();
+  const SizeValueType numberOfFrequencies =
+    this->m_TransferFunction->GetPixelContainer()->Size();
+
+  // Blur the current estimate.
+  m_FFTFilter1->SetInput( this->m_CurrentEstimate );
+  this->UpdateResidentFilter( m_FFTFilter1.GetPointer() );
+
+  ComplexMultiplyOperation blur;
+  blur.m_Buffer = m_FFTFilter1->GetOutput()->GetBufferPointer();
+  blur.m_Factor = this->m_TransferFunction->GetBufferPointer();
+  blur.m_Conjugate = false;
+  this->ParallelizeBufferOperation( numberOfFrequencies, blur );
+  this->UpdateResidentFilter( m_IFFTFilter1.GetPointer() );
+
+  // Ratio of the input to the blurred estimate.
+  RatioOperation ratio;
+  ratio.m_Buffer = m_IFFTFilter1->GetOutput()->GetBufferPointer();
+  ratio.m_Input = m_PaddedInput->GetBufferPointer();
+  ratio.m_Threshold = static_cast< InternalPixelType >( 1e-5 );
+  this->ParallelizeBufferOperation( numberOfPixels, ratio );
+  this->UpdateResidentFilter( m_FFTFilter2.GetPointer() );
+
+  // Correlate the ratio with the kernel.
+  ComplexMultiplyOperation correlate;
+  correlate.m_Buffer = m_FFTFilter2->GetOutput()->GetBufferPointer();
+  correlate.m_Factor = this->m_TransferFunction->GetBufferPointer();
+  correlate.m_Conjugate = true;
+  this->ParallelizeBufferOperation( numberOfFrequencies, correlate );
+  this->UpdateResidentFilter( m_IFFTFilter2.GetPointer() );
+
+  // Update the estimate in place.
+  MultiplyOperation update;
+  update.m_Buffer = this->m_CurrentEstimate->GetBufferPointer();
+  update.m_Factor = m_IFFTFilter2->GetOutput()->GetBufferPointer();
+  this->ParallelizeBufferOperation( numberOfPixels, update );
+  this->m_CurrentEstimate->Modified();
 }
 
 template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
@@ -146,14 +132,11 @@ RichardsonLucyDeconvolutionImageFilter< TInputImage, TKernelImage, TOutputImage,
 {
   this->Superclass::Finish( progress, progressWeight );
 
-  m_ComplexMultiplyFilter1 = ITK_NULLPTR;
+  m_PaddedInput = ITK_NULLPTR;
+  m_FFTFilter1 = ITK_NULLPTR;
   m_IFFTFilter1 = ITK_NULLPTR;
-  m_DivideFilter = ITK_NULLPTR;
-  m_FFTFilter = ITK_NULLPTR;
-  m_ConjugateAdaptor = ITK_NULLPTR;
-  m_ComplexMultiplyFilter2 = ITK_NULLPTR;
+  m_FFTFilter2 = ITK_NULLPTR;
   m_IFFTFilter2 = ITK_NULLPTR;
-  m_MultiplyFilter = ITK_NULLPTR;
 }
 
 template< typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision >
@@ -0,0 +1,166 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFFTWGlobalConfiguration.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreader.h"
+#include "itkRichardsonLucyDeconvolutionImageFilter.h"
+#include "itkTimeProbe.h"
+#include "itkTestingMacros.h"
+#include "itksys/SystemTools.hxx"
+
+// Time Richardson-Lucy iterations with and without the FFTW plan
+// cache.  Every iteration runs a forward and an inverse FFT filter;
+// without the cache each of them has to plan its transform again.
+// With a wisdom file, the transforms are measured and the wisdom must
+// be written as soon as the plans are cached.
+namespace
+{
+#if defined( ITK_USE_FFTWD )
+typedef double PixelType;
+#else
+typedef float  PixelType;
+#endif
+const unsigned int                         Dimension = 2;
+typedef itk::Image< PixelType, Dimension > ImageType;
+typedef itk::RichardsonLucyDeconvolutionImageFilter< ImageType > DeconvolutionFilterType;
+
+ImageType::Pointer
+MakeImage(unsigned int size, unsigned int period)
+{
+  ImageType::SizeType imageSize;
+  imageSize.Fill(size);
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(imageSize);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType idx = it.GetIndex();
+    it.Set( ( ( idx[0] / period + idx[1] / period ) % 2 ) ? 10.0 : 1.0 );
+    }
+  return image;
+}
+
+ImageType::Pointer
+Deconvolve(const ImageType * input, const ImageType * kernel,
+           unsigned int iterations, double & secondsPerIteration)
+{
+  DeconvolutionFilterType::Pointer filter = DeconvolutionFilterType::New();
+  filter->SetInput(input);
+  filter->SetKernelImage(kernel);
+  filter->NormalizeOn();
+  filter->SetNumberOfIterations(iterations);
+
+  itk::TimeProbe probe;
+  probe.Start();
+  filter->Update();
+  probe.Stop();
+  secondsPerIteration = probe.GetTotal() / iterations;
+
+  ImageType::Pointer output = filter->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+}
+
+int itkFFTWPlanCacheDeconvolutionTest(int argc, char* argv[])
+{
+  unsigned int size = 64;
+  unsigned int iterations = 20;
+  if ( argc > 1 )
+    {
+    size = static_cast< unsigned int >( atoi( argv[1] ) );
+    }
+  if ( argc > 2 )
+    {
+    iterations = static_cast< unsigned int >( atoi( argv[2] ) );
+    }
+  if ( argc > 3 )
+    {
+    itk::MultiThreader::SetGlobalDefaultNumberOfThreads( atoi( argv[3] ) );
+    }
+  std::string wisdomFile;
+  if ( argc > 4 )
+    {
+    wisdomFile = argv[4];
+    itksys::SystemTools::RemoveFile( wisdomFile );
+    itk::FFTWGlobalConfiguration::SetPlanRigor( FFTW_MEASURE );
+    itk::FFTWGlobalConfiguration::SetWriteWisdomCache( true );
+    itk::FFTWGlobalConfiguration::SetWisdomFilenameGenerator(
+      new itk::ManualWisdomFilenameGenerator( wisdomFile ) );
+    }
+
+  ImageType::Pointer input = MakeImage( size, 8 );
+  ImageType::Pointer kernel = MakeImage( 5, 5 );
+
+  const itk::SizeValueType defaultCacheSize =
+    itk::FFTWGlobalConfiguration::GetMaximumNumberOfCachedPlans();
+
+  // Without the cache.  Plans still come from the wisdom FFTW keeps, so
+  // this measures the planning overhead each filter call pays.
+  itk::FFTWGlobalConfiguration::SetMaximumNumberOfCachedPlans(0);
+  TEST_EXPECT_EQUAL( itk::FFTWGlobalConfiguration::GetNumberOfCachedPlans(), 0u );
+  double uncachedTime = 0.0;
+  ImageType::Pointer uncached = Deconvolve( input, kernel, iterations, uncachedTime );
+  TEST_EXPECT_EQUAL( itk::FFTWGlobalConfiguration::GetNumberOfCachedPlans(), 0u );
+
+  // With the cache.  The first run fills it, the second only reuses plans.
+  itk::FFTWGlobalConfiguration::SetMaximumNumberOfCachedPlans(defaultCacheSize);
+  double warmupTime = 0.0;
+  Deconvolve( input, kernel, iterations, warmupTime );
+  const itk::SizeValueType numberOfPlans = itk::FFTWGlobalConfiguration::GetNumberOfCachedPlans();
+  TEST_EXPECT_TRUE( numberOfPlans > 0 );
+  if ( !wisdomFile.empty() )
+    {
+    TEST_EXPECT_TRUE( itksys::SystemTools::FileLength( wisdomFile ) > 0 );
+    }
+  double cachedTime = 0.0;
+  ImageType::Pointer cached = Deconvolve( input, kernel, iterations, cachedTime );
+  TEST_EXPECT_EQUAL( itk::FFTWGlobalConfiguration::GetNumberOfCachedPlans(), numberOfPlans );
+
+  std::cout << "Image size: " << size << "x" << size
+            << ", iterations: " << iterations
+            << ", threads: " << itk::MultiThreader::GetGlobalDefaultNumberOfThreads()
+            << ", plan rigor: " << itk::FFTWGlobalConfiguration::GetPlanRigorName(
+                 itk::FFTWGlobalConfiguration::GetPlanRigor() ) << std::endl;
+  std::cout << "Cached plans: " << numberOfPlans << std::endl;
+  std::cout << "Seconds per iteration without plan cache: " << uncachedTime << std::endl;
+  std::cout << "Seconds per iteration with plan cache:    " << cachedTime << std::endl;
+
+  // FFTW may pick a different algorithm when it plans again, so allow
+  // for rounding differences.
+  itk::ImageRegionConstIterator< ImageType > uit( uncached, uncached->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< ImageType > cit( cached, cached->GetLargestPossibleRegion() );
+  for ( ; !uit.IsAtEnd(); ++uit, ++cit )
+    {
+    if ( std::abs( uit.Get() - cit.Get() ) > 1e-4 * ( 1.0 + std::abs( uit.Get() ) ) )
+      {
+      std::cerr << "Cached and uncached results differ: " << cit.Get()
+                << " != " << uit.Get() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  itk::FFTWGlobalConfiguration::ClearPlanCache();
+  TEST_EXPECT_EQUAL( itk::FFTWGlobalConfiguration::GetNumberOfCachedPlans(), 0u );
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
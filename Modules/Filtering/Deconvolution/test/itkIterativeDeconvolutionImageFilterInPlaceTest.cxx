@@ -0,0 +1,194 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkCommand.h"
+#include "itkFFTConvolutionImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkLandweberDeconvolutionImageFilter.h"
+#include "itkProjectedLandweberDeconvolutionImageFilter.h"
+#include "itkRichardsonLucyDeconvolutionImageFilter.h"
+#include "itkTestingMacros.h"
+
+// Check that the iterative deconvolution filters update their
+// estimate in place, and that the results are sensible.
+namespace
+{
+typedef itk::Image< float, 2 > ImageType;
+
+// Record whether the buffer of the estimate moves between iterations.
+template< typename TFilter >
+class EstimateBufferCommand : public itk::Command
+{
+public:
+  typedef EstimateBufferCommand     Self;
+  typedef itk::Command              Superclass;
+  typedef itk::SmartPointer< Self > Pointer;
+  itkNewMacro( Self );
+
+  virtual void Execute(itk::Object *caller, const itk::EventObject & event) ITK_OVERRIDE
+  {
+    this->Execute( (const itk::Object *)caller, event );
+  }
+
+  virtual void Execute(const itk::Object *object, const itk::EventObject & event) ITK_OVERRIDE
+  {
+    if ( !itk::IterationEvent().CheckEvent( &event ) )
+      {
+      return;
+      }
+    const TFilter * filter = static_cast< const TFilter * >( object );
+    const void * buffer = filter->GetCurrentEstimate()->GetBufferPointer();
+    if ( m_NumberOfIterations > 0 && buffer != m_Buffer )
+      {
+      m_BufferChanged = true;
+      }
+    m_Buffer = buffer;
+    ++m_NumberOfIterations;
+  }
+
+  unsigned int m_NumberOfIterations;
+  bool         m_BufferChanged;
+
+protected:
+  EstimateBufferCommand() :
+    m_NumberOfIterations( 0 ),
+    m_BufferChanged( false ),
+    m_Buffer( ITK_NULLPTR )
+  {}
+
+private:
+  const void * m_Buffer;
+};
+
+template< typename TFilter >
+bool
+TestDeconvolution(TFilter * filter, const ImageType * blurred, const ImageType * kernel,
+                  unsigned int iterations, bool nonNegative)
+{
+  typedef EstimateBufferCommand< TFilter > CommandType;
+  typename CommandType::Pointer command = CommandType::New();
+  filter->AddObserver( itk::IterationEvent(), command );
+  filter->SetInput( blurred );
+  filter->SetKernelImage( kernel );
+  filter->NormalizeOn();
+  filter->SetNumberOfIterations( iterations );
+  filter->Update();
+
+  std::cout << filter->GetNameOfClass() << ": " << command->m_NumberOfIterations
+            << " iterations" << std::endl;
+  if ( command->m_NumberOfIterations != iterations )
+    {
+    std::cerr << "Expected " << iterations << " iterations" << std::endl;
+    return false;
+    }
+  if ( command->m_BufferChanged )
+    {
+    std::cerr << "The estimate was reallocated during the iterations" << std::endl;
+    return false;
+    }
+
+  // The blurred input is positive and the kernel is normalized: the
+  // estimate must keep about the same total intensity.
+  double blurredSum = 0.0;
+  double outputSum = 0.0;
+  itk::ImageRegionConstIterator< ImageType > bit( blurred, blurred->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< ImageType > oit( filter->GetOutput(),
+                                                  filter->GetOutput()->GetLargestPossibleRegion() );
+  for ( ; !bit.IsAtEnd(); ++bit, ++oit )
+    {
+    if ( !itk::Math::isfinite( oit.Get() ) || ( nonNegative && oit.Get() < 0 ) )
+      {
+      std::cerr << "Unexpected value " << oit.Get() << " at " << oit.GetIndex() << std::endl;
+      return false;
+      }
+    blurredSum += bit.Get();
+    outputSum += oit.Get();
+    }
+  if ( std::abs( outputSum - blurredSum ) > 0.05 * blurredSum )
+    {
+    std::cerr << "Total intensity changed from " << blurredSum << " to " << outputSum << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+int itkIterativeDeconvolutionImageFilterInPlaceTest(int, char* [])
+{
+  ImageType::SizeType size;
+  size[0] = 64;
+  size[1] = 57;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType idx = it.GetIndex();
+    it.Set( ( ( idx[0] / 8 + idx[1] / 6 ) % 2 ) ? 10.0f : 1.0f );
+    }
+
+  ImageType::SizeType kernelSize;
+  kernelSize.Fill( 7 );
+  ImageType::Pointer kernel = ImageType::New();
+  kernel->SetRegions( kernelSize );
+  kernel->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > kit( kernel, kernel->GetLargestPossibleRegion() );
+  for ( kit.GoToBegin(); !kit.IsAtEnd(); ++kit )
+    {
+    const ImageType::IndexType idx = kit.GetIndex();
+    const double r2 = ( idx[0] - 3 ) * ( idx[0] - 3 ) + ( idx[1] - 3 ) * ( idx[1] - 3 );
+    kit.Set( static_cast< float >( std::exp( -r2 / 4.0 ) ) );
+    }
+
+  typedef itk::FFTConvolutionImageFilter< ImageType > ConvolutionFilterType;
+  ConvolutionFilterType::Pointer convolution = ConvolutionFilterType::New();
+  convolution->SetInput( image );
+  convolution->SetKernelImage( kernel );
+  convolution->NormalizeOn();
+  TRY_EXPECT_NO_EXCEPTION( convolution->Update() );
+
+  bool success = true;
+
+  typedef itk::RichardsonLucyDeconvolutionImageFilter< ImageType > RichardsonLucyType;
+  RichardsonLucyType::Pointer richardsonLucy = RichardsonLucyType::New();
+  success &= TestDeconvolution< RichardsonLucyType >( richardsonLucy, convolution->GetOutput(),
+                                                      kernel, 20, true );
+
+  typedef itk::LandweberDeconvolutionImageFilter< ImageType > LandweberType;
+  LandweberType::Pointer landweber = LandweberType::New();
+  landweber->SetAlpha( 0.5 );
+  success &= TestDeconvolution< LandweberType >( landweber, convolution->GetOutput(),
+                                                 kernel, 20, false );
+
+  typedef itk::ProjectedLandweberDeconvolutionImageFilter< ImageType > ProjectedLandweberType;
+  ProjectedLandweberType::Pointer projectedLandweber = ProjectedLandweberType::New();
+  projectedLandweber->SetAlpha( 0.5 );
+  success &= TestDeconvolution< ProjectedLandweberType >( projectedLandweber, convolution->GetOutput(),
+                                                          kernel, 20, true );
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
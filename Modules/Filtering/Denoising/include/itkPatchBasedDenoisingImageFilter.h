@@ -183,6 +183,22 @@ public:
   itkBooleanMacro(UseFastTensorComputations);
   itkGetConstMacro(UseFastTensorComputations, bool);
 
+  /** Set/Get flag indicating whether patch distances may be computed one search offset at a time.
+   *
+   *  When this flag is true (default) or On, the pixels are scalar and the sampler is a
+   *  SpatialNeighborSubsampler (not one of its random subclasses), the smoothing update visits
+   *  every offset of the search window once per block of the image.  The squared differences
+   *  between the block and its shifted copy are weighted and summed over the patch extent for the
+   *  whole block.  With uniform patch weights (UseSmoothDiscPatchWeights Off) the sums are running
+   *  (integral) sums along each axis, so that the distances of all patch pairs at that offset cost
+   *  a few operations per pixel instead of one operation per patch pixel.  The result matches the
+   *  patch-by-patch computation up to rounding.  Other configurations always use the
+   *  patch-by-patch computation.
+   */
+  itkSetMacro(UseFastPatchDistances, bool);
+  itkBooleanMacro(UseFastPatchDistances);
+  itkGetConstMacro(UseFastPatchDistances, bool);
+
   /** Maximum number of Newton-Raphson iterations for sigma update. */
   itkStaticConstMacro(MaxSigmaUpdateIterations, unsigned int,
                       20);
@@ -417,6 +433,20 @@ protected:
                                                BaseSamplerPointer& sampler,
                                                ThreadDataStruct& threadData);
 
+  /** Compute the gradient of the joint entropy for every pixel of the region, block by block,
+   * one search offset at a time.  Only valid when CanUseFastPatchDistances() returns true. */
+  void ComputeGradientJointEntropyInBlocks(const InputImageRegionType& regionToProcess,
+                                           std::vector<RealType>& gradients,
+                                           mpl::TrueType isScalar);
+  void ComputeGradientJointEntropyInBlocks(const InputImageRegionType& itkNotUsed(regionToProcess),
+                                           std::vector<RealType>& itkNotUsed(gradients),
+                                           mpl::FalseType itkNotUsed(isScalar))
+  {
+  }
+
+  /** Check whether the current settings allow ComputeGradientJointEntropyInBlocks(). */
+  bool CanUseFastPatchDistances() const;
+
   virtual void ApplyUpdate() ITK_OVERRIDE;
 
   virtual void ThreadedApplyUpdate(const InputImageRegionType& regionToProcess,
@@ -513,6 +543,7 @@ private:
   bool m_UseSmoothDiscPatchWeights;
 
   bool m_UseFastTensorComputations;
+  bool m_UseFastPatchDistances;
 
   RealArrayType  m_KernelBandwidthSigma;
   bool           m_KernelBandwidthSigmaIsSet;
@@ -29,6 +29,7 @@
 #include "itkImageAlgorithm.h"
 #include "itkVectorImageToImageAdaptor.h"
 #include "itkSpatialNeighborSubsampler.h"
+#include "itkUniformRandomSpatialNeighborSubsampler.h"
 #include "itkMacro.h"
 #include "itkMath.h"
 
@@ -44,6 +45,7 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
   m_TotalNumberPixels( 0 ),        // not valid until an image is provided
   m_UseSmoothDiscPatchWeights( true ),
   m_UseFastTensorComputations( true ),
+  m_UseFastPatchDistances( true ),
   m_KernelBandwidthSigmaIsSet( false ),
   m_ZeroPixel(),                 // not valid until Initialize()
   m_KernelBandwidthFractionPixelsForEstimation( 0.20 ),
@@ -2084,6 +2086,24 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
 
   ProgressReporter progress(this, threadId, regionToProcess.GetNumberOfPixels() );
 
+  // When the patch distances can be computed for a whole block at a time,
+  // compute the smoothing update of every pixel in the region up front.
+  const double smoothingWeight = this->GetSmoothingWeight();
+  const bool   useBlockGradients = smoothingWeight > 0 && this->CanUseFastPatchDistances();
+
+  std::vector<RealType> blockGradients;
+  OffsetValueType       regionOffsetTable[OutputImageType::ImageDimension];
+  if( useBlockGradients )
+    {
+    this->ComputeGradientJointEntropyInBlocks( regionToProcess, blockGradients,
+                                               IsSame<PixelType, PixelValueType>() );
+    regionOffsetTable[0] = 1;
+    for( unsigned int dim = 1; dim < OutputImageType::ImageDimension; ++dim )
+      {
+      regionOffsetTable[dim] = regionOffsetTable[dim - 1] * regionToProcess.GetSize(dim - 1);
+      }
+    }
+
   // Break the input into a series of regions.  The first region is free
   // of boundary conditions, the rest with boundary conditions.  We operate
   // on the output region because input has been copied to output
@@ -2122,13 +2142,26 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
       {
       RealType result = outputIt.Get();
 
-      const double smoothingWeight = this->GetSmoothingWeight();
       if( smoothingWeight > 0 )
         {
         // Get intensity update driven by patch-based denoiser
-        const RealType gradientJointEntropy =
-          this->ComputeGradientJointEntropy(sampleIt.GetInstanceIdentifier(), inList, sampler,
-          threadData);
+        RealType gradientJointEntropy;
+        if( useBlockGradients )
+          {
+          const typename OutputImageType::IndexType index = outputIt.GetIndex();
+          OffsetValueType offset = 0;
+          for( unsigned int dim = 0; dim < OutputImageType::ImageDimension; ++dim )
+            {
+            offset += ( index[dim] - regionToProcess.GetIndex(dim) ) * regionOffsetTable[dim];
+            }
+          gradientJointEntropy = blockGradients[offset];
+          }
+        else
+          {
+          gradientJointEntropy =
+            this->ComputeGradientJointEntropy(sampleIt.GetInstanceIdentifier(), inList, sampler,
+            threadData);
+          }
 
         const RealValueType stepSizeSmoothing = 0.2;
         result = AddUpdate(result,  gradientJointEntropy * (smoothingWeight * stepSizeSmoothing) );
@@ -2478,6 +2511,346 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
   return gradientJointEntropy;
 }
 
+template <typename TInputImage, typename TOutputImage>
+bool
+PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
+::CanUseFastPatchDistances() const
+{
+  if( !m_UseFastPatchDistances
+      || !IsSame<PixelType, PixelValueType>::Value
+      || m_NumPixelComponents != 1
+      || this->GetComponentSpace() != Superclass::EUCLIDEAN )
+    {
+    return false;
+    }
+
+  // Only a sampler that selects every patch of the search window can be
+  // replaced by a sweep over the offsets of the window. The random
+  // subsamplers derived from SpatialNeighborSubsampler select subsets and
+  // do not qualify.
+  typedef Statistics::SpatialNeighborSubsampler< PatchSampleType, InputImageRegionType >
+    SamplerType;
+  typedef Statistics::UniformRandomSpatialNeighborSubsampler< PatchSampleType, InputImageRegionType >
+    RandomSamplerType;
+  if( dynamic_cast<const SamplerType *>( m_Sampler.GetPointer() ) == ITK_NULLPTR
+      || dynamic_cast<const RandomSamplerType *>( m_Sampler.GetPointer() ) != ITK_NULLPTR )
+    {
+    return false;
+    }
+
+  return this->m_OutputImage->GetBufferedRegion() == this->m_OutputImage->GetLargestPossibleRegion();
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
+::ComputeGradientJointEntropyInBlocks(const InputImageRegionType &regionToProcess,
+                                      std::vector<RealType> &gradients,
+                                      mpl::TrueType itkNotUsed(isScalar))
+{
+  // For each block of the region and each offset of the search window, the
+  // squared differences between the image and its shifted copy are summed
+  // over the patch extent with running sums along each axis. This gives the
+  // distance between every patch of the block and its neighbor at that
+  // offset, exactly as ComputeGradientJointEntropy() would compute it.
+  typedef typename OutputImageType::IndexType  IndexType;
+  typedef typename OutputImageType::SizeType   SizeType;
+  typedef typename OutputImageType::OffsetType OffsetType;
+  typedef itk::Statistics::SpatialNeighborSubsampler< PatchSampleType, InputImageRegionType >
+    SamplerType;
+
+  const unsigned int Dimension = OutputImageType::ImageDimension;
+
+  const OutputImageType *     output = this->m_OutputImage;
+  const InputImageRegionType  imageRegion = output->GetBufferedRegion();
+  const IndexType             imageIndex = imageRegion.GetIndex();
+  const SizeType              imageSize = imageRegion.GetSize();
+  const OffsetValueType *     imageOffsetTable = output->GetOffsetTable();
+  const PixelType *           buffer = output->GetBufferPointer();
+
+  const PatchRadiusType patchRadius = this->GetPatchRadiusInVoxels();
+  const typename SamplerType::RadiusType searchRadius =
+    static_cast<const SamplerType *>( m_Sampler.GetPointer() )->GetRadius();
+
+  // A uniform patch weight enters each squared norm as a constant factor,
+  // and the squared differences are summed with running sums. Other
+  // weights, such as the smooth disc weights, are applied one patch pixel
+  // at a time.
+  const PatchWeightsType patchWeights = this->GetPatchWeights();
+  bool                   uniformWeights = true;
+  for( unsigned int jj = 1; jj < patchWeights.GetSize(); ++jj )
+    {
+    if( Math::NotExactlyEquals( patchWeights[jj], patchWeights[0] ) )
+      {
+      uniformWeights = false;
+      }
+    }
+  const double patchWeight = uniformWeights ? patchWeights[0] : 1.0;
+  const double kernelSigma = m_KernelBandwidthSigma[0];
+  const double distanceScale = patchWeight * patchWeight / ( 2.0 * kernelSigma * kernelSigma );
+
+  gradients.assign( regionToProcess.GetNumberOfPixels(), NumericTraits<RealType>::ZeroValue() );
+
+  // Blocks of about 32k pixels keep the per-offset buffers in cache.
+  const SizeValueType blockLength = 1u << ( 15 / Dimension );
+  SizeType      numberOfBlocks;
+  SizeValueType totalBlocks = 1;
+  SizeValueType numberOfShifts = 1;
+  for( unsigned int dim = 0; dim < Dimension; ++dim )
+    {
+    numberOfBlocks[dim] = ( regionToProcess.GetSize(dim) + blockLength - 1 ) / blockLength;
+    totalBlocks *= numberOfBlocks[dim];
+    numberOfShifts *= 2 * searchRadius[dim] + 1;
+    }
+
+  std::vector<double> numerators;
+  std::vector<double> denominators;
+  std::vector<double> distances;
+  std::vector<double> runningSum;
+  std::vector<double> weightedSums;
+
+  for( SizeValueType blockId = 0; blockId < totalBlocks; ++blockId )
+    {
+    InputImageRegionType block;
+    SizeValueType        remainder = blockId;
+    for( unsigned int dim = 0; dim < Dimension; ++dim )
+      {
+      const SizeValueType position = remainder % numberOfBlocks[dim];
+      remainder /= numberOfBlocks[dim];
+      block.SetIndex( dim, regionToProcess.GetIndex(dim) + position * blockLength );
+      block.SetSize( dim,
+                     std::min( blockLength, regionToProcess.GetSize(dim) - position * blockLength ) );
+      }
+
+    numerators.assign( block.GetNumberOfPixels(), 0.0 );
+    denominators.assign( block.GetNumberOfPixels(), 0.0 );
+
+    for( SizeValueType shiftId = 0; shiftId < numberOfShifts; ++shiftId )
+      {
+      OffsetType shift;
+      remainder = shiftId;
+      for( unsigned int dim = 0; dim < Dimension; ++dim )
+        {
+        shift[dim] = static_cast<OffsetValueType>( remainder % ( 2 * searchRadius[dim] + 1 ) )
+          - static_cast<OffsetValueType>( searchRadius[dim] );
+        remainder /= 2 * searchRadius[dim] + 1;
+        }
+
+      // ComputeGradientJointEntropy() only selects neighbors whose patch is
+      // at least as far inside the image as the patch being denoised. Along
+      // each axis this keeps an interval of the block.
+      InputImageRegionType valid;
+      bool                 isEmpty = false;
+      OffsetValueType      shiftOffset = 0;
+      for( unsigned int dim = 0; dim < Dimension; ++dim )
+        {
+        IndexValueType first = block.GetIndex(dim);
+        IndexValueType last = first + static_cast<IndexValueType>( block.GetSize(dim) ) - 1;
+        if( shift[dim] < 0 )
+          {
+          first = std::max( first, imageIndex[dim]
+                            + static_cast<IndexValueType>( patchRadius[dim] ) - shift[dim] );
+          }
+        else if( shift[dim] > 0 )
+          {
+          last = std::min( last, imageIndex[dim] + static_cast<IndexValueType>( imageSize[dim] )
+                           - 1 - static_cast<IndexValueType>( patchRadius[dim] ) - shift[dim] );
+          }
+        if( last < first )
+          {
+          isEmpty = true;
+          break;
+          }
+        valid.SetIndex( dim, first );
+        valid.SetSize( dim, static_cast<SizeValueType>( last - first + 1 ) );
+        shiftOffset += shift[dim] * imageOffsetTable[dim];
+        }
+      if( isEmpty )
+        {
+        continue;
+        }
+
+      // Squared differences over the patches of the valid pixels. Wherever a
+      // patch pixel is inside the image, so is its shifted counterpart. The
+      // running sums clip the patches at the image boundary; the weighted
+      // sums see zero differences outside the image instead.
+      InputImageRegionType padded = valid;
+      padded.PadByRadius( patchRadius );
+      InputImageRegionType inside = padded;
+      inside.Crop( imageRegion );
+      if( uniformWeights )
+        {
+        padded = inside;
+        }
+
+      const SizeValueType paddedPixels = padded.GetNumberOfPixels();
+      const SizeValueType paddedLength = padded.GetSize(0);
+      const SizeValueType insideLength = inside.GetSize(0);
+      distances.assign( paddedPixels, 0.0 );
+      for( SizeValueType line = 0; line < inside.GetNumberOfPixels() / insideLength; ++line )
+        {
+        OffsetValueType imageOffset = inside.GetIndex(0) - imageIndex[0];
+        OffsetValueType paddedOffset = inside.GetIndex(0) - padded.GetIndex(0);
+        OffsetValueType paddedStride = paddedLength;
+        remainder = line;
+        for( unsigned int dim = 1; dim < Dimension; ++dim )
+          {
+          const IndexValueType position =
+            inside.GetIndex(dim) + static_cast<IndexValueType>( remainder % inside.GetSize(dim) );
+          remainder /= inside.GetSize(dim);
+          imageOffset += ( position - imageIndex[dim] ) * imageOffsetTable[dim];
+          paddedOffset += ( position - padded.GetIndex(dim) ) * paddedStride;
+          paddedStride *= padded.GetSize(dim);
+          }
+        const PixelType * current = buffer + imageOffset;
+        const PixelType * shifted = current + shiftOffset;
+        double *          out = &distances[paddedOffset];
+        for( SizeValueType ii = 0; ii < insideLength; ++ii )
+          {
+          const double diff = static_cast<double>( shifted[ii] ) - static_cast<double>( current[ii] );
+          out[ii] = diff * diff;
+          }
+        }
+
+      const SizeValueType validLength = valid.GetSize(0);
+      if( !uniformWeights )
+        {
+        // Add the squared differences of each patch pixel, weighted by its
+        // squared patch weight, to the distances of the valid pixels.
+        weightedSums.assign( paddedPixels, 0.0 );
+        for( SizeValueType line = 0; line < valid.GetNumberOfPixels() / validLength; ++line )
+          {
+          OffsetValueType paddedOffset = valid.GetIndex(0) - padded.GetIndex(0);
+          OffsetValueType paddedStride = paddedLength;
+          remainder = line;
+          for( unsigned int dim = 1; dim < Dimension; ++dim )
+            {
+            const IndexValueType position =
+              valid.GetIndex(dim) + static_cast<IndexValueType>( remainder % valid.GetSize(dim) );
+            remainder /= valid.GetSize(dim);
+            paddedOffset += ( position - padded.GetIndex(dim) ) * paddedStride;
+            paddedStride *= padded.GetSize(dim);
+            }
+          double * out = &weightedSums[paddedOffset];
+          for( unsigned int jj = 0; jj < patchWeights.GetSize(); ++jj )
+            {
+            const double weight = patchWeights[jj];
+            if( weight == 0.0 )
+              {
+              continue;
+              }
+            OffsetValueType patchOffset = 0;
+            OffsetValueType patchStride = 1;
+            SizeValueType   patchRemainder = jj;
+            for( unsigned int dim = 0; dim < Dimension; ++dim )
+              {
+              const SizeValueType diameter = 2 * patchRadius[dim] + 1;
+              patchOffset += ( static_cast<OffsetValueType>( patchRemainder % diameter )
+                               - static_cast<OffsetValueType>( patchRadius[dim] ) ) * patchStride;
+              patchRemainder /= diameter;
+              patchStride *= padded.GetSize(dim);
+              }
+            const double   squaredWeight = weight * weight;
+            const double * in = &distances[paddedOffset + patchOffset];
+            for( SizeValueType ii = 0; ii < validLength; ++ii )
+              {
+              out[ii] += squaredWeight * in[ii];
+              }
+            }
+          }
+        distances.swap( weightedSums );
+        }
+
+      // Sum over the patch extent, one axis at a time, clipping the patch at
+      // the image boundary.
+      OffsetValueType stride = 1;
+      for( unsigned int dim = 0; dim < Dimension && uniformWeights; ++dim )
+        {
+        const SizeValueType  length = padded.GetSize(dim);
+        const SizeValueType  radius = patchRadius[dim];
+        const SizeValueType  numberOfOuter = paddedPixels / ( length * stride );
+        runningSum.resize( length + 1 );
+        for( SizeValueType outer = 0; outer < numberOfOuter && radius > 0; ++outer )
+          {
+          for( OffsetValueType inner = 0; inner < stride; ++inner )
+            {
+            double * line = &distances[outer * length * stride + inner];
+            runningSum[0] = 0.0;
+            for( SizeValueType ii = 0; ii < length; ++ii )
+              {
+              runningSum[ii + 1] = runningSum[ii] + line[ii * stride];
+              }
+            for( SizeValueType ii = 0; ii < length; ++ii )
+              {
+              const SizeValueType lower = ii > radius ? ii - radius : 0;
+              const SizeValueType upper = std::min( ii + radius + 1, length );
+              line[ii * stride] = runningSum[upper] - runningSum[lower];
+              }
+            }
+          }
+        stride *= length;
+        }
+
+      // Accumulate the kernel-weighted differences of the center pixels.
+      for( SizeValueType line = 0; line < valid.GetNumberOfPixels() / validLength; ++line )
+        {
+        OffsetValueType imageOffset = valid.GetIndex(0) - imageIndex[0];
+        OffsetValueType paddedOffset = valid.GetIndex(0) - padded.GetIndex(0);
+        OffsetValueType blockOffset = valid.GetIndex(0) - block.GetIndex(0);
+        OffsetValueType paddedStride = paddedLength;
+        OffsetValueType blockStride = block.GetSize(0);
+        remainder = line;
+        for( unsigned int dim = 1; dim < Dimension; ++dim )
+          {
+          const IndexValueType position =
+            valid.GetIndex(dim) + static_cast<IndexValueType>( remainder % valid.GetSize(dim) );
+          remainder /= valid.GetSize(dim);
+          imageOffset += ( position - imageIndex[dim] ) * imageOffsetTable[dim];
+          paddedOffset += ( position - padded.GetIndex(dim) ) * paddedStride;
+          blockOffset += ( position - block.GetIndex(dim) ) * blockStride;
+          paddedStride *= padded.GetSize(dim);
+          blockStride *= block.GetSize(dim);
+          }
+        const PixelType * current = buffer + imageOffset;
+        const PixelType * shifted = current + shiftOffset;
+        const double *    distance = &distances[paddedOffset];
+        double *          numerator = &numerators[blockOffset];
+        double *          denominator = &denominators[blockOffset];
+        for( SizeValueType ii = 0; ii < validLength; ++ii )
+          {
+          const double gaussian = std::exp( -distanceScale * distance[ii] );
+          const double diff = static_cast<double>( shifted[ii] ) - static_cast<double>( current[ii] );
+          numerator[ii] += diff * gaussian;
+          denominator[ii] += gaussian;
+          }
+        }
+      } // end for each offset of the search window
+
+    // Store the normalized updates of the block.
+    const SizeValueType blockLength0 = block.GetSize(0);
+    for( SizeValueType line = 0; line < block.GetNumberOfPixels() / blockLength0; ++line )
+      {
+      OffsetValueType regionOffset = block.GetIndex(0) - regionToProcess.GetIndex(0);
+      OffsetValueType regionStride = regionToProcess.GetSize(0);
+      remainder = line;
+      for( unsigned int dim = 1; dim < Dimension; ++dim )
+        {
+        const IndexValueType position =
+          block.GetIndex(dim) + static_cast<IndexValueType>( remainder % block.GetSize(dim) );
+        remainder /= block.GetSize(dim);
+        regionOffset += ( position - regionToProcess.GetIndex(dim) ) * regionStride;
+        regionStride *= regionToProcess.GetSize(dim);
+        }
+      for( SizeValueType ii = 0; ii < blockLength0; ++ii )
+        {
+        const SizeValueType blockOffset = line * blockLength0 + ii;
+        gradients[regionOffset + ii] = static_cast<RealType>( numerators[blockOffset]
+                                                              / ( denominators[blockOffset] + m_MinProbability ) );
+        }
+      }
+    } // end for each block
+}
+
 template <typename TInputImage, typename TOutputImage>
 void
 PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
@@ -2526,6 +2899,15 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>
     os << indent << "UseFastTensorComputations: Off" << std::endl;
     }
 
+  if( m_UseFastPatchDistances )
+    {
+    os << indent << "UseFastPatchDistances: On" << std::endl;
+    }
+  else
+    {
+    os << indent << "UseFastPatchDistances: Off" << std::endl;
+    }
+
   os << indent << "Kernel bandwidth sigma: "
      << m_KernelBandwidthSigma << std::endl;
   if( m_KernelBandwidthSigmaIsSet )
@@ -0,0 +1,162 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkPatchBasedDenoisingImageFilter.h"
+#include "itkSpatialNeighborSubsampler.h"
+#include "itkTestingMacros.h"
+
+// Compare the blockwise patch distances with the patch-by-patch computation.
+namespace
+{
+template< typename TImage >
+typename TImage::Pointer
+MakeNoisyCheckerboard(const typename TImage::SizeType & size)
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(1234);
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    unsigned int parity = 0;
+    for ( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+      {
+      parity += it.GetIndex()[d] / 6;
+      }
+    const double value = ( parity % 2 ) ? 100.0 : 20.0;
+    it.Set( static_cast< typename TImage::PixelType >( value + generator->GetNormalVariate(0.0, 100.0) ) );
+    }
+  return image;
+}
+
+template< typename TImage >
+typename TImage::Pointer
+Denoise(const TImage * input, bool useFastPatchDistances, unsigned int numberOfThreads,
+        unsigned int searchRadius, bool useNoiseModel, bool useSmoothDiscPatchWeights)
+{
+  typedef itk::PatchBasedDenoisingImageFilter< TImage, TImage > FilterType;
+  typedef itk::Statistics::SpatialNeighborSubsampler<
+    typename FilterType::PatchSampleType, typename TImage::RegionType > SamplerType;
+
+  typename SamplerType::Pointer sampler = SamplerType::New();
+  sampler->SetRadius(searchRadius);
+
+  typename FilterType::RealArrayType kernelSigma(1);
+  kernelSigma[0] = 40.0;
+
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetPatchRadius(2);
+  filter->SetUseSmoothDiscPatchWeights(useSmoothDiscPatchWeights);
+  filter->SetSampler(sampler);
+  filter->SetKernelBandwidthSigma(kernelSigma);
+  filter->SetNumberOfIterations(2);
+  filter->SetNumberOfThreads(numberOfThreads);
+  filter->SetUseFastPatchDistances(useFastPatchDistances);
+  if ( useNoiseModel )
+    {
+    filter->SetNoiseModel(FilterType::GAUSSIAN);
+    filter->SetNoiseModelFidelityWeight(0.1);
+    }
+  filter->Update();
+  return filter->GetOutput();
+}
+
+template< typename TImage >
+bool
+Compare(const TImage * input, unsigned int numberOfThreads, unsigned int searchRadius, bool useNoiseModel,
+        bool useSmoothDiscPatchWeights)
+{
+  typename TImage::Pointer reference =
+    Denoise(input, false, 1, searchRadius, useNoiseModel, useSmoothDiscPatchWeights);
+  typename TImage::Pointer fast =
+    Denoise(input, true, numberOfThreads, searchRadius, useNoiseModel, useSmoothDiscPatchWeights);
+
+  itk::ImageRegionConstIterator< TImage > refIt( reference, reference->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > fastIt( fast, fast->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > inIt( input, input->GetLargestPossibleRegion() );
+  double maxDifference = 0.0;
+  double maxChange = 0.0;
+  for ( ; !refIt.IsAtEnd(); ++refIt, ++fastIt, ++inIt )
+    {
+    maxDifference = std::max( maxDifference, std::abs( static_cast< double >( refIt.Get() - fastIt.Get() ) ) );
+    maxChange = std::max( maxChange, std::abs( static_cast< double >( refIt.Get() - inIt.Get() ) ) );
+    }
+  std::cout << TImage::ImageDimension << "D, " << numberOfThreads << " threads, search radius "
+            << searchRadius << ( useSmoothDiscPatchWeights ? ", smooth disc weights" : ", uniform weights" )
+            << ": max difference " << maxDifference
+            << ", max change " << maxChange << std::endl;
+  // The filter must actually have smoothed the image for the comparison to
+  // mean anything.
+  return maxDifference < 1e-3 && maxChange > 1.0;
+}
+}
+
+int itkPatchBasedDenoisingImageFilterFastPathTest(int, char* [])
+{
+  typedef itk::Image< float, 2 > Image2DType;
+  typedef itk::Image< float, 3 > Image3DType;
+
+  typedef itk::PatchBasedDenoisingImageFilter< Image2DType, Image2DType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  TEST_SET_GET_BOOLEAN( filter, UseFastPatchDistances, true );
+
+  Image2DType::SizeType size2D;
+  size2D[0] = 45;
+  size2D[1] = 38;
+  Image2DType::Pointer image2D = MakeNoisyCheckerboard< Image2DType >(size2D);
+
+  // Wider than a block, so that the regions of the threads are split in
+  // several blocks
+  Image2DType::SizeType wideSize2D;
+  wideSize2D[0] = 300;
+  wideSize2D[1] = 24;
+  Image2DType::Pointer wideImage2D = MakeNoisyCheckerboard< Image2DType >(wideSize2D);
+
+  Image3DType::SizeType size3D;
+  size3D[0] = 16;
+  size3D[1] = 13;
+  size3D[2] = 11;
+  Image3DType::Pointer image3D = MakeNoisyCheckerboard< Image3DType >(size3D);
+
+  bool passed = true;
+  passed &= Compare< Image2DType >(image2D, 1, 5, false, false);
+  passed &= Compare< Image2DType >(image2D, 3, 6, true, false);
+  passed &= Compare< Image2DType >(image2D, 2, 4, false, true);
+  passed &= Compare< Image2DType >(wideImage2D, 2, 3, false, false);
+  passed &= Compare< Image2DType >(wideImage2D, 3, 3, true, true);
+  passed &= Compare< Image3DType >(image3D, 2, 2, false, false);
+  passed &= Compare< Image3DType >(image3D, 4, 3, true, false);
+  passed &= Compare< Image3DType >(image3D, 2, 2, false, true);
+
+  if ( !passed )
+    {
+    std::cerr << "Test failed: blockwise and patch-by-patch results differ" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -49,6 +49,20 @@ namespace itk
  *  the itk::DanielssonDistanceImageFilter class except it does not return
  *  the Voronoi map.
  *
+ *  Set/GetMaximumDistance limits the computation to a narrow band around
+ *  the object boundary: distances larger than the maximum distance are
+ *  set to the maximum distance (or its square if SquaredDistance is on),
+ *  with the sign of the pixel.  Pixels farther away do not take part in
+ *  the later passes, which makes the filter faster when the band is
+ *  narrow.  By default the band is unlimited.
+ *
+ *  \par Implementation
+ *  Each of the separable passes processes all the image lines along the
+ *  current axis in parallel, whatever the image size along the other
+ *  axes.  Lines that are not contiguous in memory are processed in
+ *  batches of neighboring lines, copied to a small buffer so that the
+ *  memory is read and written in contiguous chunks.
+ *
  *  Reference:
  *  C. R. Maurer, Jr., R. Qi, and V. Raghavan, "A Linear Time Algorithm
  *  for Computing Exact Euclidean Distance Transforms of Binary Images in
@@ -154,6 +168,12 @@ public:
   itkSetMacro(BackgroundValue, InputPixelType);
   itkGetConstReferenceMacro(BackgroundValue, InputPixelType);
 
+  /** Set/Get the maximum distance computed.  It is in physical units
+   * when UseImageSpacing is on, in pixels otherwise.  Defaults to the
+   * largest double value, which disables the narrow band. */
+  itkSetMacro(MaximumDistance, double);
+  itkGetConstMacro(MaximumDistance, double);
+
 protected:
   SignedMaurerDistanceMapImageFilter();
   virtual ~SignedMaurerDistanceMapImageFilter() ITK_OVERRIDE;
@@ -162,24 +182,42 @@ protected:
 
   virtual void GenerateData() ITK_OVERRIDE;
 
-  virtual unsigned int SplitRequestedRegion(unsigned int i, unsigned int num,
-    OutputImageRegionType & splitRegion) ITK_OVERRIDE;
-
+  /** Apply the square root, if needed, and the sign to the squared
+   * distances computed by the separable passes. */
   virtual void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                             ThreadIdType threadId) ITK_OVERRIDE;
 
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(SignedMaurerDistanceMapImageFilter);
 
-  void Voronoi(unsigned int, OutputIndexType idx, OutputImageType *output );
+  /** Run the pass along m_CurrentDimension on a share of the lines. */
+  void ThreadedVoronoi(ThreadIdType threadId, ThreadIdType numberOfThreads);
+
+  /** Internal structure used for passing the filter to the threads. */
+  struct VoronoiThreadStruct
+  {
+    Self *Filter;
+  };
+
+  static ITK_THREAD_RETURN_TYPE VoronoiThreaderCallback(void *arg);
+
+  /** Compute the squared distances along one line of n pixels, stored
+   * with a stride of one.  g and h are work buffers of size n. */
+  void Voronoi(OutputPixelType *line, OutputSizeValueType n, double spacing,
+               OutputPixelType *g, OutputPixelType *h) const;
+
   bool Remove(OutputPixelType, OutputPixelType, OutputPixelType,
-              OutputPixelType, OutputPixelType, OutputPixelType);
+              OutputPixelType, OutputPixelType, OutputPixelType) const;
 
   InputPixelType   m_BackgroundValue;
   InputSpacingType m_Spacing;
 
   unsigned int m_CurrentDimension;
 
+  double          m_MaximumDistance;
+  bool            m_UseMaximumDistance;
+  OutputPixelType m_MaximumSquaredDistance;
+
   bool m_InsideIsPositive;
   bool m_UseImageSpacing;
   bool m_SquaredDistance;
@@ -25,8 +25,6 @@
 #include "itkProgressReporter.h"
 #include "itkProgressAccumulator.h"
 #include "itkMath.h"
-#include "vnl/vnl_vector.h"
-#include "itkMath.h"
 
 namespace itk
 {
@@ -36,6 +34,9 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
   m_BackgroundValue( NumericTraits< InputPixelType >::ZeroValue() ),
   m_Spacing(0.0),
   m_CurrentDimension(0),
+  m_MaximumDistance( NumericTraits< double >::max() ),
+  m_UseMaximumDistance(false),
+  m_MaximumSquaredDistance( NumericTraits< OutputPixelType >::max() ),
   m_InsideIsPositive(false),
   m_UseImageSpacing(true),
   m_SquaredDistance(false),
@@ -47,67 +48,6 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
 ::~SignedMaurerDistanceMapImageFilter()
 {}
 
-template< typename TInputImage, typename TOutputImage >
-unsigned int
-SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
-::SplitRequestedRegion(unsigned int i, unsigned int num,
-  OutputImageRegionType & splitRegion)
-{
-  // Get the output pointer
-  OutputImageType *outputPtr = this->GetOutput();
-
-  // Initialize the splitRegion to the output requested region
-  splitRegion = outputPtr->GetRequestedRegion();
-
-  const OutputSizeType & requestedRegionSize = splitRegion.GetSize();
-
-  OutputIndexType splitIndex = splitRegion.GetIndex();
-  OutputSizeType  splitSize  = splitRegion.GetSize();
-
-  // split on the outermost dimension available
-  // and avoid the current dimension
-  int splitAxis = static_cast< int >( outputPtr->GetImageDimension() ) - 1;
-  while ( ( requestedRegionSize[splitAxis] == 1 ) ||
-          ( splitAxis == static_cast< int >( m_CurrentDimension ) ) )
-    {
-    --splitAxis;
-    if ( splitAxis < 0 )
-      { // cannot split
-      itkDebugMacro("Cannot Split");
-      return 1;
-      }
-    }
-
-  // determine the actual number of pieces that will be generated
-  double range = static_cast< double >( requestedRegionSize[splitAxis] );
-
-  unsigned int valuesPerThread =
-    static_cast< unsigned int >( std::ceil( range / static_cast< double >( num ) ) );
-  unsigned int maxThreadIdUsed =
-    static_cast< unsigned int >( std::ceil( range / static_cast< double >( valuesPerThread ) ) ) - 1;
-
-  // Split the region
-  if ( i < maxThreadIdUsed )
-    {
-    splitIndex[splitAxis] += i * valuesPerThread;
-    splitSize[splitAxis] = valuesPerThread;
-    }
-  if ( i == maxThreadIdUsed )
-    {
-    splitIndex[splitAxis] += i * valuesPerThread;
-    // last thread needs to process the "rest" dimension being split
-    splitSize[splitAxis] = splitSize[splitAxis] - i * valuesPerThread;
-    }
-
-  // set the split region ivars
-  splitRegion.SetIndex(splitIndex);
-  splitRegion.SetSize(splitSize);
-
-  itkDebugMacro("Split Piece: " << splitRegion);
-
-  return maxThreadIdUsed + 1;
-}
-
 template< typename TInputImage, typename TOutputImage >
 void
 SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
@@ -123,6 +63,19 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
   this->AllocateOutputs();
   this->m_Spacing = outputPtr->GetSpacing();
 
+  // narrow band, as a squared distance in the output pixel type
+  this->m_UseMaximumDistance =
+    ( this->m_MaximumDistance < NumericTraits< double >::max() );
+  this->m_MaximumSquaredDistance = NumericTraits< OutputPixelType >::max();
+  if ( this->m_UseMaximumDistance )
+    {
+    const double maximumSquaredDistance = this->m_MaximumDistance * this->m_MaximumDistance;
+    if ( maximumSquaredDistance < static_cast< double >( NumericTraits< OutputPixelType >::max() ) )
+      {
+      this->m_MaximumSquaredDistance = static_cast< OutputPixelType >( maximumSquaredDistance );
+      }
+    }
+
   // store the binary image in an image with a pixel type as small as possible
   // instead of keeping the native input pixel type to avoid using too much
   // memory.
@@ -162,220 +115,242 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
 
   this->GraftOutput( borderFilter->GetOutput() );
 
-  // Set up the multithreaded processing
-  typename ImageSource< OutputImageType >::ThreadStruct str;
-  str.Filter = this;
+  // multithread the separable passes: each one processes all the lines
+  // along the current dimension.
+  VoronoiThreadStruct voronoiStr;
+  voronoiStr.Filter = this;
 
   this->GetMultiThreader()->SetNumberOfThreads( nbthreads );
-  this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
-
+  this->GetMultiThreader()->SetSingleMethod(this->VoronoiThreaderCallback, &voronoiStr);
 
-  // multithread the execution
   for( unsigned int d=0; d<ImageDimension; d++ )
     {
     m_CurrentDimension = d;
     this->GetMultiThreader()->SingleMethodExecute();
     }
+
+  // the passes compute squared distances; sign them and take their
+  // square root if needed.
+  typename ImageSource< OutputImageType >::ThreadStruct str;
+  str.Filter = this;
+
+  this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
 }
 
 template< typename TInputImage, typename TOutputImage >
-void
+ITK_THREAD_RETURN_TYPE
 SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
-::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
-                       ThreadIdType threadId)
+::VoronoiThreaderCallback(void *arg)
 {
-  OutputImageType      *outputImage = this->GetOutput();
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  VoronoiThreadStruct * str = static_cast< VoronoiThreadStruct * >( info->UserData );
 
-  InputRegionType region = outputRegionForThread;
-  InputSizeType   size   = region.GetSize();
-  InputIndexType  startIndex = outputRegionForThread.GetIndex();
+  str->Filter->ThreadedVoronoi( info->ThreadID, info->NumberOfThreads );
 
-  OutputImageType      *outputPtr = this->GetOutput();
+  return ITK_THREAD_RETURN_VALUE;
+}
 
-  // compute the number of rows first, so we can setup a progress reporter
-  std::vector< InputSizeValueType > NumberOfRows;
-  for ( unsigned int i = 0; i < InputImageDimension; i++ )
-    {
-    NumberOfRows.push_back(1);
-    for ( unsigned int d = 0; d < InputImageDimension; d++ )
-      {
-      if ( d != i )
-        {
-        NumberOfRows[i] *= size[d];
-        }
-      }
-    }
+template< typename TInputImage, typename TOutputImage >
+void
+SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
+::ThreadedVoronoi(ThreadIdType threadId, ThreadIdType numberOfThreads)
+{
+  OutputImageType *outputImage = this->GetOutput();
+  OutputPixelType *buffer = outputImage->GetBufferPointer();
 
-  // set the progress reporter. Use a pointer to be able to destroy it before
-  // the creation of progress2
-  // so it won't set wrong progress at the end of ThreadedGenerateData()
-  float progressPerDimension = 0.67f / static_cast< float >( ImageDimension );
-  if ( !this->m_SquaredDistance )
-    {
-    progressPerDimension = 0.67f / ( static_cast< float >( ImageDimension ) + 1 );
-    }
-  ProgressReporter *progress =
-      new ProgressReporter(this,
-                           threadId,
-                           NumberOfRows[m_CurrentDimension],
-                           30,
-                           0.33f + static_cast< float >( m_CurrentDimension * progressPerDimension ),
-                           progressPerDimension);
-
-  // This variable provides the amount by which to divide the dimensionless index in order to get the index for each dimension.
-  vnl_vector< unsigned int > k(InputImageDimension - 1);
-  unsigned int count = 0;
-  k[count] = 1;
-  for ( unsigned int d = m_CurrentDimension + InputImageDimension - 1;
-         d > m_CurrentDimension + 1;
-         d-- )
+  const unsigned int        d = m_CurrentDimension;
+  const OutputSizeType      size = outputImage->GetBufferedRegion().GetSize();
+  const OutputSizeValueType nd = size[d];
+  if ( nd == 0 )
     {
-    k[count+1] = k[count] * size[d % InputImageDimension];
-    count++;
-    }
-  k.flip();
-
-  // The index is defined as the dimensionless index into the pixel.
-  // It must be divided by each dimension size in order to get the index for that dimension.
-  // The result of this division is the offsetIndex, which is the index offset relative to the region of this thread.
-  // The true pixel location (idx) is provided by the sum of the offsetIndex and the startIndex.
-  InputSizeValueType index;
-  OutputIndexType offsetIndex;
-  offsetIndex.Fill(0);
-  InputSizeValueType tempRow = NumberOfRows[m_CurrentDimension];
-  OutputIndexType idx;
-  idx.Fill(0);
-
-  for ( InputSizeValueType n = 0; n < tempRow; n++ )
-    {
-    index = n;
-    count = 0;
-    for ( unsigned int d = m_CurrentDimension + 1;
-         d < m_CurrentDimension + InputImageDimension; d++ )
-      {
-      offsetIndex[d % InputImageDimension] = static_cast< OutputIndexValueType >( static_cast< double >( index ) / static_cast< double >( k[count] ) );
-      idx[d % InputImageDimension] = offsetIndex[d % InputImageDimension] + static_cast< OutputIndexValueType >( startIndex[d % InputImageDimension] );
-
-      index %= k[count];
-      count++;
-      }
-    this->Voronoi(m_CurrentDimension, idx,outputImage);
-    progress->CompletedPixel();
+    return;
     }
-  delete progress;
 
-  if ( m_CurrentDimension == ImageDimension - 1 && !this->m_SquaredDistance )
+  // The lines along d are indexed by the position along the dimensions
+  // before d, which varies fastest in memory, and by the position along
+  // the dimensions after d.  When d is not the first dimension, a line is
+  // strided in memory, so neighboring lines are processed together: their
+  // pixels are copied to a work buffer, one line after the other, and
+  // copied back once done.  The buffer is filled and emptied reading and
+  // writing contiguous runs of pixels.
+  const OffsetValueType *offsetTable = outputImage->GetOffsetTable();
+  const OffsetValueType  lineStride = offsetTable[d];
+  const OffsetValueType  outerStride = offsetTable[d + 1];
+
+  const OutputSizeValueType numberOfInnerLines = static_cast< OutputSizeValueType >( lineStride );
+  const OutputSizeValueType numberOfOuterLines =
+    static_cast< OutputSizeValueType >( offsetTable[ImageDimension] / outerStride );
+  const OutputSizeValueType batchSize = ( d == 0 ) ? 1 : 16;
+  const OutputSizeValueType numberOfBatchesPerOuterLine =
+    ( numberOfInnerLines + batchSize - 1 ) / batchSize;
+  const OutputSizeValueType numberOfBatches = numberOfBatchesPerOuterLine * numberOfOuterLines;
+
+  // even share of the batches for this thread
+  const OutputSizeValueType firstBatch = numberOfBatches * threadId / numberOfThreads;
+  const OutputSizeValueType lastBatch = numberOfBatches * ( threadId + 1 ) / numberOfThreads;
+
+  const float progressPerDimension = 0.67f / ( static_cast< float >( ImageDimension ) + 1 );
+  ProgressReporter progress(this, threadId, lastBatch - firstBatch, 30,
+                            0.33f + static_cast< float >( d * progressPerDimension ),
+                            progressPerDimension);
+
+  const double spacing = this->GetUseImageSpacing() ? this->m_Spacing[d] : 1.0;
+
+  std::vector< OutputPixelType > lines( ( d == 0 ) ? 0 : batchSize * nd );
+  std::vector< OutputPixelType > g(nd);
+  std::vector< OutputPixelType > h(nd);
+
+  for ( OutputSizeValueType batch = firstBatch; batch < lastBatch; ++batch )
     {
-    typedef ImageRegionIterator< OutputImageType >      OutputIterator;
-    typedef ImageRegionConstIterator< InputImageType  > InputIterator;
-
-    typename OutputImageType::RegionType outputRegion = outputRegionForThread;
-
-    OutputIterator Ot(outputPtr, outputRegion);
-    InputIterator  It(m_InputCache,  outputRegion);
+    const OutputSizeValueType outer = batch / numberOfBatchesPerOuterLine;
+    const OutputSizeValueType inner = ( batch % numberOfBatchesPerOuterLine ) * batchSize;
+    OutputPixelType *first = buffer + outer * outerStride + inner;
 
-    Ot.GoToBegin();
-    It.GoToBegin();
-
-    ProgressReporter progress2(this, threadId,
-                               outputRegionForThread.GetNumberOfPixels(), 30,
-                               0.33f + static_cast< float >( ImageDimension * progressPerDimension ),
-                               progressPerDimension);
-
-    typedef typename NumericTraits< OutputPixelType >::RealType OutputRealType;
-
-    while ( !Ot.IsAtEnd() )
+    if ( d == 0 )
       {
-      // cast to a real type is required on some platforms
-      const OutputPixelType outputValue =
-        static_cast< OutputPixelType >(
-          std::sqrt( static_cast< OutputRealType >( itk::Math::abs( Ot.Get() ) ) ) );
-
-      if ( Math::NotExactlyEquals( It.Get(), this->m_BackgroundValue ) )
+      this->Voronoi(first, nd, spacing, &g[0], &h[0]);
+      }
+    else
+      {
+      const OutputSizeValueType numberOfLines = std::min( batchSize, numberOfInnerLines - inner );
+      for ( OutputSizeValueType i = 0; i < nd; ++i )
         {
-        if ( this->GetInsideIsPositive() )
+        const OutputPixelType *pixel = first + i * lineStride;
+        for ( OutputSizeValueType l = 0; l < numberOfLines; ++l )
           {
-          Ot.Set(outputValue);
-          }
-        else
-          {
-          Ot.Set(-outputValue);
+          lines[l * nd + i] = pixel[l];
           }
         }
-      else
+      for ( OutputSizeValueType l = 0; l < numberOfLines; ++l )
         {
-        if ( this->GetInsideIsPositive() )
-          {
-          Ot.Set(-outputValue);
-          }
-        else
+        this->Voronoi(&lines[l * nd], nd, spacing, &g[0], &h[0]);
+        }
+      for ( OutputSizeValueType i = 0; i < nd; ++i )
+        {
+        OutputPixelType *pixel = first + i * lineStride;
+        for ( OutputSizeValueType l = 0; l < numberOfLines; ++l )
           {
-          Ot.Set(outputValue);
+          pixel[l] = lines[l * nd + i];
           }
         }
-
-      ++Ot;
-      ++It;
-      progress2.CompletedPixel();
       }
+    progress.CompletedPixel();
     }
 }
 
 template< typename TInputImage, typename TOutputImage >
 void
 SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
-::Voronoi(unsigned int d, OutputIndexType idx, OutputImageType *output)
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                       ThreadIdType threadId)
 {
-  OutputRegionType      oRegion = output->GetRequestedRegion();
-  OutputSizeValueType   nd = oRegion.GetSize()[d];
-
-  vnl_vector< OutputPixelType > g(nd, 0 );
-  vnl_vector< OutputPixelType > h(nd, 0 );
+  typedef ImageRegionIterator< OutputImageType >      OutputIterator;
+  typedef ImageRegionConstIterator< InputImageType  > InputIterator;
 
+  OutputIterator Ot(this->GetOutput(), outputRegionForThread);
+  InputIterator  It(m_InputCache, outputRegionForThread);
 
-  InputRegionType iRegion = m_InputCache->GetRequestedRegion();
-  InputIndexType startIndex = iRegion.GetIndex();
+  const float progressPerDimension = 0.67f / ( static_cast< float >( ImageDimension ) + 1 );
+  ProgressReporter progress(this, threadId,
+                            outputRegionForThread.GetNumberOfPixels(), 30,
+                            0.33f + static_cast< float >( ImageDimension * progressPerDimension ),
+                            progressPerDimension);
 
-  OutputPixelType di;
+  typedef typename NumericTraits< OutputPixelType >::RealType OutputRealType;
 
-  int l = -1;
-
-  for ( unsigned int i = 0; i < nd; i++ )
+  const OutputPixelType maximumValue = NumericTraits< OutputPixelType >::max();
+  OutputPixelType       bandValue = maximumValue;
+  if ( this->m_UseMaximumDistance )
     {
-    idx[d] = i + startIndex[d];
+    bandValue = this->m_SquaredDistance ? this->m_MaximumSquaredDistance :
+      static_cast< OutputPixelType >( this->m_MaximumDistance );
+    }
 
-    di = output->GetPixel(idx);
+  while ( !Ot.IsAtEnd() )
+    {
+    OutputPixelType outputValue = Ot.Get();
 
-    OutputPixelType iw;
+    if ( Math::ExactlyEquals( outputValue, maximumValue ) )
+      {
+      // outside of the narrow band, or no object in the image.  Without a
+      // narrow band, the squared distance is left unsigned.
+      if ( !this->m_UseMaximumDistance && this->m_SquaredDistance )
+        {
+        ++Ot;
+        ++It;
+        progress.CompletedPixel();
+        continue;
+        }
+      if ( this->m_UseMaximumDistance )
+        {
+        outputValue = bandValue;
+        }
+      else
+        {
+        outputValue = static_cast< OutputPixelType >(
+          std::sqrt( static_cast< OutputRealType >( outputValue ) ) );
+        }
+      }
+    else if ( !this->m_SquaredDistance )
+      {
+      // cast to a real type is required on some platforms
+      outputValue = static_cast< OutputPixelType >(
+        std::sqrt( static_cast< OutputRealType >( itk::Math::abs( outputValue ) ) ) );
+      }
 
-    if ( this->GetUseImageSpacing() )
+    if ( Math::NotExactlyEquals( It.Get(), this->m_BackgroundValue ) == this->m_InsideIsPositive )
       {
-      iw = static_cast< OutputPixelType >( i ) *
-           static_cast< OutputPixelType >( this->m_Spacing[d] );
+      Ot.Set(outputValue);
       }
     else
       {
-      iw  = static_cast< OutputPixelType >( i );
+      Ot.Set(-outputValue);
       }
 
-    if ( Math::NotExactlyEquals( di, NumericTraits< OutputPixelType >::max() ) )
+    ++Ot;
+    ++It;
+    progress.CompletedPixel();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
+::Voronoi(OutputPixelType *line, OutputSizeValueType nd, double spacing,
+          OutputPixelType *g, OutputPixelType *h) const
+{
+  const OutputPixelType maximumValue = NumericTraits< OutputPixelType >::max();
+
+  OutputPixelType di;
+
+  int l = -1;
+
+  for ( OutputSizeValueType i = 0; i < nd; i++ )
+    {
+    di = line[i];
+
+    const OutputPixelType iw = static_cast< OutputPixelType >( i ) *
+      static_cast< OutputPixelType >( spacing );
+
+    if ( Math::NotExactlyEquals( di, maximumValue ) )
       {
       if ( l < 1 )
         {
         l++;
-        g(l) = di;
-        h(l) = iw;
+        g[l] = di;
+        h[l] = iw;
         }
       else
         {
         while ( ( l >= 1 )
-                && this->Remove(g(l - 1), g(l), di, h(l - 1), h(l), iw) )
+                && this->Remove(g[l - 1], g[l], di, h[l - 1], h[l], iw) )
           {
           l--;
           }
         l++;
-        g(l) = di;
-        h(l) = iw;
+        g[l] = di;
+        h[l] = iw;
         }
       }
     }
@@ -389,25 +364,16 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
 
   l = 0;
 
-  for ( unsigned int i = 0; i < nd; i++ )
+  for ( OutputSizeValueType i = 0; i < nd; i++ )
     {
-    OutputPixelType iw;
+    const OutputPixelType iw = static_cast< OutputPixelType >( i * spacing );
 
-    if ( this->GetUseImageSpacing() )
-      {
-      iw = static_cast< OutputPixelType >( i * this->m_Spacing[d] );
-      }
-    else
-      {
-      iw = static_cast< OutputPixelType >( i );
-      }
-
-    OutputPixelType d1 = itk::Math::abs( g(l) ) + ( h(l) - iw ) * ( h(l) - iw );
+    OutputPixelType d1 = itk::Math::abs( g[l] ) + ( h[l] - iw ) * ( h[l] - iw );
 
     while ( l < ns )
       {
       // be sure to compute d2 *only* if l < ns
-      OutputPixelType d2 = itk::Math::abs( g(l + 1) ) + ( h(l + 1) - iw ) * ( h(l + 1) - iw );
+      OutputPixelType d2 = itk::Math::abs( g[l + 1] ) + ( h[l + 1] - iw ) * ( h[l + 1] - iw );
       // then compare d1 and d2
       if ( d1 <= d2 )
         {
@@ -416,30 +382,13 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
       l++;
       d1 = d2;
       }
-    idx[d] = i + startIndex[d];
 
-    if ( Math::NotExactlyEquals( m_InputCache->GetPixel(idx), this->m_BackgroundValue ) )
-      {
-      if ( this->m_InsideIsPositive )
-        {
-        output->SetPixel(idx,  d1);
-        }
-      else
-        {
-        output->SetPixel(idx, -d1);
-        }
-      }
-    else
+    // the pixels too far from the object are left out of the next passes
+    if ( d1 > this->m_MaximumSquaredDistance )
       {
-      if ( this->m_InsideIsPositive )
-        {
-        output->SetPixel(idx, -d1);
-        }
-      else
-        {
-        output->SetPixel(idx,  d1);
-        }
+      d1 = maximumValue;
       }
+    line[i] = d1;
     }
 }
 
@@ -447,7 +396,7 @@ template< typename TInputImage, typename TOutputImage >
 bool
 SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
 ::Remove(OutputPixelType d1, OutputPixelType d2, OutputPixelType df,
-         OutputPixelType x1, OutputPixelType x2, OutputPixelType xf)
+         OutputPixelType x1, OutputPixelType x2, OutputPixelType xf) const
 {
   OutputPixelType a = x2 - x1;
   OutputPixelType b = xf - x2;
@@ -479,6 +428,8 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
      << this->m_UseImageSpacing << std::endl;
   os << indent << "Squared distance: "
      << this->m_SquaredDistance << std::endl;
+  os << indent << "Maximum distance: "
+     << this->m_MaximumDistance << std::endl;
 }
 } // end namespace itk
 
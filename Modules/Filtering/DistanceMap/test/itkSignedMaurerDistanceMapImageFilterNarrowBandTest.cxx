@@ -0,0 +1,219 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBinaryContourImageFilter.h"
+#include "itkBinaryThresholdImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkSignedMaurerDistanceMapImageFilter.h"
+#include "itkTestingMacros.h"
+
+// Compare the signed Maurer distance map, with and without a narrow
+// band, with distances computed by brute force, for several numbers of
+// threads and image sizes which do not fill the batches of lines.
+namespace
+{
+
+template< typename TInputImage >
+typename TInputImage::Pointer
+MakeBlobs(const typename TInputImage::SizeType & size, unsigned int seed)
+{
+  typename TInputImage::Pointer image = TInputImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+  image->FillBuffer(0);
+
+  typename TInputImage::SpacingType spacing;
+  for ( unsigned int i = 0; i < TInputImage::ImageDimension; ++i )
+    {
+    spacing[i] = 0.5 + 0.25 * i;
+    }
+  image->SetSpacing(spacing);
+
+  // a few balls of pseudo random centers and radii
+  unsigned int value = seed;
+  for ( unsigned int b = 0; b < 4; ++b )
+    {
+    double center[TInputImage::ImageDimension];
+    for ( unsigned int i = 0; i < TInputImage::ImageDimension; ++i )
+      {
+      value = value * 1664525u + 1013904223u;
+      center[i] = ( value >> 8 ) % size[i];
+      }
+    value = value * 1664525u + 1013904223u;
+    const double radius = 1.0 + ( value >> 8 ) % 5;
+
+    itk::ImageRegionIteratorWithIndex< TInputImage > it( image, image->GetLargestPossibleRegion() );
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      double distance = 0.0;
+      for ( unsigned int i = 0; i < TInputImage::ImageDimension; ++i )
+        {
+        distance += ( it.GetIndex()[i] - center[i] ) * ( it.GetIndex()[i] - center[i] );
+        }
+      if ( distance <= radius * radius )
+        {
+        it.Set(1);
+        }
+      }
+    }
+  return image;
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+TestDistanceMap(const typename TInputImage::SizeType & size, const char * name)
+{
+  typedef itk::SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage > FilterType;
+  typedef typename TOutputImage::IndexType                                      IndexType;
+
+  typename TInputImage::Pointer input = MakeBlobs< TInputImage >( size, 7 );
+
+  // The filter measures the distances to the pixels on the contour of
+  // the object.
+  typedef itk::BinaryThresholdImageFilter< TInputImage, TOutputImage > ThresholdType;
+  typename ThresholdType::Pointer threshold = ThresholdType::New();
+  threshold->SetInput( input );
+  threshold->SetLowerThreshold( 0 );
+  threshold->SetUpperThreshold( 0 );
+  threshold->SetInsideValue( 1 );
+  threshold->SetOutsideValue( 0 );
+  typedef itk::BinaryContourImageFilter< TOutputImage, TOutputImage > ContourType;
+  typename ContourType::Pointer contour = ContourType::New();
+  contour->SetInput( threshold->GetOutput() );
+  contour->SetForegroundValue( 0 );
+  contour->SetBackgroundValue( 1 );
+  contour->FullyConnectedOn();
+  contour->Update();
+
+  std::vector< IndexType > contourIndices;
+  itk::ImageRegionConstIteratorWithIndex< TOutputImage > cit( contour->GetOutput(),
+                                                              contour->GetOutput()->GetLargestPossibleRegion() );
+  for ( cit.GoToBegin(); !cit.IsAtEnd(); ++cit )
+    {
+    if ( cit.Get() == 0 )
+      {
+      contourIndices.push_back( cit.GetIndex() );
+      }
+    }
+  if ( contourIndices.empty() )
+    {
+    std::cerr << name << ": no object in the test image" << std::endl;
+    return false;
+    }
+
+  bool success = true;
+  for ( unsigned int mode = 0; mode < 16; ++mode )
+    {
+    const bool         useSpacing = ( mode & 1 ) != 0;
+    const bool         squared = ( mode & 2 ) != 0;
+    const bool         narrowBand = ( mode & 4 ) != 0;
+    const unsigned int numberOfThreads = ( mode & 8 ) ? 3 : 1;
+    const double       maximumDistance = useSpacing ? 2.6 : 3.5;
+
+    typename FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( input );
+    filter->SetUseImageSpacing( useSpacing );
+    filter->SetSquaredDistance( squared );
+    filter->SetInsideIsPositive( mode % 3 == 0 );
+    filter->SetNumberOfThreads( numberOfThreads );
+    if ( narrowBand )
+      {
+      filter->SetMaximumDistance( maximumDistance );
+      }
+    filter->Update();
+
+    double maximumError = 0.0;
+    itk::ImageRegionConstIteratorWithIndex< TOutputImage > it( filter->GetOutput(),
+                                                               filter->GetOutput()->GetLargestPossibleRegion() );
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      double expected = itk::NumericTraits< double >::max();
+      for ( size_t c = 0; c < contourIndices.size(); ++c )
+        {
+        double distance = 0.0;
+        for ( unsigned int i = 0; i < TInputImage::ImageDimension; ++i )
+          {
+          const double delta = ( it.GetIndex()[i] - contourIndices[c][i] ) *
+            ( useSpacing ? input->GetSpacing()[i] : 1.0 );
+          distance += delta * delta;
+          }
+        expected = std::min( expected, distance );
+        }
+      if ( narrowBand )
+        {
+        expected = std::min( expected, maximumDistance * maximumDistance );
+        }
+      if ( !squared )
+        {
+        expected = std::sqrt( expected );
+        }
+      if ( ( input->GetPixel( it.GetIndex() ) != 0 ) != filter->GetInsideIsPositive() )
+        {
+        expected = -expected;
+        }
+      maximumError = std::max( maximumError, std::abs( expected - it.Get() ) );
+      }
+
+    std::cout << name << ( useSpacing ? ", spacing" : "" ) << ( squared ? ", squared" : "" )
+              << ( narrowBand ? ", narrow band" : "" ) << ", " << numberOfThreads
+              << " thread(s): maximum error " << maximumError << std::endl;
+    if ( maximumError > 1e-4 )
+      {
+      success = false;
+      }
+    }
+  return success;
+}
+
+}
+
+int itkSignedMaurerDistanceMapImageFilterNarrowBandTest(int, char* [])
+{
+  typedef itk::Image< unsigned char, 2 > InputImageType2D;
+  typedef itk::Image< float, 2 >         OutputImageType2D;
+  typedef itk::Image< unsigned char, 3 > InputImageType3D;
+  typedef itk::Image< double, 3 >        OutputImageType3D;
+
+  typedef itk::SignedMaurerDistanceMapImageFilter< InputImageType2D, OutputImageType2D > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  TEST_SET_GET_VALUE( itk::NumericTraits< double >::max(), filter->GetMaximumDistance() );
+  filter->SetMaximumDistance( 5.0 );
+  TEST_SET_GET_VALUE( 5.0, filter->GetMaximumDistance() );
+
+  bool success = true;
+
+  InputImageType2D::SizeType size2D;
+  size2D[0] = 37;
+  size2D[1] = 23;
+  success &= TestDistanceMap< InputImageType2D, OutputImageType2D >( size2D, "2D" );
+
+  InputImageType3D::SizeType size3D;
+  size3D[0] = 19;
+  size3D[1] = 11;
+  size3D[2] = 14;
+  success &= TestDistanceMap< InputImageType3D, OutputImageType3D >( size3D, "3D" );
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -35,6 +35,33 @@ namespace itk
 {
 namespace fftw
 {
+#if defined( ITK_USE_FFTWF ) || defined( ITK_USE_FFTWD )
+/** Build the key of a plan in the FFTWGlobalConfiguration plan cache. FFTW
+ * runs a plan on new arrays only if they have the same sizes, placement and
+ * alignment as the arrays it was planned with, so all of them are part of
+ * the key.
+ * \ingroup ITKFFT
+ */
+inline FFTWGlobalConfiguration::PlanKeyType
+MakePlanKey(int precision, int kind, int rank, const int *n, int sign, unsigned flags, int threads,
+            bool inPlace, int inputAlignment, int outputAlignment)
+{
+  FFTWGlobalConfiguration::PlanKeyType key;
+  key.reserve( rank + 9 );
+  key.push_back( precision );
+  key.push_back( kind );
+  key.push_back( sign );
+  key.push_back( static_cast< int >( flags ) );
+  key.push_back( threads );
+  key.push_back( inPlace ? 1 : 0 );
+  key.push_back( inputAlignment );
+  key.push_back( outputAlignment );
+  key.push_back( rank );
+  key.insert( key.end(), n, n + rank );
+  return key;
+}
+#endif
+
 /**
  * \class Interface
  * \brief Wrapper for FFTW API
@@ -357,6 +384,102 @@ public:
     MutexLockHolder< FFTWGlobalConfiguration::MutexType > lock( FFTWGlobalConfiguration::GetLockMutex() );
     fftwf_destroy_plan(p);
   }
+
+  /** Get a plan from the process-wide plan cache, planning it on first use.
+   * The plan must be run with the Execute_* function of its kind and given
+   * back with ReleaseCachedPlan(), never destroyed. */
+  static PlanType GetCachedPlan_dft_r2c(int rank,
+                                        const int *n,
+                                        PixelType *in,
+                                        ComplexType *out,
+                                        unsigned flags,
+                                        int threads=1,
+                                        bool canDestroyInput=false)
+  {
+    const FFTWGlobalConfiguration::PlanKeyType key =
+      MakePlanKey( 0, 0, rank, n, 0, flags, threads,
+                   static_cast< void * >( in ) == static_cast< void * >( out ),
+                   fftwf_alignment_of( in ),
+                   fftwf_alignment_of( reinterpret_cast< PixelType * >( out ) ) );
+    void * cached = FFTWGlobalConfiguration::AcquireCachedPlan( key );
+    if( cached != ITK_NULLPTR )
+      {
+      return static_cast< PlanType >( cached );
+      }
+    PlanType plan = Plan_dft_r2c(rank, n, in, out, flags, threads, canDestroyInput);
+    return static_cast< PlanType >( FFTWGlobalConfiguration::AddCachedPlan( key, plan, &Self::DestroyCachedPlan ) );
+  }
+
+  static PlanType GetCachedPlan_dft_c2r(int rank,
+                                        const int *n,
+                                        ComplexType *in,
+                                        PixelType *out,
+                                        unsigned flags,
+                                        int threads=1,
+                                        bool canDestroyInput=false)
+  {
+    const FFTWGlobalConfiguration::PlanKeyType key =
+      MakePlanKey( 0, 1, rank, n, 0, flags, threads,
+                   static_cast< void * >( in ) == static_cast< void * >( out ),
+                   fftwf_alignment_of( reinterpret_cast< PixelType * >( in ) ),
+                   fftwf_alignment_of( out ) );
+    void * cached = FFTWGlobalConfiguration::AcquireCachedPlan( key );
+    if( cached != ITK_NULLPTR )
+      {
+      return static_cast< PlanType >( cached );
+      }
+    PlanType plan = Plan_dft_c2r(rank, n, in, out, flags, threads, canDestroyInput);
+    return static_cast< PlanType >( FFTWGlobalConfiguration::AddCachedPlan( key, plan, &Self::DestroyCachedPlan ) );
+  }
+
+  static PlanType GetCachedPlan_dft(int rank,
+                                    const int *n,
+                                    ComplexType *in,
+                                    ComplexType *out,
+                                    int sign,
+                                    unsigned flags,
+                                    int threads=1,
+                                    bool canDestroyInput=false)
+  {
+    const FFTWGlobalConfiguration::PlanKeyType key =
+      MakePlanKey( 0, 2, rank, n, sign, flags, threads,
+                   in == out,
+                   fftwf_alignment_of( reinterpret_cast< PixelType * >( in ) ),
+                   fftwf_alignment_of( reinterpret_cast< PixelType * >( out ) ) );
+    void * cached = FFTWGlobalConfiguration::AcquireCachedPlan( key );
+    if( cached != ITK_NULLPTR )
+      {
+      return static_cast< PlanType >( cached );
+      }
+    PlanType plan = Plan_dft(rank, n, in, out, sign, flags, threads, canDestroyInput);
+    return static_cast< PlanType >( FFTWGlobalConfiguration::AddCachedPlan( key, plan, &Self::DestroyCachedPlan ) );
+  }
+
+  /** Run a plan on new arrays. These functions are thread safe. */
+  static void Execute_dft_r2c(PlanType p, PixelType *in, ComplexType *out)
+  {
+    fftwf_execute_dft_r2c(p, in, out);
+  }
+  static void Execute_dft_c2r(PlanType p, ComplexType *in, PixelType *out)
+  {
+    fftwf_execute_dft_c2r(p, in, out);
+  }
+  static void Execute_dft(PlanType p, ComplexType *in, ComplexType *out)
+  {
+    fftwf_execute_dft(p, in, out);
+  }
+
+  static void ReleaseCachedPlan(PlanType p)
+  {
+    FFTWGlobalConfiguration::ReleaseCachedPlan( p );
+  }
+
+private:
+  /** Called by FFTWGlobalConfiguration, which already holds the lock. */
+  static void DestroyCachedPlan(void *p)
+  {
+    fftwf_destroy_plan( static_cast< PlanType >( p ) );
+  }
 };
 
 #endif // ITK_USE_FFTWF
@@ -660,6 +783,102 @@ public:
     MutexLockHolder< FFTWGlobalConfiguration::MutexType > lock( FFTWGlobalConfiguration::GetLockMutex() );
     fftw_destroy_plan(p);
   }
+
+  /** Get a plan from the process-wide plan cache, planning it on first use.
+   * The plan must be run with the Execute_* function of its kind and given
+   * back with ReleaseCachedPlan(), never destroyed. */
+  static PlanType GetCachedPlan_dft_r2c(int rank,
+                                        const int *n,
+                                        PixelType *in,
+                                        ComplexType *out,
+                                        unsigned flags,
+                                        int threads=1,
+                                        bool canDestroyInput=false)
+  {
+    const FFTWGlobalConfiguration::PlanKeyType key =
+      MakePlanKey( 1, 0, rank, n, 0, flags, threads,
+                   static_cast< void * >( in ) == static_cast< void * >( out ),
+                   fftw_alignment_of( in ),
+                   fftw_alignment_of( reinterpret_cast< PixelType * >( out ) ) );
+    void * cached = FFTWGlobalConfiguration::AcquireCachedPlan( key );
+    if( cached != ITK_NULLPTR )
+      {
+      return static_cast< PlanType >( cached );
+      }
+    PlanType plan = Plan_dft_r2c(rank, n, in, out, flags, threads, canDestroyInput);
+    return static_cast< PlanType >( FFTWGlobalConfiguration::AddCachedPlan( key, plan, &Self::DestroyCachedPlan ) );
+  }
+
+  static PlanType GetCachedPlan_dft_c2r(int rank,
+                                        const int *n,
+                                        ComplexType *in,
+                                        PixelType *out,
+                                        unsigned flags,
+                                        int threads=1,
+                                        bool canDestroyInput=false)
+  {
+    const FFTWGlobalConfiguration::PlanKeyType key =
+      MakePlanKey( 1, 1, rank, n, 0, flags, threads,
+                   static_cast< void * >( in ) == static_cast< void * >( out ),
+                   fftw_alignment_of( reinterpret_cast< PixelType * >( in ) ),
+                   fftw_alignment_of( out ) );
+    void * cached = FFTWGlobalConfiguration::AcquireCachedPlan( key );
+    if( cached != ITK_NULLPTR )
+      {
+      return static_cast< PlanType >( cached );
+      }
+    PlanType plan = Plan_dft_c2r(rank, n, in, out, flags, threads, canDestroyInput);
+    return static_cast< PlanType >( FFTWGlobalConfiguration::AddCachedPlan( key, plan, &Self::DestroyCachedPlan ) );
+  }
+
+  static PlanType GetCachedPlan_dft(int rank,
+                                    const int *n,
+                                    ComplexType *in,
+                                    ComplexType *out,
+                                    int sign,
+                                    unsigned flags,
+                                    int threads=1,
+                                    bool canDestroyInput=false)
+  {
+    const FFTWGlobalConfiguration::PlanKeyType key =
+      MakePlanKey( 1, 2, rank, n, sign, flags, threads,
+                   in == out,
+                   fftw_alignment_of( reinterpret_cast< PixelType * >( in ) ),
+                   fftw_alignment_of( reinterpret_cast< PixelType * >( out ) ) );
+    void * cached = FFTWGlobalConfiguration::AcquireCachedPlan( key );
+    if( cached != ITK_NULLPTR )
+      {
+      return static_cast< PlanType >( cached );
+      }
+    PlanType plan = Plan_dft(rank, n, in, out, sign, flags, threads, canDestroyInput);
+    return static_cast< PlanType >( FFTWGlobalConfiguration::AddCachedPlan( key, plan, &Self::DestroyCachedPlan ) );
+  }
+
+  /** Run a plan on new arrays. These functions are thread safe. */
+  static void Execute_dft_r2c(PlanType p, PixelType *in, ComplexType *out)
+  {
+    fftw_execute_dft_r2c(p, in, out);
+  }
+  static void Execute_dft_c2r(PlanType p, ComplexType *in, PixelType *out)
+  {
+    fftw_execute_dft_c2r(p, in, out);
+  }
+  static void Execute_dft(PlanType p, ComplexType *in, ComplexType *out)
+  {
+    fftw_execute_dft(p, in, out);
+  }
+
+  static void ReleaseCachedPlan(PlanType p)
+  {
+    FFTWGlobalConfiguration::ReleaseCachedPlan( p );
+  }
+
+private:
+  /** Called by FFTWGlobalConfiguration, which already holds the lock. */
+  static void DestroyCachedPlan(void *p)
+  {
+    fftw_destroy_plan( static_cast< PlanType >( p ) );
+  }
 };
 
 #endif
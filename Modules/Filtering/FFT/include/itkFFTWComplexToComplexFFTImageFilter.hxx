@@ -94,15 +94,18 @@ FFTWComplexToComplexFFTImageFilter< TImage >
     sizes[(ImageDimension - 1) - i] = inputSize[i];
     }
 
-  plan = FFTWProxyType::Plan_dft(ImageDimension,sizes,
-                                    in,
-                                    out,
-                                    transformDirection,
-                                    flags,
-                                    this->GetNumberOfThreads());
-
-  FFTWProxyType::Execute(plan);
-  FFTWProxyType::DestroyPlan(plan);
+  const int threads =
+    FFTWGlobalConfiguration::GetNumberOfThreadsForSize(input->GetLargestPossibleRegion().GetNumberOfPixels(),
+                                                       this->GetNumberOfThreads());
+  plan = FFTWProxyType::GetCachedPlan_dft(ImageDimension,sizes,
+                                          in,
+                                          out,
+                                          transformDirection,
+                                          flags,
+                                          threads);
+
+  FFTWProxyType::Execute_dft(plan, in, out);
+  FFTWProxyType::ReleaseCachedPlan(plan);
 }
 
 
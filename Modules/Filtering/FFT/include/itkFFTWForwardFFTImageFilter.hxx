@@ -110,12 +110,13 @@ FFTWForwardFFTImageFilter< TInputImage, TOutputImage >
     sizes[(ImageDimension - 1) - i] = inputSize[i];
     }
 
-  plan = FFTWProxyType::Plan_dft_r2c(ImageDimension, sizes, in,
-                                     (typename FFTWProxyType::ComplexType*)
-                                     fftwOutput->GetBufferPointer(), flags,
-                                     this->GetNumberOfThreads());
-  FFTWProxyType::Execute(plan);
-  FFTWProxyType::DestroyPlan(plan);
+  typename FFTWProxyType::ComplexType * out =
+    (typename FFTWProxyType::ComplexType*) fftwOutput->GetBufferPointer();
+  const int threads =
+    FFTWGlobalConfiguration::GetNumberOfThreadsForSize(totalInputSize, this->GetNumberOfThreads());
+  plan = FFTWProxyType::GetCachedPlan_dft_r2c(ImageDimension, sizes, in, out, flags, threads);
+  FFTWProxyType::Execute_dft_r2c(plan, in, out);
+  FFTWProxyType::ReleaseCachedPlan(plan);
 
   // Expand the half image to the full image size
   typedef HalfToFullHermitianImageFilter< OutputImageType > HalfToFullFilterType;
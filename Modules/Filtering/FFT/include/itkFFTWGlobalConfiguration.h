@@ -31,6 +31,8 @@
 #include "fftw3.h"
 #include <algorithm>
 #include <cctype>
+#include <map>
+#include <vector>
 
 //* The fftw utilities help control the various strategies
 //available for controlling optimizations for the FFTW library.
@@ -50,6 +52,9 @@
 //                             file to be generated.  If this is
 //                             set, then ITK_FFTW_WISDOM_CACHE_BASE
 //                             is ignored.
+//ITK_FFTW_PLAN_CACHE_SIZE   - Defines the maximum number of plans
+//                             kept for reuse by the FFTW filters
+//                             (32 by default, 0 disables the cache)
 //
 // The above behaviors can also be controlled by the application.
 //
@@ -284,6 +289,51 @@ public:
   static bool ImportDefaultWisdomFile();
   static bool ExportDefaultWisdomFile();
 
+  /** Key identifying a plan in the plan cache, and function destroying a cached plan. */
+  typedef std::vector< int > PlanKeyType;
+  typedef void (*PlanDestructorType)( void * );
+
+  /**
+   * \brief Set/Get the maximum number of plans kept in the process-wide plan cache.
+   *
+   * The FFTW filters get their plans from this cache and run them on their own
+   * buffers through the new-array execute functions of FFTW, so that repeated
+   * transforms of the same size, as in iterative deconvolution, skip the planner.
+   * When the cache is full, the least recently used plans that are not being
+   * executed are destroyed. A value of 0 disables the cache.
+   * When a newly planned plan enters the cache and WriteWisdomCache is
+   * on, the new wisdom is written to the wisdom cache file right away,
+   * not only when the process ends.
+   * If the environmental variable "ITK_FFTW_PLAN_CACHE_SIZE" is set,
+   * then the environmental setting overides the default of 32.
+   */
+  static void SetMaximumNumberOfCachedPlans( const SizeValueType & v );
+  static SizeValueType GetMaximumNumberOfCachedPlans();
+
+  /** Get the number of plans currently in the cache. */
+  static SizeValueType GetNumberOfCachedPlans();
+
+  /** Find a plan in the cache and mark it as in use. Returns ITK_NULLPTR if
+   * there is no plan for that key. */
+  static void * AcquireCachedPlan( const PlanKeyType & key );
+
+  /** Add a new plan to the cache and mark it as in use. If another thread has
+   * added a plan with the same key in the meantime, the given plan is
+   * destroyed and the cached one is returned instead. */
+  static void * AddCachedPlan( const PlanKeyType & key, void * plan, PlanDestructorType destructor );
+
+  /** Mark a plan returned by AcquireCachedPlan() or AddCachedPlan() as no
+   * longer in use. */
+  static void ReleaseCachedPlan( void * plan );
+
+  /** Destroy the cached plans that are not in use. */
+  static void ClearPlanCache();
+
+  /** Get the number of threads FFTW should use for a transform of
+   * numberOfElements, at most maximumNumberOfThreads. The threads of FFTW only
+   * pay off for large transforms, so one thread is used per 32768 elements. */
+  static int GetNumberOfThreadsForSize( SizeValueType numberOfElements, int maximumNumberOfThreads );
+
 private:
   FFTWGlobalConfiguration(); //This will process env variables
   ~FFTWGlobalConfiguration(); //This will write cache file if requested.
@@ -299,6 +349,23 @@ private:
 
   ITK_DISALLOW_COPY_AND_ASSIGN(FFTWGlobalConfiguration);
 
+  /** Destroy unused plans, least recently used first, until at most
+   * maximumNumberOfPlans remain. The lock must be held. */
+  void TrimPlanCache( SizeValueType maximumNumberOfPlans );
+
+  /** Write the wisdom files if WriteWisdomCache is on and new wisdom
+   * is available. The lock must be held. */
+  void WriteNewWisdom();
+
+  struct CachedPlan
+  {
+    void *             Plan;
+    PlanDestructorType Destructor;
+    unsigned int       NumberOfUsers;
+    SizeValueType      LastUse;
+  };
+  typedef std::map< PlanKeyType, CachedPlan > PlanCacheType;
+
   static Pointer                m_Instance;
   static SimpleFastMutexLock    m_CreationLock;
 
@@ -311,6 +378,10 @@ private:
   //m_WriteWisdomCache Controls the behavior of default
   //wisdom file creation policies.
   WisdomFilenameGeneratorBase * m_WisdomFilenameGenerator;
+
+  PlanCacheType                 m_PlanCache;
+  SizeValueType                 m_MaximumNumberOfCachedPlans;
+  SizeValueType                 m_PlanCacheClock;
 };
 }
 #endif
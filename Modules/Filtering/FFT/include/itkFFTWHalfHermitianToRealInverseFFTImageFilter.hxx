@@ -94,9 +94,10 @@ FFTWHalfHermitianToRealInverseFFTImageFilter< TInputImage, TOutputImage >
     {
     sizes[(ImageDimension - 1) - i] = outputSize[i];
     }
-  plan = FFTWProxyType::Plan_dft_c2r( ImageDimension, sizes, in, out, m_PlanRigor,
-                                      this->GetNumberOfThreads(),
-                                      !m_CanUseDestructiveAlgorithm );
+  const int threads =
+    FFTWGlobalConfiguration::GetNumberOfThreadsForSize( totalOutputSize, this->GetNumberOfThreads() );
+  plan = FFTWProxyType::GetCachedPlan_dft_c2r( ImageDimension, sizes, in, out, m_PlanRigor,
+                                               threads, !m_CanUseDestructiveAlgorithm );
   if( !m_CanUseDestructiveAlgorithm )
     {
     // complex<double> and double[2] types are compatible memory layouts.
@@ -106,10 +107,10 @@ FFTWHalfHermitianToRealInverseFFTImageFilter< TInputImage, TOutputImage >
                inputPtr->GetBufferPointer()+totalInputSize,
                reinterpret_cast< typename InputImageType::PixelType * > (in) );
     }
-  FFTWProxyType::Execute( plan );
+  FFTWProxyType::Execute_dft_c2r( plan, in, out );
 
   // Some cleanup.
-  FFTWProxyType::DestroyPlan( plan );
+  FFTWProxyType::ReleaseCachedPlan( plan );
   if( !m_CanUseDestructiveAlgorithm )
     {
     delete[] in;
@@ -92,12 +92,14 @@ FFTWInverseFFTImageFilter< TInputImage, TOutputImage >
     sizes[(ImageDimension - 1) - i] = outputSize[i];
     }
 
-  plan = FFTWProxyType::Plan_dft_c2r( ImageDimension, sizes, in, out, m_PlanRigor,
-                                      this->GetNumberOfThreads(), false );
-  FFTWProxyType::Execute( plan );
+  const int threads =
+    FFTWGlobalConfiguration::GetNumberOfThreadsForSize( totalOutputSize, this->GetNumberOfThreads() );
+  plan = FFTWProxyType::GetCachedPlan_dft_c2r( ImageDimension, sizes, in, out, m_PlanRigor,
+                                               threads, false );
+  FFTWProxyType::Execute_dft_c2r( plan, in, out );
 
   // Some cleanup.
-  FFTWProxyType::DestroyPlan( plan );
+  FFTWProxyType::ReleaseCachedPlan( plan );
 }
 
 template <typename TInputImage, typename TOutputImage>
@@ -93,10 +93,11 @@ FFTWRealToHalfHermitianForwardFFTImageFilter< TInputImage, TOutputImage >
     sizes[(ImageDimension - 1) - i] = inputSize[i];
     }
 
-  plan = FFTWProxyType::Plan_dft_r2c(ImageDimension, sizes, in, out, flags,
-                                    this->GetNumberOfThreads());
-  FFTWProxyType::Execute(plan);
-  FFTWProxyType::DestroyPlan(plan);
+  const int threads =
+    FFTWGlobalConfiguration::GetNumberOfThreadsForSize(totalInputSize, this->GetNumberOfThreads());
+  plan = FFTWProxyType::GetCachedPlan_dft_r2c(ImageDimension, sizes, in, out, flags, threads);
+  FFTWProxyType::Execute_dft_r2c(plan, in, out);
+  FFTWProxyType::ReleaseCachedPlan(plan);
 }
 
 template< typename TInputImage, typename TOutputImage >
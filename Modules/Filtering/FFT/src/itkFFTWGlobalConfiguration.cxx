@@ -31,6 +31,8 @@
 #endif
 
 # include "itkObjectFactory.h"
+# include "itkMutexLockHolder.h"
+# include <sstream>
 
 namespace itk
 {
@@ -410,7 +412,9 @@ FFTWGlobalConfiguration
   m_PlanRigor(0),
   m_WriteWisdomCache(false),
   m_ReadWisdomCache(true),
-  m_WisdomCacheBase("")
+  m_WisdomCacheBase(""),
+  m_MaximumNumberOfCachedPlans(32),
+  m_PlanCacheClock(0)
 {
     {//Configure default method for creating WISDOM_CACHE files
     std::string manualCacheFilename="";
@@ -447,6 +451,23 @@ FFTWGlobalConfiguration
       }
     }
 
+    {
+    std::string planCacheSizeString;
+    if( itksys::SystemTools::GetEnv("ITK_FFTW_PLAN_CACHE_SIZE", planCacheSizeString) )
+      {
+      std::istringstream planCacheSizeStream( planCacheSizeString );
+      SizeValueType planCacheSize;
+      if( planCacheSizeStream >> planCacheSize )
+        {
+        this->m_MaximumNumberOfCachedPlans = planCacheSize;
+        }
+      else
+        {
+        itkWarningMacro( "Warning: Invalid FFTW plan cache size: " << planCacheSizeString );
+        }
+      }
+    }
+
 #if defined(ITK_USE_FFTWF)
   //TODO:  Investigate if this is really a warnable situation.
   //       fftw should work just fine without threads
@@ -529,6 +550,29 @@ FFTWGlobalConfiguration
 
 FFTWGlobalConfiguration
 ::~FFTWGlobalConfiguration()
+{
+  // The cached plans must be gone before FFTW cleans up.
+  for( PlanCacheType::iterator it = this->m_PlanCache.begin(); it != this->m_PlanCache.end(); ++it )
+    {
+    it->second.Destructor( it->second.Plan );
+    }
+  this->m_PlanCache.clear();
+
+  this->WriteNewWisdom();
+#if defined(ITK_USE_FFTWF)
+  fftwf_cleanup_threads();
+  fftwf_cleanup();
+#endif
+#if defined(ITK_USE_FFTWD)
+  fftw_cleanup_threads();
+  fftw_cleanup();
+#endif
+  delete this->m_WisdomFilenameGenerator;
+}
+
+void
+FFTWGlobalConfiguration
+::WriteNewWisdom()
 {
   if( this->m_WriteWisdomCache && this->m_NewWisdomAvailable )
     {
@@ -547,16 +591,8 @@ FFTWGlobalConfiguration
       ExportWisdomFileDouble(cachePath);
       }
 #endif
+    this->m_NewWisdomAvailable = false;
     }
-#if defined(ITK_USE_FFTWF)
-  fftwf_cleanup_threads();
-  fftwf_cleanup();
-#endif
-#if defined(ITK_USE_FFTWD)
-  fftw_cleanup_threads();
-  fftw_cleanup();
-#endif
-  delete this->m_WisdomFilenameGenerator;
 }
 
 void
@@ -874,6 +910,147 @@ FFTWGlobalConfiguration
   return GetInstance()->m_WisdomCacheBase;
 }
 
+void
+FFTWGlobalConfiguration
+::SetMaximumNumberOfCachedPlans( const SizeValueType & v )
+{
+  Pointer instance = GetInstance();
+  MutexLockHolder< MutexType > lock( instance->m_Lock );
+  instance->m_MaximumNumberOfCachedPlans = v;
+  instance->TrimPlanCache( v );
+}
+
+SizeValueType
+FFTWGlobalConfiguration
+::GetMaximumNumberOfCachedPlans()
+{
+  return GetInstance()->m_MaximumNumberOfCachedPlans;
+}
+
+SizeValueType
+FFTWGlobalConfiguration
+::GetNumberOfCachedPlans()
+{
+  Pointer instance = GetInstance();
+  MutexLockHolder< MutexType > lock( instance->m_Lock );
+  return static_cast< SizeValueType >( instance->m_PlanCache.size() );
+}
+
+void *
+FFTWGlobalConfiguration
+::AcquireCachedPlan( const PlanKeyType & key )
+{
+  Pointer instance = GetInstance();
+  MutexLockHolder< MutexType > lock( instance->m_Lock );
+  PlanCacheType::iterator it = instance->m_PlanCache.find( key );
+  if( it == instance->m_PlanCache.end() )
+    {
+    return ITK_NULLPTR;
+    }
+  ++it->second.NumberOfUsers;
+  it->second.LastUse = ++instance->m_PlanCacheClock;
+  return it->second.Plan;
+}
+
+void *
+FFTWGlobalConfiguration
+::AddCachedPlan( const PlanKeyType & key, void * plan, PlanDestructorType destructor )
+{
+  Pointer instance = GetInstance();
+  MutexLockHolder< MutexType > lock( instance->m_Lock );
+  PlanCacheType::iterator it = instance->m_PlanCache.find( key );
+  if( it != instance->m_PlanCache.end() )
+    {
+    destructor( plan );
+    }
+  else
+    {
+    CachedPlan cached;
+    cached.Plan = plan;
+    cached.Destructor = destructor;
+    cached.NumberOfUsers = 0;
+    cached.LastUse = 0;
+    it = instance->m_PlanCache.insert( PlanCacheType::value_type( key, cached ) ).first;
+    // Save the wisdom of the new plan now rather than at exit, so that
+    // the next processes skip the planner even if this one never ends.
+    instance->WriteNewWisdom();
+    }
+  ++it->second.NumberOfUsers;
+  it->second.LastUse = ++instance->m_PlanCacheClock;
+  return it->second.Plan;
+}
+
+void
+FFTWGlobalConfiguration
+::ReleaseCachedPlan( void * plan )
+{
+  Pointer instance = GetInstance();
+  MutexLockHolder< MutexType > lock( instance->m_Lock );
+  for( PlanCacheType::iterator it = instance->m_PlanCache.begin(); it != instance->m_PlanCache.end(); ++it )
+    {
+    if( it->second.Plan == plan )
+      {
+      if( it->second.NumberOfUsers > 0 )
+        {
+        --it->second.NumberOfUsers;
+        }
+      break;
+      }
+    }
+  instance->TrimPlanCache( instance->m_MaximumNumberOfCachedPlans );
+}
+
+void
+FFTWGlobalConfiguration
+::ClearPlanCache()
+{
+  Pointer instance = GetInstance();
+  MutexLockHolder< MutexType > lock( instance->m_Lock );
+  instance->TrimPlanCache( 0 );
+}
+
+void
+FFTWGlobalConfiguration
+::TrimPlanCache( SizeValueType maximumNumberOfPlans )
+{
+  while( this->m_PlanCache.size() > maximumNumberOfPlans )
+    {
+    PlanCacheType::iterator oldest = this->m_PlanCache.end();
+    for( PlanCacheType::iterator it = this->m_PlanCache.begin(); it != this->m_PlanCache.end(); ++it )
+      {
+      if( it->second.NumberOfUsers == 0
+          && ( oldest == this->m_PlanCache.end() || it->second.LastUse < oldest->second.LastUse ) )
+        {
+        oldest = it;
+        }
+      }
+    if( oldest == this->m_PlanCache.end() )
+      {
+      // All the remaining plans are being executed.
+      return;
+      }
+    oldest->second.Destructor( oldest->second.Plan );
+    this->m_PlanCache.erase( oldest );
+    }
+}
+
+int
+FFTWGlobalConfiguration
+::GetNumberOfThreadsForSize( SizeValueType numberOfElements, int maximumNumberOfThreads )
+{
+  const SizeValueType elementsPerThread = 32768;
+  const SizeValueType numberOfThreads = numberOfElements / elementsPerThread;
+  if( numberOfThreads < 1 )
+    {
+    return 1;
+    }
+  if( maximumNumberOfThreads < 1 || numberOfThreads > static_cast< SizeValueType >( maximumNumberOfThreads ) )
+    {
+    return std::max( maximumNumberOfThreads, 1 );
+    }
+  return static_cast< int >( numberOfThreads );
+}
+
 }//end namespace itk
 
 #endif
@@ -0,0 +1,191 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkFastMarchingIterativeImageFilterBase_h
+#define itkFastMarchingIterativeImageFilterBase_h
+
+#include "itkFastMarchingImageFilterBase.h"
+#include "itkMultiThreader.h"
+#include <vector>
+
+namespace itk
+{
+/**
+ * \class FastMarchingIterativeImageFilterBase
+ * \brief Solve the Eikonal equation on an image with the block fast
+ * iterative method, on several threads.
+ *
+ * This filter computes the unique solution of the upwind discretization
+ * of the Eikonal equation, like FastMarchingImageFilter, but it does not
+ * accept the nodes one at a time through a priority queue. Its arrival
+ * times match the ones of FastMarchingImageFilterBase away from the
+ * border of the image. FastMarchingImageFilterBase does not propagate
+ * the front from a node on the border of the image to its neighbor
+ * along the axis normal to the border, so its arrival times can be
+ * larger near the border; this filter propagates to and from the border
+ * nodes like to any other node. The image is split in
+ * blocks of BlockSize pixels along each dimension. The values of the
+ * pixels of the active blocks are updated with the same upwind solver
+ * until they no longer decrease, and a block whose border changed
+ * activates its neighbors. The blocks are processed in two phases, the
+ * blocks of each phase being processed by several threads, so that no
+ * block is modified while its neighbors are processed.
+ *
+ * The stopping criterion is shared with FastMarchingImageFilterBase. The
+ * arrival times are computed by bands of BandWidth: a value above the
+ * band is not propagated until the band is complete. The nodes of the
+ * complete band are then passed to the stopping criterion by increasing
+ * value, as the priority queue would do, and labeled as alive, until the
+ * criterion is satisfied. The nodes of the bands which are not reached
+ * keep the large value. The default band width is the time needed to
+ * cross a block at the lowest speed.
+ *
+ * The alive nodes propagate the front like the trial nodes, without
+ * requiring their neighbors to be given as trial nodes.
+ *
+ * The topology constraints depend on the order in which the nodes are
+ * accepted, so when TopologyCheck is set, the priority queue of
+ * FastMarchingImageFilterBase is used.
+ *
+ * See W.-K. Jeong and R. T. Whitaker, "A fast iterative method for
+ * Eikonal equations", SIAM Journal on Scientific Computing, 30(5), 2008.
+ *
+ * \sa FastMarchingImageFilterBase
+ * \sa FastMarchingThresholdStoppingCriterion
+ * \sa FastMarchingReachedTargetNodesStoppingCriterion
+ *
+ * \ingroup ITKFastMarching
+*/
+template< typename TInput, typename TOutput >
+class ITK_TEMPLATE_EXPORT FastMarchingIterativeImageFilterBase :
+    public FastMarchingImageFilterBase< TInput, TOutput >
+  {
+public:
+  typedef FastMarchingIterativeImageFilterBase            Self;
+  typedef FastMarchingImageFilterBase< TInput, TOutput > Superclass;
+  typedef SmartPointer< Self >                           Pointer;
+  typedef SmartPointer< const Self >                     ConstPointer;
+  typedef typename Superclass::Traits                    Traits;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(FastMarchingIterativeImageFilterBase, FastMarchingImageFilterBase);
+
+  typedef typename Superclass::InputImageType   InputImageType;
+  typedef typename Superclass::InputPixelType   InputPixelType;
+  typedef typename Superclass::OutputImageType  OutputImageType;
+  typedef typename Superclass::OutputPixelType  OutputPixelType;
+  typedef typename Superclass::OutputRegionType OutputRegionType;
+  typedef typename Superclass::NodeType         NodeType;
+  typedef typename Superclass::NodePairType     NodePairType;
+  typedef typename Superclass::LabelImageType   LabelImageType;
+
+  itkStaticConstMacro( ImageDimension, unsigned int, Traits::ImageDimension );
+
+  /** Set/Get the number of pixels of the blocks along each dimension.
+   * Defaults to 8. */
+  itkSetClampMacro( BlockSize, unsigned int, 1, NumericTraits< unsigned int >::max() );
+  itkGetConstMacro( BlockSize, unsigned int );
+
+  /** Set/Get the range of values computed before the stopping criterion
+   * is checked. A null value, the default, selects the time needed to
+   * cross a block at the lowest speed. */
+  itkSetMacro( BandWidth, double );
+  itkGetConstMacro( BandWidth, double );
+
+protected:
+  FastMarchingIterativeImageFilterBase();
+  ~FastMarchingIterativeImageFilterBase() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  void GenerateData() ITK_OVERRIDE;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(FastMarchingIterativeImageFilterBase);
+
+  typedef std::pair< OutputPixelType, OffsetValueType > ValueOffsetPairType;
+  typedef std::vector< ValueOffsetPairType >            ValueOffsetVectorType;
+
+  /** The data shared by the threads. A thread only writes the pixels and
+   * the state of its blocks. */
+  struct FastIterativeThreadStruct
+  {
+    OutputPixelType *     Output;
+    const unsigned char * Labels;
+    const InputPixelType *Speed;
+    OffsetValueType       OutputStrides[ImageDimension];
+    OffsetValueType       SpeedStrides[ImageDimension];
+    OffsetValueType       SpeedOffset;
+    SizeValueType         Size[ImageDimension];
+    SizeValueType         NumberOfBlocks[ImageDimension];
+    unsigned int          BlockSize;
+    double                SpaceFactors[ImageDimension];
+    double                NormalizationFactor;
+    double                InverseSpeed;
+    OutputPixelType       LargeValue;
+    OutputPixelType       Upper;
+
+    /** The blocks processed by the current phase. */
+    std::vector< SizeValueType > Blocks;
+
+    /** The faces of each block which changed, a bit per face. */
+    std::vector< unsigned int > ChangedFaces;
+
+    /** Whether values above the band were computed in each block, and
+     * the smallest of these values. */
+    std::vector< unsigned char > Deferred;
+    std::vector< double >        MinimumDeferred;
+
+    /** The nodes of the band collected by each thread. */
+    std::vector< ValueOffsetVectorType > Collected;
+
+    bool Collect;
+  };
+
+  static ITK_THREAD_RETURN_TYPE FastIterativeThreaderCallback( void *arg );
+
+  /** Process the blocks of the thread struct with all the threads. */
+  void RunPhase( FastIterativeThreadStruct & str, bool collect );
+
+  /** Update the pixels of a block until they no longer decrease. */
+  static void ProcessBlock( FastIterativeThreadStruct & str, SizeValueType block );
+
+  /** Collect the far nodes of a block with a value in the band. */
+  static void CollectBlock( FastIterativeThreadStruct & str, SizeValueType block,
+                            ValueOffsetVectorType & collected );
+
+  /** The first index and the size of a block, relative to the buffered
+   * region. */
+  static void GetBlockRange( const FastIterativeThreadStruct & str, SizeValueType block,
+                             SizeValueType first[], SizeValueType size[] );
+
+  /** The largest inverse of the normalized speed over the output region. */
+  double ComputeMaximumSlowness( const FastIterativeThreadStruct & str ) const;
+
+  unsigned int m_BlockSize;
+  double       m_BandWidth;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFastMarchingIterativeImageFilterBase.hxx"
+#endif
+
+#endif // itkFastMarchingIterativeImageFilterBase_h
@@ -0,0 +1,599 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkFastMarchingIterativeImageFilterBase_hxx
+#define itkFastMarchingIterativeImageFilterBase_hxx
+
+#include "itkFastMarchingIterativeImageFilterBase.h"
+
+#include "itkImageRegionConstIterator.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+
+namespace itk
+{
+
+template< typename TInput, typename TOutput >
+FastMarchingIterativeImageFilterBase< TInput, TOutput >::
+FastMarchingIterativeImageFilterBase() :
+  m_BlockSize( 8 ),
+  m_BandWidth( 0.0 )
+{
+}
+
+template< typename TInput, typename TOutput >
+void
+FastMarchingIterativeImageFilterBase< TInput, TOutput >::
+PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Block size: " << m_BlockSize << std::endl;
+  os << indent << "Band width: " << m_BandWidth << std::endl;
+}
+
+template< typename TInput, typename TOutput >
+void
+FastMarchingIterativeImageFilterBase< TInput, TOutput >::
+GenerateData()
+{
+  if( this->m_TopologyCheck != Superclass::Nothing )
+    {
+    // the topology depends on the order of the nodes
+    Superclass::GenerateData();
+    return;
+    }
+
+  OutputImageType* output = this->GetOutput();
+
+  this->Initialize( output );
+
+  const OutputRegionType & region = this->m_BufferedRegion;
+
+  FastIterativeThreadStruct str;
+  str.Output = output->GetBufferPointer();
+  str.Labels = this->m_LabelImage->GetBufferPointer();
+  str.Speed = ITK_NULLPTR;
+  str.SpeedOffset = 0;
+  str.BlockSize = m_BlockSize;
+  str.NormalizationFactor = this->m_NormalizationFactor;
+  str.InverseSpeed = this->m_InverseSpeed;
+  str.LargeValue = this->m_LargeValue;
+  str.Collect = false;
+
+  if( this->m_InputCache )
+    {
+    if( !this->m_InputCache->GetBufferedRegion().IsInside( region ) )
+      {
+      itkExceptionMacro( << "The speed image is not buffered over the output region "
+                         << region );
+      }
+    str.Speed = this->m_InputCache->GetBufferPointer();
+    str.SpeedOffset = this->m_InputCache->ComputeOffset( region.GetIndex() );
+    }
+
+  SizeValueType numberOfBlocks = 1;
+  SizeValueType blockStrides[ImageDimension];
+  double        maximumSpacing = 0.0;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+    str.OutputStrides[d] = output->GetOffsetTable()[d];
+    str.SpeedStrides[d] = str.Speed ? this->m_InputCache->GetOffsetTable()[d] : 0;
+    str.Size[d] = region.GetSize( d );
+    str.NumberOfBlocks[d] = ( str.Size[d] + m_BlockSize - 1 ) / m_BlockSize;
+    str.SpaceFactors[d] = itk::Math::sqr( 1.0 / this->m_OutputSpacing[d] );
+    blockStrides[d] = numberOfBlocks;
+    numberOfBlocks *= str.NumberOfBlocks[d];
+    maximumSpacing = std::max( maximumSpacing, static_cast< double >( this->m_OutputSpacing[d] ) );
+    }
+
+  double bandWidth = m_BandWidth;
+  if( bandWidth <= 0.0 )
+    {
+    bandWidth = m_BlockSize * maximumSpacing * this->ComputeMaximumSlowness( str );
+    }
+  if( !( bandWidth < NumericTraits< double >::max() ) )
+    {
+    bandWidth = NumericTraits< double >::max();
+    }
+
+  str.ChangedFaces.assign( numberOfBlocks, 0 );
+  str.Deferred.assign( numberOfBlocks, 0 );
+  str.MinimumDeferred.assign( numberOfBlocks, NumericTraits< double >::max() );
+
+  // the trial nodes are passed to the stopping criterion with the others,
+  // in the order of their values
+  ValueOffsetVectorType trial;
+  while( !this->m_Heap.empty() )
+    {
+    const NodePairType & nodePair = this->m_Heap.top();
+    trial.push_back( ValueOffsetPairType( nodePair.GetValue(), output->ComputeOffset( nodePair.GetNode() ) ) );
+    this->m_Heap.pop();
+    }
+  std::sort( trial.begin(), trial.end() );
+
+  // the blocks of the alive and trial nodes and their neighbors start the
+  // propagation
+  std::vector< unsigned char > active( numberOfBlocks, 0 );
+  std::vector< unsigned char > touched( numberOfBlocks, 0 );
+  double                       minimumSeedValue = NumericTraits< double >::max();
+  for( unsigned int container = 0; container < 2; ++container )
+    {
+    const typename Superclass::NodePairContainerType * nodes =
+      ( container == 0 ) ? this->m_AlivePoints.GetPointer() : this->m_TrialPoints.GetPointer();
+    if( !nodes )
+      {
+      continue;
+      }
+    for( typename Superclass::NodePairContainerConstIterator it = nodes->Begin(); it != nodes->End(); ++it )
+      {
+      const NodeType & node = it->Value().GetNode();
+      if( !region.IsInside( node ) )
+        {
+        continue;
+        }
+      minimumSeedValue = std::min( minimumSeedValue, static_cast< double >( it->Value().GetValue() ) );
+      SizeValueType block = 0;
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+        {
+        block += ( ( node[d] - region.GetIndex( d ) ) / m_BlockSize ) * blockStrides[d];
+        }
+      active[block] = 1;
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+        {
+        const SizeValueType position = ( block / blockStrides[d] ) % str.NumberOfBlocks[d];
+        if( position > 0 )
+          {
+          active[block - blockStrides[d]] = 1;
+          }
+        if( position + 1 < str.NumberOfBlocks[d] )
+          {
+          active[block + blockStrides[d]] = 1;
+          }
+        }
+      }
+    }
+
+  ProgressReporter progress( this, 0, this->GetTotalNumberOfNodes() );
+
+  this->m_StoppingCriterion->Reinitialize();
+
+  OutputPixelType currentValue = NumericTraits< OutputPixelType >::ZeroValue();
+  str.Upper = static_cast< OutputPixelType >(
+    std::min( minimumSeedValue + bandWidth, static_cast< double >( this->m_LargeValue ) ) );
+  typename ValueOffsetVectorType::const_iterator nextTrial = trial.begin();
+  ValueOffsetVectorType                          band;
+  while( true )
+    {
+    // update the active blocks until the values below the band no longer
+    // change. The blocks of a phase are not neighbors of each other.
+    bool isActive = true;
+    while( isActive )
+      {
+      isActive = false;
+      for( unsigned int parity = 0; parity < 2; ++parity )
+        {
+        str.Blocks.clear();
+        for( SizeValueType block = 0; block < numberOfBlocks; ++block )
+          {
+          if( !active[block] )
+            {
+            continue;
+            }
+          unsigned int blockParity = 0;
+          for( unsigned int d = 0; d < ImageDimension; ++d )
+            {
+            blockParity += ( block / blockStrides[d] ) % str.NumberOfBlocks[d];
+            }
+          if( blockParity % 2 == parity )
+            {
+            str.Blocks.push_back( block );
+            active[block] = 0;
+            touched[block] = 1;
+            }
+          }
+        if( str.Blocks.empty() )
+          {
+          continue;
+          }
+
+        this->RunPhase( str, false );
+
+        for( typename std::vector< SizeValueType >::const_iterator it = str.Blocks.begin();
+             it != str.Blocks.end(); ++it )
+          {
+          const unsigned int faces = str.ChangedFaces[*it];
+          for( unsigned int d = 0; d < ImageDimension; ++d )
+            {
+            if( faces & ( 1u << ( 2 * d ) ) )
+              {
+              active[*it - blockStrides[d]] = 1;
+              isActive = true;
+              }
+            if( faces & ( 1u << ( 2 * d + 1 ) ) )
+              {
+              active[*it + blockStrides[d]] = 1;
+              isActive = true;
+              }
+            }
+          }
+        }
+      }
+
+    // the values below the band are final. Pass them to the stopping
+    // criterion in increasing order.
+    str.Blocks.clear();
+    for( SizeValueType block = 0; block < numberOfBlocks; ++block )
+      {
+      if( touched[block] )
+        {
+        str.Blocks.push_back( block );
+        touched[block] = 0;
+        }
+      }
+    this->RunPhase( str, true );
+
+    band.clear();
+    for( unsigned int t = 0; t < str.Collected.size(); ++t )
+      {
+      const SizeValueType middle = band.size();
+      band.insert( band.end(), str.Collected[t].begin(), str.Collected[t].end() );
+      std::inplace_merge( band.begin(), band.begin() + middle, band.end() );
+      }
+    const SizeValueType middle = band.size();
+    for( ; nextTrial != trial.end() && nextTrial->first < str.Upper; ++nextTrial )
+      {
+      band.push_back( *nextTrial );
+      }
+    std::inplace_merge( band.begin(), band.begin() + middle, band.end() );
+
+    bool stopped = false;
+    for( typename ValueOffsetVectorType::const_iterator it = band.begin(); it != band.end(); ++it )
+      {
+      const NodeType node = output->ComputeIndex( it->second );
+      if( this->m_LabelImage->GetPixel( node ) == Traits::Alive ||
+          Math::NotExactlyEquals( output->GetPixel( node ), it->first ) )
+        {
+        continue;
+        }
+
+      currentValue = it->first;
+      const NodePairType nodePair( node, currentValue );
+      this->m_StoppingCriterion->SetCurrentNodePair( nodePair );
+      if( this->m_StoppingCriterion->IsSatisfied() )
+        {
+        stopped = true;
+        break;
+        }
+
+      if( this->m_CollectPoints )
+        {
+        this->m_ProcessedPoints->push_back( nodePair );
+        }
+      this->m_LabelImage->SetPixel( node, Traits::Alive );
+      progress.CompletedPixel();
+      }
+    if( stopped )
+      {
+      break;
+      }
+
+    // the next band starts at the smallest value above this one
+    bool   isPending = false;
+    double nextValue = NumericTraits< double >::max();
+    for( SizeValueType block = 0; block < numberOfBlocks; ++block )
+      {
+      if( str.Deferred[block] )
+        {
+        active[block] = 1;
+        isPending = true;
+        nextValue = std::min( nextValue, str.MinimumDeferred[block] );
+        str.Deferred[block] = 0;
+        str.MinimumDeferred[block] = NumericTraits< double >::max();
+        }
+      }
+    if( nextTrial != trial.end() )
+      {
+      isPending = true;
+      nextValue = std::min( nextValue, static_cast< double >( nextTrial->first ) );
+      }
+    if( !isPending )
+      {
+      break;
+      }
+    const double upper = std::max( static_cast< double >( str.Upper ), nextValue ) + bandWidth;
+    str.Upper = static_cast< OutputPixelType >( std::min( upper, static_cast< double >( this->m_LargeValue ) ) );
+    }
+
+  this->m_TargetReachedValue = currentValue;
+}
+
+template< typename TInput, typename TOutput >
+void
+FastMarchingIterativeImageFilterBase< TInput, TOutput >::
+RunPhase( FastIterativeThreadStruct & str, bool collect )
+{
+  str.Collect = collect;
+  if( collect )
+    {
+    str.Collected.assign( this->GetNumberOfThreads(), ValueOffsetVectorType() );
+    }
+
+  MultiThreader *threader = this->GetMultiThreader();
+  threader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  threader->SetSingleMethod( this->FastIterativeThreaderCallback, &str );
+  threader->SingleMethodExecute();
+}
+
+template< typename TInput, typename TOutput >
+ITK_THREAD_RETURN_TYPE
+FastMarchingIterativeImageFilterBase< TInput, TOutput >::
+FastIterativeThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *threadInfo =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  FastIterativeThreadStruct *str =
+    static_cast< FastIterativeThreadStruct * >( threadInfo->UserData );
+  const ThreadIdType threadId = threadInfo->ThreadID;
+  const ThreadIdType numberOfThreads = threadInfo->NumberOfThreads;
+
+  for( SizeValueType i = threadId; i < str->Blocks.size(); i += numberOfThreads )
+    {
+    if( str->Collect )
+      {
+      Self::CollectBlock( *str, str->Blocks[i], str->Collected[threadId] );
+      }
+    else
+      {
+      Self::ProcessBlock( *str, str->Blocks[i] );
+      }
+    }
+  if( str->Collect )
+    {
+    std::sort( str->Collected[threadId].begin(), str->Collected[threadId].end() );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInput, typename TOutput >
+void
+FastMarchingIterativeImageFilterBase< TInput, TOutput >::
+GetBlockRange( const FastIterativeThreadStruct & str, SizeValueType block,
+               SizeValueType first[], SizeValueType size[] )
+{
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+    first[d] = ( block % str.NumberOfBlocks[d] ) * str.BlockSize;
+    size[d] = std::min( static_cast< SizeValueType >( str.BlockSize ), str.Size[d] - first[d] );
+    block /= str.NumberOfBlocks[d];
+    }
+}
+
+template< typename TInput, typename TOutput >
+void
+FastMarchingIterativeImageFilterBase< TInput, TOutput >::
+ProcessBlock( FastIterativeThreadStruct & str, SizeValueType block )
+{
+  SizeValueType first[ImageDimension];
+  SizeValueType size[ImageDimension];
+  Self::GetBlockRange( str, block, first, size );
+
+  SizeValueType numberOfLines = 1;
+  for( unsigned int d = 1; d < ImageDimension; ++d )
+    {
+    numberOfLines *= size[d];
+    }
+
+  unsigned int faces = 0;
+  bool         deferred = false;
+  double       minimumDeferred = NumericTraits< double >::max();
+
+  // sweep the block forward and backward until no value decreases
+  bool changed = true;
+  for( unsigned int sweep = 0; changed; ++sweep )
+    {
+    changed = false;
+    const bool forward = ( sweep % 2 == 0 );
+    for( SizeValueType l = 0; l < numberOfLines; ++l )
+      {
+      SizeValueType   index[ImageDimension];
+      SizeValueType   remainder = forward ? l : numberOfLines - 1 - l;
+      OffsetValueType lineOffset = 0;
+      OffsetValueType speedLineOffset = str.SpeedOffset;
+      for( unsigned int d = 1; d < ImageDimension; ++d )
+        {
+        index[d] = first[d] + remainder % size[d];
+        remainder /= size[d];
+        lineOffset += index[d] * str.OutputStrides[d];
+        speedLineOffset += index[d] * str.SpeedStrides[d];
+        }
+
+      for( SizeValueType k = 0; k < size[0]; ++k )
+        {
+        index[0] = first[0] + ( forward ? k : size[0] - 1 - k );
+        const OffsetValueType offset = lineOffset + index[0];
+        if( str.Labels[offset] != Traits::Far )
+          {
+          continue;
+          }
+
+        double cc = str.InverseSpeed;
+        if( str.Speed )
+          {
+          const double speed = static_cast< double >(
+            str.Speed[speedLineOffset + index[0] * str.SpeedStrides[0]] ) / str.NormalizationFactor;
+          if( Math::ExactlyEquals( speed, 0.0 ) )
+            {
+            continue;
+            }
+          cc = -1.0 * itk::Math::sqr( 1.0 / speed );
+          }
+
+        // the smallest neighbor along each dimension, in increasing order
+        double       values[ImageDimension];
+        unsigned int axes[ImageDimension];
+        unsigned int numberOfValues = 0;
+        for( unsigned int d = 0; d < ImageDimension; ++d )
+          {
+          OutputPixelType value = str.LargeValue;
+          if( index[d] > 0 && str.Labels[offset - str.OutputStrides[d]] != Traits::Forbidden )
+            {
+            value = std::min( value, str.Output[offset - str.OutputStrides[d]] );
+            }
+          if( index[d] + 1 < str.Size[d] && str.Labels[offset + str.OutputStrides[d]] != Traits::Forbidden )
+            {
+            value = std::min( value, str.Output[offset + str.OutputStrides[d]] );
+            }
+          if( value < str.LargeValue )
+            {
+            unsigned int i = numberOfValues++;
+            for( ; i > 0 && values[i - 1] > value; --i )
+              {
+              values[i] = values[i - 1];
+              axes[i] = axes[i - 1];
+              }
+            values[i] = static_cast< double >( value );
+            axes[i] = d;
+            }
+          }
+
+        // solve the quadratic equation as FastMarchingImageFilterBase::Solve
+        double solution = NumericTraits< double >::max();
+        double aa = 0.0;
+        double bb = 0.0;
+        for( unsigned int i = 0; i < numberOfValues && solution >= values[i]; ++i )
+          {
+          const double spaceFactor = str.SpaceFactors[axes[i]];
+          aa += spaceFactor;
+          bb += values[i] * spaceFactor;
+          cc += itk::Math::sqr( values[i] ) * spaceFactor;
+
+          const double discrim = itk::Math::sqr( bb ) - aa * cc;
+          if( discrim < itk::Math::eps )
+            {
+            break;
+            }
+          solution = ( std::sqrt( discrim ) + bb ) / aa;
+          }
+
+        if( !( solution < static_cast< double >( str.LargeValue ) ) )
+          {
+          continue;
+          }
+        const OutputPixelType newValue = static_cast< OutputPixelType >( solution );
+        if( !( newValue < str.Output[offset] ) )
+          {
+          continue;
+          }
+        if( !( newValue < str.Upper ) )
+          {
+          // propagated with the next band
+          deferred = true;
+          minimumDeferred = std::min( minimumDeferred, solution );
+          continue;
+          }
+
+        str.Output[offset] = newValue;
+        changed = true;
+        for( unsigned int d = 0; d < ImageDimension; ++d )
+          {
+          if( index[d] == first[d] && index[d] > 0 )
+            {
+            faces |= 1u << ( 2 * d );
+            }
+          if( index[d] + 1 == first[d] + size[d] && index[d] + 1 < str.Size[d] )
+            {
+            faces |= 1u << ( 2 * d + 1 );
+            }
+          }
+        }
+      }
+    }
+
+  str.ChangedFaces[block] = faces;
+  if( deferred )
+    {
+    str.Deferred[block] = 1;
+    str.MinimumDeferred[block] = std::min( str.MinimumDeferred[block], minimumDeferred );
+    }
+}
+
+template< typename TInput, typename TOutput >
+void
+FastMarchingIterativeImageFilterBase< TInput, TOutput >::
+CollectBlock( FastIterativeThreadStruct & str, SizeValueType block, ValueOffsetVectorType & collected )
+{
+  SizeValueType first[ImageDimension];
+  SizeValueType size[ImageDimension];
+  Self::GetBlockRange( str, block, first, size );
+
+  SizeValueType numberOfLines = 1;
+  for( unsigned int d = 1; d < ImageDimension; ++d )
+    {
+    numberOfLines *= size[d];
+    }
+
+  for( SizeValueType l = 0; l < numberOfLines; ++l )
+    {
+    SizeValueType   remainder = l;
+    OffsetValueType offset = first[0];
+    for( unsigned int d = 1; d < ImageDimension; ++d )
+      {
+      offset += ( first[d] + remainder % size[d] ) * str.OutputStrides[d];
+      remainder /= size[d];
+      }
+    for( SizeValueType k = 0; k < size[0]; ++k, ++offset )
+      {
+      if( str.Labels[offset] == Traits::Far && str.Output[offset] < str.Upper )
+        {
+        collected.push_back( ValueOffsetPairType( str.Output[offset], offset ) );
+        }
+      }
+    }
+}
+
+template< typename TInput, typename TOutput >
+double
+FastMarchingIterativeImageFilterBase< TInput, TOutput >::
+ComputeMaximumSlowness( const FastIterativeThreadStruct & str ) const
+{
+  if( !str.Speed )
+    {
+    return std::sqrt( -str.InverseSpeed );
+    }
+
+  double minimumSpeed = NumericTraits< double >::max();
+  ImageRegionConstIterator< InputImageType > it( this->m_InputCache, this->m_BufferedRegion );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const double speed = static_cast< double >( it.Get() );
+    if( speed > 0.0 )
+      {
+      minimumSpeed = std::min( minimumSpeed, speed );
+      }
+    }
+  if( !( minimumSpeed < NumericTraits< double >::max() ) )
+    {
+    return NumericTraits< double >::max();
+    }
+  return str.NormalizationFactor / minimumSpeed;
+}
+
+} // end namespace itk
+
+#endif // itkFastMarchingIterativeImageFilterBase_hxx
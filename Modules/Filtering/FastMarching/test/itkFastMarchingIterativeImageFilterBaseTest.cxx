@@ -0,0 +1,291 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFastMarchingImageFilter.h"
+#include "itkFastMarchingIterativeImageFilterBase.h"
+#include "itkFastMarchingReachedTargetNodesStoppingCriterion.h"
+#include "itkFastMarchingThresholdStoppingCriterion.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+#include "itkTimeProbe.h"
+
+// Compare the arrival times of the fast iterative method with the ones of
+// the priority queue over the whole image, for several numbers of threads,
+// block sizes and band widths, and with the threshold and the target nodes
+// stopping criteria.
+namespace
+{
+
+const unsigned int Dimension = 3;
+
+typedef float                                   PixelType;
+typedef itk::Image< PixelType, Dimension >      ImageType;
+typedef itk::FastMarchingImageFilterBase< ImageType, ImageType >          FastMarchingType;
+typedef itk::FastMarchingIterativeImageFilterBase< ImageType, ImageType > IterativeType;
+typedef FastMarchingType::NodePairType                                    NodePairType;
+typedef FastMarchingType::NodePairContainerType                           NodePairContainerType;
+typedef FastMarchingType::StoppingCriterionType                           StoppingCriterionType;
+typedef itk::FastMarchingThresholdStoppingCriterion< ImageType, ImageType > ThresholdCriterionType;
+typedef itk::FastMarchingReachedTargetNodesStoppingCriterion< ImageType, ImageType >
+                                                                            TargetCriterionType;
+
+// FastMarchingImageFilter propagates the front from the nodes on the
+// border of the image, unlike FastMarchingImageFilterBase
+ImageType::Pointer
+ReferenceArrivalTimes(const ImageType *speed, const NodePairContainerType *alive,
+                      const NodePairContainerType *trial, const NodePairContainerType *forbidden)
+{
+  typedef itk::FastMarchingImageFilter< ImageType, ImageType > ReferenceType;
+  const NodePairContainerType *                                nodePairs[3] = { alive, trial, forbidden };
+  ReferenceType::NodeContainerPointer                          nodes[3];
+  for ( unsigned int i = 0; i < 3; ++i )
+    {
+    nodes[i] = ReferenceType::NodeContainer::New();
+    for ( NodePairContainerType::ConstIterator it = nodePairs[i]->Begin(); it != nodePairs[i]->End(); ++it )
+      {
+      ReferenceType::NodeType node;
+      node.SetIndex( it->Value().GetNode() );
+      node.SetValue( it->Value().GetValue() );
+      nodes[i]->push_back( node );
+      }
+    }
+
+  ReferenceType::Pointer reference = ReferenceType::New();
+  reference->SetInput( speed );
+  reference->SetAlivePoints( nodes[0] );
+  reference->SetTrialPoints( nodes[1] );
+  reference->SetOutsidePoints( nodes[2] );
+  reference->SetNormalizationFactor( 2.0 );
+  reference->Update();
+  return reference->GetOutput();
+}
+
+template< typename TFilter >
+void
+Setup(TFilter *filter, const ImageType *speed, NodePairContainerType *alive,
+      NodePairContainerType *trial, NodePairContainerType *forbidden, StoppingCriterionType *criterion)
+{
+  filter->SetInput( speed );
+  filter->SetAlivePoints( alive );
+  filter->SetTrialPoints( trial );
+  filter->SetForbiddenPoints( forbidden );
+  filter->SetStoppingCriterion( criterion );
+  filter->SetNormalizationFactor( 2.0 );
+}
+
+// the arrival times below the limit must be close, and the other ones
+// must be above the limit
+bool
+CompareArrivalTimes(const ImageType *expected, const ImageType *output, double limit, const char *name)
+{
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( expected, expected->GetBufferedRegion() );
+  for (; !it.IsAtEnd(); ++it )
+    {
+    const double expectedValue = it.Get();
+    const double value = output->GetPixel( it.GetIndex() );
+    const double tolerance = 1e-5 * std::max( 1.0, expectedValue );
+    if ( ( expectedValue < limit - tolerance && itk::Math::abs( value - expectedValue ) > tolerance )
+         || ( expectedValue > limit + tolerance && value < limit ) )
+      {
+      std::cerr << name << ": arrival time " << value << " instead of " << expectedValue << " at "
+                << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+bool
+SameImages(const ImageType *image1, const ImageType *image2)
+{
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( image1, image1->GetBufferedRegion() );
+  for (; !it.IsAtEnd(); ++it )
+    {
+    if ( itk::Math::NotExactlyEquals( it.Get(), image2->GetPixel( it.GetIndex() ) ) )
+      {
+      std::cerr << "The outputs differ with the number of threads at " << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+}
+
+int itkFastMarchingIterativeImageFilterBaseTest( int, char *[] )
+{
+  IterativeType::Pointer iterative = IterativeType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( iterative, FastMarchingIterativeImageFilterBase, FastMarchingImageFilterBase );
+  TEST_SET_GET_VALUE( 8u, iterative->GetBlockSize() );
+  TEST_SET_GET_VALUE( 0.0, iterative->GetBandWidth() );
+
+  // a speed image with anisotropic spacing
+  ImageType::SizeType size;
+  size[0] = 43;
+  size[1] = 37;
+  size[2] = 29;
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 1.5;
+  spacing[2] = 0.8;
+  ImageType::Pointer speed = ImageType::New();
+  speed->SetRegions( size );
+  speed->SetSpacing( spacing );
+  speed->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( speed, speed->GetBufferedRegion() );
+  for (; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType & index = it.GetIndex();
+    it.Set( static_cast< PixelType >( 2.0 + std::sin( 0.3 * index[0] ) * std::cos( 0.2 * index[1] + 0.1 * index[2] ) ) );
+    }
+
+  // a trial seed, and an alive seed with its neighbors as trial nodes
+  NodePairContainerType::Pointer alive = NodePairContainerType::New();
+  NodePairContainerType::Pointer trial = NodePairContainerType::New();
+  ImageType::IndexType           seed;
+  seed[0] = 12;
+  seed[1] = 25;
+  seed[2] = 14;
+  trial->push_back( NodePairType( seed, 0.0 ) );
+  seed[0] = 32;
+  seed[1] = 12;
+  seed[2] = 16;
+  alive->push_back( NodePairType( seed, 0.0 ) );
+  for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+    for ( int s = -1; s <= 1; s += 2 )
+      {
+      ImageType::IndexType neighbor = seed;
+      neighbor[d] += s;
+      trial->push_back( NodePairType( neighbor, static_cast< PixelType >( spacing[d] ) ) );
+      }
+    }
+
+  // a forbidden wall with a hole
+  NodePairContainerType::Pointer forbidden = NodePairContainerType::New();
+  ImageType::IndexType           index;
+  index[0] = 20;
+  for ( index[1] = 0; index[1] < static_cast< itk::IndexValueType >( size[1] ); ++index[1] )
+    {
+    for ( index[2] = 0; index[2] < static_cast< itk::IndexValueType >( size[2] ); ++index[2] )
+      {
+      if ( index[1] < 15 || index[1] > 18 || index[2] < 10 || index[2] > 12 )
+        {
+        forbidden->push_back( NodePairType( index, 0.0 ) );
+        }
+      }
+    }
+
+  // the whole image
+  itk::TimeProbe fastMarchingTime;
+  fastMarchingTime.Start();
+  ImageType::Pointer expected = ReferenceArrivalTimes( speed, alive, trial, forbidden );
+  fastMarchingTime.Stop();
+
+  ThresholdCriterionType::Pointer largeThreshold = ThresholdCriterionType::New();
+  largeThreshold->SetThreshold( 1e6 );
+
+  ImageType::Pointer reference;
+  const unsigned int blockSizes[] = { 8, 5 };
+  const double       bandWidths[] = { 0.0, 0.5, 1e9 };
+  for ( unsigned int b = 0; b < 2; ++b )
+    {
+    for ( unsigned int w = 0; w < 3; ++w )
+      {
+      for ( itk::ThreadIdType threads = 1; threads <= 4; threads += 3 )
+        {
+        iterative = IterativeType::New();
+        Setup( iterative.GetPointer(), speed, alive, trial, forbidden, largeThreshold );
+        iterative->SetBlockSize( blockSizes[b] );
+        iterative->SetBandWidth( bandWidths[w] );
+        iterative->SetNumberOfThreads( threads );
+        itk::TimeProbe iterativeTime;
+        iterativeTime.Start();
+        TRY_EXPECT_NO_EXCEPTION( iterative->Update() );
+        iterativeTime.Stop();
+        std::cout << "Block size " << blockSizes[b] << ", band width " << bandWidths[w] << ", "
+                  << threads << " threads: " << iterativeTime.GetTotal() << " s, priority queue: "
+                  << fastMarchingTime.GetTotal() << " s" << std::endl;
+
+        TEST_EXPECT_TRUE( CompareArrivalTimes( expected, iterative->GetOutput(), 1e6, "Whole image" ) );
+        if ( threads == 1 )
+          {
+          reference = iterative->GetOutput();
+          reference->DisconnectPipeline();
+          }
+        else
+          {
+          TEST_EXPECT_TRUE( SameImages( reference, iterative->GetOutput() ) );
+          }
+        }
+      }
+    }
+
+  // stop at a threshold, before the front reaches the border of the image
+  const double                    thresholdValue = 5.0;
+  ThresholdCriterionType::Pointer threshold = ThresholdCriterionType::New();
+  threshold->SetThreshold( thresholdValue );
+  FastMarchingType::Pointer fastMarching = FastMarchingType::New();
+  Setup( fastMarching.GetPointer(), speed, alive, trial, forbidden, threshold );
+  fastMarching->CollectPointsOn();
+  TRY_EXPECT_NO_EXCEPTION( fastMarching->Update() );
+
+  iterative = IterativeType::New();
+  Setup( iterative.GetPointer(), speed, alive, trial, forbidden, threshold );
+  iterative->CollectPointsOn();
+  iterative->SetNumberOfThreads( 4 );
+  TRY_EXPECT_NO_EXCEPTION( iterative->Update() );
+  TEST_EXPECT_TRUE( CompareArrivalTimes( fastMarching->GetOutput(), iterative->GetOutput(), thresholdValue, "Threshold" ) );
+  TEST_EXPECT_TRUE( iterative->GetTargetReachedValue() >= thresholdValue );
+  TEST_EXPECT_TRUE( itk::Math::abs( iterative->GetTargetReachedValue() - fastMarching->GetTargetReachedValue() ) < 1e-3 );
+  const double processedDifference = static_cast< double >( iterative->GetProcessedPoints()->Size() )
+    - static_cast< double >( fastMarching->GetProcessedPoints()->Size() );
+  TEST_EXPECT_TRUE( itk::Math::abs( processedDifference ) <= 2 );
+
+  // stop when the target nodes are reached
+  std::vector< ImageType::IndexType > targets;
+  index[0] = 16;
+  index[1] = 25;
+  index[2] = 14;
+  targets.push_back( index );
+  index[0] = 32;
+  index[1] = 14;
+  index[2] = 19;
+  targets.push_back( index );
+
+  TargetCriterionType::Pointer target = TargetCriterionType::New();
+  target->SetTargetCondition( TargetCriterionType::AllTargets );
+  target->SetTargetNodes( targets );
+  fastMarching = FastMarchingType::New();
+  Setup( fastMarching.GetPointer(), speed, alive, trial, forbidden, target );
+  TRY_EXPECT_NO_EXCEPTION( fastMarching->Update() );
+
+  target->SetTargetNodes( targets );
+  iterative = IterativeType::New();
+  Setup( iterative.GetPointer(), speed, alive, trial, forbidden, target );
+  iterative->SetNumberOfThreads( 4 );
+  TRY_EXPECT_NO_EXCEPTION( iterative->Update() );
+  const double targetReachedValue = fastMarching->GetTargetReachedValue();
+  TEST_EXPECT_TRUE( itk::Math::abs( iterative->GetTargetReachedValue() - targetReachedValue ) < 1e-3 );
+  TEST_EXPECT_TRUE( CompareArrivalTimes( fastMarching->GetOutput(), iterative->GetOutput(), targetReachedValue,
+                                         "Target nodes" ) );
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
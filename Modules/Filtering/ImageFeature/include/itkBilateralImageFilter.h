@@ -52,6 +52,30 @@ namespace itk
  * Manduchi (Bilateral Filtering for Gray and ColorImages. IEEE
  * ICCV. 1998.)
  *
+ * When UseBilateralGrid is on, the filter computes an approximation of
+ * the bilateral filter on a bilateral grid instead (Paris and Durand, A
+ * Fast Approximation of the Bilateral Filter using a Signal Processing
+ * Approach. ECCV. 2006; Chen, Paris and Durand, Real-time Edge-Aware
+ * Image Processing with the Bilateral Grid. SIGGRAPH. 2007): the input
+ * pixels are accumulated in a grid of the image domain and the
+ * intensity range, with cells of DomainSigma by RangeSigma; the grid is
+ * blurred with Gaussians of one cell, separably; and each output value
+ * is interpolated linearly in the blurred grid at the position and
+ * intensity of its input pixel. The cost is linear in the number of
+ * pixels whatever DomainSigma, so the grid pays off as soon as
+ * DomainSigma spans a few pixels, in 3D especially. The grid is built
+ * and blurred by the threads of the filter. When the grid would have
+ * more than four cells per input pixel, for instance because
+ * RangeSigma is small compared to the range of the input, the filter
+ * computes the bilateral filter directly instead. Radius and
+ * AutomaticKernelSize are not used by the grid. The grid rounds the
+ * pixels to the nearest cell and interpolates between cells, which
+ * blurs a little more than the direct computation; on noisy images
+ * with steps much higher than RangeSigma, the mean absolute difference
+ * to the direct computation is typically about 2% of RangeSigma, and
+ * at most about a third of RangeSigma, next to the steps, which stay as
+ * sharp.
+ *
  * \sa GaussianOperator
  * \sa RecursiveGaussianImageFilter
  * \sa DiscreteGaussianImageFilter
@@ -169,6 +193,14 @@ public:
   itkSetMacro(NumberOfRangeGaussianSamples, unsigned long);
   itkGetConstMacro(NumberOfRangeGaussianSamples, unsigned long);
 
+  /** Compute an approximation of the filter on a bilateral grid, whose
+   * cost does not depend on DomainSigma. Off by default. The filter
+   * falls back to the direct computation when the grid would have more
+   * than four cells per input pixel. */
+  itkSetMacro(UseBilateralGrid, bool);
+  itkGetConstMacro(UseBilateralGrid, bool);
+  itkBooleanMacro(UseBilateralGrid);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   // Begin concept checking
   itkConceptMacro( OutputHasNumericTraitsCheck,
@@ -189,6 +221,9 @@ protected:
   /** Do some setup before the ThreadedGenerateData */
   void BeforeThreadedGenerateData() ITK_OVERRIDE;
 
+  /** Release the bilateral grid. */
+  void AfterThreadedGenerateData() ITK_OVERRIDE;
+
   /** Standard pipeline method. This filter is implemented as a multi-threaded
    * filter. */
   void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
@@ -205,6 +240,54 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(BilateralImageFilter);
 
+  /** The bilateral grid has the intensity as dimension 0, and the
+   * dimensions of the image as the next ones. */
+  itkStaticConstMacro(GridDimension, unsigned int, ImageDimension + 1);
+
+  typedef FixedArray< double, itkGetStaticConstMacro(GridDimension) >        GridSpacingType;
+  typedef FixedArray< SizeValueType, itkGetStaticConstMacro(GridDimension) > GridSizeType;
+
+  /** Accumulate the input pixels in the bilateral grid and blur it, with
+   * the threads of the filter. Return false, without computing the grid,
+   * if the grid would have more than four cells per input pixel. */
+  bool ComputeBilateralGrid();
+
+  /** The steps of the computation of the grid run by the threads. */
+  enum GridPhaseType {
+    GridRangePhase,
+    GridAccumulatePhase,
+    GridBlurPhase
+    };
+
+  /** The data shared by the threads computing the grid. Each thread
+   * accumulates a slab of cells along the last dimension of the grid,
+   * then blurs a range of the lines of the grid along each dimension. */
+  struct GridThreadStruct
+    {
+    Self *                              Filter;
+    GridPhaseType                       Phase;
+    typename InputImageType::RegionType Region;
+    std::vector< double >               Minimum;
+    std::vector< double >               Maximum;
+    SizeValueType                       Strides[GridDimension];
+    SizeValueType                       NumberOfCells;
+    unsigned int                        BlurDimension;
+    std::vector< double >               Kernel;
+    };
+
+  static ITK_THREAD_RETURN_TYPE GridThreaderCallback(void *arg);
+
+  /** Run a step of the computation of the grid with all the threads. */
+  void RunGridPhase(GridThreadStruct & str, GridPhaseType phase);
+
+  /** The steps run by each thread. */
+  void ThreadedGridRange(GridThreadStruct & str, ThreadIdType threadId, ThreadIdType numberOfThreads);
+  void ThreadedGridAccumulate(GridThreadStruct & str, ThreadIdType threadId, ThreadIdType numberOfThreads);
+  void ThreadedGridBlur(GridThreadStruct & str, ThreadIdType threadId, ThreadIdType numberOfThreads);
+
+  /** Interpolate the output values in the bilateral grid. */
+  void SliceBilateralGrid(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId);
+
   /** The standard deviation of the gaussian blurring kernel in the image
       range. Units are intensity. */
   double m_RangeSigma;
@@ -231,6 +314,17 @@ private:
   double                m_DynamicRange;
   double                m_DynamicRangeUsed;
   std::vector< double > m_RangeGaussianTable;
+
+  /** Bilateral grid: sums of the intensities and numbers of the pixels
+   * of each cell, interleaved, blurred. A cell spans m_GridSpacing
+   * pixels and intensities from m_GridOrigin and m_GridMinimum. */
+  bool                                m_UseBilateralGrid;
+  bool                                m_BilateralGridComputed;
+  std::vector< double >               m_GridData;
+  GridSpacingType                     m_GridSpacing;
+  GridSizeType                        m_GridSize;
+  typename InputImageType::IndexType  m_GridOrigin;
+  double                              m_GridMinimum;
 };
 } // end namespace itk
 
@@ -20,12 +20,16 @@
 
 #include "itkBilateralImageFilter.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkGaussianImageSource.h"
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkZeroFluxNeumannBoundaryCondition.h"
 #include "itkProgressReporter.h"
 #include "itkStatisticsImageFilter.h"
 
+#include <algorithm>
+
 namespace itk
 {
 template< typename TInputImage, typename TOutputImage >
@@ -43,6 +47,12 @@ BilateralImageFilter< TInputImage, TOutputImage >
   this->m_DomainMu = 2.5;  // keep small to keep kernels small
   this->m_RangeMu = 4.0;   // can be bigger then DomainMu since we only
                            // index into a single table
+  this->m_UseBilateralGrid = false;
+  this->m_BilateralGridComputed = false;
+  this->m_GridSpacing.Fill(1.0);
+  this->m_GridSize.Fill(0);
+  this->m_GridOrigin.Fill(0);
+  this->m_GridMinimum = 0.0;
 }
 
 template< typename TInputImage, typename TOutputImage >
@@ -128,6 +138,13 @@ void
 BilateralImageFilter< TInputImage, TOutputImage >
 ::BeforeThreadedGenerateData()
 {
+  // the direct computation is used when the grid would be too large
+  m_BilateralGridComputed = m_UseBilateralGrid && this->ComputeBilateralGrid();
+  if ( m_BilateralGridComputed )
+    {
+    return;
+    }
+
   // Build a small image of the N-dimensional Gaussian used for domain filter
   //
   // Gaussian image size will be (2*std::ceil(2.5*sigma)+1) x
@@ -251,6 +268,12 @@ BilateralImageFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                        ThreadIdType threadId)
 {
+  if ( m_BilateralGridComputed )
+    {
+    this->SliceBilateralGrid(outputRegionForThread, threadId);
+    return;
+    }
+
   typename TInputImage::ConstPointer input = this->GetInput();
   typename TOutputImage::Pointer output = this->GetOutput();
   typename TInputImage::IndexValueType i;
@@ -346,6 +369,332 @@ BilateralImageFilter< TInputImage, TOutputImage >
     }
 }
 
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::AfterThreadedGenerateData()
+{
+  std::vector< double >().swap(m_GridData);
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+BilateralImageFilter< TInputImage, TOutputImage >
+::ComputeBilateralGrid()
+{
+  const InputImageType *                     inputImage = this->GetInput();
+  const typename InputImageType::RegionType  region = inputImage->GetBufferedRegion();
+  const typename InputImageType::SpacingType inputSpacing = inputImage->GetSpacing();
+
+  if ( m_RangeSigma <= 0.0 )
+    {
+    itkExceptionMacro(<< "RangeSigma must be positive");
+    }
+
+  GridThreadStruct str;
+  str.Region = region;
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  str.Minimum.assign( this->GetMultiThreader()->GetNumberOfThreads(), NumericTraits< double >::max() );
+  str.Maximum.assign( this->GetMultiThreader()->GetNumberOfThreads(), NumericTraits< double >::NonpositiveMin() );
+  this->RunGridPhase(str, GridRangePhase);
+
+  const double minimum = *std::min_element( str.Minimum.begin(), str.Minimum.end() );
+  const double maximum = *std::max_element( str.Maximum.begin(), str.Maximum.end() );
+  if ( region.GetNumberOfPixels() == 0 || !( maximum >= minimum ) )
+    {
+    return false;
+    }
+
+  // Cells of one sigma, but not smaller than a pixel, and the standard
+  // deviations of the blurs in cells.
+  GridSpacingType blurSigma;
+  m_GridSpacing[0] = m_RangeSigma;
+  blurSigma[0] = 1.0;
+  double gridSize = std::floor( ( maximum - minimum ) / m_GridSpacing[0] ) + 2;
+  double numberOfGridCells = gridSize;
+  for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+    const double sigma = m_DomainSigma[d] / inputSpacing[d];
+    m_GridSpacing[d + 1] = std::max(sigma, 1.0);
+    blurSigma[d + 1] = sigma / m_GridSpacing[d + 1];
+    numberOfGridCells *= std::floor( ( region.GetSize(d) - 1 ) / m_GridSpacing[d + 1] ) + 2;
+    }
+
+  // A grid with many more cells than the image has pixels, for instance
+  // because RangeSigma is small compared to the range of the image, would
+  // use too much memory and cost more than the direct computation.
+  if ( numberOfGridCells > 4.0 * region.GetNumberOfPixels() )
+    {
+    return false;
+    }
+
+  m_GridSize[0] = static_cast< SizeValueType >( gridSize );
+  for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+    m_GridSize[d + 1] =
+      Math::Floor< SizeValueType >( ( region.GetSize(d) - 1 ) / m_GridSpacing[d + 1] ) + 2;
+    }
+  m_GridOrigin = region.GetIndex();
+  m_GridMinimum = minimum;
+
+  str.NumberOfCells = 1;
+  for ( unsigned int d = 0; d < GridDimension; ++d )
+    {
+    str.Strides[d] = str.NumberOfCells;
+    str.NumberOfCells *= m_GridSize[d];
+    }
+
+  // Accumulate each pixel in its nearest cell.
+  m_GridData.assign(2 * str.NumberOfCells, 0.0);
+  this->RunGridPhase(str, GridAccumulatePhase);
+
+  // Blur the grid along each dimension, without anything beyond its
+  // borders. A DomainSigma of 0 gives a delta kernel, i.e. no blur.
+  for ( unsigned int d = 0; d < GridDimension; ++d )
+    {
+    if ( !( blurSigma[d] > 0.0 ) )
+      {
+      continue;
+      }
+    const double         mu = ( d == 0 ) ? m_RangeMu : m_DomainMu;
+    const IndexValueType radius = Math::Ceil< IndexValueType >( mu * blurSigma[d] );
+    str.Kernel.resize(2 * radius + 1);
+    for ( IndexValueType k = -radius; k <= radius; ++k )
+      {
+      str.Kernel[k + radius] = std::exp( -0.5 * k * k / ( blurSigma[d] * blurSigma[d] ) );
+      }
+    str.BlurDimension = d;
+    this->RunGridPhase(str, GridBlurPhase);
+    }
+
+  return true;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::RunGridPhase(GridThreadStruct & str, GridPhaseType phase)
+{
+  str.Filter = this;
+  str.Phase = phase;
+  MultiThreader *threader = this->GetMultiThreader();
+  threader->SetSingleMethod(this->GridThreaderCallback, &str);
+  threader->SingleMethodExecute();
+}
+
+template< typename TInputImage, typename TOutputImage >
+ITK_THREAD_RETURN_TYPE
+BilateralImageFilter< TInputImage, TOutputImage >
+::GridThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *threadInfo =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  GridThreadStruct *str =
+    static_cast< GridThreadStruct * >( threadInfo->UserData );
+  const ThreadIdType threadId = threadInfo->ThreadID;
+  const ThreadIdType numberOfThreads = threadInfo->NumberOfThreads;
+
+  switch ( str->Phase )
+    {
+    case GridRangePhase:
+      str->Filter->ThreadedGridRange(*str, threadId, numberOfThreads);
+      break;
+    case GridAccumulatePhase:
+      str->Filter->ThreadedGridAccumulate(*str, threadId, numberOfThreads);
+      break;
+    case GridBlurPhase:
+      str->Filter->ThreadedGridBlur(*str, threadId, numberOfThreads);
+      break;
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::ThreadedGridRange(GridThreadStruct & str, ThreadIdType threadId, ThreadIdType numberOfThreads)
+{
+  // a slab of the image along the last dimension
+  const unsigned int  last = ImageDimension - 1;
+  const SizeValueType length = str.Region.GetSize(last);
+  typename InputImageType::RegionType slab = str.Region;
+  slab.SetIndex( last, str.Region.GetIndex(last) + static_cast< IndexValueType >( length * threadId / numberOfThreads ) );
+  slab.SetSize( last, length * ( threadId + 1 ) / numberOfThreads - length * threadId / numberOfThreads );
+  if ( slab.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  double minimum = str.Minimum[threadId];
+  double maximum = str.Maximum[threadId];
+  ImageRegionConstIterator< InputImageType > it(this->GetInput(), slab);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double value = static_cast< double >( it.Get() );
+    minimum = std::min(minimum, value);
+    maximum = std::max(maximum, value);
+    }
+  str.Minimum[threadId] = minimum;
+  str.Maximum[threadId] = maximum;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::ThreadedGridAccumulate(GridThreadStruct & str, ThreadIdType threadId, ThreadIdType numberOfThreads)
+{
+  typedef ImageRegionConstIteratorWithIndex< InputImageType > InputIteratorType;
+
+  // The thread owns a slab of cells along the last dimension of the
+  // grid, and accumulates the rows of the image whose nearest cell is in
+  // this slab, so that no two threads write the same cell.
+  const unsigned int  last = ImageDimension - 1;
+  const SizeValueType numberOfSlabCells = m_GridSize[GridDimension - 1];
+  const SizeValueType firstCell = numberOfSlabCells * threadId / numberOfThreads;
+  const SizeValueType endCell = numberOfSlabCells * ( threadId + 1 ) / numberOfThreads;
+  SizeValueType firstRow = str.Region.GetSize(last);
+  SizeValueType endRow = 0;
+  for ( SizeValueType row = 0; row < str.Region.GetSize(last); ++row )
+    {
+    const SizeValueType cell = Math::Round< SizeValueType >( row / m_GridSpacing[GridDimension - 1] );
+    if ( cell >= firstCell && cell < endCell )
+      {
+      firstRow = std::min(firstRow, row);
+      endRow = row + 1;
+      }
+    }
+  if ( endRow <= firstRow )
+    {
+    return;
+    }
+  typename InputImageType::RegionType slab = str.Region;
+  slab.SetIndex( last, str.Region.GetIndex(last) + static_cast< IndexValueType >( firstRow ) );
+  slab.SetSize( last, endRow - firstRow );
+
+  InputIteratorType it(this->GetInput(), slab);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double  value = static_cast< double >( it.Get() );
+    SizeValueType cell = Math::Round< SizeValueType >( ( value - m_GridMinimum ) / m_GridSpacing[0] );
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      cell += str.Strides[d + 1] * Math::Round< SizeValueType >(
+        ( it.GetIndex()[d] - m_GridOrigin[d] ) / m_GridSpacing[d + 1] );
+      }
+    m_GridData[2 * cell] += value;
+    m_GridData[2 * cell + 1] += 1.0;
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::ThreadedGridBlur(GridThreadStruct & str, ThreadIdType threadId, ThreadIdType numberOfThreads)
+{
+  // The lines of the grid along the blur dimension are independent: the
+  // thread blurs a range of them.
+  const unsigned int   d = str.BlurDimension;
+  const IndexValueType radius = static_cast< IndexValueType >( str.Kernel.size() / 2 );
+  const IndexValueType length = static_cast< IndexValueType >( m_GridSize[d] );
+  const SizeValueType  stride = str.Strides[d];
+  const SizeValueType  numberOfLines = str.NumberOfCells / length;
+  const SizeValueType  firstLine = numberOfLines * threadId / numberOfThreads;
+  const SizeValueType  endLine = numberOfLines * ( threadId + 1 ) / numberOfThreads;
+
+  std::vector< double > line(2 * length);
+  for ( SizeValueType lineId = firstLine; lineId < endLine; ++lineId )
+    {
+    const SizeValueType first = ( lineId / stride ) * stride * length + lineId % stride;
+    for ( IndexValueType i = 0; i < length; ++i )
+      {
+      line[2 * i] = m_GridData[2 * ( first + i * stride )];
+      line[2 * i + 1] = m_GridData[2 * ( first + i * stride ) + 1];
+      }
+    for ( IndexValueType i = 0; i < length; ++i )
+      {
+      double sum = 0.0;
+      double count = 0.0;
+      const IndexValueType lower = std::max(i - radius, IndexValueType(0));
+      const IndexValueType upper = std::min(i + radius, length - 1);
+      for ( IndexValueType j = lower; j <= upper; ++j )
+        {
+        sum += str.Kernel[j - i + radius] * line[2 * j];
+        count += str.Kernel[j - i + radius] * line[2 * j + 1];
+        }
+      m_GridData[2 * ( first + i * stride )] = sum;
+      m_GridData[2 * ( first + i * stride ) + 1] = count;
+      }
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::SliceBilateralGrid(const OutputImageRegionType & outputRegionForThread,
+                     ThreadIdType threadId)
+{
+  const InputImageType *inputImage = this->GetInput();
+  OutputImageType *     outputImage = this->GetOutput();
+
+  SizeValueType strides[GridDimension];
+  SizeValueType numberOfCells = 1;
+  for ( unsigned int d = 0; d < GridDimension; ++d )
+    {
+    strides[d] = numberOfCells;
+    numberOfCells *= m_GridSize[d];
+    }
+  const unsigned int numberOfCorners = 1u << GridDimension;
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  ImageRegionConstIteratorWithIndex< InputImageType > it(inputImage, outputRegionForThread);
+  ImageRegionIterator< OutputImageType >              outIt(outputImage, outputRegionForThread);
+  for ( it.GoToBegin(), outIt.GoToBegin(); !it.IsAtEnd(); ++it, ++outIt )
+    {
+    const double value = static_cast< double >( it.Get() );
+
+    // Cell below the pixel in each grid dimension, and the position of
+    // the pixel in the cell.
+    SizeValueType cell = 0;
+    double        fractions[GridDimension];
+    for ( unsigned int d = 0; d < GridDimension; ++d )
+      {
+      const double position = ( d == 0 )
+        ? ( value - m_GridMinimum ) / m_GridSpacing[0]
+        : ( it.GetIndex()[d - 1] - m_GridOrigin[d - 1] ) / m_GridSpacing[d];
+      const SizeValueType below = std::min( Math::Floor< SizeValueType >(position), m_GridSize[d] - 2 );
+      fractions[d] = position - below;
+      cell += below * strides[d];
+      }
+
+    double sum = 0.0;
+    double count = 0.0;
+    for ( unsigned int corner = 0; corner < numberOfCorners; ++corner )
+      {
+      SizeValueType cornerCell = cell;
+      double        weight = 1.0;
+      for ( unsigned int d = 0; d < GridDimension; ++d )
+        {
+        if ( corner & ( 1u << d ) )
+          {
+          cornerCell += strides[d];
+          weight *= fractions[d];
+          }
+        else
+          {
+          weight *= 1.0 - fractions[d];
+          }
+        }
+      sum += weight * m_GridData[2 * cornerCell];
+      count += weight * m_GridData[2 * cornerCell + 1];
+      }
+
+    outIt.Set( static_cast< OutputPixelType >( count > 0.0 ? sum / count : value ) );
+    progress.CompletedPixel();
+    }
+}
+
 template< typename TInputImage, typename TOutputImage >
 void
 BilateralImageFilter< TInputImage, TOutputImage >
@@ -361,6 +710,7 @@ BilateralImageFilter< TInputImage, TOutputImage >
   os << indent << "Amount of dynamic range used: " << m_DynamicRangeUsed << std::endl;
   os << indent << "AutomaticKernelSize: " << m_AutomaticKernelSize << std::endl;
   os << indent << "Radius: " << m_Radius << std::endl;
+  os << indent << "UseBilateralGrid: " << m_UseBilateralGrid << std::endl;
 }
 } // end namespace itk
 
@@ -0,0 +1,311 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBilateralImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMath.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+// Compare the bilateral grid approximation with the direct computation
+// on noisy steps, in 2D and in 3D.
+namespace
+{
+template< typename TImage >
+bool
+CompareWithDirectFilter(const typename TImage::SizeType & size, double domainSigma)
+{
+  typedef itk::BilateralImageFilter< TImage, TImage > FilterType;
+
+  const double stepHeight = 200.0;
+  const double noiseSigma = 10.0;
+  const double rangeSigma = 30.0;
+
+  // Steps along direction 0 and direction 1, with Gaussian noise.
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(1999);
+  itk::ImageRegionIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    double value = 100.0 + noiseSigma * generator->GetNormalVariate();
+    if ( it.GetIndex()[0] >= static_cast< itk::IndexValueType >( size[0] / 2 ) )
+      {
+      value += stepHeight;
+      }
+    if ( it.GetIndex()[1] >= static_cast< itk::IndexValueType >( size[1] / 3 ) )
+      {
+      value += stepHeight / 2;
+      }
+    it.Set( static_cast< typename TImage::PixelType >( value ) );
+    }
+
+  typename FilterType::Pointer direct = FilterType::New();
+  direct->SetInput(image);
+  direct->SetDomainSigma(domainSigma);
+  direct->SetRangeSigma(rangeSigma);
+  TRY_EXPECT_NO_EXCEPTION( direct->Update() );
+
+  typename FilterType::Pointer grid = FilterType::New();
+  grid->SetInput(image);
+  grid->SetDomainSigma(domainSigma);
+  grid->SetRangeSigma(rangeSigma);
+  TEST_SET_GET_BOOLEAN( grid, UseBilateralGrid, true );
+  TRY_EXPECT_NO_EXCEPTION( grid->Update() );
+
+  double meanDifference = 0.0;
+  double maximumDifference = 0.0;
+  double residualNoise = 0.0;
+  itk::ImageRegionIteratorWithIndex< TImage > gridIt( grid->GetOutput(), image->GetLargestPossibleRegion() );
+  for ( gridIt.GoToBegin(); !gridIt.IsAtEnd(); ++gridIt )
+    {
+    const double difference = std::abs( gridIt.Get() - direct->GetOutput()->GetPixel( gridIt.GetIndex() ) );
+    meanDifference += difference;
+    maximumDifference = std::max(maximumDifference, difference);
+
+    double expected = 100.0;
+    if ( gridIt.GetIndex()[0] >= static_cast< itk::IndexValueType >( size[0] / 2 ) )
+      {
+      expected += stepHeight;
+      }
+    if ( gridIt.GetIndex()[1] >= static_cast< itk::IndexValueType >( size[1] / 3 ) )
+      {
+      expected += stepHeight / 2;
+      }
+    residualNoise += ( gridIt.Get() - expected ) * ( gridIt.Get() - expected );
+    }
+  const double numberOfPixels = image->GetLargestPossibleRegion().GetNumberOfPixels();
+  meanDifference /= numberOfPixels;
+  residualNoise = std::sqrt(residualNoise / numberOfPixels);
+
+  std::cout << TImage::ImageDimension << "D, domain sigma " << domainSigma
+            << ": mean difference " << meanDifference << ", maximum difference " << maximumDifference
+            << ", residual noise " << residualNoise << std::endl;
+
+  // The grid smooths the noise, keeps the steps, and stays close to the
+  // direct computation.
+  bool passed = true;
+  if ( meanDifference > 0.05 * rangeSigma )
+    {
+    std::cerr << "Mean difference to the direct computation too large" << std::endl;
+    passed = false;
+    }
+  if ( maximumDifference > 0.5 * rangeSigma )
+    {
+    std::cerr << "Maximum difference to the direct computation too large" << std::endl;
+    passed = false;
+    }
+  if ( residualNoise > noiseSigma / 2 )
+    {
+    std::cerr << "Residual noise too large" << std::endl;
+    passed = false;
+    }
+  return passed;
+}
+
+// The grid computed by several threads must match the grid computed by one
+// thread, and a grid larger than the image must not be used.
+template< typename TImage >
+bool
+CheckThreadsAndFallback(const typename TImage::SizeType & size)
+{
+  typedef itk::BilateralImageFilter< TImage, TImage > FilterType;
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(2007);
+  itk::ImageRegionIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( static_cast< typename TImage::PixelType >( 50.0 * ( it.GetIndex()[0] % 7 )
+                                                       + 10.0 * generator->GetNormalVariate() ) );
+    }
+
+  bool passed = true;
+  typename TImage::Pointer reference;
+  for ( unsigned int numberOfThreads = 1; numberOfThreads <= 5; numberOfThreads += 2 )
+    {
+    typename FilterType::Pointer grid = FilterType::New();
+    grid->SetInput(image);
+    grid->SetDomainSigma(3.0);
+    grid->SetRangeSigma(20.0);
+    grid->UseBilateralGridOn();
+    grid->SetNumberOfThreads(numberOfThreads);
+    TRY_EXPECT_NO_EXCEPTION( grid->Update() );
+    if ( reference.IsNull() )
+      {
+      reference = grid->GetOutput();
+      reference->DisconnectPipeline();
+      continue;
+      }
+    itk::ImageRegionIteratorWithIndex< TImage > gridIt( grid->GetOutput(), image->GetLargestPossibleRegion() );
+    for ( gridIt.GoToBegin(); !gridIt.IsAtEnd(); ++gridIt )
+      {
+      if ( gridIt.Get() != reference->GetPixel( gridIt.GetIndex() ) )
+        {
+        std::cerr << "The grid computed by " << numberOfThreads
+                  << " threads differs from the grid computed by one thread at "
+                  << gridIt.GetIndex() << std::endl;
+        passed = false;
+        break;
+        }
+      }
+    }
+
+  // With a tiny RangeSigma the grid would have far more cells than the
+  // image has pixels: the filter must compute the direct result.
+  typename FilterType::Pointer direct = FilterType::New();
+  direct->SetInput(image);
+  direct->SetDomainSigma(1.0);
+  direct->SetRangeSigma(0.05);
+  TRY_EXPECT_NO_EXCEPTION( direct->Update() );
+
+  typename FilterType::Pointer fallback = FilterType::New();
+  fallback->SetInput(image);
+  fallback->SetDomainSigma(1.0);
+  fallback->SetRangeSigma(0.05);
+  fallback->UseBilateralGridOn();
+  TRY_EXPECT_NO_EXCEPTION( fallback->Update() );
+
+  itk::ImageRegionIteratorWithIndex< TImage > fallbackIt( fallback->GetOutput(), image->GetLargestPossibleRegion() );
+  for ( fallbackIt.GoToBegin(); !fallbackIt.IsAtEnd(); ++fallbackIt )
+    {
+    if ( fallbackIt.Get() != direct->GetOutput()->GetPixel( fallbackIt.GetIndex() ) )
+      {
+      std::cerr << "Too large a grid was not replaced by the direct computation at "
+                << fallbackIt.GetIndex() << std::endl;
+      passed = false;
+      break;
+      }
+    }
+  return passed;
+}
+
+// A DomainSigma of 0 along a dimension must not blur along it, nor stop
+// the blur along the other dimensions: constant slices between noisy
+// slices stay constant, and the noise of the other slices is smoothed.
+// The range of the image is small enough for the grid to be used.
+bool
+CheckZeroDomainSigma()
+{
+  typedef itk::Image< float, 3 >                            ImageType;
+  typedef itk::BilateralImageFilter< ImageType, ImageType > FilterType;
+
+  const double constant = 150.0;
+  const double noiseSigma = 10.0;
+
+  ImageType::SizeType size;
+  size[0] = 40;
+  size[1] = 36;
+  size[2] = 6;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(2011);
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if ( it.GetIndex()[2] % 2 )
+      {
+      it.Set( constant );
+      }
+    else
+      {
+      it.Set( 100.0 * ( it.GetIndex()[0] >= 20 ) + noiseSigma * generator->GetNormalVariate() );
+      }
+    }
+
+  FilterType::ArrayType domainSigma;
+  domainSigma[0] = 2.0;
+  domainSigma[1] = 2.0;
+  domainSigma[2] = 0.0;
+  FilterType::Pointer grid = FilterType::New();
+  grid->SetInput(image);
+  grid->SetDomainSigma(domainSigma);
+  grid->SetRangeSigma(30.0);
+  grid->UseBilateralGridOn();
+  TRY_EXPECT_NO_EXCEPTION( grid->Update() );
+
+  double residualNoise = 0.0;
+  itk::ImageRegionIteratorWithIndex< ImageType > gridIt( grid->GetOutput(), image->GetLargestPossibleRegion() );
+  for ( gridIt.GoToBegin(); !gridIt.IsAtEnd(); ++gridIt )
+    {
+    if ( itk::Math::isnan( gridIt.Get() ) )
+      {
+      std::cerr << "NaN with a DomainSigma of 0 at " << gridIt.GetIndex() << std::endl;
+      return false;
+      }
+    if ( gridIt.GetIndex()[2] % 2 == 0 )
+      {
+      const double expected = 100.0 * ( gridIt.GetIndex()[0] >= 20 );
+      residualNoise += ( gridIt.Get() - expected ) * ( gridIt.Get() - expected );
+      }
+    else if ( std::abs( gridIt.Get() - constant ) > 1e-3 )
+      {
+      std::cerr << "Blur along a DomainSigma of 0 at " << gridIt.GetIndex() << ": "
+                << gridIt.Get() << " instead of " << constant << std::endl;
+      return false;
+      }
+    }
+  residualNoise = std::sqrt( residualNoise / ( image->GetLargestPossibleRegion().GetNumberOfPixels() / 2 ) );
+  std::cout << "DomainSigma of 0 along dimension 2: residual noise " << residualNoise << std::endl;
+  if ( residualNoise > noiseSigma / 2 )
+    {
+    std::cerr << "Residual noise too large with a DomainSigma of 0" << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+int itkBilateralImageFilterGridTest(int, char* [])
+{
+  typedef itk::Image< float, 2 > ImageType2D;
+  typedef itk::Image< short, 3 > ImageType3D;
+
+  ImageType2D::SizeType size2D;
+  size2D[0] = 96;
+  size2D[1] = 80;
+  ImageType3D::SizeType size3D;
+  size3D[0] = 40;
+  size3D[1] = 36;
+  size3D[2] = 30;
+
+  bool passed = true;
+  passed &= CompareWithDirectFilter< ImageType2D >(size2D, 2.0);
+  passed &= CompareWithDirectFilter< ImageType2D >(size2D, 4.0);
+  passed &= CompareWithDirectFilter< ImageType3D >(size3D, 2.0);
+  passed &= CheckThreadsAndFallback< ImageType2D >(size2D);
+  passed &= CheckThreadsAndFallback< ImageType3D >(size3D);
+  passed &= CheckZeroDomainSigma();
+
+  if ( !passed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
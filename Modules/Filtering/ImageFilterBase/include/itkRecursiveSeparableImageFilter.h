@@ -22,6 +22,7 @@
 #include "itkNumericTraits.h"
 #include "itkImageRegionSplitterDirection.h"
 #include "itkVariableLengthVector.h"
+#include "itkIsSame.h"
 
 namespace itk
 {
@@ -45,6 +46,11 @@ namespace itk
  * G. Farneback & C.-F. Westin, "On Implementation of Recursive Gaussian
  * Filters", so far unpublished.
  *
+ * When the pixels are scalars and the direction is not 0, the filter
+ * runs on panels of adjacent lines at once: the values at one position
+ * of all the lines of a panel are stored contiguously, so that the
+ * recursion runs over unit-stride data for every direction.
+ *
  * \ingroup ImageFilters
  * \ingroup ITKImageFilterBase
  */
@@ -133,6 +139,13 @@ protected:
   void FilterDataArray(RealType *outs, const RealType *data, RealType *scratch,
                        SizeValueType ln);
 
+  /** Apply the Recursive Filter to a panel of lines of scalar data,
+   * interleaved so that the values at position i of the lines are at
+   * data[i * width] to data[i * width + width - 1]. The results are the
+   * same as those of FilterDataArray() on each line. */
+  void FilterDataArrays(RealType *outs, const RealType *data, RealType *scratch,
+                        SizeValueType ln, SizeValueType width);
+
 protected:
   /** Causal coefficients that multiply the input data. */
   ScalarRealType m_N0;
@@ -227,6 +240,20 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(RecursiveSeparableImageFilter);
 
+  /** Filter the lines of the region one by one. */
+  void FilterLines(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId);
+
+  /** Filter the lines of the region in panels of lines adjacent along
+   * direction 0, for scalar pixels and directions other than 0. */
+  void FilterLinesInPanels(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId,
+                           mpl::TrueType);
+
+  void FilterLinesInPanels(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId,
+                           mpl::FalseType)
+  {
+    this->FilterLines(outputRegionForThread, threadId);
+  }
+
   /** Direction in which the filter is to be applied
    * this should be in the range [0,ImageDimension-1]. */
   unsigned int m_Direction;
@@ -21,8 +21,11 @@
 #include "itkRecursiveSeparableImageFilter.h"
 #include "itkObjectFactory.h"
 #include "itkImageLinearIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
 #include "itkProgressReporter.h"
+#include <algorithm>
 #include <new>
+#include <vector>
 
 namespace itk
 {
@@ -170,6 +173,110 @@ RecursiveSeparableImageFilter< TInputImage, TOutputImage >
     }
 }
 
+/**
+ * Apply Recursive Filter to interleaved lines
+ */
+template< typename TInputImage, typename TOutputImage >
+void
+RecursiveSeparableImageFilter< TInputImage, TOutputImage >
+::FilterDataArrays(RealType *outs, const RealType *data,
+                   RealType *scratch, SizeValueType ln, SizeValueType width)
+{
+  // Local copies of the coefficients, which the compiler cannot
+  // otherwise keep in registers while writing to the arrays.
+  const ScalarRealType n0 = m_N0;
+  const ScalarRealType n1 = m_N1;
+  const ScalarRealType n2 = m_N2;
+  const ScalarRealType n3 = m_N3;
+  const ScalarRealType d1 = m_D1;
+  const ScalarRealType d2 = m_D2;
+  const ScalarRealType d3 = m_D3;
+  const ScalarRealType d4 = m_D4;
+  const ScalarRealType m1 = m_M1;
+  const ScalarRealType m2 = m_M2;
+  const ScalarRealType m3 = m_M3;
+  const ScalarRealType m4 = m_M4;
+
+  const OffsetValueType w1 = static_cast< OffsetValueType >( width );
+  const OffsetValueType w2 = 2 * w1;
+  const OffsetValueType w3 = 3 * w1;
+  const OffsetValueType w4 = 4 * w1;
+
+  RealType * scratch1 = outs;
+  RealType * scratch2 = scratch;
+
+  /**
+   * Causal direction pass, with the same borders as FilterDataArray()
+   */
+  for ( SizeValueType w = 0; w < width; ++w )
+    {
+    RealType *       s = scratch1 + w;
+    const RealType * x = data + w;
+    const RealType   outV1 = x[0];
+
+    s[0]  = outV1 * n0 + outV1 * n1 + outV1 * n2 + outV1 * n3;
+    s[w1] = x[w1] * n0 + outV1 * n1 + outV1 * n2 + outV1 * n3;
+    s[w2] = x[w2] * n0 + x[w1] * n1 + outV1 * n2 + outV1 * n3;
+    s[w3] = x[w3] * n0 + x[w2] * n1 + x[w1] * n2 + outV1 * n3;
+
+    s[0]  -= outV1 * m_BN1 + outV1 * m_BN2 + outV1 * m_BN3 + outV1 * m_BN4;
+    s[w1] -= s[0] * d1 + outV1 * m_BN2 + outV1 * m_BN3 + outV1 * m_BN4;
+    s[w2] -= s[w1] * d1 + s[0] * d2 + outV1 * m_BN3 + outV1 * m_BN4;
+    s[w3] -= s[w2] * d1 + s[w1] * d2 + s[0] * d3 + outV1 * m_BN4;
+    }
+
+  for ( SizeValueType i = 4; i < ln; i++ )
+    {
+    RealType *       s = scratch1 + i * width;
+    const RealType * x = data + i * width;
+    for ( SizeValueType w = 0; w < width; ++w )
+      {
+      s[w] = x[w] * n0 + x[w - w1] * n1 + x[w - w2] * n2 + x[w - w3] * n3;
+      s[w] -= s[w - w1] * d1 + s[w - w2] * d2 + s[w - w3] * d3 + s[w - w4] * d4;
+      }
+    }
+
+  /**
+   * AntiCausal direction pass
+   */
+  for ( SizeValueType w = 0; w < width; ++w )
+    {
+    RealType *       s = scratch2 + ( ln - 1 ) * width + w;
+    const RealType * x = data + ( ln - 1 ) * width + w;
+    const RealType   outV2 = x[0];
+
+    s[0]   = outV2 * m1 + outV2 * m2 + outV2 * m3 + outV2 * m4;
+    s[-w1] = x[0] * m1 + outV2 * m2 + outV2 * m3 + outV2 * m4;
+    s[-w2] = x[-w1] * m1 + x[0] * m2 + outV2 * m3 + outV2 * m4;
+    s[-w3] = x[-w2] * m1 + x[-w1] * m2 + x[0] * m3 + outV2 * m4;
+
+    s[0]   -= outV2 * m_BM1 + outV2 * m_BM2 + outV2 * m_BM3 + outV2 * m_BM4;
+    s[-w1] -= s[0] * d1 + outV2 * m_BM2 + outV2 * m_BM3 + outV2 * m_BM4;
+    s[-w2] -= s[-w1] * d1 + s[0] * d2 + outV2 * m_BM3 + outV2 * m_BM4;
+    s[-w3] -= s[-w2] * d1 + s[-w1] * d2 + s[0] * d3 + outV2 * m_BM4;
+    }
+
+  for ( SizeValueType i = ln - 4; i > 0; i-- )
+    {
+    RealType *       s = scratch2 + ( i - 1 ) * width;
+    const RealType * x = data + i * width;
+    for ( SizeValueType w = 0; w < width; ++w )
+      {
+      s[w] = x[w] * m1 + x[w + w1] * m2 + x[w + w2] * m3 + x[w + w3] * m4;
+      s[w] -= s[w + w1] * d1 + s[w + w2] * d2 + s[w + w3] * d3 + s[w + w4] * d4;
+      }
+    }
+
+  /**
+   * Roll the antiCausal part into the output
+   */
+  const SizeValueType size = ln * width;
+  for ( SizeValueType i = 0; i < size; i++ )
+    {
+    outs[i] += scratch2[i];
+    }
+}
+
 //
 // we need all of the image in just the "Direction" we are separated into
 //
@@ -254,6 +361,22 @@ template< typename TInputImage, typename TOutputImage >
 void
 RecursiveSeparableImageFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId)
+{
+  if ( this->m_Direction == 0 )
+    {
+    // The lines are already contiguous.
+    this->FilterLines(outputRegionForThread, threadId);
+    }
+  else
+    {
+    this->FilterLinesInPanels( outputRegionForThread, threadId, IsSame< RealType, ScalarRealType >() );
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RecursiveSeparableImageFilter< TInputImage, TOutputImage >
+::FilterLines(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId)
 {
   typedef typename TOutputImage::PixelType OutputPixelType;
 
@@ -337,6 +460,101 @@ RecursiveSeparableImageFilter< TInputImage, TOutputImage >
   delete[] scratch;
 }
 
+template< typename TInputImage, typename TOutputImage >
+void
+RecursiveSeparableImageFilter< TInputImage, TOutputImage >
+::FilterLinesInPanels(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId,
+                      mpl::TrueType)
+{
+  typedef typename TOutputImage::PixelType OutputPixelType;
+
+  typedef ImageRegionConstIterator< TInputImage > InputConstIteratorType;
+  typedef ImageRegionIterator< TOutputImage >     OutputIteratorType;
+
+  // Enough lines to fill a few vector registers, few enough for the
+  // buffers of long lines to stay in cache.
+  const SizeValueType panelWidth = 16;
+
+  typename TInputImage::ConstPointer inputImage( this->GetInputImage () );
+  typename TOutputImage::Pointer     outputImage( this->GetOutput() );
+
+  const unsigned int  direction = this->m_Direction;
+  const SizeValueType ln = outputRegionForThread.GetSize(direction);
+  const SizeValueType rowLength = outputRegionForThread.GetSize(0);
+  const SizeValueType numberOfLinesToProcess = outputRegionForThread.GetNumberOfPixels() / ln;
+  ProgressReporter    progress(this, threadId, numberOfLinesToProcess, 10);
+
+  if ( numberOfLinesToProcess == 0 )
+    {
+    return;
+    }
+
+  const SizeValueType     maximumWidth = std::min(panelWidth, rowLength);
+  std::vector< RealType > inps(ln * maximumWidth);
+  std::vector< RealType > outs(ln * maximumWidth);
+  std::vector< RealType > scratch(ln * maximumWidth);
+
+  // A panel is the region of width lines along direction 0, one pixel
+  // thick in the other directions: region iterators visit it in the
+  // interleaved order of FilterDataArrays().
+  const typename OutputImageRegionType::IndexType start = outputRegionForThread.GetIndex();
+  OutputImageRegionType panel = outputRegionForThread;
+  for ( unsigned int d = 1; d < TOutputImage::ImageDimension; ++d )
+    {
+    if ( d != direction )
+      {
+      panel.SetSize(d, 1);
+      }
+    }
+
+  while ( true )
+    {
+    const SizeValueType width =
+      std::min( panelWidth, static_cast< SizeValueType >( start[0] + rowLength - panel.GetIndex(0) ) );
+    panel.SetSize(0, width);
+
+    InputConstIteratorType inputIterator(inputImage, panel);
+    for ( SizeValueType i = 0; !inputIterator.IsAtEnd(); ++inputIterator, ++i )
+      {
+      inps[i] = inputIterator.Get();
+      }
+
+    this->FilterDataArrays(&outs[0], &inps[0], &scratch[0], ln, width);
+
+    OutputIteratorType outputIterator(outputImage, panel);
+    for ( SizeValueType i = 0; !outputIterator.IsAtEnd(); ++outputIterator, ++i )
+      {
+      outputIterator.Set( static_cast< OutputPixelType >( outs[i] ) );
+      }
+
+    for ( SizeValueType w = 0; w < width; ++w )
+      {
+      progress.CompletedPixel();
+      }
+
+    // Next panel
+    unsigned int d = 0;
+    for (; d < TOutputImage::ImageDimension; ++d )
+      {
+      if ( d == direction )
+        {
+        continue;
+        }
+      const OffsetValueType step = ( d == 0 ) ? static_cast< OffsetValueType >( width ) : 1;
+      panel.SetIndex( d, panel.GetIndex(d) + step );
+      if ( panel.GetIndex(d) < start[d] + static_cast< OffsetValueType >( outputRegionForThread.GetSize(d) ) )
+        {
+        break;
+        }
+      panel.SetIndex( d, start[d] );
+      }
+    if ( d == TOutputImage::ImageDimension )
+      {
+      break;
+      }
+    }
+}
+
 template< typename TInputImage, typename TOutputImage >
 void
 RecursiveSeparableImageFilter< TInputImage, TOutputImage >
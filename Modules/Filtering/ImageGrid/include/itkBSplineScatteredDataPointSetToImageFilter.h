@@ -37,6 +37,11 @@ namespace itk
  * matrix to find a least-squares fit is made obsolete.  Therefore,
  * memory issues are not a concern and inverting large matrices is
  * not applicable. In addition, this allows fitting to be multi-threaded.
+ * Each thread accumulates the contributions of the points to its own slab
+ * of the control point lattice, so the memory used by the fitting does not
+ * grow with the number of threads.  The residuals of the points and the
+ * sampled output are computed in parallel as well, the latter by collapsing
+ * the control point lattice one dimension at a time.
  * This class generalizes from Lee's original paper to encompass
  * n-D data in m-D parametric space and any *feasible* B-spline order as well
  * as the option of specifying a confidence value for each point.
@@ -278,6 +283,12 @@ public:
     return static_cast<PointDataImageType *>( this->ProcessObject::GetOutput( 1 ) );
     }
 
+  /** Get the values of the fitted B-spline object at the input points.
+   * Since the B-spline object is linear in its control points, this can be
+   * used to update a field sampled at the input points without evaluating
+   * the control point lattice again. */
+  itkGetConstObjectMacro( OutputPointData, PointDataContainerType );
+
 protected:
   BSplineScatteredDataPointSetToImageFilter();
   virtual ~BSplineScatteredDataPointSetToImageFilter() ITK_OVERRIDE;
@@ -305,6 +316,13 @@ private:
   /** Determine the residuals after fitting to one level. */
   void UpdatePointSet();
 
+  /** Static function used as a "callback" by the MultiThreader to evaluate
+   * the B-spline object at the points. */
+  static ITK_THREAD_RETURN_TYPE UpdatePointSetThreaderCallback( void *arg );
+
+  /** Evaluate the B-spline object at a subset of the points. */
+  void ThreadedUpdatePointSet( ThreadIdType, ThreadIdType );
+
   /** This function is not used as it requires an evaluation of all
    * (SplineOrder+1)^ImageDimensions B-spline weights for each evaluation. */
   void GenerateOutputImage();
@@ -315,10 +333,16 @@ private:
   /** Function used to generate the sampled B-spline object quickly. */
   void ThreadedGenerateDataForReconstruction( const RegionType &, ThreadIdType );
 
-  /** Sub-function used by GenerateOutputImageFast() to generate the sampled
-   * B-spline object quickly. */
-  void CollapsePhiLattice( PointDataImageType *, PointDataImageType *,
-    const RealType, const unsigned int );
+  /** Map a point to the parametric domain of the current control point
+   * lattice. Throws an exception if the point is outside of the domain. */
+  void TransformPointToParametricDomain( const PointType &, RealArrayType & ) const;
+
+  /** Compute the B-spline weights of a parametric coordinate along a
+   * dimension, and the offsets of the corresponding control points in a
+   * lattice of the given size along that dimension and of the given stride. */
+  void ComputeBSplineWeightsAndOffsets( const RealType, const unsigned int,
+    const SizeValueType, const OffsetValueType, RealType *,
+    OffsetValueType * ) const;
 
   /** Set the grid parametric domain parameters such as the origin, size,
    * spacing, and direction. */
@@ -356,8 +380,16 @@ private:
   typename KernelOrder2Type::Pointer           m_KernelOrder2;
   typename KernelOrder3Type::Pointer           m_KernelOrder3;
 
-  std::vector<RealImagePointer>                m_OmegaLatticePerThread;
-  std::vector<PointDataImagePointer>           m_DeltaLatticePerThread;
+  RealImagePointer                             m_OmegaLattice;
+  PointDataImagePointer                        m_DeltaLattice;
+
+  /** The points, sorted by their first control point along the dimension
+   * m_SlabDimension.  The points of the span s are
+   * m_SlabPointIds[m_SlabPointOffsets[s]] to
+   * m_SlabPointIds[m_SlabPointOffsets[s + 1] - 1]. */
+  unsigned int                                 m_SlabDimension;
+  std::vector<SizeValueType>                   m_SlabPointOffsets;
+  std::vector<SizeValueType>                   m_SlabPointIds;
 
   RealType                                     m_BSplineEpsilon;
   bool                                         m_IsFittingComplete;
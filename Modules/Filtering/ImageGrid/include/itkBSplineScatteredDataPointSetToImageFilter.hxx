@@ -21,14 +21,15 @@
 #include "itkBSplineScatteredDataPointSetToImageFilter.h"
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageScanlineIterator.h"
 #include "itkImageDuplicator.h"
 #include "itkCastImageFilter.h"
 #include "itkNumericTraits.h"
 #include "itkMath.h"
 
-#include "itkMath.h"
 #include "vnl/algo/vnl_matrix_inverse.h"
-#include "itkMath.h"
+
+#include <algorithm>
 
 namespace itk
 {
@@ -41,6 +42,7 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
   m_UsePointWeights( false ),
   m_MaximumNumberOfLevels( 1 ),
   m_CurrentLevel( 0 ),
+  m_SlabDimension( 0 ),
   m_BSplineEpsilon( 1e-3 ),
   m_IsFittingComplete( false )
 {
@@ -283,6 +285,7 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
 
   this->m_CurrentLevel = 0;
   this->m_CurrentNumberOfControlPoints = this->m_NumberOfControlPoints;
+  this->m_IsFittingComplete = false;
 
 
   // Set up multithread processing to handle generating the
@@ -431,9 +434,6 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
 {
   if( !this->m_IsFittingComplete )
     {
-    this->m_DeltaLatticePerThread.resize( this->GetNumberOfThreads() );
-    this->m_OmegaLatticePerThread.resize( this->GetNumberOfThreads() );
-
     typename RealImageType::SizeType size;
     for( unsigned int i = 0; i < ImageDimension; i++ )
       {
@@ -447,17 +447,65 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
         }
       }
 
-    for( unsigned int n = 0; n < this->GetNumberOfThreads(); n++ )
+    // The threads share the delta and omega lattices, each of them
+    // accumulating into its own slab of control points.
+
+    this->m_OmegaLattice = RealImageType::New();
+    this->m_OmegaLattice->SetRegions( size );
+    this->m_OmegaLattice->Allocate();
+    this->m_OmegaLattice->FillBuffer( 0.0 );
+
+    this->m_DeltaLattice = PointDataImageType::New();
+    this->m_DeltaLattice->SetRegions( size );
+    this->m_DeltaLattice->Allocate();
+    this->m_DeltaLattice->FillBuffer( NumericTraits<PointDataType>::ZeroValue() );
+
+    // The slabs are cut along the largest dimension of the lattice.
+
+    this->m_SlabDimension = ImageDimension - 1;
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      if( size[i] > size[this->m_SlabDimension] )
+        {
+        this->m_SlabDimension = i;
+        }
+      }
+
+    // Sort the points by the first control point of their support along
+    // the slab dimension so that each thread only visits the points which
+    // contribute to its slab.  The points are also checked here, rather
+    // than in the threads, to be in the parametric domain.
+
+    const TInputPointSet *input = this->GetInput();
+    const SizeValueType numberOfPoints = input->GetNumberOfPoints();
+    const SizeValueType numberOfSpans =
+      this->m_CurrentNumberOfControlPoints[this->m_SlabDimension] -
+      this->m_SplineOrder[this->m_SlabDimension];
+
+    std::vector<SizeValueType> pointSpans( numberOfPoints );
+    this->m_SlabPointOffsets.assign( numberOfSpans + 1, 0 );
+    for( SizeValueType n = 0; n < numberOfPoints; n++ )
       {
-      this->m_OmegaLatticePerThread[n] = RealImageType::New();
-      this->m_OmegaLatticePerThread[n]->SetRegions( size );
-      this->m_OmegaLatticePerThread[n]->Allocate();
-      this->m_OmegaLatticePerThread[n]->FillBuffer( 0.0 );
-
-      this->m_DeltaLatticePerThread[n] = PointDataImageType::New();
-      this->m_DeltaLatticePerThread[n]->SetRegions( size );
-      this->m_DeltaLatticePerThread[n]->Allocate();
-      this->m_DeltaLatticePerThread[n]->FillBuffer( NumericTraits<PointDataType>::ZeroValue() );
+      PointType point;
+      point.Fill( 0.0 );
+      input->GetPoint( n, &point );
+
+      RealArrayType p;
+      this->TransformPointToParametricDomain( point, p );
+      pointSpans[n] = static_cast<SizeValueType>( p[this->m_SlabDimension] );
+      ++this->m_SlabPointOffsets[pointSpans[n] + 1];
+      }
+    for( SizeValueType s = 0; s < numberOfSpans; s++ )
+      {
+      this->m_SlabPointOffsets[s + 1] += this->m_SlabPointOffsets[s];
+      }
+
+    std::vector<SizeValueType> nextPosition( this->m_SlabPointOffsets.begin(),
+      this->m_SlabPointOffsets.end() - 1 );
+    this->m_SlabPointIds.resize( numberOfPoints );
+    for( SizeValueType n = 0; n < numberOfPoints; n++ )
+      {
+      this->m_SlabPointIds[nextPosition[pointSpans[n]]++] = n;
       }
     }
 }
@@ -548,143 +596,141 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
   const TInputPointSet *input = this->GetInput();
 
   // Ignore the output region as we're only interested in dividing the
-  // points among the threads.
-
-  typename RealImageType::SizeType size;
-
-  for( unsigned int i = 0; i < ImageDimension; i++ )
+  // control point lattice among the threads.  Each thread owns a slab of
+  // the lattice along m_SlabDimension and adds the contributions of the
+  // points to the control points of its slab, so that no thread writes to
+  // the control points of another one.
+
+  const typename RealImageType::SizeType size =
+    this->m_OmegaLattice->GetLargestPossibleRegion().GetSize();
+  const unsigned int slabDimension = this->m_SlabDimension;
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+
+  const SizeValueType slabStart =
+    size[slabDimension] * threadId / numberOfThreads;
+  const SizeValueType slabEnd =
+    size[slabDimension] * ( threadId + 1 ) / numberOfThreads;
+  if( slabStart == slabEnd )
     {
-    size[i] = this->m_SplineOrder[i] + 1;
+    return;
     }
-  RealImagePointer neighborhoodWeightImage = RealImageType::New();
-  neighborhoodWeightImage->SetRegions( size );
-  neighborhoodWeightImage->Allocate();
-  neighborhoodWeightImage->FillBuffer( 0.0 );
-
-  ImageRegionIteratorWithIndex<RealImageType> ItW(
-    neighborhoodWeightImage, neighborhoodWeightImage->GetRequestedRegion() );
 
-  RealArrayType p;
-  RealArrayType r;
-  RealArrayType epsilon;
+  OffsetValueType stride[ImageDimension];
+  std::vector<RealType> weights[ImageDimension];
+  std::vector<OffsetValueType> offsets[ImageDimension];
   for( unsigned int i = 0; i < ImageDimension; i++ )
     {
-    r[i] = static_cast<RealType>( this->m_CurrentNumberOfControlPoints[i] -
-      this->m_SplineOrder[i] ) / ( static_cast<RealType>( this->m_Size[i] - 1 ) *
-      this->m_Spacing[i] );
-    epsilon[i] = r[i] * this->m_Spacing[i] * this->m_BSplineEpsilon;
+    stride[i] = ( i == 0 ) ? 1 :
+      stride[i - 1] * static_cast<OffsetValueType>( size[i - 1] );
+    weights[i].resize( this->m_SplineOrder[i] + 1 );
+    offsets[i].resize( this->m_SplineOrder[i] + 1 );
     }
 
-  // Determine which points should be handled by this particular thread.
-
-  ThreadIdType numberOfThreads = this->GetNumberOfThreads();
-  SizeValueType numberOfPointsPerThread = static_cast<SizeValueType>(
-    input->GetNumberOfPoints() / numberOfThreads );
+  RealType *omegaLattice = this->m_OmegaLattice->GetBufferPointer();
+  PointDataType *deltaLattice = this->m_DeltaLattice->GetBufferPointer();
 
-  unsigned int start = threadId * numberOfPointsPerThread;
-  unsigned int end = start + numberOfPointsPerThread;
-  if( threadId == this->GetNumberOfThreads() - 1 )
+  const SizeValueType numberOfSpans = this->m_SlabPointOffsets.size() - 1;
+  for( SizeValueType s = 0; s < numberOfSpans; s++ )
     {
-    end = input->GetNumberOfPoints();
-    }
+    // Skip the points whose support does not intersect the slab.
+    bool intersectsSlab = false;
+    for( unsigned int k = 0; k <= this->m_SplineOrder[slabDimension]; k++ )
+      {
+      const SizeValueType controlPoint = ( s + k ) % size[slabDimension];
+      if( controlPoint >= slabStart && controlPoint < slabEnd )
+        {
+        intersectsSlab = true;
+        break;
+        }
+      }
+    if( !intersectsSlab )
+      {
+      continue;
+      }
 
-  for( unsigned int n = start; n < end; n++ )
-    {
-    PointType point;
-    point.Fill( 0.0 );
+    for( SizeValueType j = this->m_SlabPointOffsets[s];
+      j < this->m_SlabPointOffsets[s + 1]; j++ )
+      {
+      const SizeValueType n = this->m_SlabPointIds[j];
 
-    input->GetPoint( n, &point );
+      PointType point;
+      point.Fill( 0.0 );
+      input->GetPoint( n, &point );
 
-    for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-      unsigned int totalNumberOfSpans =
-        this->m_CurrentNumberOfControlPoints[i] - this->m_SplineOrder[i];
+      RealArrayType p;
+      this->TransformPointToParametricDomain( point, p );
 
-      p[i] = ( point[i] - this->m_Origin[i] ) * r[i];
-      if( std::abs( p[i] - static_cast<RealType>( totalNumberOfSpans ) ) <= epsilon[i] )
-        {
-        p[i] = static_cast<RealType>( totalNumberOfSpans ) - epsilon[i];
-        }
-      if( p[i] < NumericTraits<RealType>::ZeroValue() && std::abs( p[i] ) <= epsilon[i] )
+      // The B-spline weights are separable, and so is the sum of their
+      // squares over the support of the point.
+      RealType w2Sum = 1.0;
+      for( unsigned int i = 0; i < ImageDimension; i++ )
         {
-        p[i] = NumericTraits<RealType>::ZeroValue();
+        this->ComputeBSplineWeightsAndOffsets( p[i], i, size[i], stride[i],
+          &weights[i][0], &offsets[i][0] );
+
+        RealType sum = 0.0;
+        for( unsigned int k = 0; k <= this->m_SplineOrder[i]; k++ )
+          {
+          sum += weights[i][k] * weights[i][k];
+          }
+        w2Sum *= sum;
         }
 
-      if( p[i] < NumericTraits<RealType>::ZeroValue() ||
-          p[i] >= static_cast<RealType>( totalNumberOfSpans ) )
+      // Discard the control points outside of the slab of the thread.
+      for( unsigned int k = 0; k <= this->m_SplineOrder[slabDimension]; k++ )
         {
-        itkExceptionMacro( "The reparameterized point component " << p[i]
-          << " is outside the corresponding parametric domain of [0, "
-          << totalNumberOfSpans << ")." );
+        const SizeValueType controlPoint = static_cast<SizeValueType>(
+          offsets[slabDimension][k] / stride[slabDimension] );
+        if( controlPoint < slabStart || controlPoint >= slabEnd )
+          {
+          offsets[slabDimension][k] = -1;
+          }
         }
-      }
 
-    RealType w2Sum = 0.0;
-    for( ItW.GoToBegin(); !ItW.IsAtEnd(); ++ItW )
-      {
-      RealType B = 1.0;
-      typename RealImageType::IndexType idx = ItW.GetIndex();
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-        {
-        RealType u = static_cast<RealType>( p[i] -
-          static_cast<unsigned>( p[i] ) - idx[i] ) + 0.5 *
-          static_cast<RealType>( this->m_SplineOrder[i] - 1 );
+      const RealType wc = this->m_PointWeights->GetElement( n );
+      const PointDataType data = this->m_InputPointData->GetElement( n );
 
-        switch( this->m_SplineOrder[i] )
+      // Visit the support of the point, the first dimension being the
+      // innermost loop.
+      FixedArray<unsigned int, ImageDimension> k;
+      k.Fill( 0 );
+      while( true )
+        {
+        RealType B = 1.0;
+        OffsetValueType offset = 0;
+        bool isInSlab = true;
+        for( unsigned int i = 1; i < ImageDimension; i++ )
           {
-          case 0:
-            {
-            B *= this->m_KernelOrder0->Evaluate( u );
-            break;
-            }
-          case 1:
-            {
-            B *= this->m_KernelOrder1->Evaluate( u );
-            break;
-            }
-          case 2:
-            {
-            B *= this->m_KernelOrder2->Evaluate( u );
-            break;
-            }
-          case 3:
-            {
-            B *= this->m_KernelOrder3->Evaluate( u );
-            break;
-            }
-          default:
+          isInSlab = isInSlab && ( offsets[i][k[i]] >= 0 );
+          B *= weights[i][k[i]];
+          offset += offsets[i][k[i]];
+          }
+        if( isInSlab )
+          {
+          for( unsigned int k0 = 0; k0 <= this->m_SplineOrder[0]; k0++ )
             {
-            B *= this->m_Kernel[i]->Evaluate( u );
-            break;
+            if( offsets[0][k0] < 0 )
+              {
+              continue;
+              }
+            const RealType t = B * weights[0][k0];
+            omegaLattice[offset + offsets[0][k0]] += wc * t * t;
+            deltaLattice[offset + offsets[0][k0]] +=
+              data * ( t * t * t * wc / w2Sum );
             }
           }
-        }
-      ItW.Set( B );
-      w2Sum += B * B;
-      }
 
-    RealImageType * currentThreadOmegaLattice = this->m_OmegaLatticePerThread[threadId];
-    PointDataImageType * currentThreadDeltaLattice = this->m_DeltaLatticePerThread[threadId];
-
-    for( ItW.GoToBegin(); !ItW.IsAtEnd(); ++ItW )
-      {
-      typename RealImageType::IndexType idx = ItW.GetIndex();
-      for( unsigned int i = 0; i < ImageDimension; i++ )
-        {
-        idx[i] += static_cast<unsigned>( p[i] );
-        if( this->m_CloseDimension[i] )
+        unsigned int i = 1;
+        while( i < ImageDimension && ++k[i] > this->m_SplineOrder[i] )
+          {
+          k[i] = 0;
+          i++;
+          }
+        if( i == ImageDimension )
           {
-          idx[i] %= size[i];
+          break;
           }
         }
-      RealType wc = this->m_PointWeights->GetElement(n);
-      RealType t = ItW.Get();
-      currentThreadOmegaLattice->SetPixel( idx,
-        currentThreadOmegaLattice->GetPixel( idx ) + wc * t * t );
-      PointDataType data = this->m_InputPointData->GetElement( n );
-      data *= ( t * t * t * wc / w2Sum );
-      currentThreadDeltaLattice->SetPixel( idx,
-        currentThreadDeltaLattice->GetPixel( idx ) + data );
       }
     }
 }
@@ -695,41 +741,25 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
 ::ThreadedGenerateDataForReconstruction( const RegionType &region, ThreadIdType
   itkNotUsed( threadId ) )
 {
-  typename PointDataImageType::Pointer collapsedPhiLattices[ImageDimension + 1];
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-    {
-    collapsedPhiLattices[i] = PointDataImageType::New();
-    collapsedPhiLattices[i]->CopyInformation( this->m_PhiLattice );
+  // The B-spline object is a tensor product, so it is sampled by collapsing
+  // the control point lattice one dimension at a time, from the last one,
+  // each time the index of the output changes along that dimension.  Each
+  // output pixel then only costs SplineOrder[0] + 1 products.  The control
+  // point lattice is only read, so it is shared by the threads.
 
-    typename PointDataImageType::SizeType size;
-    size.Fill(1);
-    for( unsigned int j = 0; j < i; j++ )
-      {
-      size[j] = this->m_PhiLattice->GetLargestPossibleRegion().GetSize()[j];
-      }
-    collapsedPhiLattices[i]->SetRegions( size );
-    collapsedPhiLattices[i]->Allocate();
-    }
-  typedef ImageDuplicator<PointDataImageType> ImageDuplicatorType;
-  typename ImageDuplicatorType::Pointer duplicator = ImageDuplicatorType::New();
-  duplicator->SetInputImage( this->m_PhiLattice );
-  duplicator->Update();
-
-  collapsedPhiLattices[ImageDimension] = duplicator->GetModifiableOutput();
+  const typename PointDataImageType::SizeType size =
+    this->m_PhiLattice->GetLargestPossibleRegion().GetSize();
 
   ArrayType totalNumberOfSpans;
   for( unsigned int i = 0; i < ImageDimension; i++ )
     {
     if( this->m_CloseDimension[i] )
       {
-      totalNumberOfSpans[i] =
-        this->m_PhiLattice->GetLargestPossibleRegion().GetSize()[i];
+      totalNumberOfSpans[i] = size[i];
       }
     else
       {
-      totalNumberOfSpans[i] =
-        this->m_PhiLattice->GetLargestPossibleRegion().GetSize()[i] -
-        this->m_SplineOrder[i];
+      totalNumberOfSpans[i] = size[i] - this->m_SplineOrder[i];
       }
     }
 
@@ -746,56 +776,117 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
     epsilon[i] = r[i] * this->m_Spacing[i] * this->m_BSplineEpsilon;
     }
 
-  FixedArray<RealType, ImageDimension> U;
-  FixedArray<RealType, ImageDimension> currentU;
-  currentU.Fill( -1 );
-
   typename ImageType::IndexType startIndex =
     this->GetOutput()->GetRequestedRegion().GetIndex();
-  typename PointDataImageType::IndexType startPhiIndex =
-    this->m_PhiLattice->GetLargestPossibleRegion().GetIndex();
 
-  ImageRegionIteratorWithIndex<ImageType> It( this->GetOutput(), region );
-  for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+  // Tabulate the weights and the offsets of the control points for each
+  // index of the region.
+
+  OffsetValueType stride[ImageDimension];
+  std::vector<RealType> weights[ImageDimension];
+  std::vector<OffsetValueType> offsets[ImageDimension];
+  for( unsigned int i = 0; i < ImageDimension; i++ )
     {
-    typename ImageType::IndexType idx = It.GetIndex();
-    for( unsigned int i = 0; i < ImageDimension; i++ )
+    stride[i] = ( i == 0 ) ? 1 :
+      stride[i - 1] * static_cast<OffsetValueType>( size[i - 1] );
+
+    const unsigned int numberOfWeights = this->m_SplineOrder[i] + 1;
+    weights[i].resize( region.GetSize()[i] * numberOfWeights );
+    offsets[i].resize( region.GetSize()[i] * numberOfWeights );
+    for( SizeValueType j = 0; j < region.GetSize()[i]; j++ )
       {
-      U[i] = static_cast<RealType>( totalNumberOfSpans[i] ) *
-        static_cast<RealType>( idx[i] - startIndex[i] ) /
+      const IndexValueType idx =
+        region.GetIndex()[i] + static_cast<IndexValueType>( j );
+      RealType U = static_cast<RealType>( totalNumberOfSpans[i] ) *
+        static_cast<RealType>( idx - startIndex[i] ) /
         static_cast<RealType>( this->m_Size[i] - 1 );
 
-      if( std::abs( U[i] - static_cast<RealType>( totalNumberOfSpans[i] ) ) <= epsilon[i] )
+      if( std::abs( U - static_cast<RealType>( totalNumberOfSpans[i] ) ) <= epsilon[i] )
         {
-        U[i] = static_cast<RealType>( totalNumberOfSpans[i] ) - epsilon[i];
+        U = static_cast<RealType>( totalNumberOfSpans[i] ) - epsilon[i];
         }
-      if( U[i] < NumericTraits<RealType>::ZeroValue() && std::abs( U[i] ) <= epsilon[i] )
+      if( U < NumericTraits<RealType>::ZeroValue() && std::abs( U ) <= epsilon[i] )
         {
-        U[i] = NumericTraits<RealType>::ZeroValue();
+        U = NumericTraits<RealType>::ZeroValue();
         }
 
-      if( U[i] < NumericTraits<RealType>::ZeroValue() ||
-          U[i] >= static_cast<RealType>( totalNumberOfSpans[i] ) )
+      this->ComputeBSplineWeightsAndOffsets( U, i, size[i], stride[i],
+        &weights[i][j * numberOfWeights], &offsets[i][j * numberOfWeights] );
+      }
+    }
+
+  // collapsedPhiLattices[i] is the lattice collapsed along the dimensions
+  // i to ImageDimension - 1, made of stride[i] control points.
+  std::vector<PointDataType> collapsedPhiLattices[ImageDimension];
+  const PointDataType *collapsedPhiLatticePointers[ImageDimension + 1];
+  collapsedPhiLatticePointers[ImageDimension] =
+    this->m_PhiLattice->GetBufferPointer();
+  for( unsigned int i = 1; i < ImageDimension; i++ )
+    {
+    collapsedPhiLattices[i].resize( stride[i] );
+    collapsedPhiLatticePointers[i] = &collapsedPhiLattices[i][0];
+    }
+
+  const PointDataType zero = NumericTraits<PointDataType>::ZeroValue();
+
+  typename ImageType::IndexType previousIndex = region.GetIndex();
+  bool isFirstLine = true;
+
+  ImageScanlineIterator<ImageType> It( this->GetOutput(), region );
+  while( !It.IsAtEnd() )
+    {
+    const typename ImageType::IndexType index = It.GetIndex();
+
+    unsigned int collapseDimension = 0;
+    for( unsigned int i = ImageDimension - 1; i > 0; i-- )
+      {
+      if( isFirstLine || index[i] != previousIndex[i] )
         {
-        itkExceptionMacro( "The collapse point component " << U[i]
-          << " is outside the corresponding parametric domain of [0, "
-          << totalNumberOfSpans[i] << ")." );
+        collapseDimension = i;
+        break;
         }
       }
-    for( int i = ImageDimension - 1; i >= 0; i-- )
+    for( unsigned int i = collapseDimension; i > 0; i-- )
       {
-      if( Math::NotExactlyEquals(U[i], currentU[i]) )
+      const unsigned int numberOfWeights = this->m_SplineOrder[i] + 1;
+      const SizeValueType j =
+        static_cast<SizeValueType>( index[i] - region.GetIndex()[i] );
+      const RealType *w = &weights[i][j * numberOfWeights];
+      const OffsetValueType *o = &offsets[i][j * numberOfWeights];
+
+      const PointDataType *lattice = collapsedPhiLatticePointers[i + 1];
+      PointDataType *collapsedLattice = &collapsedPhiLattices[i][0];
+      std::fill( collapsedLattice, collapsedLattice + stride[i], zero );
+      for( unsigned int k = 0; k < numberOfWeights; k++ )
         {
-        for( int j = i; j >= 0; j-- )
+        const PointDataType *latticeSlice = lattice + o[k];
+        for( OffsetValueType m = 0; m < stride[i]; m++ )
           {
-          this->CollapsePhiLattice( collapsedPhiLattices[j + 1],
-            collapsedPhiLattices[j], U[j], j );
-          currentU[j] = U[j];
+          collapsedLattice[m] += latticeSlice[m] * w[k];
           }
-        break;
         }
       }
-    It.Set( collapsedPhiLattices[0]->GetPixel( startPhiIndex ) );
+
+    const PointDataType *collapsedLine = collapsedPhiLatticePointers[1];
+    const unsigned int numberOfWeights = this->m_SplineOrder[0] + 1;
+    const RealType *w = &weights[0][0];
+    const OffsetValueType *o = &offsets[0][0];
+    while( !It.IsAtEndOfLine() )
+      {
+      PointDataType data = zero;
+      for( unsigned int k = 0; k < numberOfWeights; k++ )
+        {
+        data += collapsedLine[o[k]] * w[k];
+        }
+      It.Set( data );
+      w += numberOfWeights;
+      o += numberOfWeights;
+      ++It;
+      }
+    It.NextLine();
+
+    previousIndex = index;
+    isFirstLine = false;
     }
 }
 
@@ -806,62 +897,20 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
 {
   if( !this->m_IsFittingComplete )
     {
-    // Accumulate all the delta lattice and omega lattice values to
-    // calculate the final phi lattice.
-
-    ImageRegionIterator< PointDataImageType > ItD(
-      this->m_DeltaLatticePerThread[0],
-      this->m_DeltaLatticePerThread[0]->GetLargestPossibleRegion() );
-    ImageRegionIterator< RealImageType > ItO(
-      this->m_OmegaLatticePerThread[0],
-      this->m_OmegaLatticePerThread[0]->GetLargestPossibleRegion() );
-
-    for( ThreadIdType n = 1; n < this->GetNumberOfThreads(); n++ )
-      {
-      ImageRegionIterator< PointDataImageType > Itd(
-        this->m_DeltaLatticePerThread[n],
-        this->m_DeltaLatticePerThread[n]->GetLargestPossibleRegion() );
-      ImageRegionIterator< RealImageType > Ito(
-        this->m_OmegaLatticePerThread[n],
-        this->m_OmegaLatticePerThread[n]->GetLargestPossibleRegion() );
-
-      ItD.GoToBegin();
-      ItO.GoToBegin();
-      Itd.GoToBegin();
-      Ito.GoToBegin();
-      while( !ItD.IsAtEnd() )
-        {
-        ItD.Set( ItD.Get() + Itd.Get() );
-        ItO.Set( ItO.Get() + Ito.Get() );
-
-        ++ItD;
-        ++ItO;
-        ++Itd;
-        ++Ito;
-        }
-      }
-
     // Generate the control point lattice
 
-    typename RealImageType::SizeType size;
-    for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-      if( this->m_CloseDimension[i] )
-        {
-        size[i] = this->m_CurrentNumberOfControlPoints[i] - this->m_SplineOrder[i];
-        }
-      else
-        {
-        size[i] = this->m_CurrentNumberOfControlPoints[i];
-        }
-      }
     this->m_PhiLattice = PointDataImageType::New();
-    this->m_PhiLattice->SetRegions( size );
+    this->m_PhiLattice->SetRegions(
+      this->m_DeltaLattice->GetLargestPossibleRegion() );
     this->m_PhiLattice->Allocate();
     this->m_PhiLattice->FillBuffer( NumericTraits<PointDataType>::ZeroValue() );
 
     ImageRegionIterator<PointDataImageType> ItP(
       this->m_PhiLattice, this->m_PhiLattice->GetLargestPossibleRegion() );
+    ImageRegionIterator<PointDataImageType> ItD(
+      this->m_DeltaLattice, this->m_DeltaLattice->GetLargestPossibleRegion() );
+    ImageRegionIterator<RealImageType> ItO(
+      this->m_OmegaLattice, this->m_OmegaLattice->GetLargestPossibleRegion() );
 
     for( ItP.GoToBegin(), ItO.GoToBegin(), ItD.GoToBegin(); !ItP.IsAtEnd();
       ++ItP, ++ItO, ++ItD )
@@ -881,6 +930,12 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
         ItP.Set( P );
         }
       }
+
+    // Release the memory used by the fitting of this level.
+
+    this->m_OmegaLattice = ITK_NULLPTR;
+    this->m_DeltaLattice = ITK_NULLPTR;
+    std::vector<SizeValueType>().swap( this->m_SlabPointIds );
     }
 }
 
@@ -1045,171 +1100,190 @@ template<typename TInputPointSet, typename TOutputImage>
 void
 BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
 ::UpdatePointSet()
+{
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(
+    this->UpdatePointSetThreaderCallback, this );
+  this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template<typename TInputPointSet, typename TOutputImage>
+ITK_THREAD_RETURN_TYPE
+BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
+::UpdatePointSetThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *threadInfo =
+    static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  Self *filter = static_cast<Self *>( threadInfo->UserData );
+
+  filter->ThreadedUpdatePointSet( threadInfo->ThreadID,
+    threadInfo->NumberOfThreads );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template<typename TInputPointSet, typename TOutputImage>
+void
+BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
+::ThreadedUpdatePointSet( ThreadIdType threadId, ThreadIdType numberOfThreads )
 {
   const TInputPointSet *input = this->GetInput();
-  PointDataImagePointer collapsedPhiLattices[ImageDimension + 1];
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-    {
-    collapsedPhiLattices[i] = PointDataImageType::New();
-    collapsedPhiLattices[i]->SetOrigin( this->m_PhiLattice->GetOrigin() );
-    collapsedPhiLattices[i]->SetSpacing( this->m_PhiLattice->GetSpacing() );
-    collapsedPhiLattices[i]->SetDirection( this->m_PhiLattice->GetDirection() );
-
-    typename PointDataImageType::SizeType size;
-    size.Fill( 1 );
-    for( unsigned int j = 0; j < i; j++ )
-      {
-      size[j] = this->m_PhiLattice->GetLargestPossibleRegion().GetSize()[j];
-      }
-    collapsedPhiLattices[i]->SetRegions( size );
-    collapsedPhiLattices[i]->Allocate();
-    }
-  collapsedPhiLattices[ImageDimension] = this->m_PhiLattice;
-  ArrayType totalNumberOfSpans;
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-    {
-    if( this->m_CloseDimension[i] )
-      {
-      totalNumberOfSpans[i] =
-        this->m_PhiLattice->GetLargestPossibleRegion().GetSize()[i];
-      }
-    else
-      {
-      totalNumberOfSpans[i] =
-        this->m_PhiLattice->GetLargestPossibleRegion().GetSize()[i] -
-        this->m_SplineOrder[i];
-      }
-    }
 
-  RealArrayType r;
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-    {
-    r[i] = static_cast<RealType>( totalNumberOfSpans[i] ) /
-      ( static_cast<RealType>( this->m_Size[i] - 1 ) * this->m_Spacing[i] );
-    }
+  // Each point only depends on the (SplineOrder + 1)^ImageDimension control
+  // points of its support, so the points are divided among the threads.
 
-  RealArrayType epsilon;
+  const SizeValueType numberOfPoints = input->GetNumberOfPoints();
+  const SizeValueType start = numberOfPoints * threadId / numberOfThreads;
+  const SizeValueType end = numberOfPoints * ( threadId + 1 ) / numberOfThreads;
+
+  const typename PointDataImageType::SizeType size =
+    this->m_PhiLattice->GetLargestPossibleRegion().GetSize();
+  const PointDataType *phiLattice = this->m_PhiLattice->GetBufferPointer();
+
+  OffsetValueType stride[ImageDimension];
+  std::vector<RealType> weights[ImageDimension];
+  std::vector<OffsetValueType> offsets[ImageDimension];
   for( unsigned int i = 0; i < ImageDimension; i++ )
     {
-    epsilon[i] = r[i] * this->m_Spacing[i] * this->m_BSplineEpsilon;
+    stride[i] = ( i == 0 ) ? 1 :
+      stride[i - 1] * static_cast<OffsetValueType>( size[i - 1] );
+    weights[i].resize( this->m_SplineOrder[i] + 1 );
+    offsets[i].resize( this->m_SplineOrder[i] + 1 );
     }
 
-  FixedArray<RealType, ImageDimension> U;
-  FixedArray<RealType, ImageDimension> currentU;
-  currentU.Fill( -1 );
-
-  typename PointDataImageType::IndexType startPhiIndex =
-    this->m_PhiLattice->GetLargestPossibleRegion().GetIndex();
-
-  typename PointDataContainerType::ConstIterator ItIn =
-    this->m_InputPointData->Begin();
-  while( ItIn != this->m_InputPointData->End() )
+  for( SizeValueType n = start; n < end; n++ )
     {
     PointType point;
     point.Fill( 0.0 );
+    input->GetPoint( n, &point );
 
-    input->GetPoint( ItIn.Index(), &point );
-
+    RealArrayType p;
+    this->TransformPointToParametricDomain( point, p );
     for( unsigned int i = 0; i < ImageDimension; i++ )
       {
-      U[i] = static_cast<RealType>( totalNumberOfSpans[i] ) *
-        static_cast<RealType>( point[i] - this->m_Origin[i] ) /
-        ( static_cast<RealType>( this->m_Size[i] - 1 ) * this->m_Spacing[i] );
+      this->ComputeBSplineWeightsAndOffsets( p[i], i, size[i], stride[i],
+        &weights[i][0], &offsets[i][0] );
+      }
+
+    PointDataType data = NumericTraits<PointDataType>::ZeroValue();
 
-      if( std::abs( U[i] - static_cast<RealType>( totalNumberOfSpans[i] ) ) <= epsilon[i] )
+    FixedArray<unsigned int, ImageDimension> k;
+    k.Fill( 0 );
+    while( true )
+      {
+      RealType B = 1.0;
+      OffsetValueType offset = 0;
+      for( unsigned int i = 1; i < ImageDimension; i++ )
         {
-        U[i] = static_cast<RealType>( totalNumberOfSpans[i] ) - epsilon[i];
+        B *= weights[i][k[i]];
+        offset += offsets[i][k[i]];
         }
-      if( U[i] < NumericTraits<RealType>::ZeroValue() && std::abs( U[i] ) <= epsilon[i] )
+      for( unsigned int k0 = 0; k0 <= this->m_SplineOrder[0]; k0++ )
         {
-        U[i] = NumericTraits<RealType>::ZeroValue();
+        data += phiLattice[offset + offsets[0][k0]] * ( B * weights[0][k0] );
         }
 
-      if( U[i] < NumericTraits<RealType>::ZeroValue() ||
-          U[i] >= static_cast<RealType>( totalNumberOfSpans[i] ) )
+      unsigned int i = 1;
+      while( i < ImageDimension && ++k[i] > this->m_SplineOrder[i] )
         {
-        itkExceptionMacro( "The collapse point component " << U[i]
-          << " is outside the corresponding parametric domain of [0, "
-          << totalNumberOfSpans[i] << ")." );
+        k[i] = 0;
+        i++;
         }
-      }
-    for( int i = ImageDimension - 1; i >= 0; i-- )
-      {
-      if( Math::NotExactlyEquals(U[i], currentU[i]) )
+      if( i == ImageDimension )
         {
-        for( int j = i; j >= 0; j-- )
-          {
-          this->CollapsePhiLattice( collapsedPhiLattices[j + 1],
-            collapsedPhiLattices[j], U[j], j );
-          currentU[j] = U[j];
-          }
         break;
         }
       }
-    this->m_OutputPointData->InsertElement( ItIn.Index(),
-      collapsedPhiLattices[0]->GetPixel( startPhiIndex ) );
-    ++ItIn;
+
+    this->m_OutputPointData->SetElement( n, data );
     }
 }
 
 template<typename TInputPointSet, typename TOutputImage>
 void
 BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
-::CollapsePhiLattice( PointDataImageType *lattice,
-  PointDataImageType *collapsedLattice,
-  const RealType u, const unsigned int dimension )
+::TransformPointToParametricDomain( const PointType & point,
+  RealArrayType & p ) const
 {
-  ImageRegionIteratorWithIndex< PointDataImageType > It(
-    collapsedLattice, collapsedLattice->GetLargestPossibleRegion() );
-
-  for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+  for( unsigned int i = 0; i < ImageDimension; i++ )
     {
-    PointDataType data;
-    data.Fill( 0.0 );
-    typename PointDataImageType::IndexType idx = It.GetIndex();
-    for( unsigned int i = 0; i < this->m_SplineOrder[dimension] + 1; i++ )
+    const unsigned int totalNumberOfSpans =
+      this->m_CurrentNumberOfControlPoints[i] - this->m_SplineOrder[i];
+
+    const RealType r = static_cast<RealType>( totalNumberOfSpans ) /
+      ( static_cast<RealType>( this->m_Size[i] - 1 ) * this->m_Spacing[i] );
+    const RealType epsilon = r * this->m_Spacing[i] * this->m_BSplineEpsilon;
+
+    p[i] = ( point[i] - this->m_Origin[i] ) * r;
+    if( std::abs( p[i] - static_cast<RealType>( totalNumberOfSpans ) ) <= epsilon )
       {
-      idx[dimension] = static_cast<unsigned int>( u ) + i;
-      RealType v = u - idx[dimension] + 0.5 * static_cast<RealType>(
-        this->m_SplineOrder[dimension] - 1 );
+      p[i] = static_cast<RealType>( totalNumberOfSpans ) - epsilon;
+      }
+    if( p[i] < NumericTraits<RealType>::ZeroValue() && std::abs( p[i] ) <= epsilon )
+      {
+      p[i] = NumericTraits<RealType>::ZeroValue();
+      }
 
-      RealType B = 0.0;
-      switch( this->m_SplineOrder[dimension] )
+    if( p[i] < NumericTraits<RealType>::ZeroValue() ||
+        p[i] >= static_cast<RealType>( totalNumberOfSpans ) )
+      {
+      itkExceptionMacro( "The reparameterized point component " << p[i]
+        << " is outside the corresponding parametric domain of [0, "
+        << totalNumberOfSpans << ")." );
+      }
+    }
+}
+
+template<typename TInputPointSet, typename TOutputImage>
+void
+BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
+::ComputeBSplineWeightsAndOffsets( const RealType u,
+  const unsigned int dimension, const SizeValueType latticeSize,
+  const OffsetValueType stride, RealType *weights,
+  OffsetValueType *offsets ) const
+{
+  const IndexValueType firstControlPoint = static_cast<IndexValueType>( u );
+  for( unsigned int k = 0; k <= this->m_SplineOrder[dimension]; k++ )
+    {
+    IndexValueType controlPoint = firstControlPoint + k;
+
+    const RealType v = u - controlPoint + 0.5 * static_cast<RealType>(
+      this->m_SplineOrder[dimension] - 1 );
+
+    switch( this->m_SplineOrder[dimension] )
+      {
+      case 0:
         {
-        case 0:
-          {
-          B = this->m_KernelOrder0->Evaluate( v );
-          break;
-          }
-        case 1:
-          {
-          B = this->m_KernelOrder1->Evaluate( v );
-          break;
-          }
-        case 2:
-          {
-          B = this->m_KernelOrder2->Evaluate( v );
-          break;
-          }
-        case 3:
-          {
-          B = this->m_KernelOrder3->Evaluate( v );
-          break;
-          }
-        default:
-          {
-          B = this->m_Kernel[dimension]->Evaluate( v );
-          break;
-          }
+        weights[k] = this->m_KernelOrder0->Evaluate( v );
+        break;
+        }
+      case 1:
+        {
+        weights[k] = this->m_KernelOrder1->Evaluate( v );
+        break;
+        }
+      case 2:
+        {
+        weights[k] = this->m_KernelOrder2->Evaluate( v );
+        break;
         }
-      if( this->m_CloseDimension[dimension] )
+      case 3:
         {
-        idx[dimension] %=
-          lattice->GetLargestPossibleRegion().GetSize()[dimension];
+        weights[k] = this->m_KernelOrder3->Evaluate( v );
+        break;
+        }
+      default:
+        {
+        weights[k] = this->m_Kernel[dimension]->Evaluate( v );
+        break;
         }
-      data += ( lattice->GetPixel( idx ) * B );
       }
-    It.Set( data );
+
+    if( this->m_CloseDimension[dimension] )
+      {
+      controlPoint %= static_cast<IndexValueType>( latticeSize );
+      }
+    offsets[k] = controlPoint * stride;
     }
 }
 
@@ -1321,17 +1395,10 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>
   itkPrintSelfObjectMacro( KernelOrder2 );
   itkPrintSelfObjectMacro( KernelOrder3 );
 
-  os << indent << "Omega lattice per thread: " << std::endl;
-  for( unsigned int i = 0; i < m_OmegaLatticePerThread.size(); i++ )
-    {
-    os << indent << "[" << i <<"]: " << this->m_OmegaLatticePerThread[i] << std::endl;
-    }
+  itkPrintSelfObjectMacro( OmegaLattice );
+  itkPrintSelfObjectMacro( DeltaLattice );
 
-  os << indent << "Delta lattice per thread: " << std::endl;
-  for( unsigned int i = 0; i < m_DeltaLatticePerThread.size(); i++ )
-    {
-    os << indent << "[" << i <<"]: " << this->m_DeltaLatticePerThread[i] << std::endl;
-    }
+  os << indent << "Slab dimension: " << this->m_SlabDimension << std::endl;
 }
 } // end namespace itk
 
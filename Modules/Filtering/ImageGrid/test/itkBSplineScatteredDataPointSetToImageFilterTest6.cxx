@@ -0,0 +1,183 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBSplineControlPointImageFunction.h"
+#include "itkBSplineScatteredDataPointSetToImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkPointSet.h"
+#include "itkTestingMacros.h"
+
+/**
+ * In this test, we fit a 3-D scalar field sampled at random points with
+ * different numbers of threads, with and without a closed dimension.
+ * The control point lattices and the sampled outputs must not depend on
+ * the number of threads, and the sampled outputs must match the
+ * evaluation of the control point lattices by
+ * BSplineControlPointImageFunction.
+ */
+namespace
+{
+
+const unsigned int ParametricDimension = 3;
+
+typedef float                                              RealType;
+typedef itk::Vector<RealType, 1>                           VectorType;
+typedef itk::Image<VectorType, ParametricDimension>        ImageType;
+typedef itk::PointSet<VectorType, ParametricDimension>     PointSetType;
+typedef itk::BSplineScatteredDataPointSetToImageFilter
+  <PointSetType, ImageType>                                FilterType;
+
+bool
+SameImages( const ImageType *expected, const ImageType *actual )
+{
+  itk::ImageRegionConstIteratorWithIndex<ImageType> eIt(
+    expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIteratorWithIndex<ImageType> aIt(
+    actual, actual->GetLargestPossibleRegion() );
+  for( ; !eIt.IsAtEnd(); ++eIt, ++aIt )
+    {
+    if( aIt.IsAtEnd() || eIt.Get() != aIt.Get() )
+      {
+      std::cerr << "Different values at " << eIt.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  return aIt.IsAtEnd();
+}
+
+}
+
+int itkBSplineScatteredDataPointSetToImageFilterTest6( int, char * [] )
+{
+  ImageType::SizeType size;
+  size[0] = 41;
+  size[1] = 33;
+  size[2] = 17;
+  ImageType::SpacingType spacing;
+  ImageType::PointType origin;
+  for( unsigned int i = 0; i < ParametricDimension; i++ )
+    {
+    spacing[i] = 1.0 / ( size[i] - 1 );
+    origin[i] = 0.0;
+    }
+
+  // Sample a smooth function at random points of the parametric domain.
+  PointSetType::Pointer pointSet = PointSetType::New();
+  FilterType::WeightsContainerType::Pointer weights =
+    FilterType::WeightsContainerType::New();
+  unsigned int value = 7;
+  for( unsigned int n = 0; n < 20000; n++ )
+    {
+    PointSetType::PointType point;
+    for( unsigned int i = 0; i < ParametricDimension; i++ )
+      {
+      value = value * 1664525u + 1013904223u;
+      point[i] = ( value >> 8 ) / static_cast<double>( 1u << 24 );
+      }
+    VectorType data;
+    data[0] = std::sin( 6.0 * point[0] ) * std::cos( 4.0 * point[1] ) + point[2] * point[2];
+    pointSet->SetPoint( n, point );
+    pointSet->SetPointData( n, data );
+
+    value = value * 1664525u + 1013904223u;
+    weights->InsertElement( n, 0.5 + ( value >> 8 ) / static_cast<double>( 1u << 24 ) );
+    }
+
+  bool success = true;
+
+  for( unsigned int closeDimension = 0; closeDimension < 2; closeDimension++ )
+    {
+    FilterType::ArrayType close;
+    close.Fill( 0 );
+    close[0] = closeDimension;
+
+    FilterType::Pointer filters[2];
+    const itk::ThreadIdType numberOfThreads[2] = { 1, 4 };
+    for( unsigned int t = 0; t < 2; t++ )
+      {
+      filters[t] = FilterType::New();
+      filters[t]->SetOrigin( origin );
+      filters[t]->SetSpacing( spacing );
+      filters[t]->SetSize( size );
+      filters[t]->SetInput( pointSet );
+      filters[t]->SetPointWeights( weights );
+      filters[t]->SetSplineOrder( 3 );
+      FilterType::ArrayType ncps;
+      ncps.Fill( 4 );
+      ncps[2] = 5;
+      filters[t]->SetNumberOfControlPoints( ncps );
+      filters[t]->SetNumberOfLevels( 3 );
+      filters[t]->SetCloseDimension( close );
+      filters[t]->SetNumberOfThreads( numberOfThreads[t] );
+
+      TRY_EXPECT_NO_EXCEPTION( filters[t]->Update() );
+      }
+
+    // The results do not depend on the number of threads.
+    FilterType::PointDataImagePointer phiLattice = filters[0]->GetPhiLattice();
+    success &= SameImages( phiLattice, filters[1]->GetPhiLattice() );
+    success &= SameImages( filters[0]->GetOutput(), filters[1]->GetOutput() );
+
+    // The sampled output is the B-spline object of the control points.
+    typedef itk::BSplineControlPointImageFunction<ImageType> BSplinerType;
+    BSplinerType::Pointer bspliner = BSplinerType::New();
+    bspliner->SetOrigin( origin );
+    bspliner->SetSpacing( spacing );
+    bspliner->SetSize( size );
+    bspliner->SetSplineOrder( 3 );
+    bspliner->SetCloseDimension( close );
+    bspliner->SetInputImage( phiLattice );
+
+    double maximumError = 0.0;
+    itk::ImageRegionConstIteratorWithIndex<ImageType> It(
+      filters[1]->GetOutput(), filters[1]->GetOutput()->GetLargestPossibleRegion() );
+    for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+      {
+      // BSplineControlPointImageFunction pushes the upper edge of the
+      // domain inside by a different epsilon.
+      bool isOnUpperEdge = false;
+      for( unsigned int i = 0; i < ParametricDimension; i++ )
+        {
+        isOnUpperEdge |= ( It.GetIndex()[i] == static_cast<itk::IndexValueType>( size[i] - 1 ) );
+        }
+      if( isOnUpperEdge )
+        {
+        continue;
+        }
+      const double error = itk::Math::abs(
+        bspliner->EvaluateAtIndex( It.GetIndex() )[0] - It.Get()[0] );
+      maximumError = std::max( maximumError, error );
+      }
+    std::cout << "Close dimension: " << close << ", maximum difference with "
+              << "BSplineControlPointImageFunction: " << maximumError << std::endl;
+    if( maximumError > 1e-5 )
+      {
+      std::cerr << "The sampled output does not match the control point lattice."
+                << std::endl;
+      success = false;
+      }
+    }
+
+  if( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -49,6 +49,16 @@ namespace itk
  * threaded. It computes statistics in each thread then combines them in
  * its AfterThreadedGenerate method.
  *
+ * When the label image has an integer pixel type, each thread stores
+ * the statistics of the labels of its region in an array indexed by the
+ * label, which grows with the range of the labels found so far.  When
+ * this range exceeds both 1024 labels and four times the number of
+ * labels found, the thread moves its statistics to a hash map.
+ * The arrays of the threads are combined in parallel, each thread
+ * combining a range of labels.  The threads only record the histogram
+ * bins which are hit by each label, and the histograms are built when
+ * the statistics of the threads are combined.
+ *
  * \ingroup MathematicalStatisticsImageFilters
  * \ingroup ITKImageStatistics
  *
@@ -354,7 +364,98 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(LabelStatisticsImageFilter);
 
-  std::vector< MapType >        m_LabelStatisticsPerThread;
+  typedef typename HistogramType::InstanceIdentifier    BinIdentifierType;
+  typedef typename HistogramType::AbsoluteFrequencyType BinFrequencyType;
+
+  /** Histogram of a label in a thread: the frequencies of the bins
+   * between the first and the last bin hit by the label. */
+  struct SparseHistogramType
+  {
+    SparseHistogramType() : m_FirstBin( 0 ) {}
+
+    void IncreaseFrequency(BinIdentifierType bin, BinFrequencyType frequency)
+    {
+      if ( m_Frequencies.empty() )
+        {
+        m_FirstBin = bin;
+        }
+      else if ( bin < m_FirstBin )
+        {
+        m_Frequencies.insert( m_Frequencies.begin(), m_FirstBin - bin, 0 );
+        m_FirstBin = bin;
+        }
+      if ( bin - m_FirstBin >= m_Frequencies.size() )
+        {
+        m_Frequencies.resize( bin - m_FirstBin + 1, 0 );
+        }
+      m_Frequencies[bin - m_FirstBin] += frequency;
+    }
+
+    BinIdentifierType               m_FirstBin;
+    std::vector< BinFrequencyType > m_Frequencies;
+  };
+
+  /** Statistics accumulated by a thread for a label. */
+  struct LabelAccumulator
+  {
+    LabelAccumulator();
+
+    void Merge(const LabelAccumulator & other);
+
+    IdentifierType      m_Count;
+    RealType            m_Minimum;
+    RealType            m_Maximum;
+    RealType            m_Sum;
+    RealType            m_SumOfSquares;
+    IndexValueType      m_BoundingBox[2 * ImageDimension];
+    SparseHistogramType m_Histogram;
+  };
+
+  typedef std::vector< LabelAccumulator >                        DenseAccumulatorType;
+  typedef itksys::hash_map< LabelPixelType, LabelAccumulator >   AccumulatorMapType;
+
+  /** Statistics accumulated by a thread: in an array indexed by
+   * label - m_FirstLabel if m_Dense is true, in a map otherwise. */
+  struct ThreadAccumulator
+  {
+    bool                 m_Dense;
+    LabelPixelType       m_FirstLabel;
+    SizeValueType        m_NumberOfLabels;
+    DenseAccumulatorType m_DenseAccumulators;
+    AccumulatorMapType   m_Accumulators;
+  };
+
+  /** Offset of a label in an array starting at firstLabel. */
+  static SizeValueType LabelOffset(LabelPixelType label, LabelPixelType firstLabel)
+  {
+    return static_cast< SizeValueType >( label ) - static_cast< SizeValueType >( firstLabel );
+  }
+
+  /** Statistics of a label in the accumulator of a thread.  The array
+   * is enlarged to hold the label, or replaced by a map if its range
+   * would be too large for the number of labels. */
+  static LabelAccumulator & GetLabelAccumulator(ThreadAccumulator & accumulator, LabelPixelType label);
+
+  /** Combine the arrays of the threads for the labels
+   * [firstLabel + begin, firstLabel + end). */
+  void MergeDenseAccumulators(SizeValueType begin, SizeValueType end);
+
+  static ITK_THREAD_RETURN_TYPE MergeThreaderCallback(void *arg);
+
+  /** Internal structure used for passing the filter to the threads. */
+  struct MergeThreadStruct
+  {
+    Self *Filter;
+  };
+
+  /** Create the statistics of a label from the combined accumulator. */
+  void AddLabelStatistics(LabelPixelType label, const LabelAccumulator & accumulator);
+
+  std::vector< ThreadAccumulator > m_ThreadAccumulators;
+  DenseAccumulatorType             m_MergedAccumulators;
+  LabelPixelType                   m_MergedFirstLabel;
+  HistogramPointer                 m_HistogramTemplate;
+
   MapType                       m_LabelStatistics;
   ValidLabelValuesContainerType m_ValidLabelValues;
 
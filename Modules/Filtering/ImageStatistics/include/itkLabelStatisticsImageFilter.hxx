@@ -19,9 +19,10 @@
 #define itkLabelStatisticsImageFilter_hxx
 #include "itkLabelStatisticsImageFilter.h"
 
-#include "itkImageLinearConstIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
 #include "itkImageScanlineConstIterator.h"
 #include "itkProgressReporter.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -35,6 +36,7 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
   m_NumBins[0] = 20;
   m_LowerBound = static_cast< RealType >( NumericTraits< PixelType >::NonpositiveMin() );
   m_UpperBound = static_cast< RealType >( NumericTraits< PixelType >::max() );
+  m_MergedFirstLabel = NumericTraits< LabelPixelType >::ZeroValue();
   m_ValidLabelValues.clear();
 }
 
@@ -72,6 +74,63 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
   m_UseHistograms = true;
 }
 
+template< typename TInputImage, typename TLabelImage >
+LabelStatisticsImageFilter< TInputImage, TLabelImage >
+::LabelAccumulator::LabelAccumulator() :
+  m_Count( NumericTraits< IdentifierType >::ZeroValue() ),
+  // Set such that the first pixel encountered can be compared
+  m_Minimum( NumericTraits< RealType >::max() ),
+  m_Maximum( NumericTraits< RealType >::NonpositiveMin() ),
+  m_Sum( NumericTraits< RealType >::ZeroValue() ),
+  m_SumOfSquares( NumericTraits< RealType >::ZeroValue() )
+{
+  for ( unsigned int i = 0; i < ImageDimension * 2; i += 2 )
+    {
+    m_BoundingBox[i] = NumericTraits< IndexValueType >::max();
+    m_BoundingBox[i + 1] = NumericTraits< IndexValueType >::NonpositiveMin();
+    }
+}
+
+template< typename TInputImage, typename TLabelImage >
+void
+LabelStatisticsImageFilter< TInputImage, TLabelImage >
+::LabelAccumulator::Merge(const LabelAccumulator & other)
+{
+  m_Count += other.m_Count;
+  m_Sum += other.m_Sum;
+  m_SumOfSquares += other.m_SumOfSquares;
+
+  if ( m_Minimum > other.m_Minimum )
+    {
+    m_Minimum = other.m_Minimum;
+    }
+  if ( m_Maximum < other.m_Maximum )
+    {
+    m_Maximum = other.m_Maximum;
+    }
+
+  //bounding box is min,max pairs
+  for ( unsigned int ii = 0; ii < ( ImageDimension * 2 ); ii += 2 )
+    {
+    if ( m_BoundingBox[ii] > other.m_BoundingBox[ii] )
+      {
+      m_BoundingBox[ii] = other.m_BoundingBox[ii];
+      }
+    if ( m_BoundingBox[ii + 1] < other.m_BoundingBox[ii + 1] )
+      {
+      m_BoundingBox[ii + 1] = other.m_BoundingBox[ii + 1];
+      }
+    }
+
+  for ( BinIdentifierType bin = 0; bin < other.m_Histogram.m_Frequencies.size(); ++bin )
+    {
+    if ( other.m_Histogram.m_Frequencies[bin] > 0 )
+      {
+      m_Histogram.IncreaseFrequency( other.m_Histogram.m_FirstBin + bin, other.m_Histogram.m_Frequencies[bin] );
+      }
+    }
+}
+
 template< typename TInputImage, typename TLabelImage >
 void
 LabelStatisticsImageFilter< TInputImage, TLabelImage >
@@ -80,12 +139,22 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
   ThreadIdType numberOfThreads = this->GetNumberOfThreads();
 
   // Resize the thread temporaries
-  m_LabelStatisticsPerThread.resize(numberOfThreads);
+  m_ThreadAccumulators.resize(numberOfThreads);
 
   // Initialize the temporaries
   for ( ThreadIdType i = 0; i < numberOfThreads; ++i )
     {
-    m_LabelStatisticsPerThread[i].clear();
+    m_ThreadAccumulators[i].m_Dense = false;
+    m_ThreadAccumulators[i].m_DenseAccumulators.clear();
+    m_ThreadAccumulators[i].m_Accumulators.clear();
+    }
+
+  // The threads find the bins of the values with a histogram shared by
+  // all the labels, so that they do not need a histogram per label.
+  m_HistogramTemplate = ITK_NULLPTR;
+  if ( m_UseHistograms )
+    {
+    m_HistogramTemplate = LabelStatistics(m_NumBins[0], m_LowerBound, m_UpperBound).m_Histogram;
     }
 
   // Initialize the final map
@@ -98,81 +167,111 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
 ::AfterThreadedGenerateData()
 {
   MapIterator      mapIt;
-  MapConstIterator threadIt;
   ThreadIdType     i;
   ThreadIdType     numberOfThreads = this->GetNumberOfThreads();
 
-  // Run through the map for each thread and accumulate the count,
-  // sum, and sumofsquares
+  // The arrays of the threads can be combined in a single array if
+  // all the threads used one, and if the labels of the threads overlap
+  // enough for the combined array not to be much larger.
+  bool           dense = true;
+  bool           anyLabel = false;
+  LabelPixelType firstLabel = NumericTraits< LabelPixelType >::ZeroValue();
+  LabelPixelType lastLabel = NumericTraits< LabelPixelType >::ZeroValue();
+  SizeValueType  totalSize = 0;
   for ( i = 0; i < numberOfThreads; i++ )
     {
-    // iterate over the map for this thread
-    for ( threadIt = m_LabelStatisticsPerThread[i].begin();
-          threadIt != m_LabelStatisticsPerThread[i].end();
-          ++threadIt )
+    const ThreadAccumulator & threadAccumulator = m_ThreadAccumulators[i];
+    if ( threadAccumulator.m_Dense )
       {
-      // does this label exist in the cumulative structure yet?
-      mapIt = m_LabelStatistics.find( ( *threadIt ).first );
-      if ( mapIt == m_LabelStatistics.end() )
+      const LabelPixelType threadFirst = threadAccumulator.m_FirstLabel;
+      const LabelPixelType threadLast = static_cast< LabelPixelType >(
+        static_cast< SizeValueType >( threadFirst ) + threadAccumulator.m_DenseAccumulators.size() - 1 );
+      if ( !anyLabel || threadFirst < firstLabel )
         {
-        // create a new entry
-        typedef typename MapType::value_type MapValueType;
-        if ( m_UseHistograms )
-          {
-          mapIt = m_LabelStatistics.insert( MapValueType( ( *threadIt ).first,
-                                                          LabelStatistics(m_NumBins[0], m_LowerBound,
-                                                                          m_UpperBound) ) ).first;
-          }
-        else
-          {
-          mapIt = m_LabelStatistics.insert( MapValueType( ( *threadIt ).first,
-                                                          LabelStatistics() ) ).first;
-          }
+        firstLabel = threadFirst;
         }
-
-
-      typename MapType::mapped_type &labelStats = ( *mapIt ).second;
-
-      // accumulate the information from this thread
-      labelStats.m_Count += ( *threadIt ).second.m_Count;
-      labelStats.m_Sum += ( *threadIt ).second.m_Sum;
-      labelStats.m_SumOfSquares += ( *threadIt ).second.m_SumOfSquares;
-
-      if ( labelStats.m_Minimum > ( *threadIt ).second.m_Minimum )
+      if ( !anyLabel || threadLast > lastLabel )
         {
-        labelStats.m_Minimum = ( *threadIt ).second.m_Minimum;
+        lastLabel = threadLast;
         }
-      if ( labelStats.m_Maximum < ( *threadIt ).second.m_Maximum )
+      anyLabel = true;
+      totalSize += threadAccumulator.m_DenseAccumulators.size();
+      }
+    else if ( !threadAccumulator.m_Accumulators.empty() )
+      {
+      dense = false;
+      }
+    }
+
+  if ( dense && anyLabel && LabelOffset(lastLabel, firstLabel) < totalSize )
+    {
+    // Combine the arrays in parallel, each thread taking a range of
+    // labels.  The statistics of the threads are accumulated in thread
+    // order, as in the serial case.
+    m_MergedFirstLabel = firstLabel;
+    m_MergedAccumulators.clear();
+    m_MergedAccumulators.resize( LabelOffset(lastLabel, firstLabel) + 1 );
+
+    MergeThreadStruct str;
+    str.Filter = this;
+    this->GetMultiThreader()->SetNumberOfThreads(numberOfThreads);
+    this->GetMultiThreader()->SetSingleMethod(this->MergeThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+
+    for ( SizeValueType k = 0; k < m_MergedAccumulators.size(); ++k )
+      {
+      if ( m_MergedAccumulators[k].m_Count > 0 )
         {
-        labelStats.m_Maximum = ( *threadIt ).second.m_Maximum;
+        AddLabelStatistics( static_cast< LabelPixelType >( static_cast< SizeValueType >( firstLabel ) + k ),
+                            m_MergedAccumulators[k] );
         }
-
-      //bounding box is min,max pairs
-      for ( unsigned int ii = 0; ii < ( ImageDimension * 2 ); ii += 2 )
+      }
+    m_MergedAccumulators.clear();
+    }
+  else
+    {
+    // Run through the statistics of each thread and accumulate the
+    // count, sum, and sumofsquares
+    AccumulatorMapType merged;
+    for ( i = 0; i < numberOfThreads; i++ )
+      {
+      const ThreadAccumulator & threadAccumulator = m_ThreadAccumulators[i];
+      if ( threadAccumulator.m_Dense )
         {
-        if ( labelStats.m_BoundingBox[ii] > ( *threadIt ).second.m_BoundingBox[ii] )
+        const DenseAccumulatorType & accumulators = threadAccumulator.m_DenseAccumulators;
+        for ( SizeValueType k = 0; k < accumulators.size(); ++k )
           {
-          labelStats.m_BoundingBox[ii] = ( *threadIt ).second.m_BoundingBox[ii];
-          }
-        if ( labelStats.m_BoundingBox[ii + 1] < ( *threadIt ).second.m_BoundingBox[ii + 1] )
-          {
-          labelStats.m_BoundingBox[ii + 1] = ( *threadIt ).second.m_BoundingBox[ii + 1];
+          if ( accumulators[k].m_Count > 0 )
+            {
+            const LabelPixelType label = static_cast< LabelPixelType >(
+              static_cast< SizeValueType >( threadAccumulator.m_FirstLabel ) + k );
+            merged[label].Merge( accumulators[k] );
+            }
           }
         }
-
-      // if enabled, update the histogram for this label
-      if ( m_UseHistograms )
+      else
         {
-        typename HistogramType::IndexType index;
-        index.SetSize(1);
-        for ( unsigned int bin = 0; bin < m_NumBins[0]; bin++ )
+        for ( typename AccumulatorMapType::const_iterator threadIt = threadAccumulator.m_Accumulators.begin();
+              threadIt != threadAccumulator.m_Accumulators.end();
+              ++threadIt )
           {
-          index[0] = bin;
-          labelStats.m_Histogram->IncreaseFrequency( bin, ( *threadIt ).second.m_Histogram->GetFrequency(bin) );
+          merged[threadIt->first].Merge( threadIt->second );
           }
         }
-      } // end of thread map iterator loop
-    }   // end of thread loop
+      }
+    for ( typename AccumulatorMapType::const_iterator it = merged.begin(); it != merged.end(); ++it )
+      {
+      AddLabelStatistics( it->first, it->second );
+      }
+    }
+
+  // Release the memory of the threads
+  for ( i = 0; i < numberOfThreads; i++ )
+    {
+    m_ThreadAccumulators[i].m_DenseAccumulators.clear();
+    m_ThreadAccumulators[i].m_Accumulators.clear();
+    }
+  m_HistogramTemplate = ITK_NULLPTR;
 
   // compute the remainder of the statistics
   for ( mapIt = m_LabelStatistics.begin();
@@ -217,6 +316,154 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
     }
 }
 
+template< typename TInputImage, typename TLabelImage >
+ITK_THREAD_RETURN_TYPE
+LabelStatisticsImageFilter< TInputImage, TLabelImage >
+::MergeThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  MergeThreadStruct * str = static_cast< MergeThreadStruct * >( info->UserData );
+
+  const SizeValueType numberOfLabels = str->Filter->m_MergedAccumulators.size();
+  const SizeValueType begin = numberOfLabels * info->ThreadID / info->NumberOfThreads;
+  const SizeValueType end = numberOfLabels * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+  str->Filter->MergeDenseAccumulators(begin, end);
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TLabelImage >
+void
+LabelStatisticsImageFilter< TInputImage, TLabelImage >
+::MergeDenseAccumulators(SizeValueType begin, SizeValueType end)
+{
+  for ( typename std::vector< ThreadAccumulator >::const_iterator threadIt = m_ThreadAccumulators.begin();
+        threadIt != m_ThreadAccumulators.end(); ++threadIt )
+    {
+    if ( !threadIt->m_Dense )
+      {
+      continue;
+      }
+    // the labels of this thread in [begin, end)
+    const SizeValueType threadBegin = LabelOffset(threadIt->m_FirstLabel, m_MergedFirstLabel);
+    const SizeValueType threadEnd = threadBegin + threadIt->m_DenseAccumulators.size();
+    const SizeValueType first = std::max(begin, threadBegin);
+    const SizeValueType last = std::min(end, threadEnd);
+    for ( SizeValueType k = first; k < last; ++k )
+      {
+      const LabelAccumulator & accumulator = threadIt->m_DenseAccumulators[k - threadBegin];
+      if ( accumulator.m_Count > 0 )
+        {
+        m_MergedAccumulators[k].Merge(accumulator);
+        }
+      }
+    }
+}
+
+template< typename TInputImage, typename TLabelImage >
+void
+LabelStatisticsImageFilter< TInputImage, TLabelImage >
+::AddLabelStatistics(LabelPixelType label, const LabelAccumulator & accumulator)
+{
+  // create a new entry
+  typedef typename MapType::value_type MapValueType;
+  MapIterator mapIt;
+  if ( m_UseHistograms )
+    {
+    mapIt = m_LabelStatistics.insert( MapValueType( label,
+                                                    LabelStatistics(m_NumBins[0], m_LowerBound,
+                                                                    m_UpperBound) ) ).first;
+    }
+  else
+    {
+    mapIt = m_LabelStatistics.insert( MapValueType( label,
+                                                    LabelStatistics() ) ).first;
+    }
+
+  typename MapType::mapped_type &labelStats = ( *mapIt ).second;
+
+  labelStats.m_Count = accumulator.m_Count;
+  labelStats.m_Sum = accumulator.m_Sum;
+  labelStats.m_SumOfSquares = accumulator.m_SumOfSquares;
+  labelStats.m_Minimum = accumulator.m_Minimum;
+  labelStats.m_Maximum = accumulator.m_Maximum;
+  for ( unsigned int ii = 0; ii < ( ImageDimension * 2 ); ++ii )
+    {
+    labelStats.m_BoundingBox[ii] = accumulator.m_BoundingBox[ii];
+    }
+
+  // if enabled, fill the histogram for this label
+  if ( m_UseHistograms )
+    {
+    const SparseHistogramType & histogram = accumulator.m_Histogram;
+    for ( BinIdentifierType bin = 0; bin < histogram.m_Frequencies.size(); ++bin )
+      {
+      if ( histogram.m_Frequencies[bin] > 0 )
+        {
+        labelStats.m_Histogram->IncreaseFrequency( histogram.m_FirstBin + bin, histogram.m_Frequencies[bin] );
+        }
+      }
+    }
+}
+
+template< typename TInputImage, typename TLabelImage >
+typename LabelStatisticsImageFilter< TInputImage, TLabelImage >::LabelAccumulator &
+LabelStatisticsImageFilter< TInputImage, TLabelImage >
+::GetLabelAccumulator(ThreadAccumulator & threadAccumulator, LabelPixelType label)
+{
+  if ( threadAccumulator.m_Dense )
+    {
+    DenseAccumulatorType & accumulators = threadAccumulator.m_DenseAccumulators;
+    if ( accumulators.empty() )
+      {
+      threadAccumulator.m_FirstLabel = label;
+      }
+    const LabelPixelType firstLabel = std::min( label, threadAccumulator.m_FirstLabel );
+    const SizeValueType  offset = LabelOffset(threadAccumulator.m_FirstLabel, firstLabel);
+    SizeValueType        lastOffset = LabelOffset(label, firstLabel);
+    if ( !accumulators.empty() )
+      {
+      lastOffset = std::max( lastOffset, offset + accumulators.size() - 1 );
+      }
+
+    // the array may hold a few times more labels than those found, or
+    // 1024 labels, whatever the number of labels
+    if ( lastOffset < std::max( static_cast< SizeValueType >( 1024 ), 4 * ( threadAccumulator.m_NumberOfLabels + 1 ) ) )
+      {
+      const SizeValueType size = lastOffset + 1;
+      if ( offset > 0 )
+        {
+        accumulators.insert( accumulators.begin(), offset, LabelAccumulator() );
+        threadAccumulator.m_FirstLabel = firstLabel;
+        }
+      if ( size > accumulators.size() )
+        {
+        accumulators.resize(size);
+        }
+      LabelAccumulator & labelAccumulator = accumulators[LabelOffset(label, firstLabel)];
+      if ( labelAccumulator.m_Count == 0 )
+        {
+        ++threadAccumulator.m_NumberOfLabels;
+        }
+      return labelAccumulator;
+      }
+
+    // the labels are too scattered: move the statistics to a map
+    for ( SizeValueType k = 0; k < accumulators.size(); ++k )
+      {
+      if ( accumulators[k].m_Count > 0 )
+        {
+        const LabelPixelType arrayLabel = static_cast< LabelPixelType >(
+          static_cast< SizeValueType >( threadAccumulator.m_FirstLabel ) + k );
+        threadAccumulator.m_Accumulators[arrayLabel] = accumulators[k];
+        }
+      }
+    DenseAccumulatorType().swap(accumulators);
+    threadAccumulator.m_Dense = false;
+    }
+  return threadAccumulator.m_Accumulators[label];
+}
+
 template< typename TInputImage, typename TLabelImage >
 void
 LabelStatisticsImageFilter< TInputImage, TLabelImage >
@@ -233,14 +480,20 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
     return;
     }
 
-  ImageLinearConstIteratorWithIndex< TInputImage > it (this->GetInput(),
-                                                       outputRegionForThread);
+  const BinIdentifierType numberOfBins = m_NumBins[0];
+  const RealType binScale = static_cast< RealType >( numberOfBins ) / ( m_UpperBound - m_LowerBound );
+
+  // the array of the statistics grows with the range of the labels
+  ThreadAccumulator & threadAccumulator = m_ThreadAccumulators[threadId];
+  threadAccumulator.m_Dense = NumericTraits< LabelPixelType >::IsInteger;
+  threadAccumulator.m_NumberOfLabels = 0;
+
+  ImageScanlineConstIterator< TInputImage > it (this->GetInput(),
+                                                outputRegionForThread);
 
   ImageScanlineConstIterator< TLabelImage > labelIt (this->GetLabelInput(),
                                                      outputRegionForThread);
 
-  MapIterator mapIt;
-
   // support progress methods/callbacks
   const size_t numberOfLinesToProcess = outputRegionForThread.GetNumberOfPixels() / size0;
   ProgressReporter progress( this, threadId, static_cast<SizeValueType>( numberOfLinesToProcess ) );
@@ -248,72 +501,89 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
   // do the work
   while ( !it.IsAtEnd() )
     {
+    const IndexType lineIndex = it.GetIndex();
+    IndexValueType  index0 = lineIndex[0];
     while ( !it.IsAtEndOfLine() )
       {
-      const RealType & value = static_cast< RealType >( it.Get() );
+      // the statistics of a label are looked up once for each run of
+      // pixels with this label
+      const LabelPixelType label = labelIt.Get();
+      LabelAccumulator *   labelStats = &GetLabelAccumulator(threadAccumulator, label);
 
-      const LabelPixelType & label = labelIt.Get();
-
-      // is the label already in this thread?
-      mapIt = m_LabelStatisticsPerThread[threadId].find(label);
-      if ( mapIt == m_LabelStatisticsPerThread[threadId].end() )
+      const IndexValueType runStart = index0;
+      do
         {
-        // create a new statistics object
-        typedef typename MapType::value_type MapValueType;
-        if ( m_UseHistograms )
+        const RealType & value = static_cast< RealType >( it.Get() );
+
+        // update the values for this label and this thread
+        if ( value < labelStats->m_Minimum )
           {
-          mapIt = m_LabelStatisticsPerThread[threadId].insert( MapValueType( label,
-                                                                             LabelStatistics(m_NumBins[0], m_LowerBound,
-                                                                                             m_UpperBound) ) ).first;
+          labelStats->m_Minimum = value;
           }
-        else
+        if ( value > labelStats->m_Maximum )
           {
-          mapIt = m_LabelStatisticsPerThread[threadId].insert( MapValueType( label,
-                                                                             LabelStatistics() ) ).first;
+          labelStats->m_Maximum = value;
           }
-        }
 
-      typename MapType::mapped_type &labelStats = ( *mapIt ).second;
+        labelStats->m_Sum += value;
+        labelStats->m_SumOfSquares += ( value * value );
+        labelStats->m_Count++;
+
+        // if enabled, update the histogram for this label
+        if ( m_UseHistograms )
+          {
+          // guess the bin from the bin width, and check it against the
+          // bounds of the bin computed by the histogram
+          BinIdentifierType bin = numberOfBins;
+          const RealType position = ( value - m_LowerBound ) * binScale;
+          if ( position >= 0 && position < numberOfBins )
+            {
+            bin = static_cast< BinIdentifierType >( position );
+            if ( value < m_HistogramTemplate->GetBinMin(0, bin) || value >= m_HistogramTemplate->GetBinMax(0, bin) )
+              {
+              bin = numberOfBins;
+              }
+            }
+          if ( bin == numberOfBins )
+            {
+            histogramMeasurement[0] = value;
+            if ( m_HistogramTemplate->GetIndex(histogramMeasurement, histogramIndex) )
+              {
+              bin = m_HistogramTemplate->GetInstanceIdentifier(histogramIndex);
+              }
+            }
+          if ( bin < numberOfBins )
+            {
+            labelStats->m_Histogram.IncreaseFrequency(bin, 1);
+            }
+          }
+
+        ++labelIt;
+        ++it;
+        ++index0;
+        }
+      while ( !it.IsAtEndOfLine() && labelIt.Get() == label );
 
-      // update the values for this label and this thread
-      if ( value < labelStats.m_Minimum )
+      // bounding box is min,max pairs
+      if ( labelStats->m_BoundingBox[0] > runStart )
         {
-        labelStats.m_Minimum = value;
+        labelStats->m_BoundingBox[0] = runStart;
         }
-      if ( value > labelStats.m_Maximum )
+      if ( labelStats->m_BoundingBox[1] < index0 - 1 )
         {
-        labelStats.m_Maximum = value;
+        labelStats->m_BoundingBox[1] = index0 - 1;
         }
-
-      // bounding box is min,max pairs
-      for ( unsigned int i = 0; i < ( 2 * TInputImage::ImageDimension ); i += 2 )
+      for ( unsigned int i = 2; i < ( 2 * TInputImage::ImageDimension ); i += 2 )
         {
-        const IndexType & index = it.GetIndex();
-        if ( labelStats.m_BoundingBox[i] > index[i / 2] )
+        if ( labelStats->m_BoundingBox[i] > lineIndex[i / 2] )
           {
-          labelStats.m_BoundingBox[i] = index[i / 2];
+          labelStats->m_BoundingBox[i] = lineIndex[i / 2];
           }
-        if ( labelStats.m_BoundingBox[i + 1] < index[i / 2] )
+        if ( labelStats->m_BoundingBox[i + 1] < lineIndex[i / 2] )
           {
-          labelStats.m_BoundingBox[i + 1] = index[i / 2];
+          labelStats->m_BoundingBox[i + 1] = lineIndex[i / 2];
           }
         }
-
-      labelStats.m_Sum += value;
-      labelStats.m_SumOfSquares += ( value * value );
-      labelStats.m_Count++;
-
-      // if enabled, update the histogram for this label
-      if ( m_UseHistograms )
-        {
-        histogramMeasurement[0] = value;
-        labelStats.m_Histogram->GetIndex(histogramMeasurement, histogramIndex);
-        labelStats.m_Histogram->IncreaseFrequencyOfIndex(histogramIndex, 1);
-        }
-
-
-      ++labelIt;
-      ++it;
       }
     labelIt.NextLine();
     it.NextLine();
@@ -0,0 +1,239 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkLabelStatisticsImageFilter.h"
+#include "itkTestingMacros.h"
+
+// Compare the statistics computed with several numbers of threads with
+// statistics computed pixel by pixel, for compact label ranges (stored
+// in arrays by the threads), for scattered labels (stored in maps), and
+// for a mix of both.
+namespace
+{
+
+typedef itk::Image< short, 3 > ImageType;
+
+template< typename TLabelImage >
+struct ReferenceStatistics
+{
+  ReferenceStatistics() :
+    m_Count( 0 ),
+    m_Minimum( itk::NumericTraits< double >::max() ),
+    m_Maximum( itk::NumericTraits< double >::NonpositiveMin() ),
+    m_Sum( 0.0 ),
+    m_SumOfSquares( 0.0 )
+  {
+    for ( unsigned int i = 0; i < TLabelImage::ImageDimension; ++i )
+      {
+      m_BoundingBox.push_back( itk::NumericTraits< itk::IndexValueType >::max() );
+      m_BoundingBox.push_back( itk::NumericTraits< itk::IndexValueType >::NonpositiveMin() );
+      }
+  }
+
+  itk::SizeValueType                 m_Count;
+  double                             m_Minimum;
+  double                             m_Maximum;
+  double                             m_Sum;
+  double                             m_SumOfSquares;
+  std::vector< itk::IndexValueType > m_BoundingBox;
+  std::vector< itk::SizeValueType >  m_Histogram;
+};
+
+template< typename TLabelImage >
+bool
+TestLabelStatistics(const ImageType * image, const TLabelImage * labels, const char * name)
+{
+  typedef itk::LabelStatisticsImageFilter< ImageType, TLabelImage > FilterType;
+  typedef typename TLabelImage::PixelType                           LabelType;
+  typedef ReferenceStatistics< TLabelImage >                        ReferenceType;
+  typedef std::map< LabelType, ReferenceType >                      ReferenceMapType;
+
+  const int    numberOfBins = 17;
+  const double lowerBound = -150.0;
+  const double upperBound = 900.0;
+
+  // the bins of the filter
+  typename FilterType::HistogramType::Pointer histogram = FilterType::HistogramType::New();
+  typename FilterType::HistogramType::SizeType histogramSize(1);
+  typename FilterType::HistogramType::MeasurementVectorType lower(1);
+  typename FilterType::HistogramType::MeasurementVectorType upper(1);
+  histogramSize[0] = numberOfBins;
+  lower[0] = lowerBound;
+  upper[0] = upperBound;
+  histogram->SetMeasurementVectorSize(1);
+  histogram->Initialize( histogramSize, lower, upper );
+
+  ReferenceMapType reference;
+  itk::ImageRegionConstIteratorWithIndex< TLabelImage > lit( labels, labels->GetLargestPossibleRegion() );
+  for ( lit.GoToBegin(); !lit.IsAtEnd(); ++lit )
+    {
+    ReferenceType & stats = reference[lit.Get()];
+    const double    value = image->GetPixel( lit.GetIndex() );
+    ++stats.m_Count;
+    stats.m_Minimum = std::min( stats.m_Minimum, value );
+    stats.m_Maximum = std::max( stats.m_Maximum, value );
+    stats.m_Sum += value;
+    stats.m_SumOfSquares += value * value;
+    for ( unsigned int i = 0; i < TLabelImage::ImageDimension; ++i )
+      {
+      stats.m_BoundingBox[2 * i] = std::min( stats.m_BoundingBox[2 * i], lit.GetIndex()[i] );
+      stats.m_BoundingBox[2 * i + 1] = std::max( stats.m_BoundingBox[2 * i + 1], lit.GetIndex()[i] );
+      }
+    stats.m_Histogram.resize( numberOfBins, 0 );
+    typename FilterType::HistogramType::MeasurementVectorType measurement(1);
+    typename FilterType::HistogramType::IndexType             index(1);
+    measurement[0] = value;
+    if ( histogram->GetIndex( measurement, index ) )
+      {
+      ++stats.m_Histogram[index[0]];
+      }
+    }
+
+  const unsigned int numberOfThreads[] = { 1, 2, 3, 7 };
+  bool               success = true;
+  for ( unsigned int t = 0; t < 4; ++t )
+    {
+    typename FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( image );
+    filter->SetLabelInput( labels );
+    filter->SetHistogramParameters( numberOfBins, lowerBound, upperBound );
+    filter->SetNumberOfThreads( numberOfThreads[t] );
+    filter->Update();
+
+    std::cout << name << ", " << numberOfThreads[t] << " thread(s): "
+              << filter->GetNumberOfLabels() << " labels" << std::endl;
+    if ( filter->GetNumberOfLabels() != reference.size()
+         || filter->GetValidLabelValues().size() != reference.size() )
+      {
+      std::cerr << "Expected " << reference.size() << " labels" << std::endl;
+      success = false;
+      continue;
+      }
+
+    for ( typename ReferenceMapType::const_iterator it = reference.begin(); it != reference.end(); ++it )
+      {
+      const LabelType       label = it->first;
+      const ReferenceType & stats = it->second;
+      const double          count = static_cast< double >( stats.m_Count );
+      const double          mean = stats.m_Sum / count;
+      const double          variance = stats.m_Count > 1 ?
+        ( stats.m_SumOfSquares - stats.m_Sum * stats.m_Sum / count ) / ( count - 1.0 ) : 0.0;
+
+      // the median is the center of the bin where the cumulated
+      // frequency gets over half the count
+      double       total = 0.0;
+      unsigned int bin = 0;
+      while ( total <= stats.m_Count / 2 && bin < static_cast< unsigned int >( numberOfBins ) )
+        {
+        total += stats.m_Histogram[bin++];
+        }
+      --bin;
+      const double median = ( histogram->GetBinMin(0, bin) + histogram->GetBinMax(0, bin) ) / 2;
+
+      bool sameHistogram = true;
+      for ( unsigned int b = 0; b < static_cast< unsigned int >( numberOfBins ); ++b )
+        {
+        sameHistogram &= ( filter->GetHistogram(label)->GetFrequency(b) == stats.m_Histogram[b] );
+        }
+
+      const double tolerance = 1e-9 * ( 1.0 + std::abs( stats.m_SumOfSquares ) );
+      if ( !filter->HasLabel(label)
+           || filter->GetCount(label) != stats.m_Count
+           || filter->GetMinimum(label) != stats.m_Minimum
+           || filter->GetMaximum(label) != stats.m_Maximum
+           || filter->GetBoundingBox(label) != stats.m_BoundingBox
+           || std::abs( filter->GetSum(label) - stats.m_Sum ) > tolerance
+           || std::abs( filter->GetMean(label) - mean ) > 1e-9 * ( 1.0 + std::abs( mean ) )
+           || std::abs( filter->GetVariance(label) - variance ) > 1e-6 * ( 1.0 + variance )
+           || filter->GetMedian(label) != median
+           || !sameHistogram )
+        {
+        std::cerr << "Wrong statistics for label " << static_cast< double >( label )
+                  << ": count " << filter->GetCount(label) << " (" << stats.m_Count << ")"
+                  << ", minimum " << filter->GetMinimum(label) << " (" << stats.m_Minimum << ")"
+                  << ", maximum " << filter->GetMaximum(label) << " (" << stats.m_Maximum << ")"
+                  << ", sum " << filter->GetSum(label) << " (" << stats.m_Sum << ")"
+                  << ", variance " << filter->GetVariance(label) << " (" << variance << ")"
+                  << ", median " << filter->GetMedian(label) << " (" << median << ")" << std::endl;
+        success = false;
+        break;
+        }
+      }
+    }
+  return success;
+}
+
+}
+
+int itkLabelStatisticsImageFilterThreadsTest(int, char* [])
+{
+  typedef itk::Image< unsigned short, 3 > CompactLabelImageType;
+  typedef itk::Image< unsigned int, 3 >   ScatteredLabelImageType;
+
+  ImageType::SizeType size;
+  size[0] = 23;
+  size[1] = 19;
+  size[2] = 17;
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  CompactLabelImageType::Pointer compactLabels = CompactLabelImageType::New();
+  compactLabels->SetRegions( size );
+  compactLabels->Allocate();
+
+  ScatteredLabelImageType::Pointer scatteredLabels = ScatteredLabelImageType::New();
+  scatteredLabels->SetRegions( size );
+  scatteredLabels->Allocate();
+
+  ScatteredLabelImageType::Pointer mixedLabels = ScatteredLabelImageType::New();
+  mixedLabels->SetRegions( size );
+  mixedLabels->Allocate();
+
+  unsigned int value = 3;
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    value = value * 1664525u + 1013904223u;
+    // some values are out of the histogram range
+    it.Set( static_cast< short >( ( value >> 8 ) % 1200 ) - 200 );
+
+    // labels made of short runs along the lines
+    const unsigned int compact = 1000 + ( index[0] / 3 + 2 * index[1] + 5 * index[2] ) % 97;
+    compactLabels->SetPixel( index, static_cast< unsigned short >( compact ) );
+    scatteredLabels->SetPixel( index, compact * 40000000u % 4000000007u );
+    // the last slices have scattered labels
+    mixedLabels->SetPixel( index, index[2] < 12 ? compact : compact * 40000000u );
+    }
+
+  bool success = true;
+  success &= TestLabelStatistics< CompactLabelImageType >( image, compactLabels, "compact labels" );
+  success &= TestLabelStatistics< ScatteredLabelImageType >( image, scatteredLabels, "scattered labels" );
+  success &= TestLabelStatistics< ScatteredLabelImageType >( image, mixedLabels, "mixed labels" );
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -23,10 +23,10 @@
 #include <map>
 #include <vector>
 #include "itkProgressReporter.h"
-#include "itkBarrier.h"
 #include "itkLabelMap.h"
 #include "itkLabelObject.h"
 #include "itkImageRegionSplitterDirection.h"
+#include "itkScanlineConnectedComponents.h"
 
 namespace itk
 {
@@ -43,6 +43,9 @@ namespace itk
  *
  * The GetOutput() function of this class returns an itk::LabelMap.
  *
+ * The runs of pixels are labeled by all the threads, see
+ * ScanlineConnectedComponents.
+ *
  * This implementation was taken from the Insight Journal paper:
  * https://hdl.handle.net/1926/584  or
  * http://www.insight-journal.org/browse/publication/176
@@ -185,56 +188,8 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(BinaryImageToLabelMapFilter);
 
-  // some additional types
-  typedef typename TOutputImage::RegionType::SizeType OutSizeType;
-
-  // types to support the run length encoding of lines
-  class runLength
-  {
-  public:
-    // run length information - may be a more type safe way of doing this
-    SizeValueType length;
-    typename InputImageType::IndexType where; // Index of the start of the run
-    InternalLabelType label;                  // the initial label of the run
-  };
-
-  typedef std::vector< runLength > lineEncoding;
-
-  // the map storing lines
-  typedef std::vector< lineEncoding > LineMapType;
-
-  typedef std::vector< OffsetValueType > OffsetVectorType;
-
-  // the types to support union-find operations
-  typedef std::vector< InternalLabelType > UnionFindType;
-  UnionFindType m_UnionFind;
-
-  typedef std::vector< OutputPixelType > ConsecutiveVectorType;
-  ConsecutiveVectorType m_Consecutive;
-
-  // functions to support union-find operations
-  void InitUnion(const InternalLabelType size);
-
-  void InsertSet(const InternalLabelType label);
-
-  InternalLabelType LookupSet(const InternalLabelType label);
-
-  void LinkLabels(const InternalLabelType lab1, const InternalLabelType lab2);
-
-  SizeValueType CreateConsecutive();
-
-  //////////////////
-  bool CheckNeighbors(const OutputIndexType & A,
-                      const OutputIndexType & B);
-
-  void CompareLines(lineEncoding & current, const lineEncoding & Neighbour);
-
-  void FillOutput(const LineMapType & LineMap,
-                  ProgressReporter & progress);
-
-  void SetupLineOffsets(OffsetVectorType & LineOffsets);
-
-  void Wait();
+  typedef ScanlineConnectedComponents< ImageDimension > ScanlineConnectedComponentsType;
+  typedef typename ScanlineConnectedComponentsType::LineEncodingType LineEncodingType;
 
   OutputPixelType m_OutputBackgroundValue;
   InputPixelType  m_InputForegroundValue;
@@ -243,15 +198,10 @@ private:
 
   bool m_FullyConnected;
 
-  std::vector< SizeValueType >   m_NumberOfLabels;
-  std::vector< SizeValueType >   m_FirstLineIdToJoin;
-
-  typename Barrier::Pointer m_Barrier;
-
   ImageRegionSplitterDirection::Pointer m_ImageRegionSplitter;
 
 #if !defined( ITK_WRAPPING_PARSER )
-  LineMapType m_LineMap;
+  ScanlineConnectedComponentsType m_ScanlineConnectedComponents;
 #endif
 };
 } // end namespace itk
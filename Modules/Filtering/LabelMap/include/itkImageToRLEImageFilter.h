@@ -0,0 +1,127 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageToRLEImageFilter_h
+#define itkImageToRLEImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkImageRegionSplitterSlowDimension.h"
+#include "itkRLEImage.h"
+
+namespace itk
+{
+/** \class ImageToRLEImageFilter
+ * \brief Encode an image as an RLEImage, piece by piece.
+ *
+ * ImageToRLEImageFilter encodes the runs of equal pixels of the lines
+ * of the input image.  Like StreamingImageFilter, it divides its output
+ * in SetNumberOfStreamDivisions() pieces along the slowest dimension,
+ * and updates the upstream pipeline for each piece.  When the input is
+ * read by an ImageFileReader with an ImageIO which supports streaming,
+ * only one piece of the image is stored densely in memory at a time:
+ *
+ * \code
+ * reader->SetFileName( fileName );
+ * encoder->SetInput( reader->GetOutput() );
+ * encoder->SetNumberOfStreamDivisions( 20 );
+ * encoder->Update();
+ * \endcode
+ *
+ * \sa RLEImage, RLEImageToImageFilter, StreamingImageFilter
+ * \ingroup ITKLabelMap
+ */
+template< typename TInputImage, typename TOutputImage =
+            RLEImage< typename TInputImage::PixelType, TInputImage::ImageDimension > >
+class ITK_TEMPLATE_EXPORT ImageToRLEImageFilter:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageToRLEImageFilter                           Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageToRLEImageFilter, ImageToImageFilter);
+
+  /** Some typedefs for the input and output. */
+  typedef TInputImage                         InputImageType;
+  typedef typename InputImageType::RegionType InputImageRegionType;
+  typedef typename InputImageType::PixelType  InputImagePixelType;
+
+  typedef TOutputImage                          OutputImageType;
+  typedef typename OutputImageType::RegionType  OutputImageRegionType;
+  typedef typename OutputImageType::PixelType   OutputImagePixelType;
+  typedef typename OutputImageType::CounterType CounterType;
+  typedef typename OutputImageType::RLSegment   RLSegment;
+  typedef typename OutputImageType::RLLine      RLLine;
+
+  /** Dimension of input image. */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      InputImageType::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      OutputImageType::ImageDimension);
+
+  /** Set/Get the number of pieces to divide the input.  The upstream
+   * pipeline will be executed this many times. */
+  itkSetMacro(NumberOfStreamDivisions, unsigned int);
+  itkGetConstReferenceMacro(NumberOfStreamDivisions, unsigned int);
+
+  /** Encode the pieces one after the other, updating the upstream
+   * pipeline for each piece.  The work is done in UpdateOutputData(),
+   * as in StreamingImageFilter. */
+  virtual void UpdateOutputData(DataObject *output) ITK_OVERRIDE;
+
+  /** The requested regions of the input are managed in
+   * UpdateOutputData(), so they are not propagated upstream here. */
+  virtual void PropagateRequestedRegion(DataObject *output) ITK_OVERRIDE;
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  // Begin concept checking
+  itkConceptMacro( SameDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, OutputImageDimension > ) );
+  itkConceptMacro( InputConvertibleToOutputCheck,
+                   ( Concept::Convertible< InputImagePixelType, OutputImagePixelType > ) );
+  // End concept checking
+#endif
+
+protected:
+  ImageToRLEImageFilter();
+  ~ImageToRLEImageFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  /** Append the runs of a piece of the input to the lines of the
+   * output. */
+  void EncodeRegion(const InputImageType *input, const InputImageRegionType & region);
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ImageToRLEImageFilter);
+
+  unsigned int                              m_NumberOfStreamDivisions;
+  ImageRegionSplitterSlowDimension::Pointer m_RegionSplitter;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageToRLEImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,178 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageToRLEImageFilter_hxx
+#define itkImageToRLEImageFilter_hxx
+
+#include "itkImageToRLEImageFilter.h"
+#include "itkImageScanlineConstIterator.h"
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+ImageToRLEImageFilter< TInputImage, TOutputImage >
+::ImageToRLEImageFilter()
+{
+  // the whole image at once by default
+  m_NumberOfStreamDivisions = 1;
+
+  m_RegionSplitter = ImageRegionSplitterSlowDimension::New();
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+ImageToRLEImageFilter< TInputImage, TOutputImage >
+::PropagateRequestedRegion(DataObject *output)
+{
+  // check flag to avoid executing forever if there is a loop
+  if ( this->m_Updating )
+    {
+    return;
+    }
+
+  this->EnlargeOutputRequestedRegion(output);
+  this->GenerateOutputRequestedRegion(output);
+
+  // the input requested regions are set for each piece in
+  // UpdateOutputData()
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+ImageToRLEImageFilter< TInputImage, TOutputImage >
+::UpdateOutputData( DataObject *itkNotUsed(output) )
+{
+  // prevent chasing our tail
+  if ( this->m_Updating )
+    {
+    return;
+    }
+
+  // Prepare all the outputs. This may deallocate previous bulk data.
+  this->PrepareOutputs();
+
+  // Make sure we have the necessary inputs
+  const ProcessObject::DataObjectPointerArraySizeType & ninputs = this->GetNumberOfValidRequiredInputs();
+  if ( ninputs < this->GetNumberOfRequiredInputs() )
+    {
+    itkExceptionMacro(
+      << "At least " << static_cast< unsigned int >( this->GetNumberOfRequiredInputs() )
+      << " inputs are required but only " << ninputs << " are specified.");
+    }
+
+  this->InvokeEvent( StartEvent() );
+  this->SetAbortGenerateData(0);
+  this->UpdateProgress(0.0);
+  this->m_Updating = true;
+
+  // Allocate the output, with empty lines which are filled piece by piece
+  OutputImageType *           outputPtr = this->GetOutput();
+  const OutputImageRegionType outputRegion = outputPtr->GetRequestedRegion();
+  outputPtr->SetBufferedRegion(outputRegion);
+  outputPtr->Allocate();
+  for ( SizeValueType lineId = 0; lineId < outputPtr->GetNumberOfLines(); ++lineId )
+    {
+    outputPtr->GetLine(lineId).clear();
+    }
+
+  InputImageType *inputPtr = const_cast< InputImageType * >( this->GetInput() );
+
+  // The pieces are split along the slowest dimension, so they are
+  // encoded in the order of the lines, and along the lines in one
+  // dimension.
+  const unsigned int numDivisions =
+    m_RegionSplitter->GetNumberOfSplits(outputRegion, m_NumberOfStreamDivisions);
+  for ( unsigned int piece = 0; piece < numDivisions && !this->GetAbortGenerateData(); piece++ )
+    {
+    InputImageRegionType streamRegion = outputRegion;
+    m_RegionSplitter->GetSplit(piece, numDivisions, streamRegion);
+
+    inputPtr->SetRequestedRegion(streamRegion);
+    inputPtr->PropagateRequestedRegion();
+    inputPtr->UpdateOutputData();
+
+    this->EncodeRegion(inputPtr, streamRegion);
+
+    this->UpdateProgress( static_cast< float >( piece + 1 ) / static_cast< float >( numDivisions ) );
+    }
+
+  this->InvokeEvent( EndEvent() );
+
+  // Now we have to mark the data as up to data.
+  for ( unsigned int idx = 0; idx < this->GetNumberOfOutputs(); ++idx )
+    {
+    if ( this->GetOutput(idx) )
+      {
+      this->GetOutput(idx)->DataHasBeenGenerated();
+      }
+    }
+
+  // Release any inputs if marked for release
+  this->ReleaseInputs();
+
+  // Mark that we are no longer updating the data in this filter
+  this->m_Updating = false;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+ImageToRLEImageFilter< TInputImage, TOutputImage >
+::EncodeRegion(const InputImageType *input, const InputImageRegionType & region)
+{
+  OutputImageType *output = this->GetOutput();
+
+  ImageScanlineConstIterator< InputImageType > it(input, region);
+  while ( !it.IsAtEnd() )
+    {
+    RLLine & line = output->GetLine( output->ComputeLineId( it.GetIndex() ) );
+    while ( !it.IsAtEndOfLine() )
+      {
+      const OutputImagePixelType value = static_cast< OutputImagePixelType >( it.Get() );
+      CounterType                length = 0;
+      do
+        {
+        ++length;
+        ++it;
+        }
+      while ( !it.IsAtEndOfLine() && static_cast< OutputImagePixelType >( it.Get() ) == value );
+
+      // a line of a one dimensional image may be split between two pieces
+      if ( !line.empty() && line.back().second == value )
+        {
+        line.back().first += length;
+        }
+      else
+        {
+        line.push_back( RLSegment(length, value) );
+        }
+      }
+    it.NextLine();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+ImageToRLEImageFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfStreamDivisions: " << m_NumberOfStreamDivisions << std::endl;
+}
+} // end namespace itk
+
+#endif
@@ -29,7 +29,9 @@
 #define itkLabelMapFilter_h
 
 #include "itkImageToImageFilter.h"
+#include "itkAtomicInt.h"
 #include "itkFastMutexLock.h"
+#include <vector>
 
 namespace itk
 {
@@ -42,6 +44,11 @@ namespace itk
  * With that class, the developer doesn't need to take care of iterating over all the objects in
  * the image, or to manage by hand the threads.
  *
+ * The threads take the objects by batches, so that many small objects
+ * can be processed without contention between the threads.  The object
+ * being processed may be removed from the label map, but no other
+ * object may be added or removed.
+ *
  * \author Gaetan Lehmann. Biologie du Developpement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
  * This implementation was taken from the Insight Journal paper:
@@ -123,9 +130,11 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(LabelMapFilter);
 
-  typename InputImageType::Iterator m_LabelObjectIterator;
-  float                             m_InverseNumberOfLabelObjects;
-  SizeValueType                     m_NumberOfLabelObjectsProcessed;
+  std::vector< LabelObjectType * > m_LabelObjects;
+  SizeValueType                    m_LabelObjectBatchSize;
+  AtomicInt< SizeValueType >       m_NumberOfLabelObjectsTaken;
+  float                            m_InverseNumberOfLabelObjects;
+  AtomicInt< SizeValueType >       m_NumberOfLabelObjectsProcessed;
 };
 } // end namespace itk
 
@@ -28,13 +28,15 @@
 #ifndef itkLabelMapFilter_hxx
 #define itkLabelMapFilter_hxx
 #include "itkLabelMapFilter.h"
-#include "itkMutexLockHolder.h"
+#include <algorithm>
 
 namespace itk
 {
 template< typename TInputImage, typename TOutputImage >
 LabelMapFilter< TInputImage, TOutputImage >
 ::LabelMapFilter():
+  m_LabelObjectBatchSize( 1 ),
+  m_NumberOfLabelObjectsTaken( 0 ),
   m_InverseNumberOfLabelObjects( 1.0f ),
   m_NumberOfLabelObjectsProcessed( 1 )
 {
@@ -76,20 +78,32 @@ void
 LabelMapFilter< TInputImage, TOutputImage >
 ::BeforeThreadedGenerateData()
 {
-  // initialize the iterator
-  m_LabelObjectIterator =  typename InputImageType::Iterator(this->GetLabelMap());
-//  m_LabelObjectIterator = typename InputImageType::Iterator(this->GetLabelMap());
+  // list the objects, the threads take them by batches
+  InputImageType * labelMap = this->GetLabelMap();
+  m_LabelObjects.clear();
+  m_LabelObjects.reserve( labelMap->GetNumberOfLabelObjects() );
+  for ( typename InputImageType::Iterator it( labelMap ); !it.IsAtEnd(); ++it )
+    {
+    m_LabelObjects.push_back( it.GetLabelObject() );
+    }
+
+  // about 16 batches per thread, to balance the load when the objects
+  // have very different sizes
+  const SizeValueType numberOfBatches = 16 * static_cast< SizeValueType >( this->GetNumberOfThreads() );
+  m_LabelObjectBatchSize = std::max( static_cast< SizeValueType >( m_LabelObjects.size() ) / numberOfBatches,
+                                     static_cast< SizeValueType >( 1 ) );
+  m_NumberOfLabelObjectsTaken = 0;
 
-  // and the mutex
+  // and the mutex, used by the subclasses which remove objects
   m_LabelObjectContainerLock = FastMutexLock::New();
 
-  if(Math::ExactlyEquals(this->GetLabelMap()->GetNumberOfLabelObjects(), 0.0))
+  if( m_LabelObjects.empty() )
     {
     m_InverseNumberOfLabelObjects = NumericTraits<float>::max();
     }
   else
     {
-    m_InverseNumberOfLabelObjects = 1.0f/this->GetLabelMap()->GetNumberOfLabelObjects();
+    m_InverseNumberOfLabelObjects = 1.0f / m_LabelObjects.size();
     }
 
   m_NumberOfLabelObjectsProcessed = 0;
@@ -100,6 +114,7 @@ void
 LabelMapFilter< TInputImage, TOutputImage >
 ::AfterThreadedGenerateData()
 {
+  m_LabelObjects.clear();
   this->UpdateProgress(1.0);
 }
 
@@ -108,38 +123,28 @@ void
 LabelMapFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData( const OutputImageRegionType &, ThreadIdType threadId )
 {
+  const SizeValueType numberOfLabelObjects = static_cast< SizeValueType >( m_LabelObjects.size() );
   while ( true )
     {
-    LabelObjectType *labelObject;
-    // begin mutex lock
-    {
-    MutexLockHolder< FastMutexLock > lock(*m_LabelObjectContainerLock );
-
-    if ( m_LabelObjectIterator.IsAtEnd() )
+    // take the next batch of objects
+    const SizeValueType end = ( m_NumberOfLabelObjectsTaken += m_LabelObjectBatchSize );
+    const SizeValueType begin = end - m_LabelObjectBatchSize;
+    if ( begin >= numberOfLabelObjects )
       {
-      // mutex lock holder deleted
       return;
       }
 
-    // get the label object
-    labelObject = m_LabelObjectIterator.GetLabelObject();
-
-    // increment the iterator now, so it will not be invalidated if the object
-    // is destroyed
-    ++m_LabelObjectIterator;
-    ++m_NumberOfLabelObjectsProcessed;
-
-    // unlock the mutex, so the other threads can get an object
-    }
-    // end mutex lock
-
-
-    // and run the user defined method for that object
-    this->ThreadedProcessLabelObject(labelObject);
+    // and run the user defined method for these objects
+    const SizeValueType batchEnd = std::min( end, numberOfLabelObjects );
+    for ( SizeValueType i = begin; i < batchEnd; ++i )
+      {
+      this->ThreadedProcessLabelObject( m_LabelObjects[i] );
+      }
+    const SizeValueType processed = ( m_NumberOfLabelObjectsProcessed += batchEnd - begin );
 
     if (threadId==0)
       {
-      const float progress = m_InverseNumberOfLabelObjects*m_NumberOfLabelObjectsProcessed;
+      const float progress = m_InverseNumberOfLabelObjects*processed;
       this->UpdateProgress(progress);
       }
 
@@ -0,0 +1,136 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkLabelMapToRLEImageFilter_h
+#define itkLabelMapToRLEImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkImageRegionSplitterDirection.h"
+#include "itkRLEImage.h"
+
+namespace itk
+{
+/** \class LabelMapToRLEImageFilter
+ * \brief Converts a LabelMap to a run length encoded label image.
+ *
+ * The lines of the label objects are copied to the runs of the output
+ * RLEImage, and the gaps between them are filled with the background
+ * value of the LabelMap.  Unlike LabelMapToLabelImageFilter, the image
+ * is never stored densely in memory: the time and the memory are
+ * proportional to the number of lines of the objects.
+ *
+ * \sa RLEImage, RLEImageToLabelMapFilter, LabelMapToLabelImageFilter
+ * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
+ * \ingroup LabeledImageFilters
+ * \ingroup ITKLabelMap
+ */
+template< typename TInputImage, typename TOutputImage =
+            RLEImage< typename TInputImage::LabelType, TInputImage::ImageDimension > >
+class ITK_TEMPLATE_EXPORT LabelMapToRLEImageFilter:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef LabelMapToRLEImageFilter                        Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TInputImage                              InputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::LabelObjectType LabelObjectType;
+  typedef typename LabelObjectType::LabelType      LabelType;
+  typedef typename LabelObjectType::LengthType     LengthType;
+
+  typedef TOutputImage                          OutputImageType;
+  typedef typename OutputImageType::RegionType  OutputImageRegionType;
+  typedef typename OutputImageType::PixelType   OutputImagePixelType;
+  typedef typename OutputImageType::IndexType   IndexType;
+  typedef typename OutputImageType::CounterType CounterType;
+  typedef typename OutputImageType::RLSegment   RLSegment;
+  typedef typename OutputImageType::RLLine      RLLine;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int, TInputImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int, TOutputImage::ImageDimension);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(LabelMapToRLEImageFilter, ImageToImageFilter);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  itkConceptMacro( SameDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, OutputImageDimension > ) );
+#endif
+
+protected:
+  LabelMapToRLEImageFilter();
+  ~LabelMapToRLEImageFilter() ITK_OVERRIDE {}
+
+  /** LabelMapToRLEImageFilter needs the entire input. */
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  /** LabelMapToRLEImageFilter will produce the entire output. */
+  void EnlargeOutputRequestedRegion( DataObject *itkNotUsed(output) ) ITK_OVERRIDE;
+
+  /** Sort the lines of the objects by line of the output. */
+  virtual void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  virtual void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                    ThreadIdType threadId) ITK_OVERRIDE;
+
+  virtual void AfterThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Provide an ImageRegionSplitter that does not split along the first
+   * dimension, so the threads encode complete lines. */
+  virtual const ImageRegionSplitterBase* GetImageRegionSplitter() const ITK_OVERRIDE
+  {
+    return m_ImageRegionSplitter.GetPointer();
+  }
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(LabelMapToRLEImageFilter);
+
+  /** A line of an object, in a line of the output. */
+  struct ObjectRun
+  {
+    IndexValueType start;
+    LengthType     length;
+    LabelType      label;
+
+    bool operator<(const ObjectRun & other) const
+    {
+      return start < other.start;
+    }
+  };
+
+  typedef std::vector< ObjectRun > ObjectRunVectorType;
+
+  std::vector< ObjectRunVectorType >    m_ObjectRuns;
+  ImageRegionSplitterDirection::Pointer m_ImageRegionSplitter;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelMapToRLEImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,152 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkLabelMapToRLEImageFilter_hxx
+#define itkLabelMapToRLEImageFilter_hxx
+
+#include "itkLabelMapToRLEImageFilter.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+LabelMapToRLEImageFilter< TInputImage, TOutputImage >
+::LabelMapToRLEImageFilter()
+{
+  m_ImageRegionSplitter = ImageRegionSplitterDirection::New();
+  m_ImageRegionSplitter->SetDirection(0);
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+LabelMapToRLEImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // We need all the input.
+  InputImagePointer input = const_cast< InputImageType * >( this->GetInput() );
+  if ( !input )
+    {
+    return;
+    }
+  input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+LabelMapToRLEImageFilter< TInputImage, TOutputImage >
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()->SetRequestedRegion( this->GetOutput()->GetLargestPossibleRegion() );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+LabelMapToRLEImageFilter< TInputImage, TOutputImage >
+::BeforeThreadedGenerateData()
+{
+  const InputImageType *input = this->GetInput();
+  OutputImageType *     output = this->GetOutput();
+
+  m_ObjectRuns.clear();
+  m_ObjectRuns.resize( output->GetNumberOfLines() );
+
+  for ( typename InputImageType::ConstIterator it( input ); !it.IsAtEnd(); ++it )
+    {
+    const LabelObjectType *labelObject = it.GetLabelObject();
+    ObjectRun              run;
+    run.label = labelObject->GetLabel();
+    for ( typename LabelObjectType::ConstLineIterator lit( labelObject ); !lit.IsAtEnd(); ++lit )
+      {
+      const IndexType & index = lit.GetLine().GetIndex();
+      run.start = index[0];
+      run.length = lit.GetLine().GetLength();
+      m_ObjectRuns[output->ComputeLineId(index)].push_back(run);
+      }
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+LabelMapToRLEImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId)
+{
+  OutputImageType *          output = this->GetOutput();
+  const OutputImagePixelType background =
+    static_cast< OutputImagePixelType >( this->GetInput()->GetBackgroundValue() );
+
+  const IndexValueType lineStart = outputRegionForThread.GetIndex(0);
+  const IndexValueType lineEnd = lineStart + static_cast< IndexValueType >( outputRegionForThread.GetSize(0) );
+  const SizeValueType  numberOfLines = outputRegionForThread.GetNumberOfPixels() / outputRegionForThread.GetSize(0);
+
+  ProgressReporter progress( this, threadId, numberOfLines );
+
+  IndexType index = outputRegionForThread.GetIndex();
+  for ( SizeValueType l = 0; l < numberOfLines; ++l )
+    {
+    const SizeValueType   lineId = output->ComputeLineId(index);
+    ObjectRunVectorType & runs = m_ObjectRuns[lineId];
+    std::sort( runs.begin(), runs.end() );
+
+    // fill the gaps between the runs of the objects with the background
+    RLLine &       line = output->GetLine(lineId);
+    IndexValueType x = lineStart;
+    line.clear();
+    for ( typename ObjectRunVectorType::const_iterator it = runs.begin(); it != runs.end(); ++it )
+      {
+      if ( it->start > x )
+        {
+        line.push_back( RLSegment( static_cast< CounterType >( it->start - x ), background ) );
+        }
+      line.push_back( RLSegment( static_cast< CounterType >( it->length ),
+                                 static_cast< OutputImagePixelType >( it->label ) ) );
+      x = it->start + static_cast< IndexValueType >( it->length );
+      }
+    if ( x < lineEnd )
+      {
+      line.push_back( RLSegment( static_cast< CounterType >( lineEnd - x ), background ) );
+      }
+    OutputImageType::MergeRuns(line);
+    ObjectRunVectorType().swap(runs);
+
+    // next line
+    for ( unsigned int dim = 1; dim < OutputImageDimension; ++dim )
+      {
+      if ( ++index[dim] < outputRegionForThread.GetIndex(dim)
+           + static_cast< IndexValueType >( outputRegionForThread.GetSize(dim) ) )
+        {
+        break;
+        }
+      index[dim] = outputRegionForThread.GetIndex(dim);
+      }
+    progress.CompletedPixel();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+LabelMapToRLEImageFilter< TInputImage, TOutputImage >
+::AfterThreadedGenerateData()
+{
+  m_ObjectRuns.clear();
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,186 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImage_h
+#define itkRLEImage_h
+
+#include "itkImageBase.h"
+#include "itkVectorContainer.h"
+#include <utility>
+#include <vector>
+
+namespace itk
+{
+/** \class RLEImage
+ *  \brief Templated n-dimensional image stored as runs of equal pixels.
+ *
+ * RLEImage stores each line of the buffered region along the first
+ * dimension as a list of runs, where a run is a pair made of a number
+ * of pixels and of their value.  Label images are made of large regions
+ * of constant value, so they usually take 20 to 100 times less memory
+ * in this form than in an itk::Image.
+ *
+ * Like LabelMap, RLEImage derives from ImageBase, so it can be the input
+ * or the output of the pipeline filters.  It is produced from an image
+ * by ImageToRLEImageFilter, which can stream the reading of a file,
+ * decoded by RLEImageToImageFilter, which can stream the writing of a
+ * file, and converted directly from and to a LabelMap by
+ * LabelMapToRLEImageFilter and RLEImageToLabelMapFilter.
+ *
+ * GetPixel() and SetPixel() are linear in the number of runs of the
+ * line of the pixel.  To visit the pixels of a region, use
+ * RLEImageRegionConstIterator, which moves from a run to the next.
+ *
+ * The number of pixels of a run is stored with the CounterType, so the
+ * lines cannot be longer than the largest value of CounterType.
+ *
+ * \sa RLEImageRegionConstIterator, LabelMap
+ * \ingroup ImageObjects
+ * \ingroup ITKLabelMap
+ */
+template< typename TPixel, unsigned int VImageDimension = 3, typename TCounter = unsigned short >
+class ITK_TEMPLATE_EXPORT RLEImage:public ImageBase< VImageDimension >
+{
+public:
+  /** Standard class typedefs */
+  typedef RLEImage                      Self;
+  typedef ImageBase< VImageDimension >  Superclass;
+  typedef SmartPointer< Self >          Pointer;
+  typedef SmartPointer< const Self >    ConstPointer;
+  typedef WeakPointer< const Self >     ConstWeakPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(RLEImage, ImageBase);
+
+  /** Dimension of the image. */
+  itkStaticConstMacro(ImageDimension, unsigned int, VImageDimension);
+
+  /** Pixel typedef support. */
+  typedef TPixel PixelType;
+  typedef TPixel ValueType;
+
+  typedef typename Superclass::SizeValueType   SizeValueType;
+  typedef typename Superclass::IndexType       IndexType;
+  typedef typename Superclass::IndexValueType  IndexValueType;
+  typedef typename Superclass::OffsetType      OffsetType;
+  typedef typename Superclass::OffsetValueType OffsetValueType;
+  typedef typename Superclass::SizeType        SizeType;
+  typedef typename Superclass::DirectionType   DirectionType;
+  typedef typename Superclass::RegionType      RegionType;
+  typedef typename Superclass::SpacingType     SpacingType;
+  typedef typename Superclass::PointType       PointType;
+
+  /** Type used to store the number of pixels of a run. */
+  typedef TCounter CounterType;
+
+  /** A run: the number of pixels and their value. */
+  typedef std::pair< CounterType, PixelType > RLSegment;
+
+  /** The runs of a line, in the order of the first dimension. */
+  typedef std::vector< RLSegment > RLLine;
+
+  /** The container of the lines, in the order of the buffered region. */
+  typedef VectorContainer< SizeValueType, RLLine > BufferType;
+  typedef typename BufferType::Pointer             BufferPointer;
+
+  /** Restore the data object to its initial state. This means releasing
+   * memory. */
+  virtual void Initialize() ITK_OVERRIDE;
+
+  /** Allocate the lines of the buffered region.  Each line is made of a
+   * single run of the default pixel value. */
+  virtual void Allocate(bool initialize = false) ITK_OVERRIDE;
+
+  /** Fill the buffered region with a value. */
+  void FillBuffer(const PixelType & value);
+
+  /** Get a pixel.  The index must be in the buffered region. */
+  PixelType GetPixel(const IndexType & index) const;
+
+  /** Set a pixel.  The runs of the line are split or merged as needed.
+   * The index must be in the buffered region. */
+  void SetPixel(const IndexType & index, const PixelType & value);
+
+  /** Number of lines in the buffered region. */
+  SizeValueType GetNumberOfLines() const
+  {
+    return m_Buffer->Size();
+  }
+
+  /** Position of the line of an index in the buffered region. */
+  SizeValueType ComputeLineId(const IndexType & index) const
+  {
+    return static_cast< SizeValueType >( this->ComputeOffset(index) )
+           / this->GetBufferedRegion().GetSize(0);
+  }
+
+  /** Access to the runs of a line. */
+  RLLine & GetLine(SizeValueType lineId)
+  {
+    return m_Buffer->ElementAt(lineId);
+  }
+  const RLLine & GetLine(SizeValueType lineId) const
+  {
+    return m_Buffer->ElementAt(lineId);
+  }
+
+  /** Total number of runs, a measure of the memory used by the image. */
+  SizeValueType GetNumberOfRuns() const;
+
+  /** Merge the consecutive runs of a line which have the same value. */
+  static void MergeRuns(RLLine & line);
+
+  /** Merge the consecutive runs with the same value in all the lines. */
+  void CleanUp();
+
+  /** Return a pointer to the container of the lines. */
+  BufferType * GetBuffer()
+  {
+    return m_Buffer.GetPointer();
+  }
+  const BufferType * GetBuffer() const
+  {
+    return m_Buffer.GetPointer();
+  }
+
+  /** Graft the data and information from one image to another.  The
+   * lines are shared by both images. */
+  virtual void Graft(const Self *data);
+
+protected:
+  RLEImage();
+  ~RLEImage() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  virtual void Graft(const DataObject *data) ITK_OVERRIDE;
+  using Superclass::Graft;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(RLEImage);
+
+  BufferPointer m_Buffer;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRLEImage.hxx"
+#endif
+
+#endif
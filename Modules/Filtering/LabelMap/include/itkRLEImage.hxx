@@ -0,0 +1,278 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImage_hxx
+#define itkRLEImage_hxx
+
+#include "itkRLEImage.h"
+#include "itkNumericTraits.h"
+
+namespace itk
+{
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+RLEImage< TPixel, VImageDimension, TCounter >
+::RLEImage()
+{
+  m_Buffer = BufferType::New();
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+void
+RLEImage< TPixel, VImageDimension, TCounter >
+::Initialize()
+{
+  // Call the superclass which should initialize the BufferedRegion ivar.
+  Superclass::Initialize();
+
+  // Replace the lines by a new container, the old one may be shared by
+  // a grafted image.
+  m_Buffer = BufferType::New();
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+void
+RLEImage< TPixel, VImageDimension, TCounter >
+::Allocate(bool)
+{
+  const RegionType & region = this->GetBufferedRegion();
+  if ( region.GetSize(0) > static_cast< SizeValueType >( NumericTraits< CounterType >::max() ) )
+    {
+    itkExceptionMacro(<< "The lines of " << region.GetSize(0)
+                      << " pixels are too long for the counter type of the runs.");
+    }
+  this->ComputeOffsetTable();
+
+  const SizeValueType numberOfLines =
+    region.GetSize(0) > 0 ? region.GetNumberOfPixels() / region.GetSize(0) : 0;
+  m_Buffer = BufferType::New();
+  m_Buffer->CastToSTLContainer().resize(numberOfLines);
+  this->FillBuffer( NumericTraits< PixelType >::ZeroValue() );
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+void
+RLEImage< TPixel, VImageDimension, TCounter >
+::FillBuffer(const PixelType & value)
+{
+  const CounterType lineLength = static_cast< CounterType >( this->GetBufferedRegion().GetSize(0) );
+  typename BufferType::STLContainerType & lines = m_Buffer->CastToSTLContainer();
+  for ( typename BufferType::STLContainerType::iterator it = lines.begin(); it != lines.end(); ++it )
+    {
+    it->assign( 1, RLSegment(lineLength, value) );
+    }
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+typename RLEImage< TPixel, VImageDimension, TCounter >::PixelType
+RLEImage< TPixel, VImageDimension, TCounter >
+::GetPixel(const IndexType & index) const
+{
+  const RLLine & line = this->GetLine( this->ComputeLineId(index) );
+  IndexValueType x = index[0] - this->GetBufferedRegion().GetIndex(0);
+  typename RLLine::const_iterator segment = line.begin();
+  while ( x >= static_cast< IndexValueType >( segment->first ) )
+    {
+    x -= segment->first;
+    ++segment;
+    }
+  return segment->second;
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+void
+RLEImage< TPixel, VImageDimension, TCounter >
+::SetPixel(const IndexType & index, const PixelType & value)
+{
+  RLLine &       line = this->GetLine( this->ComputeLineId(index) );
+  IndexValueType x = index[0] - this->GetBufferedRegion().GetIndex(0);
+
+  // find the run of the pixel, and the position of the pixel in the run
+  SizeValueType s = 0;
+  while ( x >= static_cast< IndexValueType >( line[s].first ) )
+    {
+    x -= line[s].first;
+    ++s;
+    }
+  if ( line[s].second == value )
+    {
+    return;
+    }
+
+  const bool sameAsPrevious = ( s > 0 && line[s - 1].second == value );
+  const bool sameAsNext = ( s + 1 < line.size() && line[s + 1].second == value );
+  const CounterType length = line[s].first;
+  if ( length == 1 )
+    {
+    // the run disappears, or takes the new value
+    if ( sameAsPrevious && sameAsNext )
+      {
+      line[s - 1].first += 1 + line[s + 1].first;
+      line.erase( line.begin() + s, line.begin() + s + 2 );
+      }
+    else if ( sameAsPrevious )
+      {
+      ++line[s - 1].first;
+      line.erase( line.begin() + s );
+      }
+    else if ( sameAsNext )
+      {
+      ++line[s + 1].first;
+      line.erase( line.begin() + s );
+      }
+    else
+      {
+      line[s].second = value;
+      }
+    }
+  else if ( x == 0 )
+    {
+    // first pixel of the run
+    --line[s].first;
+    if ( sameAsPrevious )
+      {
+      ++line[s - 1].first;
+      }
+    else
+      {
+      line.insert( line.begin() + s, RLSegment(1, value) );
+      }
+    }
+  else if ( x == static_cast< IndexValueType >( length ) - 1 )
+    {
+    // last pixel of the run
+    --line[s].first;
+    if ( sameAsNext )
+      {
+      ++line[s + 1].first;
+      }
+    else
+      {
+      line.insert( line.begin() + s + 1, RLSegment(1, value) );
+      }
+    }
+  else
+    {
+    // the run is split in three
+    const RLSegment after( static_cast< CounterType >( length - x - 1 ), line[s].second );
+    line[s].first = static_cast< CounterType >( x );
+    line.insert( line.begin() + s + 1, 2, after );
+    line[s + 1] = RLSegment(1, value);
+    }
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+typename RLEImage< TPixel, VImageDimension, TCounter >::SizeValueType
+RLEImage< TPixel, VImageDimension, TCounter >
+::GetNumberOfRuns() const
+{
+  SizeValueType numberOfRuns = 0;
+  const typename BufferType::STLContainerType & lines = m_Buffer->CastToSTLConstContainer();
+  for ( typename BufferType::STLContainerType::const_iterator it = lines.begin(); it != lines.end(); ++it )
+    {
+    numberOfRuns += it->size();
+    }
+  return numberOfRuns;
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+void
+RLEImage< TPixel, VImageDimension, TCounter >
+::MergeRuns(RLLine & line)
+{
+  if ( line.empty() )
+    {
+    return;
+    }
+  SizeValueType last = 0;
+  for ( SizeValueType s = 1; s < line.size(); ++s )
+    {
+    if ( line[s].second == line[last].second )
+      {
+      line[last].first += line[s].first;
+      }
+    else
+      {
+      line[++last] = line[s];
+      }
+    }
+  line.resize( last + 1 );
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+void
+RLEImage< TPixel, VImageDimension, TCounter >
+::CleanUp()
+{
+  typename BufferType::STLContainerType & lines = m_Buffer->CastToSTLContainer();
+  for ( typename BufferType::STLContainerType::iterator it = lines.begin(); it != lines.end(); ++it )
+    {
+    MergeRuns(*it);
+    }
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+void
+RLEImage< TPixel, VImageDimension, TCounter >
+::Graft(const Self *imgData)
+{
+  if ( imgData == ITK_NULLPTR )
+    {
+    return; // nothing to do
+    }
+  // call the superclass' implementation
+  Superclass::Graft(imgData);
+
+  // share the lines
+  m_Buffer = const_cast< BufferType * >( imgData->GetBuffer() );
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+void
+RLEImage< TPixel, VImageDimension, TCounter >
+::Graft(const DataObject *data)
+{
+  if ( data == ITK_NULLPTR )
+    {
+    return; // nothing to do
+    }
+
+  // Attempt to cast data to an RLEImage
+  const Self *imgData = dynamic_cast< const Self * >( data );
+
+  if ( imgData == ITK_NULLPTR )
+    {
+    // pointer could not be cast back down
+    itkExceptionMacro( << "itk::RLEImage::Graft() cannot cast "
+                       << typeid( data ).name() << " to "
+                       << typeid( const Self * ).name() );
+    }
+  this->Graft(imgData);
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename TCounter >
+void
+RLEImage< TPixel, VImageDimension, TCounter >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfLines: " << this->GetNumberOfLines() << std::endl;
+  os << indent << "NumberOfRuns: " << this->GetNumberOfRuns() << std::endl;
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImageRegionConstIterator_h
+#define itkRLEImageRegionConstIterator_h
+
+#include "itkRLEImage.h"
+#include <algorithm>
+
+namespace itk
+{
+/** \class RLEImageRegionConstIterator
+ * \brief A read-only iterator over the pixels of a region of an RLEImage.
+ *
+ * RLEImageRegionConstIterator visits the pixels of a region in the same
+ * order as ImageRegionConstIterator: the first dimension is the fastest.
+ * Incrementing the iterator only moves to the next run of the line when
+ * the end of the current run is reached, so the pixels are visited in
+ * constant time.
+ *
+ * The iterator can also visit the region run by run: GetRunLength()
+ * gives the number of pixels left in the current run, clipped to the
+ * region, and NextRun() moves to the first pixel after them.
+ *
+ * \sa RLEImage, ImageRegionConstIterator
+ * \ingroup ImageIterators
+ * \ingroup ITKLabelMap
+ */
+template< typename TImage >
+class ITK_TEMPLATE_EXPORT RLEImageRegionConstIterator
+{
+public:
+  /** Standard class typedefs. */
+  typedef RLEImageRegionConstIterator Self;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TImage::ImageDimension);
+
+  typedef TImage                             ImageType;
+  typedef typename ImageType::PixelType      PixelType;
+  typedef typename ImageType::IndexType      IndexType;
+  typedef typename ImageType::IndexValueType IndexValueType;
+  typedef typename ImageType::SizeType       SizeType;
+  typedef typename ImageType::SizeValueType  SizeValueType;
+  typedef typename ImageType::RegionType     RegionType;
+  typedef typename ImageType::RLLine         RLLine;
+
+  /** Default constructor.  The iterator is at end until it is assigned. */
+  RLEImageRegionConstIterator();
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image.  The region must be in the buffered
+   * region of the image. */
+  RLEImageRegionConstIterator(const ImageType *image, const RegionType & region);
+
+  /** Move the iterator to the first pixel of the region. */
+  void GoToBegin();
+
+  /** Is the iterator past the last pixel of the region? */
+  bool IsAtEnd() const
+  {
+    return m_IsAtEnd;
+  }
+
+  /** Move to the next pixel. */
+  Self & operator++()
+  {
+    ++m_Index[0];
+    if ( m_Index[0] == m_SegmentEnd && m_Index[0] != m_LineEnd )
+      {
+      ++m_Segment;
+      m_SegmentEnd += ( *m_Line )[m_Segment].first;
+      }
+    else if ( m_Index[0] == m_LineEnd )
+      {
+      this->NextLine();
+      }
+    return *this;
+  }
+
+  /** Move to the first pixel after the current run, or to the next line
+   * if the run ends the line of the region. */
+  void NextRun()
+  {
+    m_Index[0] = std::min( m_SegmentEnd, m_LineEnd ) - 1;
+    ++( *this );
+  }
+
+  /** Number of pixels from the current one to the end of its run,
+   * clipped to the region. */
+  SizeValueType GetRunLength() const
+  {
+    return static_cast< SizeValueType >( std::min( m_SegmentEnd, m_LineEnd ) - m_Index[0] );
+  }
+
+  /** Value of the current pixel. */
+  const PixelType & Get() const
+  {
+    return ( *m_Line )[m_Segment].second;
+  }
+  const PixelType & Value() const
+  {
+    return ( *m_Line )[m_Segment].second;
+  }
+
+  /** Index of the current pixel. */
+  const IndexType & GetIndex() const
+  {
+    return m_Index;
+  }
+
+  /** The region iterated over. */
+  const RegionType & GetRegion() const
+  {
+    return m_Region;
+  }
+
+  /** The image iterated over. */
+  const ImageType * GetImage() const
+  {
+    return m_Image;
+  }
+
+private:
+  /** Move to the beginning of the next line of the region. */
+  void NextLine();
+
+  /** Find the run of the current pixel. */
+  void SetLine();
+
+  const ImageType *m_Image;
+  RegionType       m_Region;
+  IndexType        m_Index;
+  IndexType        m_EndIndex;
+  IndexValueType   m_LineEnd;
+  const RLLine *   m_Line;
+  SizeValueType    m_Segment;
+  IndexValueType   m_SegmentEnd;
+  bool             m_IsAtEnd;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRLEImageRegionConstIterator.hxx"
+#endif
+
+#endif
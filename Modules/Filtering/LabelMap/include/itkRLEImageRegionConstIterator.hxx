@@ -0,0 +1,116 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImageRegionConstIterator_hxx
+#define itkRLEImageRegionConstIterator_hxx
+
+#include "itkRLEImageRegionConstIterator.h"
+
+namespace itk
+{
+template< typename TImage >
+RLEImageRegionConstIterator< TImage >
+::RLEImageRegionConstIterator() :
+  m_Image( ITK_NULLPTR ),
+  m_LineEnd( 0 ),
+  m_Line( ITK_NULLPTR ),
+  m_Segment( 0 ),
+  m_SegmentEnd( 0 ),
+  m_IsAtEnd( true )
+{
+  m_Index.Fill(0);
+  m_EndIndex.Fill(0);
+}
+
+template< typename TImage >
+RLEImageRegionConstIterator< TImage >
+::RLEImageRegionConstIterator(const ImageType *image, const RegionType & region) :
+  m_Image( image ),
+  m_Region( region ),
+  m_LineEnd( 0 ),
+  m_Line( ITK_NULLPTR ),
+  m_Segment( 0 ),
+  m_SegmentEnd( 0 ),
+  m_IsAtEnd( true )
+{
+  if ( region.GetNumberOfPixels() > 0
+       && !image->GetBufferedRegion().IsInside( region ) )
+    {
+    itkGenericExceptionMacro(<< "Region " << region
+                             << " is outside of buffered region " << image->GetBufferedRegion());
+    }
+  this->GoToBegin();
+}
+
+template< typename TImage >
+void
+RLEImageRegionConstIterator< TImage >
+::GoToBegin()
+{
+  m_Index = m_Region.GetIndex();
+  m_EndIndex = m_Region.GetUpperIndex();
+  m_LineEnd = m_EndIndex[0] + 1;
+  m_IsAtEnd = ( m_Image == ITK_NULLPTR || m_Region.GetNumberOfPixels() == 0 );
+  if ( !m_IsAtEnd )
+    {
+    this->SetLine();
+    }
+}
+
+template< typename TImage >
+void
+RLEImageRegionConstIterator< TImage >
+::NextLine()
+{
+  m_Index[0] = m_Region.GetIndex(0);
+  unsigned int dim = 1;
+  for (; dim < ImageDimension; ++dim )
+    {
+    if ( m_Index[dim] < m_EndIndex[dim] )
+      {
+      ++m_Index[dim];
+      break;
+      }
+    m_Index[dim] = m_Region.GetIndex(dim);
+    }
+  if ( dim == ImageDimension )
+    {
+    // all the lines have been visited
+    m_Index[0] = m_LineEnd;
+    m_IsAtEnd = true;
+    return;
+    }
+  this->SetLine();
+}
+
+template< typename TImage >
+void
+RLEImageRegionConstIterator< TImage >
+::SetLine()
+{
+  m_Line = &m_Image->GetLine( m_Image->ComputeLineId(m_Index) );
+  m_Segment = 0;
+  m_SegmentEnd = m_Image->GetBufferedRegion().GetIndex(0) + ( *m_Line )[0].first;
+  while ( m_SegmentEnd <= m_Index[0] )
+    {
+    ++m_Segment;
+    m_SegmentEnd += ( *m_Line )[m_Segment].first;
+    }
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,103 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImageToImageFilter_h
+#define itkRLEImageToImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkRLEImage.h"
+
+namespace itk
+{
+/** \class RLEImageToImageFilter
+ * \brief Decode an RLEImage to an image.
+ *
+ * RLEImageToImageFilter only decodes the requested region of its
+ * output, so it can be streamed.  Writing an RLEImage with an
+ * ImageFileWriter divided in several pieces only stores one piece of
+ * the image densely in memory at a time:
+ *
+ * \code
+ * decoder->SetInput( rleImage );
+ * writer->SetInput( decoder->GetOutput() );
+ * writer->SetNumberOfStreamDivisions( 20 );
+ * writer->Update();
+ * \endcode
+ *
+ * \sa RLEImage, ImageToRLEImageFilter
+ * \ingroup ITKLabelMap
+ */
+template< typename TInputImage, typename TOutputImage =
+            Image< typename TInputImage::PixelType, TInputImage::ImageDimension > >
+class ITK_TEMPLATE_EXPORT RLEImageToImageFilter:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef RLEImageToImageFilter                           Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(RLEImageToImageFilter, ImageToImageFilter);
+
+  /** Some typedefs for the input and output. */
+  typedef TInputImage                         InputImageType;
+  typedef typename InputImageType::RegionType InputImageRegionType;
+  typedef typename InputImageType::PixelType  InputImagePixelType;
+  typedef typename InputImageType::RLLine     RLLine;
+
+  typedef TOutputImage                         OutputImageType;
+  typedef typename OutputImageType::RegionType OutputImageRegionType;
+  typedef typename OutputImageType::PixelType  OutputImagePixelType;
+
+  /** Dimension of input image. */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      InputImageType::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      OutputImageType::ImageDimension);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  // Begin concept checking
+  itkConceptMacro( SameDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, OutputImageDimension > ) );
+  itkConceptMacro( InputConvertibleToOutputCheck,
+                   ( Concept::Convertible< InputImagePixelType, OutputImagePixelType > ) );
+  // End concept checking
+#endif
+
+protected:
+  RLEImageToImageFilter() {}
+  ~RLEImageToImageFilter() ITK_OVERRIDE {}
+
+  virtual void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                    ThreadIdType threadId) ITK_OVERRIDE;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(RLEImageToImageFilter);
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRLEImageToImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImageToImageFilter_hxx
+#define itkRLEImageToImageFilter_hxx
+
+#include "itkRLEImageToImageFilter.h"
+#include "itkImageScanlineIterator.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+void
+RLEImageToImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId)
+{
+  const InputImageType *input = this->GetInput();
+  OutputImageType *     output = this->GetOutput();
+
+  const IndexValueType bufferStart = input->GetBufferedRegion().GetIndex(0);
+  const SizeValueType  lineLength = outputRegionForThread.GetSize(0);
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() / lineLength );
+
+  ImageScanlineIterator< OutputImageType > it(output, outputRegionForThread);
+  while ( !it.IsAtEnd() )
+    {
+    const RLLine & line = input->GetLine( input->ComputeLineId( it.GetIndex() ) );
+
+    // skip the runs before the region
+    typename RLLine::const_iterator segment = line.begin();
+    IndexValueType                  segmentEnd = bufferStart + segment->first;
+    while ( segmentEnd <= it.GetIndex()[0] )
+      {
+      ++segment;
+      segmentEnd += segment->first;
+      }
+
+    // and copy the runs in the region
+    const IndexValueType lineEnd = it.GetIndex()[0] + static_cast< IndexValueType >( lineLength );
+    IndexValueType       x = it.GetIndex()[0];
+    while ( true )
+      {
+      const OutputImagePixelType value = static_cast< OutputImagePixelType >( segment->second );
+      const IndexValueType       runEnd = std::min( segmentEnd, lineEnd );
+      for (; x < runEnd; ++x )
+        {
+        it.Set(value);
+        ++it;
+        }
+      if ( x == lineEnd )
+        {
+        break;
+        }
+      ++segment;
+      segmentEnd += segment->first;
+      }
+    it.NextLine();
+    progress.CompletedPixel();
+    }
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,137 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImageToLabelMapFilter_h
+#define itkRLEImageToLabelMapFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkImageRegionSplitterDirection.h"
+#include "itkLabelMap.h"
+#include "itkLabelObject.h"
+#include "itkRLEImage.h"
+
+namespace itk
+{
+/** \class RLEImageToLabelMapFilter
+ * \brief Converts a run length encoded label image to a LabelMap.
+ *
+ * Each run of the input RLEImage which is not the background becomes a
+ * line of the label object of its value.  Unlike
+ * LabelImageToLabelMapFilter, the pixels are never visited one by one:
+ * the time is proportional to the number of runs of the input.
+ *
+ * \sa RLEImage, LabelMapToRLEImageFilter, LabelImageToLabelMapFilter
+ * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
+ * \ingroup ITKLabelMap
+ */
+template< typename TInputImage, typename TOutputImage =
+            LabelMap< LabelObject< typename TInputImage::PixelType,
+                                   TInputImage::ImageDimension > > >
+class ITK_TEMPLATE_EXPORT RLEImageToLabelMapFilter:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef RLEImageToLabelMapFilter                        Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TInputImage                           InputImageType;
+  typedef TOutputImage                          OutputImageType;
+  typedef typename InputImageType::Pointer      InputImagePointer;
+  typedef typename InputImageType::ConstPointer InputImageConstPointer;
+  typedef typename InputImageType::RegionType   InputImageRegionType;
+  typedef typename InputImageType::PixelType    InputImagePixelType;
+  typedef typename InputImageType::IndexType    IndexType;
+  typedef typename InputImageType::RLLine       RLLine;
+
+  typedef typename OutputImageType::Pointer         OutputImagePointer;
+  typedef typename OutputImageType::ConstPointer    OutputImageConstPointer;
+  typedef typename OutputImageType::RegionType      OutputImageRegionType;
+  typedef typename OutputImageType::PixelType       OutputImagePixelType;
+  typedef typename OutputImageType::LabelObjectType LabelObjectType;
+  typedef typename LabelObjectType::LengthType      LengthType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(RLEImageToLabelMapFilter,
+               ImageToImageFilter);
+
+  /**
+   * Set/Get the value used as "background" in the output image.
+   * Defaults to NumericTraits<PixelType>::NonpositiveMin().
+   */
+  itkSetMacro(BackgroundValue, OutputImagePixelType);
+  itkGetConstMacro(BackgroundValue, OutputImagePixelType);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  itkConceptMacro( SameDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, OutputImageDimension > ) );
+#endif
+
+protected:
+  RLEImageToLabelMapFilter();
+  ~RLEImageToLabelMapFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  /** RLEImageToLabelMapFilter needs the entire input be
+   * available. Thus, it needs to provide an implementation of
+   * GenerateInputRequestedRegion(). */
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  /** RLEImageToLabelMapFilter will produce the entire output. */
+  void EnlargeOutputRequestedRegion( DataObject *itkNotUsed(output) ) ITK_OVERRIDE;
+
+  virtual void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  virtual void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId) ITK_OVERRIDE;
+
+  virtual void AfterThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Provide an ImageRegionSplitter that does not split along the first
+   * dimension, so the threads convert complete lines. */
+  virtual const ImageRegionSplitterBase* GetImageRegionSplitter() const ITK_OVERRIDE
+  {
+    return m_ImageRegionSplitter.GetPointer();
+  }
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(RLEImageToLabelMapFilter);
+
+  OutputImagePixelType m_BackgroundValue;
+
+  typename std::vector< OutputImagePointer > m_TemporaryImages;
+
+  ImageRegionSplitterDirection::Pointer m_ImageRegionSplitter;
+}; // end of class
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRLEImageToLabelMapFilter.hxx"
+#endif
+
+#endif
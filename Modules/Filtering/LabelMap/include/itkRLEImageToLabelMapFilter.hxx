@@ -0,0 +1,188 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImageToLabelMapFilter_hxx
+#define itkRLEImageToLabelMapFilter_hxx
+
+#include "itkRLEImageToLabelMapFilter.h"
+#include "itkNumericTraits.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+RLEImageToLabelMapFilter< TInputImage, TOutputImage >
+::RLEImageToLabelMapFilter()
+{
+  m_BackgroundValue = NumericTraits< OutputImagePixelType >::NonpositiveMin();
+
+  m_ImageRegionSplitter = ImageRegionSplitterDirection::New();
+  m_ImageRegionSplitter->SetDirection(0);
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RLEImageToLabelMapFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // We need all the input.
+  InputImagePointer input = const_cast< InputImageType * >( this->GetInput() );
+  if ( !input )
+    {
+    return;
+    }
+  input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RLEImageToLabelMapFilter< TInputImage, TOutputImage >
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()->SetRequestedRegion( this->GetOutput()->GetLargestPossibleRegion() );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RLEImageToLabelMapFilter< TInputImage, TOutputImage >
+::BeforeThreadedGenerateData()
+{
+  // init the temp images - one per thread
+  m_TemporaryImages.resize( this->GetNumberOfThreads() );
+
+  for ( ThreadIdType i = 0; i < this->GetNumberOfThreads(); i++ )
+    {
+    if ( i == 0 )
+      {
+      // the first one is the output image
+      m_TemporaryImages[0] = this->GetOutput();
+      }
+    else
+      {
+      // the other must be created
+      m_TemporaryImages[i] = OutputImageType::New();
+      }
+
+    // set the minimum data needed to create the objects properly
+    m_TemporaryImages[i]->SetBackgroundValue(m_BackgroundValue);
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RLEImageToLabelMapFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(const OutputImageRegionType & regionForThread, ThreadIdType threadId)
+{
+  const InputImageType *input = this->GetInput();
+  OutputImageType *     output = m_TemporaryImages[threadId];
+
+  const IndexValueType bufferStart = input->GetBufferedRegion().GetIndex(0);
+  const IndexValueType lineStart = regionForThread.GetIndex(0);
+  const IndexValueType lineEnd = lineStart + static_cast< IndexValueType >( regionForThread.GetSize(0) );
+  const SizeValueType  numberOfLines = regionForThread.GetNumberOfPixels() / regionForThread.GetSize(0);
+
+  ProgressReporter progress( this, threadId, numberOfLines );
+
+  IndexType index = regionForThread.GetIndex();
+  for ( SizeValueType l = 0; l < numberOfLines; ++l )
+    {
+    // create a line in the label object of each run, except for the
+    // background, clipped to the region
+    const RLLine & line = input->GetLine( input->ComputeLineId(index) );
+    IndexValueType x = bufferStart;
+    for ( typename RLLine::const_iterator segment = line.begin(); segment != line.end() && x < lineEnd; ++segment )
+      {
+      const IndexValueType runStart = std::max( x, lineStart );
+      x += segment->first;
+      if ( x > runStart
+           && segment->second != static_cast< InputImagePixelType >( m_BackgroundValue ) )
+        {
+        index[0] = runStart;
+        output->SetLine( index, static_cast< LengthType >( std::min( x, lineEnd ) - runStart ),
+                         static_cast< OutputImagePixelType >( segment->second ) );
+        }
+      }
+
+    // next line
+    index[0] = lineStart;
+    for ( unsigned int dim = 1; dim < InputImageDimension; ++dim )
+      {
+      if ( ++index[dim] < regionForThread.GetIndex(dim) + static_cast< IndexValueType >( regionForThread.GetSize(dim) ) )
+        {
+        break;
+        }
+      index[dim] = regionForThread.GetIndex(dim);
+      }
+    progress.CompletedPixel();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RLEImageToLabelMapFilter< TInputImage, TOutputImage >
+::AfterThreadedGenerateData()
+{
+  OutputImageType *output = this->GetOutput();
+
+  // merge the lines from the temporary images in the output image
+  // don't use the first image - that's the output image
+  for ( ThreadIdType i = 1; i < this->GetNumberOfThreads(); i++ )
+    {
+    for ( typename OutputImageType::Iterator it( m_TemporaryImages[i] );
+          ! it.IsAtEnd();
+          ++it )
+      {
+      LabelObjectType *labelObject = it.GetLabelObject();
+      if ( output->HasLabel( labelObject->GetLabel() ) )
+        {
+        // merge the lines in the output's object
+        LabelObjectType * lo = output->GetLabelObject( labelObject->GetLabel() );
+        typename LabelObjectType::ConstLineIterator lit( labelObject );
+        while( ! lit.IsAtEnd() )
+          {
+          lo->AddLine( lit.GetLine() );
+          ++lit;
+          }
+        }
+      else
+        {
+        // simply take the object
+        output->AddLabelObject(labelObject);
+        }
+      }
+    }
+
+  // release the data in the temp images
+  m_TemporaryImages.clear();
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RLEImageToLabelMapFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "BackgroundValue: "
+     << static_cast< typename NumericTraits< OutputImagePixelType >::PrintType >( m_BackgroundValue ) << std::endl;
+}
+} // end namespace itk
+#endif
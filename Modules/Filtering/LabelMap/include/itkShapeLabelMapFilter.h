@@ -28,15 +28,14 @@ namespace itk
  * ShapeLabelMapFilter can be used to set the attributes values of the
  * ShapeLabelObject in a LabelMap.
  *
- * ShapeLabelMapFilter takes an optional parameter, used only to
- * optimize the computation time and the memory usage when the
- * perimeter or the feret diameter is used: the exact copy of the
- * input LabelMap is stored in an Image.
- * It can be set with SetLabelImage(). It is cleared at the end of the
- * computation, so must be reset before running Update() again. It is
- * not part of the pipeline management design, to let the subclasses
- * of ShapeLabelMapFilter use the pipeline design to specify truly
- * required inputs.
+ * The perimeter and the Feret diameter are computed from the lines of
+ * each object.  The Feret diameter is searched among the vertices of
+ * the convex hulls of the slices of the object, so it is much cheaper
+ * than comparing all the pairs of pixels on the border of the object.
+ * The objects are processed in parallel.
+ *
+ * The label image which could be set with SetLabelImage() is not
+ * needed anymore, and is ignored.
  *
  * \author Gaetan Lehmann. Biologie du Developpement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
@@ -101,7 +100,7 @@ public:
 
   /**
    * Set/Get whether the maximum Feret diameter should be computed or not.
-   * Default value is false because of the high computation time required.
+   * Default value is false because of the computation time required.
    */
   itkSetMacro(ComputeFeretDiameter, bool);
   itkGetConstReferenceMacro(ComputeFeretDiameter, bool);
@@ -124,7 +123,7 @@ public:
   itkGetConstReferenceMacro(ComputeOrientedBoundingBox, bool);
   itkBooleanMacro(ComputeOrientedBoundingBox);
 
-  /** Set the label image */
+  /** Set the label image. Not used anymore. */
   void SetLabelImage(const TLabelImage *input)
   {
     m_LabelImage = input;
@@ -136,8 +135,6 @@ protected:
 
   virtual void ThreadedProcessLabelObject(LabelObjectType *labelObject) ITK_OVERRIDE;
 
-  virtual void BeforeThreadedGenerateData() ITK_OVERRIDE;
-
   virtual void AfterThreadedGenerateData() ITK_OVERRIDE;
 
   void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
@@ -154,6 +151,28 @@ private:
   void ComputePerimeter(LabelObjectType *labelObject);
   void ComputeOrientedBoundingBox(LabelObjectType *labelObject);
 
+  typedef typename LabelObjectType::LineType LineType;
+  typedef std::vector< LineType >            LineVectorType;
+
+  /** Order the lines by row, then along the row. */
+  static bool LineLessThan(const LineType & a, const LineType & b);
+
+  /** Compare the coordinates of a and b in the dimensions from
+   * firstDimension, starting with the last dimension. */
+  static int CompareRows(const IndexType & a, const IndexType & b, unsigned int firstDimension);
+
+  /** Sort the lines of an object by row, and find the first line of
+   * each row. */
+  static void GetSortedLines(const LabelObjectType *labelObject, LineVectorType & lines,
+                             std::vector< SizeValueType > & rows);
+
+  /** Cross product of (a - o) and (b - o) in the plane of the first two
+   * dimensions, with the second dimension first. */
+  static OffsetValueType Cross(const IndexType & o, const IndexType & a, const IndexType & b)
+  {
+    return ( a[1] - o[1] ) * ( b[0] - o[0] ) - ( a[0] - o[0] ) * ( b[1] - o[1] );
+  }
+
   typedef itk::Offset<2>                                                          Offset2Type;
   typedef itk::Offset<3>                                                          Offset3Type;
   typedef itk::Vector<double, 2>                                                  Spacing2Type;
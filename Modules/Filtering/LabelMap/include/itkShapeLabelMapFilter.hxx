@@ -20,16 +20,12 @@
 
 #include "itkShapeLabelMapFilter.h"
 #include "itkProgressReporter.h"
-#include "itkConstNeighborhoodIterator.h"
-#include "itkConstShapedNeighborhoodIterator.h"
 #include "itkLabelMapToLabelImageFilter.h"
-#include "itkConstantBoundaryCondition.h"
 #include "itkGeometryUtilities.h"
-#include "itkConnectedComponentAlgorithm.h"
 #include "vnl/algo/vnl_real_eigensystem.h"
 #include "vnl/algo/vnl_symmetric_eigensystem.h"
 #include "itkMath.h"
-#include <deque>
+#include <algorithm>
 #include <map>
 
 namespace itk
@@ -43,30 +39,6 @@ ShapeLabelMapFilter< TImage, TLabelImage >
   m_ComputeOrientedBoundingBox = false;
 }
 
-template< typename TImage, typename TLabelImage >
-void
-ShapeLabelMapFilter< TImage, TLabelImage >
-::BeforeThreadedGenerateData()
-{
-  Superclass::BeforeThreadedGenerateData();
-
-  // Generate the label image, if needed
-  if ( m_ComputeFeretDiameter )
-    {
-    if ( !m_LabelImage )
-      {
-      // generate an image of the labelized image
-      typedef LabelMapToLabelImageFilter< TImage, LabelImageType > LCI2IType;
-      typename LCI2IType::Pointer lci2i = LCI2IType::New();
-      lci2i->SetInput( this->GetOutput() );
-      // Respect the number of threads of the filter
-      lci2i->SetNumberOfThreads( this->GetNumberOfThreads() );
-      lci2i->Update();
-      m_LabelImage = lci2i->GetOutput();
-      }
-    }
-}
-
 template< typename TImage, typename TLabelImage >
 void
 ShapeLabelMapFilter< TImage, TLabelImage >
@@ -424,44 +396,136 @@ ShapeLabelMapFilter< TImage, TLabelImage >
 }
 
 template< typename TImage, typename TLabelImage >
-void
+bool
 ShapeLabelMapFilter< TImage, TLabelImage >
-::ComputeFeretDiameter(LabelObjectType *labelObject)
+::LineLessThan(const LineType & a, const LineType & b)
 {
-  const LabelPixelType & label = labelObject->GetLabel();
+  const IndexType & ia = a.GetIndex();
+  const IndexType & ib = b.GetIndex();
+  for ( int i = ImageDimension - 1; i >= 0; i-- )
+    {
+    if ( ia[i] != ib[i] )
+      {
+      return ia[i] < ib[i];
+      }
+    }
+  return false;
+}
 
-  typedef typename std::deque< IndexType > IndexListType;
-  IndexListType idxList;
+template< typename TImage, typename TLabelImage >
+int
+ShapeLabelMapFilter< TImage, TLabelImage >
+::CompareRows(const IndexType & a, const IndexType & b, unsigned int firstDimension)
+{
+  for ( int i = ImageDimension - 1; i >= static_cast< int >( firstDimension ); i-- )
+    {
+    if ( a[i] != b[i] )
+      {
+      return a[i] < b[i] ? -1 : 1;
+      }
+    }
+  return 0;
+}
+
+template< typename TImage, typename TLabelImage >
+void
+ShapeLabelMapFilter< TImage, TLabelImage >
+::GetSortedLines(const LabelObjectType *labelObject, LineVectorType & lines, std::vector< SizeValueType > & rows)
+{
+  lines.clear();
+  lines.reserve( labelObject->GetNumberOfLines() );
+  for ( typename LabelObjectType::ConstLineIterator lit( labelObject ); !lit.IsAtEnd(); ++lit )
+    {
+    lines.push_back( lit.GetLine() );
+    }
+  std::sort( lines.begin(), lines.end(), LineLessThan );
 
-  typedef typename itk::ConstNeighborhoodIterator< LabelImageType > NeighborIteratorType;
-  SizeType neighborHoodRadius;
-  neighborHoodRadius.Fill(1);
-  NeighborIteratorType                        it( neighborHoodRadius, m_LabelImage, m_LabelImage->GetBufferedRegion() );
-  ConstantBoundaryCondition< LabelImageType > lcbc;
-  // Use label + 1 to have a label different of the current label on the border
-  lcbc.SetConstant(label + 1);
-  it.OverrideBoundaryCondition(&lcbc);
-  it.GoToBegin();
+  // the first line of each row, and the end of the last row
+  rows.clear();
+  for ( SizeValueType i = 0; i < lines.size(); i++ )
+    {
+    if ( i == 0 || CompareRows( lines[i - 1].GetIndex(), lines[i].GetIndex(), 1 ) != 0 )
+      {
+      rows.push_back( i );
+      }
+    }
+  rows.push_back( lines.size() );
+}
 
-  typedef typename NeighborIteratorType::NeighborIndexType   NeighborIndexType;
+template< typename TImage, typename TLabelImage >
+void
+ShapeLabelMapFilter< TImage, TLabelImage >
+::ComputeFeretDiameter(LabelObjectType *labelObject)
+{
+  // The two pixels the most distant from each other are vertices of the
+  // convex hull of the object.  A vertex of the hull of the object is
+  // also a vertex of the hull of its slice along the first two
+  // dimensions, and the hull of a slice only depends on the leftmost and
+  // rightmost pixels of each of its rows.
+  LineVectorType               lines;
+  std::vector< SizeValueType > rows;
+  GetSortedLines( labelObject, lines, rows );
+
+  typedef std::vector< IndexType > IndexListType;
+  IndexListType idxList;
+  IndexListType slice;
+  IndexListType hull;
 
-  // Iterate over all the indexes
-  typename LabelObjectType::ConstIndexIterator iit( labelObject );
-  while( ! iit.IsAtEnd() )
+  const unsigned int rowDimension = ImageDimension > 1 ? 1 : 0;
+  for ( SizeValueType r = 0; r + 1 < rows.size(); r++ )
     {
-    // Move the iterator to the new location
-    it += iit.GetIndex() - it.GetIndex();
+    // the ends of the row, in the order of the row coordinate then of
+    // the line coordinate
+    IndexType      first = lines[rows[r]].GetIndex();
+    IndexValueType lastIndex0 = first[0];
+    for ( SizeValueType l = rows[r]; l < rows[r + 1]; l++ )
+      {
+      lastIndex0 = std::max( lastIndex0,
+                             lines[l].GetIndex()[0] + static_cast< IndexValueType >( lines[l].GetLength() ) - 1 );
+      }
+    IndexType last = first;
+    last[0] = lastIndex0;
+    slice.push_back( first );
+    if ( lastIndex0 != first[0] )
+      {
+      slice.push_back( last );
+      }
 
-    // Push the pixel in the list if it is on the border of the object
-    for ( NeighborIndexType i = 0; i < it.Size(); i++ )
+    // at the end of the slice, keep the vertices of its hull
+    if ( r + 2 == rows.size()
+         || CompareRows( first, lines[rows[r + 1]].GetIndex(), 2 ) != 0 )
       {
-      if ( it.GetPixel(i) != label )
+      if ( slice.size() <= 2 || rowDimension == 0 )
         {
-        idxList.push_back( iit.GetIndex() );
-        break;
+        idxList.insert( idxList.end(), slice.begin(), slice.end() );
+        }
+      else
+        {
+        // monotone chain
+        hull.resize( 2 * slice.size() );
+        SizeValueType k = 0;
+        for ( SizeValueType i = 0; i < slice.size(); i++ )
+          {
+          while ( k >= 2 && Cross( hull[k - 2], hull[k - 1], slice[i] ) <= 0 )
+            {
+            k--;
+            }
+          hull[k++] = slice[i];
+          }
+        const SizeValueType lowerSize = k + 1;
+        for ( SizeValueType i = slice.size() - 1; i > 0; i-- )
+          {
+          while ( k >= lowerSize && Cross( hull[k - 2], hull[k - 1], slice[i - 1] ) <= 0 )
+            {
+            k--;
+            }
+          hull[k++] = slice[i - 1];
+          }
+        // the first vertex is repeated at the end
+        idxList.insert( idxList.end(), hull.begin(), hull.begin() + ( k - 1 ) );
         }
+      slice.clear();
       }
-    ++iit;
     }
 
   ImageType *output = this->GetOutput();
@@ -502,110 +566,103 @@ void
 ShapeLabelMapFilter< TImage, TLabelImage >
 ::ComputePerimeter(LabelObjectType *labelObject)
 {
-  // store the lines in a N-1D image of vectors
-  typedef std::deque< typename LabelObjectType::LineType > VectorLineType;
-  typedef itk::Image< VectorLineType, ImageDimension - 1 > LineImageType;
-  typename LineImageType::Pointer lineImage = LineImageType::New();
-  typename LineImageType::IndexType lIdx;
-  typename LineImageType::SizeType lSize;
-  RegionType boundingBox = labelObject->GetBoundingBox();
-  for( unsigned int i=0; i<ImageDimension-1; i++ )
-    {
-    lIdx[i] = boundingBox.GetIndex()[i+1];
-    lSize[i] = boundingBox.GetSize()[i+1];
-    }
-  typename LineImageType::RegionType lRegion;
-  lRegion.SetIndex( lIdx );
-  lRegion.SetSize( lSize );
-  // enlarge the region a bit to avoid boundary problems
-  typename LineImageType::RegionType elRegion(lRegion);
-  lSize.Fill(1);
-  elRegion.PadByRadius(lSize);
-  // std::cout << boundingBox << "  " << lRegion << "  " << elRegion << std::endl;
-  // now initialize the image
-  lineImage->SetRegions( elRegion );
-  lineImage->Allocate();
-  lineImage->FillBuffer( VectorLineType() );
-
-  // std::cout << "lineContainer.size(): " << lineContainer.size() << std::endl;
-
-  // Iterate over all the lines and fill the image of lines
-  typename LabelObjectType::ConstLineIterator lit( labelObject );
-  while( ! lit.IsAtEnd() )
+  // the lines sorted by row
+  LineVectorType               lines;
+  std::vector< SizeValueType > rows;
+  GetSortedLines( labelObject, lines, rows );
+  const SizeValueType numberOfRows = rows.size() - 1;
+
+  // the offsets of the neighbor rows
+  std::vector< OffsetType > rowOffsets;
+  OffsetType                rowOffset;
+  rowOffset.Fill(-1);
+  rowOffset[0] = 0;
+  while ( ImageDimension > 1 )
     {
-    const IndexType & idx = lit.GetLine().GetIndex();
-    for( unsigned int i=0; i<ImageDimension-1; i++ )
+    bool isCenter = true;
+    for ( unsigned int i = 1; i < ImageDimension; i++ )
       {
-      lIdx[i] = idx[i+1];
+      isCenter &= ( rowOffset[i] == 0 );
       }
-    lineImage->GetPixel( lIdx ).push_back( lit.GetLine() );
-    ++lit;
+    if ( !isCenter )
+      {
+      rowOffsets.push_back( rowOffset );
+      }
+    unsigned int i = 1;
+    while ( i < ImageDimension && rowOffset[i] == 1 )
+      {
+      rowOffset[i++] = -1;
+      }
+    if ( i == ImageDimension )
+      {
+      break;
+      }
+    rowOffset[i]++;
     }
 
-  // a data structure to store the number of intercepts on each direction
-  typedef typename std::map<OffsetType, SizeValueType, typename OffsetType::LexicographicCompare> MapInterceptType;
-  MapInterceptType intercepts;
-  // int nbOfDirections = (int)std::pow( 2.0, (int)ImageDimension ) - 1;
-  // intecepts.resize(nbOfDirections + 1);  // code begins at position 1
+  // the number of intercepts in each direction, indexed by the
+  // dimensions where the direction is not null
+  std::vector< SizeValueType > intercepts( 1 << ImageDimension, 0 );
 
-  // now iterate over the vectors of lines
-  typedef ConstShapedNeighborhoodIterator< LineImageType > LineImageIteratorType;
-  LineImageIteratorType lIt( lSize, lineImage, lRegion ); // the original, non padded region
-  setConnectivity( &lIt, true );
-  for( lIt.GoToBegin(); !lIt.IsAtEnd(); ++lIt )
+  // now iterate over the rows of lines
+  for ( SizeValueType r = 0; r < numberOfRows; r++ )
     {
-    const VectorLineType & ls = lIt.GetCenterPixel();
+    const LineType * ls = &lines[rows[r]];
+    const LineType * lsEnd = &lines[0] + rows[r + 1];
 
     // there are two intercepts on the 0 axis for each line
-    OffsetType no;
-    no.Fill(0);
-    no[0] = 1;
-    // std::cout << no << "-> " << 2 * ls.size() << std::endl;
-    intercepts[no] += 2 * static_cast<SizeValueType>( ls.size() );
+    intercepts[1] += 2 * static_cast<SizeValueType>( lsEnd - ls );
 
     // and look at the neighbors
-    typename LineImageIteratorType::ConstIterator ci;
-    for (ci = lIt.Begin(); ci != lIt.End(); ci++)
-      {
-          // std::cout << "-------------" << std::endl;
-      // the vector of lines in the neighbor
-      const VectorLineType & ns = ci.Get();
-      // prepare the offset to be stored in the intercepts map
-      typename LineImageType::OffsetType lno = ci.GetNeighborhoodOffset();
-      no[0] = 0;
-      for( unsigned int i=0; i<ImageDimension-1; i++ )
+    for ( typename std::vector< OffsetType >::const_iterator oIt = rowOffsets.begin(); oIt != rowOffsets.end(); ++oIt )
+      {
+      // the direction to be stored in the intercepts
+      unsigned int no = 0;
+      for ( unsigned int i = 1; i < ImageDimension; i++ )
         {
-        no[i+1] = itk::Math::abs(lno[i]);
+        if ( ( *oIt )[i] != 0 )
+          {
+          no |= 1 << i;
+          }
         }
-      OffsetType dno = no; // offset for the diagonal
-      dno[0] = 1;
+      const unsigned int dno = no | 1; // direction for the diagonal
 
-      // now process the two lines to search the pixels on the contour of the object
-      if( ls.empty() )
+      // search the neighbor row
+      const IndexType neighborIndex = ls->GetIndex() + *oIt;
+      SizeValueType   begin = 0;
+      SizeValueType   end = numberOfRows;
+      while ( begin < end )
         {
-        // std::cout << "ls.empty()" << std::endl;
-        // nothing to do
+        const SizeValueType middle = ( begin + end ) / 2;
+        if ( CompareRows( lines[rows[middle]].GetIndex(), neighborIndex, 1 ) < 0 )
+          {
+          begin = middle + 1;
+          }
+        else
+          {
+          end = middle;
+          }
         }
-      if( ns.empty() )
+
+      // now process the two lines to search the pixels on the contour of the object
+      if( begin == numberOfRows || CompareRows( lines[rows[begin]].GetIndex(), neighborIndex, 1 ) != 0 )
         {
         // no line in the neighbors - all the lines in ls are on the contour
-        for( typename VectorLineType::const_iterator li = ls.begin(); li != ls.end(); ++li )
+        for( const LineType * li = ls; li != lsEnd; ++li )
           {
-          // std::cout << "ns.empty()" << std::endl;
-          const typename LabelObjectType::LineType & l = *li;
           // add as much intercepts as the line size
-          intercepts[no] += l.GetLength();
+          intercepts[no] += li->GetLength();
           // and 2 times as much diagonal intercepts as the line size
-          intercepts[dno] += l.GetLength() * 2;
+          intercepts[dno] += li->GetLength() * 2;
           }
         }
       else
         {
-        // std::cout << "else" << std::endl;
         // TODO - fix the code when the line starts at  NumericTraits<IndexValueType>::NonpositiveMin()
         // or end at  NumericTraits<IndexValueType>::max()
-        typename VectorLineType::const_iterator li = ls.begin();
-        typename VectorLineType::const_iterator ni = ns.begin();
+        const LineType * li = ls;
+        const LineType * ni = &lines[rows[begin]];
+        const LineType * nsEnd = &lines[0] + rows[begin + 1];
 
         IndexValueType lZero = 0;
         IndexValueType lMin = 0;
@@ -614,7 +671,7 @@ ShapeLabelMapFilter< TImage, TLabelImage >
         IndexValueType nMin = NumericTraits<IndexValueType>::NonpositiveMin() + 1;
         IndexValueType nMax = ni->GetIndex()[0] - 1;
 
-        while( li!=ls.end() )
+        while( li != lsEnd )
           {
           // update the current line min and max. Neighbor line data is already up to date.
           lMin = li->GetIndex()[0];
@@ -622,12 +679,6 @@ ShapeLabelMapFilter< TImage, TLabelImage >
 
           // add as much intercepts as intersections of the 2 lines
           intercepts[no] += std::max( lZero, std::min(lMax, nMax) - std::max(lMin, nMin) + 1 );
-          // std::cout << "============" << std::endl;
-          // std::cout << "  lMin:" << lMin << " lMax:" << lMax << " nMin:" << nMin << " nMax:" << nMax;
-          // std::cout << " count: " << std::max( 0l, std::min(lMax, nMax) - std::max(lMin, nMin) + 1 ) << std::endl;
-          // std::cout << "  " << no << ": " << intercepts[no] << std::endl;
-          // std::cout << std::max( lZero, std::min(lMax, nMax+1) - std::max(lMin, nMin+1) + 1 ) << std::endl;
-          // std::cout << std::max( lZero, std::min(lMax, nMax-1) - std::max(lMin, nMin-1) + 1 ) << std::endl;
           // left diagonal intercepts
           intercepts[dno] += std::max( lZero, std::min(lMax, nMax+1) - std::max(lMin, nMin+1) + 1 );
           // right diagonal intercepts
@@ -640,7 +691,7 @@ ShapeLabelMapFilter< TImage, TLabelImage >
             nMin = ni->GetIndex()[0] + ni->GetLength();
             ni++;
 
-            if( ni != ns.end() )
+            if( ni != nsEnd )
               {
               nMax = ni->GetIndex()[0] - 1;
               }
@@ -655,13 +706,25 @@ ShapeLabelMapFilter< TImage, TLabelImage >
             li++;
             }
           }
-
         }
       }
     }
 
+  // store the intercepts in a map for PerimeterFromInterceptCount
+  typedef typename std::map<OffsetType, SizeValueType, typename OffsetType::LexicographicCompare> MapInterceptType;
+  MapInterceptType interceptMap;
+  for ( unsigned int code = 0; code < intercepts.size(); code++ )
+    {
+    OffsetType no;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      no[i] = ( code >> i ) & 1;
+      }
+    interceptMap[no] = intercepts[code];
+    }
+
   // compute the perimeter based on the intercept counts
-  double perimeter = PerimeterFromInterceptCount( intercepts, this->GetOutput()->GetSpacing() );
+  double perimeter = PerimeterFromInterceptCount( interceptMap, this->GetOutput()->GetSpacing() );
   labelObject->SetPerimeter( perimeter );
   labelObject->SetRoundness( labelObject->GetEquivalentSphericalPerimeter() / perimeter );
   labelObject->SetPerimeterOnBorderRatio( labelObject->GetPerimeterOnBorder() / perimeter );
@@ -0,0 +1,195 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageToRLEImageFilter.h"
+#include "itkRLEImageRegionConstIterator.h"
+#include "itkRLEImageToImageFilter.h"
+#include "itkTestingMacros.h"
+
+// Encode a label image, compare the pixels of the RLEImage and of its
+// iterators with the pixels of the image, modify pixels of both, and
+// decode the RLEImage.
+namespace
+{
+
+const unsigned int Dimension = 3;
+
+typedef itk::Image< unsigned char, Dimension >    ImageType;
+typedef itk::RLEImage< unsigned char, Dimension > RLEImageType;
+
+bool
+SameRegion(const ImageType *image, const RLEImageType *rleImage, const ImageType::RegionType & region)
+{
+  itk::ImageRegionConstIterator< ImageType >       it( image, region );
+  itk::RLEImageRegionConstIterator< RLEImageType > rit( rleImage, region );
+  for ( ; !it.IsAtEnd(); ++it, ++rit )
+    {
+    if ( rit.IsAtEnd() || rit.GetIndex() != it.GetIndex() || rit.Get() != it.Get()
+         || rleImage->GetPixel( it.GetIndex() ) != it.Get() )
+      {
+      std::cerr << "Different pixels at " << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  if ( !rit.IsAtEnd() )
+    {
+    std::cerr << "The iterator of the RLEImage does not end with the region" << std::endl;
+    return false;
+    }
+
+  // visit the region run by run
+  itk::SizeValueType numberOfPixels = 0;
+  for ( rit.GoToBegin(); !rit.IsAtEnd(); rit.NextRun() )
+    {
+    const itk::SizeValueType length = rit.GetRunLength();
+    ImageType::IndexType     index = rit.GetIndex();
+    for ( itk::SizeValueType i = 0; i < length; ++i, ++index[0] )
+      {
+      if ( image->GetPixel(index) != rit.Get() )
+        {
+        std::cerr << "Wrong run at " << rit.GetIndex() << std::endl;
+        return false;
+        }
+      }
+    numberOfPixels += length;
+    }
+  if ( numberOfPixels != region.GetNumberOfPixels() )
+    {
+    std::cerr << "The runs cover " << numberOfPixels << " pixels instead of "
+              << region.GetNumberOfPixels() << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+int itkRLEImageTest(int, char* [])
+{
+  ImageType::IndexType start;
+  start[0] = -3;
+  start[1] = 5;
+  start[2] = 2;
+  ImageType::SizeType size;
+  size[0] = 37;
+  size[1] = 21;
+  size[2] = 9;
+  const ImageType::RegionType region( start, size );
+
+  // blocks of labels along the lines
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  unsigned int value = 5;
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, region );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    value = value * 1664525u + 1013904223u;
+    const ImageType::IndexType & index = it.GetIndex();
+    unsigned char label = static_cast< unsigned char >( ( index[0] + 3 ) / 6 + index[1] / 4 + index[2] );
+    if ( ( ( value >> 8 ) % 10 ) == 0 )
+      {
+      label = 0;
+      }
+    it.Set( label );
+    }
+
+  typedef itk::ImageToRLEImageFilter< ImageType, RLEImageType > EncoderType;
+  EncoderType::Pointer encoder = EncoderType::New();
+  encoder->SetInput( image );
+  encoder->SetNumberOfStreamDivisions( 4 );
+  TEST_SET_GET_VALUE( 4, encoder->GetNumberOfStreamDivisions() );
+  TRY_EXPECT_NO_EXCEPTION( encoder->Update() );
+
+  RLEImageType::Pointer rleImage = encoder->GetOutput();
+  rleImage->DisconnectPipeline();
+  std::cout << "Number of runs: " << rleImage->GetNumberOfRuns() << " for "
+            << region.GetNumberOfPixels() << " pixels" << std::endl;
+  TEST_EXPECT_EQUAL( rleImage->GetNumberOfLines(), size[1] * size[2] );
+  TEST_EXPECT_TRUE( rleImage->GetNumberOfRuns() < region.GetNumberOfPixels() / 2 );
+
+  bool success = SameRegion( image, rleImage, region );
+
+  // a region which does not start at the beginning of the lines
+  ImageType::IndexType subStart = start;
+  subStart[0] += 4;
+  subStart[1] += 3;
+  ImageType::SizeType subSize;
+  subSize[0] = 11;
+  subSize[1] = 5;
+  subSize[2] = 3;
+  success &= SameRegion( image, rleImage, ImageType::RegionType( subStart, subSize ) );
+
+  // modify some pixels: isolated, at the ends of the runs, and in the
+  // middle of the runs
+  for ( unsigned int i = 0; i < 2000; ++i )
+    {
+    value = value * 1664525u + 1013904223u;
+    ImageType::IndexType index;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      index[d] = start[d] + static_cast< itk::IndexValueType >( ( value >> ( 4 + 7 * d ) ) % size[d] );
+      }
+    const unsigned char label = static_cast< unsigned char >( ( value >> 28 ) % 4 );
+    image->SetPixel( index, label );
+    rleImage->SetPixel( index, label );
+    }
+  success &= SameRegion( image, rleImage, region );
+
+  // SetPixel() keeps the runs merged
+  const itk::SizeValueType numberOfRuns = rleImage->GetNumberOfRuns();
+  rleImage->CleanUp();
+  TEST_EXPECT_EQUAL( rleImage->GetNumberOfRuns(), numberOfRuns );
+
+  // the decoded image
+  typedef itk::RLEImageToImageFilter< RLEImageType, ImageType > DecoderType;
+  DecoderType::Pointer decoder = DecoderType::New();
+  decoder->SetInput( rleImage );
+  decoder->SetNumberOfThreads( 3 );
+  TRY_EXPECT_NO_EXCEPTION( decoder->Update() );
+  success &= SameRegion( decoder->GetOutput(), rleImage, region );
+
+  // a grafted image shares the lines
+  RLEImageType::Pointer grafted = RLEImageType::New();
+  grafted->Graft( rleImage );
+  TEST_EXPECT_EQUAL( grafted->GetBuffer(), rleImage->GetBuffer() );
+  TEST_EXPECT_EQUAL( grafted->GetBufferedRegion(), rleImage->GetBufferedRegion() );
+
+  rleImage->FillBuffer( 7 );
+  TEST_EXPECT_EQUAL( rleImage->GetNumberOfRuns(), rleImage->GetNumberOfLines() );
+  TEST_EXPECT_EQUAL( static_cast< int >( rleImage->GetPixel( subStart ) ), 7 );
+
+  // the lines are limited by the counter type
+  typedef itk::RLEImage< unsigned char, 2, unsigned char > SmallCounterRLEImageType;
+  SmallCounterRLEImageType::Pointer tooLong = SmallCounterRLEImageType::New();
+  SmallCounterRLEImageType::SizeType tooLongSize;
+  tooLongSize[0] = 300;
+  tooLongSize[1] = 2;
+  tooLong->SetRegions( tooLongSize );
+  TRY_EXPECT_EXCEPTION( tooLong->Allocate() );
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageToRLEImageFilter.h"
+#include "itkLabelImageToLabelMapFilter.h"
+#include "itkLabelMapToRLEImageFilter.h"
+#include "itkRLEImageToImageFilter.h"
+#include "itkRLEImageToLabelMapFilter.h"
+#include "itkTestingMacros.h"
+
+// Write a run length encoded label image to a file and read it back
+// piece by piece, convert it to a LabelMap and back, and compare the
+// results with the dense label image.
+namespace
+{
+
+const unsigned int Dimension = 3;
+
+typedef itk::Image< unsigned short, Dimension >                        ImageType;
+typedef itk::RLEImage< unsigned short, Dimension >                     RLEImageType;
+typedef itk::LabelMap< itk::LabelObject< unsigned short, Dimension > > LabelMapType;
+
+bool
+SameImages(const ImageType *expected, const ImageType *actual)
+{
+  if ( expected->GetLargestPossibleRegion() != actual->GetLargestPossibleRegion() )
+    {
+    std::cerr << "Expected the region " << expected->GetLargestPossibleRegion()
+              << ", got " << actual->GetLargestPossibleRegion() << std::endl;
+    return false;
+    }
+  itk::ImageRegionConstIterator< ImageType > eit( expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< ImageType > ait( actual, expected->GetLargestPossibleRegion() );
+  for ( ; !eit.IsAtEnd(); ++eit, ++ait )
+    {
+    if ( eit.Get() != ait.Get() )
+      {
+      std::cerr << "Expected " << eit.Get() << " at " << eit.GetIndex()
+                << ", got " << ait.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+ImageType::Pointer
+Decode(const RLEImageType *rleImage)
+{
+  typedef itk::RLEImageToImageFilter< RLEImageType, ImageType > DecoderType;
+  DecoderType::Pointer decoder = DecoderType::New();
+  decoder->SetInput( rleImage );
+  decoder->Update();
+  ImageType::Pointer image = decoder->GetOutput();
+  image->DisconnectPipeline();
+  return image;
+}
+
+}
+
+int itkRLEImageToLabelMapFilterTest(int argc, char * argv[])
+{
+  if ( argc != 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputImage" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ImageType::SizeType size;
+  size[0] = 64;
+  size[1] = 45;
+  size[2] = 23;
+
+  // a few overlapping boxes on a background
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 0.75;
+  spacing[2] = 2.0;
+  image->SetSpacing( spacing );
+  image->Allocate();
+  image->FillBuffer( 0 );
+  unsigned int value = 17;
+  for ( unsigned short label = 1; label < 40; ++label )
+    {
+    ImageType::IndexType index;
+    ImageType::SizeType  boxSize;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      value = value * 1664525u + 1013904223u;
+      index[d] = ( value >> 8 ) % size[d];
+      value = value * 1664525u + 1013904223u;
+      boxSize[d] = 1 + ( value >> 8 ) % ( size[d] / 3 );
+      }
+    ImageType::RegionType box( index, boxSize );
+    box.Crop( image->GetLargestPossibleRegion() );
+    itk::ImageRegionIteratorWithIndex< ImageType > it( image, box );
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      it.Set( 1000 + 7 * label );
+      }
+    }
+
+  bool success = true;
+
+  // write the image from its run length encoding, piece by piece
+  typedef itk::ImageToRLEImageFilter< ImageType, RLEImageType > EncoderType;
+  EncoderType::Pointer encoder = EncoderType::New();
+  encoder->SetInput( image );
+  encoder->Update();
+  std::cout << encoder->GetOutput()->GetNumberOfRuns() << " runs for "
+            << image->GetLargestPossibleRegion().GetNumberOfPixels() << " pixels" << std::endl;
+
+  typedef itk::RLEImageToImageFilter< RLEImageType, ImageType > DecoderType;
+  DecoderType::Pointer decoder = DecoderType::New();
+  decoder->SetInput( encoder->GetOutput() );
+
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( decoder->GetOutput() );
+  writer->SetFileName( argv[1] );
+  writer->SetNumberOfStreamDivisions( 5 );
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  // and read it back, piece by piece
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+
+  EncoderType::Pointer streamingEncoder = EncoderType::New();
+  streamingEncoder->SetInput( reader->GetOutput() );
+  streamingEncoder->SetNumberOfStreamDivisions( 7 );
+  TRY_EXPECT_NO_EXCEPTION( streamingEncoder->Update() );
+
+  RLEImageType::Pointer rleImage = streamingEncoder->GetOutput();
+  rleImage->DisconnectPipeline();
+  TEST_EXPECT_EQUAL( rleImage->GetNumberOfRuns(), encoder->GetOutput()->GetNumberOfRuns() );
+  TEST_EXPECT_EQUAL( rleImage->GetSpacing(), spacing );
+  // the reader only produced the last piece
+  TEST_EXPECT_TRUE( reader->GetOutput()->GetBufferedRegion().GetNumberOfPixels()
+                    < image->GetLargestPossibleRegion().GetNumberOfPixels() );
+  success &= SameImages( image, Decode( rleImage ) );
+
+  // convert the RLEImage to a LabelMap, without the dense image
+  typedef itk::RLEImageToLabelMapFilter< RLEImageType, LabelMapType > RLEToLabelMapType;
+  RLEToLabelMapType::Pointer rleToLabelMap = RLEToLabelMapType::New();
+  rleToLabelMap->SetInput( rleImage );
+  rleToLabelMap->SetBackgroundValue( 0 );
+  rleToLabelMap->SetNumberOfThreads( 3 );
+  TEST_SET_GET_VALUE( 0, rleToLabelMap->GetBackgroundValue() );
+  TRY_EXPECT_NO_EXCEPTION( rleToLabelMap->Update() );
+
+  // the same objects as the ones of the dense image
+  typedef itk::LabelImageToLabelMapFilter< ImageType, LabelMapType > LabelImageToLabelMapType;
+  LabelImageToLabelMapType::Pointer labelImageToLabelMap = LabelImageToLabelMapType::New();
+  labelImageToLabelMap->SetInput( image );
+  labelImageToLabelMap->SetBackgroundValue( 0 );
+  labelImageToLabelMap->Update();
+
+  const LabelMapType *labelMap = rleToLabelMap->GetOutput();
+  const LabelMapType *expectedLabelMap = labelImageToLabelMap->GetOutput();
+  TEST_EXPECT_EQUAL( labelMap->GetNumberOfLabelObjects(), expectedLabelMap->GetNumberOfLabelObjects() );
+  for ( LabelMapType::ConstIterator it( expectedLabelMap ); !it.IsAtEnd(); ++it )
+    {
+    const LabelMapType::LabelObjectType *expected = it.GetLabelObject();
+    if ( !labelMap->HasLabel( expected->GetLabel() )
+         || labelMap->GetLabelObject( expected->GetLabel() )->Size() != expected->Size() )
+      {
+      std::cerr << "Wrong object for label " << expected->GetLabel() << std::endl;
+      success = false;
+      }
+    }
+
+  // and back to an RLEImage
+  typedef itk::LabelMapToRLEImageFilter< LabelMapType, RLEImageType > LabelMapToRLEType;
+  LabelMapToRLEType::Pointer labelMapToRLE = LabelMapToRLEType::New();
+  labelMapToRLE->SetInput( labelMap );
+  labelMapToRLE->SetNumberOfThreads( 2 );
+  TRY_EXPECT_NO_EXCEPTION( labelMapToRLE->Update() );
+  TEST_EXPECT_EQUAL( labelMapToRLE->GetOutput()->GetNumberOfRuns(), rleImage->GetNumberOfRuns() );
+  success &= SameImages( image, Decode( labelMapToRLE->GetOutput() ) );
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
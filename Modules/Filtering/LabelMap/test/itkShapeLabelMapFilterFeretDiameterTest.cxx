@@ -0,0 +1,164 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBinaryImageToLabelMapFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkShapeLabelMapFilter.h"
+#include "itkShapeLabelObject.h"
+#include "itkTestingMacros.h"
+
+// Compare the Feret diameters computed by ShapeLabelMapFilter with the
+// largest distance between all the pairs of pixels of the objects, on
+// random objects with an anisotropic spacing, and check that the
+// attributes do not depend on the number of threads.
+namespace
+{
+
+template< unsigned int VDimension >
+bool
+TestFeretDiameter(const typename itk::Image< unsigned char, VDimension >::SizeType & size,
+                  unsigned int density)
+{
+  typedef itk::Image< unsigned char, VDimension >                         InputImageType;
+  typedef itk::ShapeLabelObject< unsigned short, VDimension >             LabelObjectType;
+  typedef itk::LabelMap< LabelObjectType >                                LabelMapType;
+  typedef itk::BinaryImageToLabelMapFilter< InputImageType, LabelMapType > BinaryToLabelMapType;
+  typedef itk::ShapeLabelMapFilter< LabelMapType >                        ShapeFilterType;
+  typedef typename InputImageType::IndexType                              IndexType;
+
+  typename InputImageType::Pointer input = InputImageType::New();
+  input->SetRegions( size );
+  typename InputImageType::SpacingType spacing;
+  for ( unsigned int i = 0; i < VDimension; ++i )
+    {
+    spacing[i] = 0.6 + 0.45 * i;
+    }
+  input->SetSpacing( spacing );
+  input->Allocate();
+
+  unsigned int value = 7;
+  itk::ImageRegionIteratorWithIndex< InputImageType > it( input, input->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    value = value * 1664525u + 1013904223u;
+    it.Set( ( ( value >> 8 ) % 100 ) < density ? 1 : 0 );
+    }
+
+  bool                  success = true;
+  std::vector< double > perimeters;
+  const unsigned int    numberOfThreads[] = { 1, 3 };
+  for ( unsigned int t = 0; t < 2; ++t )
+    {
+    typename BinaryToLabelMapType::Pointer binaryToLabelMap = BinaryToLabelMapType::New();
+    binaryToLabelMap->SetInput( input );
+    binaryToLabelMap->SetInputForegroundValue( 1 );
+
+    typename ShapeFilterType::Pointer shape = ShapeFilterType::New();
+    shape->SetInput( binaryToLabelMap->GetOutput() );
+    shape->SetComputeFeretDiameter( true );
+    shape->SetNumberOfThreads( numberOfThreads[t] );
+    shape->Update();
+
+    const LabelMapType * labelMap = shape->GetOutput();
+    std::cout << VDimension << "D, density " << density << ", " << numberOfThreads[t] << " thread(s): "
+              << labelMap->GetNumberOfLabelObjects() << " objects" << std::endl;
+    if ( labelMap->GetNumberOfLabelObjects() == 0 )
+      {
+      std::cerr << "No object found" << std::endl;
+      success = false;
+      continue;
+      }
+
+    itk::SizeValueType objectId = 0;
+    for ( typename LabelMapType::ConstIterator oit( labelMap ); !oit.IsAtEnd(); ++oit, ++objectId )
+      {
+      const LabelObjectType *  labelObject = oit.GetLabelObject();
+      std::vector< IndexType > pixels;
+      for ( typename LabelObjectType::ConstIndexIterator iit( labelObject ); !iit.IsAtEnd(); ++iit )
+        {
+        pixels.push_back( iit.GetIndex() );
+        }
+
+      double expected = 0;
+      for ( size_t a = 0; a < pixels.size(); ++a )
+        {
+        for ( size_t b = a + 1; b < pixels.size(); ++b )
+          {
+          double length = 0;
+          for ( unsigned int i = 0; i < VDimension; ++i )
+            {
+            const double diff = ( pixels[a][i] - pixels[b][i] ) * spacing[i];
+            length += diff * diff;
+            }
+          expected = std::max( expected, length );
+          }
+        }
+      expected = std::sqrt( expected );
+
+      if ( std::abs( labelObject->GetFeretDiameter() - expected ) > 1e-9 * ( 1.0 + expected ) )
+        {
+        std::cerr << "Wrong Feret diameter for label " << labelObject->GetLabel() << " with "
+                  << pixels.size() << " pixels: " << labelObject->GetFeretDiameter()
+                  << " instead of " << expected << std::endl;
+        success = false;
+        break;
+        }
+
+      if ( t == 0 )
+        {
+        perimeters.push_back( labelObject->GetPerimeter() );
+        }
+      else if ( objectId >= perimeters.size() || labelObject->GetPerimeter() != perimeters[objectId] )
+        {
+        std::cerr << "The objects or the perimeter of label " << labelObject->GetLabel()
+                  << " depends on the number of threads" << std::endl;
+        success = false;
+        break;
+        }
+      }
+    }
+  return success;
+}
+
+}
+
+int itkShapeLabelMapFilterFeretDiameterTest(int, char* [])
+{
+  bool success = true;
+
+  itk::Size< 2 > size2D;
+  size2D[0] = 61;
+  size2D[1] = 47;
+  success &= TestFeretDiameter< 2 >( size2D, 45 );
+  success &= TestFeretDiameter< 2 >( size2D, 65 );
+
+  itk::Size< 3 > size3D;
+  size3D[0] = 19;
+  size3D[1] = 17;
+  size3D[2] = 13;
+  success &= TestFeretDiameter< 3 >( size3D, 25 );
+  success &= TestFeretDiameter< 3 >( size3D, 50 );
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkChordErodeDilateImageFilter_h
+#define itkChordErodeDilateImageFilter_h
+
+#include "itkKernelImageFilter.h"
+#include "itkImageRegionSplitterDirection.h"
+#include "itkChordUtilities.h"
+
+namespace itk
+{
+/**
+ * \class ChordErodeDilateImageFilter
+ * \brief class to implement erosions and dilations by arbitrary flat
+ * structuring elements decomposed in chords. This is the base class that
+ * must be instantiated with the appropriate function.
+ *
+ * The structuring element is decomposed in chords, the runs of its pixels
+ * along the last dimension. For each length of chord, the maximum (or
+ * minimum) over the windows of that length along the last dimension is
+ * computed with the algorithm of van Herk and Gil-Werman, on whole planes
+ * of the image at once, so that the inner loops are vectorized by the
+ * compiler. The output is the maximum of these window images, translated
+ * by the starts of the chords of that length.
+ *
+ * The result is exact, and the cost per pixel depends on the number of
+ * chords and of lengths of chords, but neither on the number of pixels of
+ * the structuring element nor on the pixel type. Balls, annuli and the
+ * other non decomposable structuring elements are thus processed much
+ * faster than by the moving histogram, in particular for the images of
+ * real pixels.
+ *
+ * The image is split among the threads along all the dimensions but the
+ * last one. The pixels outside the image have the boundary value.
+ *
+ * \sa StructuringElementChord, VanHerkGilWermanErodeDilateImageFilter
+ * \ingroup ITKMathematicalMorphology
+ */
+template< typename TImage, typename TKernel, typename TFunction1 >
+class ITK_TEMPLATE_EXPORT ChordErodeDilateImageFilter:
+  public KernelImageFilter< TImage, TImage, TKernel >
+{
+public:
+  /** Standard class typedefs. */
+  typedef ChordErodeDilateImageFilter                  Self;
+  typedef KernelImageFilter< TImage, TImage, TKernel > Superclass;
+  typedef SmartPointer< Self >                         Pointer;
+  typedef SmartPointer< const Self >                   ConstPointer;
+
+  /** Some convenient typedefs. */
+  /** Kernel typedef. */
+  typedef TKernel KernelType;
+
+  typedef TImage                                InputImageType;
+  typedef typename InputImageType::Pointer      InputImagePointer;
+  typedef typename InputImageType::ConstPointer InputImageConstPointer;
+  typedef typename InputImageType::RegionType   InputImageRegionType;
+  typedef typename InputImageType::PixelType    InputImagePixelType;
+  typedef typename TImage::IndexType            IndexType;
+  typedef typename TImage::SizeType             SizeType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  typedef StructuringElementChord< itkGetStaticConstMacro(InputImageDimension) > ChordType;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(ChordErodeDilateImageFilter,
+               KernelImageFilter);
+
+  /** Set/Get the boundary value. */
+  itkSetMacro(Boundary, InputImagePixelType);
+  itkGetConstMacro(Boundary, InputImagePixelType);
+
+protected:
+  ChordErodeDilateImageFilter();
+  ~ChordErodeDilateImageFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  /** Decompose the kernel in chords. */
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Multi-thread version GenerateData. */
+  void  ThreadedGenerateData(const InputImageRegionType & outputRegionForThread,
+                             ThreadIdType threadId) ITK_OVERRIDE;
+
+  /** The image is not split along the chords. */
+  const ImageRegionSplitterBase * GetImageRegionSplitter() const ITK_OVERRIDE;
+
+  // should be set by the meta filter
+  InputImagePixelType m_Boundary;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ChordErodeDilateImageFilter);
+
+  std::vector< ChordType > m_Chords;
+
+  ImageRegionSplitterDirection::Pointer m_ImageRegionSplitter;
+}; // end of class
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkChordErodeDilateImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,210 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkChordErodeDilateImageFilter_hxx
+#define itkChordErodeDilateImageFilter_hxx
+
+#include "itkChordErodeDilateImageFilter.h"
+#include "itkImageScanlineIterator.h"
+#include "itkProgressReporter.h"
+
+namespace itk
+{
+template< typename TImage, typename TKernel, typename TFunction1 >
+ChordErodeDilateImageFilter< TImage, TKernel, TFunction1 >
+::ChordErodeDilateImageFilter():
+  m_Boundary( NumericTraits< InputImagePixelType >::ZeroValue() )
+{
+  m_ImageRegionSplitter = ImageRegionSplitterDirection::New();
+  m_ImageRegionSplitter->SetDirection(InputImageDimension - 1);
+}
+
+template< typename TImage, typename TKernel, typename TFunction1 >
+const ImageRegionSplitterBase *
+ChordErodeDilateImageFilter< TImage, TKernel, TFunction1 >
+::GetImageRegionSplitter() const
+{
+  return m_ImageRegionSplitter;
+}
+
+template< typename TImage, typename TKernel, typename TFunction1 >
+void
+ChordErodeDilateImageFilter< TImage, TKernel, TFunction1 >
+::BeforeThreadedGenerateData()
+{
+  m_Chords = DecomposeInChords(this->GetKernel(), false);
+}
+
+template< typename TImage, typename TKernel, typename TFunction1 >
+void
+ChordErodeDilateImageFilter< TImage, TKernel, TFunction1 >
+::ThreadedGenerateData(const InputImageRegionType & outputRegionForThread,
+                       ThreadIdType threadId)
+{
+  const unsigned int lastDimension = InputImageDimension - 1;
+
+  const InputImageType *input = this->GetInput();
+  InputImageType *      output = this->GetOutput();
+
+  ProgressReporter progress(this, threadId, static_cast< SizeValueType >( m_Chords.size() ) + 1);
+
+  typedef ImageScanlineIterator< InputImageType > OutputIteratorType;
+  OutputIteratorType outputIt(output, outputRegionForThread);
+
+  if ( m_Chords.empty() || outputRegionForThread.GetNumberOfPixels() == 0 )
+    {
+    // no pixel of the structuring element: only the boundary remains
+    while ( !outputIt.IsAtEnd() )
+      {
+      while ( !outputIt.IsAtEndOfLine() )
+        {
+        outputIt.Set(m_Boundary);
+        ++outputIt;
+        }
+      outputIt.NextLine();
+      }
+    progress.CompletedPixel();
+    return;
+    }
+
+  // copy the pixels covered by the chords to a buffer, with the boundary
+  // value out of the input
+  const InputImageRegionType paddedRegion = PadRegionByChords(outputRegionForThread, m_Chords);
+
+  OffsetValueType strides[InputImageDimension];
+  strides[0] = 1;
+  for ( unsigned int d = 1; d < InputImageDimension; ++d )
+    {
+    strides[d] = strides[d - 1] * paddedRegion.GetSize(d - 1);
+    }
+  const SizeValueType planeSize = strides[lastDimension];
+  const SizeValueType numberOfPlanes = paddedRegion.GetSize(lastDimension);
+
+  std::vector< InputImagePixelType > values(paddedRegion.GetNumberOfPixels(), m_Boundary);
+  InputImageRegionType inputRegion = paddedRegion;
+  if ( inputRegion.Crop( input->GetBufferedRegion() ) )
+    {
+    ImageScanlineConstIterator< InputImageType > inputIt(input, inputRegion);
+    while ( !inputIt.IsAtEnd() )
+      {
+      const IndexType & index = inputIt.GetIndex();
+      OffsetValueType   offset = 0;
+      for ( unsigned int d = 0; d < InputImageDimension; ++d )
+        {
+        offset += ( index[d] - paddedRegion.GetIndex(d) ) * strides[d];
+        }
+      while ( !inputIt.IsAtEndOfLine() )
+        {
+        values[offset++] = inputIt.Get();
+        ++inputIt;
+        }
+      inputIt.NextLine();
+      }
+    }
+
+  // the offsets in the buffer of the lines of the output region
+  const SizeValueType lineLength = outputRegionForThread.GetSize(0);
+  const SizeValueType numberOfLines = outputRegionForThread.GetNumberOfPixels() / lineLength;
+  std::vector< OffsetValueType > lineOffsets(numberOfLines);
+  for ( SizeValueType line = 0; line < numberOfLines; ++line )
+    {
+    OffsetValueType offset = outputRegionForThread.GetIndex(0) - paddedRegion.GetIndex(0);
+    SizeValueType   remainder = line;
+    for ( unsigned int d = 1; d < InputImageDimension; ++d )
+      {
+      const OffsetValueType position = static_cast< OffsetValueType >( remainder % outputRegionForThread.GetSize(d) );
+      offset += ( outputRegionForThread.GetIndex(d) + position - paddedRegion.GetIndex(d) ) * strides[d];
+      remainder /= outputRegionForThread.GetSize(d);
+      }
+    lineOffsets[line] = offset;
+    }
+
+  // the chords are sorted by length, so the windows of each length are
+  // computed once
+  const TFunction1 function;
+
+  std::vector< InputImagePixelType > accumulated(outputRegionForThread.GetNumberOfPixels());
+  std::vector< InputImagePixelType > prefix;
+  std::vector< InputImagePixelType > windows;
+  for ( unsigned int first = 0, last = 0; first < m_Chords.size(); first = last )
+    {
+    const SizeValueType        length = m_Chords[first].m_Length;
+    const InputImagePixelType *window = &values[0];
+    if ( length > 1 )
+      {
+      prefix.resize( values.size() );
+      windows.resize( values.size() );
+      VanHerkGilWermanPlanes(&values[0], &prefix[0], &windows[0], planeSize, numberOfPlanes, length, function);
+      window = &windows[0];
+      }
+
+    for ( last = first; last < m_Chords.size() && m_Chords[last].m_Length == length; ++last )
+      {
+      OffsetValueType chordOffset = 0;
+      for ( unsigned int d = 0; d < InputImageDimension; ++d )
+        {
+        chordOffset += m_Chords[last].m_Start[d] * strides[d];
+        }
+
+      for ( SizeValueType line = 0; line < numberOfLines; ++line )
+        {
+        const InputImagePixelType *source = window + lineOffsets[line] + chordOffset;
+        InputImagePixelType *      target = &accumulated[line * lineLength];
+        if ( last == 0 )
+          {
+          std::copy(source, source + lineLength, target);
+          }
+        else
+          {
+          for ( SizeValueType i = 0; i < lineLength; ++i )
+            {
+            target[i] = function(target[i], source[i]);
+            }
+          }
+        }
+      progress.CompletedPixel();
+      }
+    }
+
+  // the lines of the output region are in the same order as in the buffer
+  typename std::vector< InputImagePixelType >::const_iterator accumulatedIt = accumulated.begin();
+  while ( !outputIt.IsAtEnd() )
+    {
+    while ( !outputIt.IsAtEndOfLine() )
+      {
+      outputIt.Set(*accumulatedIt);
+      ++accumulatedIt;
+      ++outputIt;
+      }
+    outputIt.NextLine();
+    }
+  progress.CompletedPixel();
+}
+
+template< typename TImage, typename TKernel, typename TFunction1 >
+void
+ChordErodeDilateImageFilter< TImage, TKernel, TFunction1 >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Boundary: "
+     << static_cast< typename NumericTraits< InputImagePixelType >::PrintType >( m_Boundary ) << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,69 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkChordErodeImageFilter_h
+#define itkChordErodeImageFilter_h
+
+#include "itkChordErodeDilateImageFilter.h"
+// for the MinFunctor
+#include "itkVanHerkGilWermanErodeImageFilter.h"
+
+namespace itk
+{
+/**
+ * \class ChordErodeImageFilter
+ * \brief Grayscale erosion by an arbitrary flat structuring element,
+ * decomposed in chords.
+ *
+ * \sa ChordErodeDilateImageFilter, GrayscaleErodeImageFilter
+ * \ingroup ITKMathematicalMorphology
+ */
+template< typename TImage, typename TKernel >
+class ChordErodeImageFilter:
+  public ChordErodeDilateImageFilter< TImage, TKernel, MinFunctor< typename TImage::PixelType > >
+{
+public:
+  typedef ChordErodeImageFilter Self;
+  typedef ChordErodeDilateImageFilter< TImage, TKernel,
+                                       MinFunctor< typename TImage::PixelType > > Superclass;
+
+  /** Runtime information support. */
+  itkTypeMacro(ChordErodeImageFilter,
+               ChordErodeDilateImageFilter);
+
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+  typedef typename TImage::PixelType PixelType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+protected:
+
+  ChordErodeImageFilter()
+  {
+    this->m_Boundary = NumericTraits< PixelType >::max();
+  }
+  virtual ~ChordErodeImageFilter() ITK_OVERRIDE {}
+
+private:
+
+  ITK_DISALLOW_COPY_AND_ASSIGN(ChordErodeImageFilter);
+};
+} // namespace itk
+
+#endif
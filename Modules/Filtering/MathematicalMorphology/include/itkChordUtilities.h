@@ -0,0 +1,97 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkChordUtilities_h
+#define itkChordUtilities_h
+
+#include <vector>
+
+#include "itkOffset.h"
+
+namespace itk
+{
+/**
+ * \class StructuringElementChord
+ * \brief A run of consecutive pixels of a structuring element along its
+ * last dimension.
+ *
+ * A flat structuring element is the union of its chords, so the dilation
+ * by the structuring element is the maximum of the dilations by its
+ * chords. The dilations by all the chords of the same length share the
+ * maximum over the windows of that length along the last dimension, and
+ * only differ by a translation.
+ *
+ * See J. Urbach and M. Wilkinson, "Efficient 2-D grayscale morphological
+ * transformations with arbitrary flat structuring elements", IEEE
+ * Transactions on Image Processing, 17(1), 2008.
+ *
+ * \ingroup ITKMathematicalMorphology
+ */
+template< unsigned int VDimension >
+class StructuringElementChord
+{
+public:
+  typedef Offset< VDimension > OffsetType;
+
+  /** Offset of the first pixel of the chord from the center of the
+   * structuring element. */
+  OffsetType m_Start;
+
+  /** Number of pixels of the chord. */
+  SizeValueType m_Length;
+
+  /** The chords are ordered by length. */
+  bool operator<(const StructuringElementChord & other) const
+  {
+    return m_Length < other.m_Length;
+  }
+};
+
+/** Decompose the elements of the kernel with a positive value in chords
+ * along the last dimension, sorted by length. With reflect, the chords of
+ * the kernel reflected through its center are returned. */
+template< typename TKernel >
+std::vector< StructuringElementChord< TKernel::NeighborhoodDimension > >
+DecomposeInChords(const TKernel & kernel, bool reflect);
+
+/** The smallest region containing the pixels covered by the chords
+ * translated to all the pixels of the region. The chords must not be
+ * empty. */
+template< typename TRegion >
+TRegion
+PadRegionByChords(const TRegion & region,
+                  const std::vector< StructuringElementChord< TRegion::ImageDimension > > & chords);
+
+/** Apply the function over the windows of length consecutive planes of the
+ * values, with the algorithm of van Herk and Gil-Werman, which costs three
+ * evaluations of the function per value, whatever the length. The whole
+ * planes are processed at once, so the loops run over planeSize
+ * contiguous values and can be vectorized by the compiler. On return, the
+ * plane k of the windows holds the result for the planes k to
+ * k + length - 1 of the values, for k up to numberOfPlanes - length. The
+ * prefix is a work buffer of the size of the values. */
+template< typename TValue, typename TFunction >
+void VanHerkGilWermanPlanes(const TValue *values, TValue *prefix, TValue *windows,
+                            SizeValueType planeSize, SizeValueType numberOfPlanes,
+                            SizeValueType length, const TFunction & function);
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkChordUtilities.hxx"
+#endif
+
+#endif
@@ -0,0 +1,167 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkChordUtilities_hxx
+#define itkChordUtilities_hxx
+
+#include <algorithm>
+
+#include "itkChordUtilities.h"
+#include "itkNumericTraits.h"
+
+namespace itk
+{
+template< typename TKernel >
+std::vector< StructuringElementChord< TKernel::NeighborhoodDimension > >
+DecomposeInChords(const TKernel & kernel, bool reflect)
+{
+  typedef StructuringElementChord< TKernel::NeighborhoodDimension > ChordType;
+  typedef typename TKernel::PixelType                               KernelPixelType;
+
+  const unsigned int  lastDimension = TKernel::NeighborhoodDimension - 1;
+  const SizeValueType numberOfPlanes = kernel.GetSize(lastDimension);
+  const SizeValueType planeSize = kernel.Size() / numberOfPlanes;
+
+  std::vector< ChordType > chords;
+  for ( SizeValueType column = 0; column < planeSize; ++column )
+    {
+    SizeValueType length = 0;
+    for ( SizeValueType k = 0; k <= numberOfPlanes; ++k )
+      {
+      if ( k < numberOfPlanes
+           && kernel[column + k * planeSize] > NumericTraits< KernelPixelType >::ZeroValue() )
+        {
+        ++length;
+        }
+      else if ( length > 0 )
+        {
+        ChordType chord;
+        chord.m_Length = length;
+        if ( reflect )
+          {
+          // the reflection of the last pixel of the chord is the first one
+          const typename ChordType::OffsetType last = kernel.GetOffset( column + ( k - 1 ) * planeSize );
+          for ( unsigned int d = 0; d < TKernel::NeighborhoodDimension; ++d )
+            {
+            chord.m_Start[d] = -last[d];
+            }
+          }
+        else
+          {
+          chord.m_Start = kernel.GetOffset( column + ( k - length ) * planeSize );
+          }
+        chords.push_back(chord);
+        length = 0;
+        }
+      }
+    }
+
+  std::stable_sort( chords.begin(), chords.end() );
+  return chords;
+}
+
+template< typename TRegion >
+TRegion
+PadRegionByChords(const TRegion & region,
+                  const std::vector< StructuringElementChord< TRegion::ImageDimension > > & chords)
+{
+  const unsigned int lastDimension = TRegion::ImageDimension - 1;
+
+  typename TRegion::OffsetType lower = chords[0].m_Start;
+  typename TRegion::OffsetType upper = chords[0].m_Start;
+  for ( unsigned int i = 0; i < chords.size(); ++i )
+    {
+    for ( unsigned int d = 0; d < TRegion::ImageDimension; ++d )
+      {
+      OffsetValueType end = chords[i].m_Start[d];
+      if ( d == lastDimension )
+        {
+        end += chords[i].m_Length - 1;
+        }
+      lower[d] = std::min( lower[d], chords[i].m_Start[d] );
+      upper[d] = std::max( upper[d], end );
+      }
+    }
+
+  TRegion padded = region;
+  for ( unsigned int d = 0; d < TRegion::ImageDimension; ++d )
+    {
+    padded.SetIndex( d, region.GetIndex(d) + lower[d] );
+    padded.SetSize( d, region.GetSize(d) + upper[d] - lower[d] );
+    }
+  return padded;
+}
+
+template< typename TValue, typename TFunction >
+void VanHerkGilWermanPlanes(const TValue *values, TValue *prefix, TValue *windows,
+                            SizeValueType planeSize, SizeValueType numberOfPlanes,
+                            SizeValueType length, const TFunction & function)
+{
+  // the planes are cut in blocks of length planes. The prefix holds the
+  // result from the start of the block of each plane, and the windows
+  // the result to the end of the block.
+  for ( SizeValueType k = 0; k < numberOfPlanes; ++k )
+    {
+    const TValue *value = values + k * planeSize;
+    TValue *      current = prefix + k * planeSize;
+    if ( k % length == 0 )
+      {
+      std::copy( value, value + planeSize, current );
+      }
+    else
+      {
+      const TValue *previous = current - planeSize;
+      for ( SizeValueType i = 0; i < planeSize; ++i )
+        {
+        current[i] = function( previous[i], value[i] );
+        }
+      }
+    }
+
+  for ( SizeValueType k = numberOfPlanes; k-- > 0; )
+    {
+    const TValue *value = values + k * planeSize;
+    TValue *      current = windows + k * planeSize;
+    if ( ( k + 1 ) % length == 0 || k + 1 == numberOfPlanes )
+      {
+      std::copy( value, value + planeSize, current );
+      }
+    else
+      {
+      const TValue *next = current + planeSize;
+      for ( SizeValueType i = 0; i < planeSize; ++i )
+        {
+        current[i] = function( next[i], value[i] );
+        }
+      }
+    }
+
+  // a window spans the end of the block of its first plane and the start
+  // of the block of its last plane
+  for ( SizeValueType k = 0; k + length <= numberOfPlanes; ++k )
+    {
+    TValue *      current = windows + k * planeSize;
+    const TValue *last = prefix + ( k + length - 1 ) * planeSize;
+    for ( SizeValueType i = 0; i < planeSize; ++i )
+      {
+      current[i] = function( current[i], last[i] );
+      }
+    }
+}
+} // namespace itk
+
+#endif
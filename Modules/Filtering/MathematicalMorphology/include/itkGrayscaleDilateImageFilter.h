@@ -23,6 +23,7 @@
 #include "itkBasicDilateImageFilter.h"
 #include "itkAnchorDilateImageFilter.h"
 #include "itkVanHerkGilWermanDilateImageFilter.h"
+#include "itkChordDilateImageFilter.h"
 #include "itkCastImageFilter.h"
 #include "itkConstantBoundaryCondition.h"
 #include "itkNeighborhood.h"
@@ -40,6 +41,13 @@ namespace itk
  * values (zero or one). Only elements of the structuring element
  * having values > 0 are candidates for affecting the center pixel.
  *
+ * The algorithm is selected when the kernel is set: the decomposable
+ * FlatStructuringElement, like the boxes and the polygons, are processed
+ * by the anchor algorithm, the other ones, like the balls, by their
+ * decomposition in chords (see ChordDilateImageFilter), and the other kernels
+ * by the basic or the moving histogram algorithm. SetAlgorithm() selects
+ * another one.
+ *
  * \sa MorphologyImageFilter, GrayscaleFunctionDilateImageFilter, BinaryDilateImageFilter
  * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
  * \ingroup ITKMathematicalMorphology
@@ -90,6 +98,7 @@ public:
 
   typedef AnchorDilateImageFilter< TInputImage, FlatKernelType >           AnchorFilterType;
   typedef VanHerkGilWermanDilateImageFilter< TInputImage, FlatKernelType > VHGWFilterType;
+  typedef ChordDilateImageFilter< TInputImage, TKernel >                   ChordFilterType;
   typedef CastImageFilter< TInputImage, TOutputImage >                     CastFilterType;
 
   /** Typedef for boundary conditions. */
@@ -124,7 +133,8 @@ public:
     BASIC = 0,
     HISTO = 1,
     ANCHOR = 2,
-    VHGW = 3
+    VHGW = 3,
+    CHORD = 4
     };
 
   void SetNumberOfThreads(ThreadIdType nb) ITK_OVERRIDE;
@@ -150,6 +160,8 @@ private:
 
   typename VHGWFilterType::Pointer m_VHGWFilter;
 
+  typename ChordFilterType::Pointer m_ChordFilter;
+
   // and the name of the filter
   int m_Algorithm;
 
@@ -23,6 +23,7 @@
 #include "itkBasicErodeImageFilter.h"
 #include "itkAnchorErodeImageFilter.h"
 #include "itkVanHerkGilWermanErodeImageFilter.h"
+#include "itkChordErodeImageFilter.h"
 #include "itkCastImageFilter.h"
 #include "itkConstantBoundaryCondition.h"
 #include "itkNeighborhood.h"
@@ -40,6 +41,13 @@ namespace itk
  * values (zero or one). Only elements of the structuring element
  * having values > 0 are candidates for affecting the center pixel.
  *
+ * The algorithm is selected when the kernel is set: the decomposable
+ * FlatStructuringElement, like the boxes and the polygons, are processed
+ * by the anchor algorithm, the other ones, like the balls, by their
+ * decomposition in chords (see ChordErodeImageFilter), and the other kernels
+ * by the basic or the moving histogram algorithm. SetAlgorithm() selects
+ * another one.
+ *
  * \sa MorphologyImageFilter, GrayscaleFunctionErodeImageFilter, BinaryErodeImageFilter
  * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
  * \ingroup ITKMathematicalMorphology
@@ -86,7 +94,8 @@ public:
     BASIC = 0,
     HISTO = 1,
     ANCHOR = 2,
-    VHGW = 3
+    VHGW = 3,
+    CHORD = 4
     };
 
   typedef MovingHistogramErodeImageFilter< TInputImage, TOutputImage, TKernel >
@@ -98,6 +107,7 @@ public:
 
   typedef AnchorErodeImageFilter< TInputImage, FlatKernelType >           AnchorFilterType;
   typedef VanHerkGilWermanErodeImageFilter< TInputImage, FlatKernelType > VHGWFilterType;
+  typedef ChordErodeImageFilter< TInputImage, TKernel >                   ChordFilterType;
   typedef CastImageFilter< TInputImage, TOutputImage >                    CastFilterType;
 
   /** Typedef for boundary conditions. */
@@ -150,6 +160,8 @@ private:
 
   typename VHGWFilterType::Pointer m_VHGWFilter;
 
+  typename ChordFilterType::Pointer m_ChordFilter;
+
   // and the name of the filter
   int m_Algorithm;
 
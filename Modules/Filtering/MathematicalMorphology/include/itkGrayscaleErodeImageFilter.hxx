@@ -33,6 +33,7 @@ GrayscaleErodeImageFilter< TInputImage, TOutputImage, TKernel >
   m_HistogramFilter = HistogramFilterType::New();
   m_AnchorFilter = AnchorFilterType::New();
   m_VHGWFilter = VHGWFilterType::New();
+  m_ChordFilter = ChordFilterType::New();
   m_Algorithm = HISTO;
 
   this->SetBoundary( NumericTraits< PixelType >::max() );
@@ -47,6 +48,7 @@ GrayscaleErodeImageFilter< TInputImage, TOutputImage, TKernel >
   m_HistogramFilter->SetNumberOfThreads(nb);
   m_AnchorFilter->SetNumberOfThreads(nb);
   m_VHGWFilter->SetNumberOfThreads(nb);
+  m_ChordFilter->SetNumberOfThreads(nb);
   m_BasicFilter->SetNumberOfThreads(nb);
 }
 
@@ -62,6 +64,13 @@ GrayscaleErodeImageFilter< TInputImage, TOutputImage, TKernel >
     m_AnchorFilter->SetKernel(*flatKernel);
     m_Algorithm = ANCHOR;
     }
+  else if ( flatKernel != ITK_NULLPTR )
+    {
+    // the decomposition in chords is faster than the histogram based
+    // filter for all the flat kernels, and does not depend on the pixel type
+    m_ChordFilter->SetKernel(kernel);
+    m_Algorithm = CHORD;
+    }
   else if ( m_HistogramFilter->GetUseVectorBasedAlgorithm() )
     {
     // histogram based filter is as least as good as the basic one, so always
@@ -103,6 +112,7 @@ GrayscaleErodeImageFilter< TInputImage, TOutputImage, TKernel >
   m_HistogramFilter->SetBoundary(value);
   m_AnchorFilter->SetBoundary(value);
   m_VHGWFilter->SetBoundary(value);
+  m_ChordFilter->SetBoundary(value);
   m_BoundaryCondition.SetConstant(value);
   m_BasicFilter->OverrideBoundaryCondition(&m_BoundaryCondition);
 }
@@ -132,6 +142,10 @@ GrayscaleErodeImageFilter< TInputImage, TOutputImage, TKernel >
       {
       m_VHGWFilter->SetKernel(*flatKernel);
       }
+    else if ( algo == CHORD )
+      {
+      m_ChordFilter->SetKernel( this->GetKernel() );
+      }
     else
       {
       itkExceptionMacro(<< "Invalid algorithm");
@@ -200,6 +214,20 @@ GrayscaleErodeImageFilter< TInputImage, TOutputImage, TKernel >
     cast->SetInput( m_VHGWFilter->GetOutput() );
     progress->RegisterInternalFilter(cast, 0.1f);
 
+    cast->GraftOutput( this->GetOutput() );
+    cast->Update();
+    this->GraftOutput( cast->GetOutput() );
+    }
+  else if ( m_Algorithm == CHORD )
+    {
+    itkDebugMacro("Running ChordErodeImageFilter");
+    m_ChordFilter->SetInput( this->GetInput() );
+    progress->RegisterInternalFilter(m_ChordFilter, 0.9f);
+
+    typename CastFilterType::Pointer cast = CastFilterType::New();
+    cast->SetInput( m_ChordFilter->GetOutput() );
+    progress->RegisterInternalFilter(cast, 0.1f);
+
     cast->GraftOutput( this->GetOutput() );
     cast->Update();
     this->GraftOutput( cast->GetOutput() );
@@ -216,6 +244,7 @@ GrayscaleErodeImageFilter< TInputImage, TOutputImage, TKernel >
   m_HistogramFilter->Modified();
   m_AnchorFilter->Modified();
   m_VHGWFilter->Modified();
+  m_ChordFilter->Modified();
 }
 
 template< typename TInputImage, typename TOutputImage, typename TKernel >
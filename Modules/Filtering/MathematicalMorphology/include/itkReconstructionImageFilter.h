@@ -23,6 +23,8 @@
 #include "itkImageRegionIterator.h"
 #include "itkProgressReporter.h"
 #include <queue>
+#include <utility>
+#include <vector>
 
 //#define BASIC
 #define COPY
@@ -43,6 +45,13 @@ namespace itk
  * applications and efficient algorithms" -- IEEE Transactions on
  * Image processing, Vol 2, No 2, pp 176-201, April 1993
  *
+ * The image is split in slabs along its last dimension, one per thread.
+ * Each thread runs the raster, antiraster and FIFO steps in its slab,
+ * then the threads exchange the values of the borders of the slabs and
+ * propagate them with their FIFO, until no value changes. The
+ * reconstruction is unique, so the output does not depend on the number
+ * of threads.
+ *
  * \author Richard Beare. Department of Medicine, Monash University,
  * Melbourne, Australia.
  *
@@ -131,6 +140,9 @@ public:
    * Perform a padding of the image internally to increase the performance
    * of the filter. UseInternalCopy can be set to false to reduce the memory
    * usage.
+   * The filter now works in the output image and checks the borders of
+   * the image itself, so this option has no effect anymore and is kept
+   * for backward compatibility.
    */
   itkSetMacro(UseInternalCopy, bool);
   itkGetConstReferenceMacro(UseInternalCopy, bool);
@@ -162,18 +174,59 @@ private:
   bool m_FullyConnected;
   bool m_UseInternalCopy;
 
-  typedef typename itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator< OutputImageType > FaceCalculatorType;
-
-  typedef typename FaceCalculatorType::FaceListType           FaceListType;
-  typedef typename FaceCalculatorType::FaceListType::iterator FaceListTypeIt;
-
-  typedef ImageRegionConstIterator< InputImageType > InputIteratorType;
-  typedef ImageRegionIterator< OutputImageType >     OutputIteratorType;
-
-  typedef typename OutputImageType::IndexType               OutIndexType;
-  typedef typename InputImageType::IndexType                InIndexType;
-  typedef ConstShapedNeighborhoodIterator< InputImageType > CNInputIterator;
-  typedef ShapedNeighborhoodIterator< OutputImageType >     NOutputIterator;
+  typedef typename OutputImageType::OffsetType OffsetType;
+
+  /** The pixels of a slab which may be raised by the neighboring slabs,
+   * with their new values. */
+  typedef std::vector< std::pair< OffsetValueType, InputImagePixelType > > UpdateVectorType;
+
+  /** The steps of the reconstruction run by the threads. */
+  enum ReconstructionPhaseType {
+    SlabReconstructionPhase,
+    ExchangeBordersPhase,
+    PropagateUpdatesPhase
+    };
+
+  /** The data shared by the threads. Each thread only modifies the pixels
+   * of its slab, and only reads the pixels of the other slabs when no
+   * thread modifies them. */
+  struct ReconstructionThreadStruct
+    {
+    ReconstructionPhaseType          Phase;
+    const MarkerImagePixelType *     Marker;
+    const MaskImagePixelType *       Mask;
+    OutputImagePixelType *           Output;
+    ISizeType                        Size;
+    OffsetValueType                  Strides[OutputImageDimension];
+    std::vector< OffsetValueType >   NeighborOffsets;
+    std::vector< OffsetType >        NeighborIndexOffsets;
+    std::vector< OffsetValueType >   SlabBegin;
+    std::vector< UpdateVectorType >  Updates;
+    std::vector< unsigned char >     InvalidMarker;
+    };
+
+  static ITK_THREAD_RETURN_TYPE ReconstructionThreaderCallback( void *arg );
+
+  /** Run a phase of the reconstruction with all the threads. */
+  void RunReconstructionPhase( ReconstructionThreadStruct & str, ReconstructionPhaseType phase );
+
+  /** The phases run by each thread, in its slab. */
+  static void ThreadedSlabReconstruction( ReconstructionThreadStruct & str, ThreadIdType threadId );
+  static void ThreadedExchangeBorders( ReconstructionThreadStruct & str, ThreadIdType threadId );
+  static void ThreadedPropagateUpdates( ReconstructionThreadStruct & str, ThreadIdType threadId );
+
+  /** Propagate the values of the pixels of the FIFO in the slab. */
+  static void PropagateInSlab( ReconstructionThreadStruct & str, ThreadIdType threadId,
+                               std::queue< OffsetValueType > & fifo );
+
+  /** Compute the index of a pixel from its offset, and return whether all
+   * its neighbors are in the image. */
+  static bool ComputeIndex( const ReconstructionThreadStruct & str, OffsetValueType offset,
+                            OffsetType & index );
+
+  /** Return whether the k-th neighbor of a pixel is in the image. */
+  static bool IsNeighborInside( const ReconstructionThreadStruct & str, const OffsetType & index,
+                                unsigned int k );
 }; // end of class
 } // end namespace itk
 
@@ -18,13 +18,10 @@
 #ifndef itkReconstructionImageFilter_hxx
 #define itkReconstructionImageFilter_hxx
 
+#include <algorithm>
 #include "itkMath.h"
 #include "itkReconstructionImageFilter.h"
-#include "itkConstantBoundaryCondition.h"
-#include "itkConnectedComponentAlgorithm.h"
-
-#include "itkConstantPadImageFilter.h"
-#include "itkCropImageFilter.h"
+#include "itkMultiThreader.h"
 
 namespace itk
 {
@@ -99,7 +96,6 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >::GetMaskImage()
   return this->GetInput(1);
 }
 
-// a version that takes a padded copy of mask and marker
 template< typename TInputImage, typename TOutputImage, typename TCompare >
 void
 ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
@@ -107,13 +103,6 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
 {
   // Allocate the output
   this->AllocateOutputs();
-  // there are 2 passes that use all pixels and a 3rd that uses some
-  // subset of the pixels. We'll just pretend that the third pass
-  // takes the same as each of the others. Is it OK to update more
-  // often than pixels?
-  ProgressReporter progress(this, 0, this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() * 3);
-
-  TCompare compare;
 
   MarkerImageConstPointer markerImage = this->GetMarkerImage();
   MaskImageConstPointer   maskImage = this->GetMaskImage();
@@ -125,119 +114,78 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
     itkExceptionMacro(<< "Marker and mask must have the same size.");
     }
 
-  // create padded versions of the marker image and the mask image
-  typedef typename itk::ConstantPadImageFilter< InputImageType, InputImageType > PadType;
-
-  MarkerImageConstPointer markerImageP;
-  MaskImageConstPointer   maskImageP;
+  // the images are completely buffered, so the pixels are addressed by
+  // their offset in the buffers
+  const OutputImageRegionType region = output->GetRequestedRegion();
+  if ( region.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
 
-  ISizeType padSize;
+  ReconstructionThreadStruct str;
+  str.Marker = markerImage->GetBufferPointer();
+  str.Mask = maskImage->GetBufferPointer();
+  str.Output = output->GetBufferPointer();
+  str.Size = region.GetSize();
+  str.Strides[0] = 1;
+  for ( unsigned int d = 1; d < OutputImageDimension; ++d )
+    {
+    str.Strides[d] = str.Strides[d - 1] * static_cast< OffsetValueType >( str.Size[d - 1] );
+    }
 
-  if ( m_UseInternalCopy )
+  // the neighbors in raster order: the first half are the previous
+  // neighbors, the second half the later neighbors
+  unsigned int neighborhoodSize = 1;
+  for ( unsigned int d = 0; d < OutputImageDimension; ++d )
     {
-    typename PadType::Pointer MaskPad = PadType::New();
-    typename PadType::Pointer MarkerPad = PadType::New();
-    padSize.Fill(1);
-
-    MaskPad->SetConstant(m_MarkerValue);
-    MarkerPad->SetConstant(m_MarkerValue);
-    MaskPad->SetPadLowerBound(padSize);
-    MaskPad->SetPadUpperBound(padSize);
-    MarkerPad->SetPadLowerBound(padSize);
-    MarkerPad->SetPadUpperBound(padSize);
-
-    MaskPad->SetInput(maskImage);
-    MarkerPad->SetInput(markerImage);
-    MaskPad->Update();
-    MarkerPad->Update();
-
-    markerImageP = MarkerPad->GetOutput();
-    maskImageP = MaskPad->GetOutput();
+    neighborhoodSize *= 3;
     }
-  else
+  for ( unsigned int n = 0; n < neighborhoodSize; ++n )
     {
-    maskImageP = this->GetMaskImage();
-    InputIteratorType inIt( markerImage,
-                            output->GetRequestedRegion() );
-    OutputIteratorType outIt( output,
-                              output->GetRequestedRegion() );
-    // copy marker to output - isn't there a better way?
-    while ( !outIt.IsAtEnd() )
+    OffsetType      offset;
+    OffsetValueType linearOffset = 0;
+    unsigned int    numberOfNonZero = 0;
+    unsigned int    remainder = n;
+    for ( unsigned int d = 0; d < OutputImageDimension; ++d )
       {
-      MarkerImagePixelType currentValue = inIt.Get();
-      outIt.Set( static_cast< OutputImagePixelType >( currentValue ) );
-      ++inIt;
-      ++outIt;
+      offset[d] = static_cast< OffsetValueType >( remainder % 3 ) - 1;
+      remainder /= 3;
+      linearOffset += offset[d] * str.Strides[d];
+      if ( offset[d] != 0 )
+        {
+        ++numberOfNonZero;
+        }
+      }
+    if ( numberOfNonZero == 1 || ( numberOfNonZero > 1 && m_FullyConnected ) )
+      {
+      str.NeighborOffsets.push_back( linearOffset );
+      str.NeighborIndexOffsets.push_back( offset );
       }
-    markerImageP = output;
     }
 
-  // declare our queue type
-  typedef typename std::queue< OutputImageIndexType > FifoType;
-  FifoType IndexFifo;
-
-  NOutputIterator   outNIt;
-  InputIteratorType mskIt;
-  CNInputIterator   mskNIt;
-  ISizeType         kernelRadius;
-  kernelRadius.Fill(1);
-  if ( m_UseInternalCopy )
-    {
-    FaceCalculatorType faceCalculator;
-
-    FaceListType   faceList;
-    FaceListTypeIt fit;
-
-    faceList = faceCalculator(maskImageP, maskImageP->GetLargestPossibleRegion(),
-                              kernelRadius);
-    // we will only be processing the body region
-    fit = faceList.begin();
-    // must be a better way of doing this
-    NOutputIterator tt(kernelRadius,
-                       markerImageP,
-                       *fit);
-    outNIt = tt;
-
-    InputIteratorType ttt(maskImageP,
-                          *fit);
-    mskIt = ttt;
-    CNInputIterator tttt(kernelRadius,
-                         maskImageP,
-                         *fit);
-    mskNIt = tttt;
-    }
-  else
+  // one slab of planes per thread
+  const SizeValueType numberOfPlanes = str.Size[OutputImageDimension - 1];
+  MultiThreader *     threader = this->GetMultiThreader();
+  threader->SetNumberOfThreads( static_cast< ThreadIdType >(
+    std::min( static_cast< SizeValueType >( this->GetNumberOfThreads() ), numberOfPlanes ) ) );
+  const ThreadIdType numberOfThreads = threader->GetNumberOfThreads();
+  str.SlabBegin.resize( numberOfThreads + 1 );
+  for ( ThreadIdType t = 0; t <= numberOfThreads; ++t )
     {
-    NOutputIterator tt( kernelRadius,
-                        markerImageP,
-                        output->GetRequestedRegion() );
-    outNIt = tt;
-
-    InputIteratorType ttt( maskImageP,
-                           output->GetRequestedRegion() );
-    mskIt = ttt;
-    CNInputIterator tttt( kernelRadius,
-                          maskImageP,
-                          output->GetRequestedRegion() );
-    mskNIt = tttt;
+    str.SlabBegin[t] = static_cast< OffsetValueType >( numberOfPlanes * t / numberOfThreads )
+      * str.Strides[OutputImageDimension - 1];
     }
+  str.Updates.resize( numberOfThreads );
+  str.InvalidMarker.assign( numberOfThreads, 0 );
 
-  setConnectivityPrevious(&outNIt, m_FullyConnected);
-
-  ConstantBoundaryCondition< OutputImageType > oBC;
-  oBC.SetConstant(m_MarkerValue);
-  outNIt.OverrideBoundaryCondition(&oBC);
-
-  mskIt.GoToBegin();
-  // scan in forward raster order
-  for ( outNIt.GoToBegin(), mskIt.GoToBegin(); !outNIt.IsAtEnd(); ++outNIt, ++mskIt )
+  // the raster, antiraster and FIFO steps in each slab
+  this->RunReconstructionPhase( str, SlabReconstructionPhase );
+  for ( ThreadIdType t = 0; t < numberOfThreads; ++t )
     {
-    InputImagePixelType V = outNIt.GetCenterPixel();
-    InputImagePixelType iV = static_cast< OutputImagePixelType >( mskIt.Get() );
-
     // be sure that the pixels in the images follow the preconditions
-    if ( compare(V, iV) )
+    if ( str.InvalidMarker[t] )
       {
+      TCompare compare;
       if ( compare(0, 1) )
         {
         itkExceptionMacro(<< "Marker pixels must be <= mask pixels.");
@@ -247,144 +195,320 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
         itkExceptionMacro(<< "Marker pixels must be >= mask pixels.");
         }
       }
+    }
+  this->UpdateProgress( 0.5f );
+
+  // the values propagated to the borders of the slabs are propagated to
+  // the neighboring slabs, until no value changes
+  for (;; )
+    {
+    this->RunReconstructionPhase( str, ExchangeBordersPhase );
+    bool updated = false;
+    for ( ThreadIdType t = 0; t < numberOfThreads; ++t )
+      {
+      updated = updated || !str.Updates[t].empty();
+      }
+    if ( !updated )
+      {
+      break;
+      }
+    this->RunReconstructionPhase( str, PropagateUpdatesPhase );
+    }
+  this->UpdateProgress( 1.0f );
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::RunReconstructionPhase( ReconstructionThreadStruct & str, ReconstructionPhaseType phase )
+{
+  str.Phase = phase;
+  MultiThreader *threader = this->GetMultiThreader();
+  threader->SetSingleMethod( this->ReconstructionThreaderCallback, &str );
+  threader->SingleMethodExecute();
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+ITK_THREAD_RETURN_TYPE
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ReconstructionThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *threadInfo =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ReconstructionThreadStruct *str =
+    static_cast< ReconstructionThreadStruct * >( threadInfo->UserData );
+  const ThreadIdType threadId = threadInfo->ThreadID;
+
+  switch ( str->Phase )
+    {
+    case SlabReconstructionPhase:
+      Self::ThreadedSlabReconstruction( *str, threadId );
+      break;
+    case ExchangeBordersPhase:
+      Self::ThreadedExchangeBorders( *str, threadId );
+      break;
+    case PropagateUpdatesPhase:
+      Self::ThreadedPropagateUpdates( *str, threadId );
+      break;
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+bool
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ComputeIndex( const ReconstructionThreadStruct & str, OffsetValueType offset, OffsetType & index )
+{
+  bool interior = true;
+  for ( unsigned int d = OutputImageDimension; d > 0; --d )
+    {
+    const unsigned int i = d - 1;
+    index[i] = offset / str.Strides[i];
+    offset -= index[i] * str.Strides[i];
+    interior = interior && index[i] > 0 && index[i] + 1 < static_cast< OffsetValueType >( str.Size[i] );
+    }
+  return interior;
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+bool
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::IsNeighborInside( const ReconstructionThreadStruct & str, const OffsetType & index, unsigned int k )
+{
+  const OffsetType & offset = str.NeighborIndexOffsets[k];
+  for ( unsigned int d = 0; d < OutputImageDimension; ++d )
+    {
+    const OffsetValueType i = index[d] + offset[d];
+    if ( i < 0 || i >= static_cast< OffsetValueType >( str.Size[d] ) )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ThreadedSlabReconstruction( ReconstructionThreadStruct & str, ThreadIdType threadId )
+{
+  TCompare compare;
+
+  const OffsetValueType begin = str.SlabBegin[threadId];
+  const OffsetValueType end = str.SlabBegin[threadId + 1];
+  const unsigned int    numberOfNeighbors = static_cast< unsigned int >( str.NeighborOffsets.size() );
+  const unsigned int    numberOfPreviousNeighbors = numberOfNeighbors / 2;
+
+  // copy marker to output, and be sure that the pixels in the images
+  // follow the preconditions
+  for ( OffsetValueType p = begin; p < end; ++p )
+    {
+    const InputImagePixelType V = str.Marker[p];
+    if ( compare(V, str.Mask[p]) )
+      {
+      str.InvalidMarker[threadId] = 1;
+      return;
+      }
+    str.Output[p] = static_cast< OutputImagePixelType >( V );
+    }
+
+  // scan in forward raster order
+  for ( OffsetValueType p = begin; p < end; ++p )
+    {
+    InputImagePixelType V = str.Output[p];
+    OffsetType          index;
+    const bool          interior = Self::ComputeIndex( str, p, index );
 
     // visit the previous neighbours
-    typename NOutputIterator::ConstIterator sIt;
-    for ( sIt = outNIt.Begin(); !sIt.IsAtEnd(); ++sIt )
+    for ( unsigned int k = 0; k < numberOfPreviousNeighbors; ++k )
       {
-      InputImagePixelType VN = sIt.Get();
+      const OffsetValueType q = p + str.NeighborOffsets[k];
+      if ( ( !interior && !Self::IsNeighborInside( str, index, k ) ) || q < begin )
+        {
+        continue;
+        }
+      const InputImagePixelType VN = str.Output[q];
       if ( compare(VN, V) )
         {
-        outNIt.SetCenterPixel(VN);
         V = VN;
         }
       }
 
     // this step clamps to the mask
+    const InputImagePixelType iV = str.Mask[p];
     if ( compare(V, iV) )
       {
-      outNIt.SetCenterPixel(iV);
+      V = iV;
       }
-
-    progress.CompletedPixel();
+    str.Output[p] = static_cast< OutputImagePixelType >( V );
     }
 
   // now for the reverse raster order pass
-  // reset the neighborhood
-  setConnectivityLater(&outNIt, m_FullyConnected);
-  outNIt.OverrideBoundaryCondition(&oBC);
-  outNIt.GoToEnd();
-  //mskIt.GoToEnd();
-
-  ConstantBoundaryCondition< InputImageType > iBC;
-  iBC.SetConstant(m_MarkerValue);
-
-  setConnectivityLater(&mskNIt, m_FullyConnected);
-  mskNIt.OverrideBoundaryCondition(&iBC);
-
-  typename NOutputIterator::IndexListType oIndexList, mIndexList;
-  typename NOutputIterator::IndexListType::const_iterator oLIt, mLIt;
-
-  oIndexList = outNIt.GetActiveIndexList();
-  mIndexList = mskNIt.GetActiveIndexList();
-
-  mskNIt.GoToEnd();
-  while ( !outNIt.IsAtBegin() )
+  std::queue< OffsetValueType > fifo;
+  for ( OffsetValueType p = end - 1; p >= begin; --p )
     {
-    --outNIt;
-    --mskNIt;
-    InputImagePixelType V = outNIt.GetCenterPixel();
-    typename NOutputIterator::ConstIterator sIt;
-    for ( sIt = outNIt.Begin(); !sIt.IsAtEnd(); ++sIt )
+    InputImagePixelType V = str.Output[p];
+    OffsetType          index;
+    const bool          interior = Self::ComputeIndex( str, p, index );
+
+    for ( unsigned int k = numberOfPreviousNeighbors; k < numberOfNeighbors; ++k )
       {
-      InputImagePixelType VN = sIt.Get();
+      const OffsetValueType q = p + str.NeighborOffsets[k];
+      if ( ( !interior && !Self::IsNeighborInside( str, index, k ) ) || q >= end )
+        {
+        continue;
+        }
+      const InputImagePixelType VN = str.Output[q];
       if ( compare(VN, V) )
         {
-        outNIt.SetCenterPixel(VN);
         V = VN;
         }
       }
-    InputImagePixelType iV = mskNIt.GetCenterPixel();
+    const InputImagePixelType iV = str.Mask[p];
     if ( compare(V, iV) )
       {
-      outNIt.SetCenterPixel(iV);
       V = iV;
       }
+    str.Output[p] = static_cast< OutputImagePixelType >( V );
 
     // now put indexes in the fifo
-    //typename CNInputIterator::ConstIterator mIt;
-    for ( oLIt = oIndexList.begin(), mLIt = mIndexList.begin(); oLIt != oIndexList.end(); ++oLIt, ++mLIt )
+    for ( unsigned int k = numberOfPreviousNeighbors; k < numberOfNeighbors; ++k )
       {
-      InputImagePixelType VN = outNIt.GetPixel(*oLIt);
-      InputImagePixelType iN = mskNIt.GetPixel(*mLIt);
+      const OffsetValueType q = p + str.NeighborOffsets[k];
+      if ( ( !interior && !Self::IsNeighborInside( str, index, k ) ) || q >= end )
+        {
+        continue;
+        }
+      const InputImagePixelType VN = str.Output[q];
+      const InputImagePixelType iN = str.Mask[q];
       if ( compare(V, VN) && compare(iN, VN) )
         {
-        IndexFifo.push( outNIt.GetIndex() );
+        fifo.push( p );
         break;
         }
       }
-    progress.CompletedPixel();
     }
 
-  // Now we want to check the full neighborhood
-  setConnectivity(&outNIt, m_FullyConnected);
-  setConnectivity(&mskNIt, m_FullyConnected);
-  mskNIt.OverrideBoundaryCondition(&iBC);
-  outNIt.OverrideBoundaryCondition(&oBC);
-  oIndexList = outNIt.GetActiveIndexList();
-  mIndexList = mskNIt.GetActiveIndexList();
   // now process the fifo - this fill the parts that weren't dealt
   // with by the raster and anti-raster passes
-  //typename NOutputIterator::Iterator sIt;
-  typename CNInputIterator::ConstIterator mIt;
+  Self::PropagateInSlab( str, threadId, fifo );
+}
 
-  while ( !IndexFifo.empty() )
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ThreadedExchangeBorders( ReconstructionThreadStruct & str, ThreadIdType threadId )
+{
+  TCompare compare;
+
+  const OffsetValueType begin = str.SlabBegin[threadId];
+  const OffsetValueType end = str.SlabBegin[threadId + 1];
+  const OffsetValueType planeSize = str.Strides[OutputImageDimension - 1];
+  const ThreadIdType    numberOfThreads = static_cast< ThreadIdType >( str.SlabBegin.size() - 1 );
+  const unsigned int    numberOfNeighbors = static_cast< unsigned int >( str.NeighborOffsets.size() );
+
+  UpdateVectorType & updates = str.Updates[threadId];
+  updates.clear();
+
+  // the first plane of the slab is next to the previous slab, and the last
+  // plane is next to the next slab
+  OffsetValueType ranges[2][2];
+  ranges[0][0] = begin;
+  ranges[0][1] = ( threadId > 0 ) ? begin + planeSize : begin;
+  ranges[1][0] = std::max( end - planeSize, ranges[0][1] );
+  ranges[1][1] = ( threadId + 1 < numberOfThreads ) ? end : ranges[1][0];
+
+  for ( unsigned int r = 0; r < 2; ++r )
     {
-    InputImageIndexType I = IndexFifo.front();
-    IndexFifo.pop();
-    // reposition the iterators
-    outNIt += I - outNIt.GetIndex();
-    mskNIt += I - mskNIt.GetIndex();
-    InputImagePixelType V = outNIt.GetCenterPixel();
-    for ( oLIt = oIndexList.begin(), mLIt = mIndexList.begin();
-          oLIt != oIndexList.end();
-          ++oLIt, ++mLIt )
+    for ( OffsetValueType p = ranges[r][0]; p < ranges[r][1]; ++p )
       {
-      InputImagePixelType VN = outNIt.GetPixel(*oLIt);
-      InputImagePixelType iN = mskNIt.GetPixel(*mLIt);
+      const InputImagePixelType V = str.Output[p];
+      const InputImagePixelType iV = str.Mask[p];
+      InputImagePixelType       newV = V;
+      OffsetType                index;
+      const bool                interior = Self::ComputeIndex( str, p, index );
+      for ( unsigned int k = 0; k < numberOfNeighbors; ++k )
+        {
+        const OffsetValueType q = p + str.NeighborOffsets[k];
+        if ( ( !interior && !Self::IsNeighborInside( str, index, k ) ) || ( q >= begin && q < end ) )
+          {
+          continue;
+          }
+        // the neighbor of the other slab dilates this pixel as in the FIFO
+        const InputImagePixelType VN = str.Output[q];
+        if ( compare(VN, newV) && Math::NotAlmostEquals( iV, newV ) )
+          {
+          newV = compare(iV, VN) ? VN : iV;
+          }
+        }
+      if ( compare(newV, V) )
+        {
+        updates.push_back( std::make_pair( p, newV ) );
+        }
+      }
+    }
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ThreadedPropagateUpdates( ReconstructionThreadStruct & str, ThreadIdType threadId )
+{
+  std::queue< OffsetValueType > fifo;
+  const UpdateVectorType &      updates = str.Updates[threadId];
+  for ( typename UpdateVectorType::const_iterator it = updates.begin(); it != updates.end(); ++it )
+    {
+    str.Output[it->first] = static_cast< OutputImagePixelType >( it->second );
+    fifo.push( it->first );
+    }
+  Self::PropagateInSlab( str, threadId, fifo );
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::PropagateInSlab( ReconstructionThreadStruct & str, ThreadIdType threadId,
+                   std::queue< OffsetValueType > & fifo )
+{
+  TCompare compare;
+
+  const OffsetValueType begin = str.SlabBegin[threadId];
+  const OffsetValueType end = str.SlabBegin[threadId + 1];
+  const unsigned int    numberOfNeighbors = static_cast< unsigned int >( str.NeighborOffsets.size() );
+
+  while ( !fifo.empty() )
+    {
+    const OffsetValueType p = fifo.front();
+    fifo.pop();
+    const InputImagePixelType V = str.Output[p];
+    OffsetType                index;
+    const bool                interior = Self::ComputeIndex( str, p, index );
+    for ( unsigned int k = 0; k < numberOfNeighbors; ++k )
+      {
+      const OffsetValueType q = p + str.NeighborOffsets[k];
+      if ( ( !interior && !Self::IsNeighborInside( str, index, k ) ) || q < begin || q >= end )
+        {
+        continue;
+        }
+      const InputImagePixelType VN = str.Output[q];
+      const InputImagePixelType iN = str.Mask[q];
       // candidate for dilation via flooding
       if ( compare(V, VN) && Math::NotAlmostEquals( iN, VN ) )
         {
         if ( compare(iN, V) )
           {
           // not clamped by the mask, propagate the center value
-          outNIt.SetPixel(*oLIt, V);
+          str.Output[q] = static_cast< OutputImagePixelType >( V );
           }
         else
           {
           // apply the clamping
-          outNIt.SetPixel(*oLIt, iN);
+          str.Output[q] = static_cast< OutputImagePixelType >( iN );
           }
-        IndexFifo.push( outNIt.GetIndex(*oLIt) );
+        fifo.push( q );
         }
       }
-    progress.CompletedPixel();
-    }
-
-  if ( m_UseInternalCopy )
-    {
-    typedef typename itk::CropImageFilter< InputImageType, OutputImageType > CropType;
-    typename CropType::Pointer crop = CropType::New();
-
-    crop->SetInput(markerImageP);
-    crop->SetUpperBoundaryCropSize(padSize);
-    crop->SetLowerBoundaryCropSize(padSize);
-    crop->GraftOutput( this->GetOutput() );
-    /** execute the minipipeline */
-    crop->Update();
-
-    /** graft the minipipeline output back into this filter's output */
-    this->GraftOutput( crop->GetOutput() );
     }
 }
 
@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkGrayscaleFillholeImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkFlatStructuringElement.h"
+#include "itkGrayscaleDilateImageFilter.h"
+#include "itkGrayscaleErodeImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkTestingMacros.h"
+
+/**
+ * In this test, we dilate and erode random images by structuring elements
+ * which can not be decomposed in lines: balls, annuli and random
+ * asymmetric elements. The outputs computed with the chords must match the
+ * ones of the basic algorithm, with several numbers of threads.
+ */
+namespace
+{
+
+unsigned int randomState = 11;
+
+unsigned int
+NextRandom()
+{
+  randomState = randomState * 1664525u + 1013904223u;
+  return randomState >> 8;
+}
+
+template< typename TImage >
+bool
+SameImages( const TImage *expected, const TImage *actual )
+{
+  itk::ImageRegionConstIterator< TImage > eIt( expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > aIt( actual, actual->GetLargestPossibleRegion() );
+  for ( ; !eIt.IsAtEnd(); ++eIt, ++aIt )
+    {
+    if ( itk::Math::NotExactlyEquals( eIt.Get(), aIt.Get() ) )
+      {
+      std::cerr << "Different values: " << static_cast< double >( eIt.Get() )
+                << " and " << static_cast< double >( aIt.Get() ) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< typename TFilter >
+typename TFilter::OutputImageType::Pointer
+Run( const typename TFilter::InputImageType *image, const typename TFilter::KernelType & kernel,
+     int algorithm, itk::ThreadIdType numberOfThreads )
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput( image );
+  filter->SetKernel( kernel );
+  filter->SetAlgorithm( algorithm );
+  filter->SetBoundary( 100 );
+  filter->SetNumberOfThreads( numberOfThreads );
+  filter->Update();
+  return filter->GetOutput();
+}
+
+template< typename TPixel, unsigned int VDimension >
+bool
+CompareWithBasic( unsigned int imageSize )
+{
+  typedef itk::Image< TPixel, VDimension >                                    ImageType;
+  typedef itk::FlatStructuringElement< VDimension >                           KernelType;
+  typedef itk::GrayscaleDilateImageFilter< ImageType, ImageType, KernelType > DilateType;
+  typedef itk::GrayscaleErodeImageFilter< ImageType, ImageType, KernelType >  ErodeType;
+
+  typename ImageType::SizeType size;
+  size.Fill( imageSize );
+  size[0] = imageSize + 5;
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIterator< ImageType > It( image, image->GetLargestPossibleRegion() );
+  for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    It.Set( static_cast< TPixel >( NextRandom() % 200 ) );
+    }
+
+  typename KernelType::RadiusType radius;
+  radius.Fill( 3 );
+  radius[0] = 2;
+  std::vector< KernelType > kernels;
+  kernels.push_back( KernelType::Ball( radius ) );
+  kernels.push_back( KernelType::Annulus( radius, 1, false ) );
+  KernelType random;
+  random.SetRadius( radius );
+  for ( unsigned int i = 0; i < random.Size(); i++ )
+    {
+    random[i] = ( NextRandom() % 3 == 0 );
+    }
+  kernels.push_back( random );
+
+  bool success = true;
+  const itk::ThreadIdType numberOfThreads[2] = { 1, 3 };
+  for ( unsigned int k = 0; k < kernels.size(); k++ )
+    {
+    typename ImageType::Pointer expectedDilation = Run< DilateType >( image, kernels[k], DilateType::BASIC, 1 );
+    typename ImageType::Pointer expectedErosion = Run< ErodeType >( image, kernels[k], ErodeType::BASIC, 1 );
+    for ( unsigned int t = 0; t < 2; t++ )
+      {
+      success &= SameImages< ImageType >( expectedDilation,
+                                          Run< DilateType >( image, kernels[k], DilateType::CHORD, numberOfThreads[t] ) );
+      success &= SameImages< ImageType >( expectedErosion,
+                                          Run< ErodeType >( image, kernels[k], ErodeType::CHORD, numberOfThreads[t] ) );
+      }
+    }
+  return success;
+}
+
+}
+
+int itkChordErodeDilateImageFilterTest( int, char * [] )
+{
+  bool success = true;
+
+  success &= CompareWithBasic< unsigned char, 2 >( 31 );
+  success &= CompareWithBasic< float, 3 >( 13 );
+
+  // the chords are selected for the flat structuring elements which can
+  // not be decomposed in lines
+  typedef itk::Image< float, 2 >                                              ImageType;
+  typedef itk::FlatStructuringElement< 2 >                                    KernelType;
+  typedef itk::GrayscaleDilateImageFilter< ImageType, ImageType, KernelType > DilateType;
+  KernelType::RadiusType radius;
+  radius.Fill( 4 );
+  DilateType::Pointer dilate = DilateType::New();
+  dilate->SetKernel( KernelType::Ball( radius ) );
+  TEST_EXPECT_EQUAL( dilate->GetAlgorithm(), static_cast< int >( DilateType::CHORD ) );
+  dilate->SetKernel( KernelType::Box( radius ) );
+  TEST_EXPECT_EQUAL( dilate->GetAlgorithm(), static_cast< int >( DilateType::ANCHOR ) );
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
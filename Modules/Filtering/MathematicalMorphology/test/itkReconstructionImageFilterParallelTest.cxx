@@ -0,0 +1,236 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkGrayscaleFillholeImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkReconstructionByDilationImageFilter.h"
+#include "itkReconstructionByErosionImageFilter.h"
+#include "itkTimeProbe.h"
+#include "itkTestingMacros.h"
+
+/**
+ * In this test, we reconstruct synthetic 3D images by dilation and by
+ * erosion with several numbers of threads, so the propagation crosses the
+ * borders of the slabs of the threads many times. The outputs must match
+ * a reconstruction computed by iterating elementary geodesic dilations
+ * and erosions until stability, for both connectivities. The times of the
+ * fillhole of a larger image are reported for each number of threads.
+ */
+namespace
+{
+
+const unsigned int Dimension = 3;
+
+typedef itk::Image< unsigned char, Dimension > ImageType;
+
+bool
+SameImages( const ImageType *expected, const ImageType *actual )
+{
+  itk::ImageRegionConstIterator< ImageType > eIt( expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< ImageType > aIt( actual, actual->GetLargestPossibleRegion() );
+  for ( ; !eIt.IsAtEnd(); ++eIt, ++aIt )
+    {
+    if ( eIt.Get() != aIt.Get() )
+      {
+      std::cerr << "Different values: " << static_cast< int >( eIt.Get() )
+                << " and " << static_cast< int >( aIt.Get() ) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// Iterate the elementary geodesic dilations (or erosions) until stability.
+ImageType::Pointer
+NaiveReconstruction( const ImageType *marker, const ImageType *mask, bool fullyConnected, bool byDilation )
+{
+  ImageType::Pointer output = ImageType::New();
+  output->SetRegions( marker->GetLargestPossibleRegion() );
+  output->Allocate();
+  itk::ImageRegionConstIterator< ImageType > mIt( marker, marker->GetLargestPossibleRegion() );
+  itk::ImageRegionIteratorWithIndex< ImageType > oIt( output, output->GetLargestPossibleRegion() );
+  for ( ; !oIt.IsAtEnd(); ++mIt, ++oIt )
+    {
+    oIt.Set( mIt.Get() );
+    }
+
+  const ImageType::RegionType region = output->GetLargestPossibleRegion();
+  bool changed = true;
+  while ( changed )
+    {
+    changed = false;
+    for ( oIt.GoToBegin(); !oIt.IsAtEnd(); ++oIt )
+      {
+      int value = oIt.Get();
+      ImageType::OffsetType offset;
+      for ( unsigned int n = 0; n < 27; ++n )
+        {
+        unsigned int numberOfNonZero = 0;
+        unsigned int remainder = n;
+        for ( unsigned int d = 0; d < Dimension; ++d )
+          {
+          offset[d] = static_cast< int >( remainder % 3 ) - 1;
+          remainder /= 3;
+          numberOfNonZero += ( offset[d] != 0 );
+          }
+        if ( numberOfNonZero == 0 || ( numberOfNonZero > 1 && !fullyConnected ) )
+          {
+          continue;
+          }
+        const ImageType::IndexType neighbor = oIt.GetIndex() + offset;
+        if ( region.IsInside( neighbor ) )
+          {
+          const int neighborValue = output->GetPixel( neighbor );
+          value = byDilation ? std::max( value, neighborValue ) : std::min( value, neighborValue );
+          }
+        }
+      const int maskValue = mask->GetPixel( oIt.GetIndex() );
+      value = byDilation ? std::min( value, maskValue ) : std::max( value, maskValue );
+      if ( value != oIt.Get() )
+        {
+        oIt.Set( static_cast< ImageType::PixelType >( value ) );
+        changed = true;
+        }
+      }
+    }
+  return output;
+}
+
+ImageType::Pointer
+CreateMask( unsigned int imageSize )
+{
+  ImageType::SizeType size;
+  size.Fill( imageSize );
+  size[0] = imageSize + 3;
+
+  // a spiral of bright tubes, so the propagation goes back and forth along
+  // the last dimension, on a noisy background
+  ImageType::Pointer mask = ImageType::New();
+  mask->SetRegions( size );
+  mask->Allocate();
+  unsigned int value = 3;
+  itk::ImageRegionIteratorWithIndex< ImageType > It( mask, mask->GetLargestPossibleRegion() );
+  for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    const ImageType::IndexType & index = It.GetIndex();
+    value = value * 1664525u + 1013904223u;
+    const bool isTube = ( index[0] % 6 < 2 ) && ( ( index[0] / 6 + index[1] / 4 + index[2] ) % 5 < 3 );
+    It.Set( static_cast< ImageType::PixelType >( ( isTube ? 150 : 30 ) + ( value >> 8 ) % 50 ) );
+    }
+  return mask;
+}
+
+}
+
+int itkReconstructionImageFilterParallelTest( int, char * [] )
+{
+  bool success = true;
+
+  ImageType::Pointer mask = CreateMask( 17 );
+
+  // markers below and above the mask
+  ImageType::Pointer lowMarker = ImageType::New();
+  lowMarker->SetRegions( mask->GetLargestPossibleRegion() );
+  lowMarker->Allocate();
+  ImageType::Pointer highMarker = ImageType::New();
+  highMarker->SetRegions( mask->GetLargestPossibleRegion() );
+  highMarker->Allocate();
+  unsigned int value = 5;
+  itk::ImageRegionIteratorWithIndex< ImageType > It( mask, mask->GetLargestPossibleRegion() );
+  for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    value = value * 1664525u + 1013904223u;
+    const bool isSeed = ( ( value >> 8 ) % 61 == 0 );
+    lowMarker->SetPixel( It.GetIndex(), isSeed ? It.Get() : 0 );
+    highMarker->SetPixel( It.GetIndex(), isSeed ? It.Get() : 255 );
+    }
+
+  const itk::ThreadIdType numberOfThreads[3] = { 1, 3, 8 };
+  for ( unsigned int fullyConnected = 0; fullyConnected < 2; fullyConnected++ )
+    {
+    ImageType::Pointer expectedDilation = NaiveReconstruction( lowMarker, mask, fullyConnected, true );
+    ImageType::Pointer expectedErosion = NaiveReconstruction( highMarker, mask, fullyConnected, false );
+
+    for ( unsigned int t = 0; t < 3; t++ )
+      {
+      typedef itk::ReconstructionByDilationImageFilter< ImageType, ImageType > DilationType;
+      DilationType::Pointer dilation = DilationType::New();
+      dilation->SetMarkerImage( lowMarker );
+      dilation->SetMaskImage( mask );
+      dilation->SetFullyConnected( fullyConnected );
+      dilation->SetNumberOfThreads( numberOfThreads[t] );
+      TRY_EXPECT_NO_EXCEPTION( dilation->Update() );
+      success &= SameImages( expectedDilation, dilation->GetOutput() );
+
+      typedef itk::ReconstructionByErosionImageFilter< ImageType, ImageType > ErosionType;
+      ErosionType::Pointer erosion = ErosionType::New();
+      erosion->SetMarkerImage( highMarker );
+      erosion->SetMaskImage( mask );
+      erosion->SetFullyConnected( fullyConnected );
+      erosion->SetNumberOfThreads( numberOfThreads[t] );
+      TRY_EXPECT_NO_EXCEPTION( erosion->Update() );
+      success &= SameImages( expectedErosion, erosion->GetOutput() );
+      }
+    }
+
+  // the marker must be below the mask
+  typedef itk::ReconstructionByDilationImageFilter< ImageType, ImageType > DilationType;
+  DilationType::Pointer invalid = DilationType::New();
+  invalid->SetMarkerImage( highMarker );
+  invalid->SetMaskImage( mask );
+  invalid->SetNumberOfThreads( 3 );
+  TRY_EXPECT_EXCEPTION( invalid->Update() );
+
+  // the fillhole of a larger image
+  ImageType::Pointer largeMask = CreateMask( 96 );
+  ImageType::Pointer expected;
+  for ( unsigned int t = 0; t < 3; t++ )
+    {
+    typedef itk::GrayscaleFillholeImageFilter< ImageType, ImageType > FillholeType;
+    FillholeType::Pointer fillhole = FillholeType::New();
+    fillhole->SetInput( largeMask );
+    fillhole->SetFullyConnected( true );
+    fillhole->SetNumberOfThreads( numberOfThreads[t] );
+
+    itk::TimeProbe timer;
+    timer.Start();
+    TRY_EXPECT_NO_EXCEPTION( fillhole->Update() );
+    timer.Stop();
+    std::cout << "Fillhole with " << numberOfThreads[t] << " threads: "
+              << timer.GetTotal() << " s" << std::endl;
+
+    if ( t == 0 )
+      {
+      expected = fillhole->GetOutput();
+      expected->DisconnectPipeline();
+      }
+    else
+      {
+      success &= SameImages( expected, fillhole->GetOutput() );
+      }
+    }
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
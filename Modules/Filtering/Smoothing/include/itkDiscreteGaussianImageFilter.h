@@ -20,6 +20,8 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkImage.h"
+#include "itkIsSame.h"
+#include <vector>
 
 namespace itk
 {
@@ -43,6 +45,17 @@ namespace itk
  * When the Gaussian kernel is small, this filter tends to run faster than
  * itk::RecursiveGaussianImageFilter.
  *
+ * Images of scalar pixels are convolved along all the axes in one pass
+ * over the output, slab by slab: each thread filters a slab of a few
+ * slices through all the directions in its own buffers, without any
+ * image-sized intermediate. The lines are convolved in small panels of
+ * neighboring lines, so that the inner loops are contiguous and can be
+ * vectorized. The results are the same as convolving the whole image
+ * in each direction in turn, intermediate values included being cast
+ * to the output pixel type. Images of multi-component pixels are
+ * processed by a mini-pipeline of NeighborhoodOperatorImageFilter,
+ * streamed in InternalNumberOfStreamDivisions pieces.
+ *
  * \sa GaussianOperator
  * \sa Image
  * \sa Neighborhood
@@ -98,6 +111,12 @@ public:
   /** Typedef of double containers */
   typedef FixedArray< double, itkGetStaticConstMacro(ImageDimension) > ArrayType;
 
+  /** Type of the kernel coefficients and of the convolution sums. */
+  typedef typename NumericTraits< OutputPixelType >::RealType     RealOutputPixelType;
+  typedef typename NumericTraits< RealOutputPixelType >::ValueType RealOutputPixelValueType;
+
+  typedef typename OutputImageType::RegionType OutputImageRegionType;
+
   /** The variance for the discrete Gaussian kernel.  Sets the variance
    * independently for each dimension, but
    * see also SetVariance(const double v). The default is 0.0 in each
@@ -207,7 +226,9 @@ public:
    * The default value is $ImageDimension^2$.
    *
    * This parameter was introduced to reduce the memory used by images
-   * internally, at the cost of performance.
+   * internally, at the cost of performance. It is only used for images
+   * of multi-component pixels; images of scalar pixels are filtered
+   * without internal images.
    */
   itkSetMacro(InternalNumberOfStreamDivisions, unsigned int);
   itkGetConstReferenceMacro(InternalNumberOfStreamDivisions, unsigned int);
@@ -243,16 +264,145 @@ protected:
   virtual ~DiscreteGaussianImageFilter() ITK_OVERRIDE {}
   void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
 
-  /** Standard pipeline method. While this class does not implement a
-   * ThreadedGenerateData(), its GenerateData() delegates all
-   * calculations to an NeighborhoodOperatorImageFilter.  Since the
+  /** Standard pipeline method. Images of scalar pixels are filtered by
+   * ThreadedGenerateData(). For other images, GenerateData() delegates
+   * all calculations to a NeighborhoodOperatorImageFilter.  Since the
    * NeighborhoodOperatorImageFilter is multithreaded, this filter is
    * multithreaded by default. */
   void GenerateData() ITK_OVERRIDE;
 
+  /** Compute the kernel coefficients of each filtered direction. */
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Convolve the region of the output slab by slab along all the
+   * filtered directions. */
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId) ITK_OVERRIDE;
+
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(DiscreteGaussianImageFilter);
 
+  /** True when the pixels of both images are scalars. */
+  typedef typename mpl::AndC< IsSame< InputPixelType, InputPixelValueType >::Value,
+                              IsSame< OutputPixelType, OutputPixelValueType >::Value >::Type ScalarPixelsType;
+
+  typedef std::vector< RealOutputPixelValueType > KernelType;
+  typedef typename OutputImageType::IndexType     IndexType;
+
+  /** Access to the pixels of the input or output image through their
+   * pixel accessors. */
+  template< typename TImage >
+  class ImageView
+  {
+  public:
+    typedef typename TImage::InternalPixelType   InternalPixelType;
+    typedef typename TImage::AccessorType        AccessorType;
+    typedef typename TImage::AccessorFunctorType AccessorFunctorType;
+
+    ImageView(const TImage *image):
+      m_Image(image),
+      m_Buffer( const_cast< InternalPixelType * >( image->GetBufferPointer() ) ),
+      m_PixelAccessor( image->GetPixelAccessor() )
+    {
+      m_Accessor.SetPixelAccessor(m_PixelAccessor);
+      m_Accessor.SetBegin(m_Buffer);
+      for ( unsigned int d = 0; d < ImageDimension; ++d )
+        {
+        m_Strides[d] = image->GetOffsetTable()[d];
+        }
+    }
+
+    OffsetValueType ComputeOffset(const IndexType & index) const
+    {
+      return m_Image->ComputeOffset(index);
+    }
+    OffsetValueType GetStride(unsigned int dim) const { return m_Strides[dim]; }
+    RealOutputPixelValueType Get(OffsetValueType offset) const
+    {
+      return static_cast< RealOutputPixelValueType >( m_Accessor.Get( *( m_Buffer + offset ) ) );
+    }
+    void Set(OffsetValueType offset, RealOutputPixelValueType value) const
+    {
+      m_Accessor.Set( *( m_Buffer + offset ), static_cast< OutputPixelType >( value ) );
+    }
+
+  private:
+    ITK_DISALLOW_COPY_AND_ASSIGN(ImageView);
+
+    const TImage *      m_Image;
+    InternalPixelType * m_Buffer;
+    AccessorType        m_PixelAccessor;
+    AccessorFunctorType m_Accessor;
+    OffsetValueType     m_Strides[ImageDimension];
+  };
+
+  /** Intermediate values of a slab, stored in the output pixel type as
+   * they would be in an intermediate image. */
+  class BufferView
+  {
+  public:
+    BufferView(std::vector< OutputPixelType > & buffer, const OutputImageRegionType & region):
+      m_Region(region)
+    {
+      buffer.resize( region.GetNumberOfPixels() );
+      m_Buffer = buffer.empty() ? ITK_NULLPTR : &buffer[0];
+      OffsetValueType stride = 1;
+      for ( unsigned int d = 0; d < ImageDimension; ++d )
+        {
+        m_Strides[d] = stride;
+        stride *= static_cast< OffsetValueType >( region.GetSize(d) );
+        }
+    }
+
+    OffsetValueType ComputeOffset(const IndexType & index) const
+    {
+      OffsetValueType offset = 0;
+      for ( unsigned int d = 0; d < ImageDimension; ++d )
+        {
+        offset += ( index[d] - m_Region.GetIndex(d) ) * m_Strides[d];
+        }
+      return offset;
+    }
+    OffsetValueType GetStride(unsigned int dim) const { return m_Strides[dim]; }
+    RealOutputPixelValueType Get(OffsetValueType offset) const
+    {
+      return static_cast< RealOutputPixelValueType >( m_Buffer[offset] );
+    }
+    void Set(OffsetValueType offset, RealOutputPixelValueType value) const
+    {
+      m_Buffer[offset] = static_cast< OutputPixelType >( value );
+    }
+
+  private:
+    OutputPixelType *     m_Buffer;
+    OutputImageRegionType m_Region;
+    OffsetValueType       m_Strides[ImageDimension];
+  };
+
+  /** Scratch space of one thread. */
+  struct LineBuffers
+  {
+    std::vector< RealOutputPixelValueType > Input;
+    std::vector< RealOutputPixelValueType > Output;
+  };
+
+  /** Convolve the lines of region along direction with kernel, reading
+   * from source and writing to destination. The source covers region
+   * padded by the kernel radius along direction, cropped to the largest
+   * possible region; the lines are extended by repeating their end
+   * values beyond the largest possible region. */
+  template< typename TSource, typename TDestination >
+  void ConvolveLines(const TSource & source, const TDestination & destination,
+                     const OutputImageRegionType & region, unsigned int direction,
+                     const KernelType & kernel, LineBuffers & buffers) const;
+
+  /** ThreadedGenerateData() for images of scalar pixels, and a
+   * placeholder for the other images, which are not threaded here. */
+  void ConvolveRegion(const OutputImageRegionType & outputRegionForThread,
+                      ThreadIdType threadId, mpl::TrueType);
+
+  void ConvolveRegion(const OutputImageRegionType &, ThreadIdType, mpl::FalseType) {}
+
   /** The variance of the gaussian blurring kernel in each dimensional
     direction. */
   ArrayType m_Variance;
@@ -275,6 +425,9 @@ private:
   /** Number of pieces to divide the input on the internal composite
   pipeline. The upstream pipeline will not be effected. */
   unsigned int m_InternalNumberOfStreamDivisions;
+
+  /** Kernel coefficients of each filtered direction. */
+  std::vector< KernelType > m_Kernels;
 };
 } // end namespace itk
 
@@ -23,8 +23,11 @@
 #include "itkGaussianOperator.h"
 #include "itkImageRegionIterator.h"
 #include "itkProgressAccumulator.h"
+#include "itkProgressReporter.h"
 #include "itkStreamingImageFilter.h"
 
+#include <algorithm>
+
 namespace itk
 {
 template< typename TInputImage, typename TOutputImage >
@@ -116,6 +119,21 @@ void
 DiscreteGaussianImageFilter< TInputImage, TOutputImage >
 ::GenerateData()
 {
+  // Determine the dimensionality to filter
+  unsigned int filterDimensionality = m_FilterDimensionality;
+  if ( filterDimensionality > ImageDimension )
+    {
+    filterDimensionality = ImageDimension;
+    }
+
+  // Images of scalar pixels are filtered by ThreadedGenerateData(),
+  // without intermediate images
+  if ( filterDimensionality > 0 && ScalarPixelsType::Value )
+    {
+    Superclass::GenerateData();
+    return;
+    }
+
   typename TOutputImage::Pointer output = this->GetOutput();
 
   output->SetBufferedRegion( output->GetRequestedRegion() );
@@ -127,12 +145,6 @@ DiscreteGaussianImageFilter< TInputImage, TOutputImage >
   typename TInputImage::Pointer localInput = TInputImage::New();
   localInput->Graft( this->GetInput() );
 
-  // Determine the dimensionality to filter
-  unsigned int filterDimensionality = m_FilterDimensionality;
-  if ( filterDimensionality > ImageDimension )
-    {
-    filterDimensionality = ImageDimension;
-    }
   if ( filterDimensionality == 0 )
     {
     // no smoothing, copy input to output
@@ -153,10 +165,7 @@ DiscreteGaussianImageFilter< TInputImage, TOutputImage >
     }
 
   // Type of the pixel to use for intermediate results
-  typedef typename NumericTraits< OutputPixelType >::RealType RealOutputPixelType;
-  typedef Image< OutputPixelType, ImageDimension >            RealOutputImageType;
-
-  typedef typename NumericTraits<RealOutputPixelType>::ValueType RealOutputPixelValueType;
+  typedef Image< OutputPixelType, ImageDimension > RealOutputImageType;
 
   // Type definition for the internal neighborhood filter
   //
@@ -327,6 +336,268 @@ DiscreteGaussianImageFilter< TInputImage, TOutputImage >
     }
 }
 
+template< typename TInputImage, typename TOutputImage >
+void
+DiscreteGaussianImageFilter< TInputImage, TOutputImage >
+::BeforeThreadedGenerateData()
+{
+  const InputImageType *input = this->GetInput();
+
+  unsigned int filterDimensionality = m_FilterDimensionality;
+  if ( filterDimensionality > ImageDimension )
+    {
+    filterDimensionality = ImageDimension;
+    }
+  m_Kernels.resize(filterDimensionality);
+  for ( unsigned int i = 0; i < filterDimensionality; ++i )
+    {
+    GaussianOperator< RealOutputPixelValueType, ImageDimension > oper;
+    oper.SetDirection(i);
+    if ( m_UseImageSpacing == true )
+      {
+      if ( input->GetSpacing()[i] == 0.0 )
+        {
+        itkExceptionMacro(<< "Pixel spacing cannot be zero");
+        }
+      else
+        {
+        // convert the variance from physical units to pixels
+        double s = input->GetSpacing()[i];
+        s = s * s;
+        oper.SetVariance(m_Variance[i] / s);
+        }
+      }
+    else
+      {
+      oper.SetVariance(m_Variance[i]);
+      }
+    oper.SetMaximumKernelWidth(m_MaximumKernelWidth);
+    oper.SetMaximumError(m_MaximumError[i]);
+    oper.CreateDirectional();
+
+    m_Kernels[i].assign( oper.Begin(), oper.End() );
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+DiscreteGaussianImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                       ThreadIdType threadId)
+{
+  this->ConvolveRegion( outputRegionForThread, threadId, ScalarPixelsType() );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+DiscreteGaussianImageFilter< TInputImage, TOutputImage >
+::ConvolveRegion(const OutputImageRegionType & outputRegionForThread,
+                 ThreadIdType threadId, mpl::TrueType)
+{
+  if ( outputRegionForThread.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  OutputImageType *                output = this->GetOutput();
+  const OutputImageRegionType      largestRegion = output->GetLargestPossibleRegion();
+  const unsigned int               filterDimensionality = static_cast< unsigned int >( m_Kernels.size() );
+  const ImageView< InputImageType >  inputView( this->GetInput() );
+  const ImageView< OutputImageType > outputView(output);
+
+  // The region is processed in slabs of whole slices along the last
+  // dimension. A slab is filtered along the last filtered direction
+  // first, straight from the input, then along the others in the
+  // buffers of the thread, and along direction 0 into the output. The
+  // slabs are sized so that their intermediate values stay in cache.
+  const unsigned int slabDimension = ImageDimension - 1;
+  const SizeValueType slabBytes = 256 * 1024;
+  SizeValueType sliceBytes = sizeof( OutputPixelType );
+  for ( unsigned int d = 0; d < slabDimension; ++d )
+    {
+    SizeValueType size = outputRegionForThread.GetSize(d);
+    if ( d < filterDimensionality )
+      {
+      size = std::min( size + m_Kernels[d].size() - 1, static_cast< SizeValueType >( largestRegion.GetSize(d) ) );
+      }
+    sliceBytes *= size;
+    }
+  const SizeValueType slabSlices = std::max< SizeValueType >( 1, slabBytes / sliceBytes );
+  const SizeValueType numberOfSlices = outputRegionForThread.GetSize(slabDimension);
+  const SizeValueType numberOfSlabs = ( numberOfSlices + slabSlices - 1 ) / slabSlices;
+
+  ProgressReporter progress(this, threadId, numberOfSlabs);
+
+  std::vector< OutputImageRegionType > regions(filterDimensionality);
+  std::vector< OutputPixelType >       scratch[2];
+  LineBuffers                          buffers;
+  for ( SizeValueType slab = 0; slab < numberOfSlabs; ++slab )
+    {
+    // regions[k] is the region written by the k-th convolution, which is
+    // along direction filterDimensionality - 1 - k. It must cover the
+    // region read by the next convolution.
+    OutputImageRegionType slabRegion = outputRegionForThread;
+    slabRegion.SetIndex( slabDimension, outputRegionForThread.GetIndex(slabDimension)
+                         + static_cast< IndexValueType >( slab * slabSlices ) );
+    slabRegion.SetSize( slabDimension, std::min( slabSlices, numberOfSlices - slab * slabSlices ) );
+    regions[filterDimensionality - 1] = slabRegion;
+    for ( unsigned int k = filterDimensionality - 1; k > 0; --k )
+      {
+      const unsigned int   direction = filterDimensionality - 1 - k;
+      const IndexValueType radius = static_cast< IndexValueType >( m_Kernels[direction].size() / 2 );
+      const IndexValueType lower = std::max( regions[k].GetIndex(direction) - radius,
+                                             largestRegion.GetIndex(direction) );
+      const IndexValueType upper = std::min( regions[k].GetUpperIndex()[direction] + radius,
+                                             largestRegion.GetUpperIndex()[direction] );
+      regions[k - 1] = regions[k];
+      regions[k - 1].SetIndex(direction, lower);
+      regions[k - 1].SetSize( direction, static_cast< SizeValueType >( upper - lower + 1 ) );
+      }
+
+    if ( filterDimensionality == 1 )
+      {
+      this->ConvolveLines(inputView, outputView, regions[0], 0, m_Kernels[0], buffers);
+      }
+    else
+      {
+      const BufferView first(scratch[0], regions[0]);
+      this->ConvolveLines(inputView, first, regions[0], filterDimensionality - 1,
+                          m_Kernels[filterDimensionality - 1], buffers);
+      for ( unsigned int k = 1; k + 1 < filterDimensionality; ++k )
+        {
+        const BufferView source(scratch[( k - 1 ) % 2], regions[k - 1]);
+        const BufferView destination(scratch[k % 2], regions[k]);
+        this->ConvolveLines(source, destination, regions[k], filterDimensionality - 1 - k,
+                            m_Kernels[filterDimensionality - 1 - k], buffers);
+        }
+      const BufferView last(scratch[( filterDimensionality - 2 ) % 2], regions[filterDimensionality - 2]);
+      this->ConvolveLines(last, outputView, regions[filterDimensionality - 1], 0, m_Kernels[0], buffers);
+      }
+    progress.CompletedPixel();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+template< typename TSource, typename TDestination >
+void
+DiscreteGaussianImageFilter< TInputImage, TOutputImage >
+::ConvolveLines(const TSource & source, const TDestination & destination,
+                const OutputImageRegionType & region, unsigned int direction,
+                const KernelType & kernel, LineBuffers & buffers) const
+{
+  // Lines along a direction other than 0 are convolved in panels of
+  // lines that are neighbors along direction 0: the values at one
+  // position of all the lines of a panel are contiguous in the line
+  // buffers.
+  const SizeValueType panelWidth = 16;
+
+  const OutputImageRegionType largestRegion = this->GetOutput()->GetLargestPossibleRegion();
+  const IndexValueType        lower = largestRegion.GetIndex(direction);
+  const IndexValueType        upper = largestRegion.GetUpperIndex()[direction];
+  const IndexValueType        first = region.GetIndex(direction);
+  const SizeValueType         length = region.GetSize(direction);
+  const SizeValueType         kernelWidth = kernel.size();
+  const IndexValueType        radius = static_cast< IndexValueType >( kernelWidth / 2 );
+  const SizeValueType         maximumWidth = ( direction == 0 ) ? 1 : std::min( panelWidth, region.GetSize(0) );
+
+  buffers.Input.resize( ( length + kernelWidth - 1 ) * maximumWidth );
+  buffers.Output.resize(length * maximumWidth);
+  RealOutputPixelValueType *in = &buffers.Input[0];
+  RealOutputPixelValueType *out = &buffers.Output[0];
+
+  const OffsetValueType sourceStride = source.GetStride(direction);
+  const OffsetValueType sourceStride0 = source.GetStride(0);
+  const OffsetValueType destinationStride = destination.GetStride(direction);
+  const OffsetValueType destinationStride0 = destination.GetStride(0);
+
+  const IndexType start = region.GetIndex();
+  IndexType       index = start;
+  while ( true )
+    {
+    const SizeValueType width = ( direction == 0 ) ? 1
+      : std::min( panelWidth, static_cast< SizeValueType >( start[0] + region.GetSize(0) - index[0] ) );
+
+    // Gather the lines, repeating the values at the image boundary.
+    IndexType sourceIndex = index;
+    sourceIndex[direction] = lower;
+    const OffsetValueType sourceBase = source.ComputeOffset(sourceIndex);
+    for ( SizeValueType p = 0; p < length + kernelWidth - 1; ++p )
+      {
+      const IndexValueType  position = std::min( std::max( first - radius + static_cast< IndexValueType >( p ), lower ),
+                                                 upper );
+      const OffsetValueType offset = sourceBase + ( position - lower ) * sourceStride;
+      for ( SizeValueType w = 0; w < width; ++w )
+        {
+        in[p * width + w] = source.Get( offset + static_cast< OffsetValueType >( w ) * sourceStride0 );
+        }
+      }
+
+    // The sums run over the kernel in the same order for every output
+    // value; the inner loops are contiguous.
+    if ( width == 1 )
+      {
+      std::fill(out, out + length, NumericTraits< RealOutputPixelValueType >::ZeroValue());
+      for ( SizeValueType k = 0; k < kernelWidth; ++k )
+        {
+        const RealOutputPixelValueType   c = kernel[k];
+        const RealOutputPixelValueType * inK = in + k;
+        for ( SizeValueType i = 0; i < length; ++i )
+          {
+          out[i] += c * inK[i];
+          }
+        }
+      }
+    else
+      {
+      for ( SizeValueType i = 0; i < length; ++i )
+        {
+        RealOutputPixelValueType *outRow = out + i * width;
+        std::fill(outRow, outRow + width, NumericTraits< RealOutputPixelValueType >::ZeroValue());
+        for ( SizeValueType k = 0; k < kernelWidth; ++k )
+          {
+          const RealOutputPixelValueType   c = kernel[k];
+          const RealOutputPixelValueType * inRow = in + ( i + k ) * width;
+          for ( SizeValueType w = 0; w < width; ++w )
+            {
+            outRow[w] += c * inRow[w];
+            }
+          }
+        }
+      }
+
+    // Scatter the convolved lines.
+    const OffsetValueType destinationBase = destination.ComputeOffset(index);
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      const OffsetValueType offset = destinationBase + static_cast< OffsetValueType >( i ) * destinationStride;
+      for ( SizeValueType w = 0; w < width; ++w )
+        {
+        destination.Set( offset + static_cast< OffsetValueType >( w ) * destinationStride0, out[i * width + w] );
+        }
+      }
+
+    // Next line or panel.
+    unsigned int d = 0;
+    for (; d < ImageDimension; ++d )
+      {
+      if ( d == direction )
+        {
+        continue;
+        }
+      index[d] += ( d == 0 ) ? static_cast< IndexValueType >( width ) : 1;
+      if ( index[d] < start[d] + static_cast< IndexValueType >( region.GetSize(d) ) )
+        {
+        break;
+        }
+      index[d] = start[d];
+      }
+    if ( d == ImageDimension )
+      {
+      break;
+      }
+    }
+}
+
 template< typename TInputImage, typename TOutputImage >
 void
 DiscreteGaussianImageFilter< TInputImage, TOutputImage >
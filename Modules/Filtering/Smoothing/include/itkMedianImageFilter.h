@@ -20,6 +20,9 @@
 
 #include "itkBoxImageFilter.h"
 #include "itkImage.h"
+#include <limits>
+#include <utility>
+#include <vector>
 
 namespace itk
 {
@@ -35,6 +38,33 @@ namespace itk
  * This filter requires that the input pixel type provides an operator<()
  * (LessThan Comparable).
  *
+ * For input pixels of arithmetic types, the filter chooses how to
+ * compute the medians from the size of the neighborhood and the pixel
+ * type:
+ * - neighborhoods of at most 27 pixels (3x3x3) go through a median
+ *   selection network, a fixed sequence of min/max operations pruned
+ *   from Batcher's odd-even merge sort;
+ * - larger neighborhoods of integers of at most 16 bits are counted in
+ *   a histogram that slides along each row, updated with the pixels
+ *   entering and leaving the neighborhood only. The histogram has two
+ *   tiers, so that finding the median reads a few coarse bins and
+ *   the fine bins of one coarse bin. The cost per pixel is not constant:
+ *   it is proportional to the number of lines of the neighborhood along
+ *   the row, whose entering and leaving pixels update the histogram;
+ * - larger neighborhoods of other types are sorted partially, as for
+ *   non-arithmetic pixel types, unless UseQuantization is on.
+ *
+ * When UseQuantization is on, the larger neighborhoods of pixels that
+ * are not 8 or 16 bit integers go through the sliding histogram too,
+ * with the input values quantized to NumberOfQuantizationLevels levels
+ * between the minimum and the maximum of the input. The medians are
+ * then approximate: they are the centers of the levels holding the
+ * exact medians, which are at most half a level away, i.e.
+ * (maximum - minimum) / ( 2 * NumberOfQuantizationLevels ). The minimum
+ * and the maximum only account for the finite values: NaN values are
+ * counted in the lowest level, and infinite values in the lowest or the
+ * highest level.
+ *
  * \sa Image
  * \sa Neighborhood
  * \sa NeighborhoodOperator
@@ -84,6 +114,17 @@ public:
 
   typedef typename InputImageType::SizeType InputSizeType;
 
+  /** Compute approximate medians of quantized values for large
+   * neighborhoods of pixels that are not 8 or 16 bit integers. Off by
+   * default. */
+  itkSetMacro(UseQuantization, bool);
+  itkGetConstMacro(UseQuantization, bool);
+  itkBooleanMacro(UseQuantization);
+
+  /** Number of levels of the quantized values. The default is 65536. */
+  itkSetClampMacro(NumberOfQuantizationLevels, unsigned int, 2, 1u << 24);
+  itkGetConstMacro(NumberOfQuantizationLevels, unsigned int);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   // Begin concept checking
   itkConceptMacro( SameDimensionCheck,
@@ -98,6 +139,10 @@ public:
 protected:
   MedianImageFilter();
   virtual ~MedianImageFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  /** Build the selection network or set up the histogram. */
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
 
   /** MedianImageFilter can be implemented as a multithreaded filter.
    * Therefore, this implementation provides a ThreadedGenerateData()
@@ -114,6 +159,57 @@ protected:
 
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(MedianImageFilter);
+
+  typedef typename mpl::If< std::numeric_limits< InputPixelType >::is_specialized,
+                            mpl::TrueType, mpl::FalseType >::Type ArithmeticPixelType;
+
+  typedef std::pair< unsigned int, unsigned int > ComparatorType;
+  typedef std::vector< ComparatorType >           NetworkType;
+
+  /** Compute the medians with the method suited to the pixel type and
+   * the size of the neighborhood. */
+  void ComputeMedians(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId,
+                      mpl::TrueType);
+
+  void ComputeMedians(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId,
+                      mpl::FalseType)
+  {
+    this->ComputeMediansBySelection(outputRegionForThread, threadId);
+  }
+
+  /** Partially sort each neighborhood with std::nth_element(). */
+  void ComputeMediansBySelection(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId);
+
+  /** Run each neighborhood through m_SelectionNetwork. */
+  void ComputeMediansWithNetwork(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId);
+
+  /** Slide a histogram of the neighborhood along each row. */
+  void ComputeMediansWithHistogram(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId);
+
+  /** Buffer offsets of the lines along direction 0 of the neighborhood
+   * of the first pixel of a row, and of the positions along the row,
+   * replicating the border of the buffered region of the input. */
+  void ComputeRowOffsets(const typename InputImageType::IndexType & rowIndex, SizeValueType rowLength,
+                         std::vector< OffsetValueType > & lineOffsets,
+                         std::vector< OffsetValueType > & positionOffsets) const;
+
+  /** Comparators of a network that moves the median of size values to
+   * position size / 2. */
+  static NetworkType MakeSelectionNetwork(unsigned int size);
+
+  bool         m_UseQuantization;
+  unsigned int m_NumberOfQuantizationLevels;
+
+  NetworkType m_SelectionNetwork;
+
+  /** Mapping of the input values to the bins of the histogram: bin b
+   * holds the values v with floor( ( v - m_HistogramMinimum ) * m_HistogramScale ) == b,
+   * and its value is m_HistogramMinimum + ( b + m_HistogramBinCenter ) / m_HistogramScale.
+   * There is no histogram when m_NumberOfHistogramBins is 0. */
+  SizeValueType m_NumberOfHistogramBins;
+  double        m_HistogramMinimum;
+  double        m_HistogramScale;
+  double        m_HistogramBinCenter;
 };
 } // end namespace itk
 
@@ -25,22 +25,407 @@
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkOffset.h"
 #include "itkProgressReporter.h"
+#include "itkImageScanlineIterator.h"
+#include "itkMath.h"
 
 #include <vector>
 #include <algorithm>
+#include <cmath>
 
 namespace itk
 {
 template< typename TInputImage, typename TOutputImage >
 MedianImageFilter< TInputImage, TOutputImage >
-::MedianImageFilter()
+::MedianImageFilter():
+  m_UseQuantization(false),
+  m_NumberOfQuantizationLevels(65536),
+  m_NumberOfHistogramBins(0),
+  m_HistogramMinimum(0.0),
+  m_HistogramScale(1.0),
+  m_HistogramBinCenter(0.0)
 {}
 
+template< typename TInputImage, typename TOutputImage >
+typename MedianImageFilter< TInputImage, TOutputImage >::NetworkType
+MedianImageFilter< TInputImage, TOutputImage >
+::MakeSelectionNetwork(unsigned int size)
+{
+  // Batcher's odd-even merge sort, for any size.
+  NetworkType sortingNetwork;
+  for ( unsigned int p = 1; p < size; p += p )
+    {
+    for ( unsigned int k = p; k >= 1; k /= 2 )
+      {
+      for ( unsigned int j = k % p; j + k < size; j += 2 * k )
+        {
+        for ( unsigned int i = 0; i < std::min(k, size - j - k); ++i )
+          {
+          if ( ( i + j ) / ( 2 * p ) == ( i + j + k ) / ( 2 * p ) )
+            {
+            sortingNetwork.push_back( ComparatorType(i + j, i + j + k) );
+            }
+          }
+        }
+      }
+    }
+
+  // Only keep the comparators that the median depends on.
+  std::vector< bool > needed(size, false);
+  needed[size / 2] = true;
+  NetworkType selectionNetwork;
+  for ( typename NetworkType::reverse_iterator it = sortingNetwork.rbegin(); it != sortingNetwork.rend(); ++it )
+    {
+    if ( needed[it->first] || needed[it->second] )
+      {
+      needed[it->first] = true;
+      needed[it->second] = true;
+      selectionNetwork.push_back(*it);
+      }
+    }
+  std::reverse( selectionNetwork.begin(), selectionNetwork.end() );
+  return selectionNetwork;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::BeforeThreadedGenerateData()
+{
+  // Neighborhoods up to 3x3x3 go through a selection network.
+  const unsigned int maximumNetworkSize = 27;
+
+  SizeValueType neighborhoodSize = 1;
+  for ( unsigned int d = 0; d < InputImageDimension; ++d )
+    {
+    neighborhoodSize *= 2 * this->GetRadius()[d] + 1;
+    }
+
+  m_SelectionNetwork.clear();
+  m_NumberOfHistogramBins = 0;
+  if ( !ArithmeticPixelType::Value )
+    {
+    return;
+    }
+  if ( neighborhoodSize <= maximumNetworkSize )
+    {
+    m_SelectionNetwork = MakeSelectionNetwork( static_cast< unsigned int >( neighborhoodSize ) );
+    return;
+    }
+
+  typedef std::numeric_limits< InputPixelType > LimitsType;
+  if ( LimitsType::is_integer && sizeof( InputPixelType ) <= 2 )
+    {
+    // One bin per value
+    m_HistogramMinimum = static_cast< double >( LimitsType::min() );
+    m_HistogramScale = 1.0;
+    m_HistogramBinCenter = 0.0;
+    m_NumberOfHistogramBins =
+      static_cast< SizeValueType >( static_cast< double >( LimitsType::max() ) - m_HistogramMinimum + 1.0 );
+    }
+  else if ( m_UseQuantization )
+    {
+    const InputImageType *input = this->GetInput();
+    ImageRegionConstIterator< InputImageType > it( input, input->GetBufferedRegion() );
+    double minimum = NumericTraits< double >::max();
+    double maximum = NumericTraits< double >::NonpositiveMin();
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      const double value = static_cast< double >( it.Get() );
+      if ( !Math::isfinite(value) )
+        {
+        continue;
+        }
+      minimum = std::min(minimum, value);
+      maximum = std::max(maximum, value);
+      }
+    if ( !( maximum >= minimum ) )
+      {
+      // no finite value
+      minimum = maximum = 0.0;
+      }
+    m_HistogramMinimum = minimum;
+    if ( maximum > minimum )
+      {
+      m_NumberOfHistogramBins = m_NumberOfQuantizationLevels;
+      m_HistogramScale = m_NumberOfQuantizationLevels / ( maximum - minimum );
+      m_HistogramBinCenter = 0.5;
+      }
+    else
+      {
+      m_NumberOfHistogramBins = 1;
+      m_HistogramScale = 1.0;
+      m_HistogramBinCenter = 0.0;
+      }
+    }
+}
+
 template< typename TInputImage, typename TOutputImage >
 void
 MedianImageFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                        ThreadIdType threadId)
+{
+  this->ComputeMedians( outputRegionForThread, threadId, ArithmeticPixelType() );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::ComputeMedians(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId,
+                 mpl::TrueType)
+{
+  if ( !m_SelectionNetwork.empty() )
+    {
+    this->ComputeMediansWithNetwork(outputRegionForThread, threadId);
+    }
+  else if ( m_NumberOfHistogramBins > 0 )
+    {
+    this->ComputeMediansWithHistogram(outputRegionForThread, threadId);
+    }
+  else
+    {
+    this->ComputeMediansBySelection(outputRegionForThread, threadId);
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::ComputeRowOffsets(const typename InputImageType::IndexType & rowIndex, SizeValueType rowLength,
+                    std::vector< OffsetValueType > & lineOffsets,
+                    std::vector< OffsetValueType > & positionOffsets) const
+{
+  const InputImageType *       input = this->GetInput();
+  const InputImageRegionType & bufferedRegion = input->GetBufferedRegion();
+  const OffsetValueType *      offsetTable = input->GetOffsetTable();
+  const InputSizeType &        radius = this->GetRadius();
+
+  // Lines of the neighborhood, in the order of a neighborhood iterator.
+  lineOffsets.assign(1, 0);
+  for ( unsigned int d = 1; d < InputImageDimension; ++d )
+    {
+    const SizeValueType numberOfLines = lineOffsets.size();
+    const IndexValueType lower = bufferedRegion.GetIndex(d);
+    const IndexValueType upper = lower + static_cast< IndexValueType >( bufferedRegion.GetSize(d) ) - 1;
+    std::vector< OffsetValueType > lines;
+    lines.reserve( numberOfLines * ( 2 * radius[d] + 1 ) );
+    for ( IndexValueType o = -static_cast< IndexValueType >( radius[d] );
+          o <= static_cast< IndexValueType >( radius[d] ); ++o )
+      {
+      const IndexValueType index = std::min( std::max(rowIndex[d] + o, lower), upper );
+      for ( SizeValueType l = 0; l < numberOfLines; ++l )
+        {
+        lines.push_back( lineOffsets[l] + ( index - lower ) * offsetTable[d] );
+        }
+      }
+    lineOffsets.swap(lines);
+    }
+
+  // Positions from rowIndex[0] - radius[0] to the end of the row plus radius[0].
+  const IndexValueType lower = bufferedRegion.GetIndex(0);
+  const IndexValueType upper = lower + static_cast< IndexValueType >( bufferedRegion.GetSize(0) ) - 1;
+  positionOffsets.resize( rowLength + 2 * radius[0] );
+  for ( SizeValueType i = 0; i < positionOffsets.size(); ++i )
+    {
+    const IndexValueType index = rowIndex[0] - static_cast< IndexValueType >( radius[0] ) + static_cast< IndexValueType >( i );
+    positionOffsets[i] = std::min( std::max(index, lower), upper ) - lower;
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::ComputeMediansWithNetwork(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId)
+{
+  typedef typename InputImageType::AccessorFunctorType InputAccessorFunctorType;
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+
+  typename InputImageType::AccessorType pixelAccessor = input->GetPixelAccessor();
+  InputAccessorFunctorType              accessor;
+  accessor.SetPixelAccessor(pixelAccessor);
+  accessor.SetBegin( input->GetBufferPointer() );
+  const typename InputImageType::InternalPixelType *buffer = input->GetBufferPointer();
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  const SizeValueType            rowLength = outputRegionForThread.GetSize(0);
+  const SizeValueType            width = 2 * this->GetRadius()[0] + 1;
+  const ComparatorType *         network = &m_SelectionNetwork[0];
+  const SizeValueType            networkSize = m_SelectionNetwork.size();
+  std::vector< OffsetValueType > lineOffsets;
+  std::vector< OffsetValueType > positionOffsets;
+  std::vector< InputPixelType >  pixels;
+
+  ImageScanlineIterator< OutputImageType > it(output, outputRegionForThread);
+  while ( !it.IsAtEnd() )
+    {
+    this->ComputeRowOffsets(it.GetIndex(), rowLength, lineOffsets, positionOffsets);
+    pixels.resize( lineOffsets.size() * width );
+    for ( SizeValueType x = 0; !it.IsAtEndOfLine(); ++x, ++it )
+      {
+      InputPixelType *p = &pixels[0];
+      for ( SizeValueType l = 0; l < lineOffsets.size(); ++l )
+        {
+        for ( SizeValueType w = 0; w < width; ++w )
+          {
+          *p++ = accessor.Get( buffer[lineOffsets[l] + positionOffsets[x + w]] );
+          }
+        }
+
+      InputPixelType *v = &pixels[0];
+      for ( SizeValueType c = 0; c < networkSize; ++c )
+        {
+        const InputPixelType a = v[network[c].first];
+        const InputPixelType b = v[network[c].second];
+        v[network[c].first] = std::min(a, b);
+        v[network[c].second] = std::max(a, b);
+        }
+      it.Set( static_cast< OutputPixelType >( v[pixels.size() / 2] ) );
+      progress.CompletedPixel();
+      }
+    it.NextLine();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::ComputeMediansWithHistogram(const OutputImageRegionType & outputRegionForThread,
+                              ThreadIdType threadId)
+{
+  typedef typename InputImageType::AccessorFunctorType InputAccessorFunctorType;
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+
+  typename InputImageType::AccessorType pixelAccessor = input->GetPixelAccessor();
+  InputAccessorFunctorType              accessor;
+  accessor.SetPixelAccessor(pixelAccessor);
+  accessor.SetBegin( input->GetBufferPointer() );
+  const typename InputImageType::InternalPixelType *buffer = input->GetBufferPointer();
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  // Coarse bins of 2^shift fine bins, about as many as there are fine
+  // bins in each.
+  unsigned int shift = 0;
+  while ( ( static_cast< SizeValueType >( 1 ) << ( 2 * shift ) ) < m_NumberOfHistogramBins )
+    {
+    ++shift;
+    }
+  const SizeValueType            numberOfBins = m_NumberOfHistogramBins;
+  std::vector< SizeValueType >   fine(numberOfBins, 0);
+  std::vector< SizeValueType >   coarse( ( ( numberOfBins - 1 ) >> shift ) + 1, 0 );
+  const double                   minimum = m_HistogramMinimum;
+  const double                   scale = m_HistogramScale;
+  const SizeValueType            rowLength = outputRegionForThread.GetSize(0);
+  const SizeValueType            width = 2 * this->GetRadius()[0] + 1;
+  std::vector< OffsetValueType > lineOffsets;
+  std::vector< OffsetValueType > positionOffsets;
+  std::vector< SizeValueType >   bins;
+
+  ImageScanlineIterator< OutputImageType > it(output, outputRegionForThread);
+  while ( !it.IsAtEnd() )
+    {
+    this->ComputeRowOffsets(it.GetIndex(), rowLength, lineOffsets, positionOffsets);
+    const SizeValueType numberOfLines = lineOffsets.size();
+    const SizeValueType medianRank = numberOfLines * width / 2;
+
+    // Bins of the pixels of the lines of the neighborhood, at each
+    // position along the row.
+    bins.resize( numberOfLines * positionOffsets.size() );
+    for ( SizeValueType i = 0; i < positionOffsets.size(); ++i )
+      {
+      for ( SizeValueType l = 0; l < numberOfLines; ++l )
+        {
+        const double value = static_cast< double >( accessor.Get( buffer[lineOffsets[l] + positionOffsets[i]] ) );
+        const double bin = std::floor( ( value - minimum ) * scale );
+        // NaN goes to the first bin: casting it to an integer is undefined
+        bins[i * numberOfLines + l] = !( bin > 0.0 ) ? 0
+          : ( bin >= static_cast< double >( numberOfBins - 1 ) ? numberOfBins - 1
+              : static_cast< SizeValueType >( bin ) );
+        }
+      }
+
+    // The median is in coarse bin medianCoarse, above belowCount values.
+    SizeValueType medianCoarse = 0;
+    SizeValueType belowCount = 0;
+    for ( SizeValueType i = 0; i < width - 1; ++i )
+      {
+      for ( SizeValueType l = 0; l < numberOfLines; ++l )
+        {
+        const SizeValueType bin = bins[i * numberOfLines + l];
+        ++fine[bin];
+        ++coarse[bin >> shift];
+        }
+      }
+    for ( SizeValueType x = 0; !it.IsAtEndOfLine(); ++x, ++it )
+      {
+      // Add the pixels entering the neighborhood and remove those
+      // leaving it.
+      const SizeValueType *entering = &bins[( x + width - 1 ) * numberOfLines];
+      for ( SizeValueType l = 0; l < numberOfLines; ++l )
+        {
+        ++fine[entering[l]];
+        ++coarse[entering[l] >> shift];
+        belowCount += ( entering[l] >> shift ) < medianCoarse;
+        }
+      if ( x > 0 )
+        {
+        const SizeValueType *leaving = &bins[( x - 1 ) * numberOfLines];
+        for ( SizeValueType l = 0; l < numberOfLines; ++l )
+          {
+          --fine[leaving[l]];
+          --coarse[leaving[l] >> shift];
+          belowCount -= ( leaving[l] >> shift ) < medianCoarse;
+          }
+        }
+
+      while ( belowCount + coarse[medianCoarse] <= medianRank )
+        {
+        belowCount += coarse[medianCoarse];
+        ++medianCoarse;
+        }
+      while ( belowCount > medianRank )
+        {
+        --medianCoarse;
+        belowCount -= coarse[medianCoarse];
+        }
+      SizeValueType medianBin = medianCoarse << shift;
+      SizeValueType count = belowCount + fine[medianBin];
+      while ( count <= medianRank )
+        {
+        ++medianBin;
+        count += fine[medianBin];
+        }
+
+      const double value = minimum + ( medianBin + m_HistogramBinCenter ) / scale;
+      it.Set( static_cast< OutputPixelType >( static_cast< InputPixelType >( value ) ) );
+      progress.CompletedPixel();
+      }
+
+    // Empty the histogram for the next row.
+    for ( SizeValueType i = rowLength - 1; i < rowLength + width - 1; ++i )
+      {
+      for ( SizeValueType l = 0; l < numberOfLines; ++l )
+        {
+        const SizeValueType bin = bins[i * numberOfLines + l];
+        --fine[bin];
+        --coarse[bin >> shift];
+        }
+      }
+    it.NextLine();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::ComputeMediansBySelection(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId)
 {
   // Allocate output
   typename OutputImageType::Pointer output = this->GetOutput();
@@ -94,6 +479,17 @@ MedianImageFilter< TInputImage, TOutputImage >
       }
     }
 }
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseQuantization: " << m_UseQuantization << std::endl;
+  os << indent << "NumberOfQuantizationLevels: " << m_NumberOfQuantizationLevels << std::endl;
+}
 } // end namespace itk
 
 #endif
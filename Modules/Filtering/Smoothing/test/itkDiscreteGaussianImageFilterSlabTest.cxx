@@ -0,0 +1,167 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkDiscreteGaussianImageFilter.h"
+#include "itkGaussianOperator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkNeighborhoodOperatorImageFilter.h"
+#include "itkTestingMacros.h"
+
+// Compare the slab by slab convolution of images of scalar pixels with
+// a chain of NeighborhoodOperatorImageFilter, for several pixel types,
+// filter dimensionalities, requested regions and numbers of threads.
+namespace
+{
+template< typename TInputImage, typename TOutputImage >
+typename TOutputImage::Pointer
+ChainedConvolution(const TInputImage *input, const double variance[], unsigned int filterDimensionality)
+{
+  typedef typename itk::NumericTraits< typename TOutputImage::PixelType >::RealType RealType;
+  typedef itk::GaussianOperator< RealType, TInputImage::ImageDimension >           OperatorType;
+  typedef itk::NeighborhoodOperatorImageFilter< TInputImage, TOutputImage, RealType >  FirstFilterType;
+  typedef itk::NeighborhoodOperatorImageFilter< TOutputImage, TOutputImage, RealType > FilterType;
+
+  std::vector< OperatorType > operators(filterDimensionality);
+  for ( unsigned int i = 0; i < filterDimensionality; ++i )
+    {
+    operators[i].SetDirection(i);
+    const double spacing = input->GetSpacing()[i];
+    operators[i].SetVariance( variance[i] / ( spacing * spacing ) );
+    operators[i].SetMaximumKernelWidth(32);
+    operators[i].SetMaximumError(0.01);
+    operators[i].CreateDirectional();
+    }
+
+  // The last direction is filtered first.
+  typename FirstFilterType::Pointer first = FirstFilterType::New();
+  first->SetInput(input);
+  first->SetOperator( operators[filterDimensionality - 1] );
+  first->Update();
+  typename TOutputImage::Pointer output = first->GetOutput();
+  output->DisconnectPipeline();
+  for ( int i = static_cast< int >( filterDimensionality ) - 2; i >= 0; --i )
+    {
+    typename FilterType::Pointer filter = FilterType::New();
+    filter->SetInput(output);
+    filter->SetOperator(operators[i]);
+    filter->Update();
+    output = filter->GetOutput();
+    output->DisconnectPipeline();
+    }
+  return output;
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+CompareWithChainedConvolution(unsigned int filterDimensionality, bool subRegion,
+                              itk::ThreadIdType numberOfThreads, double tolerance)
+{
+  typedef itk::DiscreteGaussianImageFilter< TInputImage, TOutputImage > FilterType;
+
+  typename TInputImage::SizeType size;
+  size[0] = 61;
+  size[1] = 47;
+  size[2] = 29;
+  typename TInputImage::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 0.7;
+  spacing[2] = 2.0;
+  typename TInputImage::Pointer input = TInputImage::New();
+  input->SetRegions(size);
+  input->SetSpacing(spacing);
+  input->Allocate();
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(1234);
+  itk::ImageRegionIterator< TInputImage > it( input, input->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( static_cast< typename TInputImage::PixelType >( generator->GetUniformVariate(0.0, 1000.0) ) );
+    }
+
+  typename TOutputImage::RegionType requestedRegion = input->GetLargestPossibleRegion();
+  if ( subRegion )
+    {
+    requestedRegion.SetIndex(0, 3);
+    requestedRegion.SetIndex(1, 20);
+    requestedRegion.SetIndex(2, 1);
+    requestedRegion.SetSize(0, 40);
+    requestedRegion.SetSize(1, 27);
+    requestedRegion.SetSize(2, 12);
+    }
+
+  const double variance[3] = { 2.0, 1.0, 9.0 };
+  typename FilterType::ArrayType varianceArray;
+  for ( unsigned int i = 0; i < 3; ++i )
+    {
+    varianceArray[i] = variance[i];
+    }
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetVariance(varianceArray);
+  filter->SetMaximumError(0.01);
+  filter->SetMaximumKernelWidth(32);
+  filter->SetFilterDimensionality(filterDimensionality);
+  filter->SetNumberOfThreads(numberOfThreads);
+  filter->GetOutput()->SetRequestedRegion(requestedRegion);
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+
+  typename TOutputImage::Pointer expected =
+    ChainedConvolution< TInputImage, TOutputImage >(input, variance, filterDimensionality);
+
+  itk::ImageRegionConstIteratorWithIndex< TOutputImage > outIt(filter->GetOutput(), requestedRegion);
+  for ( outIt.GoToBegin(); !outIt.IsAtEnd(); ++outIt )
+    {
+    const double value = outIt.Get();
+    const double expectedValue = expected->GetPixel( outIt.GetIndex() );
+    if ( std::abs(value - expectedValue) > tolerance )
+      {
+      std::cerr << "Filter dimensionality " << filterDimensionality << ", "
+                << numberOfThreads << " threads: wrong value at " << outIt.GetIndex()
+                << ": " << value << " instead of " << expectedValue << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkDiscreteGaussianImageFilterSlabTest(int, char* [])
+{
+  typedef itk::Image< float, 3 > FloatImageType;
+  typedef itk::Image< short, 3 > ShortImageType;
+
+  bool passed = true;
+  for ( unsigned int filterDimensionality = 1; filterDimensionality <= 3; ++filterDimensionality )
+    {
+    passed &= CompareWithChainedConvolution< FloatImageType, FloatImageType >(filterDimensionality, false, 1, 1e-3);
+    passed &= CompareWithChainedConvolution< FloatImageType, FloatImageType >(filterDimensionality, true, 3, 1e-3);
+    passed &= CompareWithChainedConvolution< ShortImageType, ShortImageType >(filterDimensionality, true, 2, 1.0);
+    passed &= CompareWithChainedConvolution< ShortImageType, FloatImageType >(filterDimensionality, false, 4, 1e-3);
+    }
+
+  if ( !passed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,215 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMedianImageFilter.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Compare the medians computed with selection networks, with sliding
+// histograms and with quantized values to medians computed directly,
+// with the border of the image replicated.
+namespace
+{
+template< typename TImage >
+typename TImage::Pointer
+MakeRandomImage(const typename TImage::SizeType & size, double minimum, double maximum)
+{
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(2017);
+  itk::ImageRegionIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( static_cast< typename TImage::PixelType >( generator->GetUniformVariate(minimum, maximum) ) );
+    }
+  return image;
+}
+
+template< typename TImage >
+typename TImage::PixelType
+DirectMedian(const TImage *image, const typename TImage::IndexType & index,
+             const typename TImage::SizeType & radius)
+{
+  const unsigned int                   Dimension = TImage::ImageDimension;
+  const typename TImage::RegionType    region = image->GetLargestPossibleRegion();
+  typename TImage::RegionType          neighborhood;
+  for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+    neighborhood.SetIndex( d, index[d] - static_cast< itk::IndexValueType >( radius[d] ) );
+    neighborhood.SetSize(d, 2 * radius[d] + 1);
+    }
+  std::vector< typename TImage::PixelType > pixels;
+  typename TImage::IndexType neighbor = neighborhood.GetIndex();
+  while ( true )
+    {
+    typename TImage::IndexType clamped;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      clamped[d] = std::min( std::max( neighbor[d], region.GetIndex(d) ), region.GetUpperIndex()[d] );
+      }
+    pixels.push_back( image->GetPixel(clamped) );
+    unsigned int d = 0;
+    for (; d < Dimension; ++d )
+      {
+      if ( ++neighbor[d] <= neighborhood.GetUpperIndex()[d] )
+        {
+        break;
+        }
+      neighbor[d] = neighborhood.GetIndex(d);
+      }
+    if ( d == Dimension )
+      {
+      break;
+      }
+    }
+  std::nth_element( pixels.begin(), pixels.begin() + pixels.size() / 2, pixels.end() );
+  return pixels[pixels.size() / 2];
+}
+
+template< typename TImage >
+bool
+CheckMedians(const typename TImage::SizeType & size, double minimum, double maximum,
+             itk::SizeValueType radiusValue, bool useQuantization, double tolerance)
+{
+  typedef itk::MedianImageFilter< TImage, TImage > FilterType;
+
+  typename TImage::Pointer image = MakeRandomImage< TImage >(size, minimum, maximum);
+
+  typename TImage::SizeType radius;
+  radius.Fill(radiusValue);
+
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetRadius(radius);
+  filter->SetUseQuantization(useQuantization);
+  filter->SetNumberOfThreads(3);
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+
+  itk::ImageRegionIteratorWithIndex< TImage > it( filter->GetOutput(), image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double expected = DirectMedian< TImage >(image, it.GetIndex(), radius);
+    if ( std::abs(it.Get() - expected) > tolerance )
+      {
+      std::cerr << "Radius " << radiusValue << ": wrong median at " << it.GetIndex()
+                << ": " << static_cast< double >( it.Get() ) << " instead of " << expected << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// The NaN and infinite values must not change the quantization of the
+// other values, nor be cast to bins out of the histogram.
+bool
+CheckNonFiniteValues()
+{
+  typedef itk::Image< float, 2 >                   ImageType;
+  typedef itk::MedianImageFilter< ImageType, ImageType > FilterType;
+
+  ImageType::SizeType size;
+  size[0] = 40;
+  size[1] = 30;
+  ImageType::Pointer image = MakeRandomImage< ImageType >(size, -1.0, 1.0);
+
+  ImageType::IndexType index;
+  index[0] = 1;
+  index[1] = 1;
+  image->SetPixel( index, std::numeric_limits< float >::quiet_NaN() );
+  index[0] = 2;
+  image->SetPixel( index, std::numeric_limits< float >::infinity() );
+  index[1] = 2;
+  image->SetPixel( index, -std::numeric_limits< float >::infinity() );
+
+  ImageType::SizeType radius;
+  radius.Fill(2);
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetRadius(radius);
+  filter->UseQuantizationOn();
+  filter->SetNumberOfThreads(3);
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( filter->GetOutput(), image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if ( it.GetIndex()[0] <= 4 && it.GetIndex()[1] <= 4 )
+      {
+      continue;
+      }
+    const double expected = DirectMedian< ImageType >(image, it.GetIndex(), radius);
+    if ( std::abs(it.Get() - expected) > 2.0 / 65536 )
+      {
+      std::cerr << "Non finite values: wrong median at " << it.GetIndex()
+                << ": " << it.Get() << " instead of " << expected << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkMedianImageFilterAlgorithmsTest(int, char* [])
+{
+  typedef itk::Image< unsigned char, 2 > UCharImage2DType;
+  typedef itk::Image< float, 2 >         FloatImage2DType;
+  typedef itk::Image< short, 3 >         ShortImage3DType;
+  typedef itk::Image< float, 3 >         FloatImage3DType;
+
+  UCharImage2DType::SizeType size2D;
+  size2D[0] = 45;
+  size2D[1] = 31;
+  ShortImage3DType::SizeType size3D;
+  size3D[0] = 19;
+  size3D[1] = 14;
+  size3D[2] = 11;
+
+  bool passed = true;
+
+  // Selection networks: 3x3 and 3x3x3 neighborhoods.
+  passed &= CheckMedians< UCharImage2DType >(size2D, 0.0, 255.0, 1, false, 0.0);
+  passed &= CheckMedians< FloatImage2DType >(size2D, -1.0, 1.0, 1, false, 0.0);
+  passed &= CheckMedians< FloatImage3DType >(size3D, -1.0, 1.0, 1, false, 0.0);
+
+  // Sliding histograms of 8 and 16 bit integers.
+  passed &= CheckMedians< UCharImage2DType >(size2D, 0.0, 255.0, 4, false, 0.0);
+  passed &= CheckMedians< ShortImage3DType >(size3D, -30000.0, 30000.0, 2, false, 0.0);
+  passed &= CheckMedians< ShortImage3DType >(size3D, -5.0, 5.0, 3, false, 0.0);
+
+  // Partial sorts of floats, and quantized floats.
+  passed &= CheckMedians< FloatImage3DType >(size3D, -1.0, 1.0, 2, false, 0.0);
+  passed &= CheckMedians< FloatImage3DType >(size3D, -1.0, 1.0, 2, true, 2.0 / 65536);
+  passed &= CheckNonFiniteValues();
+
+  if ( !passed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
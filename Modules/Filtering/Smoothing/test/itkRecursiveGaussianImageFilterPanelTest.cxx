@@ -0,0 +1,144 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkRecursiveGaussianImageFilter.h"
+#include "itkTestingMacros.h"
+
+// Lines along directions other than 0 are filtered in panels of
+// interleaved lines. Compare them with the lines along direction 0 of
+// the image with the two directions swapped, which are filtered one by
+// one.
+namespace
+{
+typedef itk::Image< float, 3 > ImageType;
+
+ImageType::IndexType
+SwapAxes(ImageType::IndexType index, unsigned int direction)
+{
+  std::swap(index[0], index[direction]);
+  return index;
+}
+
+ImageType::Pointer
+SwapAxes(const ImageType *image, unsigned int direction)
+{
+  ImageType::SizeType    size = image->GetLargestPossibleRegion().GetSize();
+  ImageType::SpacingType spacing = image->GetSpacing();
+  std::swap(size[0], size[direction]);
+  std::swap(spacing[0], spacing[direction]);
+
+  ImageType::Pointer swapped = ImageType::New();
+  swapped->SetRegions(size);
+  swapped->SetSpacing(spacing);
+  swapped->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( swapped, swapped->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( image->GetPixel( SwapAxes(it.GetIndex(), direction) ) );
+    }
+  return swapped;
+}
+
+template< typename TOutputImage >
+bool
+CompareDirections(const ImageType *image, unsigned int direction,
+                  int order,
+                  itk::ThreadIdType numberOfThreads, double tolerance)
+{
+  typedef itk::RecursiveGaussianImageFilter< ImageType, TOutputImage > FilterType;
+
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetDirection(direction);
+  filter->SetSigma(2.5);
+  filter->SetOrder( static_cast< typename FilterType::OrderEnumType >( order ) );
+  filter->SetNumberOfThreads(numberOfThreads);
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+
+  ImageType::Pointer swapped = SwapAxes(image, direction);
+  typename FilterType::Pointer lineFilter = FilterType::New();
+  lineFilter->SetInput(swapped);
+  lineFilter->SetDirection(0);
+  lineFilter->SetSigma(2.5);
+  lineFilter->SetOrder( static_cast< typename FilterType::OrderEnumType >( order ) );
+  TRY_EXPECT_NO_EXCEPTION( lineFilter->Update() );
+
+  itk::ImageRegionIteratorWithIndex< TOutputImage > it( filter->GetOutput(),
+                                                        filter->GetOutput()->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double value = it.Get();
+    const double expected = lineFilter->GetOutput()->GetPixel( SwapAxes(it.GetIndex(), direction) );
+    if ( std::abs(value - expected) > tolerance )
+      {
+      std::cerr << "Direction " << direction << ", order " << order << ", " << numberOfThreads
+                << " threads: wrong value at " << it.GetIndex() << ": " << value
+                << " instead of " << expected << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkRecursiveGaussianImageFilterPanelTest(int, char* [])
+{
+  typedef itk::Image< short, 3 > ShortImageType;
+  typedef itk::RecursiveGaussianImageFilter< ImageType, ImageType > FilterType;
+
+  // The rows are not a whole number of panels.
+  ImageType::SizeType size;
+  size[0] = 37;
+  size[1] = 23;
+  size[2] = 19;
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 0.8;
+  spacing[2] = 1.5;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->Allocate();
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(4321);
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( static_cast< float >( generator->GetUniformVariate(-100.0, 100.0) ) );
+    }
+
+  bool passed = true;
+  for ( unsigned int direction = 1; direction < 3; ++direction )
+    {
+    passed &= CompareDirections< ImageType >(image, direction, FilterType::ZeroOrder, 1, 1e-4);
+    passed &= CompareDirections< ImageType >(image, direction, FilterType::FirstOrder, 3, 1e-4);
+    passed &= CompareDirections< ImageType >(image, direction, FilterType::SecondOrder, 2, 1e-4);
+    passed &= CompareDirections< ShortImageType >(image, direction, FilterType::ZeroOrder, 4, 0.0);
+    }
+
+  if ( !passed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -66,6 +66,13 @@ namespace itk
  *             the MetaDataDictionary some fields are converted to ASCII (only VR: OB/OW/OF and UN are encoded as
  *             mime64).
  *
+ *  Reading supports streaming: when only a region of the image is
+ *  requested, only the rows and frames of that region are read, and for
+ *  encapsulated (JPEG, JPEG-LS, JPEG 2000, RLE) transfer syntaxes only the
+ *  frames overlapping the region are decoded. Frames of multi-frame objects
+ *  are decoded in parallel. Palette color and planar configuration 1 images
+ *  are always read in full.
+ *
  *  \ingroup IOFilters
  *
  * \ingroup ITKIOGDCM
@@ -101,6 +108,15 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer) ITK_OVERRIDE;
 
+  /** Determine if the ImageIO can stream reading from the current
+   * file. ReadImageInformation must be called prior to this function. */
+  virtual bool CanStreamRead() ITK_OVERRIDE;
+
+  /** Return the requested region when streamed reading is enabled and
+   * the file supports it, the largest possible region otherwise. */
+  virtual ImageIORegion
+  GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requested) const ITK_OVERRIDE;
+
   /** Set/Get the original component type of the image. This differs from
    * ComponentType which may change as a function of rescale slope and
    * intercept. */
@@ -265,6 +281,14 @@ protected:
 
   void InternalReadImageInformation();
 
+  /** Read the whole image, applying palette, planar configuration and
+   * rescale conversions. */
+  void ReadWholeImage(void *buffer);
+
+  /** Read the current IORegion only, decoding frames in parallel.
+   * Returns false when GDCM cannot extract the region from the file. */
+  bool ReadRegion(void *buffer);
+
   double m_RescaleSlope;
   double m_RescaleIntercept;
 
@@ -306,6 +330,11 @@ private:
 
   ImageIOBase::IOComponentType m_InternalComponentType;
   InternalHeader *             m_DICOMHeader;
+
+  /** Whether the pixel data of the current file can be read by region,
+   * and whether its frames are individually compressed. */
+  bool m_RegionReadable;
+  bool m_EncapsulatedPixelData;
 };
 } // end namespace itk
 
@@ -32,7 +32,9 @@ namespace itk
  *
  * This class generates a sequence of files whose filenames point to
  * a DICOM file. The ordering is based on the following strategy:
- * Read all images in the directory (assuming there is only one study/series)
+ * Read, in parallel, the headers of all images in the directory, only as
+ * far as the elements used for grouping and ordering (assuming there is only
+ * one study/series)
  *
  *   1. Extract Image Orientation & Image Position from DICOM images, and then
  *      calculate the ordering based on the 3D coordinate of the slice.
@@ -155,11 +157,19 @@ public:
    * tags to take into account for subrefining a set of DICOM files into multiple
    * series. Format for tag is "group|element" of a DICOM tag.
    * \warning User need to set SetUseSeriesDetails(true)
+   * \warning Restrictions must be added before SetInputDirectory(), which
+   * parses the headers only as far as the series grouping needs.
    */
-  void AddSeriesRestriction(const std::string & tag)
-  {
-    m_SerieHelper->AddRestriction(tag);
-  }
+  void AddSeriesRestriction(const std::string & tag);
+
+  /** Set/Get the file used to keep the parsed headers between runs.
+   * Files whose size and modification time did not change since they
+   * were cached are not opened again, which makes rescanning a large
+   * directory almost instantaneous. The cache may be shared between
+   * directories. Empty (the default) disables the cache.
+   */
+  itkSetStringMacro(HeaderCacheFileName);
+  itkGetStringMacro(HeaderCacheFileName);
 
   /** Parse any sequences in the DICOM file. Defaults to false
    *  to skip sequences. This makes loading DICOM files faster when
@@ -205,6 +215,8 @@ private:
   bool m_Recursive;
   bool m_LoadSequences;
   bool m_LoadPrivateTags;
+
+  std::string m_HeaderCacheFileName;
 };
 } //namespace ITK
 
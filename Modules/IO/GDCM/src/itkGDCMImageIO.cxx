@@ -31,6 +31,7 @@
 #include "itkIOCommon.h"
 #include "itkArray.h"
 #include "itkByteSwapper.h"
+#include "itkMultiThreader.h"
 #include "vnl/vnl_cross.h"
 
 #include "itkMetaDataObject.h"
@@ -47,12 +48,15 @@
 #include "gdcmImageChangePlanarConfiguration.h"
 #include "gdcmRescaler.h"
 #include "gdcmImageReader.h"
+#include "gdcmImageRegionReader.h"
+#include "gdcmBoxRegion.h"
 #include "gdcmImageWriter.h"
 #include "gdcmUIDGenerator.h"
 #include "gdcmAttribute.h"
 #include "gdcmGlobal.h"
 #include "gdcmMediaStorage.h"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -67,8 +71,65 @@ public:
     delete m_Header;
   }
   gdcm::File *m_Header;
+  // pixel format of the stored values, before rescaling
+  gdcm::PixelFormat m_PixelFormat;
 };
 
+namespace
+{
+/** Shared state for reading a region of a file, the frames of which are
+ * split among the threads. */
+struct RegionReadStruct
+{
+  std::string        FileName;
+  unsigned int       XMin;
+  unsigned int       XMax;
+  unsigned int       YMin;
+  unsigned int       YMax;
+  unsigned int       ZMin;
+  unsigned int       ZMax;
+  char *             Buffer;
+  SizeValueType      FrameSizeInBytes;
+  std::vector< int > Success;
+};
+
+/** Each thread opens its own reader, so that the codecs decoding the
+ * frames of the thread do not share any state with the other threads. */
+ITK_THREAD_RETURN_TYPE
+RegionReadThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  RegionReadStruct *str = static_cast< RegionReadStruct * >( info->UserData );
+
+  const unsigned int numberOfFrames = str->ZMax - str->ZMin + 1;
+  const unsigned int begin = str->ZMin
+    + static_cast< unsigned int >( numberOfFrames * info->ThreadID / info->NumberOfThreads );
+  const unsigned int end = str->ZMin
+    + static_cast< unsigned int >( numberOfFrames * ( info->ThreadID + 1 ) / info->NumberOfThreads );
+  if ( begin == end )
+    {
+    str->Success[info->ThreadID] = 1;
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  gdcm::ImageRegionReader reader;
+  reader.SetFileName( str->FileName.c_str() );
+  if ( !reader.ReadInformation() )
+    {
+    str->Success[info->ThreadID] = 0;
+    return ITK_THREAD_RETURN_VALUE;
+    }
+  gdcm::BoxRegion box;
+  box.SetDomain(str->XMin, str->XMax, str->YMin, str->YMax, begin, end - 1);
+  reader.SetRegion(box);
+  char *frames = str->Buffer + ( begin - str->ZMin ) * str->FrameSizeInBytes;
+  str->Success[info->ThreadID] =
+    reader.ReadIntoBuffer( frames, reader.ComputeBufferLength() ) ? 1 : 0;
+  return ITK_THREAD_RETURN_VALUE;
+}
+} // end anonymous namespace
+
 GDCMImageIO::GDCMImageIO()
 {
   this->m_DICOMHeader = new InternalHeader;
@@ -93,6 +154,9 @@ GDCMImageIO::GDCMImageIO()
 
   m_InternalComponentType = UNKNOWNCOMPONENTTYPE;
 
+  m_RegionReadable = false;
+  m_EncapsulatedPixelData = false;
+
   // by default assume that images will be 2D.
   // This number is updated according the information
   // received through the MetaDataDictionary
@@ -185,6 +249,21 @@ bool GDCMImageIO::CanReadFile(const char *filename)
   return false;
 }
 
+bool GDCMImageIO::CanStreamRead()
+{
+  return m_RegionReadable;
+}
+
+ImageIORegion
+GDCMImageIO::GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requested) const
+{
+  if ( !m_UseStreamedReading || !m_RegionReadable )
+    {
+    return Superclass::GenerateStreamableReadRegionFromRequestedRegion(requested);
+    }
+  return requested;
+}
+
 void GDCMImageIO::Read(void *pointer)
 {
   // ensure file can be opened for reading, before doing any more work
@@ -193,6 +272,124 @@ void GDCMImageIO::Read(void *pointer)
   this->OpenFileForReading( inputFileStream, m_FileName );
   inputFileStream.close();
 
+  // a region of lower dimension than the file selects the first slice
+  const ImageIORegion & region = this->GetIORegion();
+  bool wholeImage = true;
+  for ( unsigned int i = 0; i < 3; ++i )
+    {
+    const bool inRegion = i < region.GetImageDimension();
+    const ImageIORegion::IndexValueType index = inRegion ? region.GetIndex(i) : 0;
+    const ImageIORegion::SizeValueType  size = inRegion ? region.GetSize(i) : 1;
+    wholeImage = wholeImage && index == 0 && size == m_Dimensions[i];
+    }
+
+  if ( wholeImage )
+    {
+    this->ReadWholeImage(pointer);
+    return;
+    }
+  if ( m_RegionReadable && this->ReadRegion(pointer) )
+    {
+    return;
+    }
+
+  // GDCM could not extract the region by itself: read everything and
+  // copy the rows of the region.
+  itkDebugMacro(<< "Reading whole image to extract region " << region);
+  const SizeValueType pixelSize = this->GetComponentSize() * this->GetNumberOfComponents();
+  const SizeValueType rowSize = m_Dimensions[0] * pixelSize;
+  const SizeValueType frameSize = m_Dimensions[1] * rowSize;
+  std::vector< char > wholeBuffer( frameSize * m_Dimensions[2] );
+  this->ReadWholeImage( &wholeBuffer[0] );
+
+  const SizeValueType regionRowSize = region.GetSize(0) * pixelSize;
+  const SizeValueType numberOfRows = region.GetImageDimension() > 1 ? region.GetSize(1) : 1;
+  const SizeValueType numberOfFrames = region.GetImageDimension() > 2 ? region.GetSize(2) : 1;
+  const SizeValueType y0 = region.GetImageDimension() > 1 ? region.GetIndex(1) : 0;
+  const SizeValueType z0 = region.GetImageDimension() > 2 ? region.GetIndex(2) : 0;
+  char *out = static_cast< char * >( pointer );
+  for ( SizeValueType z = 0; z < numberOfFrames; ++z )
+    {
+    for ( SizeValueType y = 0; y < numberOfRows; ++y )
+      {
+      const char *in = &wholeBuffer[0] + ( z0 + z ) * frameSize + ( y0 + y ) * rowSize
+                       + region.GetIndex(0) * pixelSize;
+      std::copy(in, in + regionRowSize, out);
+      out += regionRowSize;
+      }
+    }
+}
+
+bool GDCMImageIO::ReadRegion(void *pointer)
+{
+  const ImageIORegion & region = this->GetIORegion();
+  const unsigned int    regionDimension = region.GetImageDimension();
+
+  RegionReadStruct str;
+  str.FileName = m_FileName;
+  str.XMin = static_cast< unsigned int >( region.GetIndex(0) );
+  str.XMax = static_cast< unsigned int >( region.GetIndex(0) + region.GetSize(0) - 1 );
+  str.YMin = 0;
+  str.YMax = 0;
+  str.ZMin = 0;
+  str.ZMax = 0;
+  if ( regionDimension > 1 )
+    {
+    str.YMin = static_cast< unsigned int >( region.GetIndex(1) );
+    str.YMax = static_cast< unsigned int >( region.GetIndex(1) + region.GetSize(1) - 1 );
+    }
+  if ( regionDimension > 2 )
+    {
+    str.ZMin = static_cast< unsigned int >( region.GetIndex(2) );
+    str.ZMax = static_cast< unsigned int >( region.GetIndex(2) + region.GetSize(2) - 1 );
+    }
+
+  const gdcm::PixelFormat & pixeltype = m_DICOMHeader->m_PixelFormat;
+  const SizeValueType numberOfPixels =
+    static_cast< SizeValueType >( str.XMax - str.XMin + 1 ) * ( str.YMax - str.YMin + 1 ) * ( str.ZMax - str.ZMin + 1 );
+  const SizeValueType len = numberOfPixels * pixeltype.GetPixelSize();
+  str.FrameSizeInBytes =
+    static_cast< SizeValueType >( str.XMax - str.XMin + 1 ) * ( str.YMax - str.YMin + 1 ) * pixeltype.GetPixelSize();
+  str.Buffer = static_cast< char * >( pointer );
+
+  // Uncompressed frames are bound by the file system, compressed frames
+  // by their decoding: only the latter are worth spreading over threads.
+  ThreadIdType numberOfThreads = 1;
+  if ( m_EncapsulatedPixelData )
+    {
+    numberOfThreads = std::min< ThreadIdType >( MultiThreader::GetGlobalDefaultNumberOfThreads(),
+                                                str.ZMax - str.ZMin + 1 );
+    }
+  str.Success.resize(numberOfThreads, 0);
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(RegionReadThreaderCallback, &str);
+  threader->SingleMethodExecute();
+  for ( ThreadIdType i = 0; i < numberOfThreads; ++i )
+    {
+    if ( !str.Success[i] )
+      {
+      return false;
+      }
+    }
+
+  if ( m_RescaleSlope != 1.0 || m_RescaleIntercept != 0.0 )
+    {
+    gdcm::Rescaler r;
+    r.SetIntercept(m_RescaleIntercept);
+    r.SetSlope(m_RescaleSlope);
+    r.SetPixelFormat(pixeltype);
+    char *copy = new char[len];
+    memcpy(copy, (char *)pointer, len);
+    r.Rescale( (char *)pointer, copy, len );
+    delete[] copy;
+    }
+  return true;
+}
+
+void GDCMImageIO::ReadWholeImage(void *pointer)
+{
   itkAssertInDebugAndIgnoreInReleaseMacro( gdcm::ImageHelper::GetForceRescaleInterceptSlope() );
   gdcm::ImageReader reader;
   reader.SetFileName( m_FileName.c_str() );
@@ -292,6 +489,20 @@ void GDCMImageIO::InternalReadImageInformation()
   const unsigned int *  dims = image.GetDimensions();
 
   const gdcm::PixelFormat & pixeltype = image.GetPixelFormat();
+  m_DICOMHeader->m_PixelFormat = pixeltype;
+
+  // gdcm::ImageRegionReader only supports byte aligned pixels stored
+  // without palette, in pixel interleaved order, in a seekable stream.
+  const gdcm::TransferSyntax &                ts = image.GetTransferSyntax();
+  const gdcm::PhotometricInterpretation::PIType photometric = image.GetPhotometricInterpretation();
+  m_EncapsulatedPixelData = ts.IsEncapsulated();
+  m_RegionReadable = ( photometric == gdcm::PhotometricInterpretation::MONOCHROME1
+                       || photometric == gdcm::PhotometricInterpretation::MONOCHROME2
+                       || photometric == gdcm::PhotometricInterpretation::RGB )
+                     && image.GetPlanarConfiguration() == 0
+                     && pixeltype.GetBitsAllocated() % 8 == 0
+                     && ts != gdcm::TransferSyntax::DeflatedExplicitVRLittleEndian;
+
   switch ( pixeltype )
     {
     case gdcm::PixelFormat::INT8:
@@ -21,18 +21,375 @@
 #include "itkGDCMSeriesFileNames.h"
 #include "itksys/SystemTools.hxx"
 #include "itkProgressReporter.h"
+#include "itkMultiThreader.h"
+#include "itkIntTypes.h"
+#include "gdcmDirectory.h"
+#include "gdcmReader.h"
+#include "gdcmWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
 
 namespace itk
 {
+namespace
+{
+const char * const HeaderCacheSignature = "ITKGDCMSeriesHeaderCache 1\n";
+
+/** What the header cache remembers about one file. An empty Header
+ * marks a file that is not a DICOM image. */
+struct HeaderCacheRecord
+{
+  HeaderCacheRecord():
+    Length(0),
+    ModifiedTime(0)
+  {}
+
+  unsigned long Length;
+  long int      ModifiedTime;
+  std::string   Header;
+};
+
+typedef std::map< std::string, HeaderCacheRecord > HeaderCacheType;
+
+/** Result of the header scan of one file. */
+struct HeaderScanEntry
+{
+  HeaderScanEntry():
+    Length(0),
+    ModifiedTime(0),
+    Parsed(false)
+  {}
+
+  std::string                              FileName;
+  unsigned long                            Length;
+  long int                                 ModifiedTime;
+  gdcm::SmartPointer< gdcm::FileWithName > File;
+  std::string                              Header;
+  bool                                     Parsed;
+};
+
+struct HeaderScanStruct
+{
+  std::vector< HeaderScanEntry > *Entries;
+  const HeaderCacheType          *Cache;
+  gdcm::Tag                       StopTag;
+};
+
+/** Parse the header of filename up to and including stopTag. The
+ * Pixel Data element is never read. Returns a null pointer when the
+ * file is not a DICOM image. */
+gdcm::SmartPointer< gdcm::FileWithName >
+ReadImageHeader(std::string const & filename, const gdcm::Tag & stopTag)
+{
+  const gdcm::Tag pixelDataTag(0x7fe0, 0x0010);
+  std::set< gdcm::Tag > skipTags;
+  skipTags.insert(pixelDataTag);
+
+  gdcm::SmartPointer< gdcm::FileWithName > f;
+  gdcm::Reader reader;
+  reader.SetFileName( filename.c_str() );
+  if ( !reader.ReadUpToTag(stopTag, skipTags) )
+    {
+    return f;
+    }
+  // Only accept DICOM files describing an image, as gdcm::SerieHelper
+  // does through gdcm::ImageReader.
+  const gdcm::DataSet & ds = reader.GetFile().GetDataSet();
+  if ( !ds.FindDataElement( gdcm::Tag(0x0028, 0x0010) )
+       || !ds.FindDataElement( gdcm::Tag(0x0028, 0x0011) ) )
+    {
+    return f;
+    }
+  // Enhanced multi-frame objects have no Image Position (Patient) at
+  // the top level; their geometry lives in the functional group
+  // sequences, right before the Pixel Data.
+  if ( !ds.FindDataElement( gdcm::Tag(0x0020, 0x0032) ) && stopTag < pixelDataTag )
+    {
+    return ReadImageHeader(filename, pixelDataTag);
+    }
+  f = new gdcm::FileWithName( reader.GetFile() );
+  f->filename = filename;
+  return f;
+}
+
+/** Serialize a parsed header so that it can be stored in the cache.
+ * Returns an empty string if gdcm cannot write it back. */
+std::string EncodeImageHeader(gdcm::FileWithName & file)
+{
+  std::ostringstream os;
+  gdcm::Writer writer;
+  writer.SetStream(os);
+  writer.SetFile(file);
+  writer.SetCheckFileMetaInformation(false);
+  if ( !writer.Write() )
+    {
+    return std::string();
+    }
+  return os.str();
+}
+
+gdcm::SmartPointer< gdcm::FileWithName >
+DecodeImageHeader(std::string const & filename, std::string const & header)
+{
+  gdcm::SmartPointer< gdcm::FileWithName > f;
+  std::istringstream is(header);
+  gdcm::Reader reader;
+  reader.SetStream(is);
+  if ( reader.Read() )
+    {
+    f = new gdcm::FileWithName( reader.GetFile() );
+    f->filename = filename;
+    }
+  return f;
+}
+
+ITK_THREAD_RETURN_TYPE HeaderScanThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  HeaderScanStruct *str = static_cast< HeaderScanStruct * >( info->UserData );
+
+  std::vector< HeaderScanEntry > & entries = *str->Entries;
+  const size_t numberOfEntries = entries.size();
+  const size_t begin = numberOfEntries * info->ThreadID / info->NumberOfThreads;
+  const size_t end = numberOfEntries * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+
+  for ( size_t i = begin; i < end; ++i )
+    {
+    HeaderScanEntry & entry = entries[i];
+    if ( str->Cache )
+      {
+      entry.Length = itksys::SystemTools::FileLength(entry.FileName);
+      entry.ModifiedTime = itksys::SystemTools::ModifiedTime(entry.FileName);
+
+      HeaderCacheType::const_iterator cached = str->Cache->find(entry.FileName);
+      if ( cached != str->Cache->end()
+           && cached->second.Length == entry.Length
+           && cached->second.ModifiedTime == entry.ModifiedTime )
+        {
+        if ( cached->second.Header.empty() )
+          {
+          continue;
+          }
+        entry.File = DecodeImageHeader(entry.FileName, cached->second.Header);
+        if ( entry.File )
+          {
+          entry.Header = cached->second.Header;
+          continue;
+          }
+        }
+      }
+
+    entry.Parsed = true;
+    entry.File = ReadImageHeader(entry.FileName, str->StopTag);
+    if ( str->Cache && entry.File )
+      {
+      entry.Header = EncodeImageHeader(*entry.File);
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/** \class SerieHeaderHelper
+ * gdcm::SerieHelper parses every file completely, Pixel Data
+ * included, although grouping and sorting a series only needs a
+ * handful of header elements. This helper parses the files in
+ * parallel, stops at the last element it needs, and optionally keeps
+ * the parsed headers in an on-disk cache keyed by file path, size and
+ * modification time.
+ */
+class SerieHeaderHelper : public gdcm::SerieHelper
+{
+public:
+  SerieHeaderHelper()
+  {
+    // Series UID, the series details added by
+    // CreateDefaultUniqueSeriesIdentifier(), and what the ordering
+    // strategies look at.
+    m_HeaderTags.insert( gdcm::Tag(0x0020, 0x000e) );
+    m_HeaderTags.insert( gdcm::Tag(0x0020, 0x0011) );
+    m_HeaderTags.insert( gdcm::Tag(0x0018, 0x0024) );
+    m_HeaderTags.insert( gdcm::Tag(0x0018, 0x0050) );
+    m_HeaderTags.insert( gdcm::Tag(0x0020, 0x0013) );
+    m_HeaderTags.insert( gdcm::Tag(0x0020, 0x0032) );
+    m_HeaderTags.insert( gdcm::Tag(0x0020, 0x0037) );
+    m_HeaderTags.insert( gdcm::Tag(0x0028, 0x0010) );
+    m_HeaderTags.insert( gdcm::Tag(0x0028, 0x0011) );
+  }
+
+  /** Make sure the header is parsed at least up to tag. */
+  void AddHeaderTag(std::string const & tag)
+  {
+    gdcm::Tag t;
+    if ( t.ReadFromPipeSeparatedString( tag.c_str() ) )
+      {
+      m_HeaderTags.insert(t);
+      }
+  }
+
+  /** Scan dir. Returns false if cacheFileName is not empty and the
+   * cache could not be written. */
+  bool SetHeaderDirectory(std::string const & dir, bool recursive,
+                          std::string const & cacheFileName)
+  {
+    gdcm::Directory dirList;
+    dirList.Load(dir, recursive);
+
+    gdcm::Directory::FilenamesType const & filenames = dirList.GetFilenames();
+    std::vector< HeaderScanEntry > entries( filenames.size() );
+    for ( size_t i = 0; i < filenames.size(); ++i )
+      {
+      entries[i].FileName = filenames[i];
+      }
+
+    const gdcm::Tag stopTag = *m_HeaderTags.rbegin();
+    const bool useCache = !cacheFileName.empty();
+    HeaderCacheType cache;
+    if ( useCache )
+      {
+      ReadHeaderCache(cacheFileName, stopTag, cache);
+      }
+
+    if ( !entries.empty() )
+      {
+      HeaderScanStruct str;
+      str.Entries = &entries;
+      str.Cache = useCache ? &cache : ITK_NULLPTR;
+      str.StopTag = stopTag;
+
+      MultiThreader::Pointer threader = MultiThreader::New();
+      threader->SetNumberOfThreads(
+        static_cast< ThreadIdType >( std::min< size_t >(
+          entries.size(), MultiThreader::GetGlobalDefaultNumberOfThreads() ) ) );
+      threader->SetSingleMethod(HeaderScanThreaderCallback, &str);
+      threader->SingleMethodExecute();
+      }
+
+    // Add the files in directory order, so that the result does not
+    // depend on the number of threads.
+    bool cacheModified = false;
+    for ( size_t i = 0; i < entries.size(); ++i )
+      {
+      HeaderScanEntry & entry = entries[i];
+      if ( entry.File )
+        {
+        this->AddFile(*entry.File);
+        }
+      if ( useCache && entry.Parsed )
+        {
+        cacheModified = true;
+        if ( entry.File && entry.Header.empty() )
+          {
+          cache.erase(entry.FileName);
+          continue;
+          }
+        HeaderCacheRecord & record = cache[entry.FileName];
+        record.Length = entry.Length;
+        record.ModifiedTime = entry.ModifiedTime;
+        record.Header = entry.Header;
+        }
+      }
+
+    if ( cacheModified )
+      {
+      return WriteHeaderCache(cacheFileName, stopTag, cache);
+      }
+    return true;
+  }
+
+private:
+  /** The cache is only used if it was written for headers parsed at
+   * least as far as stopTag. */
+  static void ReadHeaderCache(std::string const & fileName, const gdcm::Tag & stopTag,
+                              HeaderCacheType & cache)
+  {
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+    if ( !file )
+      {
+      return;
+      }
+    const std::string signature(HeaderCacheSignature);
+    std::string buffer( signature.size(), '\0' );
+    uint32_t cacheStopTag = 0;
+    if ( !file.read( &buffer[0], buffer.size() ) || buffer != signature
+         || !file.read( reinterpret_cast< char * >( &cacheStopTag ), sizeof( cacheStopTag ) )
+         || cacheStopTag < stopTag.GetElementTag() )
+      {
+      return;
+      }
+
+    uint32_t nameLength;
+    while ( file.read( reinterpret_cast< char * >( &nameLength ), sizeof( nameLength ) ) )
+      {
+      std::string name(nameLength, '\0');
+      uint64_t length;
+      int64_t  modifiedTime;
+      uint32_t headerLength;
+      if ( !file.read( &name[0], nameLength )
+           || !file.read( reinterpret_cast< char * >( &length ), sizeof( length ) )
+           || !file.read( reinterpret_cast< char * >( &modifiedTime ), sizeof( modifiedTime ) )
+           || !file.read( reinterpret_cast< char * >( &headerLength ), sizeof( headerLength ) ) )
+        {
+        break;
+        }
+      HeaderCacheRecord record;
+      record.Length = static_cast< unsigned long >( length );
+      record.ModifiedTime = static_cast< long int >( modifiedTime );
+      record.Header.resize(headerLength);
+      if ( headerLength > 0 && !file.read( &record.Header[0], headerLength ) )
+        {
+        break;
+        }
+      cache[name] = record;
+      }
+  }
+
+  static bool WriteHeaderCache(std::string const & fileName, const gdcm::Tag & stopTag,
+                               HeaderCacheType const & cache)
+  {
+    std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if ( !file )
+      {
+      return false;
+      }
+    const uint32_t cacheStopTag = stopTag.GetElementTag();
+    file.write( HeaderCacheSignature, std::strlen(HeaderCacheSignature) );
+    file.write( reinterpret_cast< const char * >( &cacheStopTag ), sizeof( cacheStopTag ) );
+    for ( HeaderCacheType::const_iterator it = cache.begin(); it != cache.end(); ++it )
+      {
+      const uint32_t nameLength = static_cast< uint32_t >( it->first.size() );
+      const uint64_t length = it->second.Length;
+      const int64_t  modifiedTime = it->second.ModifiedTime;
+      const uint32_t headerLength = static_cast< uint32_t >( it->second.Header.size() );
+      file.write( reinterpret_cast< const char * >( &nameLength ), sizeof( nameLength ) );
+      file.write( it->first.c_str(), nameLength );
+      file.write( reinterpret_cast< const char * >( &length ), sizeof( length ) );
+      file.write( reinterpret_cast< const char * >( &modifiedTime ), sizeof( modifiedTime ) );
+      file.write( reinterpret_cast< const char * >( &headerLength ), sizeof( headerLength ) );
+      file.write( it->second.Header.c_str(), headerLength );
+      }
+    return static_cast< bool >( file );
+  }
+
+  std::set< gdcm::Tag > m_HeaderTags;
+};
+} // end anonymous namespace
+
 GDCMSeriesFileNames::GDCMSeriesFileNames()
 {
-  m_SerieHelper = new gdcm::SerieHelper();
+  m_SerieHelper = new SerieHeaderHelper();
   m_InputDirectory = "";
   m_OutputDirectory = "";
   m_UseSeriesDetails = true;
   m_Recursive = false;
   m_LoadSequences = false;
   m_LoadPrivateTags = false;
+  m_HeaderCacheFileName = "";
 }
 
 GDCMSeriesFileNames::~GDCMSeriesFileNames()
@@ -80,11 +437,21 @@ void GDCMSeriesFileNames::SetInputDirectory(std::string const & name)
   m_SerieHelper->SetUseSeriesDetails(m_UseSeriesDetails);
   m_SerieHelper->SetLoadMode( ( m_LoadSequences ? 0 : gdcm::LD_NOSEQ )
                               | ( m_LoadPrivateTags ? 0 : gdcm::LD_NOSHADOW ) );
-  m_SerieHelper->SetDirectory(name, m_Recursive);
+  if ( !static_cast< SerieHeaderHelper * >( m_SerieHelper )
+       ->SetHeaderDirectory(name, m_Recursive, m_HeaderCacheFileName) )
+    {
+    itkWarningMacro(<< "Could not write the header cache " << m_HeaderCacheFileName);
+    }
   //as a side effect it also execute
   this->Modified();
 }
 
+void GDCMSeriesFileNames::AddSeriesRestriction(const std::string & tag)
+{
+  m_SerieHelper->AddRestriction(tag);
+  static_cast< SerieHeaderHelper * >( m_SerieHelper )->AddHeaderTag(tag);
+}
+
 const GDCMSeriesFileNames::SeriesUIDContainerType & GDCMSeriesFileNames::GetSeriesUIDs()
 {
   m_SeriesUIDs.clear();
@@ -286,6 +653,7 @@ void GDCMSeriesFileNames::PrintSelf(std::ostream & os, Indent indent) const
   os << indent << "InputDirectory: " << m_InputDirectory << std::endl;
   os << indent << "LoadSequences:" << m_LoadSequences << std::endl;
   os << indent << "LoadPrivateTags:" << m_LoadPrivateTags << std::endl;
+  os << indent << "HeaderCacheFileName: " << m_HeaderCacheFileName << std::endl;
   if ( m_Recursive )
     {
     os << indent << "Recursive: True" << std::endl;
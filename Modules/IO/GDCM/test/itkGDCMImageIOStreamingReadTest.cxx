@@ -0,0 +1,128 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkGDCMImageIO.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMetaDataObject.h"
+#include "itkTestingMacros.h"
+
+// Write a multi-frame DICOM object, then read a region of it back
+// with streaming, for raw and encapsulated transfer syntaxes.
+namespace
+{
+typedef short                               PixelType;
+typedef itk::Image< PixelType, 3 >          ImageType;
+typedef itk::ImageFileReader< ImageType >   ReaderType;
+typedef itk::ImageFileWriter< ImageType >   WriterType;
+
+PixelType
+ExpectedValue(const ImageType::IndexType & idx)
+{
+  return static_cast< PixelType >( idx[2] * 100 + idx[1] * 10 + idx[0] );
+}
+
+int
+WriteAndReadRegion(const std::string & fileName, bool useCompression,
+                   itk::GDCMImageIO::TCompressionType compressionType)
+{
+  ImageType::SizeType size;
+  size[0] = 16;
+  size[1] = 12;
+  size[2] = 6;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it(image, image->GetLargestPossibleRegion());
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( ExpectedValue( it.GetIndex() ) );
+    }
+  // multi-frame MR image
+  itk::EncapsulateMetaData< std::string >( image->GetMetaDataDictionary(), "0008|0016", "1.2.840.10008.5.1.4.1.1.4" );
+
+  itk::GDCMImageIO::Pointer writeIO = itk::GDCMImageIO::New();
+  writeIO->SetCompressionType(compressionType);
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetImageIO(writeIO);
+  writer->SetFileName(fileName);
+  writer->SetInput(image);
+  writer->SetUseCompression(useCompression);
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+
+  ImageType::RegionType region;
+  region.SetIndex(0, 3);
+  region.SetIndex(1, 2);
+  region.SetIndex(2, 1);
+  region.SetSize(0, 7);
+  region.SetSize(1, 5);
+  region.SetSize(2, 4);
+
+  itk::GDCMImageIO::Pointer readIO = itk::GDCMImageIO::New();
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetImageIO(readIO);
+  reader->SetFileName(fileName);
+  reader->SetUseStreaming(true);
+  TRY_EXPECT_NO_EXCEPTION( reader->UpdateOutputInformation() );
+  TEST_EXPECT_TRUE( readIO->CanStreamRead() );
+  reader->GetOutput()->SetRequestedRegion(region);
+  TRY_EXPECT_NO_EXCEPTION( reader->Update() );
+
+  ImageType::Pointer output = reader->GetOutput();
+  TEST_EXPECT_EQUAL( output->GetBufferedRegion(), region );
+  itk::ImageRegionIteratorWithIndex< ImageType > ot(output, region);
+  for ( ot.GoToBegin(); !ot.IsAtEnd(); ++ot )
+    {
+    if ( ot.Get() != ExpectedValue( ot.GetIndex() ) )
+      {
+      std::cerr << fileName << ": wrong value " << ot.Get()
+                << " at " << ot.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkGDCMImageIOStreamingReadTest(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string outputDirectory = argv[1];
+
+  int status = EXIT_SUCCESS;
+  if ( WriteAndReadRegion(outputDirectory + "/itkGDCMImageIOStreamingReadTestRaw.dcm",
+                          false, itk::GDCMImageIO::JPEG2000) != EXIT_SUCCESS )
+    {
+    status = EXIT_FAILURE;
+    }
+  if ( WriteAndReadRegion(outputDirectory + "/itkGDCMImageIOStreamingReadTestJPEG.dcm",
+                          true, itk::GDCMImageIO::JPEG) != EXIT_SUCCESS )
+    {
+    status = EXIT_FAILURE;
+    }
+  if ( WriteAndReadRegion(outputDirectory + "/itkGDCMImageIOStreamingReadTestJPEG2000.dcm",
+                          true, itk::GDCMImageIO::JPEG2000) != EXIT_SUCCESS )
+    {
+    status = EXIT_FAILURE;
+    }
+  return status;
+}
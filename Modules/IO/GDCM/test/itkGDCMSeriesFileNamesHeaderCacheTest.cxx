@@ -0,0 +1,111 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkGDCMImageIO.h"
+#include "itkGDCMSeriesFileNames.h"
+#include "itkImageFileWriter.h"
+#include "itkMetaDataObject.h"
+#include "itkTestingMacros.h"
+#include "itksys/SystemTools.hxx"
+
+#include <fstream>
+#include <sstream>
+
+// Write a series whose file names are in the reverse order of the
+// slice positions, next to a file which is not DICOM, and check that
+// the series is ordered the same with and without the header cache.
+int itkGDCMSeriesFileNamesHeaderCacheTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = std::string( argv[1] ) + "/itkGDCMSeriesFileNamesHeaderCacheTest";
+  itksys::SystemTools::RemoveADirectory( directory.c_str() );
+  itksys::SystemTools::MakeDirectory( directory.c_str() );
+  const std::string cacheFileName = std::string( argv[1] ) + "/itkGDCMSeriesFileNamesHeaderCacheTest.cache";
+  itksys::SystemTools::RemoveFile( cacheFileName.c_str() );
+
+  typedef itk::Image< short, 2 >               ImageType;
+  typedef itk::ImageFileWriter< ImageType >    WriterType;
+  typedef itk::GDCMSeriesFileNames::FileNamesContainerType FileNamesContainerType;
+
+  ImageType::SizeType size;
+  size.Fill(8);
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+  image->FillBuffer(1);
+  // Secondary Capture images are not sorted by position, so write MR images.
+  itk::EncapsulateMetaData< std::string >( image->GetMetaDataDictionary(), "0008|0016", "1.2.840.10008.5.1.4.1.1.4" );
+
+  const unsigned int numberOfSlices = 5;
+  FileNamesContainerType expected;
+  itk::GDCMImageIO::Pointer gdcmIO = itk::GDCMImageIO::New();
+  for( unsigned int i = 0; i < numberOfSlices; ++i )
+    {
+    std::ostringstream fileName;
+    fileName << directory << "/slice" << numberOfSlices - 1 - i << ".dcm";
+    std::ostringstream position;
+    position << "0\\0\\" << 2.5 * i;
+    itk::EncapsulateMetaData< std::string >( image->GetMetaDataDictionary(), "0020|0032", position.str() );
+
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetImageIO(gdcmIO);
+    writer->SetFileName( fileName.str() );
+    writer->SetInput(image);
+    TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+    expected.push_back( fileName.str() );
+    }
+  {
+  std::ofstream notDicom( ( directory + "/README.txt" ).c_str() );
+  notDicom << "Not a DICOM file" << std::endl;
+  }
+
+  for( unsigned int run = 0; run < 4; ++run )
+    {
+    itk::GDCMSeriesFileNames::Pointer seriesFileNames = itk::GDCMSeriesFileNames::New();
+    if( run > 0 )
+      {
+      seriesFileNames->SetHeaderCacheFileName( cacheFileName );
+      TEST_SET_GET_VALUE( cacheFileName, std::string( seriesFileNames->GetHeaderCacheFileName() ) );
+      }
+    if( run == 3 )
+      {
+      // A modified file must be parsed again.
+      std::ofstream notDicom( ( directory + "/README.txt" ).c_str(), std::ios::app );
+      notDicom << "Still not a DICOM file" << std::endl;
+      }
+    seriesFileNames->SetInputDirectory( directory );
+
+    const FileNamesContainerType & fileNames = seriesFileNames->GetInputFileNames();
+    TEST_EXPECT_EQUAL( fileNames.size(), expected.size() );
+    for( size_t i = 0; i < expected.size(); ++i )
+      {
+      TEST_EXPECT_EQUAL( fileNames[i], expected[i] );
+      }
+    TEST_EXPECT_EQUAL( seriesFileNames->GetSeriesUIDs().size(), 1u );
+    if( run > 0 )
+      {
+      TEST_EXPECT_TRUE( itksys::SystemTools::FileExists( cacheFileName.c_str(), true ) );
+      }
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
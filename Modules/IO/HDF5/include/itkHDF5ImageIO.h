@@ -79,6 +79,15 @@ namespace itk
  * \li \/ITKImage\/\<name\>\/MetaData\/\<item-name\>
  *                             Dataset containing data for item-name
  *                             in the MetaDataDictionary
+ * \li \/ITKImage\/\<name\>\/NumberOfResolutionLevels
+ *                             Number of resolution levels stored in the
+ *                             file, including the full resolution image.
+ * \li \/ITKImage\/\<name\>\/ResolutionLevels\/\<level\>
+ *                             Group holding the Origin, Spacing, Dimension
+ *                             and VoxelData of a coarser resolution level.
+ *                             Each level halves the previous one along
+ *                             every dimension by averaging 2^N blocks of
+ *                             voxels.
  * re-arrangement.
  *
  *
@@ -131,6 +140,26 @@ public:
    * that the IORegions has been set properly. */
   virtual void Write(const void *buffer) ITK_OVERRIDE;
 
+  /** Set/Get the number of resolution levels written to the file,
+   * including the full resolution image. Levels past the first are
+   * computed from the buffer passed to Write, so streamed writing is
+   * disabled when more than one level is requested. After
+   * ReadImageInformation this holds the number of levels in the file.
+   * Defaults to 1. */
+  itkSetClampMacro(NumberOfResolutionLevels, unsigned int, 1,
+                   NumericTraits< unsigned int >::max());
+  itkGetConstMacro(NumberOfResolutionLevels, unsigned int);
+
+  /** Set/Get the resolution level to read, where 0 is the full resolution
+   * image. The image information and (possibly streamed) pixel data
+   * reported by the ImageIO are those of the selected level, so only the
+   * bytes of that level are read from disk. Defaults to 0. */
+  itkSetMacro(ResolutionLevel, unsigned int);
+  itkGetConstMacro(ResolutionLevel, unsigned int);
+
+  /** Streamed writing is only supported for single level files. */
+  virtual bool CanStreamWrite() ITK_OVERRIDE;
+
 protected:
   HDF5ImageIO();
   ~HDF5ImageIO() ITK_OVERRIDE;
@@ -192,12 +221,19 @@ private:
   void SetupStreaming(H5::DataSpace *imageSpace,
                       H5::DataSpace *slabSpace);
 
+  bool DataSetExists(const std::string &path);
+
+  template <typename TComponent>
+  void WriteResolutionLevels(const TComponent *buffer);
+
   void CloseH5File();
   void CloseDataSet();
 
   H5::H5File  *m_H5File;
   H5::DataSet *m_VoxelDataSet;
   bool         m_ImageInformationWritten;
+  unsigned int m_NumberOfResolutionLevels;
+  unsigned int m_ResolutionLevel;
 };
 } // end namespace itk
 
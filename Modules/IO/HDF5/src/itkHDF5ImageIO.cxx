@@ -19,15 +19,22 @@
 #include "itkHDF5ImageIO.h"
 #include "itkMetaDataObject.h"
 #include "itkArray.h"
+#include "itkMultiThreader.h"
 #include "itksys/SystemTools.hxx"
 #include "itk_H5Cpp.h"
 
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
 namespace itk
 {
 
 HDF5ImageIO::HDF5ImageIO() : m_H5File(ITK_NULLPTR),
                              m_VoxelDataSet(ITK_NULLPTR),
-                             m_ImageInformationWritten(false)
+                             m_ImageInformationWritten(false),
+                             m_NumberOfResolutionLevels(1),
+                             m_ResolutionLevel(0)
 {
 }
 
@@ -44,6 +51,9 @@ HDF5ImageIO
   Superclass::PrintSelf(os, indent);
   // just prints out the pointer value.
   os << indent << "H5File: " << this->m_H5File << std::endl;
+  os << indent << "NumberOfResolutionLevels: "
+     << this->m_NumberOfResolutionLevels << std::endl;
+  os << indent << "ResolutionLevel: " << this->m_ResolutionLevel << std::endl;
 }
 
 //
@@ -60,6 +70,100 @@ const std::string Dimensions("/Dimension");
 const std::string VoxelType("/VoxelType");
 const std::string VoxelData("/VoxelData");
 const std::string MetaDataName("/MetaData");
+const std::string NumberOfResolutionLevelsName("/NumberOfResolutionLevels");
+const std::string ResolutionLevelsGroup("/ResolutionLevels");
+
+std::string
+ResolutionLevelGroupName(const std::string &groupName, unsigned int level)
+{
+  std::ostringstream levelName;
+  levelName << groupName << ResolutionLevelsGroup << "/" << level;
+  return levelName.str();
+}
+
+/** Shared state for computing one resolution level from the previous one.
+ * Dimensions are listed fastest moving first, as in ITK. */
+template <typename TComponent>
+struct ShrinkByTwoStruct
+{
+  const TComponent           *Input;
+  TComponent                 *Output;
+  std::vector< SizeValueType > InputSize;
+  std::vector< SizeValueType > OutputSize;
+  SizeValueType                NumberOfComponents;
+};
+
+/** Each output voxel is the average of the (up to) 2^N input voxels it
+ * covers. The outermost output dimension is split among the threads. */
+template <typename TComponent>
+ITK_THREAD_RETURN_TYPE
+ShrinkByTwoThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const ShrinkByTwoStruct< TComponent > *str =
+    static_cast< ShrinkByTwoStruct< TComponent > * >( info->UserData );
+
+  const unsigned int numDims = static_cast< unsigned int >( str->InputSize.size() );
+  const SizeValueType numComponents = str->NumberOfComponents;
+  const SizeValueType outerSize = str->OutputSize[numDims - 1];
+  const SizeValueType outerBegin = outerSize * info->ThreadID / info->NumberOfThreads;
+  const SizeValueType outerEnd = outerSize * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+
+  SizeValueType sliceSize = 1;
+  std::vector< SizeValueType > inputStrides(numDims);
+  for( unsigned int d = 0; d < numDims; ++d )
+    {
+    inputStrides[d] = ( d == 0 ) ? numComponents : inputStrides[d - 1] * str->InputSize[d - 1];
+    if( d < numDims - 1 )
+      {
+      sliceSize *= str->OutputSize[d];
+      }
+    }
+
+  std::vector< SizeValueType > index(numDims);
+  std::vector< double >        sum(numComponents);
+  const unsigned int           numberOfCorners = 1u << numDims;
+  for( SizeValueType outIndex = outerBegin * sliceSize;
+       outIndex < outerEnd * sliceSize; ++outIndex )
+    {
+    SizeValueType remainder = outIndex;
+    for( unsigned int d = 0; d < numDims; ++d )
+      {
+      index[d] = remainder % str->OutputSize[d];
+      remainder /= str->OutputSize[d];
+      }
+    std::fill( sum.begin(), sum.end(), 0.0 );
+    unsigned int count = 0;
+    for( unsigned int corner = 0; corner < numberOfCorners; ++corner )
+      {
+      SizeValueType offset = 0;
+      bool          inside = true;
+      for( unsigned int d = 0; d < numDims && inside; ++d )
+        {
+        const SizeValueType inIndex = 2 * index[d] + ( ( corner >> d ) & 1u );
+        inside = inIndex < str->InputSize[d];
+        offset += inIndex * inputStrides[d];
+        }
+      if( inside )
+        {
+        for( SizeValueType c = 0; c < numComponents; ++c )
+          {
+          sum[c] += static_cast< double >( str->Input[offset + c] );
+          }
+        ++count;
+        }
+      }
+    TComponent *out = str->Output + outIndex * numComponents;
+    for( SizeValueType c = 0; c < numComponents; ++c )
+      {
+      const double average = sum[c] / count;
+      out[c] = static_cast< TComponent >( NumericTraits< TComponent >::is_integer ?
+                                          std::floor( average + 0.5 ) : average );
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
 
 template <typename TScalar>
 H5::PredType GetType()
@@ -767,6 +871,20 @@ HDF5ImageIO
     }
 }
 
+bool
+HDF5ImageIO
+::DataSetExists(const std::string &path)
+{
+  return H5Lexists(this->m_H5File->getId(), path.c_str(), H5P_DEFAULT) > 0;
+}
+
+bool
+HDF5ImageIO
+::CanStreamWrite()
+{
+  return this->m_NumberOfResolutionLevels == 1;
+}
+
 void
 HDF5ImageIO
 ::ReadImageInformation()
@@ -827,7 +945,42 @@ HDF5ImageIO
       }
     }
 
+    //
+    // files written without resolution levels hold only the full
+    // resolution image
+    this->m_NumberOfResolutionLevels = 1;
+    std::string NumberOfResolutionLevelsPath(groupName);
+    NumberOfResolutionLevelsPath += NumberOfResolutionLevelsName;
+    if(this->DataSetExists(NumberOfResolutionLevelsPath))
+      {
+      this->m_NumberOfResolutionLevels = static_cast<unsigned int>(
+        this->ReadScalar<int>(NumberOfResolutionLevelsPath) );
+      }
+    if(this->m_ResolutionLevel >= this->m_NumberOfResolutionLevels)
+      {
+      itkExceptionMacro(<< "Resolution level " << this->m_ResolutionLevel
+                        << " requested but " << this->GetFileName()
+                        << " only holds " << this->m_NumberOfResolutionLevels
+                        << " resolution levels");
+      }
+
     std::string VoxelDataName(groupName);
+    if(this->m_ResolutionLevel > 0)
+      {
+      const std::string levelGroupName =
+        ResolutionLevelGroupName(groupName,this->m_ResolutionLevel);
+      this->m_Origin = this->ReadVector<double>(levelGroupName + Origin);
+      std::vector<double> levelSpacing =
+        this->ReadVector<double>(levelGroupName + Spacing);
+      std::vector<ImageIOBase::SizeValueType> levelDims =
+        this->ReadVector<ImageIOBase::SizeValueType>(levelGroupName + Dimensions);
+      for(int i = 0; i < numDims; i++)
+        {
+        this->SetSpacing(i,levelSpacing[i]);
+        this->SetDimensions(i,levelDims[i]);
+        }
+      VoxelDataName = levelGroupName;
+      }
     VoxelDataName += VoxelData;
     *(this->m_VoxelDataSet) = this->m_H5File->openDataSet(VoxelDataName);
     H5::DataSet imageSet = *(this->m_VoxelDataSet);
@@ -1242,6 +1395,11 @@ HDF5ImageIO
     *(this->m_VoxelDataSet) = this->m_H5File->createDataSet(VoxelDataName,
                                                             dataType,
                                                             imageSpace,plist);
+    std::string NumberOfResolutionLevelsPath(groupName);
+    NumberOfResolutionLevelsPath += NumberOfResolutionLevelsName;
+    this->WriteScalar(NumberOfResolutionLevelsPath,
+                      static_cast<int>(this->m_NumberOfResolutionLevels));
+
     std::string MetaDataGroupName(groupName);
     MetaDataGroupName += MetaDataName;
     this->m_H5File->createGroup(MetaDataGroupName);
@@ -1442,6 +1600,33 @@ HDF5ImageIO
     this->SetupStreaming(&imageSpace,&dspace);
     this->m_VoxelDataSet->write(buffer,dataType,dspace,imageSpace);
     delete[] dims;
+
+    if(this->m_NumberOfResolutionLevels > 1)
+      {
+#define ITK_HDF5_WRITE_RESOLUTION_LEVELS(cType, CXXType)                      \
+      case ImageIOBase::cType:                                                \
+        this->WriteResolutionLevels(static_cast<const CXXType *>(buffer));    \
+        break
+      switch(this->GetComponentType())
+        {
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(UCHAR, unsigned char);
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(CHAR, char);
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(USHORT, unsigned short);
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(SHORT, short);
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(UINT, unsigned int);
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(INT, int);
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(ULONG, unsigned long);
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(LONG, long);
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(ULONGLONG, unsigned long long);
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(LONGLONG, long long);
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(FLOAT, float);
+        ITK_HDF5_WRITE_RESOLUTION_LEVELS(DOUBLE, double);
+        default:
+          itkExceptionMacro(<< "unsupported IOComponentType "
+                            << this->GetComponentType());
+        }
+#undef ITK_HDF5_WRITE_RESOLUTION_LEVELS
+      }
     }
   // catch failure caused by the H5File operations
   catch( H5::FileIException & error )
@@ -1465,6 +1650,103 @@ HDF5ImageIO
     }
 }
 
+/**
+ * Compute the coarser resolution levels from the full resolution
+ * buffer, each from the previous one, and store them next to it.
+ */
+template <typename TComponent>
+void
+HDF5ImageIO
+::WriteResolutionLevels(const TComponent *buffer)
+{
+  const unsigned int numDims = this->GetNumberOfDimensions();
+  const SizeValueType numComponents = this->GetNumberOfComponents();
+
+  std::string groupName(ImageGroup);
+  groupName += "/0";
+  std::string LevelsGroupName(groupName);
+  LevelsGroupName += ResolutionLevelsGroup;
+  this->m_H5File->createGroup(LevelsGroupName);
+
+  std::vector<SizeValueType> size(this->m_Dimensions.begin(),
+                                  this->m_Dimensions.end());
+  std::vector<double> spacing(this->m_Spacing);
+  std::vector<double> origin(this->m_Origin);
+
+  std::vector<TComponent> previousLevel;
+  std::vector<TComponent> currentLevel;
+  const TComponent *input = buffer;
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  const ThreadIdType maximumNumberOfThreads = threader->GetNumberOfThreads();
+
+  for(unsigned int level = 1; level < this->m_NumberOfResolutionLevels; ++level)
+    {
+    ShrinkByTwoStruct<TComponent> str;
+    str.InputSize = size;
+    str.OutputSize.resize(numDims);
+    str.NumberOfComponents = numComponents;
+    SizeValueType numberOfValues = numComponents;
+    for(unsigned int d = 0; d < numDims; ++d)
+      {
+      str.OutputSize[d] = (size[d] + 1) / 2;
+      numberOfValues *= str.OutputSize[d];
+      // the new voxel center lies halfway between the two voxels it covers
+      if(size[d] > 1)
+        {
+        for(unsigned int i = 0; i < numDims; ++i)
+          {
+          origin[i] += 0.5 * spacing[d] * this->m_Direction[d][i];
+          }
+        spacing[d] *= 2.0;
+        }
+      }
+    currentLevel.resize(numberOfValues);
+    str.Input = input;
+    str.Output = &(currentLevel[0]);
+
+    const SizeValueType outerSize = str.OutputSize[numDims - 1];
+    threader->SetNumberOfThreads(static_cast<ThreadIdType>(
+      std::min<SizeValueType>(maximumNumberOfThreads, outerSize)));
+    threader->SetSingleMethod(ShrinkByTwoThreaderCallback<TComponent>, &str);
+    threader->SingleMethodExecute();
+
+    const std::string levelGroupName = ResolutionLevelGroupName(groupName,level);
+    this->m_H5File->createGroup(levelGroupName);
+    this->WriteVector(levelGroupName + Origin,origin);
+    this->WriteVector(levelGroupName + Spacing,spacing);
+    this->WriteVector(levelGroupName + Dimensions,str.OutputSize);
+
+    // HDF5 dimensions listed slowest moving first, ITK are fastest
+    // moving first.
+    const unsigned int HDFDim = numDims + (numComponents == 1 ? 0 : 1);
+    std::vector<hsize_t> dims(HDFDim);
+    for(unsigned int i(0), j(numDims-1); i < numDims; i++, j--)
+      {
+      dims[j] = str.OutputSize[i];
+      }
+    if(numComponents > 1)
+      {
+      dims[numDims] = numComponents;
+      }
+    H5::DataSpace levelSpace(HDFDim,&(dims[0]));
+    H5::PredType dataType = ComponentToPredType(this->GetComponentType());
+    H5::DSetCreatPropList plist;
+    plist.setDeflate(5);
+    dims[0] = 1;
+    plist.setChunk(HDFDim,&(dims[0]));
+    H5::DataSet levelSet =
+      this->m_H5File->createDataSet(levelGroupName + VoxelData,
+                                    dataType,levelSpace,plist);
+    levelSet.write(str.Output,dataType);
+    levelSet.close();
+
+    size = str.OutputSize;
+    previousLevel.swap(currentLevel);
+    input = &(previousLevel[0]);
+    }
+}
+
 //
 // GetHeaderSize -- return 0
 ImageIOBase::SizeType
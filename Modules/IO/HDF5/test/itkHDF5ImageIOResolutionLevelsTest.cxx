@@ -0,0 +1,197 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkHDF5ImageIO.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMath.h"
+#include "itkTestingMacros.h"
+#include "itksys/SystemTools.hxx"
+
+namespace
+{
+
+typedef float                       PixelType;
+typedef itk::Image< PixelType, 3 >  ImageType;
+
+ImageType::Pointer
+ReadLevel(const char *fileName, unsigned int level, const ImageType::RegionType *requestedRegion)
+{
+  itk::HDF5ImageIO::Pointer imageIO = itk::HDF5ImageIO::New();
+  imageIO->SetResolutionLevel(level);
+
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->SetImageIO(imageIO);
+  reader->SetUseStreaming(true);
+  if( requestedRegion != ITK_NULLPTR )
+    {
+    reader->UpdateOutputInformation();
+    reader->GetOutput()->SetRequestedRegion(*requestedRegion);
+    }
+  reader->Update();
+  if( imageIO->GetNumberOfResolutionLevels() != 3 )
+    {
+    std::cerr << "Expected 3 resolution levels, file reports "
+              << imageIO->GetNumberOfResolutionLevels() << std::endl;
+    return ITK_NULLPTR;
+    }
+  return reader->GetOutput();
+}
+
+}
+
+int itkHDF5ImageIOResolutionLevelsTest(int argc, char *argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itksys::SystemTools::ChangeDirectory(argv[1]);
+  const char *fileName = "HDF5ResolutionLevels.hdf5";
+
+  // odd sizes exercise the partial blocks on the upper boundaries
+  ImageType::SizeType size;
+  size[0] = 9;
+  size[1] = 8;
+  size[2] = 5;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 1.0;
+  spacing[2] = 2.0;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it(image, image->GetLargestPossibleRegion());
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType idx = it.GetIndex();
+    it.Set(idx[2] * 100 + idx[1] * 10 + idx[0]);
+    }
+
+  itk::HDF5ImageIO::Pointer imageIO = itk::HDF5ImageIO::New();
+  imageIO->SetNumberOfResolutionLevels(3);
+  TEST_SET_GET_VALUE(3, imageIO->GetNumberOfResolutionLevels());
+  TEST_EXPECT_TRUE(!imageIO->CanStreamWrite());
+
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName(fileName);
+  writer->SetImageIO(imageIO);
+  writer->SetInput(image);
+  writer->SetNumberOfStreamDivisions(5);
+  TRY_EXPECT_NO_EXCEPTION(writer->Update());
+  writer = ITK_NULLPTR;
+  imageIO = ITK_NULLPTR;
+
+  // the full resolution image is unchanged
+  ImageType::Pointer level0;
+  TRY_EXPECT_NO_EXCEPTION(level0 = ReadLevel(fileName, 0, ITK_NULLPTR));
+  TEST_EXPECT_TRUE(level0.IsNotNull());
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if( itk::Math::NotAlmostEquals(level0->GetPixel(it.GetIndex()), it.Get()) )
+      {
+      std::cerr << "Level 0 mismatch at " << it.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // level 1 averages 2x2x2 blocks, clipped at the image boundary
+  ImageType::Pointer level1;
+  TRY_EXPECT_NO_EXCEPTION(level1 = ReadLevel(fileName, 1, ITK_NULLPTR));
+  TEST_EXPECT_TRUE(level1.IsNotNull());
+  ImageType::SizeType level1Size;
+  level1Size[0] = 5;
+  level1Size[1] = 4;
+  level1Size[2] = 3;
+  TEST_EXPECT_EQUAL(level1Size, level1->GetLargestPossibleRegion().GetSize());
+  TEST_EXPECT_EQUAL(spacing * 2.0, level1->GetSpacing());
+  ImageType::PointType level1Origin;
+  level1Origin[0] = 0.25;
+  level1Origin[1] = 0.5;
+  level1Origin[2] = 1.0;
+  TEST_EXPECT_EQUAL(level1Origin, level1->GetOrigin());
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it1(level1, level1->GetLargestPossibleRegion());
+  for( it1.GoToBegin(); !it1.IsAtEnd(); ++it1 )
+    {
+    const ImageType::IndexType idx = it1.GetIndex();
+    double       sum = 0.0;
+    unsigned int count = 0;
+    for( unsigned int corner = 0; corner < 8; ++corner )
+      {
+      ImageType::IndexType child;
+      for( unsigned int d = 0; d < 3; ++d )
+        {
+        child[d] = 2 * idx[d] + ( ( corner >> d ) & 1 );
+        }
+      if( image->GetLargestPossibleRegion().IsInside(child) )
+        {
+        sum += image->GetPixel(child);
+        ++count;
+        }
+      }
+    if( !itk::Math::FloatAlmostEqual(static_cast< double >( it1.Get() ), sum / count, 4, 1e-5) )
+      {
+      std::cerr << "Level 1 mismatch at " << idx << ": " << it1.Get()
+                << " != " << sum / count << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // a streamed read of a sub-region of level 2 matches the full level
+  ImageType::Pointer level2;
+  TRY_EXPECT_NO_EXCEPTION(level2 = ReadLevel(fileName, 2, ITK_NULLPTR));
+  TEST_EXPECT_TRUE(level2.IsNotNull());
+  ImageType::SizeType level2Size;
+  level2Size[0] = 3;
+  level2Size[1] = 2;
+  level2Size[2] = 2;
+  TEST_EXPECT_EQUAL(level2Size, level2->GetLargestPossibleRegion().GetSize());
+
+  ImageType::RegionType subRegion;
+  subRegion.SetIndex(0, 1);
+  subRegion.SetIndex(1, 0);
+  subRegion.SetIndex(2, 1);
+  subRegion.SetSize(0, 2);
+  subRegion.SetSize(1, 2);
+  subRegion.SetSize(2, 1);
+  ImageType::Pointer level2Region;
+  TRY_EXPECT_NO_EXCEPTION(level2Region = ReadLevel(fileName, 2, &subRegion));
+  TEST_EXPECT_TRUE(level2Region.IsNotNull());
+  TEST_EXPECT_EQUAL(subRegion, level2Region->GetBufferedRegion());
+  itk::ImageRegionIteratorWithIndex< ImageType > it2(level2Region, subRegion);
+  for( it2.GoToBegin(); !it2.IsAtEnd(); ++it2 )
+    {
+    if( itk::Math::NotAlmostEquals(level2->GetPixel(it2.GetIndex()), it2.Get()) )
+      {
+      std::cerr << "Streamed level 2 mismatch at " << it2.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // requesting a level the file does not hold fails
+  TRY_EXPECT_EXCEPTION(ReadLevel(fileName, 3, ITK_NULLPTR));
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -21,6 +21,7 @@
 
 
 #include <fstream>
+#include <vector>
 #include "itkImageIOBase.h"
 #include "metaObject.h"
 #include "metaImage.h"
@@ -34,6 +35,19 @@ namespace itk
  *  For a detailed description of using this format, please see
  *  https://www.itk.org/Wiki/ITK/MetaIO/Documentation
  *
+ *  Compressed .mha files can be written in pieces, e.g. with
+ *  ImageFileWriter::SetNumberOfStreamDivisions(). The data is then
+ *  split along the last dimension into chunks of whole slices which
+ *  are deflated independently, as raw deflate data ending on a byte
+ *  boundary, so that the element data is still a single zlib stream
+ *  that any MetaIO reader inflates. The header gets the extra field
+ *  "CompressedDataChunkSlices = <slices per chunk>", and the zlib
+ *  stream, of CompressedDataSize bytes, is followed by a table of
+ *  (number of chunks + 1) little-endian 64-bit offsets of the chunks,
+ *  relative to the start of the element data. Such files can be read
+ *  by regions, and only the chunks overlapping the requested region
+ *  are decompressed, in parallel.
+ *
  *  \ingroup IOFilters
  * \ingroup ITKIOMeta
  */
@@ -119,19 +133,21 @@ public:
                            const ImageIORegion & largestPossibleRegion) ITK_OVERRIDE;
 
   /** Determine if the ImageIO can stream reading from this
-   *  file. Only time cannot stream read/write is if compression is used.
+   *  file. Compressed data can only be streamed if it was written
+   *  in chunks.
    *  CanRead must be called prior to this function. */
   virtual bool CanStreamRead() ITK_OVERRIDE
   {
     if ( m_MetaImage.CompressedData() )
       {
-      return false;
+      return m_CompressedDataChunkSlices > 0;
       }
     return true;
   }
 
   /** Determine if the ImageIO can stream writing to this
-   *  file. Only time cannot stream read/write is if compression is used.
+   *  file. Compressed data can only be streamed to a .mha file, in
+   *  chunks.
    *  Assumes file passes a CanRead call and its pixels are of the same
    *  type as the template of the writer. Can verify by first calling
    *  CanRead and then CanStreamRead prior to calling CanStreamWrite. */
@@ -139,11 +155,18 @@ public:
   {
     if ( this->GetUseCompression() )
       {
-      return false;
+      return this->CanWriteCompressedDataChunks();
       }
     return true;
   }
 
+  /** Set/Get the zlib compression level, from 0 (no compression) to
+   * 9 (best compression), used when UseCompression is on. Defaults
+   * to 6, the zlib default. Compression runs on the default number of
+   * threads, in blocks of about 1 MiB. */
+  itkSetClampMacro(CompressionLevel, int, 0, 9);
+  itkGetConstMacro(CompressionLevel, int);
+
   /** Determing the subsampling factor in case
    *  we want a coarse version of the image/
    * \warning this is only used when streaming is on. */
@@ -170,12 +193,45 @@ protected:
 
 private:
 
+  /** True if compressed data can be written in chunks: binary data
+   * in a .mha file. */
+  bool CanWriteCompressedDataChunks() const;
+
+  /** Number of slices along the last dimension in each chunk of
+   * compressed data, chosen so that a chunk holds about 1 MiB. */
+  SizeValueType ComputeCompressedDataChunkSlices() const;
+
+  /** Write m_IORegion, made of whole chunks, after the chunks
+   * written by the previous calls. */
+  void WriteCompressedDataChunks(const void *buffer);
+
+  /** Write the whole image compressed as a single zlib stream, made
+   * of blocks deflated in parallel. */
+  void WriteCompressedDataStream(const void *buffer);
+
+  /** Read m_IORegion from a file written in chunks. */
+  void ReadCompressedDataChunks(void *buffer);
+
   MetaImage m_MetaImage;
 
   ITK_DISALLOW_COPY_AND_ASSIGN(MetaImageIO);
 
   unsigned int m_SubSamplingFactor;
 
+  int m_CompressionLevel;
+
+  /** Slices per chunk of the file being read, 0 if the data is not
+   * compressed in chunks. */
+  SizeValueType m_CompressedDataChunkSlices;
+
+  /** Chunk table, position of the element data and of the value of
+   * CompressedDataSize in the header, and Adler-32 of the chunks written
+   * so far, of the file being written in chunks. */
+  std::vector< uint64_t > m_CompressedDataChunkOffsets;
+  std::streamoff          m_CompressedDataOffset;
+  std::streamoff          m_CompressedDataSizePosition;
+  unsigned long           m_CompressedDataChecksum;
+
   static unsigned int m_DefaultDoublePrecision;
 };
 } // end namespace itk
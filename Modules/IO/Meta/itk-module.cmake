@@ -10,6 +10,7 @@ itk_module(ITKIOMeta
     ITKMetaIO
   PRIVATE_DEPENDS
     ITKIOImageBase
+    ITKZLIB
   TEST_DEPENDS
     ITKTestKernel
     ITKSmoothing
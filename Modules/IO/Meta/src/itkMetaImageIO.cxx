@@ -22,6 +22,15 @@
 #include "itkIOCommon.h"
 #include "itksys/SystemTools.hxx"
 #include "itkMath.h"
+#include "itkByteSwapper.h"
+#include "itkMultiThreader.h"
+#include "itk_zlib.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 
 namespace itk
 {
@@ -29,10 +38,346 @@ namespace itk
 // better accuracy when writing out floating point number in MetaImage header.
 unsigned int MetaImageIO::m_DefaultDoublePrecision = 17;
 
+namespace
+{
+const char * const CompressedDataChunkSlicesField = "CompressedDataChunkSlices";
+
+struct CompressedDataChunkReadStruct
+{
+  std::string                     FileName;
+  std::streamoff                  DataOffset;
+  const std::vector< uint64_t > * ChunkOffsets;
+  SizeValueType                   FirstChunk;
+  SizeValueType                   EndChunk;
+  SizeValueType                   ChunkSlices;
+  std::vector< SizeValueType >    Dimensions;
+  ImageIORegion                   Region;
+  SizeValueType                   PixelSize;
+  char *                          Buffer;
+  std::vector< std::string >      Errors;
+};
+
+/** Copy the part of the region found in a decompressed chunk. */
+void CopyChunkToRegion(const CompressedDataChunkReadStruct & str,
+                       SizeValueType chunkBeginSlice, SizeValueType chunkEndSlice,
+                       const char *chunk)
+{
+  const std::vector< SizeValueType > & dims = str.Dimensions;
+  const ImageIORegion & region = str.Region;
+  const unsigned int    last = static_cast< unsigned int >( dims.size() - 1 );
+  const SizeValueType   regionBegin = region.GetIndex(last);
+  const SizeValueType   beginSlice = std::max(chunkBeginSlice, regionBegin);
+  const SizeValueType   endSlice = std::min( chunkEndSlice, regionBegin + region.GetSize(last) );
+
+  if ( last == 0 )
+    {
+    std::memcpy( str.Buffer + ( beginSlice - regionBegin ) * str.PixelSize,
+                 chunk + ( beginSlice - chunkBeginSlice ) * str.PixelSize,
+                 ( endSlice - beginSlice ) * str.PixelSize );
+    return;
+    }
+
+  // Offsets in pixels of consecutive indices along each dimension.
+  std::vector< SizeValueType > strides( dims.size(), 1 );
+  for ( unsigned int i = 1; i < dims.size(); ++i )
+    {
+    strides[i] = strides[i - 1] * dims[i - 1];
+    }
+  SizeValueType linesPerSlice = 1;
+  for ( unsigned int i = 1; i < last; ++i )
+    {
+    linesPerSlice *= region.GetSize(i);
+    }
+  const SizeValueType lineLength = region.GetSize(0);
+
+  for ( SizeValueType z = beginSlice; z < endSlice; ++z )
+    {
+    for ( SizeValueType line = 0; line < linesPerSlice; ++line )
+      {
+      SizeValueType in = ( z - chunkBeginSlice ) * strides[last] + region.GetIndex(0);
+      SizeValueType remainder = line;
+      for ( unsigned int i = 1; i < last; ++i )
+        {
+        in += ( region.GetIndex(i) + remainder % region.GetSize(i) ) * strides[i];
+        remainder /= region.GetSize(i);
+        }
+      const SizeValueType out = ( ( z - regionBegin ) * linesPerSlice + line ) * lineLength;
+      std::memcpy( str.Buffer + out * str.PixelSize,
+                   chunk + in * str.PixelSize,
+                   lineLength * str.PixelSize );
+      }
+    }
+}
+
+/** Blocks of a buffer to deflate in parallel. With RawBlocks, the
+ * blocks are raw deflate data ending on a byte boundary, to be
+ * concatenated into a single zlib stream, each primed with the 32 KiB
+ * of input preceding it unless IndependentBlocks is set, and the last
+ * one ending the stream if FinishStream is set; otherwise each block
+ * is a zlib stream. */
+struct DeflateStruct
+{
+  const Bytef *                       Input;
+  std::vector< SizeValueType >        BlockOffsets;
+  int                                 Level;
+  bool                                RawBlocks;
+  bool                                IndependentBlocks;
+  bool                                FinishStream;
+  std::vector< std::vector< Bytef > > Output;
+  std::vector< uLong >                Checksums;
+  std::vector< int >                  Failed;
+};
+
+ITK_THREAD_RETURN_TYPE DeflateThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  DeflateStruct *str = static_cast< DeflateStruct * >( info->UserData );
+
+  const size_t numberOfBlocks = str->BlockOffsets.size() - 1;
+  for ( size_t b = info->ThreadID; b < numberOfBlocks; b += info->NumberOfThreads )
+    {
+    const SizeValueType begin = str->BlockOffsets[b];
+    const uInt          size = static_cast< uInt >( str->BlockOffsets[b + 1] - begin );
+    const bool          last = ( b + 1 == numberOfBlocks );
+
+    z_stream strm;
+    std::memset( &strm, 0, sizeof( strm ) );
+    if ( deflateInit2(&strm, str->Level, Z_DEFLATED, str->RawBlocks ? -MAX_WBITS : MAX_WBITS,
+                      8, Z_DEFAULT_STRATEGY) != Z_OK )
+      {
+      str->Failed[b] = 1;
+      continue;
+      }
+    if ( str->RawBlocks && !str->IndependentBlocks && begin > 0 )
+      {
+      const SizeValueType dictionarySize = std::min< SizeValueType >(begin, 32768);
+      deflateSetDictionary( &strm, str->Input + begin - dictionarySize, static_cast< uInt >( dictionarySize ) );
+      }
+
+    // Z_SYNC_FLUSH adds an empty stored block of at most 5 bytes.
+    std::vector< Bytef > & output = str->Output[b];
+    output.resize(deflateBound(&strm, size) + 16);
+    strm.next_in = const_cast< Bytef * >( str->Input + begin );
+    strm.avail_in = size;
+    strm.next_out = &output[0];
+    strm.avail_out = static_cast< uInt >( output.size() );
+    const int flush = ( str->RawBlocks && !( last && str->FinishStream ) ) ? Z_SYNC_FLUSH : Z_FINISH;
+    const int status = deflate(&strm, flush);
+    if ( ( flush == Z_FINISH && status != Z_STREAM_END )
+         || ( flush == Z_SYNC_FLUSH && ( status != Z_OK || strm.avail_in != 0 || strm.avail_out == 0 ) ) )
+      {
+      str->Failed[b] = 1;
+      }
+    output.resize(strm.total_out);
+    deflateEnd(&strm);
+
+    if ( str->RawBlocks )
+      {
+      str->Checksums[b] = adler32(adler32(0L, Z_NULL, 0), str->Input + begin, size);
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/** Deflate the blocks of str on the default number of threads.
+ * Returns false if zlib failed on any block. */
+bool DeflateBlocks(DeflateStruct & str)
+{
+  const size_t numberOfBlocks = str.BlockOffsets.size() - 1;
+  str.Output.assign( numberOfBlocks, std::vector< Bytef >() );
+  str.Checksums.assign(numberOfBlocks, 0);
+  str.Failed.assign(numberOfBlocks, 0);
+  if ( numberOfBlocks == 0 )
+    {
+    return true;
+    }
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( static_cast< ThreadIdType >(
+    std::min< size_t >( numberOfBlocks, MultiThreader::GetGlobalDefaultNumberOfThreads() ) ) );
+  threader->SetSingleMethod(DeflateThreaderCallback, &str);
+  threader->SingleMethodExecute();
+
+  return std::find( str.Failed.begin(), str.Failed.end(), 1 ) == str.Failed.end();
+}
+
+/** The two bytes starting a zlib stream deflated at the given level. */
+void ZlibHeader(int level, unsigned char header[2])
+{
+  const int levelFlag = level < 2 ? 0 : ( level < 6 ? 1 : ( level == 6 ? 2 : 3 ) );
+  header[0] = 0x78;
+  header[1] = static_cast< unsigned char >( levelFlag << 6 );
+  header[1] += static_cast< unsigned char >( ( 31 - ( header[0] * 256 + header[1] ) % 31 ) % 31 );
+}
+
+/** The Adler-32 ending a zlib stream, most significant byte first. */
+void ZlibTrailer(uLong checksum, unsigned char trailer[4])
+{
+  trailer[0] = static_cast< unsigned char >( ( checksum >> 24 ) & 0xff );
+  trailer[1] = static_cast< unsigned char >( ( checksum >> 16 ) & 0xff );
+  trailer[2] = static_cast< unsigned char >( ( checksum >> 8 ) & 0xff );
+  trailer[3] = static_cast< unsigned char >( checksum & 0xff );
+}
+
+/** Scan the header lines of a MetaImage file for the position of the
+ * value of a field, and for the end of the ElementDataFile line where
+ * local element data starts. Positions not found are left at -1. */
+void LocateHeaderField(std::istream & header, const std::string & fieldName,
+                       std::streamoff & valuePosition, std::streamoff & dataPosition)
+{
+  valuePosition = -1;
+  dataPosition = -1;
+  std::streamoff lineBegin = header.tellg();
+  std::string    line;
+  while ( std::getline(header, line) )
+    {
+    const std::string::size_type start = line.find_first_not_of(" \t");
+    if ( start != std::string::npos && line.compare(start, 15, "ElementDataFile") == 0 )
+      {
+      dataPosition = header.tellg();
+      return;
+      }
+    if ( start != std::string::npos && line.compare(start, fieldName.size(), fieldName) == 0 )
+      {
+      const std::string::size_type equal = line.find_first_not_of(" \t", start + fieldName.size());
+      if ( equal != std::string::npos && line[equal] == '=' )
+        {
+        const std::string::size_type value = line.find_first_not_of(" \t", equal + 1);
+        if ( value != std::string::npos )
+          {
+          valuePosition = lineBegin + static_cast< std::streamoff >( value );
+          }
+        }
+      }
+    lineBegin = header.tellg();
+    }
+}
+
+/** Write only the header of a compressed MetaImage file, for element
+ * data compressed here. MetaImage::Write() deflates the whole element
+ * data whenever CompressedData is on, even when it does not write it,
+ * so the header is written with CompressedData off and the field is
+ * then set in the file. */
+bool WriteCompressedHeader(MetaImage & metaImage, const char *fileName, const char *dataFileName)
+{
+  metaImage.CompressedData(false);
+  const bool written = metaImage.Write(fileName, dataFileName, false);
+  metaImage.CompressedData(true);
+  if ( !written )
+    {
+    return false;
+    }
+
+  std::ostringstream content;
+  {
+  std::ifstream in(fileName, std::ios::in | std::ios::binary);
+  content << in.rdbuf();
+  }
+  std::string                  header = content.str();
+  const std::string            field = "CompressedData = False";
+  const std::string::size_type position = header.find(field);
+  if ( position == std::string::npos )
+    {
+    return false;
+    }
+  header.replace( position, field.size(), "CompressedData = True" );
+  std::ofstream out(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+  out.write( header.data(), static_cast< std::streamsize >( header.size() ) );
+  return !out.fail();
+}
+
+ITK_THREAD_RETURN_TYPE CompressedDataChunkReadThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  CompressedDataChunkReadStruct *str =
+    static_cast< CompressedDataChunkReadStruct * >( info->UserData );
+
+  const SizeValueType numberOfChunks = str->EndChunk - str->FirstChunk;
+  const SizeValueType begin = str->FirstChunk + numberOfChunks * info->ThreadID / info->NumberOfThreads;
+  const SizeValueType end = str->FirstChunk + numberOfChunks * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+  if ( begin == end )
+    {
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  std::ifstream file(str->FileName.c_str(), std::ios::in | std::ios::binary);
+  if ( !file )
+    {
+    str->Errors[info->ThreadID] = "Cannot open " + str->FileName;
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  const unsigned int  last = static_cast< unsigned int >( str->Dimensions.size() - 1 );
+  std::vector< Bytef > compressed;
+  std::vector< Bytef > chunk;
+  for ( SizeValueType c = begin; c < end; ++c )
+    {
+    const SizeValueType chunkBeginSlice = c * str->ChunkSlices;
+    const SizeValueType chunkEndSlice = std::min( chunkBeginSlice + str->ChunkSlices, str->Dimensions[last] );
+
+    SizeValueType chunkSize = str->PixelSize * ( chunkEndSlice - chunkBeginSlice );
+    for ( unsigned int i = 0; i < last; ++i )
+      {
+      chunkSize *= str->Dimensions[i];
+      }
+    const uint64_t compressedBegin = ( *str->ChunkOffsets )[c];
+    const uint64_t compressedEnd = ( *str->ChunkOffsets )[c + 1];
+    if ( compressedEnd <= compressedBegin )
+      {
+      str->Errors[info->ThreadID] = "Corrupted chunk table in " + str->FileName;
+      return ITK_THREAD_RETURN_VALUE;
+      }
+    compressed.resize( static_cast< size_t >( compressedEnd - compressedBegin ) );
+    // One more byte than the chunk so that the empty block ending a
+    // chunk in the middle of the stream is consumed as well.
+    chunk.resize(chunkSize + 1);
+
+    file.seekg( str->DataOffset + static_cast< std::streamoff >( compressedBegin ) );
+    if ( !file.read( reinterpret_cast< char * >( &compressed[0] ), compressed.size() ) )
+      {
+      str->Errors[info->ThreadID] = "Cannot read compressed data from " + str->FileName;
+      return ITK_THREAD_RETURN_VALUE;
+      }
+
+    // The chunks are raw deflate data, deflated without the preceding
+    // input, so each one inflates on its own.
+    z_stream strm;
+    std::memset( &strm, 0, sizeof( strm ) );
+    if ( inflateInit2(&strm, -MAX_WBITS) != Z_OK )
+      {
+      str->Errors[info->ThreadID] = "Cannot uncompress data from " + str->FileName;
+      return ITK_THREAD_RETURN_VALUE;
+      }
+    strm.next_in = &compressed[0];
+    strm.avail_in = static_cast< uInt >( compressed.size() );
+    strm.next_out = &chunk[0];
+    strm.avail_out = static_cast< uInt >( chunk.size() );
+    const int status = inflate(&strm, Z_SYNC_FLUSH);
+    const bool inflated = ( status == Z_STREAM_END || ( status == Z_OK && strm.avail_in == 0 ) )
+                          && strm.total_out == chunkSize;
+    inflateEnd(&strm);
+    if ( !inflated )
+      {
+      str->Errors[info->ThreadID] = "Cannot uncompress data from " + str->FileName;
+      return ITK_THREAD_RETURN_VALUE;
+      }
+    CopyChunkToRegion( *str, chunkBeginSlice, chunkEndSlice, reinterpret_cast< const char * >( &chunk[0] ) );
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+} // end anonymous namespace
+
 MetaImageIO::MetaImageIO()
 {
   m_FileType = Binary;
   m_SubSamplingFactor = 1;
+  m_CompressionLevel = 6;
+  m_CompressedDataChunkSlices = 0;
+  m_CompressedDataOffset = 0;
+  m_CompressedDataSizePosition = 0;
+  m_CompressedDataChecksum = 0;
   if ( MET_SystemByteOrderMSB() )
     {
     m_ByteOrder = BigEndian;
@@ -59,6 +404,7 @@ void MetaImageIO::PrintSelf(std::ostream & os, Indent indent) const
   Superclass::PrintSelf(os, indent);
   m_MetaImage.PrintInfo();
   os << indent << "SubSamplingFactor: " << m_SubSamplingFactor << "\n";
+  os << indent << "CompressionLevel: " << m_CompressionLevel << "\n";
 }
 
 void MetaImageIO::SetDataFileName(const char *filename)
@@ -85,6 +431,7 @@ bool MetaImageIO::CanReadFile(const char *filename)
 
 void MetaImageIO::ReadImageInformation()
 {
+  m_CompressedDataChunkSlices = 0;
   if ( !m_MetaImage.Read(m_FileName.c_str(), false) )
     {
     itkExceptionMacro( "File cannot be read: "
@@ -405,6 +752,15 @@ void MetaImageIO::ReadImageInformation()
     {
     std::string key( m_MetaImage.GetAdditionalReadFieldName(f) );
     std::string value ( m_MetaImage.GetAdditionalReadFieldValue(f) );
+    if ( key == CompressedDataChunkSlicesField )
+      {
+      if ( m_MetaImage.CompressedData() )
+        {
+        std::istringstream is(value);
+        is >> m_CompressedDataChunkSlices;
+        }
+      continue;
+      }
     EncapsulateMetaData< std::string >( thisMetaDict,key,value );
     }
 
@@ -429,6 +785,12 @@ void MetaImageIO::ReadImageInformation()
 
 void MetaImageIO::Read(void *buffer)
 {
+  if ( m_MetaImage.CompressedData() && m_CompressedDataChunkSlices > 0 )
+    {
+    this->ReadCompressedDataChunks(buffer);
+    return;
+    }
+
   const unsigned int nDims = this->GetNumberOfDimensions();
 
   // this will check to see if we are actually streaming
@@ -1083,7 +1445,11 @@ MetaImageIO
 
   if ( m_UseCompression && ( largestRegion != m_IORegion ) )
     {
-    std::cout << "Compression in use: cannot stream the file writing" << std::endl;
+    delete[] dSize;
+    delete[] eSpacing;
+    delete[] eOrigin;
+    this->WriteCompressedDataChunks(buffer);
+    return;
     }
   else if (  largestRegion != m_IORegion )
     {
@@ -1115,6 +1481,15 @@ MetaImageIO
     delete[] indexMin;
     delete[] indexMax;
     }
+  else if ( m_UseCompression && binaryData
+            && std::strlen( m_MetaImage.ElementDataFileName() ) == 0 )
+    {
+    delete[] dSize;
+    delete[] eSpacing;
+    delete[] eOrigin;
+    this->WriteCompressedDataStream(buffer);
+    return;
+    }
   else
     {
     if ( !m_MetaImage.Write( m_FileName.c_str() ) )
@@ -1172,13 +1547,21 @@ MetaImageIO::GetActualNumberOfSplitsForWriting(unsigned int numberOfRequestedSpl
 {
   if ( this->GetUseCompression() )
     {
-    // we can not stream or paste with compression
+    // we can not paste with compression, and only stream in chunks
     if ( pasteRegion != largestPossibleRegion )
       {
       itkExceptionMacro( "Pasting and compression is not supported! Can't write:" << this->GetFileName() );
       }
     else if ( numberOfRequestedSplits != 1 )
       {
+      if ( this->CanWriteCompressedDataChunks() )
+        {
+        const unsigned int  last = this->GetNumberOfDimensions() - 1;
+        const SizeValueType chunkSlices = this->ComputeCompressedDataChunkSlices();
+        const SizeValueType numberOfChunks = ( this->GetDimensions(last) + chunkSlices - 1 ) / chunkSlices;
+        return static_cast< unsigned int >(
+          std::min( static_cast< SizeValueType >( numberOfRequestedSplits ), numberOfChunks ) );
+        }
       itkDebugMacro("Requested streaming and compression");
       itkDebugMacro("Meta IO is not streaming now!");
       }
@@ -1294,9 +1677,420 @@ MetaImageIO::GetSplitRegionForWriting( unsigned int ithPiece,
                                        const ImageIORegion & pasteRegion,
                                        const ImageIORegion & itkNotUsed(largestPossibleRegion) )
 {
+  if ( this->GetUseCompression() && numberOfActualSplits > 1 )
+    {
+    // Split along the last dimension, in whole chunks.
+    const unsigned int  last = this->GetNumberOfDimensions() - 1;
+    const SizeValueType chunkSlices = this->ComputeCompressedDataChunkSlices();
+    const SizeValueType numberOfChunks = ( this->GetDimensions(last) + chunkSlices - 1 ) / chunkSlices;
+    const SizeValueType beginSlice = chunkSlices * ( numberOfChunks * ithPiece / numberOfActualSplits );
+    const SizeValueType endSlice = std::min( chunkSlices * ( numberOfChunks * ( ithPiece + 1 ) / numberOfActualSplits ),
+                                             static_cast< SizeValueType >( this->GetDimensions(last) ) );
+    ImageIORegion splitRegion(pasteRegion);
+    splitRegion.SetIndex(last, beginSlice);
+    splitRegion.SetSize(last, endSlice - beginSlice);
+    return splitRegion;
+    }
   return GetSplitRegionForWritingCanStreamWrite(ithPiece, numberOfActualSplits, pasteRegion);
 }
 
+bool MetaImageIO::CanWriteCompressedDataChunks() const
+{
+  if ( this->GetFileType() == ASCII || this->GetNumberOfDimensions() == 0
+       || std::strlen( m_MetaImage.ElementDataFileName() ) > 0 )
+    {
+    return false;
+    }
+  std::string::size_type mhaPos = m_FileName.rfind(".mha");
+  return ( mhaPos != std::string::npos ) && ( mhaPos == m_FileName.length() - 4 );
+}
+
+SizeValueType MetaImageIO::ComputeCompressedDataChunkSlices() const
+{
+  const SizeValueType chunkSize = 1024 * 1024;
+  SizeValueType       sliceSize = this->GetComponentSize() * this->GetNumberOfComponents();
+  for ( unsigned int i = 0; i + 1 < this->GetNumberOfDimensions(); ++i )
+    {
+    sliceSize *= this->GetDimensions(i);
+    }
+  return std::max< SizeValueType >( 1, ( chunkSize + sliceSize - 1 ) / sliceSize );
+}
+
+void MetaImageIO::WriteCompressedDataChunks(const void *buffer)
+{
+  if ( !this->CanWriteCompressedDataChunks() )
+    {
+    itkExceptionMacro( "Compressed data can only be streamed to a binary .mha file. Can't write: "
+                       << this->GetFileName() );
+    }
+
+  const unsigned int  last = this->GetNumberOfDimensions() - 1;
+  const SizeValueType chunkSlices = this->ComputeCompressedDataChunkSlices();
+  const SizeValueType numberOfSlices = this->GetDimensions(last);
+  const SizeValueType numberOfChunks = ( numberOfSlices + chunkSlices - 1 ) / chunkSlices;
+
+  SizeValueType sliceSize = this->GetComponentSize() * this->GetNumberOfComponents();
+  for ( unsigned int i = 0; i < last; ++i )
+    {
+    if ( m_IORegion.GetIndex(i) != 0 || m_IORegion.GetSize(i) != this->GetDimensions(i) )
+      {
+      itkExceptionMacro( "Compressed data can only be streamed in whole slices. Can't write: "
+                         << this->GetFileName() );
+      }
+    sliceSize *= this->GetDimensions(i);
+    }
+  const SizeValueType beginSlice = m_IORegion.GetIndex(last);
+  const SizeValueType endSlice = beginSlice + m_IORegion.GetSize(last);
+  if ( beginSlice % chunkSlices != 0 || ( endSlice % chunkSlices != 0 && endSlice != numberOfSlices ) )
+    {
+    itkExceptionMacro( "Compressed data can only be streamed in whole chunks. Can't write: "
+                       << this->GetFileName() );
+    }
+  const SizeValueType beginChunk = beginSlice / chunkSlices;
+  const SizeValueType endChunk = ( endSlice + chunkSlices - 1 ) / chunkSlices;
+
+  // The header gets the chunk size and a CompressedDataSize of fixed
+  // width, set once the last chunk is written.
+  const std::streamsize compressedSizeWidth = 20;
+  if ( beginChunk == 0 )
+    {
+    std::ostringstream chunkSlicesValue;
+    chunkSlicesValue << chunkSlices;
+    const std::string value = chunkSlicesValue.str();
+    m_MetaImage.AddUserField( CompressedDataChunkSlicesField, MET_STRING,
+                              static_cast< int >( value.size() ), value.c_str(), true, -1 );
+    const std::string compressedSizeValue( static_cast< size_t >( compressedSizeWidth ), '0' );
+    m_MetaImage.AddUserField( "CompressedDataSize", MET_STRING,
+                              static_cast< int >( compressedSizeValue.size() ), compressedSizeValue.c_str(), true, -1 );
+    const bool written = WriteCompressedHeader(m_MetaImage, m_FileName.c_str(), ITK_NULLPTR);
+    // The header is written once, the fields must not leak into the
+    // next files written with this object. The write fields still point
+    // to the user fields, so they are cleared first.
+    m_MetaImage.ClearFields();
+    m_MetaImage.ClearUserFields();
+    if ( !written )
+      {
+      itkExceptionMacro( "File cannot be written: "
+                         << this->GetFileName()
+                         << std::endl
+                         << "Reason: "
+                         << itksys::SystemTools::GetLastSystemError() );
+      }
+    std::ifstream header(m_FileName.c_str(), std::ios::in | std::ios::binary);
+    LocateHeaderField(header, "CompressedDataSize", m_CompressedDataSizePosition, m_CompressedDataOffset);
+    if ( m_CompressedDataSizePosition < 0 || m_CompressedDataOffset < 0 )
+      {
+      itkExceptionMacro( "File cannot be written: "
+                         << this->GetFileName()
+                         << std::endl
+                         << "Reason: cannot locate the element data" );
+      }
+    m_CompressedDataChunkOffsets.assign(1, 2);
+    m_CompressedDataChecksum = adler32(0L, Z_NULL, 0);
+    }
+  else if ( beginChunk + 1 != m_CompressedDataChunkOffsets.size() )
+    {
+    itkExceptionMacro( "Compressed data must be streamed in order. Can't write: "
+                       << this->GetFileName() );
+    }
+
+  std::fstream file(m_FileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+  if ( !file )
+    {
+    itkExceptionMacro( "File cannot be written: "
+                       << this->GetFileName()
+                       << std::endl
+                       << "Reason: "
+                       << itksys::SystemTools::GetLastSystemError() );
+    }
+
+  // The chunks are raw deflate data ending on a byte boundary, deflated
+  // without the preceding input, so that they form a single zlib stream
+  // which any MetaIO reader inflates, and can also be inflated one by
+  // one.
+  const bool    lastPiece = ( endChunk == numberOfChunks );
+  DeflateStruct str;
+  str.Input = static_cast< const Bytef * >( buffer );
+  str.Level = m_CompressionLevel;
+  str.RawBlocks = true;
+  str.IndependentBlocks = true;
+  str.FinishStream = lastPiece;
+  for ( SizeValueType c = beginChunk; c < endChunk; ++c )
+    {
+    str.BlockOffsets.push_back( ( c * chunkSlices - beginSlice ) * sliceSize );
+    }
+  str.BlockOffsets.push_back( ( endSlice - beginSlice ) * sliceSize );
+  if ( !DeflateBlocks(str) )
+    {
+    itkExceptionMacro( "Compression failed. Can't write: " << this->GetFileName() );
+    }
+
+  if ( beginChunk == 0 )
+    {
+    unsigned char header[2];
+    ZlibHeader(m_CompressionLevel, header);
+    file.seekp(m_CompressedDataOffset);
+    file.write( reinterpret_cast< const char * >( header ), sizeof( header ) );
+    }
+  file.seekp( m_CompressedDataOffset + static_cast< std::streamoff >( m_CompressedDataChunkOffsets.back() ) );
+  for ( size_t b = 0; b < str.Output.size(); ++b )
+    {
+    file.write( reinterpret_cast< const char * >( &str.Output[b][0] ), str.Output[b].size() );
+    m_CompressedDataChunkOffsets.push_back( m_CompressedDataChunkOffsets.back() + str.Output[b].size() );
+    m_CompressedDataChecksum = adler32_combine( m_CompressedDataChecksum, str.Checksums[b],
+                                                static_cast< z_off_t >( str.BlockOffsets[b + 1] - str.BlockOffsets[b] ) );
+    }
+
+  if ( lastPiece )
+    {
+    // End the zlib stream, append the table of the chunk offsets,
+    // relative to the start of the element data, and set the size of
+    // the stream in the header. MetaIO reads no further than the
+    // stream.
+    unsigned char trailer[4];
+    ZlibTrailer(m_CompressedDataChecksum, trailer);
+    file.write( reinterpret_cast< const char * >( trailer ), sizeof( trailer ) );
+
+    std::vector< uint64_t > table(m_CompressedDataChunkOffsets);
+    ByteSwapper< uint64_t >::SwapRangeFromSystemToLittleEndian( &table[0], table.size() );
+    file.write( reinterpret_cast< const char * >( &table[0] ), table.size() * sizeof( uint64_t ) );
+
+    file.seekp(m_CompressedDataSizePosition);
+    file << std::setw(compressedSizeWidth) << std::setfill('0')
+         << m_CompressedDataChunkOffsets.back() + sizeof( trailer );
+    }
+  if ( !file )
+    {
+    itkExceptionMacro( "File cannot be written: "
+                       << this->GetFileName()
+                       << std::endl
+                       << "Reason: "
+                       << itksys::SystemTools::GetLastSystemError() );
+    }
+}
+
+void MetaImageIO::WriteCompressedDataStream(const void *buffer)
+{
+  const SizeValueType blockSize = 1024 * 1024;
+  const SizeValueType size = this->GetImageSizeInBytes();
+  DeflateStruct       str;
+  str.Input = static_cast< const Bytef * >( buffer );
+  str.Level = m_CompressionLevel;
+  str.RawBlocks = true;
+  str.IndependentBlocks = false;
+  str.FinishStream = true;
+  SizeValueType       offset = 0;
+  do
+    {
+    str.BlockOffsets.push_back(offset);
+    offset += blockSize;
+    }
+  while ( offset < size );
+  str.BlockOffsets.push_back(size);
+  if ( !DeflateBlocks(str) )
+    {
+    itkExceptionMacro( "Compression failed. Can't write: " << this->GetFileName() );
+    }
+
+  // zlib header, raw deflate blocks, and the Adler-32 of the whole
+  // buffer: a regular zlib stream as MetaIO writes it.
+  unsigned char header[2];
+  ZlibHeader(m_CompressionLevel, header);
+  uLong         checksum = adler32(0L, Z_NULL, 0);
+  SizeValueType compressedSize = sizeof( header ) + 4;
+  for ( size_t b = 0; b < str.Checksums.size(); ++b )
+    {
+    checksum = adler32_combine( checksum, str.Checksums[b],
+                                static_cast< z_off_t >( str.BlockOffsets[b + 1] - str.BlockOffsets[b] ) );
+    compressedSize += str.Output[b].size();
+    }
+  unsigned char trailer[4];
+  ZlibTrailer(checksum, trailer);
+
+  // The element data goes after the header of a .mha file, or in a
+  // .zraw file next to the .mhd header, as MetaImage::Write() does.
+  // MetaImage only writes CompressedDataSize when it compresses the
+  // data itself, so the field is added to the header here.
+  std::ostringstream compressedSizeValue;
+  compressedSizeValue << compressedSize;
+  const std::string value = compressedSizeValue.str();
+  m_MetaImage.AddUserField( "CompressedDataSize", MET_STRING,
+                            static_cast< int >( value.size() ), value.c_str(), true, -1 );
+
+  std::string::size_type mhaPos = m_FileName.rfind(".mha");
+  const bool             localData = ( mhaPos != std::string::npos ) && ( mhaPos == m_FileName.length() - 4 );
+  std::string            dataFileName = m_FileName;
+  bool                   written;
+  if ( localData )
+    {
+    written = WriteCompressedHeader(m_MetaImage, m_FileName.c_str(), ITK_NULLPTR);
+    }
+  else
+    {
+    dataFileName = itksys::SystemTools::GetFilenamePath(m_FileName);
+    if ( !dataFileName.empty() )
+      {
+      dataFileName += "/";
+      }
+    dataFileName += itksys::SystemTools::GetFilenameWithoutLastExtension(m_FileName) + ".zraw";
+    written = WriteCompressedHeader( m_MetaImage, m_FileName.c_str(),
+                                     itksys::SystemTools::GetFilenameName(dataFileName).c_str() );
+    }
+  m_MetaImage.ClearFields();
+  m_MetaImage.ClearUserFields();
+  if ( !written )
+    {
+    itkExceptionMacro( "File cannot be written: "
+                       << this->GetFileName()
+                       << std::endl
+                       << "Reason: "
+                       << itksys::SystemTools::GetLastSystemError() );
+    }
+
+  std::ofstream file( dataFileName.c_str(),
+                      localData ? std::ios::out | std::ios::binary | std::ios::app
+                                : std::ios::out | std::ios::binary | std::ios::trunc );
+  file.write( reinterpret_cast< const char * >( header ), sizeof( header ) );
+  for ( size_t b = 0; b < str.Output.size(); ++b )
+    {
+    file.write( reinterpret_cast< const char * >( &str.Output[b][0] ), str.Output[b].size() );
+    }
+  file.write( reinterpret_cast< const char * >( trailer ), sizeof( trailer ) );
+  if ( !file )
+    {
+    itkExceptionMacro( "File cannot be written: "
+                       << dataFileName
+                       << std::endl
+                       << "Reason: "
+                       << itksys::SystemTools::GetLastSystemError() );
+    }
+}
+
+void MetaImageIO::ReadCompressedDataChunks(void *buffer)
+{
+  const unsigned int nDims = this->GetNumberOfDimensions();
+  const unsigned int last = nDims - 1;
+
+  if ( m_SubSamplingFactor > 1 )
+    {
+    itkExceptionMacro( "SubSamplingFactor is not supported for data compressed in chunks: "
+                       << this->GetFileName() );
+    }
+
+  // The region may have fewer dimensions than the file, as when the
+  // last dimensions of the file are of size 1.
+  CompressedDataChunkReadStruct str;
+  str.Region = ImageIORegion(nDims);
+  for ( unsigned int i = 0; i < nDims; i++ )
+    {
+    str.Dimensions.push_back( this->GetDimensions(i) );
+    if ( i < m_IORegion.GetImageDimension() )
+      {
+      str.Region.SetIndex( i, m_IORegion.GetIndex(i) );
+      str.Region.SetSize( i, m_IORegion.GetSize(i) );
+      }
+    else if ( m_IORegion.GetImageDimension() == 0 )
+      {
+      str.Region.SetIndex(i, 0);
+      str.Region.SetSize( i, this->GetDimensions(i) );
+      }
+    else
+      {
+      str.Region.SetIndex(i, 0);
+      str.Region.SetSize(i, 1);
+      }
+    }
+
+  // Locate the element data: after the ElementDataFile line of the
+  // header, or at the start of a separate data file.
+  const std::string dataFileName( m_MetaImage.ElementDataFileName() );
+  const bool        localData = itksys::SystemTools::LowerCase(dataFileName) == "local";
+  std::streamoff    compressedSizePosition;
+  std::ifstream     header(m_FileName.c_str(), std::ios::in | std::ios::binary);
+  LocateHeaderField(header, "CompressedDataSize", compressedSizePosition, str.DataOffset);
+  SizeValueType compressedSize = 0;
+  if ( compressedSizePosition >= 0 )
+    {
+    header.clear();
+    header.seekg(compressedSizePosition);
+    header >> compressedSize;
+    }
+  if ( localData )
+    {
+    str.FileName = m_FileName;
+    }
+  else if ( itksys::SystemTools::FileIsFullPath( dataFileName.c_str() ) )
+    {
+    str.FileName = dataFileName;
+    str.DataOffset = 0;
+    }
+  else
+    {
+    str.FileName = itksys::SystemTools::GetFilenamePath(m_FileName);
+    if ( !str.FileName.empty() )
+      {
+      str.FileName += "/";
+      }
+    str.FileName += dataFileName;
+    str.DataOffset = 0;
+    }
+
+  // The table of the chunk offsets follows the zlib stream.
+  const SizeValueType numberOfChunks =
+    ( this->GetDimensions(last) + m_CompressedDataChunkSlices - 1 ) / m_CompressedDataChunkSlices;
+  std::vector< uint64_t > chunkOffsets(numberOfChunks + 1);
+  std::ifstream           file(str.FileName.c_str(), std::ios::in | std::ios::binary);
+  file.seekg( str.DataOffset + static_cast< std::streamoff >( compressedSize ) );
+  if ( str.DataOffset < 0 || compressedSize == 0
+       || !file.read( reinterpret_cast< char * >( &chunkOffsets[0] ), chunkOffsets.size() * sizeof( uint64_t ) ) )
+    {
+    itkExceptionMacro( "File cannot be read: "
+                       << this->GetFileName() << " for reading."
+                       << std::endl
+                       << "Reason: cannot read the chunk table" );
+    }
+  ByteSwapper< uint64_t >::SwapRangeFromSystemToLittleEndian( &chunkOffsets[0], chunkOffsets.size() );
+  if ( chunkOffsets.back() + 4 != compressedSize )
+    {
+    itkExceptionMacro( "File cannot be read: "
+                       << this->GetFileName() << " for reading."
+                       << std::endl
+                       << "Reason: corrupted chunk table" );
+    }
+
+  str.ChunkOffsets = &chunkOffsets;
+  str.ChunkSlices = m_CompressedDataChunkSlices;
+  str.FirstChunk = str.Region.GetIndex(last) / m_CompressedDataChunkSlices;
+  str.EndChunk = ( str.Region.GetIndex(last) + str.Region.GetSize(last) + m_CompressedDataChunkSlices - 1 )
+                 / m_CompressedDataChunkSlices;
+  str.PixelSize = this->GetComponentSize() * this->GetNumberOfComponents();
+  str.Buffer = static_cast< char * >( buffer );
+
+  const ThreadIdType numberOfThreads = static_cast< ThreadIdType >(
+    std::min< SizeValueType >( str.EndChunk - str.FirstChunk, MultiThreader::GetGlobalDefaultNumberOfThreads() ) );
+  if ( numberOfThreads > 0 )
+    {
+    str.Errors.resize(numberOfThreads);
+    MultiThreader::Pointer threader = MultiThreader::New();
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(CompressedDataChunkReadThreaderCallback, &str);
+    threader->SingleMethodExecute();
+    for ( size_t i = 0; i < str.Errors.size(); ++i )
+      {
+      if ( !str.Errors[i].empty() )
+        {
+        itkExceptionMacro( "File cannot be read: "
+                           << this->GetFileName() << " for reading."
+                           << std::endl
+                           << "Reason: " << str.Errors[i] );
+        }
+      }
+    }
+
+  m_MetaImage.ElementData(buffer, false);
+  m_MetaImage.ElementByteOrderFix( str.Region.GetNumberOfPixels() );
+}
+
 void MetaImageIO::SetDefaultDoublePrecision(unsigned int precision)
 {
   m_DefaultDoublePrecision = precision;
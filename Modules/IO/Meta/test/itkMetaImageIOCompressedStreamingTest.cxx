@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkCastImageFilter.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMetaImageIO.h"
+#include "itkTestingMacros.h"
+#include "metaImage.h"
+
+// Write a compressed MetaImage in several pieces, then read it back
+// whole and by regions, and with MetaIO alone.
+namespace
+{
+typedef short                             PixelType;
+typedef itk::Image< PixelType, 3 >        ImageType;
+typedef itk::ImageFileReader< ImageType > ReaderType;
+typedef itk::ImageFileWriter< ImageType > WriterType;
+
+PixelType
+ExpectedValue(const ImageType::IndexType & idx)
+{
+  return static_cast< PixelType >( idx[2] * 7 + idx[1] * 3 + idx[0] );
+}
+
+bool
+CheckValues(const ImageType * image, const ImageType::RegionType & region)
+{
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it(image, region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != ExpectedValue( it.GetIndex() ) )
+      {
+      std::cerr << "Wrong value at " << it.GetIndex() << ": " << it.Get()
+                << " instead of " << ExpectedValue( it.GetIndex() ) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkMetaImageIOCompressedStreamingTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string fileName = std::string( argv[1] ) + "/itkMetaImageIOCompressedStreamingTest.mha";
+
+  // 32 KiB slices: 32 slices per chunk, 4 chunks.
+  ImageType::SizeType size;
+  size[0] = 128;
+  size[1] = 128;
+  size[2] = 100;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( ExpectedValue( it.GetIndex() ) );
+    }
+
+  // The writer only streams when its input produces the requested pieces.
+  typedef itk::CastImageFilter< ImageType, ImageType > StreamingFilterType;
+  StreamingFilterType::Pointer streamer = StreamingFilterType::New();
+  streamer->SetInput(image);
+  streamer->InPlaceOff();
+
+  itk::MetaImageIO::Pointer writeIO = itk::MetaImageIO::New();
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetImageIO(writeIO);
+  writer->SetFileName(fileName);
+  writer->SetInput( streamer->GetOutput() );
+  writer->SetUseCompression(true);
+  writer->SetNumberOfStreamDivisions(3);
+  TRY_EXPECT_NO_EXCEPTION( writer->Update() );
+  TEST_EXPECT_TRUE( writeIO->CanStreamWrite() );
+
+  // Whole image.
+  itk::MetaImageIO::Pointer readIO = itk::MetaImageIO::New();
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetImageIO(readIO);
+  reader->SetFileName(fileName);
+  TRY_EXPECT_NO_EXCEPTION( reader->Update() );
+  TEST_EXPECT_TRUE( readIO->CanStreamRead() );
+  TEST_EXPECT_TRUE( !reader->GetOutput()->GetMetaDataDictionary().HasKey("CompressedDataChunkSlices") );
+  if ( !CheckValues( reader->GetOutput(), reader->GetOutput()->GetLargestPossibleRegion() ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // MetaIO reads the chunks as a regular zlib stream.
+  MetaImage metaImage;
+  TEST_EXPECT_TRUE( metaImage.Read( fileName.c_str() ) );
+  TEST_EXPECT_TRUE( metaImage.CompressedData() );
+  TEST_EXPECT_EQUAL( metaImage.ElementType(), MET_SHORT );
+  TEST_EXPECT_EQUAL( metaImage.Quantity(),
+                     static_cast< std::streamoff >( image->GetLargestPossibleRegion().GetNumberOfPixels() ) );
+  const PixelType * metaBuffer = static_cast< const PixelType * >( metaImage.ElementData() );
+  if ( !std::equal( metaBuffer, metaBuffer + metaImage.Quantity(), image->GetBufferPointer() ) )
+    {
+    std::cerr << "MetaIO read wrong values" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A region across two chunks.
+  ImageType::RegionType region;
+  region.SetIndex(0, 5);
+  region.SetIndex(1, 17);
+  region.SetIndex(2, 30);
+  region.SetSize(0, 50);
+  region.SetSize(1, 9);
+  region.SetSize(2, 40);
+
+  itk::MetaImageIO::Pointer streamIO = itk::MetaImageIO::New();
+  streamIO->SetUseStreamedReading(true);
+  ReaderType::Pointer streamReader = ReaderType::New();
+  streamReader->SetImageIO(streamIO);
+  streamReader->SetFileName(fileName);
+  streamReader->SetUseStreaming(true);
+  TRY_EXPECT_NO_EXCEPTION( streamReader->UpdateOutputInformation() );
+  streamReader->GetOutput()->SetRequestedRegion(region);
+  TRY_EXPECT_NO_EXCEPTION( streamReader->Update() );
+  TEST_EXPECT_EQUAL( streamReader->GetOutput()->GetBufferedRegion(), region );
+  if ( !CheckValues( streamReader->GetOutput(), region ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Pasting into a compressed file is still not supported.
+  ImageType::RegionType pasteRegion( region );
+  itk::ImageIORegion    ioRegion(3);
+  itk::ImageIORegionAdaptor< 3 >::Convert( pasteRegion, ioRegion,
+                                           image->GetLargestPossibleRegion().GetIndex() );
+  writer->SetIORegion(ioRegion);
+  TRY_EXPECT_EXCEPTION( writer->Update() );
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
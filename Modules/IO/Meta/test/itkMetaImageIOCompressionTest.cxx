@@ -0,0 +1,107 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMetaImageIO.h"
+#include "itkTestingImageIOCompression.h"
+#include "itkTestingMacros.h"
+#include "metaImage.h"
+
+#include <algorithm>
+#include "itksys/SystemTools.hxx"
+
+// Write compressed MetaImage files at several compression levels and
+// read them back, also with MetaIO alone, then time the single zlib
+// stream MetaImage::Write() deflates against the blocks MetaImageIO
+// deflates in parallel.
+namespace
+{
+typedef itk::Testing::CompressionTestImageType ImageType;
+
+void
+WriteSingleStream(const ImageType * image, const std::string & fileName)
+{
+  const ImageType::SizeType size = image->GetLargestPossibleRegion().GetSize();
+  const int                 dimSize[3] = { static_cast< int >( size[0] ),
+                                           static_cast< int >( size[1] ),
+                                           static_cast< int >( size[2] ) };
+  const float               spacing[3] = { 1.0f, 1.0f, 1.0f };
+  MetaImage                 metaImage( 3, dimSize, spacing, MET_SHORT, 1,
+                                       const_cast< ImageType::PixelType * >( image->GetBufferPointer() ) );
+  metaImage.CompressedData(true);
+  metaImage.Write( ( fileName + ".mha" ).c_str() );
+}
+
+void
+WriteBlocks(const ImageType * image, const std::string & fileName)
+{
+  itk::Testing::WriteCompressedImage< itk::MetaImageIO >( image, fileName + ".mha", 6 );
+}
+}
+
+int itkMetaImageIOCompressionTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string prefix = std::string( argv[1] ) + "/itkMetaImageIOCompressionTest";
+
+  ImageType::Pointer image = itk::Testing::MakeCompressionTestImage();
+
+  itk::MetaImageIO::Pointer io = itk::MetaImageIO::New();
+  EXERCISE_BASIC_OBJECT_METHODS( io, MetaImageIO, ImageIOBase );
+
+  const char * const extensions[] = { ".mha", ".mhd" };
+  if ( !itk::Testing::TestImageIOCompressionLevels< itk::MetaImageIO >( image, prefix, extensions, 2 ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The .mha files hold the whole compressed stream.
+  const unsigned long storedLength = itksys::SystemTools::FileLength( prefix + "0.mha" );
+  const unsigned long fastLength = itksys::SystemTools::FileLength( prefix + "1.mha" );
+  std::cout << "Compressed size at level 0: " << storedLength << " bytes, at level 1: "
+            << fastLength << " bytes" << std::endl;
+  TEST_EXPECT_TRUE( fastLength < storedLength );
+
+  // The blocks form a single zlib stream that MetaIO inflates.
+  for ( unsigned int e = 0; e < 2; ++e )
+    {
+    const std::string fileName = prefix + "6" + extensions[e];
+    MetaImage         metaImage;
+    TEST_EXPECT_TRUE( metaImage.Read( fileName.c_str() ) );
+    TEST_EXPECT_TRUE( metaImage.CompressedData() );
+    TEST_EXPECT_EQUAL( metaImage.Quantity(),
+                       static_cast< std::streamoff >( image->GetLargestPossibleRegion().GetNumberOfPixels() ) );
+    const ImageType::PixelType * metaBuffer = static_cast< const ImageType::PixelType * >( metaImage.ElementData() );
+    if ( !std::equal( metaBuffer, metaBuffer + metaImage.Quantity(), image->GetBufferPointer() ) )
+      {
+      std::cerr << "MetaIO read wrong values from " << fileName << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  const double singleStreamTime = itk::Testing::TimeCompressedWrite( WriteSingleStream, image, prefix + "Timing" );
+  const double blocksTime = itk::Testing::TimeCompressedWrite( WriteBlocks, image, prefix + "Timing" );
+  itk::Testing::ReportCompressedWriteTime( "Level 6, single zlib stream", image, singleStreamTime );
+  itk::Testing::ReportCompressedWriteTime( "Level 6, blocks in parallel", image, blocksTime );
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -76,6 +76,13 @@ public:
    * that the IORegions has been set properly. */
   virtual void Write(const void *buffer) ITK_OVERRIDE;
 
+  /** Set/Get the zlib compression level used when UseCompression is on,
+   * from 0 (store only) to 9 (smallest output). The default is 6. The
+   * data of a .nrrd file are compressed in parallel as a sequence of
+   * gzip members, one per megabyte of pixel data. */
+  itkSetClampMacro(CompressionLevel, int, 0, 9);
+  itkGetConstMacro(CompressionLevel, int);
+
 protected:
   NrrdImageIO();
   ~NrrdImageIO() ITK_OVERRIDE;
@@ -89,6 +96,8 @@ protected:
 
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(NrrdImageIO);
+
+  int m_CompressionLevel;
 };
 } // end namespace itk
 
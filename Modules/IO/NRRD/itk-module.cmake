@@ -7,8 +7,10 @@ itk_module(ITKIONRRD
   PRIVATE_DEPENDS
     ITKIOImageBase
     ITKNrrdIO
+    ITKZLIB
   TEST_DEPENDS
     ITKTestKernel
+    ITKZLIB
   FACTORY_NAMES
     ImageIO::Nrrd
   DESCRIPTION
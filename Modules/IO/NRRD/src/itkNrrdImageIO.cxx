@@ -22,12 +22,109 @@
 #include "itkMetaDataObject.h"
 #include "itkIOCommon.h"
 #include "itkFloatingPointExceptions.h"
+#include "itkMultiThreader.h"
+#include "itk_zlib.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace itk
 {
 #define KEY_PREFIX "NRRD_"
 
-NrrdImageIO::NrrdImageIO()
+namespace
+{
+/** Uncompressed size of the blocks that are gzipped independently. */
+const SizeValueType GzipBlockSize = 1024 * 1024;
+
+struct GzipBlocksStruct
+{
+  const Bytef *                       Input;
+  std::vector< SizeValueType >        BlockOffsets;
+  int                                 Level;
+  std::vector< std::vector< Bytef > > Output;
+  std::vector< int >                  Failed;
+};
+
+ITK_THREAD_RETURN_TYPE GzipBlocksThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  GzipBlocksStruct *str = static_cast< GzipBlocksStruct * >( info->UserData );
+
+  const size_t numberOfBlocks = str->BlockOffsets.size() - 1;
+  for ( size_t b = info->ThreadID; b < numberOfBlocks; b += info->NumberOfThreads )
+    {
+    const SizeValueType begin = str->BlockOffsets[b];
+    const uInt          size = static_cast< uInt >( str->BlockOffsets[b + 1] - begin );
+
+    // windowBits of MAX_WBITS + 16 selects the gzip wrapper, so each
+    // block becomes a complete gzip member.
+    z_stream strm;
+    std::memset( &strm, 0, sizeof( strm ) );
+    if ( deflateInit2(&strm, str->Level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK )
+      {
+      str->Failed[b] = 1;
+      continue;
+      }
+    std::vector< Bytef > & output = str->Output[b];
+    output.resize( deflateBound(&strm, size) + 32 );
+    strm.next_in = const_cast< Bytef * >( str->Input + begin );
+    strm.avail_in = size;
+    strm.next_out = &output[0];
+    strm.avail_out = static_cast< uInt >( output.size() );
+    if ( deflate(&strm, Z_FINISH) != Z_STREAM_END )
+      {
+      str->Failed[b] = 1;
+      }
+    output.resize(strm.total_out);
+    deflateEnd(&strm);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/** Append the buffer to the file as a sequence of gzip members,
+ * compressed in parallel. Returns false on any failure. */
+bool AppendGzipMembers(const std::string & fileName, const void *buffer, SizeValueType size, int level)
+{
+  GzipBlocksStruct str;
+  str.Input = static_cast< const Bytef * >( buffer );
+  str.Level = level;
+  SizeValueType offset = 0;
+  do
+    {
+    str.BlockOffsets.push_back(offset);
+    offset = std::min(offset + GzipBlockSize, size);
+    }
+  while ( offset < size );
+  str.BlockOffsets.push_back(size);
+
+  const size_t numberOfBlocks = str.BlockOffsets.size() - 1;
+  str.Output.assign( numberOfBlocks, std::vector< Bytef >() );
+  str.Failed.assign(numberOfBlocks, 0);
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( static_cast< ThreadIdType >(
+    std::min< size_t >( numberOfBlocks, MultiThreader::GetGlobalDefaultNumberOfThreads() ) ) );
+  threader->SetSingleMethod(GzipBlocksThreaderCallback, &str);
+  threader->SingleMethodExecute();
+  if ( std::find( str.Failed.begin(), str.Failed.end(), 1 ) != str.Failed.end() )
+    {
+    return false;
+    }
+
+  std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+  for ( size_t b = 0; b < numberOfBlocks && file; ++b )
+    {
+    file.write( reinterpret_cast< const char * >( &str.Output[b][0] ),
+                static_cast< std::streamsize >( str.Output[b].size() ) );
+    }
+  return !file.fail();
+}
+} // end anonymous namespace
+
+NrrdImageIO::NrrdImageIO():
+  m_CompressionLevel(6)
 {
   this->SetNumberOfDimensions(3);
   this->AddSupportedWriteExtension(".nrrd");
@@ -55,6 +152,7 @@ bool NrrdImageIO::SupportsDimension(unsigned long dim)
 void NrrdImageIO::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "CompressionLevel: " << m_CompressionLevel << std::endl;
 }
 
 ImageIOBase::IOComponentType
@@ -1077,11 +1175,25 @@ void NrrdImageIO::Write(const void *buffer)
     }
 
   // set encoding for data: compressed (raw), (uncompressed) raw, or ascii
+  bool appendGzipMembers = false;
   if ( this->GetUseCompression() == true
        && nrrdEncodingGzip->available() )
     {
     // this is necessarily gzip-compressed *raw* data
     nio->encoding = nrrdEncodingGzip;
+    nio->zlibLevel = m_CompressionLevel;
+
+    // With an attached header in native byte order, NrrdIO writes only
+    // the header and the data are appended below as gzip members that are
+    // compressed in parallel. gzip readers decode concatenated members as
+    // a single stream.
+    const std::string fileName = this->GetFileName();
+    const ByteOrder   byteOrder = this->GetByteOrder();
+    appendGzipMembers =
+      !( fileName.size() >= 5 && fileName.compare(fileName.size() - 5, 5, ".nhdr") == 0 )
+      && ( byteOrder == OrderNotApplicable
+           || ( byteOrder == BigEndian ) == ( airMyEndian() == airEndianBig ) );
+    nio->skipData = appendGzipMembers ? AIR_TRUE : AIR_FALSE;
     }
   else
     {
@@ -1126,6 +1238,15 @@ void NrrdImageIO::Write(const void *buffer)
   // Free the nrrd struct but don't touch nrrd->data
   nrrdNix(nrrd);
   nrrdIoStateNix(nio);
+
+  if ( appendGzipMembers
+       && !AppendGzipMembers(this->GetFileName(), buffer,
+                             static_cast< SizeValueType >( this->GetImageSizeInBytes() ),
+                             m_CompressionLevel) )
+    {
+    itkExceptionMacro("Write: Error writing compressed data to "
+                      << this->GetFileName());
+    }
 }
 
 } // end namespace itk
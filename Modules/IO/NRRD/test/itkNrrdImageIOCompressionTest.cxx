@@ -0,0 +1,159 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkNrrdImageIO.h"
+#include "itkTestingImageIOCompression.h"
+#include "itkTestingMacros.h"
+#include "itk_zlib.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "itksys/SystemTools.hxx"
+
+// Write compressed NRRD files at several compression levels and read
+// them back, check that the data of a .nrrd file is a standard gzip
+// stream, then time the single gzip stream NrrdIO writes, still used
+// for .nhdr files, against the parallel gzip members of .nrrd files.
+namespace
+{
+typedef itk::Testing::CompressionTestImageType ImageType;
+
+void
+WriteSingleStream(const ImageType * image, const std::string & fileName)
+{
+  itk::Testing::WriteCompressedImage< itk::NrrdImageIO >( image, fileName + ".nhdr", 6 );
+}
+
+void
+WriteBlocks(const ImageType * image, const std::string & fileName)
+{
+  itk::Testing::WriteCompressedImage< itk::NrrdImageIO >( image, fileName + ".nrrd", 6 );
+}
+
+/** Inflate the data after the header of a .nrrd file with zlib alone,
+ * member after member, and compare it with the pixel buffer. */
+bool
+CheckGzipData(const std::string & fileName, const ImageType * image, unsigned int & numberOfMembers)
+{
+  std::ifstream        file( fileName.c_str(), std::ios::in | std::ios::binary );
+  std::vector< char >  contents( ( std::istreambuf_iterator< char >( file ) ), std::istreambuf_iterator< char >() );
+  const std::string    blankLine( "\n\n" );
+  std::vector< char >::iterator dataBegin =
+    std::search( contents.begin(), contents.end(), blankLine.begin(), blankLine.end() );
+  if ( dataBegin == contents.end() )
+    {
+    std::cerr << "No end of header in " << fileName << std::endl;
+    return false;
+    }
+  dataBegin += blankLine.size();
+
+  const size_t         size = image->GetLargestPossibleRegion().GetNumberOfPixels() * sizeof( ImageType::PixelType );
+  std::vector< Bytef > data( size + 1 );
+  z_stream             strm;
+  std::memset( &strm, 0, sizeof( strm ) );
+  if ( inflateInit2(&strm, MAX_WBITS + 16) != Z_OK )
+    {
+    return false;
+    }
+  strm.next_in = reinterpret_cast< Bytef * >( &*dataBegin );
+  strm.avail_in = static_cast< uInt >( contents.end() - dataBegin );
+  strm.next_out = &data[0];
+  strm.avail_out = static_cast< uInt >( data.size() );
+  numberOfMembers = 0;
+  bool inflated = false;
+  for (;; )
+    {
+    const int status = inflate(&strm, Z_NO_FLUSH);
+    if ( status == Z_STREAM_END )
+      {
+      ++numberOfMembers;
+      if ( strm.avail_in == 0 )
+        {
+        inflated = true;
+        break;
+        }
+      inflateReset(&strm);
+      }
+    else if ( status != Z_OK )
+      {
+      break;
+      }
+    }
+  const size_t inflatedSize = data.size() - strm.avail_out;
+  inflateEnd(&strm);
+  if ( !inflated || inflatedSize != size )
+    {
+    std::cerr << "zlib inflated " << inflatedSize << " bytes instead of " << size
+              << " from " << fileName << std::endl;
+    return false;
+    }
+  if ( std::memcmp( &data[0], image->GetBufferPointer(), size ) != 0 )
+    {
+    std::cerr << "zlib inflated other bytes than the pixels from " << fileName << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+int itkNrrdImageIOCompressionTest(int argc, char* argv[])
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " OutputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string prefix = std::string( argv[1] ) + "/itkNrrdImageIOCompressionTest";
+
+  ImageType::Pointer image = itk::Testing::MakeCompressionTestImage();
+
+  itk::NrrdImageIO::Pointer io = itk::NrrdImageIO::New();
+  EXERCISE_BASIC_OBJECT_METHODS( io, NrrdImageIO, ImageIOBase );
+
+  const char * const extensions[] = { ".nrrd", ".nhdr" };
+  if ( !itk::Testing::TestImageIOCompressionLevels< itk::NrrdImageIO >( image, prefix, extensions, 2 ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The attached-header files hold the whole compressed stream.
+  const unsigned long storedLength = itksys::SystemTools::FileLength( prefix + "0.nrrd" );
+  const unsigned long fastLength = itksys::SystemTools::FileLength( prefix + "1.nrrd" );
+  std::cout << "Compressed size at level 0: " << storedLength << " bytes, at level 1: "
+            << fastLength << " bytes" << std::endl;
+  TEST_EXPECT_TRUE( fastLength < storedLength );
+
+  // One gzip member per MiB of pixel data.
+  unsigned int numberOfMembers = 0;
+  if ( !CheckGzipData( prefix + "6.nrrd", image, numberOfMembers ) )
+    {
+    return EXIT_FAILURE;
+    }
+  TEST_EXPECT_EQUAL( numberOfMembers, 8u );
+
+  const double singleStreamTime = itk::Testing::TimeCompressedWrite( WriteSingleStream, image, prefix + "Timing" );
+  const double blocksTime = itk::Testing::TimeCompressedWrite( WriteBlocks, image, prefix + "Timing" );
+  itk::Testing::ReportCompressedWriteTime( "Level 6, single gzip stream", image, singleStreamTime );
+  itk::Testing::ReportCompressedWriteTime( "Level 6, gzip members in parallel", image, blocksTime );
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
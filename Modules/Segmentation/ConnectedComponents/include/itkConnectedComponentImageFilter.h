@@ -23,7 +23,8 @@
 #include <vector>
 #include <map>
 #include "itkProgressReporter.h"
-#include "itkBarrier.h"
+#include "itkImageRegionSplitterDirection.h"
+#include "itkScanlineConnectedComponents.h"
 
 namespace itk
 {
@@ -45,9 +46,13 @@ namespace itk
  *
  * After the filter is executed, ObjectCount holds the number of connected components.
  *
- * \sa ImageToImageFilter
+ * All the steps are multithreaded: the threads encode the lines of
+ * their region, merge the runs of their region, then merge the regions
+ * along their boundaries and write the output, see
+ * ScanlineConnectedComponents.
+ *
+ * \sa ImageToImageFilter, ScanlineConnectedComponents
  *
- * \ingroup SingleThreaded
  * \ingroup ITKConnectedComponents
  *
  * \wiki
@@ -161,6 +166,8 @@ protected:
     m_FullyConnected = false;
     m_ObjectCount = 0;
     m_BackgroundValue = NumericTraits< OutputImagePixelType >::ZeroValue();
+    m_ImageRegionSplitter = ImageRegionSplitterDirection::New();
+    m_ImageRegionSplitter->SetDirection(0);
 
     // implicit
     // #0 "Primary" required
@@ -192,6 +199,13 @@ protected:
    * \sa ProcessObject::EnlargeOutputRequestedRegion() */
   void EnlargeOutputRequestedRegion( DataObject * itkNotUsed(output) ) ITK_OVERRIDE;
 
+  /** Provide an ImageRegionSplitter that does not split along the first
+   * dimension -- the threads process complete lines. */
+  virtual const ImageRegionSplitterBase* GetImageRegionSplitter() const ITK_OVERRIDE
+  {
+    return m_ImageRegionSplitter.GetPointer();
+  }
+
   bool m_FullyConnected;
 
 private:
@@ -200,74 +214,16 @@ private:
   LabelType            m_ObjectCount;
   OutputImagePixelType m_BackgroundValue;
 
-  // some additional types
-  typedef typename TOutputImage::RegionType::SizeType OutSizeType;
-
-  // types to support the run length encoding of lines
-  class runLength
-  {
-public:
-    // run length information - may be a more type safe way of doing this
-    typename TInputImage::OffsetValueType   length;
-    typename TInputImage::IndexType         where;   // Index of the start of the run
-    LabelType                               label;   // the initial label of the run
-  };
-
-  typedef std::vector< runLength > lineEncoding;
-
-  // the map storing lines
-  typedef std::vector< lineEncoding > LineMapType;
-
-  typedef std::vector< typename TInputImage::OffsetValueType > OffsetVec;
-
-  // the types to support union-find operations
-  typedef std::vector< LabelType > UnionFindType;
-  UnionFindType m_UnionFind;
-  UnionFindType m_Consecutive;
-
-  // functions to support union-find operations
-  void InitUnion( SizeValueType size )
-  {
-    m_UnionFind = UnionFindType(size + 1);
-  }
-
-  void InsertSet(const LabelType label);
+  typedef ScanlineConnectedComponents< ImageDimension > ScanlineConnectedComponentsType;
+  typedef typename ScanlineConnectedComponentsType::LineEncodingType LineEncodingType;
 
-  SizeValueType LookupSet(const LabelType label);
-
-  void LinkLabels(const LabelType lab1, const LabelType lab2);
-
-  SizeValueType CreateConsecutive();
-
-  //////////////////
-  bool CheckNeighbors(const OutputIndexType & A,
-                      const OutputIndexType & B);
-
-  void CompareLines(lineEncoding & current, const lineEncoding & Neighbour);
-
-  void FillOutput(const LineMapType & LineMap,
-                  ProgressReporter & progress);
-
-  void SetupLineOffsets(OffsetVec & LineOffsets);
-
-  void Wait()
-  {
-    // use m_NumberOfLabels.size() to get the number of thread used
-    if ( m_NumberOfLabels.size() > 1 )
-      {
-      m_Barrier->Wait();
-      }
-  }
-
-  typename std::vector< IdentifierType > m_NumberOfLabels;
-  typename std::vector< IdentifierType > m_FirstLineIdToJoin;
+#if !defined( ITK_WRAPPING_PARSER )
+  ScanlineConnectedComponentsType m_ScanlineConnectedComponents;
+#endif
 
-  typename Barrier::Pointer m_Barrier;
+  ImageRegionSplitterDirection::Pointer m_ImageRegionSplitter;
 
   typename TInputImage::ConstPointer m_Input;
-#if !defined( ITK_WRAPPING_PARSER )
-  LineMapType m_LineMap;
-#endif
 };
 } // end namespace itk
 
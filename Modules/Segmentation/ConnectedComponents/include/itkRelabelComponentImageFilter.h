@@ -20,6 +20,7 @@
 
 #include "itkInPlaceImageFilter.h"
 #include "itkImage.h"
+#include "itksys/hash_map.hxx"
 #include <vector>
 
 namespace itk
@@ -67,9 +68,11 @@ namespace itk
  * controlled via methods in the superclass,
  * InPlaceImageFilter::InPlaceOn() and InPlaceImageFilter::InPlaceOff().
  *
+ * Both the computation of the object sizes and the relabeling are
+ * multithreaded.
+ *
  * \sa ConnectedComponentImageFilter, BinaryThresholdImageFilter, ThresholdImageFilter
  *
- * \ingroup SingleThreaded
  * \ingroup ITKConnectedComponents
  *
  * \wiki
@@ -260,6 +263,9 @@ protected:
    */
   void GenerateData() ITK_OVERRIDE;
 
+  /** Relabel the pixels of a region of the output. */
+  void ThreadedGenerateData(const RegionType & outputRegionForThread, ThreadIdType threadId) ITK_OVERRIDE;
+
   /** RelabelComponentImageFilter needs the entire input. Therefore
    * it must provide an implementation GenerateInputRequestedRegion().
    * \sa ProcessObject::GenerateInputRequestedRegion(). */
@@ -302,9 +308,37 @@ protected:
     }
   };
 
+  // sort in ascending order of the original object number
+  class RelabelComponentObjectNumberComparator
+  {
+  public:
+    bool operator()(const RelabelComponentObjectType & a,
+                    const RelabelComponentObjectType & b)
+    {
+      return a.m_ObjectNumber < b.m_ObjectNumber;
+    }
+  };
+
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(RelabelComponentImageFilter);
 
+  /** Count the pixels of each label in a share of the input. */
+  void ThreadedCountLabels(ThreadIdType threadId, ThreadIdType numberOfThreads);
+
+  static ITK_THREAD_RETURN_TYPE CountLabelsThreaderCallback(void *arg);
+
+  /** Internal structure used for passing the filter to the threads. */
+  struct CountThreadStruct
+  {
+    Self *Filter;
+  };
+
+  typedef itksys::hash_map< LabelType, ObjectSizeType > SizeMapType;
+  typedef itksys::hash_map< LabelType, LabelType >      RelabelMapType;
+
+  std::vector< SizeMapType > m_SizeMaps;
+  RelabelMapType             m_RelabelMap;
+
   LabelType      m_NumberOfObjects;
   LabelType      m_NumberOfObjectsToPrint;
   LabelType      m_OriginalNumberOfObjects;
@@ -22,8 +22,7 @@
 #include "itkImageRegionIterator.h"
 #include "itkNumericTraits.h"
 #include "itkProgressReporter.h"
-#include "itksys/hash_map.hxx"
-#include <map>
+#include <algorithm>
 
 namespace itk
 {
@@ -50,24 +49,8 @@ RelabelComponentImageFilter< TInputImage, TOutputImage >
 {
   SizeValueType i;
 
-  // Use a map to keep track of the size of each object.  Object
-  // number -> ObjectType (which has Object number and the two sizes)
-  typedef itksys::hash_map< LabelType, RelabelComponentObjectType > MapType;
-  MapType sizeMap;
-  typename MapType::iterator mapIt;
-  typedef typename MapType::value_type MapValueType;
-
-  // Get the input and the output
+  // Get the input
   typename TInputImage::ConstPointer input = this->GetInput();
-  typename TOutputImage::Pointer output = this->GetOutput();
-
-  // Setup a progress reporter.  We have 2 stages to the algorithm so
-  // use the total number of pixels accessed. We walk the entire input
-  // in the first pass, then walk just the output requested region in
-  // the second pass.
-  ProgressReporter progress( this, 0,
-                             input->GetRequestedRegion().GetNumberOfPixels()
-                             + output->GetRequestedRegion().GetNumberOfPixels() );
 
   // Calculate the size of pixel
   float physicalPixelSize = 1.0;
@@ -76,46 +59,47 @@ RelabelComponentImageFilter< TInputImage, TOutputImage >
     physicalPixelSize *= input->GetSpacing()[i];
     }
 
-  RelabelComponentObjectType initialSize;
-  initialSize.m_SizeInPixels = 1;
-  initialSize.m_SizeInPhysicalUnits = physicalPixelSize;
-
   // First pass: walk the entire input image and determine what
   // labels are used and the number of pixels used in each label.
-  //
+  // Each thread counts the labels of a piece of the input in its own
+  // map.
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+  m_SizeMaps.clear();
+  m_SizeMaps.resize(numberOfThreads);
+
+  CountThreadStruct str;
+  str.Filter = this;
+  this->GetMultiThreader()->SetNumberOfThreads(numberOfThreads);
+  this->GetMultiThreader()->SetSingleMethod(this->CountLabelsThreaderCallback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
 
-  // walk the input
-  ImageRegionConstIterator< InputImageType > it( input, input->GetRequestedRegion() );
-  it.GoToBegin();
+  // Use a map to keep track of the size of each object.  Object
+  // number -> ObjectType (which has Object number and the two sizes)
+  typedef itksys::hash_map< LabelType, RelabelComponentObjectType > MapType;
+  MapType sizeMap;
+  typename MapType::iterator mapIt;
+  typedef typename MapType::value_type MapValueType;
 
-  while ( !it.IsAtEnd() )
+  for ( typename std::vector< SizeMapType >::const_iterator threadIt = m_SizeMaps.begin();
+        threadIt != m_SizeMaps.end(); ++threadIt )
     {
-    // Get the input pixel value
-    const LabelType inputValue = static_cast< LabelType >( it.Get() );
-
-    // if the input pixel is not the background
-    if ( inputValue != NumericTraits< LabelType >::ZeroValue() )
+    for ( typename SizeMapType::const_iterator sizeIt = threadIt->begin(); sizeIt != threadIt->end(); ++sizeIt )
       {
-      // Does this label already exist
-      mapIt = sizeMap.find(inputValue);
+      mapIt = sizeMap.find(sizeIt->first);
       if ( mapIt == sizeMap.end() )
         {
-        // label is not currently in the map
-        initialSize.m_ObjectNumber = inputValue;
-        sizeMap.insert( MapValueType(inputValue, initialSize) );
+        RelabelComponentObjectType initialSize;
+        initialSize.m_ObjectNumber = sizeIt->first;
+        initialSize.m_SizeInPixels = sizeIt->second;
+        sizeMap.insert( MapValueType(sizeIt->first, initialSize) );
         }
       else
         {
-        // label is already in the map, update the values
-        ( *mapIt ).second.m_SizeInPixels++;
-        ( *mapIt ).second.m_SizeInPhysicalUnits += physicalPixelSize;
+        ( *mapIt ).second.m_SizeInPixels += sizeIt->second;
         }
       }
-
-    // increment the iterators
-    ++it;
-    progress.CompletedPixel();
     }
+  m_SizeMaps.clear();
 
   // Now we need to reorder the labels. Use the m_ObjectSortingOrder
   // to determine how to sort the objects. Define a map for converting
@@ -125,24 +109,30 @@ RelabelComponentImageFilter< TInputImage, TOutputImage >
   VectorType sizeVector;
   typename VectorType::iterator vit;
 
-  typedef std::map< LabelType, LabelType >    RelabelMapType;
   typedef typename RelabelMapType::value_type RelabelMapValueType;
-  RelabelMapType relabelMap;
+  m_RelabelMap.clear();
 
   // copy the original object map to a vector so we can sort it
   for ( mapIt = sizeMap.begin(); mapIt != sizeMap.end(); ++mapIt )
     {
+    ( *mapIt ).second.m_SizeInPhysicalUnits = ( *mapIt ).second.m_SizeInPixels * physicalPixelSize;
     sizeVector.push_back( ( *mapIt ).second );
     }
 
   // Sort the objects by size by default, unless m_SortByObjectSize
-  // is set to false.
+  // is set to false.  In that case, keep the order of the labels.
   if ( m_SortByObjectSize )
     {
     std::sort(  sizeVector.begin(),
                 sizeVector.end(),
                 RelabelComponentSizeInPixelsComparator() );
     }
+  else
+    {
+    std::sort(  sizeVector.begin(),
+                sizeVector.end(),
+                RelabelComponentObjectNumberComparator() );
+    }
 
   // create a lookup table to map the input label to the output label.
   // cache the object sizes for later access by the user
@@ -161,13 +151,13 @@ RelabelComponentImageFilter< TInputImage, TOutputImage >
       {
       // map small objects to the background
       NumberOfObjectsRemoved++;
-      relabelMap.insert( RelabelMapValueType( ( *vit ).m_ObjectNumber, 0 ) );
+      m_RelabelMap.insert( RelabelMapValueType( ( *vit ).m_ObjectNumber, 0 ) );
       }
     else
       {
       // map for input labels to output labels (Note we use i+1 in the
       // map since index 0 is the background)
-      relabelMap.insert( RelabelMapValueType( ( *vit ).m_ObjectNumber, i + 1 ) );
+      m_RelabelMap.insert( RelabelMapValueType( ( *vit ).m_ObjectNumber, i + 1 ) );
 
       // cache object sizes for later access by the user
       m_SizeOfObjectsInPixels[i] = ( *vit ).m_SizeInPixels;
@@ -185,36 +175,119 @@ RelabelComponentImageFilter< TInputImage, TOutputImage >
     }
 
   // Second pass: walk just the output requested region and relabel
-  // the necessary pixels.
+  // the necessary pixels, in parallel.
   //
 
   // Allocate the output
   this->AllocateOutputs();
 
+  typename ImageSource< OutputImageType >::ThreadStruct relabelStr;
+  relabelStr.Filter = this;
+  this->GetMultiThreader()->SetNumberOfThreads(numberOfThreads);
+  this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &relabelStr);
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  m_RelabelMap.clear();
+}
+
+template< typename TInputImage, typename TOutputImage >
+ITK_THREAD_RETURN_TYPE
+RelabelComponentImageFilter< TInputImage, TOutputImage >
+::CountLabelsThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  CountThreadStruct * str = static_cast< CountThreadStruct * >( info->UserData );
+
+  str->Filter->ThreadedCountLabels( info->ThreadID, info->NumberOfThreads );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RelabelComponentImageFilter< TInputImage, TOutputImage >
+::ThreadedCountLabels(ThreadIdType threadId, ThreadIdType numberOfThreads)
+{
+  const InputImageType * input = this->GetInput();
+
+  // the piece of the input for this thread
+  typename InputImageType::RegionType region = input->GetRequestedRegion();
+  const ImageRegionSplitterBase * splitter = this->GetImageRegionSplitter();
+  const unsigned int numberOfPieces = splitter->GetNumberOfSplits(region, numberOfThreads);
+  if ( threadId >= numberOfPieces )
+    {
+    return;
+    }
+  splitter->GetSplit(threadId, numberOfPieces, region);
+
+  // Setup a progress reporter.  We have 2 stages to the algorithm:
+  // the counting of the labels in the input, then the relabeling of the
+  // output requested region.
+  ProgressReporter progress( this, threadId, region.GetNumberOfPixels(), 100, 0.0f, 0.5f );
+
+  SizeMapType & sizeMap = m_SizeMaps[threadId];
+
+  // the labels usually come in runs: keep the count of the last label
+  // seen to avoid looking it up for each pixel
+  LabelType        lastLabel = NumericTraits< LabelType >::ZeroValue();
+  ObjectSizeType * lastSize = ITK_NULLPTR;
+
+  ImageRegionConstIterator< InputImageType > it( input, region );
+  while ( !it.IsAtEnd() )
+    {
+    // Get the input pixel value
+    const LabelType inputValue = static_cast< LabelType >( it.Get() );
+
+    // if the input pixel is not the background
+    if ( inputValue != NumericTraits< LabelType >::ZeroValue() )
+      {
+      if ( lastSize == ITK_NULLPTR || inputValue != lastLabel )
+        {
+        // the map elements do not move when the map grows
+        lastSize = &sizeMap[inputValue];
+        lastLabel = inputValue;
+        }
+      ++( *lastSize );
+      }
+
+    // increment the iterator
+    ++it;
+    progress.CompletedPixel();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+RelabelComponentImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(const RegionType & outputRegionForThread, ThreadIdType threadId)
+{
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels(), 100, 0.5f, 0.5f );
+
   // Remap the labels.  Note we only walk the region of the output
   // that was requested.  This may be a subset of the input image.
-  OutputPixelType                        outputValue;
-  ImageRegionIterator< OutputImageType > oit;
-  oit = ImageRegionIterator< OutputImageType >( output,
-                                                output->GetRequestedRegion() );
-  it = ImageRegionConstIterator< InputImageType >( input,
-                                                   output->GetRequestedRegion() );
-
-  it.GoToBegin();
-  oit.GoToBegin();
+  ImageRegionIterator< OutputImageType >     oit( this->GetOutput(), outputRegionForThread );
+  ImageRegionConstIterator< InputImageType > it( this->GetInput(), outputRegionForThread );
+
+  LabelType       lastLabel = NumericTraits< LabelType >::ZeroValue();
+  OutputPixelType lastOutputValue = NumericTraits< OutputPixelType >::ZeroValue();
+
   while ( !oit.IsAtEnd() )
     {
     const LabelType inputValue = static_cast< LabelType >( it.Get() );
 
     if ( inputValue != NumericTraits< LabelType >::ZeroValue() )
       {
-      // lookup the mapped label
-      outputValue = static_cast< OutputPixelType >( relabelMap[inputValue] );
-      oit.Set(outputValue);
+      // lookup the mapped label, unless it is the same as the last one
+      if ( inputValue != lastLabel )
+        {
+        lastOutputValue = static_cast< OutputPixelType >( m_RelabelMap.find(inputValue)->second );
+        lastLabel = inputValue;
+        }
+      oit.Set(lastOutputValue);
       }
     else
       {
-      oit.Set(inputValue);
+      oit.Set( static_cast< OutputPixelType >( it.Get() ) );
       }
 
     // increment the iterators
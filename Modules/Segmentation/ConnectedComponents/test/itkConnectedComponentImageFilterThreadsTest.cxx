@@ -0,0 +1,222 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkConnectedComponentImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkRelabelComponentImageFilter.h"
+#include "itkTestingMacros.h"
+#include <queue>
+
+// Compare the connected components found with several numbers of
+// threads with the components found by a flood fill, then check that
+// the relabeling does not depend on the number of threads either.
+namespace
+{
+
+template< typename TImage >
+typename TImage::Pointer
+MakeRandomImage(const typename TImage::SizeType & size, unsigned int seed, unsigned int density)
+{
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+  unsigned int value = seed;
+  itk::ImageRegionIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    value = value * 1664525u + 1013904223u;
+    it.Set( ( ( value >> 8 ) % 100 ) < density ? 1 : 0 );
+    }
+  return image;
+}
+
+// Label the components in raster order of their first pixel.
+template< typename TInputImage, typename TOutputImage >
+typename TOutputImage::Pointer
+FloodFill(const TInputImage * input, bool fullyConnected)
+{
+  typedef typename TInputImage::IndexType  IndexType;
+  typedef typename TInputImage::OffsetType OffsetType;
+  const unsigned int Dimension = TInputImage::ImageDimension;
+
+  const typename TInputImage::RegionType region = input->GetLargestPossibleRegion();
+  typename TOutputImage::Pointer output = TOutputImage::New();
+  output->SetRegions(region);
+  output->Allocate();
+  output->FillBuffer(0);
+
+  std::vector< OffsetType > offsets;
+  unsigned int numberOfOffsets = 1;
+  for ( unsigned int i = 0; i < Dimension; ++i )
+    {
+    numberOfOffsets *= 3;
+    }
+  for ( unsigned int n = 0; n < numberOfOffsets; ++n )
+    {
+    OffsetType   offset;
+    unsigned int code = n;
+    unsigned int nonZero = 0;
+    for ( unsigned int i = 0; i < Dimension; ++i )
+      {
+      offset[i] = static_cast< int >( code % 3 ) - 1;
+      code /= 3;
+      nonZero += ( offset[i] != 0 );
+      }
+    if ( nonZero == 1 || ( fullyConnected && nonZero > 1 ) )
+      {
+      offsets.push_back(offset);
+      }
+    }
+
+  typename TOutputImage::PixelType label = 0;
+  itk::ImageRegionIteratorWithIndex< TOutputImage > it( output, region );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != 0 || input->GetPixel( it.GetIndex() ) == 0 )
+      {
+      continue;
+      }
+    ++label;
+    std::queue< IndexType > front;
+    front.push( it.GetIndex() );
+    output->SetPixel( it.GetIndex(), label );
+    while ( !front.empty() )
+      {
+      const IndexType current = front.front();
+      front.pop();
+      for ( size_t o = 0; o < offsets.size(); ++o )
+        {
+        const IndexType neighbor = current + offsets[o];
+        if ( region.IsInside(neighbor) && input->GetPixel(neighbor) != 0
+             && output->GetPixel(neighbor) == 0 )
+          {
+          output->SetPixel(neighbor, label);
+          front.push(neighbor);
+          }
+        }
+      }
+    }
+  return output;
+}
+
+template< typename TImage >
+bool
+SameImages(const TImage * expected, const TImage * actual)
+{
+  itk::ImageRegionConstIterator< TImage > eit( expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > ait( actual, expected->GetLargestPossibleRegion() );
+  for ( ; !eit.IsAtEnd(); ++eit, ++ait )
+    {
+    if ( eit.Get() != ait.Get() )
+      {
+      std::cerr << "Expected " << static_cast< double >( eit.Get() ) << " at " << eit.GetIndex()
+                << ", got " << static_cast< double >( ait.Get() ) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+TestConnectedComponents(const typename TInputImage::SizeType & size, const char * name)
+{
+  typedef itk::ConnectedComponentImageFilter< TInputImage, TOutputImage > FilterType;
+  typedef itk::RelabelComponentImageFilter< TOutputImage, TOutputImage >  RelabelType;
+
+  const unsigned int numberOfThreads[] = { 1, 2, 3, 5, 8 };
+  const unsigned int densities[] = { 30, 55, 80 };
+
+  bool success = true;
+  for ( unsigned int d = 0; d < 3; ++d )
+    {
+    typename TInputImage::Pointer input = MakeRandomImage< TInputImage >( size, 11 + d, densities[d] );
+    for ( unsigned int fully = 0; fully < 2; ++fully )
+      {
+      typename TOutputImage::Pointer expected = FloodFill< TInputImage, TOutputImage >( input, fully != 0 );
+
+      typename TOutputImage::Pointer relabeled;
+      for ( unsigned int t = 0; t < 5; ++t )
+        {
+        typename FilterType::Pointer filter = FilterType::New();
+        filter->SetInput( input );
+        filter->SetFullyConnected( fully != 0 );
+        filter->SetNumberOfThreads( numberOfThreads[t] );
+        filter->Update();
+
+        std::cout << name << ", density " << densities[d] << ( fully ? ", fully connected" : "" )
+                  << ", " << numberOfThreads[t] << " thread(s): "
+                  << filter->GetObjectCount() << " objects" << std::endl;
+        if ( !SameImages< TOutputImage >( expected, filter->GetOutput() ) )
+          {
+          success = false;
+          continue;
+          }
+
+        typename RelabelType::Pointer relabel = RelabelType::New();
+        relabel->SetInput( filter->GetOutput() );
+        relabel->SetMinimumObjectSize( 2 );
+        relabel->SetNumberOfThreads( numberOfThreads[t] );
+        relabel->Update();
+        if ( relabeled.IsNull() )
+          {
+          relabeled = relabel->GetOutput();
+          relabeled->DisconnectPipeline();
+          }
+        else if ( !SameImages< TOutputImage >( relabeled, relabel->GetOutput() ) )
+          {
+          std::cerr << "The relabeling depends on the number of threads" << std::endl;
+          success = false;
+          }
+        }
+      }
+    }
+  return success;
+}
+
+}
+
+int itkConnectedComponentImageFilterThreadsTest(int, char* [])
+{
+  typedef itk::Image< unsigned char, 2 >  InputImageType2D;
+  typedef itk::Image< unsigned int, 2 >   OutputImageType2D;
+  typedef itk::Image< short, 3 >          InputImageType3D;
+  typedef itk::Image< unsigned long, 3 >  OutputImageType3D;
+
+  bool success = true;
+
+  InputImageType2D::SizeType size2D;
+  size2D[0] = 53;
+  size2D[1] = 41;
+  success &= TestConnectedComponents< InputImageType2D, OutputImageType2D >( size2D, "2D" );
+
+  InputImageType3D::SizeType size3D;
+  size3D[0] = 17;
+  size3D[1] = 13;
+  size3D[2] = 11;
+  success &= TestConnectedComponents< InputImageType3D, OutputImageType3D >( size3D, "3D" );
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -19,6 +19,9 @@
 #define itkMorphologicalWatershedFromMarkersImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include <map>
+#include <utility>
+#include <vector>
 
 namespace itk
 {
@@ -60,6 +63,14 @@ namespace itk
  * the markers. The labels of the output image are the label of the marker
  * image.
  *
+ * The flooding is multithreaded. The pixels of a level of the hierarchical
+ * queue are processed breadth first, and the large fronts are processed by
+ * several threads: each thread computes the labels of a part of the front,
+ * and the pixels reached by several threads are given to the first one in
+ * the order of the queue. The few pixels where two labels meet within a
+ * front are resolved in that order too, so the output is identical to the
+ * one of the sequential algorithm, for any number of threads.
+ *
  * The morphological watershed transform algorithm is described in
  * Chapter 9.2 of Pierre Soille's book "Morphological Image Analysis:
  * Principles and Applications", Second Edition, Springer, 2003.
@@ -172,12 +183,120 @@ protected:
    * \sa ProcessObject::EnlargeOutputRequestedRegion() */
   void EnlargeOutputRequestedRegion( DataObject *itkNotUsed(output) ) ITK_OVERRIDE;
 
-  /** The filter is single threaded. */
+  /** The flooding is multithreaded, by front of the hierarchical queue. */
   void GenerateData() ITK_OVERRIDE;
 
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(MorphologicalWatershedFromMarkersImageFilter);
 
+  /** The pixels are addressed by their offset in the buffers. */
+  typedef std::vector< OffsetValueType >                                   OffsetVectorType;
+  typedef std::map< InputImagePixelType, OffsetVectorType >                HierarchicalQueueType;
+  typedef std::vector< std::pair< InputImagePixelType, OffsetValueType > > QueuedPixelVectorType;
+  typedef typename LabelImageType::OffsetType                              OffsetType;
+  typedef typename LabelImageType::SizeType                                SizeType;
+
+  /** A pixel reached by a pixel of the front. Among the claims of a
+   * pixel, the first one in the order of the front is accepted. */
+  struct ClaimType
+    {
+    OffsetValueType Pixel;
+    SizeValueType   Parent;
+    bool            Accepted;
+    };
+  typedef std::vector< ClaimType > ClaimVectorType;
+
+  /** The steps of the flooding run by the threads. */
+  enum FloodPhaseType {
+    MeyerInitPhase,
+    BeucherInitPhase,
+    MeyerLabelPhase,
+    MeyerMarkFrontPhase,
+    MeyerClaimPhase,
+    BeucherClaimPhase,
+    AcceptClaimsPhase,
+    GatherClaimsPhase
+    };
+
+  /** Bits of the status of the pixels in Meyer's algorithm. */
+  enum {
+    QueuedStatus = 1,
+    FrontStatus = 2
+    };
+
+  /** The data shared by the threads. The claims are stored by thread and
+   * by thread owning the claimed pixel, so a pixel is only modified by its
+   * owner when the claims are accepted. */
+  struct FloodThreadStruct
+    {
+    FloodPhaseType                                 Phase;
+    ThreadIdType                                   NumberOfThreads;
+    const InputImagePixelType *                    Input;
+    const LabelImagePixelType *                    Marker;
+    LabelImagePixelType *                          Output;
+    unsigned char *                                Status;
+    SizeValueType                                  NumberOfPixels;
+    SizeType                                       Size;
+    OffsetValueType                                Strides[ImageDimension];
+    std::vector< OffsetValueType >                 NeighborOffsets;
+    std::vector< OffsetType >                      NeighborIndexOffsets;
+    const OffsetVectorType *                       Front;
+    InputImagePixelType                            CurrentValue;
+    bool                                           Initializing;
+    std::vector< LabelImagePixelType >             Labels;
+    std::vector< std::vector< ClaimVectorType > >  Claims;
+    std::vector< std::vector< ThreadIdType > >     ClaimOwners;
+    std::vector< std::vector< SizeValueType > >    Contested;
+    std::vector< OffsetVectorType >                Next;
+    std::vector< QueuedPixelVectorType >           Higher;
+    };
+
+  static ITK_THREAD_RETURN_TYPE FloodThreaderCallback( void *arg );
+
+  /** Run a phase of the flooding with all the threads. */
+  void RunFloodPhase( FloodThreadStruct & str, FloodPhaseType phase );
+
+  /** Process a front with one thread, exactly as the queue would. */
+  static void MeyerFloodFront( FloodThreadStruct & str, HierarchicalQueueType & fah,
+                               OffsetVectorType & next );
+  static void BeucherFloodFront( FloodThreadStruct & str, HierarchicalQueueType & fah,
+                                 OffsetVectorType & next );
+
+  /** Process a front with all the threads. */
+  void MeyerFloodFrontInParallel( FloodThreadStruct & str, HierarchicalQueueType & fah,
+                                  OffsetVectorType & next );
+  void BeucherFloodFrontInParallel( FloodThreadStruct & str, HierarchicalQueueType & fah,
+                                    OffsetVectorType & next );
+
+  /** Append the pixels gathered by the threads to the next front and to
+   * the hierarchical queue, in the order of the threads. */
+  static void MergeQueuedPixels( FloodThreadStruct & str, HierarchicalQueueType & fah,
+                                 OffsetVectorType & next );
+
+  /** The phases run by each thread. */
+  static void ThreadedMeyerInit( FloodThreadStruct & str, ThreadIdType threadId );
+  static void ThreadedBeucherInit( FloodThreadStruct & str, ThreadIdType threadId );
+  static void ThreadedMeyerLabel( FloodThreadStruct & str, ThreadIdType threadId );
+  static void ThreadedMeyerMarkFront( FloodThreadStruct & str, ThreadIdType threadId );
+  static void ThreadedMeyerClaim( FloodThreadStruct & str, ThreadIdType threadId );
+  static void ThreadedBeucherClaim( FloodThreadStruct & str, ThreadIdType threadId );
+  static void ThreadedAcceptClaims( FloodThreadStruct & str, ThreadIdType threadId );
+  static void ThreadedGatherClaims( FloodThreadStruct & str, ThreadIdType threadId );
+
+  /** Compute the index of a pixel from its offset, and return whether all
+   * its neighbors are in the image. */
+  static bool ComputeIndex( const FloodThreadStruct & str, OffsetValueType offset,
+                            OffsetType & index );
+
+  /** Return whether the k-th neighbor of a pixel is in the image. */
+  static bool IsNeighborInside( const FloodThreadStruct & str, const OffsetType & index,
+                                unsigned int k );
+
+  /** Record the claim of a pixel by the pixel of the front at the given
+   * position. */
+  static void Claim( FloodThreadStruct & str, ThreadIdType threadId,
+                     OffsetValueType pixel, SizeValueType parent );
+
   bool m_FullyConnected;
 
   bool m_MarkWatershedLine;
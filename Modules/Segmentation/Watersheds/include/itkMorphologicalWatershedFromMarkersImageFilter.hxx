@@ -19,16 +19,8 @@
 #define itkMorphologicalWatershedFromMarkersImageFilter_hxx
 
 #include <algorithm>
-#include <queue>
-#include <list>
 #include "itkMorphologicalWatershedFromMarkersImageFilter.h"
-#include "itkProgressReporter.h"
-#include "itkImageRegionIterator.h"
-#include "itkImageRegionConstIteratorWithIndex.h"
-#include "itkConstShapedNeighborhoodIterator.h"
-#include "itkConstantBoundaryCondition.h"
-#include "itkSize.h"
-#include "itkConnectedComponentAlgorithm.h"
+#include "itkMultiThreader.h"
 
 namespace itk
 {
@@ -91,19 +83,13 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
   // the algorithm with watershed lines is from Meyer
   // the algorithm without watershed lines is from beucher
   // The 2 algorithms are very similar and so are integrated in the same filter.
-
-  //---------------------------------------------------------------------------
-  // declare the vars common to the 2 algorithms: constants, iterators,
-  // hierarchical queue, progress reporter, and status image
-  // also allocate output images and verify preconditions
-  //---------------------------------------------------------------------------
-
-  // the label used to find background in the marker image
-  static const LabelImagePixelType bgLabel =
-    NumericTraits< LabelImagePixelType >::ZeroValue();
-  // the label used to mark the watershed line in the output image
-  static const LabelImagePixelType wsLabel =
-    NumericTraits< LabelImagePixelType >::ZeroValue();
+  //
+  // The pixels of a level of the hierarchical queue are processed in
+  // fronts: the pixels added to the queue of the current level while a
+  // front is processed make the next front. The large fronts are split
+  // between the threads, and every decision depending on the order of the
+  // queue is taken in that order, so the output does not depend on the
+  // number of threads.
 
   this->AllocateOutputs();
 
@@ -111,338 +97,845 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
   const InputImageType * inputImage = this->GetInput();
   LabelImageType * outputImage = this->GetOutput();
 
-  // Set up the progress reporter
-  // we can't found the exact number of pixel to process in the 2nd pass, so we
-  // use the maximum number possible.
-  ProgressReporter progress(this, 0, markerImage->GetRequestedRegion().GetNumberOfPixels() * 2);
-
   // mask and marker must have the same size
   if ( markerImage->GetRequestedRegion().GetSize() != inputImage->GetRequestedRegion().GetSize() )
     {
     itkExceptionMacro(<< "Marker and input must have the same size.");
     }
 
+  // the images are completely buffered, so the pixels are addressed by
+  // their offset in the buffers
+  const LabelImageRegionType region = outputImage->GetRequestedRegion();
+  const SizeValueType numberOfPixels = region.GetNumberOfPixels();
+  if ( numberOfPixels == 0 )
+    {
+    return;
+    }
+
+  FloodThreadStruct str;
+  str.Input = inputImage->GetBufferPointer();
+  str.Marker = markerImage->GetBufferPointer();
+  str.Output = outputImage->GetBufferPointer();
+  str.Status = ITK_NULLPTR;
+  str.NumberOfPixels = numberOfPixels;
+  str.Size = region.GetSize();
+  str.Strides[0] = 1;
+  for ( unsigned int d = 1; d < ImageDimension; ++d )
+    {
+    str.Strides[d] = str.Strides[d - 1] * static_cast< OffsetValueType >( str.Size[d - 1] );
+    }
+  str.Front = ITK_NULLPTR;
+  str.CurrentValue = NumericTraits< InputImagePixelType >::ZeroValue();
+  str.Initializing = true;
+
+  // the neighbors are visited in the order of the neighborhood iterators
+  // configured by setConnectivity()
+  unsigned int neighborhoodSize = 1;
+  for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+    neighborhoodSize *= 3;
+    }
+  for ( unsigned int n = 0; n < neighborhoodSize; ++n )
+    {
+    OffsetType      offset;
+    OffsetValueType linearOffset = 0;
+    unsigned int    numberOfNonZero = 0;
+    unsigned int    remainder = n;
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      offset[d] = static_cast< OffsetValueType >( remainder % 3 ) - 1;
+      remainder /= 3;
+      linearOffset += offset[d] * str.Strides[d];
+      if ( offset[d] != 0 )
+        {
+        ++numberOfNonZero;
+        }
+      }
+    if ( numberOfNonZero == 1 || ( numberOfNonZero > 1 && m_FullyConnected ) )
+      {
+      str.NeighborOffsets.push_back( linearOffset );
+      str.NeighborIndexOffsets.push_back( offset );
+      }
+    }
+
+  MultiThreader * threader = this->GetMultiThreader();
+  threader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  const ThreadIdType numberOfThreads = threader->GetNumberOfThreads();
+  str.NumberOfThreads = numberOfThreads;
+  str.Claims.resize( numberOfThreads, std::vector< ClaimVectorType >( numberOfThreads ) );
+  str.ClaimOwners.resize( numberOfThreads );
+  str.Contested.resize( numberOfThreads );
+  str.Next.resize( numberOfThreads );
+  str.Higher.resize( numberOfThreads );
+
+  // the fronts smaller than that are not worth the synchronization of the
+  // threads
+  const SizeValueType minimumFrontSize = 2048 * static_cast< SizeValueType >( numberOfThreads );
+
   // FAH (in french: File d'Attente Hierarchique)
-  typedef std::queue< IndexType >                    QueueType;
-  typedef std::map< InputImagePixelType, QueueType > MapType;
-  MapType fah;
-
-  // the radius which will be used for all the shaped iterators
-  Size< ImageDimension > radius;
-  radius.Fill(1);
-
-  // iterator for the marker image
-  typedef ConstShapedNeighborhoodIterator< LabelImageType > MarkerIteratorType;
-  typename MarkerIteratorType::ConstIterator nmIt;
-  MarkerIteratorType
-  markerIt( radius, markerImage, markerImage->GetRequestedRegion() );
-  // add a boundary constant to avoid adding pixels on the border in the fah
-  ConstantBoundaryCondition< LabelImageType > lcbc;
-  lcbc.SetConstant( NumericTraits< LabelImagePixelType >::max() );
-  markerIt.OverrideBoundaryCondition(&lcbc);
-  setConnectivity(&markerIt, m_FullyConnected);
-
-  // iterator for the input image
-  typedef ConstShapedNeighborhoodIterator< InputImageType > InputIteratorType;
-  InputIteratorType
-  inputIt( radius, inputImage, inputImage->GetRequestedRegion() );
-  typename InputIteratorType::ConstIterator niIt;
-  setConnectivity(&inputIt, m_FullyConnected);
-
-  // iterator for the output image
-  typedef ShapedNeighborhoodIterator< LabelImageType > OutputIteratorType;
-  typedef typename OutputIteratorType::OffsetType      OffsetType;
-  typename OutputIteratorType::Iterator noIt;
-  OutputIteratorType
-  outputIt( radius, outputImage, outputImage->GetRequestedRegion() );
-  setConnectivity(&outputIt, m_FullyConnected);
+  HierarchicalQueueType fah;
+  OffsetVectorType      front;
+  OffsetVectorType      next;
+
+  // the status of each pixel in Meyer's algorithm: already in the fah or
+  // not, and in the current front or not
+  std::vector< unsigned char > status;
 
   //---------------------------------------------------------------------------
-  // Meyer's algorithm
+  // first stage
   //---------------------------------------------------------------------------
   if ( m_MarkWatershedLine )
     {
-    // first stage:
+    // Meyer's algorithm:
     //  - set markers pixels to already processed status
     //  - copy markers pixels to output image
     //  - init FAH with indexes of background pixels with marker pixel(s) in
     //    their neighborhood
+    status.resize( numberOfPixels );
+    str.Status = &status[0];
+    this->RunFloodPhase( str, MeyerInitPhase );
+    this->RunFloodPhase( str, AcceptClaimsPhase );
+    this->RunFloodPhase( str, GatherClaimsPhase );
+    }
+  else
+    {
+    // Beucher's algorithm:
+    //  - copy markers pixels to output image
+    //  - init FAH with indexes of pixels with background pixel in their
+    //    neighborhood
+    this->RunFloodPhase( str, BeucherInitPhase );
+    }
+  Self::MergeQueuedPixels( str, fah, next );
+  str.Initializing = false;
+
+  // we can't found the exact number of pixel to process in the 2nd pass, so we
+  // use the maximum number possible.
+  const SizeValueType progressStep = std::max( numberOfPixels / 100, static_cast< SizeValueType >( 1 ) );
+  SizeValueType       numberOfProcessedPixels = 0;
+  SizeValueType       nextProgress = progressStep;
+  this->UpdateProgress( 0.5f );
 
-    ConstantBoundaryCondition< LabelImageType > lcbc2;
-    // outside pixel are watershed so they won't be use to find real watershed
-    // pixels
-    lcbc2.SetConstant(wsLabel);
-    outputIt.OverrideBoundaryCondition(&lcbc2);
-
-    // create a temporary image to store the state of each pixel (processed or
-    // not)
-    typedef Image< bool, ImageDimension > StatusImageType;
-    typename StatusImageType::Pointer statusImage = StatusImageType::New();
-    statusImage->SetRegions( markerImage->GetLargestPossibleRegion() );
-    statusImage->Allocate();
-
-    // iterator for the status image
-    typedef ShapedNeighborhoodIterator< StatusImageType > StatusIteratorType;
-    typename StatusIteratorType::Iterator nsIt;
-    StatusIteratorType
-                                                 statusIt( radius, statusImage, outputImage->GetRequestedRegion() );
-    ConstantBoundaryCondition< StatusImageType > bcbc;
-    bcbc.SetConstant(true);    // outside pixel are already processed
-    statusIt.OverrideBoundaryCondition(&bcbc);
-    setConnectivity(&statusIt, m_FullyConnected);
-
-    // the status image must be initialized before the first stage. In the
-    // first stage, the set to true are the neighbors of the marker (and the
-    // marker) so it's difficult (impossible ?) to init the status image at
-    // the same time
-    // the overhead should be small
-    statusImage->FillBuffer(false);
-
-    for ( markerIt.GoToBegin(), statusIt.GoToBegin(), outputIt.GoToBegin(), inputIt.GoToBegin();
-          !markerIt.IsAtEnd();
-          ++markerIt, ++outputIt )
+  //---------------------------------------------------------------------------
+  // flooding
+  //---------------------------------------------------------------------------
+  while ( !fah.empty() )
+    {
+    // store the current vars
+    typename HierarchicalQueueType::iterator first = fah.begin();
+    str.CurrentValue = first->first;
+    front.swap( first->second );
+    // and remove them from the fah
+    fah.erase( first );
+
+    while ( !front.empty() )
       {
-      LabelImagePixelType markerPixel = markerIt.GetCenterPixel();
-      if ( markerPixel != bgLabel )
+      str.Front = &front;
+      const bool inParallel = ( numberOfThreads > 1 && front.size() >= minimumFrontSize );
+      if ( m_MarkWatershedLine )
         {
-        IndexType idx = markerIt.GetIndex();
-
-        // move the iterators to the right place
-        OffsetType shift = idx - statusIt.GetIndex();
-        statusIt += shift;
-        inputIt += shift;
-
-        // this pixel belongs to a marker
-        // mark it as already processed
-        statusIt.SetCenterPixel(true);
-        // copy it to the output image
-        outputIt.SetCenterPixel(markerPixel);
-        // and increase progress because this pixel will not be used in the
-        // flooding stage.
-        progress.CompletedPixel();
-
-        // search the background pixels in the neighborhood
-        for ( nmIt = markerIt.Begin(), nsIt = statusIt.Begin(), niIt = inputIt.Begin();
-              nmIt != markerIt.End();
-              nmIt++, nsIt++, niIt++ )
+        if ( inParallel )
           {
-          if ( !nsIt.Get() && nmIt.Get() == bgLabel )
-            {
-            // this neighbor is a background pixel and is not already
-            // processed; add its index to fah
-            fah[niIt.Get()].push( markerIt.GetIndex()
-                                  + nmIt.GetNeighborhoodOffset() );
-            // mark it as already in the fah to avoid adding it several times
-            nsIt.Set(true);
-            }
+          this->MeyerFloodFrontInParallel( str, fah, next );
+          }
+        else
+          {
+          Self::MeyerFloodFront( str, fah, next );
           }
         }
       else
         {
-        // Some pixels may be never processed so, by default, non marked pixels
-        // must be marked as watershed
-        outputIt.SetCenterPixel(wsLabel);
+        if ( inParallel )
+          {
+          this->BeucherFloodFrontInParallel( str, fah, next );
+          }
+        else
+          {
+          Self::BeucherFloodFront( str, fah, next );
+          }
         }
-      // one more pixel done in the init stage
-      progress.CompletedPixel();
+      numberOfProcessedPixels += front.size();
+      front.swap( next );
       }
-    // fill the borders of the status image with "true"
-    //FillSides<StatusImageType>(statusImage, true);
-    // Now disable the boundary checks
-    //outputIt.NeedToUseBoundaryConditionOff();
-    //statusIt.NeedToUseBoundaryConditionOff();
-    //inputIt.NeedToUseBoundaryConditionOff();
-    // end of init stage
-
-    // flooding
-    // init all the iterators
-    outputIt.GoToBegin();
-    statusIt.GoToBegin();
-    inputIt.GoToBegin();
-
-    // and start flooding
-    while ( !fah.empty() )
+
+    if ( numberOfProcessedPixels >= nextProgress )
       {
-      // store the current vars
-      InputImagePixelType currentValue = fah.begin()->first;
-      QueueType           currentQueue = fah.begin()->second;
-      // and remove them from the fah
-      fah.erase( fah.begin() );
+      this->UpdateProgress( 0.5f + 0.5f * std::min( 1.0f,
+        static_cast< float >( numberOfProcessedPixels ) / static_cast< float >( numberOfPixels ) ) );
+      nextProgress = numberOfProcessedPixels + progressStep;
+      }
+    }
+  this->UpdateProgress( 1.0f );
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::RunFloodPhase( FloodThreadStruct & str, FloodPhaseType phase )
+{
+  str.Phase = phase;
+  MultiThreader * threader = this->GetMultiThreader();
+  threader->SetSingleMethod( this->FloodThreaderCallback, &str );
+  threader->SingleMethodExecute();
+}
 
-      while ( !currentQueue.empty() )
+
+template< typename TInputImage, typename TLabelImage >
+ITK_THREAD_RETURN_TYPE
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::FloodThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *threadInfo =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  FloodThreadStruct *str =
+    static_cast< FloodThreadStruct * >( threadInfo->UserData );
+  const ThreadIdType threadId = threadInfo->ThreadID;
+
+  switch ( str->Phase )
+    {
+    case MeyerInitPhase:
+      Self::ThreadedMeyerInit( *str, threadId );
+      break;
+    case BeucherInitPhase:
+      Self::ThreadedBeucherInit( *str, threadId );
+      break;
+    case MeyerLabelPhase:
+      Self::ThreadedMeyerLabel( *str, threadId );
+      break;
+    case MeyerMarkFrontPhase:
+      Self::ThreadedMeyerMarkFront( *str, threadId );
+      break;
+    case MeyerClaimPhase:
+      Self::ThreadedMeyerClaim( *str, threadId );
+      break;
+    case BeucherClaimPhase:
+      Self::ThreadedBeucherClaim( *str, threadId );
+      break;
+    case AcceptClaimsPhase:
+      Self::ThreadedAcceptClaims( *str, threadId );
+      break;
+    case GatherClaimsPhase:
+      Self::ThreadedGatherClaims( *str, threadId );
+      break;
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+bool
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ComputeIndex( const FloodThreadStruct & str, OffsetValueType offset, OffsetType & index )
+{
+  bool interior = true;
+  for ( unsigned int d = ImageDimension; d > 0; --d )
+    {
+    const unsigned int i = d - 1;
+    index[i] = offset / str.Strides[i];
+    offset -= index[i] * str.Strides[i];
+    interior = interior && index[i] > 0 && index[i] + 1 < static_cast< OffsetValueType >( str.Size[i] );
+    }
+  return interior;
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+bool
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::IsNeighborInside( const FloodThreadStruct & str, const OffsetType & index, unsigned int k )
+{
+  const OffsetType & offset = str.NeighborIndexOffsets[k];
+  for ( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+    const OffsetValueType i = index[d] + offset[d];
+    if ( i < 0 || i >= static_cast< OffsetValueType >( str.Size[d] ) )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::Claim( FloodThreadStruct & str, ThreadIdType threadId, OffsetValueType pixel, SizeValueType parent )
+{
+  const ThreadIdType owner = static_cast< ThreadIdType >(
+    pixel * static_cast< OffsetValueType >( str.NumberOfThreads )
+    / static_cast< OffsetValueType >( str.NumberOfPixels ) );
+  ClaimType claim;
+  claim.Pixel = pixel;
+  claim.Parent = parent;
+  claim.Accepted = false;
+  str.Claims[threadId][owner].push_back( claim );
+  str.ClaimOwners[threadId].push_back( owner );
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::MergeQueuedPixels( FloodThreadStruct & str, HierarchicalQueueType & fah, OffsetVectorType & next )
+{
+  next.clear();
+  for ( ThreadIdType t = 0; t < str.NumberOfThreads; ++t )
+    {
+    next.insert( next.end(), str.Next[t].begin(), str.Next[t].end() );
+    }
+  for ( ThreadIdType t = 0; t < str.NumberOfThreads; ++t )
+    {
+    const QueuedPixelVectorType & higher = str.Higher[t];
+    for ( typename QueuedPixelVectorType::const_iterator it = higher.begin(); it != higher.end(); ++it )
+      {
+      fah[it->first].push_back( it->second );
+      }
+    }
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::MeyerFloodFront( FloodThreadStruct & str, HierarchicalQueueType & fah, OffsetVectorType & next )
+{
+  // the label used to mark the watershed line in the output image
+  const LabelImagePixelType wsLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+  const unsigned int numberOfNeighbors = static_cast< unsigned int >( str.NeighborOffsets.size() );
+  const OffsetVectorType & front = *str.Front;
+
+  next.clear();
+  for ( typename OffsetVectorType::const_iterator it = front.begin(); it != front.end(); ++it )
+    {
+    const OffsetValueType pixel = *it;
+    OffsetType            index;
+    const bool            interior = Self::ComputeIndex( str, pixel, index );
+
+    // iterate over the neighbors. If there is only one marker value, give
+    // that value to the pixel, else keep it as is (watershed line)
+    LabelImagePixelType marker = wsLabel;
+    bool                collision = false;
+    for ( unsigned int k = 0; k < numberOfNeighbors; ++k )
+      {
+      if ( !interior && !Self::IsNeighborInside( str, index, k ) )
+        {
+        continue;
+        }
+      const LabelImagePixelType o = str.Output[pixel + str.NeighborOffsets[k]];
+      if ( o != wsLabel )
         {
-        IndexType idx = currentQueue.front();
-        currentQueue.pop();
-
-        // move the iterators to the right place
-        OffsetType shift = idx - outputIt.GetIndex();
-        outputIt += shift;
-        statusIt += shift;
-        inputIt += shift;
-
-        // iterate over the neighbors. If there is only one marker value, give
-        // that value to the pixel, else keep it as is (watershed line)
-        LabelImagePixelType marker = wsLabel;
-        bool                collision = false;
-        for ( noIt = outputIt.Begin(); noIt != outputIt.End(); noIt++ )
+        if ( marker != wsLabel && o != marker )
           {
-          LabelImagePixelType o = noIt.Get();
-          if ( o != wsLabel )
-            {
-            if ( marker != wsLabel && o != marker )
-              {
-              collision = true;
-              break;
-              }
-            else
-                  { marker = o; }
-            }
+          collision = true;
+          break;
           }
-        if ( !collision )
+        marker = o;
+        }
+      }
+    if ( !collision )
+      {
+      // set the marker value
+      str.Output[pixel] = marker;
+      // and propagate to the neighbors
+      for ( unsigned int k = 0; k < numberOfNeighbors; ++k )
+        {
+        if ( !interior && !Self::IsNeighborInside( str, index, k ) )
+          {
+          continue;
+          }
+        const OffsetValueType neighbor = pixel + str.NeighborOffsets[k];
+        if ( !( str.Status[neighbor] & QueuedStatus ) )
           {
-          // set the marker value
-          outputIt.SetCenterPixel(marker);
-          // and propagate to the neighbors
-          for ( niIt = inputIt.Begin(), nsIt = statusIt.Begin();
-                niIt != inputIt.End();
-                niIt++, nsIt++ )
+          // the pixel is not yet processed. add it to the fah
+          const InputImagePixelType grayVal = str.Input[neighbor];
+          if ( grayVal <= str.CurrentValue )
             {
-            if ( !nsIt.Get() )
-              {
-              // the pixel is not yet processed. add it to the fah
-              InputImagePixelType GrayVal = niIt.Get();
-              if ( GrayVal <= currentValue )
-                {
-                currentQueue.push( inputIt.GetIndex()
-                                   + niIt.GetNeighborhoodOffset() );
-                }
-              else
-                {
-                fah[GrayVal].push( inputIt.GetIndex()
-                                   + niIt.GetNeighborhoodOffset() );
-                }
-              // mark it as already in the fah
-              nsIt.Set(true);
-              }
+            next.push_back( neighbor );
             }
+          else
+            {
+            fah[grayVal].push_back( neighbor );
+            }
+          // mark it as already in the fah
+          str.Status[neighbor] |= QueuedStatus;
           }
-        // one more pixel in the flooding stage
-        progress.CompletedPixel();
         }
       }
     }
+}
 
-  //---------------------------------------------------------------------------
-  // Beucher's algorithm
-  //---------------------------------------------------------------------------
-  else
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::MeyerFloodFrontInParallel( FloodThreadStruct & str, HierarchicalQueueType & fah, OffsetVectorType & next )
+{
+  const LabelImagePixelType wsLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+  const unsigned int numberOfNeighbors = static_cast< unsigned int >( str.NeighborOffsets.size() );
+  const OffsetVectorType & front = *str.Front;
+
+  // the labels of the pixels of the front, computed from the labels set
+  // before the front, are written in the output so the threads can find
+  // the pixels where two labels meet
+  str.Labels.resize( front.size() );
+  this->RunFloodPhase( str, MeyerLabelPhase );
+  this->RunFloodPhase( str, MeyerMarkFrontPhase );
+  this->RunFloodPhase( str, MeyerClaimPhase );
+
+  // in the queue, a pixel of the front also sees the labels of the pixels
+  // of the front processed before it. Only the pixels with a neighbor of
+  // the front of another label can become watershed pixels that way: they
+  // are processed in the order of the queue.
+  std::vector< std::pair< OffsetValueType, SizeValueType > > contested;
+  for ( ThreadIdType t = 0; t < str.NumberOfThreads; ++t )
     {
-    // first stage:
-    //  - copy markers pixels to output image
-    //  - init FAH with indexes of pixels with background pixel in their
-    //    neighborhood
+    const std::vector< SizeValueType > & positions = str.Contested[t];
+    for ( typename std::vector< SizeValueType >::const_iterator it = positions.begin(); it != positions.end(); ++it )
+      {
+      contested.push_back( std::make_pair( front[*it], *it ) );
+      }
+    }
+  if ( !contested.empty() )
+    {
+    std::vector< std::pair< OffsetValueType, SizeValueType > > sortedContested( contested );
+    std::sort( sortedContested.begin(), sortedContested.end() );
+    for ( typename std::vector< std::pair< OffsetValueType, SizeValueType > >::const_iterator it = contested.begin();
+          it != contested.end(); ++it )
+      {
+      const OffsetValueType     pixel = it->first;
+      const SizeValueType       position = it->second;
+      const LabelImagePixelType marker = str.Labels[position];
+      OffsetType                index;
+      const bool                interior = Self::ComputeIndex( str, pixel, index );
+      for ( unsigned int k = 0; k < numberOfNeighbors; ++k )
+        {
+        if ( !interior && !Self::IsNeighborInside( str, index, k ) )
+          {
+          continue;
+          }
+        const OffsetValueType neighbor = pixel + str.NeighborOffsets[k];
+        if ( !( str.Status[neighbor] & FrontStatus ) )
+          {
+          continue;
+          }
+        // the other pixels of the front have a compatible label
+        typename std::vector< std::pair< OffsetValueType, SizeValueType > >::const_iterator found =
+          std::lower_bound( sortedContested.begin(), sortedContested.end(),
+                            std::make_pair( neighbor, static_cast< SizeValueType >( 0 ) ) );
+        if ( found == sortedContested.end() || found->first != neighbor || found->second > position )
+          {
+          continue;
+          }
+        const LabelImagePixelType o = str.Output[neighbor];
+        if ( o != wsLabel && o != marker )
+          {
+          str.Output[pixel] = wsLabel;
+          str.Labels[position] = wsLabel;
+          break;
+          }
+        }
+      }
+    }
+
+  this->RunFloodPhase( str, AcceptClaimsPhase );
+  this->RunFloodPhase( str, GatherClaimsPhase );
+  Self::MergeQueuedPixels( str, fah, next );
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::BeucherFloodFront( FloodThreadStruct & str, HierarchicalQueueType & fah, OffsetVectorType & next )
+{
+  const LabelImagePixelType wsLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+  const unsigned int numberOfNeighbors = static_cast< unsigned int >( str.NeighborOffsets.size() );
+  const OffsetVectorType & front = *str.Front;
 
-    ConstantBoundaryCondition< LabelImageType > lcbc2;
-    // outside pixel are watershed so they won't be use to find real watershed
-    // pixels
-    lcbc2.SetConstant( NumericTraits< LabelImagePixelType >::max() );
-    outputIt.OverrideBoundaryCondition(&lcbc2);
+  next.clear();
+  for ( typename OffsetVectorType::const_iterator it = front.begin(); it != front.end(); ++it )
+    {
+    const OffsetValueType     pixel = *it;
+    const LabelImagePixelType currentMarker = str.Output[pixel];
+    OffsetType                index;
+    const bool                interior = Self::ComputeIndex( str, pixel, index );
 
-    for ( markerIt.GoToBegin(), outputIt.GoToBegin(), inputIt.GoToBegin();
-          !markerIt.IsAtEnd();
-          ++markerIt, ++outputIt )
+    // iterate over neighbors to propagate the marker
+    for ( unsigned int k = 0; k < numberOfNeighbors; ++k )
       {
-      LabelImagePixelType markerPixel = markerIt.GetCenterPixel();
-      if ( markerPixel != bgLabel )
+      if ( !interior && !Self::IsNeighborInside( str, index, k ) )
         {
-        IndexType  idx = markerIt.GetIndex();
-        OffsetType shift = idx - inputIt.GetIndex();
-        inputIt += shift;
-
-        // this pixels belongs to a marker
-        // copy it to the output image
-        outputIt.SetCenterPixel(markerPixel);
-        // search if it has background pixel in its neighborhood
-        bool haveBgNeighbor = false;
-        for ( nmIt = markerIt.Begin(); nmIt != markerIt.End(); nmIt++ )
+        continue;
+        }
+      const OffsetValueType neighbor = pixel + str.NeighborOffsets[k];
+      if ( str.Output[neighbor] == wsLabel )
+        {
+        // the pixel is not yet processed. It can be labeled with the
+        // current label
+        str.Output[neighbor] = currentMarker;
+        const InputImagePixelType grayVal = str.Input[neighbor];
+        if ( grayVal <= str.CurrentValue )
           {
-          if ( nmIt.Get() == bgLabel )
-            {
-            haveBgNeighbor = true;
-            break;
-            }
+          next.push_back( neighbor );
+          }
+        else
+          {
+          fah[grayVal].push_back( neighbor );
+          }
+        }
+      }
+    }
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::BeucherFloodFrontInParallel( FloodThreadStruct & str, HierarchicalQueueType & fah, OffsetVectorType & next )
+{
+  str.Labels.resize( str.Front->size() );
+  this->RunFloodPhase( str, BeucherClaimPhase );
+  this->RunFloodPhase( str, AcceptClaimsPhase );
+  this->RunFloodPhase( str, GatherClaimsPhase );
+  Self::MergeQueuedPixels( str, fah, next );
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ThreadedMeyerInit( FloodThreadStruct & str, ThreadIdType threadId )
+{
+  const LabelImagePixelType bgLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+  const LabelImagePixelType wsLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+  const unsigned int numberOfNeighbors = static_cast< unsigned int >( str.NeighborOffsets.size() );
+  const OffsetValueType begin = str.NumberOfPixels * threadId / str.NumberOfThreads;
+  const OffsetValueType end = str.NumberOfPixels * ( threadId + 1 ) / str.NumberOfThreads;
+
+  for ( ThreadIdType t = 0; t < str.NumberOfThreads; ++t )
+    {
+    str.Claims[threadId][t].clear();
+    }
+  str.ClaimOwners[threadId].clear();
+
+  for ( OffsetValueType pixel = begin; pixel < end; ++pixel )
+    {
+    const LabelImagePixelType markerPixel = str.Marker[pixel];
+    if ( markerPixel != bgLabel )
+      {
+      // this pixel belongs to a marker
+      // mark it as already processed
+      str.Status[pixel] = QueuedStatus;
+      // copy it to the output image
+      str.Output[pixel] = markerPixel;
+
+      // claim the background pixels in the neighborhood; the first claim
+      // in raster order adds them to the fah
+      OffsetType index;
+      const bool interior = Self::ComputeIndex( str, pixel, index );
+      for ( unsigned int k = 0; k < numberOfNeighbors; ++k )
+        {
+        if ( !interior && !Self::IsNeighborInside( str, index, k ) )
+          {
+          continue;
           }
-        if ( haveBgNeighbor )
+        const OffsetValueType neighbor = pixel + str.NeighborOffsets[k];
+        if ( str.Marker[neighbor] == bgLabel )
+          {
+          Self::Claim( str, threadId, neighbor, static_cast< SizeValueType >( pixel ) );
+          }
+        }
+      }
+    else
+      {
+      // Some pixels may be never processed so, by default, non marked pixels
+      // must be marked as watershed
+      str.Status[pixel] = 0;
+      str.Output[pixel] = wsLabel;
+      }
+    }
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ThreadedBeucherInit( FloodThreadStruct & str, ThreadIdType threadId )
+{
+  const LabelImagePixelType bgLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+  const LabelImagePixelType wsLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+  const unsigned int numberOfNeighbors = static_cast< unsigned int >( str.NeighborOffsets.size() );
+  const OffsetValueType begin = str.NumberOfPixels * threadId / str.NumberOfThreads;
+  const OffsetValueType end = str.NumberOfPixels * ( threadId + 1 ) / str.NumberOfThreads;
+
+  str.Next[threadId].clear();
+  QueuedPixelVectorType & higher = str.Higher[threadId];
+  higher.clear();
+
+  for ( OffsetValueType pixel = begin; pixel < end; ++pixel )
+    {
+    const LabelImagePixelType markerPixel = str.Marker[pixel];
+    if ( markerPixel != bgLabel )
+      {
+      // this pixels belongs to a marker
+      // copy it to the output image
+      str.Output[pixel] = markerPixel;
+      // search if it has background pixel in its neighborhood
+      OffsetType index;
+      const bool interior = Self::ComputeIndex( str, pixel, index );
+      for ( unsigned int k = 0; k < numberOfNeighbors; ++k )
+        {
+        if ( !interior && !Self::IsNeighborInside( str, index, k ) )
+          {
+          continue;
+          }
+        if ( str.Marker[pixel + str.NeighborOffsets[k]] == bgLabel )
           {
           // there is a background pixel in the neighborhood; add to fah
-          fah[inputIt.GetCenterPixel()].push( markerIt.GetIndex() );
+          higher.push_back( std::make_pair( str.Input[pixel], pixel ) );
+          break;
           }
-        else
+        }
+      }
+    else
+      {
+      str.Output[pixel] = wsLabel;
+      }
+    }
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ThreadedMeyerLabel( FloodThreadStruct & str, ThreadIdType threadId )
+{
+  const LabelImagePixelType wsLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+  const unsigned int numberOfNeighbors = static_cast< unsigned int >( str.NeighborOffsets.size() );
+  const OffsetVectorType & front = *str.Front;
+  const SizeValueType begin = front.size() * threadId / str.NumberOfThreads;
+  const SizeValueType end = front.size() * ( threadId + 1 ) / str.NumberOfThreads;
+
+  for ( SizeValueType position = begin; position < end; ++position )
+    {
+    const OffsetValueType pixel = front[position];
+    OffsetType            index;
+    const bool            interior = Self::ComputeIndex( str, pixel, index );
+
+    // the pixel which added this pixel to the fah is labeled, so the label
+    // is never wsLabel without a collision
+    LabelImagePixelType marker = wsLabel;
+    for ( unsigned int k = 0; k < numberOfNeighbors; ++k )
+      {
+      if ( !interior && !Self::IsNeighborInside( str, index, k ) )
+        {
+        continue;
+        }
+      const LabelImagePixelType o = str.Output[pixel + str.NeighborOffsets[k]];
+      if ( o != wsLabel )
+        {
+        if ( marker != wsLabel && o != marker )
           {
-          // increase progress because this pixel will not be used in the
-          // flooding stage.
-          progress.CompletedPixel();
+          marker = wsLabel;
+          break;
           }
+        marker = o;
         }
-      else
+      }
+    str.Labels[position] = marker;
+    }
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ThreadedMeyerMarkFront( FloodThreadStruct & str, ThreadIdType threadId )
+{
+  const OffsetVectorType & front = *str.Front;
+  const SizeValueType begin = front.size() * threadId / str.NumberOfThreads;
+  const SizeValueType end = front.size() * ( threadId + 1 ) / str.NumberOfThreads;
+
+  for ( SizeValueType position = begin; position < end; ++position )
+    {
+    const OffsetValueType pixel = front[position];
+    str.Output[pixel] = str.Labels[position];
+    str.Status[pixel] |= FrontStatus;
+    }
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ThreadedMeyerClaim( FloodThreadStruct & str, ThreadIdType threadId )
+{
+  const LabelImagePixelType wsLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+  const unsigned int numberOfNeighbors = static_cast< unsigned int >( str.NeighborOffsets.size() );
+  const OffsetVectorType & front = *str.Front;
+  const SizeValueType begin = front.size() * threadId / str.NumberOfThreads;
+  const SizeValueType end = front.size() * ( threadId + 1 ) / str.NumberOfThreads;
+
+  for ( ThreadIdType t = 0; t < str.NumberOfThreads; ++t )
+    {
+    str.Claims[threadId][t].clear();
+    }
+  str.ClaimOwners[threadId].clear();
+  str.Contested[threadId].clear();
+
+  for ( SizeValueType position = begin; position < end; ++position )
+    {
+    const LabelImagePixelType marker = str.Labels[position];
+    if ( marker == wsLabel )
+      {
+      continue;
+      }
+    const OffsetValueType pixel = front[position];
+    OffsetType            index;
+    const bool            interior = Self::ComputeIndex( str, pixel, index );
+    bool                  contested = false;
+    for ( unsigned int k = 0; k < numberOfNeighbors; ++k )
+      {
+      if ( !interior && !Self::IsNeighborInside( str, index, k ) )
+        {
+        continue;
+        }
+      const OffsetValueType neighbor = pixel + str.NeighborOffsets[k];
+      const unsigned char   neighborStatus = str.Status[neighbor];
+      if ( neighborStatus & FrontStatus )
+        {
+        const LabelImagePixelType o = str.Output[neighbor];
+        contested = contested || ( o != wsLabel && o != marker );
+        }
+      else if ( !( neighborStatus & QueuedStatus ) )
         {
-        outputIt.SetCenterPixel(wsLabel);
+        Self::Claim( str, threadId, neighbor, position );
         }
-      progress.CompletedPixel();
       }
-    // end of init stage
+    if ( contested )
+      {
+      str.Contested[threadId].push_back( position );
+      }
+    }
+}
 
-    // flooding
-    // init all the iterators
-    outputIt.GoToBegin();
-    inputIt.GoToBegin();
 
-    // and start flooding
-    while ( !fah.empty() )
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ThreadedBeucherClaim( FloodThreadStruct & str, ThreadIdType threadId )
+{
+  const LabelImagePixelType wsLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+  const unsigned int numberOfNeighbors = static_cast< unsigned int >( str.NeighborOffsets.size() );
+  const OffsetVectorType & front = *str.Front;
+  const SizeValueType begin = front.size() * threadId / str.NumberOfThreads;
+  const SizeValueType end = front.size() * ( threadId + 1 ) / str.NumberOfThreads;
+
+  for ( ThreadIdType t = 0; t < str.NumberOfThreads; ++t )
+    {
+    str.Claims[threadId][t].clear();
+    }
+  str.ClaimOwners[threadId].clear();
+
+  for ( SizeValueType position = begin; position < end; ++position )
+    {
+    const OffsetValueType pixel = front[position];
+    str.Labels[position] = str.Output[pixel];
+    OffsetType index;
+    const bool interior = Self::ComputeIndex( str, pixel, index );
+    for ( unsigned int k = 0; k < numberOfNeighbors; ++k )
       {
-      // store the current vars
-      InputImagePixelType currentValue = fah.begin()->first;
-      QueueType           currentQueue = fah.begin()->second;
-      // and remove them from the fah
-      fah.erase( fah.begin() );
+      if ( !interior && !Self::IsNeighborInside( str, index, k ) )
+        {
+        continue;
+        }
+      const OffsetValueType neighbor = pixel + str.NeighborOffsets[k];
+      if ( str.Output[neighbor] == wsLabel )
+        {
+        Self::Claim( str, threadId, neighbor, position );
+        }
+      }
+    }
+}
 
-      while ( !currentQueue.empty() )
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ThreadedAcceptClaims( FloodThreadStruct & str, ThreadIdType threadId )
+{
+  const LabelImagePixelType wsLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+
+  // the claims of the pixels owned by this thread, in the order of the
+  // threads which made them, so in the order of the front
+  for ( ThreadIdType t = 0; t < str.NumberOfThreads; ++t )
+    {
+    ClaimVectorType & claims = str.Claims[t][threadId];
+    for ( typename ClaimVectorType::iterator it = claims.begin(); it != claims.end(); ++it )
+      {
+      if ( str.Status )
         {
-        IndexType idx = currentQueue.front();
-        currentQueue.pop();
-
-        // move the iterators to the right place
-        OffsetType shift = idx - outputIt.GetIndex();
-        outputIt += shift;
-        inputIt += shift;
-
-        LabelImagePixelType currentMarker = outputIt.GetCenterPixel();
-        // get the current value of the pixel
-        // iterate over neighbors to propagate the marker
-        for ( noIt = outputIt.Begin(), niIt = inputIt.Begin();
-              noIt != outputIt.End();
-              noIt++, niIt++ )
+        // the pixels which became watershed pixels do not propagate
+        if ( !str.Initializing && str.Labels[it->Parent] == wsLabel )
           {
-          if ( noIt.Get() == wsLabel )
-            {
-            // the pixel is not yet processed. It can be labeled with the
-            // current label
-            noIt.Set(currentMarker);
-            InputImagePixelType GrayVal = niIt.Get();
-            if ( GrayVal <= currentValue )
-              {
-              currentQueue.push( inputIt.GetIndex()
-                                 + noIt.GetNeighborhoodOffset() );
-              }
-            else
-              {
-              fah[GrayVal].push( inputIt.GetIndex()
-                                 + noIt.GetNeighborhoodOffset() );
-              }
-            progress.CompletedPixel();
-            }
+          continue;
+          }
+        if ( !( str.Status[it->Pixel] & QueuedStatus ) )
+          {
+          str.Status[it->Pixel] |= QueuedStatus;
+          it->Accepted = true;
           }
         }
+      else if ( str.Output[it->Pixel] == wsLabel )
+        {
+        str.Output[it->Pixel] = str.Labels[it->Parent];
+        it->Accepted = true;
+        }
+      }
+    }
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ThreadedGatherClaims( FloodThreadStruct & str, ThreadIdType threadId )
+{
+  OffsetVectorType &      next = str.Next[threadId];
+  QueuedPixelVectorType & higher = str.Higher[threadId];
+  next.clear();
+  higher.clear();
+
+  // the accepted claims of this thread, in the order they were made
+  std::vector< SizeValueType >        positions( str.NumberOfThreads, 0 );
+  const std::vector< ThreadIdType > & owners = str.ClaimOwners[threadId];
+  for ( typename std::vector< ThreadIdType >::const_iterator it = owners.begin(); it != owners.end(); ++it )
+    {
+    const ClaimType & claim = str.Claims[threadId][*it][positions[*it]++];
+    if ( claim.Accepted )
+      {
+      const InputImagePixelType grayVal = str.Input[claim.Pixel];
+      if ( !str.Initializing && grayVal <= str.CurrentValue )
+        {
+        next.push_back( claim.Pixel );
+        }
+      else
+        {
+        higher.push_back( std::make_pair( grayVal, claim.Pixel ) );
+        }
+      }
+    }
+
+  if ( str.Status && !str.Initializing )
+    {
+    const OffsetVectorType & front = *str.Front;
+    const SizeValueType      begin = front.size() * threadId / str.NumberOfThreads;
+    const SizeValueType      end = front.size() * ( threadId + 1 ) / str.NumberOfThreads;
+    for ( SizeValueType position = begin; position < end; ++position )
+      {
+      str.Status[front[position]] &= ~FrontStatus;
       }
     }
 }
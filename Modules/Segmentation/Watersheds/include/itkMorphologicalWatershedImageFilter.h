@@ -120,8 +120,10 @@ protected:
   /** MorphologicalWatershedImageFilter will produce the entire output. */
   void EnlargeOutputRequestedRegion( DataObject *itkNotUsed(output) ) ITK_OVERRIDE;
 
-  /** Single-threaded version of GenerateData.  This filter delegates
-   * to GrayscaleGeodesicErodeImageFilter. */
+  /** This filter delegates to RegionalMinimaImageFilter,
+   * ConnectedComponentImageFilter and
+   * MorphologicalWatershedFromMarkersImageFilter, which floods with the
+   * number of threads of this filter. */
   void GenerateData() ITK_OVERRIDE;
 
 private:
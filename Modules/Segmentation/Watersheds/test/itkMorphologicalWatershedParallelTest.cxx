@@ -0,0 +1,177 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkMorphologicalWatershedImageFilter.h"
+#include "itkTimeProbe.h"
+#include "itkTestingMacros.h"
+
+/**
+ * In this test, we flood synthetic images of several sizes with several
+ * numbers of threads, with and without watershed lines and with both
+ * connectivities. The images have large plateaus, so the fronts are large
+ * enough to be processed by several threads. The outputs must not depend
+ * on the number of threads. The times are reported for each size and
+ * number of threads.
+ */
+namespace
+{
+
+template< typename TImage >
+bool
+SameOutputs( const TImage *expected, const TImage *actual )
+{
+  itk::ImageRegionConstIterator< TImage > eIt( expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > aIt( actual, actual->GetLargestPossibleRegion() );
+  for ( ; !eIt.IsAtEnd(); ++eIt, ++aIt )
+    {
+    if ( eIt.Get() != aIt.Get() )
+      {
+      std::cerr << "Different labels: " << eIt.Get() << " and " << aIt.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< unsigned int VDimension >
+bool
+FloodImages( unsigned int imageSize, unsigned int numberOfLevels )
+{
+  typedef itk::Image< unsigned char, VDimension >  ImageType;
+  typedef itk::Image< unsigned short, VDimension > LabelImageType;
+
+  typename ImageType::SizeType size;
+  size.Fill( imageSize );
+
+  // smooth waves quantized on a few levels, and sparse markers
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  typename LabelImageType::Pointer markers = LabelImageType::New();
+  markers->SetRegions( size );
+  markers->Allocate();
+
+  unsigned int   value = 11;
+  unsigned short label = 0;
+  itk::ImageRegionIteratorWithIndex< ImageType > It( image, image->GetLargestPossibleRegion() );
+  for ( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    double wave = 0.0;
+    for ( unsigned int d = 0; d < VDimension; d++ )
+      {
+      wave += std::sin( 0.15 * ( d + 1 ) * It.GetIndex()[d] );
+      }
+    wave = ( wave + VDimension ) / ( 2.0 * VDimension );
+    It.Set( static_cast< unsigned char >( static_cast< unsigned int >( wave * numberOfLevels ) * 20 ) );
+
+    value = value * 1664525u + 1013904223u;
+    if ( ( value >> 8 ) % 1500 == 0 )
+      {
+      label = static_cast< unsigned short >( label % 1000 + 1 );
+      markers->SetPixel( It.GetIndex(), label );
+      }
+    else
+      {
+      markers->SetPixel( It.GetIndex(), 0 );
+      }
+    }
+
+  bool success = true;
+
+  const itk::ThreadIdType numberOfThreads[3] = { 1, 2, 4 };
+  for ( unsigned int mode = 0; mode < 4; mode++ )
+    {
+    const bool markWatershedLine = ( mode & 1 );
+    const bool fullyConnected = ( mode & 2 );
+    typename LabelImageType::Pointer expected;
+    typename LabelImageType::Pointer expectedWithoutMarkers;
+    double                           times[3];
+    for ( unsigned int t = 0; t < 3; t++ )
+      {
+      typedef itk::MorphologicalWatershedFromMarkersImageFilter< ImageType, LabelImageType > FromMarkersType;
+      typename FromMarkersType::Pointer fromMarkers = FromMarkersType::New();
+      fromMarkers->SetInput( image );
+      fromMarkers->SetMarkerImage( markers );
+      fromMarkers->SetMarkWatershedLine( markWatershedLine );
+      fromMarkers->SetFullyConnected( fullyConnected );
+      fromMarkers->SetNumberOfThreads( numberOfThreads[t] );
+
+      itk::TimeProbe timer;
+      timer.Start();
+      TRY_EXPECT_NO_EXCEPTION( fromMarkers->Update() );
+      timer.Stop();
+      times[t] = timer.GetTotal();
+
+      typedef itk::MorphologicalWatershedImageFilter< ImageType, LabelImageType > WatershedType;
+      typename WatershedType::Pointer watershed = WatershedType::New();
+      watershed->SetInput( image );
+      watershed->SetMarkWatershedLine( markWatershedLine );
+      watershed->SetFullyConnected( fullyConnected );
+      watershed->SetNumberOfThreads( numberOfThreads[t] );
+      TRY_EXPECT_NO_EXCEPTION( watershed->Update() );
+
+      if ( t == 0 )
+        {
+        expected = fromMarkers->GetOutput();
+        expected->DisconnectPipeline();
+        expectedWithoutMarkers = watershed->GetOutput();
+        expectedWithoutMarkers->DisconnectPipeline();
+        }
+      else
+        {
+        // the results do not depend on the number of threads
+        success &= SameOutputs< LabelImageType >( expected, fromMarkers->GetOutput() );
+        success &= SameOutputs< LabelImageType >( expectedWithoutMarkers, watershed->GetOutput() );
+        }
+      }
+
+    std::cout << VDimension << "D, size " << imageSize
+              << ", MarkWatershedLine " << markWatershedLine
+              << ", FullyConnected " << fullyConnected << ":";
+    for ( unsigned int t = 0; t < 3; t++ )
+      {
+      std::cout << " " << numberOfThreads[t] << " threads " << times[t] << " s;";
+      }
+    std::cout << std::endl;
+    }
+
+  return success;
+}
+
+}
+
+int itkMorphologicalWatershedParallelTest( int, char * [] )
+{
+  bool success = true;
+
+  success &= FloodImages< 2 >( 100, 4 );
+  success &= FloodImages< 2 >( 256, 6 );
+  success &= FloodImages< 3 >( 24, 4 );
+  success &= FloodImages< 3 >( 48, 6 );
+
+  if ( !success )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}